@@ -0,0 +1,625 @@
+//--------------------------------------------------------------------------------------
+// File: ddspack.cpp
+//
+// Simple command-line tool for packing .DDS files into the supercompressed container
+// read by DDSTextureLoader: the DDS headers are kept as they are and the image data is
+// split into chunks that are LZ4 compressed independently, so they can be decompressed
+// in parallel at load time. Also reports the compression ratio and the in-memory
+// decompression rate for each file.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4005)
+#endif
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define NODRAWTEXT
+#define NOGDI
+#define NOBITMAP
+#define NOMCX
+#define NOSERVICE
+#define NOHELP
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <Windows.h>
+
+#if __cplusplus < 201703L
+#error Requires C++17 (and /Zc:__cplusplus with MSVC)
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+#include <cwctype>
+#include <filesystem>
+#include <iterator>
+#include <list>
+#include <locale>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DDSCompression.h"
+
+#ifdef __INTEL_COMPILER
+#pragma warning(disable : 161)
+// warning #161: unrecognized #pragma
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    struct handle_closer { void operator()(HANDLE h) { if (h) CloseHandle(h); } };
+
+    using ScopedHandle = std::unique_ptr<void, handle_closer>;
+
+    inline HANDLE safe_handle(HANDLE h) { return (h == INVALID_HANDLE_VALUE) ? nullptr : h; }
+
+    struct find_closer { void operator()(HANDLE h) { assert(h != INVALID_HANDLE_VALUE); if (h) FindClose(h); } };
+
+    using ScopedFindHandle = std::unique_ptr<void, find_closer>;
+
+    // Decompression is timed over several passes and the fastest is reported
+    constexpr int c_timingPasses = 5;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+enum OPTIONS : uint32_t
+{
+    OPT_RECURSIVE = 1,
+    OPT_OUTPUTDIR,
+    OPT_TOLOWER,
+    OPT_OVERWRITE,
+    OPT_UNPACK,
+    OPT_NOLOGO,
+    OPT_MAX
+};
+
+static_assert(OPT_MAX <= 32, "dwOptions is a unsigned int bitfield");
+
+struct SConversion
+{
+    std::wstring szSrc;
+};
+
+struct SValue
+{
+    const wchar_t*  name;
+    uint32_t        value;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+const SValue g_pOptions[] =
+{
+    { L"r",         OPT_RECURSIVE },
+    { L"o",         OPT_OUTPUTDIR },
+    { L"l",         OPT_TOLOWER },
+    { L"y",         OPT_OVERWRITE },
+    { L"u",         OPT_UNPACK },
+    { L"nologo",    OPT_NOLOGO },
+    { nullptr,      0 }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+#ifdef _PREFAST_
+#pragma prefast(disable : 26018, "Only used with static internal arrays")
+#endif
+
+    uint32_t LookupByName(const wchar_t *pName, const SValue *pArray)
+    {
+        while (pArray->name)
+        {
+            if (!_wcsicmp(pName, pArray->name))
+                return pArray->value;
+
+            pArray++;
+        }
+
+        return 0;
+    }
+
+    void SearchForFiles(const std::filesystem::path& path, std::list<SConversion>& files, bool recursive)
+    {
+        // Process files
+        WIN32_FIND_DATAW findData = {};
+        ScopedFindHandle hFile(safe_handle(FindFirstFileExW(path.c_str(),
+            FindExInfoBasic, &findData,
+            FindExSearchNameMatch, nullptr,
+            FIND_FIRST_EX_LARGE_FETCH)));
+        if (hFile)
+        {
+            for (;;)
+            {
+                if (!(findData.dwFileAttributes & (FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM | FILE_ATTRIBUTE_DIRECTORY)))
+                {
+                    SConversion conv = {};
+                    conv.szSrc = path.parent_path().append(findData.cFileName).native();
+                    files.push_back(conv);
+                }
+
+                if (!FindNextFileW(hFile.get(), &findData))
+                    break;
+            }
+        }
+
+        // Process directories
+        if (recursive)
+        {
+            auto searchDir = path.parent_path().append(L"*");
+
+            hFile.reset(safe_handle(FindFirstFileExW(searchDir.c_str(),
+                FindExInfoBasic, &findData,
+                FindExSearchLimitToDirectories, nullptr,
+                FIND_FIRST_EX_LARGE_FETCH)));
+            if (!hFile)
+                return;
+
+            for (;;)
+            {
+                if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                {
+                    if (findData.cFileName[0] != L'.')
+                    {
+                        auto subdir = path.parent_path().append(findData.cFileName).append(path.filename().c_str());
+
+                        SearchForFiles(subdir, files, recursive);
+                    }
+                }
+
+                if (!FindNextFileW(hFile.get(), &findData))
+                    break;
+            }
+        }
+    }
+
+    void PrintLogo(bool versionOnly)
+    {
+        wchar_t version[32] = {};
+
+        wchar_t appName[_MAX_PATH] = {};
+        if (GetModuleFileNameW(nullptr, appName, _MAX_PATH))
+        {
+            DWORD size = GetFileVersionInfoSizeW(appName, nullptr);
+            if (size > 0)
+            {
+                auto verInfo = std::make_unique<uint8_t[]>(size);
+                if (GetFileVersionInfoW(appName, 0, size, verInfo.get()))
+                {
+                    LPVOID lpstr = nullptr;
+                    UINT strLen = 0;
+                    if (VerQueryValueW(verInfo.get(), L"\\StringFileInfo\\040904B0\\ProductVersion", &lpstr, &strLen))
+                    {
+                        wcsncpy_s(version, reinterpret_cast<const wchar_t*>(lpstr), strLen);
+                    }
+                }
+            }
+        }
+
+        if (!*version)
+        {
+            wcscpy_s(version, L"MISSING");
+        }
+
+        if (versionOnly)
+        {
+            wprintf(L"ddspack version %ls\n", version);
+        }
+        else
+        {
+            wprintf(L"Microsoft (R) DDS Packing Tool [DirectXTK] Version %ls\n", version);
+            wprintf(L"Copyright (C) Microsoft Corp.\n");
+        #ifdef _DEBUG
+            wprintf(L"*** Debug build ***\n");
+        #endif
+            wprintf(L"\n");
+        }
+    }
+
+    void PrintUsage()
+    {
+        PrintLogo(false);
+
+        static const wchar_t* const s_usage =
+            L"Usage: ddspack <options> [--] <dds-files>\n"
+            L"\n"
+            L"   -r                  wildcard filename search is recursive\n"
+            L"   -o <directory>      output directory (defaults to next to each input)\n"
+            L"   -l                  force output filename to lower case\n"
+            L"   -y                  overwrite existing output file (if any)\n"
+            L"   -u                  unpack .ddsz files back to plain .dds\n"
+            L"   -nologo             suppress copyright message\n"
+            L"\n"
+            L"   '-- ' is needed if any input filepath starts with the '-' or '/' character\n";
+
+        wprintf(L"%ls", s_usage);
+    }
+
+    const wchar_t* GetErrorDesc(HRESULT hr)
+    {
+        static wchar_t desc[1024] = {};
+
+        LPWSTR errorText = nullptr;
+
+        DWORD result = FormatMessageW(FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS | FORMAT_MESSAGE_ALLOCATE_BUFFER,
+            nullptr, static_cast<DWORD>(hr),
+            MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), reinterpret_cast<LPWSTR>(&errorText), 0, nullptr);
+
+        *desc = 0;
+
+        if (result > 0 && errorText)
+        {
+            swprintf_s(desc, L": %ls", errorText);
+
+            size_t len = wcslen(desc);
+            if (len >= 2)
+            {
+                desc[len - 2] = 0;
+                desc[len - 1] = 0;
+            }
+
+            if (errorText)
+                LocalFree(errorText);
+
+            for (wchar_t* ptr = desc; *ptr != 0; ++ptr)
+            {
+                if (*ptr == L'\r' || *ptr == L'\n')
+                {
+                    *ptr = L' ';
+                }
+            }
+        }
+
+        return desc;
+    }
+
+    HRESULT ReadData(const wchar_t* fileName, std::vector<uint8_t>& data)
+    {
+        data.clear();
+
+        ScopedHandle hFile(safe_handle(CreateFileW(fileName,
+            GENERIC_READ, FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+            nullptr)));
+        if (!hFile)
+            return HRESULT_FROM_WIN32(GetLastError());
+
+        LARGE_INTEGER fileSize = {};
+        if (!GetFileSizeEx(hFile.get(), &fileSize))
+            return HRESULT_FROM_WIN32(GetLastError());
+
+        // DDS files are limited to 32-bit sizes
+        if (fileSize.HighPart > 0)
+            return HRESULT_FROM_WIN32(ERROR_FILE_TOO_LARGE);
+
+        data.resize(fileSize.LowPart);
+
+        DWORD bytesRead = 0;
+        if (!ReadFile(hFile.get(), data.data(), fileSize.LowPart, &bytesRead, nullptr))
+            return HRESULT_FROM_WIN32(GetLastError());
+
+        if (bytesRead != fileSize.LowPart)
+            return E_FAIL;
+
+        return S_OK;
+    }
+
+    HRESULT WriteData(const wchar_t* fileName, const uint8_t* data, size_t size)
+    {
+        ScopedHandle hFile(safe_handle(CreateFileW(fileName,
+            GENERIC_WRITE, 0,
+            nullptr,
+            CREATE_ALWAYS, 0,
+            nullptr)));
+        if (!hFile)
+            return HRESULT_FROM_WIN32(GetLastError());
+
+        DWORD bytesWritten = 0;
+        if (!WriteFile(hFile.get(), data, static_cast<DWORD>(size), &bytesWritten, nullptr))
+            return HRESULT_FROM_WIN32(GetLastError());
+
+        if (bytesWritten != size)
+            return E_FAIL;
+
+        return S_OK;
+    }
+
+    // Returns megabytes of DDS data produced per second, or 0 on failure
+    double MeasureDecompression(const std::vector<uint8_t>& blob, size_t ddsSize)
+    {
+        double best = 0.;
+
+        for (int pass = 0; pass < c_timingPasses; ++pass)
+        {
+            std::unique_ptr<uint8_t[]> ddsData;
+            size_t ddsDataSize = 0;
+
+            const auto start = std::chrono::high_resolution_clock::now();
+
+            HRESULT hr = DirectX::DecompressDDS(blob.data(), blob.size(), ddsData, ddsDataSize);
+
+            const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+            if (FAILED(hr) || ddsDataSize != ddsSize)
+                return 0.;
+
+            if (elapsed.count() > 0.)
+            {
+                best = std::max(best, double(ddsSize) / (1024. * 1024.) / elapsed.count());
+            }
+        }
+
+        return best;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------
+// Entry-point
+//--------------------------------------------------------------------------------------
+#ifdef _PREFAST_
+#pragma prefast(disable : 28198, "Command-line tool, frees all memory on exit")
+#endif
+
+int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
+{
+    // Parameters and defaults
+    std::wstring outputDir;
+
+    // Set locale for output since GetErrorDesc can get localized strings.
+    std::locale::global(std::locale(""));
+
+    // Process command line
+    uint32_t dwOptions = 0;
+    std::list<SConversion> conversion;
+    bool allowOpts = true;
+
+    for (int iArg = 1; iArg < argc; iArg++)
+    {
+        PWSTR pArg = argv[iArg];
+
+        if (allowOpts
+            && ('-' == pArg[0]) && ('-' == pArg[1]))
+        {
+            if (pArg[2] == 0)
+            {
+                // "-- " is the POSIX standard for "end of options" marking to escape the '-' and '/' characters at the start of filepaths.
+                allowOpts = false;
+            }
+            else if (!_wcsicmp(pArg, L"--version"))
+            {
+                PrintLogo(true);
+                return 0;
+            }
+            else if (!_wcsicmp(pArg, L"--help"))
+            {
+                PrintUsage();
+                return 0;
+            }
+            else
+            {
+                wprintf(L"Unknown option: %ls\n", pArg);
+                return 1;
+            }
+        }
+        else if (allowOpts
+            && (('-' == pArg[0]) || ('/' == pArg[0])))
+        {
+            pArg++;
+            PWSTR pValue;
+
+            for (pValue = pArg; *pValue && (':' != *pValue); pValue++);
+
+            if (*pValue)
+                *pValue++ = 0;
+
+            uint32_t dwOption = LookupByName(pArg, g_pOptions);
+
+            if (!dwOption || (dwOptions & (1 << dwOption)))
+            {
+                PrintUsage();
+                return 1;
+            }
+
+            dwOptions |= 1 << dwOption;
+
+            // Handle options with additional value parameter
+            switch (dwOption)
+            {
+            case OPT_OUTPUTDIR:
+                if (!*pValue)
+                {
+                    if ((iArg + 1 >= argc))
+                    {
+                        PrintUsage();
+                        return 1;
+                    }
+
+                    iArg++;
+                    pValue = argv[iArg];
+                }
+                break;
+            }
+
+            switch (dwOption)
+            {
+            case OPT_OUTPUTDIR:
+                {
+                    std::filesystem::path path(pValue);
+                    outputDir = path.make_preferred().native();
+                }
+                break;
+            }
+        }
+        else if (wcspbrk(pArg, L"?*") != nullptr)
+        {
+            size_t count = conversion.size();
+            std::filesystem::path path(pArg);
+            SearchForFiles(path.make_preferred(), conversion, (dwOptions & (1 << OPT_RECURSIVE)) != 0);
+            if (conversion.size() <= count)
+            {
+                wprintf(L"No matching files found for %ls\n", pArg);
+                return 1;
+            }
+        }
+        else
+        {
+            SConversion conv = {};
+            std::filesystem::path path(pArg);
+            conv.szSrc = path.make_preferred().native();
+            conversion.push_back(conv);
+        }
+    }
+
+    if (conversion.empty())
+    {
+        wprintf(L"ERROR: Need at least 1 DDS file to pack\n\n");
+        PrintUsage();
+        return 0;
+    }
+
+    if (~dwOptions & (1 << OPT_NOLOGO))
+        PrintLogo(false);
+
+    const bool unpack = (dwOptions & (1 << OPT_UNPACK)) != 0;
+
+    uint64_t totalIn = 0;
+    uint64_t totalOut = 0;
+
+    for (auto pConv = conversion.begin(); pConv != conversion.end(); ++pConv)
+    {
+        std::filesystem::path curpath(pConv->szSrc);
+
+        // Determine output file name
+        std::filesystem::path outpath = outputDir.empty() ? curpath.parent_path() : std::filesystem::path(outputDir);
+        outpath.append(curpath.stem().concat(unpack ? L".dds" : L".ddsz").native());
+
+        std::wstring outputFile = outpath.native();
+        if (dwOptions & (1 << OPT_TOLOWER))
+        {
+            std::transform(outputFile.begin(), outputFile.end(), outputFile.begin(), towlower);
+        }
+
+        if (_wcsicmp(outputFile.c_str(), curpath.c_str()) == 0)
+        {
+            wprintf(L"ERROR: Output file %ls would replace its input, use -o\n", outputFile.c_str());
+            return 1;
+        }
+
+        if (~dwOptions & (1 << OPT_OVERWRITE))
+        {
+            if (GetFileAttributesW(outputFile.c_str()) != INVALID_FILE_ATTRIBUTES)
+            {
+                wprintf(L"ERROR: Output file %ls already exists, use -y to overwrite!\n", outputFile.c_str());
+                return 1;
+            }
+        }
+
+        wprintf(L"reading %ls", curpath.c_str());
+        fflush(stdout);
+
+        std::vector<uint8_t> data;
+        HRESULT hr = ReadData(curpath.c_str(), data);
+        if (FAILED(hr))
+        {
+            wprintf(L"\nERROR: Failed to read file (%08X%ls)\n", static_cast<unsigned int>(hr), GetErrorDesc(hr));
+            return 1;
+        }
+
+        if (unpack)
+        {
+            std::unique_ptr<uint8_t[]> ddsData;
+            size_t ddsDataSize = 0;
+            hr = DirectX::DecompressDDS(data.data(), data.size(), ddsData, ddsDataSize);
+            if (FAILED(hr))
+            {
+                wprintf(L"\nERROR: Failed to unpack file (%08X%ls)\n", static_cast<unsigned int>(hr), GetErrorDesc(hr));
+                return 1;
+            }
+
+            hr = WriteData(outputFile.c_str(), ddsData.get(), ddsDataSize);
+            if (FAILED(hr))
+            {
+                wprintf(L"\nERROR: Failed writing output file %ls (%08X%ls)\n", outputFile.c_str(), static_cast<unsigned int>(hr), GetErrorDesc(hr));
+                return 1;
+            }
+
+            wprintf(L" (%zu -> %zu bytes)\n", data.size(), ddsDataSize);
+
+            totalIn += data.size();
+            totalOut += ddsDataSize;
+            continue;
+        }
+
+        if (DirectX::IsCompressedDDS(data.data(), data.size()))
+        {
+            wprintf(L"\nERROR: File is already packed\n");
+            return 1;
+        }
+
+        std::vector<uint8_t> blob;
+        hr = DirectX::CompressDDS(data.data(), data.size(), blob);
+        if (FAILED(hr))
+        {
+            wprintf(L"\nERROR: Failed to pack file (%08X%ls)\n", static_cast<unsigned int>(hr), GetErrorDesc(hr));
+            return 1;
+        }
+
+        const double rate = MeasureDecompression(blob, data.size());
+        if (rate <= 0.)
+        {
+            wprintf(L"\nERROR: Packed data failed to verify\n");
+            return 1;
+        }
+
+        hr = WriteData(outputFile.c_str(), blob.data(), blob.size());
+        if (FAILED(hr))
+        {
+            wprintf(L"\nERROR: Failed writing output file %ls (%08X%ls)\n", outputFile.c_str(), static_cast<unsigned int>(hr), GetErrorDesc(hr));
+            return 1;
+        }
+
+        wprintf(L" (%zu -> %zu bytes, %.1f%%, decompresses at %.0f MB/s)\n",
+            data.size(), blob.size(), 100. * double(blob.size()) / double(data.size()), rate);
+
+        totalIn += data.size();
+        totalOut += blob.size();
+    }
+
+    if (conversion.size() > 1 && totalIn > 0)
+    {
+        wprintf(L"\n%zu files, %llu -> %llu bytes (%.1f%%)\n", conversion.size(),
+            totalIn, totalOut, 100. * double(totalOut) / double(totalIn));
+    }
+
+    return 0;
+}
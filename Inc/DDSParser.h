@@ -0,0 +1,82 @@
+//--------------------------------------------------------------------------------------
+// File: DDSParser.h
+//
+// Validates a DDS file in memory and describes the texture it holds without creating
+// any Direct3D objects, for use by tools and pipelines that run without a device.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <objbase.h>
+#include <dxgiformat.h>
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace DirectX
+{
+#ifndef DDS_ALPHA_MODE_DEFINED
+#define DDS_ALPHA_MODE_DEFINED
+    enum DDS_ALPHA_MODE : uint32_t
+    {
+        DDS_ALPHA_MODE_UNKNOWN = 0,
+        DDS_ALPHA_MODE_STRAIGHT = 1,
+        DDS_ALPHA_MODE_PREMULTIPLIED = 2,
+        DDS_ALPHA_MODE_OPAQUE = 3,
+        DDS_ALPHA_MODE_CUSTOM = 4,
+    };
+#endif
+
+    // Values match D3D11_RESOURCE_DIMENSION and D3D12_RESOURCE_DIMENSION
+    enum DDS_TEXTURE_DIMENSION : uint32_t
+    {
+        DDS_TEXTURE_DIMENSION_UNKNOWN = 0,
+        DDS_TEXTURE_DIMENSION_1D = 2,
+        DDS_TEXTURE_DIMENSION_2D = 3,
+        DDS_TEXTURE_DIMENSION_3D = 4,
+    };
+
+    struct DDSTextureDesc
+    {
+        DDS_TEXTURE_DIMENSION   dimension;
+        DXGI_FORMAT             format;
+        uint32_t                width;
+        uint32_t                height;
+        uint32_t                depth;
+        uint32_t                arraySize;      // Includes all six faces of each cubemap
+        uint32_t                mipLevels;
+        bool                    isCubeMap;
+        DDS_ALPHA_MODE          alphaMode;
+        size_t                  dataOffset;     // Start of the pixel data after the headers
+        size_t                  subresourceCount;   // mipLevels * arraySize
+    };
+
+    // Subresources are ordered by array item, then by mip level, as Direct3D numbers them.
+    struct DDSSubresource
+    {
+        size_t      offset;         // From the start of the DDS data
+        size_t      size;           // slicePitch * depth
+        size_t      rowPitch;
+        size_t      slicePitch;
+        uint32_t    width;
+        uint32_t    height;
+        uint32_t    depth;
+    };
+
+    // Checks the headers and that the data holds every subresource they describe. Pass
+    // nullptr for subresources to get just the description, or an array of at least
+    // desc->subresourceCount entries to also get their byte ranges.
+    HRESULT __cdecl ParseDDS(
+        _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+        _In_ size_t ddsDataSize,
+        _Out_ DDSTextureDesc* desc,
+        _Out_writes_opt_(maxSubresources) DDSSubresource* subresources = nullptr,
+        _In_ size_t maxSubresources = 0) noexcept;
+}
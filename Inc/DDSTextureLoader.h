@@ -7,6 +7,8 @@
 // a full-featured DDS file reader, writer, and texture processing pipeline see
 // the 'Texconv' sample and the 'DirectXTex' library.
 //
+// Files packed by the 'ddspack' tool (per-chunk LZ4 compressed DDS) load the same way.
+//
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 //
@@ -47,6 +49,9 @@ namespace DirectX
             DDS_LOADER_DEFAULT = 0,
             DDS_LOADER_FORCE_SRGB = 0x1,
             DDS_LOADER_IGNORE_SRGB = 0x2,
+            DDS_LOADER_MEMORY_MAPPED = 0x4,     // File versions only: map the file rather than reading it into a heap copy
+            DDS_LOADER_MIP_CPU = 0x8,           // Build the mipmaps of single-level 2D textures on the CPU when GenerateMips can't be used
+            DDS_LOADER_MIP_KAISER = 0x10,       // With DDS_LOADER_MIP_CPU: Kaiser filter rather than box
         };
     }
 
@@ -19,7 +19,10 @@
 #endif
 
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include <DirectXMath.h>
 
@@ -49,6 +52,42 @@ namespace DirectX
         };
 
 
+        // Per-frame camera state shared by many effects. Values derived from the view, such as the
+        // eye position, are computed once here instead of by every effect it is applied to.
+        class EffectCamera
+        {
+        public:
+            EffectCamera() noexcept;
+            EffectCamera(FXMMATRIX view, CXMMATRIX projection) noexcept;
+
+            void XM_CALLCONV SetView(FXMMATRIX value) noexcept;
+            void XM_CALLCONV SetProjection(FXMMATRIX value) noexcept;
+
+            XMMATRIX XM_CALLCONV GetView() const noexcept { return XMLoadFloat4x4(&mView); }
+            XMMATRIX XM_CALLCONV GetProjection() const noexcept { return XMLoadFloat4x4(&mProjection); }
+            XMVECTOR XM_CALLCONV GetEyePosition() const noexcept { return XMLoadFloat4(&mEyePosition); }
+
+        private:
+            XMFLOAT4X4  mView;
+            XMFLOAT4X4  mProjection;
+            XMFLOAT4    mEyePosition;
+        };
+
+
+        // World matrix together with the inverse transpose used for lighting, so that many objects
+        // can be prepared in one pass with ComputeEffectWorldTransforms.
+        struct EffectWorldTransform
+        {
+            XMFLOAT4X4  world;
+            XMFLOAT3X4  worldInverseTranspose;  // Upper three rows of the world inverse
+        };
+
+        void __cdecl ComputeEffectWorldTransforms(
+            _In_reads_(count) const XMFLOAT4X4* worlds,
+            size_t count,
+            _Out_writes_(count) EffectWorldTransform* transforms) noexcept;
+
+
         // Abstract interface for effects with world, view, and projection matrices.
         class IEffectMatrices
         {
@@ -63,6 +102,11 @@ namespace DirectX
             virtual void XM_CALLCONV SetProjection(FXMMATRIX value) = 0;
             virtual void XM_CALLCONV SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection);
 
+            // The defaults forward to SetView/SetProjection and SetWorld; built-in lit effects
+            // use the precomputed values instead of deriving them again.
+            virtual void __cdecl SetCamera(const EffectCamera& camera);
+            virtual void __cdecl SetWorldTransform(const EffectWorldTransform& transform);
+
         protected:
             IEffectMatrices() = default;
             IEffectMatrices(IEffectMatrices&&) = default;
@@ -166,6 +210,8 @@ namespace DirectX
             void XM_CALLCONV SetView(FXMMATRIX value) override;
             void XM_CALLCONV SetProjection(FXMMATRIX value) override;
             void XM_CALLCONV SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection) override;
+            void __cdecl SetCamera(const EffectCamera& camera) override;
+            void __cdecl SetWorldTransform(const EffectWorldTransform& transform) override;
 
             // Material settings.
             void XM_CALLCONV SetDiffuseColor(FXMVECTOR value);
@@ -351,6 +397,8 @@ namespace DirectX
             void XM_CALLCONV SetView(FXMMATRIX value) override;
             void XM_CALLCONV SetProjection(FXMMATRIX value) override;
             void XM_CALLCONV SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection) override;
+            void __cdecl SetCamera(const EffectCamera& camera) override;
+            void __cdecl SetWorldTransform(const EffectWorldTransform& transform) override;
 
             // Material settings.
             void XM_CALLCONV SetDiffuseColor(FXMVECTOR value);
@@ -404,6 +452,14 @@ namespace DirectX
         class SkinnedEffect : public IEffect, public IEffectMatrices, public IEffectLights, public IEffectFog, public IEffectSkinning
         {
         public:
+            enum BoneFormat
+            {
+                BoneFormat_Matrix = 0,          // 4x3 matrix per bone
+                BoneFormat_DualQuaternion,      // Rotation, translation, and uniform scale per bone, blended as dual quaternions
+            };
+
+            static constexpr int MaxDualQuaternionBones = 108;
+
             explicit SkinnedEffect(_In_ ID3D11Device* device);
 
             SkinnedEffect(SkinnedEffect&&) noexcept;
@@ -424,6 +480,8 @@ namespace DirectX
             void XM_CALLCONV SetView(FXMMATRIX value) override;
             void XM_CALLCONV SetProjection(FXMMATRIX value) override;
             void XM_CALLCONV SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection) override;
+            void __cdecl SetCamera(const EffectCamera& camera) override;
+            void __cdecl SetWorldTransform(const EffectWorldTransform& transform) override;
 
             // Material settings.
             void XM_CALLCONV SetDiffuseColor(FXMVECTOR value);
@@ -459,6 +517,20 @@ namespace DirectX
             void __cdecl SetBoneTransforms(_In_reads_(count) XMMATRIX const* value, size_t count) override;
             void __cdecl ResetBoneTransforms() override;
 
+            // Bone palette settings. The dual quaternion format takes two constants per bone instead of
+            // three, allows up to MaxDualQuaternionBones, and avoids the collapsing joints of blended
+            // matrices, but bone transforms must be made of rotation, uniform scale, and translation.
+            // Only the bones passed to the last SetBoneTransforms call are uploaded in this format.
+            // Changing the format resets the bone transforms.
+            void __cdecl SetBoneFormat(BoneFormat value);
+
+            // Converts bone matrices to the dual quaternion format layout: a rotation quaternion
+            // followed by (translation, scale) for each bone.
+            static void __cdecl ConvertBoneTransforms(
+                _In_reads_(count) XMMATRIX const* value,
+                size_t count,
+                _Out_writes_(count * 2) XMVECTOR* result) noexcept;
+
             // Normal compression settings.
             void __cdecl SetBiasedVertexNormals(bool value);
 
@@ -602,6 +674,8 @@ namespace DirectX
             void XM_CALLCONV SetView(FXMMATRIX value) override;
             void XM_CALLCONV SetProjection(FXMMATRIX value) override;
             void XM_CALLCONV SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection) override;
+            void __cdecl SetCamera(const EffectCamera& camera) override;
+            void __cdecl SetWorldTransform(const EffectWorldTransform& transform) override;
 
             // Material settings.
             void XM_CALLCONV SetDiffuseColor(FXMVECTOR value);
@@ -705,6 +779,8 @@ namespace DirectX
             void XM_CALLCONV SetView(FXMMATRIX value) override;
             void XM_CALLCONV SetProjection(FXMMATRIX value) override;
             void XM_CALLCONV SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection) override;
+            void __cdecl SetCamera(const EffectCamera& camera) override;
+            void __cdecl SetWorldTransform(const EffectWorldTransform& transform) override;
 
             // Light settings.
             void __cdecl SetLightEnabled(int whichLight, bool value) override;
@@ -840,6 +916,82 @@ namespace DirectX
             std::unique_ptr<Impl> pImpl;
         };
 
+        //------------------------------------------------------------------------------
+        // Creates the shaders of the built-in effects ahead of first use
+        enum EffectWarmUpFlags : uint32_t
+        {
+            EffectWarmUp_BasicEffect = 0x1,
+            EffectWarmUp_AlphaTestEffect = 0x2,
+            EffectWarmUp_DualTextureEffect = 0x4,
+            EffectWarmUp_EnvironmentMapEffect = 0x8,
+            EffectWarmUp_SkinnedEffect = 0x10,
+            EffectWarmUp_NormalMapEffect = 0x20,    // Feature Level 10.0 or later
+            EffectWarmUp_PBREffect = 0x40,          // Feature Level 10.0 or later
+            EffectWarmUp_DebugEffect = 0x80,        // Feature Level 10.0 or later
+
+            EffectWarmUp_All = 0xFF,
+        };
+
+        class EffectShaderWarmUp
+        {
+        public:
+            struct Statistics
+            {
+                size_t  created;        // Shaders created by this call
+                size_t  existing;       // Shaders that had already been created
+                size_t  unsupported;    // Shaders the device feature level cannot create
+                double  seconds;        // Elapsed time for the call
+            };
+
+            // One shader permutation of a built-in effect type. The numbering is internal to this version of
+            // the library, so lists are obtained from GetUsedPermutations rather than written by hand.
+            struct Permutation
+            {
+                uint32_t    effect;         // A single EffectWarmUp_* flag
+                uint32_t    permutation;
+            };
+
+            using ProgressCallback = std::function<void __cdecl(size_t completed, size_t total)>;
+
+            explicit EffectShaderWarmUp(_In_ ID3D11Device* device);
+
+            EffectShaderWarmUp(EffectShaderWarmUp&&) noexcept;
+            EffectShaderWarmUp& operator= (EffectShaderWarmUp&&) noexcept;
+
+            EffectShaderWarmUp(EffectShaderWarmUp const&) = delete;
+            EffectShaderWarmUp& operator= (EffectShaderWarmUp const&) = delete;
+
+            virtual ~EffectShaderWarmUp();
+
+            // Creates every shader of the selected effect types on up to maxWorkers threads (0 uses one per core).
+            // The progress callback is invoked from the worker threads, one call at a time.
+            Statistics __cdecl WarmUp(
+                uint32_t effects = EffectWarmUp_All,
+                const ProgressCallback& progress = nullptr,
+                size_t maxWorkers = 0);
+
+            // Creates only the shaders the listed permutations use, such as those an earlier run reported.
+            Statistics __cdecl WarmUp(
+                _In_reads_(count) const Permutation* permutations,
+                size_t count,
+                const ProgressCallback& progress = nullptr,
+                size_t maxWorkers = 0);
+
+            // Appends the permutations the built-in effects have applied on this device so far, for saving
+            // and passing to WarmUp on a later run.
+            void __cdecl GetUsedPermutations(std::vector<Permutation>& permutations) const;
+
+            // Shaders are shared by all effects of a type on the device, and this object keeps them alive even
+            // while no such effect exists. Release drops those references.
+            void __cdecl Release() noexcept;
+
+        private:
+            // Private implementation.
+            class Impl;
+
+            std::unique_ptr<Impl> pImpl;
+        };
+
         //------------------------------------------------------------------------------
         // Abstract interface to factory for sharing effects and texture resources
         class IEffectFactory
@@ -901,6 +1053,20 @@ namespace DirectX
         };
 
 
+        // Texture cache shared by the effect factories created for the same device.
+        struct TextureCacheStatistics
+        {
+            size_t  textures;       // Textures held by the cache
+            size_t  bytes;          // Estimated video memory of those textures
+            size_t  budget;         // Zero if unlimited
+            size_t  hits;           // Requests served from the cache
+            size_t  waits;          // Requests that waited on another thread loading the same texture
+            size_t  misses;         // Requests that loaded the texture
+            size_t  evictions;      // Textures dropped to stay within the budget
+            size_t  evictedBytes;
+        };
+
+
         // Factory for sharing effects and texture resources
         class EffectFactory : public IEffectFactory
         {
@@ -929,6 +1095,12 @@ namespace DirectX
 
             void __cdecl SetDirectory(_In_opt_z_ const wchar_t* path) noexcept;
 
+            // Texture cache settings. The cache is shared by every effect factory for the device;
+            // ReleaseCache drops only the textures this factory asked for and no other factory type
+            // did. A budget of zero bytes means no limit.
+            void __cdecl SetTextureCacheBudget(size_t bytes) noexcept;
+            TextureCacheStatistics __cdecl GetTextureCacheStatistics() const noexcept;
+
             // Properties.
             ID3D11Device* GetDevice() const noexcept;
 
@@ -967,6 +1139,12 @@ namespace DirectX
 
             void __cdecl SetDirectory(_In_opt_z_ const wchar_t* path) noexcept;
 
+            // Texture cache settings. The cache is shared by every effect factory for the device;
+            // ReleaseCache drops only the textures this factory asked for and no other factory type
+            // did. A budget of zero bytes means no limit.
+            void __cdecl SetTextureCacheBudget(size_t bytes) noexcept;
+            TextureCacheStatistics __cdecl GetTextureCacheStatistics() const noexcept;
+
             // Properties.
             ID3D11Device* GetDevice() const noexcept;
 
@@ -1025,6 +1203,12 @@ namespace DirectX
 
             void __cdecl SetDirectory(_In_opt_z_ const wchar_t* path) noexcept;
 
+            // Texture cache settings. The cache is shared by every effect factory for the device;
+            // ReleaseCache drops only the textures this factory asked for and no other factory type
+            // did. A budget of zero bytes means no limit.
+            void __cdecl SetTextureCacheBudget(size_t bytes) noexcept;
+            TextureCacheStatistics __cdecl GetTextureCacheStatistics() const noexcept;
+
             // Properties.
             ID3D11Device* GetDevice() const noexcept;
 
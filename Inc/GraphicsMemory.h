@@ -16,6 +16,7 @@
 #endif
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 
 
@@ -44,6 +45,38 @@ namespace DirectX
 
             void __cdecl Commit();
 
+        #if !(defined(_XBOX_ONE) && defined(_TITLE))
+            // Per-frame constant ring for Direct3D 11.1. Once enabled, the built-in effects sub-allocate their
+            // constants from one large dynamic buffer and bind them by offset, instead of each mapping its own
+            // constant buffer with discard. Commit must be called once per frame.
+            struct ConstantAllocation
+            {
+                ID3D11Buffer*   buffer;
+                UINT            firstConstant;  // In 16-byte shader constants
+                UINT            numConstants;
+                uint64_t        generation;     // The allocation can be rebound while this matches GetConstantRingGeneration
+            };
+
+            static constexpr size_t c_DefaultConstantRingSize = 4 * 1024 * 1024;
+
+            // Returns false if the device lacks constant buffer offsetting, or no-overwrite maps of constant buffers
+            bool __cdecl EnableConstantRing(size_t sizeInBytes = c_DefaultConstantRingSize);
+
+            // Copies constants into the ring (immediate context only)
+            bool __cdecl AllocateConstants(
+                _In_ ID3D11DeviceContext* context,
+                _In_reads_bytes_(size) const void* data, size_t size,
+                _Out_ ConstantAllocation& allocation);
+
+            // Binds an allocation to a vertex and pixel shader constant buffer slot
+            bool __cdecl BindConstants(_In_ ID3D11DeviceContext* context, UINT slot, const ConstantAllocation& allocation);
+
+            uint64_t __cdecl GetConstantRingGeneration() const noexcept;
+
+            // The singleton if it exists and has the constant ring enabled, otherwise nullptr
+            static GraphicsMemory* __cdecl GetConstantRing() noexcept;
+        #endif
+
             // Singleton
             static GraphicsMemory& __cdecl Get();
 
@@ -35,12 +35,18 @@
 
 namespace DirectX
 {
+    class ModelBVH;
+
     inline namespace DX11
     {
         class IEffect;
         class IEffectFactory;
+        class IEffectMatrices;
+        class IEffectSkinning;
         class CommonStates;
+        class Model;
         class ModelMesh;
+        class ModelMeshPart;
 
         //------------------------------------------------------------------------------
         // Model loading options
@@ -53,6 +59,29 @@ namespace DirectX
             ModelLoader_AllowLargeModels = 0x8,
             ModelLoader_IncludeBones = 0x10,
             ModelLoader_DisableSkinning = 0x20,
+            ModelLoader_ConsolidateBuffers = 0x40,
+            ModelLoader_QuantizeVertices = 0x80,
+            ModelLoader_BuildPickingBVH = 0x100,
+        };
+
+        //------------------------------------------------------------------------------
+        // View frustum culling statistics
+        struct ModelCullStatistics
+        {
+            size_t  meshesDrawn;        // Number of meshes which passed the frustum test
+            size_t  meshesCulled;       // Number of meshes rejected by the frustum test
+        };
+
+        //------------------------------------------------------------------------------
+        // Closest ray hit reported by Model::Intersects
+        struct ModelIntersection
+        {
+            float                   distance;   // Ray parameter of the hit (origin + distance * direction)
+            const ModelMesh*        mesh;
+            const ModelMeshPart*    part;
+            uint32_t                triangle;   // Triangle number within the mesh part
+            float                   u;          // Barycentric coordinates of the hit
+            float                   v;
         };
 
         //------------------------------------------------------------------------------
@@ -125,6 +154,7 @@ namespace DirectX
             Microsoft::WRL::ComPtr<ID3D11Buffer>                    vertexBuffer;
             std::shared_ptr<IEffect>                                effect;
             std::shared_ptr<InputLayoutCollection>                  vbDecl;
+            std::shared_ptr<ModelBVH>                               pickingBVH;
             bool                                                    isAlpha;
 
             // Draw mesh part with custom effect
@@ -147,6 +177,12 @@ namespace DirectX
 
             // Change effect used by part and regenerate input layout (be sure to call Model::Modified as well)
             void __cdecl ModifyEffect(_In_ ID3D11Device* device, _In_ const std::shared_ptr<IEffect>& ieffect, bool isalpha = false);
+
+            // Build the CPU-side picking data for a triangle list part from a copy of its vertex and index buffer contents
+            // (startIndex and vertexOffset are applied as they are when drawing)
+            void __cdecl CreatePickingBVH(
+                _In_reads_bytes_(vertexCount * positionStride) const XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+                _In_ const void* indices, size_t totalIndexCount);
         };
 
 
@@ -216,6 +252,84 @@ namespace DirectX
         };
 
 
+        //------------------------------------------------------------------------------
+        // Handle to a model being loaded on a background worker by Model::CreateFrom*Async
+        enum ModelLoadPriority : uint32_t
+        {
+            ModelLoadPriority_Low = 0,
+            ModelLoadPriority_Normal,
+            ModelLoadPriority_High,
+        };
+
+        class ModelLoadHandle
+        {
+        public:
+            ModelLoadHandle() noexcept = default;
+
+            ModelLoadHandle(ModelLoadHandle&&) = default;
+            ModelLoadHandle& operator= (ModelLoadHandle&&) = default;
+
+            ModelLoadHandle(ModelLoadHandle const&) = default;
+            ModelLoadHandle& operator= (ModelLoadHandle const&) = default;
+
+            ~ModelLoadHandle() = default;
+
+            // Completion poll for the render thread (true once loaded, failed, or cancelled)
+            bool __cdecl IsReady() const noexcept;
+
+            // Requests cancellation; work already past its last cancellation point still completes
+            // (loads check before starting, after reading the file, and before creating GPU buffers)
+            void __cdecl Cancel() noexcept;
+            bool __cdecl IsCancelled() const noexcept;
+
+            // Blocks until ready
+            void __cdecl Wait() const;
+
+            // Blocks until ready, then returns the model (nullptr if cancelled) or rethrows the loader's exception.
+            // The model can only be retrieved once.
+            std::unique_ptr<Model> __cdecl Get();
+
+            explicit operator bool() const noexcept { return pImpl != nullptr; }
+
+            // Private implementation.
+            class Impl;
+
+        private:
+            std::shared_ptr<Impl> pImpl;
+
+            friend class Model;
+        };
+
+        // Background workers that run Model::CreateFrom*Async loads, owned by the application.
+        // Destroying the queue fails every load that has not started (Get throws), cancels the
+        // ones in flight, and waits only for those to reach their next cancellation point.
+        class ModelLoadQueue
+        {
+        public:
+            // threadCount of 0 picks a small default; loads are mostly I/O and driver bound
+            explicit ModelLoadQueue(size_t threadCount = 0);
+
+            ModelLoadQueue(ModelLoadQueue&&) noexcept;
+            ModelLoadQueue& operator= (ModelLoadQueue&&) noexcept;
+
+            ModelLoadQueue(ModelLoadQueue const&) = delete;
+            ModelLoadQueue& operator= (ModelLoadQueue const&) = delete;
+
+            ~ModelLoadQueue();
+
+            // Loads queued or running
+            size_t __cdecl GetPendingCount() const noexcept;
+
+            // Private implementation.
+            class Impl;
+
+        private:
+            std::unique_ptr<Impl> pImpl;
+
+            friend class Model;
+        };
+
+
         //------------------------------------------------------------------------------
         // A model consists of one or more meshes
         class Model
@@ -245,6 +359,15 @@ namespace DirectX
                 bool wireframe = false,
                 _In_ std::function<void __cdecl()> setCustomState = nullptr) const;
 
+            // Draw all the meshes in the model which intersect the frustum (in world space)
+            void XM_CALLCONV Draw(
+                _In_ ID3D11DeviceContext* deviceContext,
+                const CommonStates& states,
+                FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                const BoundingFrustum& frustum,
+                bool wireframe = false,
+                _In_ std::function<void __cdecl()> setCustomState = nullptr) const;
+
             // Draw all the meshes using model bones
             void XM_CALLCONV Draw(
                 _In_ ID3D11DeviceContext* deviceContext,
@@ -263,6 +386,42 @@ namespace DirectX
                 bool wireframe = false,
                 _In_ std::function<void __cdecl()> setCustomState = nullptr) const;
 
+            // Test the bounding sphere of every mesh for many instances of the model against a frustum (in world space)
+            // Writes one entry per mesh per instance, and returns the number of visible meshes
+            size_t __cdecl CullMeshes(
+                const BoundingFrustum& frustum,
+                size_t ninstances, _In_reads_(ninstances) const XMMATRIX* worlds,
+                _Out_writes_(ninstances * meshes.size()) uint8_t* visible) const;
+
+            // Find the closest triangle hit by a ray (in world space) among the mesh parts with picking data (see ModelLoader_BuildPickingBVH)
+            bool XM_CALLCONV Intersects(FXMVECTOR origin, FXMVECTOR direction, FXMMATRIX world, _Out_ ModelIntersection& hit) const;
+
+            // Culling statistics accumulated by Draw with a frustum
+            ModelCullStatistics __cdecl GetCullStatistics() const noexcept { return mCullStats; }
+            void __cdecl ResetCullStatistics() noexcept { mCullStats = {}; }
+
+            // Draw all the meshes using hardware instancing, where each instance transform is applied before world (see EnableInstancing)
+            void XM_CALLCONV DrawInstanced(
+                _In_ ID3D11DeviceContext* deviceContext,
+                const CommonStates& states,
+                size_t ninstances, _In_reads_(ninstances) const XMFLOAT3X4* instanceTransforms,
+                FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                bool wireframe = false,
+                _In_ std::function<void __cdecl()> setCustomState = nullptr) const;
+
+            void XM_CALLCONV DrawInstanced(
+                _In_ ID3D11DeviceContext* deviceContext,
+                const CommonStates& states,
+                size_t ninstances, _In_reads_(ninstances) const XMMATRIX* instanceTransforms,
+                FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                bool wireframe = false,
+                _In_ std::function<void __cdecl()> setCustomState = nullptr) const;
+
+            // Switch all effects to instancing and add per-instance transforms to the input layouts
+            // (requires NormalMapEffect, PBREffect, or DebugEffect, after which the model must be drawn with DrawInstanced)
+            // Every part is checked first, so an unsupported effect throws without changing the model
+            void __cdecl EnableInstancing(_In_ ID3D11Device* device);
+
             // Compute bone positions based on heirarchy and transform matrices
             void __cdecl CopyAbsoluteBoneTransformsTo(
                 size_t nbones,
@@ -284,7 +443,9 @@ namespace DirectX
                 _Out_writes_(nbones) XMMATRIX* boneTransforms) const;
 
             // Notify model that effects, parts list, or mesh list has changed
-            void __cdecl Modified() noexcept { mEffectCache.clear(); }
+            // (draws check their cached part lists against the current meshes, parts, effects, and isAlpha flags and
+            // rebuild them on a mismatch, but UpdateEffects caches effect pointers and needs this after any effect change)
+            void __cdecl Modified() noexcept { mEffectCache.clear(); mDrawLists.reset(); }
 
             // Update all effects used by the model
             void __cdecl UpdateEffects(_In_ std::function<void __cdecl(IEffect*)> setEffect);
@@ -315,7 +476,7 @@ namespace DirectX
                 _In_ IEffectFactory& fxFactory,
                 ModelLoaderFlags flags = ModelLoader_Clockwise);
 
-            // Loads a model from a .VBO file
+            // Loads a model from a .VBO file (legacy 16-bit or version 2 with 32-bit indices and submeshes)
             static std::unique_ptr<Model> __cdecl CreateFromVBO(
                 _In_ ID3D11Device* device,
                 _In_reads_bytes_(dataSize) const uint8_t* meshData, _In_ size_t dataSize,
@@ -327,6 +488,60 @@ namespace DirectX
                 _In_ std::shared_ptr<IEffect> ieffect = nullptr,
                 ModelLoaderFlags flags = ModelLoader_Clockwise);
 
+            // Loads a model from a baked model cache written by BakeCMO or BakeSDKMESH (files are memory-mapped)
+            static std::unique_ptr<Model> __cdecl CreateFromBaked(
+                _In_ ID3D11Device* device,
+                _In_reads_bytes_(dataSize) const uint8_t* meshData, _In_ size_t dataSize,
+                _In_ IEffectFactory& fxFactory);
+            static std::unique_ptr<Model> __cdecl CreateFromBaked(
+                _In_ ID3D11Device* device,
+                _In_z_ const wchar_t* szFileName,
+                _In_ IEffectFactory& fxFactory);
+
+            // Loads a model on one of the queue's workers. File I/O, parsing, effect creation, and texture loads
+            // all run off the calling thread, so the device must be free-threaded and the effect
+            // factory (or effect) must remain valid and thread-safe until the handle is ready.
+            static ModelLoadHandle __cdecl CreateFromCMOAsync(
+                ModelLoadQueue& queue,
+                _In_ ID3D11Device* device,
+                _In_z_ const wchar_t* szFileName,
+                _In_ IEffectFactory& fxFactory,
+                ModelLoaderFlags flags = ModelLoader_CounterClockwise,
+                ModelLoadPriority priority = ModelLoadPriority_Normal);
+            static ModelLoadHandle __cdecl CreateFromSDKMESHAsync(
+                ModelLoadQueue& queue,
+                _In_ ID3D11Device* device,
+                _In_z_ const wchar_t* szFileName,
+                _In_ IEffectFactory& fxFactory,
+                ModelLoaderFlags flags = ModelLoader_Clockwise,
+                ModelLoadPriority priority = ModelLoadPriority_Normal);
+            static ModelLoadHandle __cdecl CreateFromVBOAsync(
+                ModelLoadQueue& queue,
+                _In_ ID3D11Device* device,
+                _In_z_ const wchar_t* szFileName,
+                _In_ std::shared_ptr<IEffect> ieffect = nullptr,
+                ModelLoaderFlags flags = ModelLoader_Clockwise,
+                ModelLoadPriority priority = ModelLoadPriority_Normal);
+            static ModelLoadHandle __cdecl CreateFromBakedAsync(
+                ModelLoadQueue& queue,
+                _In_ ID3D11Device* device,
+                _In_z_ const wchar_t* szFileName,
+                _In_ IEffectFactory& fxFactory,
+                ModelLoadPriority priority = ModelLoadPriority_Normal);
+
+            // Runs the .CMO / .SDKMESH loader once and writes the result as a baked model cache
+            // (uses the immediate context to read back the consolidated buffers)
+            static void __cdecl BakeCMO(
+                _In_ ID3D11Device* device,
+                _In_reads_bytes_(dataSize) const uint8_t* meshData, size_t dataSize,
+                _In_z_ const wchar_t* szBakedFile,
+                ModelLoaderFlags flags = ModelLoader_CounterClockwise);
+            static void __cdecl BakeSDKMESH(
+                _In_ ID3D11Device* device,
+                _In_reads_bytes_(dataSize) const uint8_t* meshData, size_t dataSize,
+                _In_z_ const wchar_t* szBakedFile,
+                ModelLoaderFlags flags = ModelLoader_Clockwise);
+
 #if defined(_MSC_VER) && !defined(_NATIVE_WCHAR_T_DEFINED)
             static std::unique_ptr<Model> __cdecl CreateFromCMO(
                 _In_ ID3D11Device* device,
@@ -346,11 +561,107 @@ namespace DirectX
                 _In_z_ const __wchar_t* szFileName,
                 _In_ std::shared_ptr<IEffect> ieffect = nullptr,
                 ModelLoaderFlags flags = ModelLoader_Clockwise);
+
+            static std::unique_ptr<Model> __cdecl CreateFromBaked(
+                _In_ ID3D11Device* device,
+                _In_z_ const __wchar_t* szFileName,
+                _In_ IEffectFactory& fxFactory);
+
+            static ModelLoadHandle __cdecl CreateFromCMOAsync(
+                ModelLoadQueue& queue,
+                _In_ ID3D11Device* device,
+                _In_z_ const __wchar_t* szFileName,
+                _In_ IEffectFactory& fxFactory,
+                ModelLoaderFlags flags = ModelLoader_CounterClockwise,
+                ModelLoadPriority priority = ModelLoadPriority_Normal);
+
+            static ModelLoadHandle __cdecl CreateFromSDKMESHAsync(
+                ModelLoadQueue& queue,
+                _In_ ID3D11Device* device,
+                _In_z_ const __wchar_t* szFileName,
+                _In_ IEffectFactory& fxFactory,
+                ModelLoaderFlags flags = ModelLoader_Clockwise,
+                ModelLoadPriority priority = ModelLoadPriority_Normal);
+
+            static ModelLoadHandle __cdecl CreateFromVBOAsync(
+                ModelLoadQueue& queue,
+                _In_ ID3D11Device* device,
+                _In_z_ const __wchar_t* szFileName,
+                _In_ std::shared_ptr<IEffect> ieffect = nullptr,
+                ModelLoaderFlags flags = ModelLoader_Clockwise,
+                ModelLoadPriority priority = ModelLoadPriority_Normal);
+
+            static ModelLoadHandle __cdecl CreateFromBakedAsync(
+                ModelLoadQueue& queue,
+                _In_ ID3D11Device* device,
+                _In_z_ const __wchar_t* szFileName,
+                _In_ IEffectFactory& fxFactory,
+                ModelLoadPriority priority = ModelLoadPriority_Normal);
+
+            static void __cdecl BakeCMO(
+                _In_ ID3D11Device* device,
+                _In_reads_bytes_(dataSize) const uint8_t* meshData, size_t dataSize,
+                _In_z_ const __wchar_t* szBakedFile,
+                ModelLoaderFlags flags = ModelLoader_CounterClockwise);
+
+            static void __cdecl BakeSDKMESH(
+                _In_ ID3D11Device* device,
+                _In_reads_bytes_(dataSize) const uint8_t* meshData, size_t dataSize,
+                _In_z_ const __wchar_t* szBakedFile,
+                ModelLoaderFlags flags = ModelLoader_Clockwise);
 #endif // !_NATIVE_WCHAR_T_DEFINED
 
         private:
             std::set<IEffect*>  mEffectCache;
 
+            mutable ModelCullStatistics mCullStats = {};
+
+            // Flattened list of mesh parts with the effect interfaces resolved, rebuilt on demand when the parts change.
+            // Const draws from several threads (each with its own device context) may share one model as long as
+            // nothing modifies it meanwhile; the frustum-culled Draw and DrawInstanced also update the culling
+            // statistics and instance buffer, so those two must not run concurrently on the same model.
+            struct DrawItem
+            {
+                const ModelMesh*        mesh;
+                const ModelMeshPart*    part;
+                IEffectMatrices*        matrices;
+                IEffectSkinning*        skinning;
+                size_t                  meshIndex;
+            };
+
+            struct DrawLists;
+
+            mutable std::shared_ptr<const DrawLists> mDrawLists;
+
+            // Dynamic vertex buffer of per-instance transforms for DrawInstanced
+            mutable Microsoft::WRL::ComPtr<ID3D11Buffer> mInstanceBuffer;
+            mutable size_t mInstanceCapacity = 0;
+
+            std::shared_ptr<const DrawLists> __cdecl GetDrawLists() const;
+            std::shared_ptr<const DrawLists> __cdecl BuildDrawLists() const;
+
+            template<typename TSetEffect>
+            void __cdecl DrawParts(
+                _In_ ID3D11DeviceContext* deviceContext,
+                const CommonStates& states,
+                const DrawLists& lists,
+                bool alpha,
+                bool wireframe,
+                _In_opt_ const uint8_t* visible,
+                uint32_t instanceCount,
+                TSetEffect& setEffect,
+                const std::function<void __cdecl()>& setCustomState) const;
+
+            void __cdecl CreateInstanceBuffer(_In_ ID3D11DeviceContext* deviceContext, size_t ninstances) const;
+
+            void XM_CALLCONV DrawInstancedParts(
+                _In_ ID3D11DeviceContext* deviceContext,
+                const CommonStates& states,
+                size_t ninstances,
+                FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection,
+                bool wireframe,
+                const std::function<void __cdecl()>& setCustomState) const;
+
             void __cdecl ComputeAbsolute(uint32_t index,
                 CXMMATRIX local, size_t nbones,
                 _In_reads_(nbones) const XMMATRIX* inBoneTransforms,
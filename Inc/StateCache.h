@@ -0,0 +1,100 @@
+//--------------------------------------------------------------------------------------
+// File: StateCache.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#else
+#include <d3d11_1.h>
+#endif
+
+#include <cstddef>
+#include <memory>
+
+
+namespace DirectX
+{
+    inline namespace DX11
+    {
+        // Shadows the pipeline state of a device context so repeated binds of the same shaders, buffers,
+        // resources, samplers, and state objects can be dropped. While a cache exists for a context, the
+        // built-in effects, SpriteBatch, and Model route their binds through it.
+        //
+        // Anything bound directly on the context bypasses the cache, so call Invalidate after doing so, and
+        // after changing render targets (which can silently unbind shader resources). The cache holds a
+        // reference on whatever it records as bound until it is invalidated or destroyed. Custom state
+        // callbacks passed to the toolkit can bind anything, so the cache is invalidated after each one runs.
+        class StateCache
+        {
+        public:
+            struct Statistics
+            {
+                size_t  calls;      // Binding calls made through the cache
+                size_t  elided;     // Calls dropped because the value was already bound
+            };
+
+            explicit StateCache(_In_ ID3D11DeviceContext* deviceContext);
+
+            StateCache(StateCache&&) = delete;
+            StateCache& operator= (StateCache&&) = delete;
+
+            StateCache(StateCache const&) = delete;
+            StateCache& operator= (StateCache const&) = delete;
+
+            virtual ~StateCache();
+
+            // Forgets all shadowed state, so the next bind of each kind always reaches the context.
+            void __cdecl Invalidate() noexcept;
+
+            Statistics __cdecl GetStatistics() const noexcept;
+            void __cdecl ResetStatistics() noexcept;
+
+            // Shaders. Binds with class instances are always passed through and leave the stage unshadowed.
+            void __cdecl VSSetShader(_In_opt_ ID3D11VertexShader* shader,
+                _In_reads_opt_(numClassInstances) ID3D11ClassInstance* const* classInstances = nullptr, UINT numClassInstances = 0);
+            void __cdecl PSSetShader(_In_opt_ ID3D11PixelShader* shader,
+                _In_reads_opt_(numClassInstances) ID3D11ClassInstance* const* classInstances = nullptr, UINT numClassInstances = 0);
+
+            // Constant buffers
+            void __cdecl VSSetConstantBuffer(UINT slot, _In_opt_ ID3D11Buffer* buffer);
+            void __cdecl PSSetConstantBuffer(UINT slot, _In_opt_ ID3D11Buffer* buffer);
+
+            // Constant buffer ranges in 16-byte constants (requires Direct3D 11.1)
+            void __cdecl VSSetConstantBuffer1(UINT slot, _In_opt_ ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants);
+            void __cdecl PSSetConstantBuffer1(UINT slot, _In_opt_ ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants);
+
+            // Shader resources and samplers
+            void __cdecl PSSetShaderResources(UINT startSlot, UINT count, _In_reads_opt_(count) ID3D11ShaderResourceView* const* views);
+            void __cdecl PSSetSamplers(UINT startSlot, UINT count, _In_reads_opt_(count) ID3D11SamplerState* const* samplers);
+
+            // Input assembler
+            void __cdecl IASetInputLayout(_In_opt_ ID3D11InputLayout* inputLayout);
+            void __cdecl IASetVertexBuffer(UINT slot, _In_opt_ ID3D11Buffer* buffer, UINT stride, UINT offset);
+            void __cdecl IASetIndexBuffer(_In_opt_ ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset);
+            void __cdecl IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+
+            // Fixed-function state objects
+            void __cdecl OMSetBlendState(_In_opt_ ID3D11BlendState* state, _In_opt_ const float blendFactor[4], UINT sampleMask);
+            void __cdecl OMSetDepthStencilState(_In_opt_ ID3D11DepthStencilState* state, UINT stencilRef);
+            void __cdecl RSSetState(_In_opt_ ID3D11RasterizerState* state);
+
+            ID3D11DeviceContext* __cdecl GetDeviceContext() const noexcept;
+
+            // Returns the cache created for a context, or nullptr if there isn't one.
+            static StateCache* __cdecl Get(_In_ ID3D11DeviceContext* deviceContext) noexcept;
+
+        private:
+            // Private implementation.
+            class Impl;
+
+            std::unique_ptr<Impl> pImpl;
+        };
+    }
+}
@@ -0,0 +1,80 @@
+//--------------------------------------------------------------------------------------
+// File: TextureBatchLoader.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#else
+#include <d3d11_1.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <wrl\client.h>
+
+#include "DDSParser.h"
+#include "DDSTextureLoader.h"
+
+
+namespace DirectX
+{
+    inline namespace DX11
+    {
+        // Loads many DDS files at once. Files are read by a pool of I/O threads and handed as they
+        // arrive to a pool of CPU threads, which parse them and create the textures on the device
+        // (resource creation is free-threaded). Results come back in the order the files were given.
+        //
+        // Without a device the loader stops after parsing, which is useful for measuring I/O and
+        // validating content in tools.
+        class TextureBatchLoader
+        {
+        public:
+            struct Result
+            {
+                HRESULT                                             hr;
+                Microsoft::WRL::ComPtr<ID3D11Resource>              texture;
+                Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>    textureView;
+                DDSTextureDesc                                      desc;
+                size_t                                              fileSize;       // Bytes read, before any decompression
+                double                                              readTime;       // Seconds
+                double                                              decompressTime; // Zero unless the file was supercompressed
+                double                                              parseTime;
+                double                                              createTime;
+            };
+
+            // Zero thread counts pick defaults: several I/O threads to keep the drive's queue
+            // full, and one CPU thread per core.
+            explicit TextureBatchLoader(_In_opt_ ID3D11Device* device, size_t ioThreads = 0, size_t cpuThreads = 0);
+
+            TextureBatchLoader(TextureBatchLoader&&) noexcept;
+            TextureBatchLoader& operator= (TextureBatchLoader&&) noexcept;
+
+            TextureBatchLoader(TextureBatchLoader const&) = delete;
+            TextureBatchLoader& operator= (TextureBatchLoader const&) = delete;
+
+            virtual ~TextureBatchLoader();
+
+            // Failures are reported per file in Result::hr rather than thrown.
+            std::vector<Result> __cdecl Load(
+                _In_reads_(count) const wchar_t* const* fileNames,
+                size_t count,
+                DDS_LOADER_FLAGS loadFlags = DDS_LOADER_DEFAULT);
+
+        private:
+            // Private implementation.
+            class Impl;
+
+            std::unique_ptr<Impl> pImpl;
+        };
+    }
+}
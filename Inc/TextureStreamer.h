@@ -0,0 +1,98 @@
+//--------------------------------------------------------------------------------------
+// File: TextureStreamer.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if defined(_XBOX_ONE) && defined(_TITLE)
+#include <d3d11_x.h>
+#else
+#include <d3d11_1.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "DDSTextureLoader.h"
+
+
+namespace DirectX
+{
+    inline namespace DX11
+    {
+        // Streams the mipmaps of DDS textures in and out of video memory. A texture is created
+        // with just its mip tail (the levels no larger than mipTailSize), and more detailed levels
+        // are read on a background thread as the caller raises its priority, most important
+        // first. With a budget set, the top levels of the least important textures are dropped
+        // to keep the resident total under it.
+        //
+        // Direct3D 11 can't release individual mips, so each change of resident levels creates a
+        // new texture and copies the levels it keeps on the GPU. The view returned by GetView
+        // therefore changes from time to time and should be fetched again after each Update.
+        // Only 2D textures, arrays, and cubemaps are streamed; other kinds are loaded whole. Apart
+        // from the background reads, everything happens on the thread calling the methods.
+        class TextureStreamer
+        {
+        public:
+            using Handle = uint32_t;
+
+            struct Statistics
+            {
+                size_t  textures;
+                size_t  residentBytes;
+                size_t  budget;
+                size_t  pendingRequests;    // Reads queued or in flight
+                size_t  completedRequests;  // Reads uploaded since creation
+                size_t  failedRequests;     // Reads that failed and were backed off
+                size_t  evictions;          // Textures shrunk to fit the budget
+                double  averageLatency;     // Seconds from request to upload
+                double  maxLatency;
+            };
+
+            explicit TextureStreamer(_In_ ID3D11Device* device, size_t budget = 0, uint32_t mipTailSize = 128);
+
+            TextureStreamer(TextureStreamer&&) noexcept;
+            TextureStreamer& operator= (TextureStreamer&&) noexcept;
+
+            TextureStreamer(TextureStreamer const&) = delete;
+            TextureStreamer& operator= (TextureStreamer const&) = delete;
+
+            virtual ~TextureStreamer();
+
+            // Maps the file and creates the texture with its mip tail resident.
+            Handle __cdecl Load(_In_z_ const wchar_t* fileName, DDS_LOADER_FLAGS loadFlags = DDS_LOADER_DEFAULT);
+
+            void __cdecl Unload(Handle texture) noexcept;
+
+            // Size in pixels the texture covers on screen (or any measure that falls off with
+            // distance); finer levels than this calls for are not streamed. 0 keeps only the tail.
+            void __cdecl SetPriority(Handle texture, float priority) noexcept;
+
+            // Uploads completed reads, shrinks textures over the budget, and queues new reads.
+            // Call once per frame on the thread that owns the immediate context.
+            void __cdecl Update(_In_ ID3D11DeviceContext* deviceContext);
+
+            ID3D11ShaderResourceView* __cdecl GetView(Handle texture) const noexcept;
+            uint32_t __cdecl GetResidentMip(Handle texture) const noexcept;
+
+            void __cdecl SetBudget(size_t bytes) noexcept;
+            Statistics __cdecl GetStatistics() const noexcept;
+
+        #if defined(_MSC_VER) && !defined(_NATIVE_WCHAR_T_DEFINED)
+            Handle __cdecl Load(_In_z_ const __wchar_t* fileName, DDS_LOADER_FLAGS loadFlags = DDS_LOADER_DEFAULT);
+        #endif
+
+        private:
+            // Private implementation.
+            class Impl;
+
+            std::unique_ptr<Impl> pImpl;
+        };
+    }
+}
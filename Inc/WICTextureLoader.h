@@ -50,6 +50,11 @@ namespace DirectX
             WIC_LOADER_FIT_POW2 = 0x20,
             WIC_LOADER_MAKE_SQUARE = 0x40,
             WIC_LOADER_FORCE_RGBA32 = 0x80,
+            WIC_LOADER_MIP_CPU = 0x100,         // Build the mipmaps on the CPU when GenerateMips can't be used
+            WIC_LOADER_MIP_KAISER = 0x200,      // With WIC_LOADER_MIP_CPU: Kaiser filter rather than box
+            WIC_LOADER_BC_COMPRESS = 0x400,     // Block compress 8-bit images to BC1, BC3, or BC4 (mipmaps built on the CPU)
+            WIC_LOADER_BC_RG = 0x800,           // With WIC_LOADER_BC_COMPRESS: BC5 from red and green, for normal maps
+            WIC_LOADER_BC_QUALITY = 0x1000,     // With WIC_LOADER_BC_COMPRESS: slower, lower error endpoint fitting
         };
     }
 
@@ -139,6 +139,20 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<AlphaTestEffectTraits>::DeviceResources> EffectBase<AlphaTestEffectTraits>::deviceResourcesPool = {};
 
 
+// Queues shader permutations for EffectShaderWarmUp.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::WarmUpAlphaTestEffectShaders(ID3D11Device* device, const uint32_t* permutations, size_t count, std::vector<EffectWarmUpTask>& tasks)
+{
+    return EffectBase<AlphaTestEffectTraits>::WarmUpShaders(device, permutations, count, tasks);
+}
+
+_Use_decl_annotations_
+void DirectX::GetAlphaTestEffectUsedPermutations(ID3D11Device* device, std::vector<uint32_t>& permutations)
+{
+    EffectBase<AlphaTestEffectTraits>::GetUsedPermutations(device, permutations);
+}
+
+
 // Constructor.
 AlphaTestEffect::Impl::Impl(_In_ ID3D11Device* device)
     : EffectBase(device),
@@ -185,6 +199,8 @@ void AlphaTestEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
     assert(deviceContext != nullptr);
 
+    StateFilter filter(deviceContext);
+
     // Compute derived parameter values.
     matrices.SetConstants(dirtyFlags, constants.worldViewProj);
 
@@ -272,7 +288,7 @@ void AlphaTestEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
     }
 
     // Set the texture.
-    deviceContext->PSSetShaderResources(0, 1, texture.GetAddressOf());
+    filter.PSSetShaderResources(0, 1, texture.GetAddressOf());
 
     // Set shaders and constant buffers.
     ApplyShaders(deviceContext, GetCurrentShaderPermutation());
@@ -307,7 +323,7 @@ void AlphaTestEffect::GetVertexShaderBytecode(_Out_ void const** pShaderByteCode
 // Camera settings.
 void XM_CALLCONV AlphaTestEffect::SetWorld(FXMMATRIX value)
 {
-    pImpl->matrices.world = value;
+    pImpl->matrices.SetWorld(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::FogVector;
 }
@@ -315,7 +331,7 @@ void XM_CALLCONV AlphaTestEffect::SetWorld(FXMMATRIX value)
 
 void XM_CALLCONV AlphaTestEffect::SetView(FXMMATRIX value)
 {
-    pImpl->matrices.view = value;
+    pImpl->matrices.SetView(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
 }
@@ -331,8 +347,8 @@ void XM_CALLCONV AlphaTestEffect::SetProjection(FXMMATRIX value)
 
 void XM_CALLCONV AlphaTestEffect::SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection)
 {
-    pImpl->matrices.world = world;
-    pImpl->matrices.view = view;
+    pImpl->matrices.SetWorld(world);
+    pImpl->matrices.SetView(view);
     pImpl->matrices.projection = projection;
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
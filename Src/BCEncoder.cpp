@@ -0,0 +1,617 @@
+//--------------------------------------------------------------------------------------
+// File: BCEncoder.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "BCEncoder.h"
+#include "LoaderHelpers.h"
+#include "ParallelFor.h"
+
+#include <cfloat>
+#include <climits>
+#include <new>
+
+using namespace DirectX;
+using namespace DirectX::LoaderHelpers;
+
+namespace
+{
+    constexpr size_t c_minParallelBlocks = 1024;
+    constexpr int c_refineSteps = 2;
+
+    // Texels of one block in R, G, B, A order
+    using Block = uint8_t[16][4];
+
+    enum SOURCE_ORDER
+    {
+        SOURCE_RGBA,
+        SOURCE_BGRA,
+        SOURCE_BGRX,
+        SOURCE_R,
+    };
+
+    bool GetSourceOrder(DXGI_FORMAT format, SOURCE_ORDER& order) noexcept
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            order = SOURCE_RGBA;
+            return true;
+
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            order = SOURCE_BGRA;
+            return true;
+
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            order = SOURCE_BGRX;
+            return true;
+
+        case DXGI_FORMAT_R8_UNORM:
+            order = SOURCE_R;
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    // Blocks hanging past the edge of small levels repeat the last row and column.
+    void LoadBlock(
+        _In_ const uint8_t* pixels,
+        size_t rowPitch,
+        size_t width,
+        size_t height,
+        size_t bx,
+        size_t by,
+        SOURCE_ORDER order,
+        _Out_ Block& block) noexcept
+    {
+        for (size_t y = 0; y < 4; ++y)
+        {
+            const uint8_t* row = pixels + std::min(by * 4 + y, height - 1) * rowPitch;
+
+            for (size_t x = 0; x < 4; ++x)
+            {
+                const size_t sx = std::min(bx * 4 + x, width - 1);
+                uint8_t* t = block[y * 4 + x];
+
+                switch (order)
+                {
+                case SOURCE_RGBA:
+                    memcpy(t, row + sx * 4, 4);
+                    break;
+
+                case SOURCE_BGRA:
+                case SOURCE_BGRX:
+                    t[0] = row[sx * 4 + 2];
+                    t[1] = row[sx * 4 + 1];
+                    t[2] = row[sx * 4];
+                    t[3] = (order == SOURCE_BGRA) ? row[sx * 4 + 3] : 0xff;
+                    break;
+
+                case SOURCE_R:
+                    t[0] = row[sx];
+                    t[1] = t[2] = 0;
+                    t[3] = 0xff;
+                    break;
+                }
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Color block (BC1, and the color half of BC3), always in 4 color mode
+    //--------------------------------------------------------------------------------------
+    uint16_t Pack565(FXMVECTOR color) noexcept
+    {
+        XMFLOAT3 c;
+        XMStoreFloat3(&c, XMVectorClamp(color, g_XMZero, XMVectorReplicate(255.f)));
+
+        const auto r = static_cast<uint16_t>((c.x * 31.f / 255.f) + 0.5f);
+        const auto g = static_cast<uint16_t>((c.y * 63.f / 255.f) + 0.5f);
+        const auto b = static_cast<uint16_t>((c.z * 31.f / 255.f) + 0.5f);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    XMVECTOR Unpack565(uint16_t c) noexcept
+    {
+        const uint32_t r = (c >> 11) & 0x1f;
+        const uint32_t g = (c >> 5) & 0x3f;
+        const uint32_t b = c & 0x1f;
+        return XMVectorSet(float((r << 3) | (r >> 2)), float((g << 2) | (g >> 4)), float((b << 3) | (b >> 2)), 0.f);
+    }
+
+    // Quantizes the endpoints, orders them for 4 color mode, and picks the nearest palette
+    // entry for each texel. Returns the total squared error.
+    float FitColorIndices(
+        _In_reads_(16) const XMVECTOR* texels,
+        FXMVECTOR e0,
+        FXMVECTOR e1,
+        _Out_ uint16_t& c0,
+        _Out_ uint16_t& c1,
+        _Out_writes_(16) uint8_t* indices) noexcept
+    {
+        c0 = Pack565(e0);
+        c1 = Pack565(e1);
+        if (c0 < c1)
+        {
+            std::swap(c0, c1);
+        }
+
+        if (c0 == c1)
+        {
+            const XMVECTOR p = Unpack565(c0);
+
+            float error = 0.f;
+            for (size_t i = 0; i < 16; ++i)
+            {
+                indices[i] = 0;
+                error += XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(texels[i], p)));
+            }
+            return error;
+        }
+
+        XMVECTOR palette[4];
+        palette[0] = Unpack565(c0);
+        palette[1] = Unpack565(c1);
+        palette[2] = XMVectorLerp(palette[0], palette[1], 1.f / 3.f);
+        palette[3] = XMVectorLerp(palette[0], palette[1], 2.f / 3.f);
+
+        float error = 0.f;
+        for (size_t i = 0; i < 16; ++i)
+        {
+            uint8_t best = 0;
+            float bestError = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(texels[i], palette[0])));
+            for (uint8_t k = 1; k < 4; ++k)
+            {
+                const float e = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(texels[i], palette[k])));
+                if (e < bestError)
+                {
+                    bestError = e;
+                    best = k;
+                }
+            }
+
+            indices[i] = best;
+            error += bestError;
+        }
+
+        return error;
+    }
+
+    // Least squares endpoints for a fixed set of indices.
+    bool RefineColorEndpoints(
+        _In_reads_(16) const XMVECTOR* texels,
+        _In_reads_(16) const uint8_t* indices,
+        _Out_ XMVECTOR& e0,
+        _Out_ XMVECTOR& e1) noexcept
+    {
+        static const float s_weights[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+
+        float a = 0.f;
+        float b = 0.f;
+        float c = 0.f;
+        XMVECTOR x0 = XMVectorZero();
+        XMVECTOR x1 = XMVectorZero();
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            const float w0 = s_weights[indices[i]];
+            const float w1 = 1.f - w0;
+
+            a += w0 * w0;
+            b += w0 * w1;
+            c += w1 * w1;
+            x0 = XMVectorMultiplyAdd(texels[i], XMVectorReplicate(w0), x0);
+            x1 = XMVectorMultiplyAdd(texels[i], XMVectorReplicate(w1), x1);
+        }
+
+        const float det = a * c - b * b;
+        if (std::fabs(det) < 1e-6f)
+            return false;
+
+        const float inv = 1.f / det;
+        e0 = XMVectorScale(XMVectorSubtract(XMVectorScale(x0, c), XMVectorScale(x1, b)), inv);
+        e1 = XMVectorScale(XMVectorSubtract(XMVectorScale(x1, a), XMVectorScale(x0, b)), inv);
+        return true;
+    }
+
+    void EncodeColorBlock(const Block& block, bool quality, _Out_writes_(8) uint8_t* dest) noexcept
+    {
+        XMVECTOR texels[16];
+        XMVECTOR mean = XMVectorZero();
+        XMVECTOR minColor = g_XMFltMax;
+        XMVECTOR maxColor = XMVectorNegate(g_XMFltMax);
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            texels[i] = XMVectorSet(block[i][0], block[i][1], block[i][2], 0.f);
+            mean = XMVectorAdd(mean, texels[i]);
+            minColor = XMVectorMin(minColor, texels[i]);
+            maxColor = XMVectorMax(maxColor, texels[i]);
+        }
+        mean = XMVectorScale(mean, 1.f / 16.f);
+
+        // Principal axis of the colors by power iteration on their covariance
+        XMVECTOR row0 = XMVectorZero();
+        XMVECTOR row1 = XMVectorZero();
+        XMVECTOR row2 = XMVectorZero();
+        for (size_t i = 0; i < 16; ++i)
+        {
+            const XMVECTOR d = XMVectorSubtract(texels[i], mean);
+            row0 = XMVectorMultiplyAdd(d, XMVectorSplatX(d), row0);
+            row1 = XMVectorMultiplyAdd(d, XMVectorSplatY(d), row1);
+            row2 = XMVectorMultiplyAdd(d, XMVectorSplatZ(d), row2);
+        }
+
+        XMVECTOR axis = XMVectorSubtract(maxColor, minColor);
+        const int iterations = quality ? 8 : 3;
+        for (int j = 0; j < iterations; ++j)
+        {
+            XMVECTOR next = XMVectorMultiply(row0, XMVectorSplatX(axis));
+            next = XMVectorMultiplyAdd(row1, XMVectorSplatY(axis), next);
+            next = XMVectorMultiplyAdd(row2, XMVectorSplatZ(axis), next);
+
+            const float length = XMVectorGetX(XMVector3Length(next));
+            if (length < 1e-6f)
+                break;
+
+            axis = XMVectorScale(next, 1.f / length);
+        }
+
+        // Endpoints are the texels furthest along the axis each way
+        size_t lo = 0;
+        size_t hi = 0;
+        float loDot = FLT_MAX;
+        float hiDot = -FLT_MAX;
+        for (size_t i = 0; i < 16; ++i)
+        {
+            const float t = XMVectorGetX(XMVector3Dot(XMVectorSubtract(texels[i], mean), axis));
+            if (t < loDot)
+            {
+                loDot = t;
+                lo = i;
+            }
+            if (t > hiDot)
+            {
+                hiDot = t;
+                hi = i;
+            }
+        }
+
+        uint16_t c0, c1;
+        uint8_t indices[16];
+        float error = FitColorIndices(texels, texels[hi], texels[lo], c0, c1, indices);
+
+        if (quality)
+        {
+            for (int step = 0; step < c_refineSteps && error > 0.f; ++step)
+            {
+                XMVECTOR e0, e1;
+                if (!RefineColorEndpoints(texels, indices, e0, e1))
+                    break;
+
+                uint16_t r0, r1;
+                uint8_t refined[16];
+                const float refinedError = FitColorIndices(texels, e0, e1, r0, r1, refined);
+                if (refinedError >= error)
+                    break;
+
+                error = refinedError;
+                c0 = r0;
+                c1 = r1;
+                memcpy(indices, refined, sizeof(indices));
+            }
+        }
+
+        uint32_t bits = 0;
+        for (size_t i = 0; i < 16; ++i)
+        {
+            bits |= uint32_t(indices[i]) << (i * 2);
+        }
+
+        dest[0] = static_cast<uint8_t>(c0 & 0xff);
+        dest[1] = static_cast<uint8_t>(c0 >> 8);
+        dest[2] = static_cast<uint8_t>(c1 & 0xff);
+        dest[3] = static_cast<uint8_t>(c1 >> 8);
+        memcpy(dest + 4, &bits, sizeof(bits));
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Single channel block (BC4, each half of BC5, and the alpha half of BC3)
+    //--------------------------------------------------------------------------------------
+    uint32_t FitChannelIndices(
+        _In_reads_(16) const uint8_t* values,
+        uint8_t a0,
+        uint8_t a1,
+        _Out_writes_(16) uint8_t* indices) noexcept
+    {
+        int palette[8] = { a0, a1 };
+        if (a0 > a1)
+        {
+            for (int k = 1; k < 7; ++k)
+            {
+                palette[k + 1] = ((7 - k) * a0 + k * a1 + 3) / 7;
+            }
+        }
+        else
+        {
+            for (int k = 1; k < 5; ++k)
+            {
+                palette[k + 1] = ((5 - k) * a0 + k * a1 + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint32_t error = 0;
+        for (size_t i = 0; i < 16; ++i)
+        {
+            uint8_t best = 0;
+            int bestError = INT_MAX;
+            for (uint8_t k = 0; k < 8; ++k)
+            {
+                const int d = int(values[i]) - palette[k];
+                if (d * d < bestError)
+                {
+                    bestError = d * d;
+                    best = k;
+                }
+            }
+
+            indices[i] = best;
+            error += uint32_t(bestError);
+        }
+
+        return error;
+    }
+
+    void EncodeChannelBlock(const Block& block, size_t channel, bool quality, _Out_writes_(8) uint8_t* dest) noexcept
+    {
+        uint8_t values[16];
+        uint8_t minValue = 255;
+        uint8_t maxValue = 0;
+        for (size_t i = 0; i < 16; ++i)
+        {
+            values[i] = block[i][channel];
+            minValue = std::min(minValue, values[i]);
+            maxValue = std::max(maxValue, values[i]);
+        }
+
+        uint8_t a0 = maxValue;
+        uint8_t a1 = minValue;
+        uint8_t indices[16] = {};
+
+        if (a0 != a1)
+        {
+            uint32_t error = FitChannelIndices(values, a0, a1, indices);
+
+            if (quality && error > 0)
+            {
+                // 6 value mode spends its range on the values between the exact 0 and 255
+                uint8_t lo = 255;
+                uint8_t hi = 0;
+                for (size_t i = 0; i < 16; ++i)
+                {
+                    if (values[i] != 0 && values[i] != 255)
+                    {
+                        lo = std::min(lo, values[i]);
+                        hi = std::max(hi, values[i]);
+                    }
+                }
+
+                if (lo > hi)
+                {
+                    lo = hi = 0;
+                }
+
+                uint8_t alternate[16];
+                const uint32_t alternateError = FitChannelIndices(values, lo, hi, alternate);
+                if (alternateError < error)
+                {
+                    a0 = lo;
+                    a1 = hi;
+                    memcpy(indices, alternate, sizeof(indices));
+                }
+            }
+        }
+
+        uint64_t bits = 0;
+        for (size_t i = 0; i < 16; ++i)
+        {
+            bits |= uint64_t(indices[i]) << (i * 3);
+        }
+
+        dest[0] = a0;
+        dest[1] = a1;
+        for (size_t i = 0; i < 6; ++i)
+        {
+            dest[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    size_t GetBlockSize(DXGI_FORMAT bcFormat) noexcept
+    {
+        switch (bcFormat)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_UNORM:
+            return 8;
+
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC5_UNORM:
+            return 16;
+
+        default:
+            return 0;
+        }
+    }
+
+    void EncodeBlock(const Block& block, DXGI_FORMAT bcFormat, bool quality, _Out_ uint8_t* dest) noexcept
+    {
+        switch (bcFormat)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            EncodeColorBlock(block, quality, dest);
+            break;
+
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            EncodeChannelBlock(block, 3, quality, dest);
+            EncodeColorBlock(block, quality, dest + 8);
+            break;
+
+        case DXGI_FORMAT_BC4_UNORM:
+            EncodeChannelBlock(block, 0, quality, dest);
+            break;
+
+        case DXGI_FORMAT_BC5_UNORM:
+            EncodeChannelBlock(block, 0, quality, dest);
+            EncodeChannelBlock(block, 1, quality, dest + 8);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+DXGI_FORMAT DirectX::GetBCFormat(
+    const uint8_t* pixels,
+    size_t rowPitch,
+    size_t width,
+    size_t height,
+    DXGI_FORMAT format,
+    bool twoChannel) noexcept
+{
+    SOURCE_ORDER order;
+    if (!pixels || !GetSourceOrder(format, order))
+        return DXGI_FORMAT_UNKNOWN;
+
+    if (order == SOURCE_R)
+        return DXGI_FORMAT_BC4_UNORM;
+
+    if (twoChannel)
+        return DXGI_FORMAT_BC5_UNORM;
+
+    const bool srgb = (MakeLinear(format) != format);
+
+    if (order == SOURCE_RGBA || order == SOURCE_BGRA)
+    {
+        for (size_t y = 0; y < height; ++y)
+        {
+            const uint8_t* row = pixels + y * rowPitch;
+            for (size_t x = 0; x < width; ++x)
+            {
+                if (row[x * 4 + 3] != 0xff)
+                    return srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+            }
+        }
+    }
+
+    return srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::CompressMipChain(
+    const D3D11_SUBRESOURCE_DATA* levels,
+    size_t mipLevels,
+    size_t width,
+    size_t height,
+    DXGI_FORMAT format,
+    DXGI_FORMAT bcFormat,
+    bool quality,
+    std::unique_ptr<uint8_t[]>& bcData,
+    D3D11_SUBRESOURCE_DATA* initData) noexcept
+{
+    bcData.reset();
+
+    if (!levels || !initData)
+        return E_POINTER;
+
+    if (!width || !height || !mipLevels)
+        return E_INVALIDARG;
+
+    SOURCE_ORDER order;
+    const size_t blockSize = GetBlockSize(bcFormat);
+    if (!GetSourceOrder(format, order) || !blockSize)
+        return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+    uint64_t totalBytes = 0;
+    for (size_t level = 0; level < mipLevels; ++level)
+    {
+        const uint64_t blocksWide = std::max<uint64_t>(1u, ((width >> level) + 3u) / 4u);
+        const uint64_t blocksHigh = std::max<uint64_t>(1u, ((height >> level) + 3u) / 4u);
+        totalBytes += blocksWide * blocksHigh * blockSize;
+    }
+
+    if (totalBytes > UINT32_MAX)
+        return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+
+    bcData.reset(new (std::nothrow) uint8_t[static_cast<size_t>(totalBytes)]);
+    if (!bcData)
+        return E_OUTOFMEMORY;
+
+    try
+    {
+        uint8_t* dest = bcData.get();
+
+        for (size_t level = 0; level < mipLevels; ++level)
+        {
+            const size_t w = std::max<size_t>(1u, width >> level);
+            const size_t h = std::max<size_t>(1u, height >> level);
+            const size_t blocksWide = std::max<size_t>(1u, (w + 3u) / 4u);
+            const size_t blocksHigh = std::max<size_t>(1u, (h + 3u) / 4u);
+            const size_t pitch = blocksWide * blockSize;
+
+            auto src = static_cast<const uint8_t*>(levels[level].pSysMem);
+            const size_t srcPitch = levels[level].SysMemPitch;
+
+            ParallelFor(blocksHigh, [&](size_t by)
+                {
+                    uint8_t* row = dest + by * pitch;
+                    for (size_t bx = 0; bx < blocksWide; ++bx)
+                    {
+                        Block block;
+                        LoadBlock(src, srcPitch, w, h, bx, by, order, block);
+                        EncodeBlock(block, bcFormat, quality, row + bx * blockSize);
+                    }
+                }, (blocksWide * blocksHigh < c_minParallelBlocks) ? 1u : 0u);
+
+            initData[level].pSysMem = dest;
+            initData[level].SysMemPitch = static_cast<UINT>(pitch);
+            initData[level].SysMemSlicePitch = static_cast<UINT>(pitch * blocksHigh);
+
+            dest += pitch * blocksHigh;
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+        bcData.reset();
+        return E_OUTOFMEMORY;
+    }
+    catch (...)
+    {
+        bcData.reset();
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
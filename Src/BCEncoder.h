@@ -0,0 +1,49 @@
+//--------------------------------------------------------------------------------------
+// File: BCEncoder.h
+//
+// Helper for block compressing 8-bit images at load time (BC1, BC3, BC4, and BC5)
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+namespace DirectX
+{
+    // Picks the block format for an R8G8B8A8, B8G8R8A8, B8G8R8X8, or R8 image: BC1 when every
+    // texel is opaque, BC3 otherwise, BC4 for single channel, and BC5 from red and green when
+    // twoChannel is set (normal maps). The sRGB forms map to the sRGB block formats. Returns
+    // DXGI_FORMAT_UNKNOWN for anything else.
+    DXGI_FORMAT GetBCFormat(
+        _In_ const uint8_t* pixels,
+        size_t rowPitch,
+        size_t width,
+        size_t height,
+        DXGI_FORMAT format,
+        bool twoChannel) noexcept;
+
+    // Compresses each level of a mip chain, spreading the block rows of every level across
+    // threads. Endpoints come from the principal axis of each block's colors; with quality
+    // set they are refined by least squares and alpha also tries the 6 value mode, at
+    // roughly three times the cost.
+    //
+    // initData receives mipLevels entries pointing into bcData.
+    HRESULT CompressMipChain(
+        _In_reads_(mipLevels) const D3D11_SUBRESOURCE_DATA* levels,
+        size_t mipLevels,
+        size_t width,
+        size_t height,
+        DXGI_FORMAT format,
+        DXGI_FORMAT bcFormat,
+        bool quality,
+        std::unique_ptr<uint8_t[]>& bcData,
+        _Out_writes_(mipLevels) D3D11_SUBRESOURCE_DATA* initData) noexcept;
+}
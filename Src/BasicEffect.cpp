@@ -383,6 +383,20 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<BasicEffectTraits>::DeviceResources> EffectBase<BasicEffectTraits>::deviceResourcesPool = {};
 
 
+// Queues shader permutations for EffectShaderWarmUp.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::WarmUpBasicEffectShaders(ID3D11Device* device, const uint32_t* permutations, size_t count, std::vector<EffectWarmUpTask>& tasks)
+{
+    return EffectBase<BasicEffectTraits>::WarmUpShaders(device, permutations, count, tasks);
+}
+
+_Use_decl_annotations_
+void DirectX::GetBasicEffectUsedPermutations(ID3D11Device* device, std::vector<uint32_t>& permutations)
+{
+    EffectBase<BasicEffectTraits>::GetUsedPermutations(device, permutations);
+}
+
+
 // Constructor.
 BasicEffect::Impl::Impl(_In_ ID3D11Device* device)
     : EffectBase(device),
@@ -457,6 +471,8 @@ void BasicEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
     assert(deviceContext != nullptr);
 
+    StateFilter filter(deviceContext);
+
     // Compute derived parameter values.
     matrices.SetConstants(dirtyFlags, constants.worldViewProj);
 
@@ -467,7 +483,7 @@ void BasicEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
     // Set the texture.
     if (textureEnabled)
     {
-        deviceContext->PSSetShaderResources(0, 1, texture.GetAddressOf());
+        filter.PSSetShaderResources(0, 1, texture.GetAddressOf());
     }
 
     // Set shaders and constant buffers.
@@ -503,7 +519,7 @@ void BasicEffect::GetVertexShaderBytecode(_Out_ void const** pShaderByteCode, _O
 // Camera settings.
 void XM_CALLCONV BasicEffect::SetWorld(FXMMATRIX value)
 {
-    pImpl->matrices.world = value;
+    pImpl->matrices.SetWorld(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::FogVector;
 }
@@ -511,7 +527,7 @@ void XM_CALLCONV BasicEffect::SetWorld(FXMMATRIX value)
 
 void XM_CALLCONV BasicEffect::SetView(FXMMATRIX value)
 {
-    pImpl->matrices.view = value;
+    pImpl->matrices.SetView(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
 }
@@ -527,14 +543,30 @@ void XM_CALLCONV BasicEffect::SetProjection(FXMMATRIX value)
 
 void XM_CALLCONV BasicEffect::SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection)
 {
-    pImpl->matrices.world = world;
-    pImpl->matrices.view = view;
+    pImpl->matrices.SetWorld(world);
+    pImpl->matrices.SetView(view);
     pImpl->matrices.projection = projection;
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
 }
 
 
+void BasicEffect::SetCamera(const EffectCamera& camera)
+{
+    pImpl->matrices.SetCamera(camera);
+
+    pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
+}
+
+
+void BasicEffect::SetWorldTransform(const EffectWorldTransform& transform)
+{
+    pImpl->matrices.SetWorldTransform(transform);
+
+    pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::FogVector;
+}
+
+
 // Material settings.
 void XM_CALLCONV BasicEffect::SetDiffuseColor(FXMVECTOR value)
 {
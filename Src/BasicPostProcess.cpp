@@ -16,6 +16,7 @@
 #include "AlignedNew.h"
 #include "DemandCreate.h"
 #include "SharedResourcePool.h"
+#include "StateFilter.h"
 
 using namespace DirectX;
 
@@ -139,8 +140,8 @@ namespace
 
     protected:
         ComPtr<ID3D11Device>        mDevice;
-        ComPtr<ID3D11VertexShader>  mVertexShader;
-        ComPtr<ID3D11PixelShader>   mPixelShaders[BasicPostProcess::Effect_Max];
+        AtomicComPtr<ID3D11VertexShader>  mVertexShader;
+        AtomicComPtr<ID3D11PixelShader>   mPixelShaders[BasicPostProcess::Effect_Max];
         std::mutex                  mMutex;
     };
 }
@@ -221,24 +222,26 @@ void BasicPostProcess::Impl::Process(
     _In_ ID3D11DeviceContext* deviceContext,
     const std::function<void __cdecl()>& setCustomState)
 {
+    StateFilter filter(deviceContext);
+
     // Set the texture.
     ID3D11ShaderResourceView* textures[1] = { texture.Get() };
-    deviceContext->PSSetShaderResources(0, 1, textures);
+    filter.PSSetShaderResources(0, 1, textures);
 
     auto sampler = mDeviceResources->stateObjects.LinearClamp();
-    deviceContext->PSSetSamplers(0, 1, &sampler);
+    filter.PSSetSamplers(0, 1, &sampler);
 
     // Set state objects.
-    deviceContext->OMSetBlendState(mDeviceResources->stateObjects.Opaque(), nullptr, 0xffffffff);
-    deviceContext->OMSetDepthStencilState(mDeviceResources->stateObjects.DepthNone(), 0);
-    deviceContext->RSSetState(mDeviceResources->stateObjects.CullNone());
+    filter.OMSetBlendState(mDeviceResources->stateObjects.Opaque(), nullptr, 0xffffffff);
+    filter.OMSetDepthStencilState(mDeviceResources->stateObjects.DepthNone(), 0);
+    filter.RSSetState(mDeviceResources->stateObjects.CullNone());
 
     // Set shaders.
     auto vertexShader = mDeviceResources->GetVertexShader();
     auto pixelShader = mDeviceResources->GetPixelShader(fx);
 
-    deviceContext->VSSetShader(vertexShader, nullptr, 0);
-    deviceContext->PSSetShader(pixelShader, nullptr, 0);
+    filter.VSSetShader(vertexShader, nullptr, 0);
+    filter.PSSetShader(pixelShader, nullptr, 0);
 
     // Set constants.
     if (mUseConstants)
@@ -295,18 +298,19 @@ void BasicPostProcess::Impl::Process(
         // Set the constant buffer.
         auto buffer = mConstantBuffer.GetBuffer();
 
-        deviceContext->PSSetConstantBuffers(0, 1, &buffer);
+        filter.PSSetConstantBuffers(0, 1, &buffer);
     #endif
     }
 
     if (setCustomState)
     {
         setCustomState();
+        filter.Invalidate();
     }
 
     // Draw quad.
-    deviceContext->IASetInputLayout(nullptr);
-    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    filter.IASetInputLayout(nullptr);
+    filter.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
     deviceContext->Draw(3, 0);
 }
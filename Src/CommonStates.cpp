@@ -34,28 +34,28 @@ public:
 
     ComPtr<ID3D11Device> mDevice;
 
-    ComPtr<ID3D11BlendState> opaque;
-    ComPtr<ID3D11BlendState> alphaBlend;
-    ComPtr<ID3D11BlendState> additive;
-    ComPtr<ID3D11BlendState> nonPremultiplied;
-
-    ComPtr<ID3D11DepthStencilState> depthNone;
-    ComPtr<ID3D11DepthStencilState> depthDefault;
-    ComPtr<ID3D11DepthStencilState> depthRead;
-    ComPtr<ID3D11DepthStencilState> depthReverseZ;
-    ComPtr<ID3D11DepthStencilState> depthReadReverseZ;
-
-    ComPtr<ID3D11RasterizerState> cullNone;
-    ComPtr<ID3D11RasterizerState> cullClockwise;
-    ComPtr<ID3D11RasterizerState> cullCounterClockwise;
-    ComPtr<ID3D11RasterizerState> wireframe;
-
-    ComPtr<ID3D11SamplerState> pointWrap;
-    ComPtr<ID3D11SamplerState> pointClamp;
-    ComPtr<ID3D11SamplerState> linearWrap;
-    ComPtr<ID3D11SamplerState> linearClamp;
-    ComPtr<ID3D11SamplerState> anisotropicWrap;
-    ComPtr<ID3D11SamplerState> anisotropicClamp;
+    AtomicComPtr<ID3D11BlendState> opaque;
+    AtomicComPtr<ID3D11BlendState> alphaBlend;
+    AtomicComPtr<ID3D11BlendState> additive;
+    AtomicComPtr<ID3D11BlendState> nonPremultiplied;
+
+    AtomicComPtr<ID3D11DepthStencilState> depthNone;
+    AtomicComPtr<ID3D11DepthStencilState> depthDefault;
+    AtomicComPtr<ID3D11DepthStencilState> depthRead;
+    AtomicComPtr<ID3D11DepthStencilState> depthReverseZ;
+    AtomicComPtr<ID3D11DepthStencilState> depthReadReverseZ;
+
+    AtomicComPtr<ID3D11RasterizerState> cullNone;
+    AtomicComPtr<ID3D11RasterizerState> cullClockwise;
+    AtomicComPtr<ID3D11RasterizerState> cullCounterClockwise;
+    AtomicComPtr<ID3D11RasterizerState> wireframe;
+
+    AtomicComPtr<ID3D11SamplerState> pointWrap;
+    AtomicComPtr<ID3D11SamplerState> pointClamp;
+    AtomicComPtr<ID3D11SamplerState> linearWrap;
+    AtomicComPtr<ID3D11SamplerState> linearClamp;
+    AtomicComPtr<ID3D11SamplerState> anisotropicWrap;
+    AtomicComPtr<ID3D11SamplerState> anisotropicClamp;
 
     std::mutex mutex;
 
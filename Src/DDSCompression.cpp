@@ -0,0 +1,522 @@
+//--------------------------------------------------------------------------------------
+// File: DDSCompression.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "DDSCompression.h"
+
+#include "DDS.h"
+#include "DDSParser.h"
+#include "ParallelFor.h"
+#include "PlatformHelpers.h"
+
+#include <new>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr size_t c_minMatch = 4;
+    constexpr size_t c_lastLiterals = 5;        // The block always ends with this many literals
+    constexpr size_t c_matchSearchLimit = 12;   // No match starts in the last 12 bytes
+    constexpr size_t c_maxOffset = 65535;
+    constexpr size_t c_maxInputSize = 0x7E000000;
+
+    constexpr unsigned int c_hashBits = 16;
+
+    constexpr size_t c_maxChunkSize = 256 * 1024;
+
+    // Below this much image data the chunks are decoded on the calling thread
+    constexpr size_t c_minParallelBytes = 512 * 1024;
+
+    inline uint32_t Read32(const uint8_t* p) noexcept
+    {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t Hash(uint32_t sequence) noexcept
+    {
+        return (sequence * 2654435761u) >> (32 - c_hashBits);
+    }
+
+    size_t LengthBytes(size_t length) noexcept
+    {
+        return (length >= 15) ? ((length - 15) / 255 + 1) : 0;
+    }
+
+    uint8_t* WriteLength(uint8_t* op, size_t length) noexcept
+    {
+        length -= 15;
+        while (length >= 255)
+        {
+            *op++ = 255;
+            length -= 255;
+        }
+        *op++ = static_cast<uint8_t>(length);
+        return op;
+    }
+
+    // matchLength of 0 writes the final, literal-only sequence
+    bool WriteSequence(
+        uint8_t*& op,
+        const uint8_t* oend,
+        _In_reads_(literalLength) const uint8_t* literals,
+        size_t literalLength,
+        size_t offset,
+        size_t matchLength) noexcept
+    {
+        size_t required = 1 + LengthBytes(literalLength) + literalLength;
+        if (matchLength)
+        {
+            required += 2 + LengthBytes(matchLength - c_minMatch);
+        }
+
+        if (size_t(oend - op) < required)
+            return false;
+
+        uint8_t* token = op++;
+        *token = static_cast<uint8_t>(std::min<size_t>(literalLength, 15) << 4);
+        if (literalLength >= 15)
+        {
+            op = WriteLength(op, literalLength);
+        }
+
+        memcpy(op, literals, literalLength);
+        op += literalLength;
+
+        if (matchLength)
+        {
+            *op++ = static_cast<uint8_t>(offset & 0xff);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+
+            const size_t length = matchLength - c_minMatch;
+            *token |= static_cast<uint8_t>(std::min<size_t>(length, 15));
+            if (length >= 15)
+            {
+                op = WriteLength(op, length);
+            }
+        }
+
+        return true;
+    }
+
+    bool ReadLength(const uint8_t*& ip, const uint8_t* iend, size_t& length) noexcept
+    {
+        uint8_t b;
+        do
+        {
+            if (ip >= iend)
+                return false;
+
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+
+        return true;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// LZ4 block codec
+//--------------------------------------------------------------------------------------
+size_t DirectX::LZCompressBound(size_t srcSize) noexcept
+{
+    return (srcSize > c_maxInputSize) ? 0 : (srcSize + srcSize / 255 + 16);
+}
+
+_Use_decl_annotations_
+size_t DirectX::LZCompress(
+    const uint8_t* src,
+    size_t srcSize,
+    uint8_t* dest,
+    size_t destSize) noexcept
+{
+    if (!src || !dest || srcSize > c_maxInputSize)
+        return 0;
+
+    uint8_t* op = dest;
+    const uint8_t* oend = dest + destSize;
+
+    size_t anchor = 0;
+
+    if (srcSize > c_matchSearchLimit)
+    {
+        std::unique_ptr<uint32_t[]> table(new (std::nothrow) uint32_t[size_t(1) << c_hashBits]);
+        if (!table)
+            return 0;
+
+        memset(table.get(), 0, sizeof(uint32_t) << c_hashBits);
+
+        const size_t searchEnd = srcSize - c_matchSearchLimit;
+        const size_t matchEnd = srcSize - c_lastLiterals;
+
+        size_t ip = 0;
+        while (ip < searchEnd)
+        {
+            const uint32_t sequence = Read32(src + ip);
+            const uint32_t h = Hash(sequence);
+            size_t candidate = table[h];
+            table[h] = static_cast<uint32_t>(ip);
+
+            if (candidate >= ip || (ip - candidate) > c_maxOffset || Read32(src + candidate) != sequence)
+            {
+                // Step faster through data that isn't matching
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            size_t start = ip;
+            while (start > anchor && candidate > 0 && src[start - 1] == src[candidate - 1])
+            {
+                --start;
+                --candidate;
+            }
+
+            size_t length = c_minMatch + (ip - start);
+            while (start + length < matchEnd && src[candidate + length] == src[start + length])
+            {
+                ++length;
+            }
+
+            if (!WriteSequence(op, oend, src + anchor, start - anchor, start - candidate, length))
+                return 0;
+
+            ip = start + length;
+            anchor = ip;
+
+            if (ip - 2 < searchEnd)
+            {
+                table[Hash(Read32(src + ip - 2))] = static_cast<uint32_t>(ip - 2);
+            }
+        }
+    }
+
+    if (!WriteSequence(op, oend, src + anchor, srcSize - anchor, 0, 0))
+        return 0;
+
+    return static_cast<size_t>(op - dest);
+}
+
+_Use_decl_annotations_
+bool DirectX::LZDecompress(
+    const uint8_t* src,
+    size_t srcSize,
+    uint8_t* dest,
+    size_t destSize) noexcept
+{
+    if (!src || !dest || !srcSize)
+        return false;
+
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + srcSize;
+    uint8_t* op = dest;
+    const uint8_t* oend = dest + destSize;
+
+    for (;;)
+    {
+        const uint8_t token = *ip++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !ReadLength(ip, iend, literalLength))
+            return false;
+
+        if (literalLength > size_t(iend - ip) || literalLength > size_t(oend - op))
+            return false;
+
+        memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        if (ip == iend)
+            return op == oend;
+
+        if (iend - ip < 3)
+            return false;
+
+        const size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+        ip += 2;
+
+        if (!offset || offset > size_t(op - dest))
+            return false;
+
+        size_t matchLength = token & 0xf;
+        if (matchLength == 15 && !ReadLength(ip, iend, matchLength))
+            return false;
+
+        matchLength += c_minMatch;
+        if (matchLength > size_t(oend - op))
+            return false;
+
+        const uint8_t* match = op - offset;
+        if (offset >= matchLength)
+        {
+            memcpy(op, match, matchLength);
+            op += matchLength;
+        }
+        else
+        {
+            // Overlapping copy repeats the pattern; each pass doubles the span copied
+            while (matchLength > 0)
+            {
+                const size_t count = std::min(static_cast<size_t>(op - match), matchLength);
+                memcpy(op, match, count);
+                op += count;
+                matchLength -= count;
+            }
+        }
+
+        if (ip >= iend)
+            return false;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Container
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::DecompressDDS(
+    const uint8_t* data,
+    size_t dataSize,
+    std::unique_ptr<uint8_t[]>& ddsData,
+    size_t& ddsDataSize) noexcept
+{
+    ddsData.reset();
+    ddsDataSize = 0;
+
+    if (!data)
+        return E_POINTER;
+
+    if (dataSize > UINT32_MAX || dataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
+        return E_FAIL;
+
+    if (!IsCompressedDDS(data, dataSize))
+        return E_FAIL;
+
+    auto hdr = reinterpret_cast<const DDS_HEADER*>(data + sizeof(uint32_t));
+    if (hdr->size != sizeof(DDS_HEADER) ||
+        hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
+    {
+        return E_FAIL;
+    }
+
+    size_t headerSize = sizeof(uint32_t) + sizeof(DDS_HEADER);
+    if ((hdr->ddspf.flags & DDS_FOURCC) &&
+        (MAKEFOURCC('D', 'X', '1', '0') == hdr->ddspf.fourCC))
+    {
+        headerSize += sizeof(DDS_HEADER_DXT10);
+    }
+
+    if (dataSize < headerSize + sizeof(DDSZ_HEADER))
+        return E_FAIL;
+
+    auto zhdr = reinterpret_cast<const DDSZ_HEADER*>(data + headerSize);
+    if (zhdr->version != DDSZ_VERSION)
+    {
+        DebugTrace("ERROR: DDSZ version %u is not supported\n", zhdr->version);
+        return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+    }
+
+    const size_t tableOffset = headerSize + sizeof(DDSZ_HEADER);
+    const uint64_t payloadOffset = tableOffset + uint64_t(zhdr->chunkCount) * sizeof(DDSZ_CHUNK);
+    if (payloadOffset > dataSize)
+        return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+
+    const uint64_t outputSize = uint64_t(headerSize) + zhdr->bitSize;
+    if (outputSize > UINT32_MAX)
+        return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+
+    auto chunks = reinterpret_cast<const DDSZ_CHUNK*>(data + tableOffset);
+    const size_t chunkCount = zhdr->chunkCount;
+
+    // Chunks are located by their running totals, checked here before any decoding starts
+    std::unique_ptr<size_t[]> offsets(new (std::nothrow) size_t[chunkCount * 2 + 1]);
+    if (!offsets)
+        return E_OUTOFMEMORY;
+
+    uint64_t rawTotal = 0;
+    uint64_t packedTotal = 0;
+    for (size_t j = 0; j < chunkCount; ++j)
+    {
+        if (!chunks[j].size || !chunks[j].packedSize || chunks[j].packedSize > chunks[j].size)
+            return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+        offsets[j * 2] = static_cast<size_t>(rawTotal);
+        offsets[j * 2 + 1] = static_cast<size_t>(packedTotal);
+        rawTotal += chunks[j].size;
+        packedTotal += chunks[j].packedSize;
+    }
+
+    if (rawTotal != zhdr->bitSize || payloadOffset + packedTotal > dataSize)
+        return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+    ddsData.reset(new (std::nothrow) uint8_t[static_cast<size_t>(outputSize)]);
+    if (!ddsData)
+        return E_OUTOFMEMORY;
+
+    memcpy(ddsData.get(), data, headerSize);
+    *reinterpret_cast<uint32_t*>(ddsData.get()) = DDS_MAGIC;
+
+    uint8_t* bitData = ddsData.get() + headerSize;
+    const uint8_t* payload = data + payloadOffset;
+
+    std::atomic<bool> corrupt(false);
+
+    try
+    {
+        ParallelFor(chunkCount, [&](size_t j)
+            {
+                uint8_t* dest = bitData + offsets[j * 2];
+                const uint8_t* src = payload + offsets[j * 2 + 1];
+
+                if (chunks[j].packedSize == chunks[j].size)
+                {
+                    memcpy(dest, src, chunks[j].size);
+                }
+                else if (!LZDecompress(src, chunks[j].packedSize, dest, chunks[j].size))
+                {
+                    corrupt.store(true, std::memory_order_relaxed);
+                }
+            }, (zhdr->bitSize < c_minParallelBytes) ? 1u : 0u);
+    }
+    catch (const std::bad_alloc&)
+    {
+        ddsData.reset();
+        return E_OUTOFMEMORY;
+    }
+    catch (...)
+    {
+        ddsData.reset();
+        return E_FAIL;
+    }
+
+    if (corrupt)
+    {
+        DebugTrace("ERROR: DDSZ chunk data is corrupt\n");
+        ddsData.reset();
+        return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+    }
+
+    ddsDataSize = static_cast<size_t>(outputSize);
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CompressDDS(
+    const uint8_t* ddsData,
+    size_t ddsDataSize,
+    std::vector<uint8_t>& blob) noexcept
+{
+    blob.clear();
+
+    DDSTextureDesc desc = {};
+    HRESULT hr = ParseDDS(ddsData, ddsDataSize, &desc);
+    if (FAILED(hr))
+        return hr;
+
+    try
+    {
+        std::vector<DDSSubresource> subresources(desc.subresourceCount);
+        hr = ParseDDS(ddsData, ddsDataSize, &desc, subresources.data(), subresources.size());
+        if (FAILED(hr))
+            return hr;
+
+        const size_t bitSize = ddsDataSize - desc.dataOffset;
+        if (bitSize > UINT32_MAX)
+        {
+            DebugTrace("ERROR: Image data too large for DDSZ (%zu bytes)\n", bitSize);
+            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+        }
+
+        // Cut at every subresource, then split large ones so the top mips decode in parallel too
+        std::vector<size_t> starts;
+        for (const auto& it : subresources)
+        {
+            starts.push_back(it.offset - desc.dataOffset);
+        }
+        starts.push_back(bitSize);
+        std::sort(starts.begin(), starts.end());
+        starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+
+        std::vector<DDSZ_CHUNK> chunks;
+        std::vector<size_t> rawOffsets;
+        size_t begin = 0;
+        for (const size_t end : starts)
+        {
+            while (begin < end)
+            {
+                const size_t size = std::min(end - begin, c_maxChunkSize);
+                rawOffsets.push_back(begin);
+                chunks.push_back({ static_cast<uint32_t>(size), 0 });
+                begin += size;
+            }
+        }
+
+        const uint8_t* bitData = ddsData + desc.dataOffset;
+
+        std::vector<std::vector<uint8_t>> packed(chunks.size());
+        ParallelFor(chunks.size(), [&](size_t j)
+            {
+                const uint8_t* src = bitData + rawOffsets[j];
+                const size_t size = chunks[j].size;
+
+                packed[j].resize(LZCompressBound(size));
+                size_t packedSize = LZCompress(src, size, packed[j].data(), packed[j].size());
+                if (!packedSize || packedSize >= size)
+                {
+                    packed[j].assign(src, src + size);
+                    packedSize = size;
+                }
+
+                packed[j].resize(packedSize);
+                chunks[j].packedSize = static_cast<uint32_t>(packedSize);
+            });
+
+        DDSZ_HEADER zhdr = {};
+        zhdr.version = DDSZ_VERSION;
+        zhdr.chunkCount = static_cast<uint32_t>(chunks.size());
+        zhdr.bitSize = static_cast<uint32_t>(bitSize);
+
+        auto append = [&](const void* p, size_t size)
+            {
+                auto bytes = static_cast<const uint8_t*>(p);
+                blob.insert(blob.end(), bytes, bytes + size);
+            };
+
+        append(ddsData, desc.dataOffset);
+        *reinterpret_cast<uint32_t*>(blob.data()) = DDSZ_MAGIC;
+        append(&zhdr, sizeof(zhdr));
+        append(chunks.data(), chunks.size() * sizeof(DDSZ_CHUNK));
+        for (const auto& it : packed)
+        {
+            append(it.data(), it.size());
+        }
+
+        if (blob.size() > UINT32_MAX)
+        {
+            blob.clear();
+            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+        blob.clear();
+        return E_OUTOFMEMORY;
+    }
+    catch (...)
+    {
+        blob.clear();
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
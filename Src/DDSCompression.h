@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------------------
+// File: DDSCompression.h
+//
+// Supercompressed DDS container: the usual DDS headers followed by the image data split
+// into independently LZ4-compressed chunks, so loads read fewer bytes from disk and
+// decompress the chunks in parallel straight into the buffer the texture is created from.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+namespace DirectX
+{
+    constexpr uint32_t DDSZ_MAGIC = 0x5A534444; // "DDSZ"
+    constexpr uint32_t DDSZ_VERSION = 1;
+
+#pragma pack(push,1)
+
+    // Layout: DDSZ_MAGIC, DDS_HEADER, optional DDS_HEADER_DXT10, DDSZ_HEADER, chunkCount
+    // DDSZ_CHUNK entries, then the chunk payloads back to back. Chunks cover the image data
+    // in order and never straddle a subresource.
+    struct DDSZ_HEADER
+    {
+        uint32_t    version;
+        uint32_t    chunkCount;
+        uint32_t    bitSize;        // Image data size once decompressed
+        uint32_t    reserved;
+    };
+
+    struct DDSZ_CHUNK
+    {
+        uint32_t    size;           // Decompressed size
+        uint32_t    packedSize;     // Equal to size when the chunk is stored uncompressed
+    };
+
+#pragma pack(pop)
+
+    // Block codec compatible with the LZ4 block format. LZCompress returns the compressed
+    // size, or 0 if it would not fit in destSize. LZDecompress fails unless the input
+    // decodes to exactly destSize bytes, and never reads or writes out of bounds.
+    size_t LZCompressBound(size_t srcSize) noexcept;
+
+    size_t LZCompress(
+        _In_reads_bytes_(srcSize) const uint8_t* src,
+        size_t srcSize,
+        _Out_writes_bytes_to_(destSize, return) uint8_t* dest,
+        size_t destSize) noexcept;
+
+    bool LZDecompress(
+        _In_reads_bytes_(srcSize) const uint8_t* src,
+        size_t srcSize,
+        _Out_writes_bytes_all_(destSize) uint8_t* dest,
+        size_t destSize) noexcept;
+
+    inline bool IsCompressedDDS(_In_reads_bytes_(dataSize) const uint8_t* data, size_t dataSize) noexcept
+    {
+        return data && dataSize >= sizeof(uint32_t)
+            && *reinterpret_cast<const uint32_t*>(data) == DDSZ_MAGIC;
+    }
+
+    // Expands a supercompressed DDS back into a plain DDS file image.
+    HRESULT DecompressDDS(
+        _In_reads_bytes_(dataSize) const uint8_t* data,
+        size_t dataSize,
+        std::unique_ptr<uint8_t[]>& ddsData,
+        size_t& ddsDataSize) noexcept;
+
+    // Packs a plain DDS file image. Chunks that don't shrink are stored as they are.
+    HRESULT CompressDDS(
+        _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+        size_t ddsDataSize,
+        std::vector<uint8_t>& blob) noexcept;
+}
@@ -0,0 +1,314 @@
+//--------------------------------------------------------------------------------------
+// File: DDSParser.cpp
+//
+// Validates a DDS file in memory and describes the texture it holds without creating
+// any Direct3D objects, for use by tools and pipelines that run without a device.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+
+#include "DDSParser.h"
+
+#include "PlatformHelpers.h"
+#include "DDS.h"
+#include "LoaderHelpers.h"
+
+using namespace DirectX;
+using namespace DirectX::LoaderHelpers;
+
+namespace
+{
+    // No format packs more than eight pixels into a byte (DXGI_FORMAT_R1_UNORM), so a larger
+    // top level can't fit in a DDS file. Bounding this also keeps the size math from overflowing.
+    constexpr uint64_t c_maxPixels = uint64_t(UINT32_MAX) * 8u;
+
+    //--------------------------------------------------------------------------------------
+    HRESULT GetTextureDesc(
+        _In_ const DDS_HEADER* header,
+        _Out_ DDSTextureDesc& desc) noexcept
+    {
+        desc = {};
+
+        uint32_t width = header->width;
+        uint32_t height = header->height;
+        uint32_t depth = header->depth;
+
+        uint64_t arraySize = 1;
+        DDS_TEXTURE_DIMENSION dimension = DDS_TEXTURE_DIMENSION_UNKNOWN;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        bool isCubeMap = false;
+
+        if ((header->ddspf.flags & DDS_FOURCC) &&
+            (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC))
+        {
+            auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>(reinterpret_cast<const char*>(header) + sizeof(DDS_HEADER));
+
+            arraySize = d3d10ext->arraySize;
+            if (arraySize == 0)
+            {
+                return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+            }
+
+            switch (d3d10ext->dxgiFormat)
+            {
+            case DXGI_FORMAT_NV12:
+            case DXGI_FORMAT_P010:
+            case DXGI_FORMAT_P016:
+            case DXGI_FORMAT_420_OPAQUE:
+                if ((d3d10ext->resourceDimension != DDS_DIMENSION_TEXTURE2D)
+                    || (width % 2) != 0 || (height % 2) != 0)
+                {
+                    DebugTrace("ERROR: Video texture does not meet width/height requirements.\n");
+                    return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+                }
+                break;
+
+            case DXGI_FORMAT_YUY2:
+            case DXGI_FORMAT_Y210:
+            case DXGI_FORMAT_Y216:
+            case DXGI_FORMAT_P208:
+                if ((width % 2) != 0)
+                {
+                    DebugTrace("ERROR: Video texture does not meet width requirements.\n");
+                    return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+                }
+                break;
+
+            case DXGI_FORMAT_NV11:
+                if ((width % 4) != 0)
+                {
+                    DebugTrace("ERROR: Video texture does not meet width requirements.\n");
+                    return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+                }
+                break;
+
+            default:
+                if (BitsPerPixel(d3d10ext->dxgiFormat) == 0)
+                {
+                    DebugTrace("ERROR: Unknown DXGI format (%u)\n", static_cast<uint32_t>(d3d10ext->dxgiFormat));
+                    return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+                }
+            }
+
+            format = d3d10ext->dxgiFormat;
+
+            switch (d3d10ext->resourceDimension)
+            {
+            case DDS_DIMENSION_TEXTURE1D:
+                // D3DX writes 1D textures with a fixed Height of 1
+                if ((header->flags & DDS_HEIGHT) && height != 1)
+                {
+                    return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+                }
+                height = depth = 1;
+                dimension = DDS_TEXTURE_DIMENSION_1D;
+                break;
+
+            case DDS_DIMENSION_TEXTURE2D:
+                if (d3d10ext->miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)
+                {
+                    arraySize *= 6;
+                    isCubeMap = true;
+                }
+                depth = 1;
+                dimension = DDS_TEXTURE_DIMENSION_2D;
+                break;
+
+            case DDS_DIMENSION_TEXTURE3D:
+                if (!(header->flags & DDS_HEADER_FLAGS_VOLUME))
+                {
+                    return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+                }
+
+                if (arraySize > 1)
+                {
+                    DebugTrace("ERROR: Volume textures are not texture arrays\n");
+                    return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+                }
+                dimension = DDS_TEXTURE_DIMENSION_3D;
+                break;
+
+            default:
+                DebugTrace("ERROR: Unknown or unsupported resource dimension (%u)\n", static_cast<uint32_t>(d3d10ext->resourceDimension));
+                return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+            }
+        }
+        else
+        {
+            format = GetDXGIFormat(header->ddspf);
+
+            if (format == DXGI_FORMAT_UNKNOWN)
+            {
+                DebugTrace("ERROR: DDSTextureLoader does not support all legacy DDS formats. Consider using DirectXTex.\n");
+                return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+            }
+
+            if (header->flags & DDS_HEADER_FLAGS_VOLUME)
+            {
+                dimension = DDS_TEXTURE_DIMENSION_3D;
+            }
+            else
+            {
+                if (header->caps2 & DDS_CUBEMAP)
+                {
+                    // We require all six faces to be defined
+                    if ((header->caps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES)
+                    {
+                        DebugTrace("ERROR: Partial cubemaps are not supported\n");
+                        return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+                    }
+
+                    arraySize = 6;
+                    isCubeMap = true;
+                }
+
+                depth = 1;
+                dimension = DDS_TEXTURE_DIMENSION_2D;
+
+                // Note there's no way for a legacy Direct3D 9 DDS to express a '1D' texture
+            }
+
+            assert(BitsPerPixel(format) != 0);
+        }
+
+        if (!width || !height || !depth || arraySize > UINT32_MAX)
+        {
+            return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        }
+
+        const uint64_t pixels = uint64_t(width) * uint64_t(height);
+        if (pixels > c_maxPixels || depth > c_maxPixels / pixels)
+        {
+            return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+        }
+
+        const uint32_t mipLevels = std::max<uint32_t>(header->mipMapCount, 1u);
+
+        desc.dimension = dimension;
+        desc.format = format;
+        desc.width = width;
+        desc.height = height;
+        desc.depth = depth;
+        desc.arraySize = static_cast<uint32_t>(arraySize);
+        desc.mipLevels = mipLevels;
+        desc.isCubeMap = isCubeMap;
+        desc.alphaMode = GetAlphaMode(header);
+        desc.subresourceCount = static_cast<size_t>(uint64_t(mipLevels) * arraySize);
+
+        return S_OK;
+    }
+
+    //--------------------------------------------------------------------------------------
+    HRESULT GetSubresources(
+        const DDSTextureDesc& desc,
+        size_t ddsDataSize,
+        _Out_writes_opt_(desc.subresourceCount) DDSSubresource* subresources) noexcept
+    {
+        size_t offset = desc.dataOffset;
+        size_t index = 0;
+
+        for (size_t j = 0; j < desc.arraySize; ++j)
+        {
+            size_t w = desc.width;
+            size_t h = desc.height;
+            size_t d = desc.depth;
+            for (size_t i = 0; i < desc.mipLevels; ++i)
+            {
+                size_t numBytes = 0;
+                size_t rowBytes = 0;
+                HRESULT hr = GetSurfaceInfo(w, h, desc.format, &numBytes, &rowBytes, nullptr);
+                if (FAILED(hr))
+                    return hr;
+
+                if (!numBytes || d > (ddsDataSize - offset) / numBytes)
+                {
+                    return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+                }
+
+                const size_t size = numBytes * d;
+
+                if (subresources)
+                {
+                    auto& sub = subresources[index];
+                    sub.offset = offset;
+                    sub.size = size;
+                    sub.rowPitch = rowBytes;
+                    sub.slicePitch = numBytes;
+                    sub.width = static_cast<uint32_t>(w);
+                    sub.height = static_cast<uint32_t>(h);
+                    sub.depth = static_cast<uint32_t>(d);
+                }
+
+                ++index;
+                offset += size;
+
+                w = std::max<size_t>(w >> 1, 1);
+                h = std::max<size_t>(h >> 1, 1);
+                d = std::max<size_t>(d >> 1, 1);
+            }
+        }
+
+        return S_OK;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::ParseDDS(
+    const uint8_t* ddsData,
+    size_t ddsDataSize,
+    DDSTextureDesc* desc,
+    DDSSubresource* subresources,
+    size_t maxSubresources) noexcept
+{
+    if (!desc)
+    {
+        return E_INVALIDARG;
+    }
+
+    *desc = {};
+
+    if (!ddsData)
+    {
+        return E_INVALIDARG;
+    }
+
+    const DDS_HEADER* header = nullptr;
+    const uint8_t* bitData = nullptr;
+    size_t bitSize = 0;
+
+    HRESULT hr = LoadTextureDataFromMemory(ddsData, ddsDataSize,
+        &header,
+        &bitData,
+        &bitSize
+    );
+    if (FAILED(hr))
+        return hr;
+
+    hr = GetTextureDesc(header, *desc);
+    if (FAILED(hr))
+        return hr;
+
+    desc->dataOffset = static_cast<size_t>(bitData - ddsData);
+
+    // Every subresource takes at least a byte, which also bounds the walk below.
+    if (uint64_t(desc->mipLevels) * desc->arraySize > bitSize)
+    {
+        *desc = {};
+        return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+    }
+
+    if (subresources && maxSubresources < desc->subresourceCount)
+    {
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    return GetSubresources(*desc, ddsDataSize, subresources);
+}
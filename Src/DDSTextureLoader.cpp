@@ -17,11 +17,15 @@
 #include "pch.h"
 
 #include "DDSTextureLoader.h"
+#include "DDSParser.h"
 
 #include "PlatformHelpers.h"
 #include "DDS.h"
+#include "DDSCompression.h"
 #include "DirectXHelpers.h"
 #include "LoaderHelpers.h"
+#include "MemoryMappedFile.h"
+#include "MipGenerator.h"
 
 using namespace DirectX;
 using namespace DirectX::LoaderHelpers;
@@ -30,27 +34,26 @@ static_assert(static_cast<int>(DDS_DIMENSION_TEXTURE1D) == static_cast<int>(D3D1
 static_assert(static_cast<int>(DDS_DIMENSION_TEXTURE2D) == static_cast<int>(D3D11_RESOURCE_DIMENSION_TEXTURE2D), "dds mismatch");
 static_assert(static_cast<int>(DDS_DIMENSION_TEXTURE3D) == static_cast<int>(D3D11_RESOURCE_DIMENSION_TEXTURE3D), "dds mismatch");
 static_assert(static_cast<int>(DDS_RESOURCE_MISC_TEXTURECUBE) == static_cast<int>(D3D11_RESOURCE_MISC_TEXTURECUBE), "dds mismatch");
+static_assert(static_cast<int>(DDS_TEXTURE_DIMENSION_1D) == static_cast<int>(D3D11_RESOURCE_DIMENSION_TEXTURE1D), "dds mismatch");
+static_assert(static_cast<int>(DDS_TEXTURE_DIMENSION_2D) == static_cast<int>(D3D11_RESOURCE_DIMENSION_TEXTURE2D), "dds mismatch");
+static_assert(static_cast<int>(DDS_TEXTURE_DIMENSION_3D) == static_cast<int>(D3D11_RESOURCE_DIMENSION_TEXTURE3D), "dds mismatch");
 
 namespace
 {
     //--------------------------------------------------------------------------------------
     HRESULT FillInitData(
-        _In_ size_t width,
-        _In_ size_t height,
-        _In_ size_t depth,
         _In_ size_t mipCount,
         _In_ size_t arraySize,
-        _In_ DXGI_FORMAT format,
         _In_ size_t maxsize,
-        _In_ size_t bitSize,
-        _In_reads_bytes_(bitSize) const uint8_t* bitData,
+        _In_ const uint8_t* ddsData,
+        _In_reads_(mipCount*arraySize) const DDSSubresource* subresources,
         _Out_ size_t& twidth,
         _Out_ size_t& theight,
         _Out_ size_t& tdepth,
         _Out_ size_t& skipMip,
         _Out_writes_(mipCount*arraySize) D3D11_SUBRESOURCE_DATA* initData) noexcept
     {
-        if (!bitData || !initData)
+        if (!ddsData || !subresources || !initData)
         {
             return E_POINTER;
         }
@@ -60,40 +63,30 @@ namespace
         theight = 0;
         tdepth = 0;
 
-        size_t NumBytes = 0;
-        size_t RowBytes = 0;
-        const uint8_t* pSrcBits = bitData;
-        const uint8_t* pEndBits = bitData + bitSize;
-
         size_t index = 0;
         for (size_t j = 0; j < arraySize; j++)
         {
-            size_t w = width;
-            size_t h = height;
-            size_t d = depth;
             for (size_t i = 0; i < mipCount; i++)
             {
-                HRESULT hr = GetSurfaceInfo(w, h, format, &NumBytes, &RowBytes, nullptr);
-                if (FAILED(hr))
-                    return hr;
+                const DDSSubresource& sub = subresources[j * mipCount + i];
 
-                if (NumBytes > UINT32_MAX || RowBytes > UINT32_MAX)
+                if (sub.slicePitch > UINT32_MAX || sub.rowPitch > UINT32_MAX)
                     return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
 
-                if ((mipCount <= 1) || !maxsize || (w <= maxsize && h <= maxsize && d <= maxsize))
+                if ((mipCount <= 1) || !maxsize || (sub.width <= maxsize && sub.height <= maxsize && sub.depth <= maxsize))
                 {
                     if (!twidth)
                     {
-                        twidth = w;
-                        theight = h;
-                        tdepth = d;
+                        twidth = sub.width;
+                        theight = sub.height;
+                        tdepth = sub.depth;
                     }
 
                     assert(index < mipCount * arraySize);
                     _Analysis_assume_(index < mipCount * arraySize);
-                    initData[index].pSysMem = pSrcBits;
-                    initData[index].SysMemPitch = static_cast<UINT>(RowBytes);
-                    initData[index].SysMemSlicePitch = static_cast<UINT>(NumBytes);
+                    initData[index].pSysMem = ddsData + sub.offset;
+                    initData[index].SysMemPitch = static_cast<UINT>(sub.rowPitch);
+                    initData[index].SysMemSlicePitch = static_cast<UINT>(sub.slicePitch);
                     ++index;
                 }
                 else if (!j)
@@ -101,29 +94,6 @@ namespace
                     // Count number of skipped mipmaps (first item only)
                     ++skipMip;
                 }
-
-                if (pSrcBits + (NumBytes*d) > pEndBits)
-                {
-                    return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
-                }
-
-                pSrcBits += NumBytes * d;
-
-                w = w >> 1;
-                h = h >> 1;
-                d = d >> 1;
-                if (w == 0)
-                {
-                    w = 1;
-                }
-                if (h == 0)
-                {
-                    h = 1;
-                }
-                if (d == 0)
-                {
-                    d = 1;
-                }
             }
         }
 
@@ -379,9 +349,8 @@ namespace
         _In_opt_ ID3D11DeviceX* d3dDeviceX,
         _In_opt_ ID3D11DeviceContextX* d3dContextX,
     #endif
-        _In_ const DDS_HEADER* header,
-        _In_reads_bytes_(bitSize) const uint8_t* bitData,
-        _In_ size_t bitSize,
+        _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+        _In_ size_t ddsDataSize,
         _In_ size_t maxsize,
         _In_ D3D11_USAGE usage,
         _In_ unsigned int bindFlags,
@@ -389,168 +358,49 @@ namespace
         _In_ unsigned int miscFlags,
         _In_ DDS_LOADER_FLAGS loadFlags,
         _Outptr_opt_ ID3D11Resource** texture,
-        _Outptr_opt_ ID3D11ShaderResourceView** textureView) noexcept
+        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
+        _Out_opt_ DDS_ALPHA_MODE* alphaMode) noexcept
     {
-        HRESULT hr = S_OK;
-
-        const UINT width = header->width;
-        UINT height = header->height;
-        UINT depth = header->depth;
+        // Memory and memory-mapped sources may still be supercompressed; the texture is
+        // then initialized from the expanded copy
+        std::unique_ptr<uint8_t[]> unpacked;
+        if (IsCompressedDDS(ddsData, ddsDataSize))
+        {
+            HRESULT hr = DecompressDDS(ddsData, ddsDataSize, unpacked, ddsDataSize);
+            if (FAILED(hr))
+                return hr;
 
-        uint32_t resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
-        UINT arraySize = 1;
-        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
-        bool isCubeMap = false;
+            ddsData = unpacked.get();
+        }
 
-        size_t mipCount = header->mipMapCount;
-        if (0 == mipCount)
+        DDSTextureDesc desc = {};
+        HRESULT hr = ParseDDS(ddsData, ddsDataSize, &desc);
+        if (FAILED(hr))
         {
-            mipCount = 1;
+            return hr;
         }
 
-        if ((header->ddspf.flags & DDS_FOURCC) &&
-            (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC))
+        switch (desc.format)
         {
-            auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>(reinterpret_cast<const char*>(header) + sizeof(DDS_HEADER));
-
-            arraySize = d3d10ext->arraySize;
-            if (arraySize == 0)
-            {
-                return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
-            }
-
-            switch (d3d10ext->dxgiFormat)
-            {
-            case DXGI_FORMAT_NV12:
-            case DXGI_FORMAT_P010:
-            case DXGI_FORMAT_P016:
-            case DXGI_FORMAT_420_OPAQUE:
-                if ((d3d10ext->resourceDimension != D3D11_RESOURCE_DIMENSION_TEXTURE2D)
-                    || (width % 2) != 0 || (height % 2) != 0)
-                {
-                    DebugTrace("ERROR: Video texture does not meet width/height requirements.\n");
-                    return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-                }
-                break;
-
-            case DXGI_FORMAT_YUY2:
-            case DXGI_FORMAT_Y210:
-            case DXGI_FORMAT_Y216:
-            case DXGI_FORMAT_P208:
-                if ((width % 2) != 0)
-                {
-                    DebugTrace("ERROR: Video texture does not meet width requirements.\n");
-                    return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-                }
-                break;
-
-            case DXGI_FORMAT_NV11:
-                if ((width % 4) != 0)
-                {
-                    DebugTrace("ERROR: Video texture does not meet width requirements.\n");
-                    return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-                }
-                break;
-
-            case DXGI_FORMAT_AI44:
-            case DXGI_FORMAT_IA44:
-            case DXGI_FORMAT_P8:
-            case DXGI_FORMAT_A8P8:
-                DebugTrace("ERROR: Legacy stream video texture formats are not supported by Direct3D.\n");
-                return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-
-            default:
-                if (BitsPerPixel(d3d10ext->dxgiFormat) == 0)
-                {
-                    DebugTrace("ERROR: Unknown DXGI format (%u)\n", static_cast<uint32_t>(d3d10ext->dxgiFormat));
-                    return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-                }
-            }
-
-            format = d3d10ext->dxgiFormat;
-
-            switch (d3d10ext->resourceDimension)
-            {
-            case D3D11_RESOURCE_DIMENSION_TEXTURE1D:
-                // D3DX writes 1D textures with a fixed Height of 1
-                if ((header->flags & DDS_HEIGHT) && height != 1)
-                {
-                    return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
-                }
-                height = depth = 1;
-                break;
-
-            case D3D11_RESOURCE_DIMENSION_TEXTURE2D:
-                if (d3d10ext->miscFlag & D3D11_RESOURCE_MISC_TEXTURECUBE)
-                {
-                    arraySize *= 6;
-                    isCubeMap = true;
-                }
-                depth = 1;
-                break;
-
-            case D3D11_RESOURCE_DIMENSION_TEXTURE3D:
-                if (!(header->flags & DDS_HEADER_FLAGS_VOLUME))
-                {
-                    return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
-                }
-
-                if (arraySize > 1)
-                {
-                    DebugTrace("ERROR: Volume textures are not texture arrays\n");
-                    return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-                }
-                break;
-
-            case D3D11_RESOURCE_DIMENSION_BUFFER:
-                DebugTrace("ERROR: Resource dimension buffer type not supported for textures\n");
-                return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-
-            case D3D11_RESOURCE_DIMENSION_UNKNOWN:
-            default:
-                DebugTrace("ERROR: Unknown resource dimension (%u)\n", static_cast<uint32_t>(d3d10ext->resourceDimension));
-                return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-            }
+        case DXGI_FORMAT_AI44:
+        case DXGI_FORMAT_IA44:
+        case DXGI_FORMAT_P8:
+        case DXGI_FORMAT_A8P8:
+            DebugTrace("ERROR: Legacy stream video texture formats are not supported by Direct3D.\n");
+            return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
 
-            resDim = d3d10ext->resourceDimension;
+        default:
+            break;
         }
-        else
-        {
-            format = GetDXGIFormat(header->ddspf);
 
-            if (format == DXGI_FORMAT_UNKNOWN)
-            {
-                DebugTrace("ERROR: DDSTextureLoader does not support all legacy DDS formats. Consider using DirectXTex.\n");
-                return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-            }
-
-            if (header->flags & DDS_HEADER_FLAGS_VOLUME)
-            {
-                resDim = D3D11_RESOURCE_DIMENSION_TEXTURE3D;
-            }
-            else
-            {
-                if (header->caps2 & DDS_CUBEMAP)
-                {
-                    // We require all six faces to be defined
-                    if ((header->caps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES)
-                    {
-                        DebugTrace("ERROR: DirectX 11 does not support partial cubemaps\n");
-                        return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
-                    }
-
-                    arraySize = 6;
-                    isCubeMap = true;
-                }
-
-                depth = 1;
-                resDim = D3D11_RESOURCE_DIMENSION_TEXTURE2D;
-
-                // Note there's no way for a legacy Direct3D 9 DDS to express a '1D' texture
-            }
-
-            assert(BitsPerPixel(format) != 0);
-        }
+        const UINT width = desc.width;
+        const UINT height = desc.height;
+        const UINT depth = desc.depth;
+        const uint32_t resDim = desc.dimension;
+        const UINT arraySize = desc.arraySize;
+        const size_t mipCount = desc.mipLevels;
+        const DXGI_FORMAT format = desc.format;
+        bool isCubeMap = desc.isCubeMap;
 
         if ((miscFlags & D3D11_RESOURCE_MISC_TEXTURECUBE)
             && (resDim == D3D11_RESOURCE_DIMENSION_TEXTURE2D)
@@ -619,6 +469,19 @@ namespace
             return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
         }
 
+        // The bounds above keep the subresource count to what Direct3D can create
+        std::unique_ptr<DDSSubresource[]> subresources(new (std::nothrow) DDSSubresource[desc.subresourceCount]);
+        if (!subresources)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        hr = ParseDDS(ddsData, ddsDataSize, &desc, subresources.get(), desc.subresourceCount);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
         bool autogen = false;
         if (mipCount == 1 && d3dContext && textureView) // Must have context and shader-view to auto generate mipmaps
         {
@@ -640,6 +503,26 @@ namespace
             }
         }
 
+        // Without autogen, a single-level 2D texture can still get a full chain built on the CPU
+        bool cpumips = false;
+        DXGI_FORMAT mipFormat = format;
+        if (!autogen && mipCount == 1 && (loadFlags & DDS_LOADER_MIP_CPU)
+            && (resDim == D3D11_RESOURCE_DIMENSION_TEXTURE2D)
+            && (!maxsize || (width <= maxsize && height <= maxsize)))
+        {
+            // Filter in the color space the texture will be created with
+            if (loadFlags & DDS_LOADER_FORCE_SRGB)
+            {
+                mipFormat = MakeSRGB(format);
+            }
+            else if (loadFlags & DDS_LOADER_IGNORE_SRGB)
+            {
+                mipFormat = MakeLinear(format);
+            }
+
+            cpumips = IsCPUMipFormatSupported(mipFormat);
+        }
+
         if (autogen)
         {
             // Create texture with auto-generated mipmaps
@@ -656,19 +539,8 @@ namespace
                 &tex, textureView);
             if (SUCCEEDED(hr))
             {
-                size_t numBytes = 0;
-                size_t rowBytes = 0;
-                hr = GetSurfaceInfo(width, height, format, &numBytes, &rowBytes, nullptr);
-                if (FAILED(hr))
-                    return hr;
-
-                if (numBytes > bitSize)
-                {
-                    (*textureView)->Release();
-                    *textureView = nullptr;
-                    tex->Release();
-                    return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
-                }
+                const size_t numBytes = subresources[0].slicePitch;
+                const size_t rowBytes = subresources[0].rowPitch;
 
                 if (numBytes > UINT32_MAX || rowBytes > UINT32_MAX)
                     return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
@@ -702,22 +574,11 @@ namespace
                     return E_OUTOFMEMORY;
                 }
 
-                const uint8_t* pSrcBits = bitData;
-                const uint8_t* pEndBits = bitData + bitSize;
                 for (UINT item = 0; item < arraySize; ++item)
                 {
-                    if ((pSrcBits + numBytes) > pEndBits)
-                    {
-                        (*textureView)->Release();
-                        *textureView = nullptr;
-                        tex->Release();
-                        return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
-                    }
-
-                    initData[item].pSysMem = pSrcBits;
+                    initData[item].pSysMem = ddsData + subresources[item].offset;
                     initData[item].SysMemPitch = static_cast<UINT>(rowBytes);
                     initData[item].SysMemSlicePitch = static_cast<UINT>(numBytes);
-                    pSrcBits += numBytes;
                 }
 
                 ID3D11Resource* pStaging = nullptr;
@@ -769,26 +630,15 @@ namespace
             #else
                 if (arraySize > 1)
                 {
-                    const uint8_t* pSrcBits = bitData;
-                    const uint8_t* pEndBits = bitData + bitSize;
                     for (UINT item = 0; item < arraySize; ++item)
                     {
-                        if ((pSrcBits + numBytes) > pEndBits)
-                        {
-                            (*textureView)->Release();
-                            *textureView = nullptr;
-                            tex->Release();
-                            return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
-                        }
-
                         const UINT res = D3D11CalcSubresource(0, item, mipLevels);
-                        d3dContext->UpdateSubresource(tex, res, nullptr, pSrcBits, static_cast<UINT>(rowBytes), static_cast<UINT>(numBytes));
-                        pSrcBits += numBytes;
+                        d3dContext->UpdateSubresource(tex, res, nullptr, ddsData + subresources[item].offset, static_cast<UINT>(rowBytes), static_cast<UINT>(numBytes));
                     }
                 }
                 else
                 {
-                    d3dContext->UpdateSubresource(tex, 0, nullptr, bitData, static_cast<UINT>(rowBytes), static_cast<UINT>(numBytes));
+                    d3dContext->UpdateSubresource(tex, 0, nullptr, ddsData + subresources[0].offset, static_cast<UINT>(rowBytes), static_cast<UINT>(numBytes));
                 }
             #endif
 
@@ -804,6 +654,43 @@ namespace
                 }
             }
         }
+        else if (cpumips)
+        {
+            // Create texture with mipmaps generated on the CPU
+            const size_t mipLevels = CountMips(width, height);
+
+            std::unique_ptr<D3D11_SUBRESOURCE_DATA[]> initData(new (std::nothrow) D3D11_SUBRESOURCE_DATA[mipLevels * arraySize]);
+            std::unique_ptr<std::unique_ptr<uint8_t[]>[]> mipData(new (std::nothrow) std::unique_ptr<uint8_t[]>[arraySize]);
+            if (!initData || !mipData)
+            {
+                return E_OUTOFMEMORY;
+            }
+
+            const MIP_FILTER filter = (loadFlags & DDS_LOADER_MIP_KAISER) ? MIP_FILTER_KAISER : MIP_FILTER_BOX;
+
+            for (UINT item = 0; item < arraySize; ++item)
+            {
+                const DDSSubresource& sub = subresources[item];
+
+                hr = GenerateMipChain(ddsData + sub.offset, sub.rowPitch, width, height, mipFormat,
+                    mipLevels, filter, desc.alphaMode == DDS_ALPHA_MODE_STRAIGHT,
+                    mipData[item], initData.get() + item * mipLevels);
+                if (FAILED(hr))
+                {
+                    DebugTrace("ERROR: CPU mipmap generation failed (%08X)\n", static_cast<unsigned int>(hr));
+                    return hr;
+                }
+            }
+
+            hr = CreateD3DResources(d3dDevice,
+                resDim, width, height, depth, mipLevels, arraySize,
+                format,
+                usage, bindFlags, cpuAccessFlags, miscFlags,
+                loadFlags,
+                isCubeMap,
+                initData.get(),
+                texture, textureView);
+        }
         else
         {
             // Create the texture
@@ -817,8 +704,8 @@ namespace
             size_t twidth = 0;
             size_t theight = 0;
             size_t tdepth = 0;
-            hr = FillInitData(width, height, depth, mipCount, arraySize, format,
-                maxsize, bitSize, bitData,
+            hr = FillInitData(mipCount, arraySize, maxsize,
+                ddsData, subresources.get(),
                 twidth, theight, tdepth, skipMip, initData.get());
 
             if (SUCCEEDED(hr))
@@ -864,8 +751,8 @@ namespace
                         break;
                     }
 
-                    hr = FillInitData(width, height, depth, mipCount, arraySize, format,
-                        maxsize, bitSize, bitData,
+                    hr = FillInitData(mipCount, arraySize, maxsize,
+                        ddsData, subresources.get(),
                         twidth, theight, tdepth, skipMip, initData.get());
                     if (SUCCEEDED(hr))
                     {
@@ -882,6 +769,11 @@ namespace
             }
         }
 
+        if (SUCCEEDED(hr) && alphaMode)
+        {
+            *alphaMode = desc.alphaMode;
+        }
+
         return hr;
     }
 
@@ -940,6 +832,41 @@ namespace
         UNREFERENCED_PARAMETER(textureView);
     #endif
     }
+
+    //--------------------------------------------------------------------------------------
+    // Reads the file into fileData, or with DDS_LOADER_MEMORY_MAPPED maps it, so the
+    // texture is initialized straight from the mapped pages.
+    HRESULT LoadTextureData(
+        _In_z_ const wchar_t* fileName,
+        DDS_LOADER_FLAGS loadFlags,
+        std::unique_ptr<uint8_t[]>& fileData,
+        MemoryMappedFile& mappedFile,
+        const uint8_t** ddsData,
+        size_t* ddsDataSize) noexcept
+    {
+        if (loadFlags & DDS_LOADER_MEMORY_MAPPED)
+        {
+            HRESULT hr = mappedFile.Open(fileName);
+            if (FAILED(hr))
+                return hr;
+
+            *ddsData = mappedFile.GetData();
+            *ddsDataSize = mappedFile.GetSize();
+            return S_OK;
+        }
+
+        const DDS_HEADER* header = nullptr;
+        const uint8_t* bitData = nullptr;
+        size_t bitSize = 0;
+
+        HRESULT hr = LoadTextureDataFromFile(fileName, fileData, &header, &bitData, &bitSize);
+        if (FAILED(hr))
+            return hr;
+
+        *ddsData = fileData.get();
+        *ddsDataSize = static_cast<size_t>(bitData - fileData.get()) + bitSize;
+        return S_OK;
+    }
 } // anonymous namespace
 
 
@@ -1025,30 +952,15 @@ HRESULT DirectX::CreateDDSTextureFromMemoryEx(
         return E_INVALIDARG;
     }
 
-    // Validate DDS file in memory
-    const DDS_HEADER* header = nullptr;
-    const uint8_t* bitData = nullptr;
-    size_t bitSize = 0;
-
-    HRESULT hr = LoadTextureDataFromMemory(ddsData, ddsDataSize,
-        &header,
-        &bitData,
-        &bitSize
-    );
-    if (FAILED(hr))
-    {
-        return hr;
-    }
-
-    hr = CreateTextureFromDDS(d3dDevice, nullptr,
+    HRESULT hr = CreateTextureFromDDS(d3dDevice, nullptr,
     #if defined(_XBOX_ONE) && defined(_TITLE)
         nullptr, nullptr,
     #endif
-        header, bitData, bitSize,
+        ddsData, ddsDataSize,
         maxsize,
         usage, bindFlags, cpuAccessFlags, miscFlags,
         loadFlags,
-        texture, textureView);
+        texture, textureView, alphaMode);
     if (SUCCEEDED(hr))
     {
         if (texture && *texture)
@@ -1060,9 +972,6 @@ HRESULT DirectX::CreateDDSTextureFromMemoryEx(
         {
             SetDebugObjectName(*textureView, "DDSTextureLoader");
         }
-
-        if (alphaMode)
-            *alphaMode = GetAlphaMode(header);
     }
 
     return hr;
@@ -1113,30 +1022,15 @@ HRESULT DirectX::CreateDDSTextureFromMemoryEx(
         return E_INVALIDARG;
     }
 
-    // Validate DDS file in memory
-    const DDS_HEADER* header = nullptr;
-    const uint8_t* bitData = nullptr;
-    size_t bitSize = 0;
-
-    HRESULT hr = LoadTextureDataFromMemory(ddsData, ddsDataSize,
-        &header,
-        &bitData,
-        &bitSize
-    );
-    if (FAILED(hr))
-    {
-        return hr;
-    }
-
-    hr = CreateTextureFromDDS(d3dDevice, d3dContext,
+    HRESULT hr = CreateTextureFromDDS(d3dDevice, d3dContext,
     #if defined(_XBOX_ONE) && defined(_TITLE)
         d3dDevice, d3dContext,
     #endif
-        header, bitData, bitSize,
+        ddsData, ddsDataSize,
         maxsize,
         usage, bindFlags, cpuAccessFlags, miscFlags,
         loadFlags,
-        texture, textureView);
+        texture, textureView, alphaMode);
     if (SUCCEEDED(hr))
     {
         if (texture && *texture)
@@ -1148,9 +1042,6 @@ HRESULT DirectX::CreateDDSTextureFromMemoryEx(
         {
             SetDebugObjectName(*textureView, "DDSTextureLoader");
         }
-
-        if (alphaMode)
-            *alphaMode = GetAlphaMode(header);
     }
 
     return hr;
@@ -1235,16 +1126,17 @@ HRESULT DirectX::CreateDDSTextureFromFileEx(
         return E_INVALIDARG;
     }
 
-    const DDS_HEADER* header = nullptr;
-    const uint8_t* bitData = nullptr;
-    size_t bitSize = 0;
+    std::unique_ptr<uint8_t[]> fileData;
+    MemoryMappedFile mappedFile;
+    const uint8_t* ddsData = nullptr;
+    size_t ddsDataSize = 0;
 
-    std::unique_ptr<uint8_t[]> ddsData;
-    HRESULT hr = LoadTextureDataFromFile(fileName,
-        ddsData,
-        &header,
-        &bitData,
-        &bitSize
+    HRESULT hr = LoadTextureData(fileName,
+        loadFlags,
+        fileData,
+        mappedFile,
+        &ddsData,
+        &ddsDataSize
     );
     if (FAILED(hr))
     {
@@ -1255,18 +1147,15 @@ HRESULT DirectX::CreateDDSTextureFromFileEx(
     #if defined(_XBOX_ONE) && defined(_TITLE)
         nullptr, nullptr,
     #endif
-        header, bitData, bitSize,
+        ddsData, ddsDataSize,
         maxsize,
         usage, bindFlags, cpuAccessFlags, miscFlags,
         loadFlags,
-        texture, textureView);
+        texture, textureView, alphaMode);
 
     if (SUCCEEDED(hr))
     {
         SetDebugTextureInfo(fileName, texture, textureView);
-
-        if (alphaMode)
-            *alphaMode = GetAlphaMode(header);
     }
 
     return hr;
@@ -1316,16 +1205,17 @@ HRESULT DirectX::CreateDDSTextureFromFileEx(
         return E_INVALIDARG;
     }
 
-    const DDS_HEADER* header = nullptr;
-    const uint8_t* bitData = nullptr;
-    size_t bitSize = 0;
+    std::unique_ptr<uint8_t[]> fileData;
+    MemoryMappedFile mappedFile;
+    const uint8_t* ddsData = nullptr;
+    size_t ddsDataSize = 0;
 
-    std::unique_ptr<uint8_t[]> ddsData;
-    HRESULT hr = LoadTextureDataFromFile(fileName,
-        ddsData,
-        &header,
-        &bitData,
-        &bitSize
+    HRESULT hr = LoadTextureData(fileName,
+        loadFlags,
+        fileData,
+        mappedFile,
+        &ddsData,
+        &ddsDataSize
     );
     if (FAILED(hr))
     {
@@ -1336,18 +1226,15 @@ HRESULT DirectX::CreateDDSTextureFromFileEx(
     #if defined(_XBOX_ONE) && defined(_TITLE)
         d3dDevice, d3dContext,
     #endif
-        header, bitData, bitSize,
+        ddsData, ddsDataSize,
         maxsize,
         usage, bindFlags, cpuAccessFlags, miscFlags,
         loadFlags,
-        texture, textureView);
+        texture, textureView, alphaMode);
 
     if (SUCCEEDED(hr))
     {
         SetDebugTextureInfo(fileName, texture, textureView);
-
-        if (alphaMode)
-            *alphaMode = GetAlphaMode(header);
     }
 
     return hr;
@@ -350,8 +350,8 @@ private:
 
 
     private:
-        ComPtr<ID3D11VertexShader> mVertexShaders[DGSLEffectTraits::VertexShaderCount];
-        ComPtr<ID3D11PixelShader> mPixelShaders[DGSLEffectTraits::PixelShaderCount];
+        AtomicComPtr<ID3D11VertexShader> mVertexShaders[DGSLEffectTraits::VertexShaderCount];
+        AtomicComPtr<ID3D11PixelShader> mPixelShaders[DGSLEffectTraits::PixelShaderCount];
     };
 
     // Per-device resources.
@@ -369,6 +369,8 @@ void DGSLEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
     assert(deviceContext != nullptr);
 
+    StateFilter filter(deviceContext);
+
     auto vertexShader = mDeviceResources->GetVertexShader(GetCurrentVSPermutation());
     auto pixelShader = mPixelShader.Get();
     if (!pixelShader)
@@ -376,8 +378,8 @@ void DGSLEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
         pixelShader = mDeviceResources->GetPixelShader(GetCurrentPSPermutation());
     }
 
-    deviceContext->VSSetShader(vertexShader, nullptr, 0);
-    deviceContext->PSSetShader(pixelShader, nullptr, 0);
+    filter.VSSetShader(vertexShader, nullptr, 0);
+    filter.PSSetShader(pixelShader, nullptr, 0);
 
     // Check for any required matrices updates
     if (dirtyFlags & EffectDirtyFlags::WorldViewProj)
@@ -497,8 +499,8 @@ void DGSLEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
             mCBMisc.GetBuffer(), mCBBone.GetBuffer()
         };
 
-        deviceContext->VSSetConstantBuffers(0, 5, buffers);
-        deviceContext->PSSetConstantBuffers(0, 4, buffers);
+        filter.VSSetConstantBuffers(0, 5, buffers);
+        filter.PSSetConstantBuffers(0, 4, buffers);
     }
     else
     {
@@ -508,8 +510,8 @@ void DGSLEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
             mCBMisc.GetBuffer(), nullptr
         };
 
-        deviceContext->VSSetConstantBuffers(0, 5, buffers);
-        deviceContext->PSSetConstantBuffers(0, 4, buffers);
+        filter.VSSetConstantBuffers(0, 5, buffers);
+        filter.PSSetConstantBuffers(0, 4, buffers);
     }
 #endif
 
@@ -527,12 +529,12 @@ void DGSLEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
             textures[6].Get(),
             textures[7].Get()
         };
-        deviceContext->PSSetShaderResources(0, MaxTextures, txt);
+        filter.PSSetShaderResources(0, MaxTextures, txt);
     }
     else
     {
         ID3D11ShaderResourceView* txt[MaxTextures] = { mDeviceResources->GetDefaultTexture(), nullptr };
-        deviceContext->PSSetShaderResources(0, MaxTextures, txt);
+        filter.PSSetShaderResources(0, MaxTextures, txt);
     }
 }
 
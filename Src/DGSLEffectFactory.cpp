@@ -11,9 +11,7 @@
 #include "Effects.h"
 #include "DemandCreate.h"
 #include "SharedResourcePool.h"
-
-#include "DDSTextureLoader.h"
-#include "WICTextureLoader.h"
+#include "EffectTextureCache.h"
 
 #include <string.h>
 
@@ -32,10 +30,20 @@ public:
     explicit Impl(_In_ ID3D11Device* device)
         : mPath{},
         mDevice(device),
+        mTextureCache(EffectTextureCache::instancePool.DemandCreate(device)),
         mSharing(true),
         mForceSRGB(false)
     {}
 
+    Impl(Impl const&) = delete;
+    Impl& operator= (Impl const&) = delete;
+
+    // The texture cache outlives the factory when other factories share it.
+    ~Impl()
+    {
+        mTextureCache->Release(this);
+    }
+
     std::shared_ptr<IEffect> CreateEffect(_In_ DGSLEffectFactory* factory, _In_ const IEffectFactory::EffectInfo& info, _In_opt_ ID3D11DeviceContext* deviceContext);
     std::shared_ptr<IEffect> CreateDGSLEffect(_In_ DGSLEffectFactory* factory, _In_ const DGSLEffectInfo& info, _In_opt_ ID3D11DeviceContext* deviceContext);
     void CreateTexture(_In_z_ const wchar_t* texture, _In_opt_ ID3D11DeviceContext* deviceContext, _Outptr_ ID3D11ShaderResourceView** textureView);
@@ -50,15 +58,14 @@ public:
     wchar_t mPath[MAX_PATH];
 
     ComPtr<ID3D11Device> mDevice;
+    std::shared_ptr<EffectTextureCache> mTextureCache;
 
 private:
     using EffectCache = std::map< std::wstring, std::shared_ptr<IEffect> >;
-    using TextureCache = std::map< std::wstring, ComPtr<ID3D11ShaderResourceView> >;
     using ShaderCache = std::map< std::wstring, ComPtr<ID3D11PixelShader> >;
 
     EffectCache  mEffectCache;
     EffectCache  mEffectCacheSkinning;
-    TextureCache mTextureCache;
     ShaderCache  mShaderCache;
 
     bool mSharing;
@@ -371,93 +378,7 @@ std::shared_ptr<IEffect> DGSLEffectFactory::Impl::CreateDGSLEffect(DGSLEffectFac
 _Use_decl_annotations_
 void DGSLEffectFactory::Impl::CreateTexture(const wchar_t* name, ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView** textureView)
 {
-    if (!name || !textureView)
-        throw std::invalid_argument("name and textureView parameters can't be null");
-
-#if defined(_XBOX_ONE) && defined(_TITLE)
-    UNREFERENCED_PARAMETER(deviceContext);
-#endif
-
-    auto it = mTextureCache.find(name);
-
-    if (mSharing && it != mTextureCache.end())
-    {
-        ID3D11ShaderResourceView* srv = it->second.Get();
-        srv->AddRef();
-        *textureView = srv;
-    }
-    else
-    {
-        wchar_t fullName[MAX_PATH] = {};
-        wcscpy_s(fullName, mPath);
-        wcscat_s(fullName, name);
-
-        WIN32_FILE_ATTRIBUTE_DATA fileAttr = {};
-        if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
-        {
-            // Try Current Working Directory (CWD)
-            wcscpy_s(fullName, name);
-            if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
-            {
-                DebugTrace("ERROR: DGSLEffectFactory could not find texture file '%ls'\n", name);
-                throw std::system_error(std::error_code(static_cast<int>(GetLastError()), std::system_category()), "DGSLEffectFactory::CreateTexture");
-            }
-        }
-
-        wchar_t ext[_MAX_EXT] = {};
-        _wsplitpath_s(name, nullptr, 0, nullptr, 0, nullptr, 0, ext, _MAX_EXT);
-        const bool isdds = _wcsicmp(ext, L".dds") == 0;
-
-        if (isdds)
-        {
-            HRESULT hr = CreateDDSTextureFromFileEx(
-                mDevice.Get(), fullName, 0,
-                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
-                mForceSRGB ? DDS_LOADER_FORCE_SRGB : DDS_LOADER_DEFAULT, nullptr, textureView);
-            if (FAILED(hr))
-            {
-                DebugTrace("ERROR: CreateDDSTextureFromFile failed (%08X) for '%ls'\n",
-                    static_cast<unsigned int>(hr), fullName);
-                throw std::runtime_error("DGSLEffectFactory::CreateDDSTextureFromFile");
-            }
-        }
-    #if !defined(_XBOX_ONE) || !defined(_TITLE)
-        else if (deviceContext)
-        {
-            std::lock_guard<std::mutex> lock(mutex);
-            HRESULT hr = CreateWICTextureFromFileEx(
-                mDevice.Get(), deviceContext, fullName, 0,
-                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
-                mForceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
-            if (FAILED(hr))
-            {
-                DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n",
-                    static_cast<unsigned int>(hr), fullName);
-                throw std::runtime_error("DGSLEffectFactory::CreateWICTextureFromFile");
-            }
-        }
-    #endif
-        else
-        {
-            HRESULT hr = CreateWICTextureFromFileEx(
-                mDevice.Get(), fullName, 0,
-                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
-                mForceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
-            if (FAILED(hr))
-            {
-                DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n",
-                    static_cast<unsigned int>(hr), fullName);
-                throw std::runtime_error("DGSLEffectFactory::CreateWICTextureFromFile");
-            }
-        }
-
-        if (mSharing && *name && it == mTextureCache.end())
-        {
-            std::lock_guard<std::mutex> lock(mutex);
-            TextureCache::value_type v(name, *textureView);
-            mTextureCache.insert(v);
-        }
-    }
+    mTextureCache->CreateTexture(mPath, name, mForceSRGB, mSharing, deviceContext, textureView, this, "DGSLEffectFactory");
 }
 
 
@@ -524,7 +445,7 @@ void DGSLEffectFactory::Impl::ReleaseCache()
     std::lock_guard<std::mutex> lock(mutex);
     mEffectCache.clear();
     mEffectCacheSkinning.clear();
-    mTextureCache.clear();
+    mTextureCache->Release(this);
     mShaderCache.clear();
 }
 
@@ -610,6 +531,16 @@ void DGSLEffectFactory::SetDirectory(_In_opt_z_ const wchar_t* path) noexcept
         *pImpl->mPath = 0;
 }
 
+void DGSLEffectFactory::SetTextureCacheBudget(size_t bytes) noexcept
+{
+    pImpl->mTextureCache->SetBudget(bytes);
+}
+
+TextureCacheStatistics DGSLEffectFactory::GetTextureCacheStatistics() const noexcept
+{
+    return pImpl->mTextureCache->GetStatistics();
+}
+
 ID3D11Device* DGSLEffectFactory::GetDevice() const noexcept
 {
     return pImpl->mDevice.Get();
@@ -216,6 +216,26 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<DebugEffectTraits>::DeviceResources> EffectBase<DebugEffectTraits>::deviceResourcesPool = {};
 
 
+// Queues shader permutations for EffectShaderWarmUp.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::WarmUpDebugEffectShaders(ID3D11Device* device, const uint32_t* permutations, size_t count, std::vector<EffectWarmUpTask>& tasks)
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0)
+        return nullptr;
+
+    return EffectBase<DebugEffectTraits>::WarmUpShaders(device, permutations, count, tasks);
+}
+
+_Use_decl_annotations_
+void DirectX::GetDebugEffectUsedPermutations(ID3D11Device* device, std::vector<uint32_t>& permutations)
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0)
+        return;
+
+    EffectBase<DebugEffectTraits>::GetUsedPermutations(device, permutations);
+}
+
+
 // Constructor.
 DebugEffect::Impl::Impl(_In_ ID3D11Device* device)
     : EffectBase(device),
@@ -280,11 +300,7 @@ void DebugEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
     {
         constants.world = XMMatrixTranspose(matrices.world);
 
-        const XMMATRIX worldInverse = XMMatrixInverse(nullptr, matrices.world);
-
-        constants.worldInverseTranspose[0] = worldInverse.r[0];
-        constants.worldInverseTranspose[1] = worldInverse.r[1];
-        constants.worldInverseTranspose[2] = worldInverse.r[2];
+        matrices.GetWorldInverseTranspose(constants.worldInverseTranspose);
 
         dirtyFlags &= ~EffectDirtyFlags::WorldInverseTranspose;
         dirtyFlags |= EffectDirtyFlags::ConstantBuffer;
@@ -323,7 +339,7 @@ void DebugEffect::GetVertexShaderBytecode(_Out_ void const** pShaderByteCode, _O
 // Camera settings.
 void XM_CALLCONV DebugEffect::SetWorld(FXMMATRIX value)
 {
-    pImpl->matrices.world = value;
+    pImpl->matrices.SetWorld(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose;
 }
@@ -331,7 +347,7 @@ void XM_CALLCONV DebugEffect::SetWorld(FXMMATRIX value)
 
 void XM_CALLCONV DebugEffect::SetView(FXMMATRIX value)
 {
-    pImpl->matrices.view = value;
+    pImpl->matrices.SetView(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj;
 }
@@ -347,8 +363,8 @@ void XM_CALLCONV DebugEffect::SetProjection(FXMMATRIX value)
 
 void XM_CALLCONV DebugEffect::SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection)
 {
-    pImpl->matrices.world = world;
-    pImpl->matrices.view = view;
+    pImpl->matrices.SetWorld(world);
+    pImpl->matrices.SetView(view);
     pImpl->matrices.projection = projection;
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose;
@@ -12,23 +12,50 @@
 
 #include "PlatformHelpers.h"
 
+#include <atomic>
+
 
 namespace DirectX
 {
+    // Owning COM pointer for objects created on first use. Readers load it without taking a lock:
+    // Publish stores with release semantics once the object is fully created, and Get loads with
+    // acquire semantics, so a non-null result always refers to a complete object.
+    template<typename T>
+    class AtomicComPtr
+    {
+    public:
+        AtomicComPtr() noexcept : mPtr(nullptr) {}
+
+        AtomicComPtr(AtomicComPtr const&) = delete;
+        AtomicComPtr& operator= (AtomicComPtr const&) = delete;
+
+        ~AtomicComPtr()
+        {
+            T* ptr = mPtr.load(std::memory_order_relaxed);
+            if (ptr)
+                ptr->Release();
+        }
+
+        T* Get() const noexcept { return mPtr.load(std::memory_order_acquire); }
+
+        // Takes ownership of the reference. Must be called with the creation lock held.
+        void Publish(_In_ T* ptr) noexcept
+        {
+            assert(mPtr.load(std::memory_order_relaxed) == nullptr);
+            mPtr.store(ptr, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<T*> mPtr;
+    };
+
+
     // Helper for lazily creating a D3D resource.
     template<typename T, typename TCreateFunc>
-    inline T* DemandCreate(Microsoft::WRL::ComPtr<T>& comPtr, std::mutex& mutex, TCreateFunc createFunc)
+    inline T* DemandCreate(AtomicComPtr<T>& comPtr, std::mutex& mutex, TCreateFunc createFunc)
     {
-        T* result = comPtr.Get();
-
         // Double-checked lock pattern.
-    #ifdef _MSC_VER
-        MemoryBarrier();
-    #elif defined(__GNUC__)
-        __sync_synchronize();
-    #else
-    #error Unknown memory barrier syntax
-    #endif
+        T* result = comPtr.Get();
 
         if (!result)
         {
@@ -43,16 +70,37 @@ namespace DirectX
                     createFunc(&result)
                 );
 
-            #ifdef _MSC_VER
-                MemoryBarrier();
-            #elif defined(__GNUC__)
-                __sync_synchronize();
-            #endif
-
-                comPtr.Attach(result);
+                comPtr.Publish(result);
             }
         }
 
         return result;
     }
+
+
+    // Variant for creating many resources in parallel ahead of first use. The object is created without
+    // holding the lock, and discarded if another thread published one first. Returns S_OK if this call
+    // published the object, S_FALSE if it already existed, or the failure code from createFunc.
+    template<typename T, typename TCreateFunc>
+    inline HRESULT DemandCreateUnlocked(AtomicComPtr<T>& comPtr, std::mutex& mutex, TCreateFunc createFunc)
+    {
+        if (comPtr.Get())
+            return S_FALSE;
+
+        T* created = nullptr;
+        const HRESULT hr = createFunc(&created);
+        if (FAILED(hr))
+            return hr;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (comPtr.Get())
+        {
+            created->Release();
+            return S_FALSE;
+        }
+
+        comPtr.Publish(created);
+        return S_OK;
+    }
 }
@@ -124,6 +124,20 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<DualTextureEffectTraits>::DeviceResources> EffectBase<DualTextureEffectTraits>::deviceResourcesPool = {};
 
 
+// Queues shader permutations for EffectShaderWarmUp.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::WarmUpDualTextureEffectShaders(ID3D11Device* device, const uint32_t* permutations, size_t count, std::vector<EffectWarmUpTask>& tasks)
+{
+    return EffectBase<DualTextureEffectTraits>::WarmUpShaders(device, permutations, count, tasks);
+}
+
+_Use_decl_annotations_
+void DirectX::GetDualTextureEffectUsedPermutations(ID3D11Device* device, std::vector<uint32_t>& permutations)
+{
+    EffectBase<DualTextureEffectTraits>::GetUsedPermutations(device, permutations);
+}
+
+
 // Constructor.
 DualTextureEffect::Impl::Impl(_In_ ID3D11Device* device)
     : EffectBase(device),
@@ -161,6 +175,8 @@ void DualTextureEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
     assert(deviceContext != nullptr);
 
+    StateFilter filter(deviceContext);
+
     // Compute derived parameter values.
     matrices.SetConstants(dirtyFlags, constants.worldViewProj);
 
@@ -175,7 +191,7 @@ void DualTextureEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
         texture2.Get(),
     };
 
-    deviceContext->PSSetShaderResources(0, 2, textures);
+    filter.PSSetShaderResources(0, 2, textures);
 
     // Set shaders and constant buffers.
     ApplyShaders(deviceContext, GetCurrentShaderPermutation());
@@ -210,7 +226,7 @@ void DualTextureEffect::GetVertexShaderBytecode(_Out_ void const** pShaderByteCo
 // Camera settings.
 void XM_CALLCONV DualTextureEffect::SetWorld(FXMMATRIX value)
 {
-    pImpl->matrices.world = value;
+    pImpl->matrices.SetWorld(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::FogVector;
 }
@@ -218,7 +234,7 @@ void XM_CALLCONV DualTextureEffect::SetWorld(FXMMATRIX value)
 
 void XM_CALLCONV DualTextureEffect::SetView(FXMMATRIX value)
 {
-    pImpl->matrices.view = value;
+    pImpl->matrices.SetView(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
 }
@@ -234,8 +250,8 @@ void XM_CALLCONV DualTextureEffect::SetProjection(FXMMATRIX value)
 
 void XM_CALLCONV DualTextureEffect::SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection)
 {
-    pImpl->matrices.world = world;
-    pImpl->matrices.view = view;
+    pImpl->matrices.SetWorld(world);
+    pImpl->matrices.SetView(view);
     pImpl->matrices.projection = projection;
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
@@ -24,6 +24,110 @@ void XM_CALLCONV IEffectMatrices::SetMatrices(FXMMATRIX world, CXMMATRIX view, C
 }
 
 
+void IEffectMatrices::SetCamera(const EffectCamera& camera)
+{
+    SetView(camera.GetView());
+    SetProjection(camera.GetProjection());
+}
+
+
+void IEffectMatrices::SetWorldTransform(const EffectWorldTransform& transform)
+{
+    SetWorld(XMLoadFloat4x4(&transform.world));
+}
+
+
+// Inverse for the common case of rotation, uniform scale, and translation, which is the
+// transpose of the upper 3x3 divided by the squared scale. Anything else uses the general inverse.
+XMMATRIX XM_CALLCONV DirectX::FastMatrixInverse(FXMMATRIX value) noexcept
+{
+    static const XMVECTORF32 c_lastColumn = { { { 0.f, 0.f, 0.f, 1.f } } };
+
+    const XMVECTOR lastColumn = XMVectorSet(
+        XMVectorGetW(value.r[0]), XMVectorGetW(value.r[1]), XMVectorGetW(value.r[2]), XMVectorGetW(value.r[3]));
+
+    const XMVECTOR r0 = XMVectorAndInt(value.r[0], g_XMMask3);
+    const XMVECTOR r1 = XMVectorAndInt(value.r[1], g_XMMask3);
+    const XMVECTOR r2 = XMVectorAndInt(value.r[2], g_XMMask3);
+
+    const XMVECTOR lengthSq = XMVector3LengthSq(r0);
+    const XMVECTOR epsilon = XMVectorMultiply(lengthSq, XMVectorReplicate(1e-5f));
+
+    if (XMVector4Equal(lastColumn, c_lastColumn)
+        && XMVectorGetX(lengthSq) > 0.f
+        && XMVector3NearEqual(XMVector3LengthSq(r1), lengthSq, epsilon)
+        && XMVector3NearEqual(XMVector3LengthSq(r2), lengthSq, epsilon)
+        && XMVector3NearEqual(XMVector3Dot(r0, r1), g_XMZero, epsilon)
+        && XMVector3NearEqual(XMVector3Dot(r0, r2), g_XMZero, epsilon)
+        && XMVector3NearEqual(XMVector3Dot(r1, r2), g_XMZero, epsilon))
+    {
+        const XMVECTOR invLengthSq = XMVectorReciprocal(lengthSq);
+
+        XMMATRIX upper(r0, r1, r2, g_XMIdentityR3);
+        upper = XMMatrixTranspose(upper);
+        upper.r[0] = XMVectorAndInt(XMVectorMultiply(upper.r[0], invLengthSq), g_XMMask3);
+        upper.r[1] = XMVectorAndInt(XMVectorMultiply(upper.r[1], invLengthSq), g_XMMask3);
+        upper.r[2] = XMVectorAndInt(XMVectorMultiply(upper.r[2], invLengthSq), g_XMMask3);
+
+        // -t * upper
+        XMVECTOR translation = XMVectorMultiply(XMVectorSplatX(value.r[3]), upper.r[0]);
+        translation = XMVectorMultiplyAdd(XMVectorSplatY(value.r[3]), upper.r[1], translation);
+        translation = XMVectorMultiplyAdd(XMVectorSplatZ(value.r[3]), upper.r[2], translation);
+        upper.r[3] = XMVectorSelect(g_XMIdentityR3, XMVectorNegate(translation), g_XMSelect1110);
+
+        return upper;
+    }
+
+    return XMMatrixInverse(nullptr, value);
+}
+
+
+// EffectCamera precomputes the eye position once for all the effects it is applied to.
+EffectCamera::EffectCamera() noexcept :
+    mEyePosition(0.f, 0.f, 0.f, 1.f)
+{
+    XMStoreFloat4x4(&mView, XMMatrixIdentity());
+    XMStoreFloat4x4(&mProjection, XMMatrixIdentity());
+}
+
+
+EffectCamera::EffectCamera(FXMMATRIX view, CXMMATRIX projection) noexcept
+{
+    SetView(view);
+    SetProjection(projection);
+}
+
+
+void XM_CALLCONV EffectCamera::SetView(FXMMATRIX value) noexcept
+{
+    XMStoreFloat4x4(&mView, value);
+    XMStoreFloat4(&mEyePosition, FastMatrixInverse(value).r[3]);
+}
+
+
+void XM_CALLCONV EffectCamera::SetProjection(FXMMATRIX value) noexcept
+{
+    XMStoreFloat4x4(&mProjection, value);
+}
+
+
+// Prepares the world matrices of many objects in a single pass.
+_Use_decl_annotations_
+void DirectX::ComputeEffectWorldTransforms(const XMFLOAT4X4* worlds, size_t count, EffectWorldTransform* transforms) noexcept
+{
+    for (size_t j = 0; j < count; ++j)
+    {
+        const XMMATRIX world = XMLoadFloat4x4(&worlds[j]);
+        const XMMATRIX worldInverse = FastMatrixInverse(world);
+
+        transforms[j].world = worlds[j];
+
+        // Rows 0..2 of the inverse, which the shaders use as the columns of the inverse transpose.
+        XMStoreFloat3x4(&transforms[j].worldInverseTranspose, XMMatrixTranspose(worldInverse));
+    }
+}
+
+
 // Constructor initializes default matrix values.
 EffectMatrices::EffectMatrices() noexcept
 {
@@ -32,6 +136,63 @@ EffectMatrices::EffectMatrices() noexcept
     view = id;
     projection = id;
     worldView = id;
+    eyePosition = g_XMIdentityR3;
+    worldInverseTranspose[0] = id.r[0];
+    worldInverseTranspose[1] = id.r[1];
+    worldInverseTranspose[2] = id.r[2];
+    eyePositionValid = true;
+    worldInverseTransposeValid = true;
+}
+
+
+void EffectMatrices::SetCamera(const EffectCamera& camera) noexcept
+{
+    view = camera.GetView();
+    projection = camera.GetProjection();
+    eyePosition = camera.GetEyePosition();
+    eyePositionValid = true;
+}
+
+
+void EffectMatrices::SetWorldTransform(const EffectWorldTransform& transform) noexcept
+{
+    world = XMLoadFloat4x4(&transform.world);
+
+    // XMFLOAT3X4 holds the transpose, so transposing back yields the inverse rows.
+    const XMMATRIX worldInverse = XMMatrixTranspose(XMLoadFloat3x4(&transform.worldInverseTranspose));
+    worldInverseTranspose[0] = worldInverse.r[0];
+    worldInverseTranspose[1] = worldInverse.r[1];
+    worldInverseTranspose[2] = worldInverse.r[2];
+    worldInverseTransposeValid = true;
+}
+
+
+XMVECTOR EffectMatrices::GetEyePosition() const noexcept
+{
+    if (eyePositionValid)
+        return eyePosition;
+
+    return FastMatrixInverse(view).r[3];
+}
+
+
+_Use_decl_annotations_
+void EffectMatrices::GetWorldInverseTranspose(XMVECTOR value[3]) const noexcept
+{
+    if (worldInverseTransposeValid)
+    {
+        value[0] = worldInverseTranspose[0];
+        value[1] = worldInverseTranspose[1];
+        value[2] = worldInverseTranspose[2];
+    }
+    else
+    {
+        const XMMATRIX worldInverse = FastMatrixInverse(world);
+
+        value[0] = worldInverse.r[0];
+        value[1] = worldInverse.r[1];
+        value[2] = worldInverse.r[2];
+    }
 }
 
 
@@ -189,11 +350,7 @@ _Use_decl_annotations_ void EffectLights::SetConstants(int& dirtyFlags, EffectMa
         {
             worldConstant = XMMatrixTranspose(matrices.world);
 
-            const XMMATRIX worldInverse = XMMatrixInverse(nullptr, matrices.world);
-
-            worldInverseTransposeConstant[0] = worldInverse.r[0];
-            worldInverseTransposeConstant[1] = worldInverse.r[1];
-            worldInverseTransposeConstant[2] = worldInverse.r[2];
+            matrices.GetWorldInverseTranspose(worldInverseTransposeConstant);
 
             dirtyFlags &= ~EffectDirtyFlags::WorldInverseTranspose;
             dirtyFlags |= EffectDirtyFlags::ConstantBuffer;
@@ -202,9 +359,7 @@ _Use_decl_annotations_ void EffectLights::SetConstants(int& dirtyFlags, EffectMa
         // Eye position vector.
         if (dirtyFlags & EffectDirtyFlags::EyePosition)
         {
-            XMMATRIX viewInverse = XMMatrixInverse(nullptr, matrices.view);
-
-            eyePositionConstant = viewInverse.r[3];
+            eyePositionConstant = matrices.GetEyePosition();
 
             dirtyFlags &= ~EffectDirtyFlags::EyePosition;
             dirtyFlags |= EffectDirtyFlags::ConstantBuffer;
@@ -386,7 +541,7 @@ void EffectLights::EnableDefaultLighting(_In_ IEffectLights* effect)
 
 
 // Gets or lazily creates the specified vertex shader permutation.
-ID3D11VertexShader* EffectDeviceResources::DemandCreateVertexShader(_Inout_ ComPtr<ID3D11VertexShader>& vertexShader, ShaderBytecode const& bytecode)
+ID3D11VertexShader* EffectDeviceResources::DemandCreateVertexShader(_Inout_ AtomicComPtr<ID3D11VertexShader>& vertexShader, ShaderBytecode const& bytecode)
 {
     return DemandCreate(vertexShader, mMutex, [&](ID3D11VertexShader** pResult) -> HRESULT
         {
@@ -401,7 +556,7 @@ ID3D11VertexShader* EffectDeviceResources::DemandCreateVertexShader(_Inout_ ComP
 
 
 // Gets or lazily creates the specified pixel shader permutation.
-ID3D11PixelShader* EffectDeviceResources::DemandCreatePixelShader(_Inout_ ComPtr<ID3D11PixelShader>& pixelShader, ShaderBytecode const& bytecode)
+ID3D11PixelShader* EffectDeviceResources::DemandCreatePixelShader(_Inout_ AtomicComPtr<ID3D11PixelShader>& pixelShader, ShaderBytecode const& bytecode)
 {
     return DemandCreate(pixelShader, mMutex, [&](ID3D11PixelShader** pResult) -> HRESULT
         {
@@ -415,6 +570,58 @@ ID3D11PixelShader* EffectDeviceResources::DemandCreatePixelShader(_Inout_ ComPtr
 }
 
 
+namespace
+{
+    EffectWarmUpResult WarmUpResult(HRESULT hr, D3D_FEATURE_LEVEL featureLevel)
+    {
+        if (hr == S_FALSE)
+            return EffectWarmUpResult::Existing;
+
+        // Some permutations use shader models beyond what 9.x devices support.
+        if (FAILED(hr) && featureLevel < D3D_FEATURE_LEVEL_10_0)
+            return EffectWarmUpResult::Unsupported;
+
+        ThrowIfFailed(hr);
+
+        return EffectWarmUpResult::Created;
+    }
+}
+
+
+// Creates the specified vertex shader ahead of first use.
+EffectWarmUpResult EffectDeviceResources::WarmUpVertexShader(_Inout_ AtomicComPtr<ID3D11VertexShader>& vertexShader, ShaderBytecode const& bytecode)
+{
+    const HRESULT result = DemandCreateUnlocked(vertexShader, mMutex, [&](ID3D11VertexShader** pResult) -> HRESULT
+        {
+            HRESULT hr = mDevice->CreateVertexShader(bytecode.code, bytecode.length, nullptr, pResult);
+
+            if (SUCCEEDED(hr))
+                SetDebugObjectName(*pResult, "DirectXTK:Effect");
+
+            return hr;
+        });
+
+    return WarmUpResult(result, mDevice->GetFeatureLevel());
+}
+
+
+// Creates the specified pixel shader ahead of first use.
+EffectWarmUpResult EffectDeviceResources::WarmUpPixelShader(_Inout_ AtomicComPtr<ID3D11PixelShader>& pixelShader, ShaderBytecode const& bytecode)
+{
+    const HRESULT result = DemandCreateUnlocked(pixelShader, mMutex, [&](ID3D11PixelShader** pResult) -> HRESULT
+        {
+            HRESULT hr = mDevice->CreatePixelShader(bytecode.code, bytecode.length, nullptr, pResult);
+
+            if (SUCCEEDED(hr))
+                SetDebugObjectName(*pResult, "DirectXTK:Effect");
+
+            return hr;
+        });
+
+    return WarmUpResult(result, mDevice->GetFeatureLevel());
+}
+
+
 // Gets or lazily creates the default texture
 ID3D11ShaderResourceView* EffectDeviceResources::GetDefaultTexture()
 {
@@ -14,9 +14,12 @@
 #include "Effects.h"
 #include "AlignedNew.h"
 #include "BufferHelpers.h"
+#include "DemandCreate.h"
 #include "DirectXHelpers.h"
+#include "GraphicsMemory.h"
 #include "PlatformHelpers.h"
 #include "SharedResourcePool.h"
+#include "StateFilter.h"
 
 
 // BasicEffect, SkinnedEffect, et al, have many things in common, but also significant
@@ -51,10 +54,38 @@ namespace DirectX
         XMMATRIX projection;
         XMMATRIX worldView;
 
+        // Values derived from world and view, kept when supplied precomputed by the application.
+        XMVECTOR eyePosition;
+        XMVECTOR worldInverseTranspose[3];
+        bool eyePositionValid;
+        bool worldInverseTransposeValid;
+
+        void XM_CALLCONV SetWorld(FXMMATRIX value) noexcept
+        {
+            world = value;
+            worldInverseTransposeValid = false;
+        }
+
+        void XM_CALLCONV SetView(FXMMATRIX value) noexcept
+        {
+            view = value;
+            eyePositionValid = false;
+        }
+
+        void SetCamera(const EffectCamera& camera) noexcept;
+        void SetWorldTransform(const EffectWorldTransform& transform) noexcept;
+
+        XMVECTOR GetEyePosition() const noexcept;
+        void GetWorldInverseTranspose(_Out_writes_(3) XMVECTOR value[3]) const noexcept;
+
         void SetConstants(_Inout_ int& dirtyFlags, _Inout_ XMMATRIX& worldViewProjConstant);
     };
 
 
+    // Inverts a matrix, taking a cheaper path for rotation, uniform scale, and translation.
+    XMMATRIX XM_CALLCONV FastMatrixInverse(FXMMATRIX value) noexcept;
+
+
     // Helper stores the current fog settings, and computes derived shader parameters.
     struct EffectFog
     {
@@ -118,6 +149,17 @@ namespace DirectX
     };
 
 
+    // Outcome of creating one shader ahead of first use.
+    enum class EffectWarmUpResult
+    {
+        Created,
+        Existing,
+        Unsupported,
+    };
+
+    using EffectWarmUpTask = std::function<EffectWarmUpResult()>;
+
+
     // Factory for lazily instantiating shaders. BasicEffect supports many different
     // shader permutations, so we only bother creating the ones that are actually used.
     class EffectDeviceResources
@@ -128,16 +170,20 @@ namespace DirectX
         {
         }
 
-        ID3D11VertexShader* DemandCreateVertexShader(_Inout_ Microsoft::WRL::ComPtr<ID3D11VertexShader>& vertexShader, ShaderBytecode const& bytecode);
-        ID3D11PixelShader * DemandCreatePixelShader(_Inout_ Microsoft::WRL::ComPtr<ID3D11PixelShader> & pixelShader, ShaderBytecode const& bytecode);
+        ID3D11VertexShader* DemandCreateVertexShader(_Inout_ AtomicComPtr<ID3D11VertexShader>& vertexShader, ShaderBytecode const& bytecode);
+        ID3D11PixelShader * DemandCreatePixelShader(_Inout_ AtomicComPtr<ID3D11PixelShader>& pixelShader, ShaderBytecode const& bytecode);
+
+        // Variants for warm-up, which create the shader without holding the lock so many can be created in parallel.
+        EffectWarmUpResult WarmUpVertexShader(_Inout_ AtomicComPtr<ID3D11VertexShader>& vertexShader, ShaderBytecode const& bytecode);
+        EffectWarmUpResult WarmUpPixelShader(_Inout_ AtomicComPtr<ID3D11PixelShader>& pixelShader, ShaderBytecode const& bytecode);
         ID3D11ShaderResourceView* GetDefaultTexture();
         ID3D11ShaderResourceView* GetDefaultNormalTexture();
         D3D_FEATURE_LEVEL GetDeviceFeatureLevel() const;
 
     protected:
         Microsoft::WRL::ComPtr<ID3D11Device> mDevice;
-        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> mDefaultTexture;
-        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> mDefaultNormalTexture;
+        AtomicComPtr<ID3D11ShaderResourceView> mDefaultTexture;
+        AtomicComPtr<ID3D11ShaderResourceView> mDefaultNormalTexture;
 
         std::mutex mMutex;
     };
@@ -151,8 +197,13 @@ namespace DirectX
         // Constructor.
         EffectBase(_In_ ID3D11Device* device)
             : constants{},
+            constantsSize(sizeof(constants)),
             dirtyFlags(INT_MAX),
             mConstantBuffer(device),
+        #if !(defined(_XBOX_ONE) && defined(_TITLE))
+            mConstantAllocation{},
+            mConstantBufferStale(false),
+        #endif
             mDeviceResources(deviceResourcesPool.DemandCreate(device))
         {
             SetDebugObjectName(mConstantBuffer.GetBuffer(), "Effect");
@@ -167,6 +218,10 @@ namespace DirectX
         // Fields.
         typename Traits::ConstantBufferType constants;
 
+        // Leading bytes of 'constants' read by the current shaders. Effects whose trailing arrays
+        // are only partly in use lower this to upload less.
+        size_t constantsSize;
+
         EffectMatrices matrices;
         EffectFog fog;
 
@@ -193,6 +248,59 @@ namespace DirectX
         }
 
 
+        // Queues the creation of the shaders of this effect type, every one of them or only those
+        // the listed permutations use, returning the per-device resources that will hold them.
+        static std::shared_ptr<void> WarmUpShaders(
+            _In_ ID3D11Device* device,
+            _In_reads_opt_(count) const uint32_t* permutations, size_t count,
+            _Inout_ std::vector<EffectWarmUpTask>& tasks)
+        {
+            bool vertexShaders[Traits::VertexShaderCount] = {};
+            bool pixelShaders[Traits::PixelShaderCount] = {};
+
+            if (permutations)
+            {
+                for (size_t j = 0; j < count; ++j)
+                {
+                    if (permutations[j] >= static_cast<uint32_t>(Traits::ShaderPermutationCount))
+                        throw std::out_of_range("Invalid shader permutation");
+
+                    vertexShaders[VertexShaderIndices[permutations[j]]] = true;
+                    pixelShaders[PixelShaderIndices[permutations[j]]] = true;
+                }
+            }
+            else
+            {
+                std::fill(std::begin(vertexShaders), std::end(vertexShaders), true);
+                std::fill(std::begin(pixelShaders), std::end(pixelShaders), true);
+            }
+
+            auto resources = deviceResourcesPool.DemandCreate(device);
+            auto ptr = resources.get();
+
+            for (int j = 0; j < Traits::VertexShaderCount; ++j)
+            {
+                if (vertexShaders[j])
+                    tasks.emplace_back([ptr, j]() { return ptr->WarmUpVertexShader(j); });
+            }
+
+            for (int j = 0; j < Traits::PixelShaderCount; ++j)
+            {
+                if (pixelShaders[j])
+                    tasks.emplace_back([ptr, j]() { return ptr->WarmUpPixelShader(j); });
+            }
+
+            return resources;
+        }
+
+
+        // Appends the permutations that effects of this type have applied on the device.
+        static void GetUsedPermutations(_In_ ID3D11Device* device, _Inout_ std::vector<uint32_t>& permutations)
+        {
+            deviceResourcesPool.DemandCreate(device)->GetUsedPermutations(permutations);
+        }
+
+
         // Helper sets our shaders and constant buffers onto the D3D device.
         void ApplyShaders(_In_ ID3D11DeviceContext* deviceContext, int permutation)
         {
@@ -200,8 +308,10 @@ namespace DirectX
             auto vertexShader = mDeviceResources->GetVertexShader(permutation);
             auto pixelShader = mDeviceResources->GetPixelShader(permutation);
 
-            deviceContext->VSSetShader(vertexShader, nullptr, 0);
-            deviceContext->PSSetShader(pixelShader, nullptr, 0);
+            StateFilter filter(deviceContext);
+
+            filter.VSSetShader(vertexShader, nullptr, 0);
+            filter.PSSetShader(pixelShader, nullptr, 0);
 
         #if defined(_XBOX_ONE) && defined(_TITLE)
             void *grfxMemory;
@@ -215,19 +325,53 @@ namespace DirectX
             deviceContextX->VSSetPlacementConstantBuffer(0, buffer, grfxMemory);
             deviceContextX->PSSetPlacementConstantBuffer(0, buffer, grfxMemory);
         #else
-                    // Make sure the constant buffer is up to date.
-            if (dirtyFlags & EffectDirtyFlags::ConstantBuffer)
+            // With the constant ring enabled, constants are written to the per-frame ring when they
+            // change, or when the previous allocation expires, and bound by offset.
+            if (auto ring = GraphicsMemory::GetConstantRing())
             {
-                mConstantBuffer.SetData(deviceContext, constants);
+                if ((dirtyFlags & EffectDirtyFlags::ConstantBuffer)
+                    || mConstantAllocation.generation != ring->GetConstantRingGeneration())
+                {
+                    if (!ring->AllocateConstants(deviceContext, &constants, constantsSize, mConstantAllocation))
+                    {
+                        mConstantAllocation = {};
+                    }
+                }
+
+                if (ring->BindConstants(deviceContext, 0, mConstantAllocation))
+                {
+                    dirtyFlags &= ~EffectDirtyFlags::ConstantBuffer;
+                    mConstantBufferStale = true;
+                    return;
+                }
+            }
+
+            // Make sure the constant buffer is up to date.
+            if ((dirtyFlags & EffectDirtyFlags::ConstantBuffer) || mConstantBufferStale)
+            {
+                if (constantsSize < sizeof(constants))
+                {
+                    D3D11_MAPPED_SUBRESOURCE mapped;
+                    ThrowIfFailed(deviceContext->Map(mConstantBuffer.GetBuffer(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+
+                    memcpy(mapped.pData, &constants, constantsSize);
+
+                    deviceContext->Unmap(mConstantBuffer.GetBuffer(), 0);
+                }
+                else
+                {
+                    mConstantBuffer.SetData(deviceContext, constants);
+                }
 
                 dirtyFlags &= ~EffectDirtyFlags::ConstantBuffer;
+                mConstantBufferStale = false;
             }
 
             // Set the constant buffer.
             ID3D11Buffer* buffer = mConstantBuffer.GetBuffer();
 
-            deviceContext->VSSetConstantBuffers(0, 1, &buffer);
-            deviceContext->PSSetConstantBuffers(0, 1, &buffer);
+            filter.VSSetConstantBuffers(0, 1, &buffer);
+            filter.PSSetConstantBuffers(0, 1, &buffer);
         #endif
         }
 
@@ -250,6 +394,13 @@ namespace DirectX
         // D3D constant buffer holds a copy of the same data as the public 'constants' field.
         ConstantBuffer<typename Traits::ConstantBufferType> mConstantBuffer;
 
+    #if !(defined(_XBOX_ONE) && defined(_TITLE))
+        // Location of the constants in the GraphicsMemory constant ring, and whether mConstantBuffer
+        // missed updates made while the ring was in use.
+        GraphicsMemory::ConstantAllocation mConstantAllocation;
+        bool mConstantBufferStale;
+    #endif
+
         // Only one of these helpers is allocated per D3D device, even if there are multiple effect instances.
         class DeviceResources : protected EffectDeviceResources
         {
@@ -258,7 +409,12 @@ namespace DirectX
                 : EffectDeviceResources(device),
                 mVertexShaders{},
                 mPixelShaders{}
-            { }
+            {
+                for (auto& it : mUsedPermutations)
+                {
+                    it.store(0, std::memory_order_relaxed);
+                }
+            }
 
 
             // Gets or lazily creates the specified vertex shader permutation.
@@ -270,6 +426,14 @@ namespace DirectX
                 assert(shaderIndex >= 0 && shaderIndex < Traits::VertexShaderCount);
                 _Analysis_assume_(shaderIndex >= 0 && shaderIndex < Traits::VertexShaderCount);
 
+                // Remember the permutation for EffectShaderWarmUp, writing only the first time.
+                auto& used = mUsedPermutations[permutation / 32];
+                const uint32_t bit = 1u << (permutation % 32);
+                if (!(used.load(std::memory_order_relaxed) & bit))
+                {
+                    used.fetch_or(bit, std::memory_order_relaxed);
+                }
+
                 return DemandCreateVertexShader(mVertexShaders[shaderIndex], VertexShaderBytecode[shaderIndex]);
             }
 
@@ -287,14 +451,44 @@ namespace DirectX
             }
 
 
+            // Creates the specified shaders ahead of first use.
+            EffectWarmUpResult WarmUpVertexShader(int shaderIndex)
+            {
+                assert(shaderIndex >= 0 && shaderIndex < Traits::VertexShaderCount);
+                _Analysis_assume_(shaderIndex >= 0 && shaderIndex < Traits::VertexShaderCount);
+
+                return EffectDeviceResources::WarmUpVertexShader(mVertexShaders[shaderIndex], VertexShaderBytecode[shaderIndex]);
+            }
+
+            EffectWarmUpResult WarmUpPixelShader(int shaderIndex)
+            {
+                assert(shaderIndex >= 0 && shaderIndex < Traits::PixelShaderCount);
+                _Analysis_assume_(shaderIndex >= 0 && shaderIndex < Traits::PixelShaderCount);
+
+                return EffectDeviceResources::WarmUpPixelShader(mPixelShaders[shaderIndex], PixelShaderBytecode[shaderIndex]);
+            }
+
+            void GetUsedPermutations(_Inout_ std::vector<uint32_t>& permutations) const
+            {
+                for (uint32_t j = 0; j < static_cast<uint32_t>(Traits::ShaderPermutationCount); ++j)
+                {
+                    if (mUsedPermutations[j / 32].load(std::memory_order_relaxed) & (1u << (j % 32)))
+                    {
+                        permutations.push_back(j);
+                    }
+                }
+            }
+
+
             // Helpers
             ID3D11ShaderResourceView* GetDefaultTexture() { return EffectDeviceResources::GetDefaultTexture(); }
             ID3D11ShaderResourceView* GetDefaultNormalTexture() { return EffectDeviceResources::GetDefaultNormalTexture(); }
             D3D_FEATURE_LEVEL GetDeviceFeatureLevel() const { return EffectDeviceResources::GetDeviceFeatureLevel(); }
 
         private:
-            Microsoft::WRL::ComPtr<ID3D11VertexShader> mVertexShaders[Traits::VertexShaderCount];
-            Microsoft::WRL::ComPtr<ID3D11PixelShader> mPixelShaders[Traits::PixelShaderCount];
+            AtomicComPtr<ID3D11VertexShader> mVertexShaders[Traits::VertexShaderCount];
+            AtomicComPtr<ID3D11PixelShader> mPixelShaders[Traits::PixelShaderCount];
+            std::atomic<uint32_t> mUsedPermutations[(Traits::ShaderPermutationCount + 31) / 32];
         };
 
 
@@ -303,4 +497,25 @@ namespace DirectX
 
         static SharedResourcePool<ID3D11Device*, DeviceResources> deviceResourcesPool;
     };
+
+
+    // Per effect type entry points for EffectShaderWarmUp, defined alongside each effect. A null
+    // permutations list queues every shader of the type.
+    std::shared_ptr<void> WarmUpBasicEffectShaders(_In_ ID3D11Device* device, _In_reads_opt_(count) const uint32_t* permutations, size_t count, _Inout_ std::vector<EffectWarmUpTask>& tasks);
+    std::shared_ptr<void> WarmUpAlphaTestEffectShaders(_In_ ID3D11Device* device, _In_reads_opt_(count) const uint32_t* permutations, size_t count, _Inout_ std::vector<EffectWarmUpTask>& tasks);
+    std::shared_ptr<void> WarmUpDualTextureEffectShaders(_In_ ID3D11Device* device, _In_reads_opt_(count) const uint32_t* permutations, size_t count, _Inout_ std::vector<EffectWarmUpTask>& tasks);
+    std::shared_ptr<void> WarmUpEnvironmentMapEffectShaders(_In_ ID3D11Device* device, _In_reads_opt_(count) const uint32_t* permutations, size_t count, _Inout_ std::vector<EffectWarmUpTask>& tasks);
+    std::shared_ptr<void> WarmUpSkinnedEffectShaders(_In_ ID3D11Device* device, _In_reads_opt_(count) const uint32_t* permutations, size_t count, _Inout_ std::vector<EffectWarmUpTask>& tasks);
+    std::shared_ptr<void> WarmUpNormalMapEffectShaders(_In_ ID3D11Device* device, _In_reads_opt_(count) const uint32_t* permutations, size_t count, _Inout_ std::vector<EffectWarmUpTask>& tasks);
+    std::shared_ptr<void> WarmUpPBREffectShaders(_In_ ID3D11Device* device, _In_reads_opt_(count) const uint32_t* permutations, size_t count, _Inout_ std::vector<EffectWarmUpTask>& tasks);
+    std::shared_ptr<void> WarmUpDebugEffectShaders(_In_ ID3D11Device* device, _In_reads_opt_(count) const uint32_t* permutations, size_t count, _Inout_ std::vector<EffectWarmUpTask>& tasks);
+
+    void GetBasicEffectUsedPermutations(_In_ ID3D11Device* device, _Inout_ std::vector<uint32_t>& permutations);
+    void GetAlphaTestEffectUsedPermutations(_In_ ID3D11Device* device, _Inout_ std::vector<uint32_t>& permutations);
+    void GetDualTextureEffectUsedPermutations(_In_ ID3D11Device* device, _Inout_ std::vector<uint32_t>& permutations);
+    void GetEnvironmentMapEffectUsedPermutations(_In_ ID3D11Device* device, _Inout_ std::vector<uint32_t>& permutations);
+    void GetSkinnedEffectUsedPermutations(_In_ ID3D11Device* device, _Inout_ std::vector<uint32_t>& permutations);
+    void GetNormalMapEffectUsedPermutations(_In_ ID3D11Device* device, _Inout_ std::vector<uint32_t>& permutations);
+    void GetPBREffectUsedPermutations(_In_ ID3D11Device* device, _Inout_ std::vector<uint32_t>& permutations);
+    void GetDebugEffectUsedPermutations(_In_ ID3D11Device* device, _Inout_ std::vector<uint32_t>& permutations);
 }
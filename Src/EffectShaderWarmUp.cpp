@@ -0,0 +1,230 @@
+//--------------------------------------------------------------------------------------
+// File: EffectShaderWarmUp.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "EffectCommon.h"
+#include "ParallelFor.h"
+
+#include <atomic>
+#include <chrono>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+
+namespace
+{
+    using WarmUpFunction = std::shared_ptr<void>(*)(_In_ ID3D11Device*, _In_reads_opt_(count) const uint32_t*, size_t count, _Inout_ std::vector<EffectWarmUpTask>&);
+    using UsedPermutationsFunction = void(*)(_In_ ID3D11Device*, _Inout_ std::vector<uint32_t>&);
+
+    struct EffectWarmUpEntry
+    {
+        uint32_t                    flag;
+        WarmUpFunction              function;
+        UsedPermutationsFunction    usedPermutations;
+    };
+
+    const EffectWarmUpEntry s_effects[] =
+    {
+        { EffectWarmUp_BasicEffect,             WarmUpBasicEffectShaders,           GetBasicEffectUsedPermutations },
+        { EffectWarmUp_AlphaTestEffect,         WarmUpAlphaTestEffectShaders,       GetAlphaTestEffectUsedPermutations },
+        { EffectWarmUp_DualTextureEffect,       WarmUpDualTextureEffectShaders,     GetDualTextureEffectUsedPermutations },
+        { EffectWarmUp_EnvironmentMapEffect,    WarmUpEnvironmentMapEffectShaders,  GetEnvironmentMapEffectUsedPermutations },
+        { EffectWarmUp_SkinnedEffect,           WarmUpSkinnedEffectShaders,         GetSkinnedEffectUsedPermutations },
+        { EffectWarmUp_NormalMapEffect,         WarmUpNormalMapEffectShaders,       GetNormalMapEffectUsedPermutations },
+        { EffectWarmUp_PBREffect,               WarmUpPBREffectShaders,             GetPBREffectUsedPermutations },
+        { EffectWarmUp_DebugEffect,             WarmUpDebugEffectShaders,           GetDebugEffectUsedPermutations },
+    };
+}
+
+
+//======================================================================================
+// EffectShaderWarmUp
+//======================================================================================
+
+class EffectShaderWarmUp::Impl
+{
+public:
+    explicit Impl(_In_ ID3D11Device* device) :
+        mDevice(device)
+    {
+        if (!device)
+            throw std::invalid_argument("Direct3D device is null");
+    }
+
+    Statistics WarmUp(uint32_t effects, const ProgressCallback& progress, size_t maxWorkers)
+    {
+        if (effects & ~static_cast<uint32_t>(EffectWarmUp_All))
+            throw std::invalid_argument("Unknown effect warm-up flags");
+
+        const auto start = std::chrono::steady_clock::now();
+
+        // Gather the shaders of every selected effect type. The device resources that own them
+        // are retained here so they outlive the call even if no effect of that type exists yet.
+        std::vector<EffectWarmUpTask> tasks;
+
+        for (const auto& it : s_effects)
+        {
+            if (!(effects & it.flag))
+                continue;
+
+            Retain(it.flag, it.function(mDevice.Get(), nullptr, 0, tasks));
+        }
+
+        return Run(tasks, progress, maxWorkers, start);
+    }
+
+    Statistics WarmUp(_In_reads_(count) const Permutation* permutations, size_t count, const ProgressCallback& progress, size_t maxWorkers)
+    {
+        if (!permutations && count > 0)
+            throw std::invalid_argument("Invalid permutation list");
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            const uint32_t flag = permutations[j].effect;
+            if (!flag || (flag & (flag - 1)) || (flag & ~static_cast<uint32_t>(EffectWarmUp_All)))
+                throw std::invalid_argument("Permutation effect must be a single effect warm-up flag");
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+
+        std::vector<EffectWarmUpTask> tasks;
+        std::vector<uint32_t> selected;
+
+        for (const auto& it : s_effects)
+        {
+            selected.clear();
+
+            for (size_t j = 0; j < count; ++j)
+            {
+                if (permutations[j].effect == it.flag)
+                {
+                    selected.push_back(permutations[j].permutation);
+                }
+            }
+
+            if (selected.empty())
+                continue;
+
+            Retain(it.flag, it.function(mDevice.Get(), selected.data(), selected.size(), tasks));
+        }
+
+        return Run(tasks, progress, maxWorkers, start);
+    }
+
+    void GetUsedPermutations(std::vector<Permutation>& permutations) const
+    {
+        std::vector<uint32_t> used;
+
+        for (const auto& it : s_effects)
+        {
+            used.clear();
+            it.usedPermutations(mDevice.Get(), used);
+
+            for (auto j : used)
+            {
+                permutations.push_back(Permutation{ it.flag, j });
+            }
+        }
+    }
+
+    void Release() noexcept
+    {
+        mResources.clear();
+    }
+
+private:
+    void Retain(uint32_t flag, std::shared_ptr<void>&& resources)
+    {
+        if (resources)
+        {
+            mResources[flag] = std::move(resources);
+        }
+    }
+
+    static Statistics Run(
+        std::vector<EffectWarmUpTask>& tasks,
+        const ProgressCallback& progress,
+        size_t maxWorkers,
+        std::chrono::steady_clock::time_point start)
+    {
+        std::atomic<size_t> created(0);
+        std::atomic<size_t> existing(0);
+        std::atomic<size_t> unsupported(0);
+
+        std::mutex progressMutex;
+        size_t completed = 0;
+
+        // Shader creation on the device is free-threaded.
+        ParallelFor(tasks.size(), [&](size_t index)
+            {
+                switch (tasks[index]())
+                {
+                case EffectWarmUpResult::Created:       created.fetch_add(1, std::memory_order_relaxed); break;
+                case EffectWarmUpResult::Existing:      existing.fetch_add(1, std::memory_order_relaxed); break;
+                case EffectWarmUpResult::Unsupported:   unsupported.fetch_add(1, std::memory_order_relaxed); break;
+                }
+
+                if (progress)
+                {
+                    std::lock_guard<std::mutex> lock(progressMutex);
+                    progress(++completed, tasks.size());
+                }
+            }, maxWorkers);
+
+        Statistics stats = {};
+        stats.created = created.load();
+        stats.existing = existing.load();
+        stats.unsupported = unsupported.load();
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+    ComPtr<ID3D11Device>                        mDevice;
+    std::map<uint32_t, std::shared_ptr<void>>   mResources;
+};
+
+
+// Public constructor.
+_Use_decl_annotations_
+EffectShaderWarmUp::EffectShaderWarmUp(ID3D11Device* device)
+    : pImpl(std::make_unique<Impl>(device))
+{
+}
+
+
+// Move constructor.
+EffectShaderWarmUp::EffectShaderWarmUp(EffectShaderWarmUp&&) noexcept = default;
+EffectShaderWarmUp& EffectShaderWarmUp::operator= (EffectShaderWarmUp&&) noexcept = default;
+EffectShaderWarmUp::~EffectShaderWarmUp() = default;
+
+
+EffectShaderWarmUp::Statistics EffectShaderWarmUp::WarmUp(uint32_t effects, const ProgressCallback& progress, size_t maxWorkers)
+{
+    return pImpl->WarmUp(effects, progress, maxWorkers);
+}
+
+
+_Use_decl_annotations_
+EffectShaderWarmUp::Statistics EffectShaderWarmUp::WarmUp(const Permutation* permutations, size_t count, const ProgressCallback& progress, size_t maxWorkers)
+{
+    return pImpl->WarmUp(permutations, count, progress, maxWorkers);
+}
+
+
+void EffectShaderWarmUp::GetUsedPermutations(std::vector<Permutation>& permutations) const
+{
+    pImpl->GetUsedPermutations(permutations);
+}
+
+
+void EffectShaderWarmUp::Release() noexcept
+{
+    pImpl->Release();
+}
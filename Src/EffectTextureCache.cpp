@@ -0,0 +1,438 @@
+//--------------------------------------------------------------------------------------
+// File: EffectTextureCache.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "EffectTextureCache.h"
+#include "LoaderHelpers.h"
+#include "PlatformHelpers.h"
+
+#include "DDSTextureLoader.h"
+#include "WICTextureLoader.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+
+namespace
+{
+    // Approximate video memory used by the resource behind a view, including its mipmaps.
+    size_t EstimateTextureBytes(_In_ ID3D11ShaderResourceView* textureView) noexcept
+    {
+        ComPtr<ID3D11Resource> resource;
+        textureView->GetResource(resource.GetAddressOf());
+
+        D3D11_RESOURCE_DIMENSION dimension = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+        resource->GetType(&dimension);
+
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        size_t width = 1, height = 1, depth = 1, arraySize = 1, mipLevels = 1;
+
+        switch (dimension)
+        {
+        case D3D11_RESOURCE_DIMENSION_TEXTURE1D:
+            {
+                ComPtr<ID3D11Texture1D> tex;
+                if (FAILED(resource.As(&tex)))
+                    return 0;
+
+                D3D11_TEXTURE1D_DESC desc;
+                tex->GetDesc(&desc);
+                format = desc.Format;
+                width = desc.Width;
+                arraySize = desc.ArraySize;
+                mipLevels = desc.MipLevels;
+            }
+            break;
+
+        case D3D11_RESOURCE_DIMENSION_TEXTURE2D:
+            {
+                ComPtr<ID3D11Texture2D> tex;
+                if (FAILED(resource.As(&tex)))
+                    return 0;
+
+                D3D11_TEXTURE2D_DESC desc;
+                tex->GetDesc(&desc);
+                format = desc.Format;
+                width = desc.Width;
+                height = desc.Height;
+                arraySize = desc.ArraySize;
+                mipLevels = desc.MipLevels;
+            }
+            break;
+
+        case D3D11_RESOURCE_DIMENSION_TEXTURE3D:
+            {
+                ComPtr<ID3D11Texture3D> tex;
+                if (FAILED(resource.As(&tex)))
+                    return 0;
+
+                D3D11_TEXTURE3D_DESC desc;
+                tex->GetDesc(&desc);
+                format = desc.Format;
+                width = desc.Width;
+                height = desc.Height;
+                depth = desc.Depth;
+                mipLevels = desc.MipLevels;
+            }
+            break;
+
+        default:
+            return 0;
+        }
+
+        const size_t bpp = LoaderHelpers::BitsPerPixel(format);
+
+        size_t bytes = 0;
+        for (size_t level = 0; level < mipLevels; ++level)
+        {
+            bytes += (width * height * depth * bpp + 7) / 8;
+
+            width = std::max<size_t>(width >> 1, 1);
+            height = std::max<size_t>(height >> 1, 1);
+            depth = std::max<size_t>(depth >> 1, 1);
+        }
+
+        return bytes * arraySize;
+    }
+}
+
+
+// Global instance pool.
+SharedResourcePool<ID3D11Device*, EffectTextureCache> EffectTextureCache::instancePool;
+
+
+_Use_decl_annotations_
+EffectTextureCache::EffectTextureCache(ID3D11Device* device) noexcept :
+    mDevice(device),
+    mTick(0),
+    mBudget(0),
+    mTextures(0),
+    mBytes(0),
+    mHits(0),
+    mWaits(0),
+    mMisses(0),
+    mEvictions(0),
+    mEvictedBytes(0)
+{
+}
+
+
+_Use_decl_annotations_
+void EffectTextureCache::CreateTexture(
+    const wchar_t* directory,
+    const wchar_t* name,
+    bool forceSRGB,
+    bool sharing,
+    ID3D11DeviceContext* deviceContext,
+    ID3D11ShaderResourceView** textureView,
+    const void* user,
+    const char* owner)
+{
+    if (!name || !textureView)
+        throw std::invalid_argument("name and textureView parameters can't be null");
+
+    *textureView = nullptr;
+
+    if (!sharing || !*name)
+    {
+        LoadTexture(directory, name, forceSRGB, deviceContext, textureView, owner);
+        return;
+    }
+
+    // The same name can refer to different files, or be loaded differently, depending on the factory settings.
+    std::wstring key(directory);
+    key += L'|';
+    key += name;
+    key += forceSRGB ? L"|s" : L"|";
+
+    auto& shard = GetShard(key);
+
+    std::promise<ComPtr<ID3D11ShaderResourceView>> promise;
+    TextureFuture future;
+    uint64_t id = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end())
+        {
+            auto& entry = it->second;
+            entry.lastUse = ++mTick;
+            future = entry.texture;
+
+            if (std::find(entry.users.cbegin(), entry.users.cend(), user) == entry.users.cend())
+                entry.users.push_back(user);
+
+            if (entry.ready)
+                ++mHits;
+            else
+                ++mWaits;
+        }
+        else
+        {
+            ++mMisses;
+            id = ++mTick;
+            shard.entries.emplace(key, Entry{ promise.get_future().share(), 0, id, id, false, { user } });
+        }
+    }
+
+    if (future.valid())
+    {
+        // Rethrows the error if the load that was in progress failed.
+        ComPtr<ID3D11ShaderResourceView> srv = future.get();
+        *textureView = srv.Detach();
+        return;
+    }
+
+    ComPtr<ID3D11ShaderResourceView> srv;
+    try
+    {
+        LoadTexture(directory, name, forceSRGB, deviceContext, srv.GetAddressOf(), owner);
+    }
+    catch (...)
+    {
+        // Forget the failure so a later request can try again. The entry may already have
+        // been released or evicted, and even replaced by another thread's load of the same key.
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(key);
+            if (it != shard.entries.end() && it->second.id == id)
+                shard.entries.erase(it);
+        }
+
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    const size_t bytes = EstimateTextureBytes(srv.Get());
+
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end() && it->second.id == id)
+        {
+            it->second.bytes = bytes;
+            it->second.ready = true;
+
+            ++mTextures;
+            mBytes += bytes;
+        }
+    }
+
+    promise.set_value(srv);
+
+    *textureView = srv.Detach();
+
+    if (mBudget.load() != 0)
+    {
+        Trim();
+    }
+}
+
+
+_Use_decl_annotations_
+void EffectTextureCache::LoadTexture(
+    const wchar_t* directory,
+    const wchar_t* name,
+    bool forceSRGB,
+    ID3D11DeviceContext* deviceContext,
+    ID3D11ShaderResourceView** textureView,
+    const char* owner)
+{
+#if defined(_XBOX_ONE) && defined(_TITLE)
+    UNREFERENCED_PARAMETER(deviceContext);
+#endif
+
+    wchar_t fullName[MAX_PATH] = {};
+    wcscpy_s(fullName, directory);
+    wcscat_s(fullName, name);
+
+    WIN32_FILE_ATTRIBUTE_DATA fileAttr = {};
+    if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
+    {
+        // Try Current Working Directory (CWD)
+        wcscpy_s(fullName, name);
+        if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
+        {
+            DebugTrace("ERROR: %s could not find texture file '%ls'\n", owner, name);
+            throw std::system_error(std::error_code(static_cast<int>(GetLastError()), std::system_category()), std::string(owner) + "::CreateTexture");
+        }
+    }
+
+    wchar_t ext[_MAX_EXT] = {};
+    _wsplitpath_s(name, nullptr, 0, nullptr, 0, nullptr, 0, ext, _MAX_EXT);
+    const bool isdds = _wcsicmp(ext, L".dds") == 0;
+
+    if (isdds)
+    {
+        HRESULT hr = CreateDDSTextureFromFileEx(
+            mDevice.Get(), fullName, 0,
+            D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+            forceSRGB ? DDS_LOADER_FORCE_SRGB : DDS_LOADER_DEFAULT, nullptr, textureView);
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: CreateDDSTextureFromFile failed (%08X) for '%ls'\n",
+                static_cast<unsigned int>(hr), fullName);
+            throw std::runtime_error(std::string(owner) + "::CreateDDSTextureFromFile");
+        }
+    }
+#if !defined(_XBOX_ONE) || !defined(_TITLE)
+    else if (deviceContext)
+    {
+        std::lock_guard<std::mutex> lock(mContextMutex);
+        HRESULT hr = CreateWICTextureFromFileEx(
+            mDevice.Get(), deviceContext, fullName, 0,
+            D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+            forceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n",
+                static_cast<unsigned int>(hr), fullName);
+            throw std::runtime_error(std::string(owner) + "::CreateWICTextureFromFile");
+        }
+    }
+#endif
+    else
+    {
+        HRESULT hr = CreateWICTextureFromFileEx(
+            mDevice.Get(), fullName, 0,
+            D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+            forceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n",
+                static_cast<unsigned int>(hr), fullName);
+            throw std::runtime_error(std::string(owner) + "::CreateWICTextureFromFile");
+        }
+    }
+}
+
+
+// Drops the least recently requested textures until the cache fits its budget. Textures
+// still in use by effects stay alive; the cache just stops handing them out.
+void EffectTextureCache::Trim()
+{
+    const size_t budget = mBudget.load();
+    if (!budget || mBytes.load() <= budget)
+        return;
+
+    struct Candidate
+    {
+        uint64_t        lastUse;
+        size_t          shard;
+        std::wstring    key;
+    };
+
+    std::vector<Candidate> candidates;
+
+    for (size_t j = 0; j < ShardCount; ++j)
+    {
+        std::lock_guard<std::mutex> lock(mShards[j].mutex);
+
+        for (const auto& it : mShards[j].entries)
+        {
+            if (it.second.ready)
+            {
+                candidates.push_back(Candidate{ it.second.lastUse, j, it.first });
+            }
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+        [](const Candidate& a, const Candidate& b) { return a.lastUse < b.lastUse; });
+
+    for (const auto& candidate : candidates)
+    {
+        if (mBytes.load() <= budget)
+            break;
+
+        auto& shard = mShards[candidate.shard];
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        // Skip textures requested again since the scan.
+        auto it = shard.entries.find(candidate.key);
+        if (it == shard.entries.end() || it->second.lastUse != candidate.lastUse)
+            continue;
+
+        const size_t bytes = it->second.bytes;
+        shard.entries.erase(it);
+
+        --mTextures;
+        mBytes -= bytes;
+        ++mEvictions;
+        mEvictedBytes += bytes;
+    }
+}
+
+
+_Use_decl_annotations_
+void EffectTextureCache::Release(const void* user) noexcept
+{
+    for (auto& shard : mShards)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        for (auto it = shard.entries.begin(); it != shard.entries.end();)
+        {
+            auto& users = it->second.users;
+            users.erase(std::remove(users.begin(), users.end(), user), users.end());
+
+            if (!users.empty())
+            {
+                ++it;
+                continue;
+            }
+
+            // A load still in progress finds its entry gone and leaves the totals alone.
+            if (it->second.ready)
+            {
+                --mTextures;
+                mBytes -= it->second.bytes;
+            }
+
+            it = shard.entries.erase(it);
+        }
+    }
+}
+
+
+void EffectTextureCache::SetBudget(size_t bytes) noexcept
+{
+    mBudget = bytes;
+
+    if (bytes)
+    {
+        try
+        {
+            Trim();
+        }
+        catch (...)
+        {
+            // The next load trims again.
+        }
+    }
+}
+
+
+TextureCacheStatistics EffectTextureCache::GetStatistics() const noexcept
+{
+    TextureCacheStatistics stats = {};
+    stats.textures = mTextures.load();
+    stats.bytes = mBytes.load();
+    stats.budget = mBudget.load();
+    stats.hits = mHits.load();
+    stats.waits = mWaits.load();
+    stats.misses = mMisses.load();
+    stats.evictions = mEvictions.load();
+    stats.evictedBytes = mEvictedBytes.load();
+    return stats;
+}
@@ -0,0 +1,117 @@
+//--------------------------------------------------------------------------------------
+// File: EffectTextureCache.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "Effects.h"
+#include "SharedResourcePool.h"
+
+#include <atomic>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <wrl/client.h>
+
+
+namespace DirectX
+{
+    // Textures loaded by the effect factories. One cache is shared by every EffectFactory,
+    // PBREffectFactory, and DGSLEffectFactory created for the same device.
+    //
+    // Entries are spread over independently locked shards. A load in progress is recorded
+    // as a future, so other threads asking for the same texture wait for it instead of
+    // loading it again. With a budget set, the least recently requested textures are
+    // dropped from the cache once the estimated total exceeds it. Each entry remembers
+    // which factories asked for it, so one factory releasing its textures leaves the
+    // others' in place.
+    class EffectTextureCache
+    {
+    public:
+        explicit EffectTextureCache(_In_ ID3D11Device* device) noexcept;
+
+        EffectTextureCache(EffectTextureCache const&) = delete;
+        EffectTextureCache& operator= (EffectTextureCache const&) = delete;
+
+        // Looks in directory first and then the current working directory. If sharing is
+        // false the texture is always loaded and not cached. The texture is recorded as used
+        // by 'user', and errors are reported as 'owner'.
+        void CreateTexture(
+            _In_z_ const wchar_t* directory,
+            _In_z_ const wchar_t* name,
+            bool forceSRGB,
+            bool sharing,
+            _In_opt_ ID3D11DeviceContext* deviceContext,
+            _Outptr_ ID3D11ShaderResourceView** textureView,
+            _In_ const void* user,
+            _In_z_ const char* owner);
+
+        // Forgets that 'user' asked for any texture, dropping those nobody else asked for.
+        void Release(_In_ const void* user) noexcept;
+
+        void SetBudget(size_t bytes) noexcept;
+
+        TextureCacheStatistics GetStatistics() const noexcept;
+
+        static SharedResourcePool<ID3D11Device*, EffectTextureCache> instancePool;
+
+    private:
+        static constexpr size_t ShardCount = 16;
+
+        using TextureFuture = std::shared_future<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>>;
+
+        struct Entry
+        {
+            TextureFuture               texture;
+            size_t                      bytes;      // Zero until the load completes
+            uint64_t                    lastUse;
+            uint64_t                    id;         // Tells this entry apart from a later one for the same key
+            bool                        ready;
+            std::vector<const void*>    users;
+        };
+
+        struct Shard
+        {
+            std::mutex                                  mutex;
+            std::unordered_map<std::wstring, Entry>     entries;
+        };
+
+        void LoadTexture(
+            _In_z_ const wchar_t* directory,
+            _In_z_ const wchar_t* name,
+            bool forceSRGB,
+            _In_opt_ ID3D11DeviceContext* deviceContext,
+            _Outptr_ ID3D11ShaderResourceView** textureView,
+            _In_z_ const char* owner);
+
+        Shard& GetShard(const std::wstring& key) noexcept
+        {
+            return mShards[std::hash<std::wstring>()(key) % ShardCount];
+        }
+
+        void Trim();
+
+        Microsoft::WRL::ComPtr<ID3D11Device> mDevice;
+
+        Shard mShards[ShardCount];
+
+        // Serializes WIC loads that use the device context for mipmap generation.
+        std::mutex mContextMutex;
+
+        std::atomic<uint64_t> mTick;
+        std::atomic<size_t> mBudget;
+        std::atomic<size_t> mTextures;
+        std::atomic<size_t> mBytes;
+        std::atomic<size_t> mHits;
+        std::atomic<size_t> mWaits;
+        std::atomic<size_t> mMisses;
+        std::atomic<size_t> mEvictions;
+        std::atomic<size_t> mEvictedBytes;
+    };
+}
@@ -344,6 +344,20 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<EnvironmentMapEffectTraits>::DeviceResources> EffectBase<EnvironmentMapEffectTraits>::deviceResourcesPool = {};
 
 
+// Queues shader permutations for EffectShaderWarmUp.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::WarmUpEnvironmentMapEffectShaders(ID3D11Device* device, const uint32_t* permutations, size_t count, std::vector<EffectWarmUpTask>& tasks)
+{
+    return EffectBase<EnvironmentMapEffectTraits>::WarmUpShaders(device, permutations, count, tasks);
+}
+
+_Use_decl_annotations_
+void DirectX::GetEnvironmentMapEffectUsedPermutations(ID3D11Device* device, std::vector<uint32_t>& permutations)
+{
+    EffectBase<EnvironmentMapEffectTraits>::GetUsedPermutations(device, permutations);
+}
+
+
 // Constructor.
 EnvironmentMapEffect::Impl::Impl(_In_ ID3D11Device* device)
     : EffectBase(device),
@@ -438,6 +452,8 @@ void EnvironmentMapEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
     assert(deviceContext != nullptr);
 
+    StateFilter filter(deviceContext);
+
     // Compute derived parameter values.
     matrices.SetConstants(dirtyFlags, constants.worldViewProj);
 
@@ -452,7 +468,7 @@ void EnvironmentMapEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
         environmentMap.Get(),
     };
 
-    deviceContext->PSSetShaderResources(0, 2, textures);
+    filter.PSSetShaderResources(0, 2, textures);
 
     // Set shaders and constant buffers.
     ApplyShaders(deviceContext, GetCurrentShaderPermutation());
@@ -487,7 +503,7 @@ void EnvironmentMapEffect::GetVertexShaderBytecode(_Out_ void const** pShaderByt
 // Camera settings.
 void XM_CALLCONV EnvironmentMapEffect::SetWorld(FXMMATRIX value)
 {
-    pImpl->matrices.world = value;
+    pImpl->matrices.SetWorld(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::FogVector;
 }
@@ -495,7 +511,7 @@ void XM_CALLCONV EnvironmentMapEffect::SetWorld(FXMMATRIX value)
 
 void XM_CALLCONV EnvironmentMapEffect::SetView(FXMMATRIX value)
 {
-    pImpl->matrices.view = value;
+    pImpl->matrices.SetView(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
 }
@@ -511,14 +527,30 @@ void XM_CALLCONV EnvironmentMapEffect::SetProjection(FXMMATRIX value)
 
 void XM_CALLCONV EnvironmentMapEffect::SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection)
 {
-    pImpl->matrices.world = world;
-    pImpl->matrices.view = view;
+    pImpl->matrices.SetWorld(world);
+    pImpl->matrices.SetView(view);
     pImpl->matrices.projection = projection;
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
 }
 
 
+void EnvironmentMapEffect::SetCamera(const EffectCamera& camera)
+{
+    pImpl->matrices.SetCamera(camera);
+
+    pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
+}
+
+
+void EnvironmentMapEffect::SetWorldTransform(const EffectWorldTransform& transform)
+{
+    pImpl->matrices.SetWorldTransform(transform);
+
+    pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::FogVector;
+}
+
+
 // Material settings.
 void XM_CALLCONV EnvironmentMapEffect::SetDiffuseColor(FXMVECTOR value)
 {
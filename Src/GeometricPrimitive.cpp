@@ -15,6 +15,7 @@
 #include "Effects.h"
 #include "Geometry.h"
 #include "SharedResourcePool.h"
+#include "StateFilter.h"
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -118,6 +119,8 @@ GeometricPrimitive::Impl::SharedResources::SharedResources(_In_ ID3D11DeviceCont
 // Sets up D3D device state ready for drawing a primitive.
 void GeometricPrimitive::Impl::SharedResources::PrepareForRendering(bool alpha, bool wireframe) const
 {
+    StateFilter filter(mDeviceContext.Get());
+
     // Set the blend and depth stencil state.
     ID3D11BlendState* blendState;
     ID3D11DepthStencilState* depthStencilState;
@@ -135,18 +138,18 @@ void GeometricPrimitive::Impl::SharedResources::PrepareForRendering(bool alpha,
         depthStencilState = s_reversez ? stateObjects->DepthReverseZ() : stateObjects->DepthDefault();
     }
 
-    mDeviceContext->OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
-    mDeviceContext->OMSetDepthStencilState(depthStencilState, 0);
+    filter.OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
+    filter.OMSetDepthStencilState(depthStencilState, 0);
 
     // Set the rasterizer state.
     if (wireframe)
-        mDeviceContext->RSSetState(stateObjects->Wireframe());
+        filter.RSSetState(stateObjects->Wireframe());
     else
-        mDeviceContext->RSSetState(stateObjects->CullCounterClockwise());
+        filter.RSSetState(stateObjects->CullCounterClockwise());
 
     ID3D11SamplerState* samplerState = stateObjects->LinearWrap();
 
-    mDeviceContext->PSSetSamplers(0, 1, &samplerState);
+    filter.PSSetSamplers(0, 1, &samplerState);
 }
 
 
@@ -233,12 +236,14 @@ void GeometricPrimitive::Impl::Draw(
     auto deviceContext = mResources->mDeviceContext.Get();
     assert(deviceContext != nullptr);
 
+    StateFilter filter(deviceContext);
+
     // Set state objects.
     mResources->PrepareForRendering(alpha, wireframe);
 
     // Set input layout.
     assert(inputLayout != nullptr);
-    deviceContext->IASetInputLayout(inputLayout);
+    filter.IASetInputLayout(inputLayout);
 
     // Activate our shaders, constant buffers, texture, etc.
     assert(effect != nullptr);
@@ -249,18 +254,19 @@ void GeometricPrimitive::Impl::Draw(
     constexpr UINT vertexStride = sizeof(VertexType);
     constexpr UINT vertexOffset = 0;
 
-    deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
+    filter.IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
 
-    deviceContext->IASetIndexBuffer(mIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+    filter.IASetIndexBuffer(mIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
 
     // Hook lets the caller replace our shaders or state settings with whatever else they see fit.
     if (setCustomState)
     {
         setCustomState();
+        filter.Invalidate();
     }
 
     // Draw the primitive.
-    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    filter.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
     deviceContext->DrawIndexed(mIndexCount, 0, 0);
 }
@@ -279,12 +285,14 @@ void GeometricPrimitive::Impl::DrawInstanced(
     auto deviceContext = mResources->mDeviceContext.Get();
     assert(deviceContext != nullptr);
 
+    StateFilter filter(deviceContext);
+
     // Set state objects.
     mResources->PrepareForRendering(alpha, wireframe);
 
     // Set input layout.
     assert(inputLayout != nullptr);
-    deviceContext->IASetInputLayout(inputLayout);
+    filter.IASetInputLayout(inputLayout);
 
     // Activate our shaders, constant buffers, texture, etc.
     assert(effect != nullptr);
@@ -295,18 +303,19 @@ void GeometricPrimitive::Impl::DrawInstanced(
     constexpr UINT vertexStride = sizeof(VertexType);
     constexpr UINT vertexOffset = 0;
 
-    deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
+    filter.IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
 
-    deviceContext->IASetIndexBuffer(mIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+    filter.IASetIndexBuffer(mIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
 
     // Hook lets the caller replace our shaders or state settings with whatever else they see fit.
     if (setCustomState)
     {
         setCustomState();
+        filter.Invalidate();
     }
 
     // Draw the primitive.
-    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    filter.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
     deviceContext->DrawIndexedInstanced(mIndexCount, instanceCount, 0, 0, startInstanceLocation);
 }
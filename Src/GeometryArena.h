@@ -0,0 +1,138 @@
+//--------------------------------------------------------------------------------------
+// File: GeometryArena.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+
+namespace DirectX
+{
+    // CPU-side suballocator used by the model loaders to pack many small vertex or index
+    // streams into a few large buffers. Streams are grouped by a caller-supplied key (the
+    // vertex stride or index format), and each stream is placed at an offset that is a
+    // multiple of its alignment so it can be addressed with a base vertex / start index.
+    // A new buffer is started for a key whenever appending would exceed maxBufferSize.
+    class GeometryArena
+    {
+    public:
+        struct Allocation
+        {
+            size_t buffer;      // Index of the consolidated buffer holding the stream
+            size_t offset;      // Byte offset of the stream within that buffer
+        };
+
+        explicit GeometryArena(size_t maxBufferSize) noexcept :
+            mMaxBufferSize(maxBufferSize)
+        {
+        }
+
+        GeometryArena(GeometryArena&&) = default;
+        GeometryArena& operator= (GeometryArena&&) = default;
+
+        GeometryArena(GeometryArena const&) = delete;
+        GeometryArena& operator= (GeometryArena const&) = delete;
+
+        // Copies a stream into the arena and returns where it was placed.
+        Allocation Append(uint32_t key, size_t alignment, _In_reads_bytes_(bytes) const void* data, size_t bytes)
+        {
+            if (!alignment || !bytes || !data)
+                throw std::invalid_argument("Invalid stream for geometry arena");
+
+            for (size_t j = 0; j < mBuffers.size(); ++j)
+            {
+                auto& buffer = mBuffers[j];
+                if (buffer.key != key || buffer.alignment != alignment)
+                    continue;
+
+                const size_t offset = AlignUp(buffer.data.size(), alignment);
+                if (offset > mMaxBufferSize || bytes > (mMaxBufferSize - offset))
+                    continue;
+
+                buffer.data.resize(offset + bytes);
+                memcpy(buffer.data.data() + offset, data, bytes);
+                return Allocation{ j, offset };
+            }
+
+            // Streams larger than the cap still get a buffer of their own.
+            Buffer buffer;
+            buffer.key = key;
+            buffer.alignment = alignment;
+            buffer.data.resize(bytes);
+            memcpy(buffer.data.data(), data, bytes);
+            mBuffers.emplace_back(std::move(buffer));
+            return Allocation{ mBuffers.size() - 1, 0 };
+        }
+
+        size_t GetBufferCount() const noexcept { return mBuffers.size(); }
+
+        uint32_t GetBufferKey(size_t index) const { return mBuffers.at(index).key; }
+        size_t GetBufferSize(size_t index) const { return mBuffers.at(index).data.size(); }
+        const uint8_t* GetBufferData(size_t index) const { return mBuffers.at(index).data.data(); }
+
+        // Releases the staging copies once GPU buffers have been created.
+        void Clear() noexcept { mBuffers.clear(); }
+
+        static size_t AlignUp(size_t value, size_t alignment) noexcept
+        {
+            return ((value + alignment - 1) / alignment) * alignment;
+        }
+
+    private:
+        struct Buffer
+        {
+            uint32_t                key;
+            size_t                  alignment;
+            std::vector<uint8_t>    data;
+        };
+
+        size_t              mMaxBufferSize;
+        std::vector<Buffer> mBuffers;
+    };
+
+
+#if defined(__d3d11_h__) || defined(__d3d11_x_h__)
+    // Creates one immutable-content GPU buffer per arena buffer.
+    inline void CreateGeometryArenaBuffers(
+        _In_ ID3D11Device* device,
+        const GeometryArena& arena,
+        UINT bindFlags,
+        _In_z_ const char* name,
+        std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>>& buffers)
+    {
+        buffers.clear();
+        buffers.resize(arena.GetBufferCount());
+
+        for (size_t j = 0; j < buffers.size(); ++j)
+        {
+            const size_t bytes = arena.GetBufferSize(j);
+            if (bytes > UINT32_MAX)
+                throw std::runtime_error("Consolidated buffer too large");
+
+            D3D11_BUFFER_DESC desc = {};
+            desc.Usage = D3D11_USAGE_DEFAULT;
+            desc.ByteWidth = static_cast<UINT>(bytes);
+            desc.BindFlags = bindFlags;
+
+            D3D11_SUBRESOURCE_DATA initData = { arena.GetBufferData(j), 0, 0 };
+
+            ThrowIfFailed(
+                device->CreateBuffer(&desc, &initData, buffers[j].ReleaseAndGetAddressOf())
+            );
+
+            SetDebugObjectName(buffers[j].Get(), name);
+        }
+    }
+#endif
+}
@@ -12,6 +12,10 @@
 #include "GraphicsMemory.h"
 #include "DirectXHelpers.h"
 #include "PlatformHelpers.h"
+#include "RingAllocator.h"
+#include "StateCache.h"
+
+#include <atomic>
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -211,14 +215,17 @@ GraphicsMemory::Impl* GraphicsMemory::Impl::s_graphicsMemory = nullptr;
 #else
 
 //======================================================================================
-// Null allocator for standard Direct3D
+// Standard Direct3D: null allocator, plus the optional Direct3D 11.1 constant ring
 //======================================================================================
 
 class GraphicsMemory::Impl
 {
 public:
     Impl(GraphicsMemory* owner) :
-        mOwner(owner)
+        mOwner(owner),
+        mConstantRingEnabled(false),
+        mSegmentOpen(false),
+        mGeneration(1)
     {
         if (s_graphicsMemory)
         {
@@ -228,8 +235,8 @@ public:
         s_graphicsMemory = this;
     }
 
-    Impl(Impl&&) = default;
-    Impl& operator= (Impl&&) = default;
+    Impl(Impl&&) = delete;
+    Impl& operator= (Impl&&) = delete;
 
     Impl(Impl const&) = delete;
     Impl& operator= (Impl const&) = delete;
@@ -241,8 +248,9 @@ public:
 
     void Initialize(_In_ ID3D11Device* device, unsigned int backBufferCount) noexcept
     {
-        UNREFERENCED_PARAMETER(device);
         UNREFERENCED_PARAMETER(backBufferCount);
+
+        mDevice = device;
     }
 
     void* Allocate(_In_opt_ ID3D11DeviceContext* context, size_t size, int alignment) noexcept
@@ -255,11 +263,162 @@ public:
 
     void Commit() noexcept
     {
+        if (!mConstantRingEnabled)
+            return;
+
+        std::lock_guard<std::mutex> lock(mGuard);
+
+        // The next allocation opens a new segment with a discard, so allocations are only reused within a frame
+        mSegmentOpen = false;
+        ++mGeneration;
+    }
+
+    bool EnableConstantRing(size_t sizeInBytes)
+    {
+        if (!mDevice)
+            return false;
+
+        if (!sizeInBytes || sizeInBytes > UINT32_MAX - c_ConstantAlignment)
+            throw std::invalid_argument("Invalid constant ring size");
+
+        ComPtr<ID3D11DeviceContext> context;
+        mDevice->GetImmediateContext(context.GetAddressOf());
+
+        ComPtr<ID3D11DeviceContext1> context1;
+        if (FAILED(context.As(&context1)))
+            return false;
+
+        D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+        if (FAILED(mDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options)))
+            || !options.ConstantBufferOffsetting
+            || !options.MapNoOverwriteOnDynamicConstantBuffer)
+            return false;
+
+        std::lock_guard<std::mutex> lock(mGuard);
+
+        const size_t bytes = RingAllocator::AlignUp(sizeInBytes, c_ConstantAlignment);
+
+        D3D11_BUFFER_DESC desc = {};
+        desc.ByteWidth = static_cast<UINT>(bytes);
+        desc.Usage = D3D11_USAGE_DYNAMIC;
+        desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+        ComPtr<ID3D11Buffer> buffer;
+        ThrowIfFailed(mDevice->CreateBuffer(&desc, nullptr, buffer.GetAddressOf()));
+
+        SetDebugObjectName(buffer.Get(), "DirectXTK:ConstantRing");
+
+        mContext = context;
+        mContext1 = context1;
+        mConstantBuffer = buffer;
+        mRing.Reset(bytes);
+        mSegmentOpen = false;
+        ++mGeneration;
+
+        mConstantRingEnabled = true;
+
+        return true;
+    }
+
+    bool AllocateConstants(_In_ ID3D11DeviceContext* context, _In_reads_bytes_(size) const void* data, size_t size, ConstantAllocation& allocation)
+    {
+        allocation = {};
+
+        if (!mConstantRingEnabled || context != mContext.Get() || !data || !size)
+            return false;
+
+        // Offsets and sizes are in multiples of 16 constants
+        const size_t bytes = RingAllocator::AlignUp(size, c_ConstantAlignment);
+        if (bytes > D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT * 16)
+            return false;
+
+        std::lock_guard<std::mutex> lock(mGuard);
+
+        // The first allocation of a frame opens a segment: one discard map has the driver rename the
+        // buffer, so nothing the GPU may still be reading is touched, and the rest of the frame appends to
+        // it with no-overwrite maps. A buffer can't stay mapped across the draws that read from it, hence
+        // a map per allocation rather than one mapping held until Commit.
+        size_t offset = mSegmentOpen ? mRing.Allocate(bytes, c_ConstantAlignment) : RingAllocator::InvalidOffset;
+
+        D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+        if (offset == RingAllocator::InvalidOffset)
+        {
+            // New frame, or this one has filled the buffer
+            mapType = D3D11_MAP_WRITE_DISCARD;
+            mRing.Reset();
+            ++mGeneration;
+
+            offset = mRing.Allocate(bytes, c_ConstantAlignment);
+            if (offset == RingAllocator::InvalidOffset)
+                return false;
+        }
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        if (FAILED(mContext->Map(mConstantBuffer.Get(), 0, mapType, 0, &mapped)))
+        {
+            mSegmentOpen = false;
+            return false;
+        }
+
+        mSegmentOpen = true;
+
+        memcpy(static_cast<uint8_t*>(mapped.pData) + offset, data, size);
+
+        mContext->Unmap(mConstantBuffer.Get(), 0);
+
+        allocation.buffer = mConstantBuffer.Get();
+        allocation.firstConstant = static_cast<UINT>(offset / 16);
+        allocation.numConstants = static_cast<UINT>(bytes / 16);
+        allocation.generation = mGeneration.load(std::memory_order_relaxed);
+
+        return true;
+    }
+
+    bool BindConstants(_In_ ID3D11DeviceContext* context, UINT slot, const ConstantAllocation& allocation) const
+    {
+        if (!mConstantRingEnabled || context != mContext.Get() || !allocation.buffer)
+            return false;
+
+        // Successive allocations often land on the same offset, so let the state cache drop repeats.
+        if (auto cache = StateCache::Get(context))
+        {
+            cache->VSSetConstantBuffer1(slot, allocation.buffer, allocation.firstConstant, allocation.numConstants);
+            cache->PSSetConstantBuffer1(slot, allocation.buffer, allocation.firstConstant, allocation.numConstants);
+            return true;
+        }
+
+        mContext1->VSSetConstantBuffers1(slot, 1, &allocation.buffer, &allocation.firstConstant, &allocation.numConstants);
+        mContext1->PSSetConstantBuffers1(slot, 1, &allocation.buffer, &allocation.firstConstant, &allocation.numConstants);
+
+        return true;
+    }
+
+    uint64_t GetConstantRingGeneration() const noexcept
+    {
+        // Read without the lock by effects deciding whether to rebind, so the counter is atomic
+        return mGeneration.load(std::memory_order_acquire);
     }
 
     GraphicsMemory*  mOwner;
 
+    std::atomic<bool> mConstantRingEnabled;
+
     static GraphicsMemory::Impl* s_graphicsMemory;
+
+private:
+    static constexpr size_t c_ConstantAlignment = 256;
+
+    std::mutex                          mGuard;
+
+    ComPtr<ID3D11Device>                mDevice;
+    ComPtr<ID3D11DeviceContext>         mContext;
+    ComPtr<ID3D11DeviceContext1>        mContext1;
+    ComPtr<ID3D11Buffer>                mConstantBuffer;
+
+    RingAllocator                       mRing;
+    bool                                mSegmentOpen;
+    std::atomic<uint64_t>               mGeneration;
 };
 
 GraphicsMemory::Impl* GraphicsMemory::Impl::s_graphicsMemory = nullptr;
@@ -318,6 +477,44 @@ void GraphicsMemory::Commit()
 }
 
 
+#if !(defined(_XBOX_ONE) && defined(_TITLE))
+bool GraphicsMemory::EnableConstantRing(size_t sizeInBytes)
+{
+    return pImpl->EnableConstantRing(sizeInBytes);
+}
+
+
+_Use_decl_annotations_
+bool GraphicsMemory::AllocateConstants(ID3D11DeviceContext* context, const void* data, size_t size, ConstantAllocation& allocation)
+{
+    return pImpl->AllocateConstants(context, data, size, allocation);
+}
+
+
+_Use_decl_annotations_
+bool GraphicsMemory::BindConstants(ID3D11DeviceContext* context, UINT slot, const ConstantAllocation& allocation)
+{
+    return pImpl->BindConstants(context, slot, allocation);
+}
+
+
+uint64_t GraphicsMemory::GetConstantRingGeneration() const noexcept
+{
+    return pImpl->GetConstantRingGeneration();
+}
+
+
+GraphicsMemory* GraphicsMemory::GetConstantRing() noexcept
+{
+    auto impl = Impl::s_graphicsMemory;
+    if (!impl || !impl->mConstantRingEnabled)
+        return nullptr;
+
+    return impl->mOwner;
+}
+#endif
+
+
 GraphicsMemory& GraphicsMemory::Get()
 {
     if (!Impl::s_graphicsMemory || !Impl::s_graphicsMemory->mOwner)
@@ -13,9 +13,16 @@
 #pragma once
 
 #include "DDS.h"
-#include "DDSTextureLoader.h"
+#include "DDSCompression.h"
+#include "PixelConvert.h"
 #include "PlatformHelpers.h"
 
+#ifdef _WIN32
+#include "DDSTextureLoader.h"
+#else
+#include "DDSParser.h"
+#endif
+
 
 namespace DirectX
 {
@@ -380,6 +387,7 @@ namespace DirectX
             return S_OK;
         }
 
+    #ifdef _WIN32
         //--------------------------------------------------------------------------------------
         inline HRESULT LoadTextureDataFromFile(
             _In_z_ const wchar_t* fileName,
@@ -460,6 +468,19 @@ namespace DirectX
                 return E_FAIL;
             }
 
+            size_t dataSize = fileInfo.EndOfFile.LowPart;
+
+            // A supercompressed file is expanded here, so callers only ever see a plain DDS
+            if (IsCompressedDDS(ddsData.get(), dataSize))
+            {
+                std::unique_ptr<uint8_t[]> packed(std::move(ddsData));
+                const size_t packedSize = dataSize;
+
+                HRESULT hr = DecompressDDS(packed.get(), packedSize, ddsData, dataSize);
+                if (FAILED(hr))
+                    return hr;
+            }
+
             // DDS files always start with the same magic number ("DDS ")
             auto const dwMagicNumber = *reinterpret_cast<const uint32_t*>(ddsData.get());
             if (dwMagicNumber != DDS_MAGIC)
@@ -484,7 +505,7 @@ namespace DirectX
                 (MAKEFOURCC('D', 'X', '1', '0') == hdr->ddspf.fourCC))
             {
                 // Must be long enough for both headers and magic value
-                if (fileInfo.EndOfFile.LowPart < (sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10)))
+                if (dataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10)))
                 {
                     ddsData.reset();
                     return E_FAIL;
@@ -498,10 +519,11 @@ namespace DirectX
             auto offset = sizeof(uint32_t) + sizeof(DDS_HEADER)
                 + (bDXT10Header ? sizeof(DDS_HEADER_DXT10) : 0u);
             *bitData = ddsData.get() + offset;
-            *bitSize = fileInfo.EndOfFile.LowPart - offset;
+            *bitSize = dataSize - offset;
 
             return S_OK;
         }
+    #endif // _WIN32
 
         //--------------------------------------------------------------------------------------
         // Get surface information for a particular format
@@ -995,6 +1017,7 @@ namespace DirectX
             return DDS_ALPHA_MODE_UNKNOWN;
         }
 
+    #ifdef _WIN32
         //--------------------------------------------------------------------------------------
         class auto_delete_file
         {
@@ -1049,6 +1072,7 @@ namespace DirectX
             LPCWSTR m_filename;
             Microsoft::WRL::ComPtr<IWICStream>& m_handle;
         };
+    #endif // _WIN32
 
         inline uint32_t CountMips(uint32_t width, uint32_t height) noexcept
         {
@@ -1104,5 +1128,78 @@ namespace DirectX
                 }
             }
         }
+
+    #ifdef _WIN32
+        //--------------------------------------------------------------------------------------
+        // WIC pixel formats the CPU converters can read and write directly
+        //--------------------------------------------------------------------------------------
+        inline PIXEL_LAYOUT WICToPixelLayout(const GUID& guid, _Out_ uint32_t& flags) noexcept
+        {
+            struct WICLayout
+            {
+                const GUID&     wic;
+                PIXEL_LAYOUT    layout;
+                uint32_t        flags;
+            };
+
+            static const WICLayout s_layouts[] =
+            {
+                { GUID_WICPixelFormat32bppRGBA,         PIXEL_LAYOUT_RGBA8,     PIXEL_DEFAULT },
+                { GUID_WICPixelFormat32bppBGRA,         PIXEL_LAYOUT_BGRA8,     PIXEL_DEFAULT },
+                { GUID_WICPixelFormat32bppBGR,          PIXEL_LAYOUT_BGRX8,     PIXEL_DEFAULT },
+                { GUID_WICPixelFormat32bppPRGBA,        PIXEL_LAYOUT_RGBA8,     PIXEL_PREMULTIPLIED },
+                { GUID_WICPixelFormat32bppPBGRA,        PIXEL_LAYOUT_BGRA8,     PIXEL_PREMULTIPLIED },
+                { GUID_WICPixelFormat24bppRGB,          PIXEL_LAYOUT_RGB8,      PIXEL_DEFAULT },
+                { GUID_WICPixelFormat24bppBGR,          PIXEL_LAYOUT_BGR8,      PIXEL_DEFAULT },
+                { GUID_WICPixelFormat64bppRGBA,         PIXEL_LAYOUT_RGBA16,    PIXEL_DEFAULT },
+                { GUID_WICPixelFormat64bppBGRA,         PIXEL_LAYOUT_BGRA16,    PIXEL_DEFAULT },
+                { GUID_WICPixelFormat64bppPRGBA,        PIXEL_LAYOUT_RGBA16,    PIXEL_PREMULTIPLIED },
+                { GUID_WICPixelFormat64bppPBGRA,        PIXEL_LAYOUT_BGRA16,    PIXEL_PREMULTIPLIED },
+                { GUID_WICPixelFormat48bppRGB,          PIXEL_LAYOUT_RGB16,     PIXEL_DEFAULT },
+                { GUID_WICPixelFormat48bppBGR,          PIXEL_LAYOUT_BGR16,     PIXEL_DEFAULT },
+                { GUID_WICPixelFormat64bppRGBAHalf,     PIXEL_LAYOUT_RGBA16F,   PIXEL_DEFAULT },
+                { GUID_WICPixelFormat128bppRGBAFloat,   PIXEL_LAYOUT_RGBA32F,   PIXEL_DEFAULT },
+                { GUID_WICPixelFormat128bppPRGBAFloat,  PIXEL_LAYOUT_RGBA32F,   PIXEL_PREMULTIPLIED },
+                { GUID_WICPixelFormat32bppGrayFloat,    PIXEL_LAYOUT_R32F,      PIXEL_DEFAULT },
+            #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8) || defined(_WIN7_PLATFORM_UPDATE)
+                { GUID_WICPixelFormat32bppRGB,          PIXEL_LAYOUT_RGBX8,     PIXEL_DEFAULT },
+                { GUID_WICPixelFormat64bppRGB,          PIXEL_LAYOUT_RGBX16,    PIXEL_DEFAULT },
+            #endif
+            };
+
+            for (size_t i = 0; i < std::size(s_layouts); ++i)
+            {
+                if (memcmp(&s_layouts[i].wic, &guid, sizeof(GUID)) == 0)
+                {
+                    flags = s_layouts[i].flags;
+                    return s_layouts[i].layout;
+                }
+            }
+
+            flags = PIXEL_DEFAULT;
+            return PIXEL_LAYOUT_UNKNOWN;
+        }
+    #endif // _WIN32
+
+        // WIC treats float formats as linear and integer ones as sRGB, so converting between
+        // the two encodes or decodes gamma
+        inline void ApplyWICGamma(
+            PIXEL_LAYOUT srcLayout,
+            _Inout_ uint32_t& srcFlags,
+            PIXEL_LAYOUT destLayout,
+            _Inout_ uint32_t& destFlags) noexcept
+        {
+            const bool srcFloat = IsPixelLayoutFloat(srcLayout);
+            const bool destFloat = IsPixelLayoutFloat(destLayout);
+
+            if (srcFloat && !destFloat)
+            {
+                destFlags |= PIXEL_SRGB;
+            }
+            else if (!srcFloat && destFloat)
+            {
+                srcFlags |= PIXEL_SRGB;
+            }
+        }
     }
 }
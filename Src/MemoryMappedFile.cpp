@@ -0,0 +1,190 @@
+//--------------------------------------------------------------------------------------
+// File: MemoryMappedFile.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+
+#include "MemoryMappedFile.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace DirectX;
+
+#ifndef _WIN32
+namespace
+{
+    HRESULT HResultFromErrno(int error) noexcept
+    {
+        switch (error)
+        {
+            case ENOENT:
+            case ENOTDIR:
+                return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+
+            case EACCES:
+            case EPERM:
+                return HRESULT_FROM_WIN32(ERROR_ACCESS_DENIED);
+
+            case ENOMEM:
+                return E_OUTOFMEMORY;
+
+            default:
+                return E_FAIL;
+        }
+    }
+}
+#endif
+
+
+// Maps the whole file for read-only access.
+_Use_decl_annotations_
+HRESULT MemoryMappedFile::Open(wchar_t const* fileName) noexcept
+{
+    Close();
+
+    if (!fileName)
+        return E_INVALIDARG;
+
+#ifdef _WIN32
+    // Open the file.
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    ScopedHandle hFile(safe_handle(CreateFile2(
+        fileName,
+        GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING,
+        nullptr)));
+#else
+    ScopedHandle hFile(safe_handle(CreateFileW(
+        fileName,
+        GENERIC_READ, FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+        nullptr)));
+#endif
+
+    if (!hFile)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    // Get the file size.
+    FILE_STANDARD_INFO fileInfo;
+    if (!GetFileInformationByHandleEx(hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo)))
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    // Empty files cannot be mapped.
+    if (fileInfo.EndOfFile.QuadPart <= 0)
+        return E_FAIL;
+
+#ifndef _WIN64
+    // File is too big for a 32-bit address space, so reject the mapping.
+    if (fileInfo.EndOfFile.HighPart > 0)
+        return E_FAIL;
+#endif
+
+    // Map the entire file.
+#if defined(WINAPI_FAMILY) && (WINAPI_FAMILY == WINAPI_FAMILY_APP)
+    ScopedHandle hMapping(CreateFileMappingFromApp(hFile.get(), nullptr, PAGE_READONLY, 0, nullptr));
+#else
+    ScopedHandle hMapping(CreateFileMappingW(hFile.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+#endif
+
+    if (!hMapping)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+#if defined(WINAPI_FAMILY) && (WINAPI_FAMILY == WINAPI_FAMILY_APP)
+    void* view = MapViewOfFileFromApp(hMapping.get(), FILE_MAP_READ, 0, 0);
+#else
+    void* view = MapViewOfFile(hMapping.get(), FILE_MAP_READ, 0, 0, 0);
+#endif
+
+    if (!view)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    mFile = std::move(hFile);
+    mMapping = std::move(hMapping);
+    mView.reset(view);
+    mData = static_cast<uint8_t const*>(view);
+    mSize = static_cast<size_t>(fileInfo.EndOfFile.QuadPart);
+#else
+    // Open the file. Wide names are converted the way std::filesystem does (UTF-8).
+    int fd = -1;
+    try
+    {
+        fd = open(std::filesystem::path(fileName).c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    catch (...)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (fd < 0)
+        return HResultFromErrno(errno);
+
+    // Get the file size.
+    struct stat fileInfo = {};
+    if (fstat(fd, &fileInfo) != 0)
+    {
+        const int error = errno;
+        close(fd);
+        return HResultFromErrno(error);
+    }
+
+    // Empty files cannot be mapped, nor files too big for the address space.
+    if (fileInfo.st_size <= 0 || static_cast<uint64_t>(fileInfo.st_size) > SIZE_MAX)
+    {
+        close(fd);
+        return E_FAIL;
+    }
+
+    const auto size = static_cast<size_t>(fileInfo.st_size);
+
+    // Map the entire file. The mapping keeps its own reference to the file.
+    void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int error = errno;
+    close(fd);
+
+    if (view == MAP_FAILED)
+        return HResultFromErrno(error);
+
+    mView = std::unique_ptr<void, view_unmapper>(view, view_unmapper{ size });
+    mData = static_cast<uint8_t const*>(view);
+    mSize = size;
+#endif
+
+    return S_OK;
+}
+
+
+// Unmaps the view and closes the file.
+void MemoryMappedFile::Close() noexcept
+{
+    mView.reset();
+#ifdef _WIN32
+    mMapping.reset();
+    mFile.reset();
+#endif
+    mData = nullptr;
+    mSize = 0;
+}
+
+#ifndef _WIN32
+void MemoryMappedFile::view_unmapper::operator()(void* p) const noexcept
+{
+    if (p)
+        munmap(p, size);
+}
+#endif
@@ -0,0 +1,63 @@
+//--------------------------------------------------------------------------------------
+// File: MemoryMappedFile.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "PlatformHelpers.h"
+
+
+namespace DirectX
+{
+    // Read-only view of an entire file mapped into the address space, so loaders can
+    // hand file contents straight to CreateBuffer/CreateTexture without a heap copy.
+    // Uses file mappings on Windows and mmap elsewhere.
+    class MemoryMappedFile
+    {
+    public:
+        MemoryMappedFile() noexcept : mData(nullptr), mSize(0) {}
+
+        MemoryMappedFile(MemoryMappedFile&&) = default;
+        MemoryMappedFile& operator= (MemoryMappedFile&&) = default;
+
+        MemoryMappedFile(MemoryMappedFile const&) = delete;
+        MemoryMappedFile& operator= (MemoryMappedFile const&) = delete;
+
+        ~MemoryMappedFile() = default;
+
+        HRESULT __cdecl Open(_In_z_ wchar_t const* fileName) noexcept;
+        void __cdecl Close() noexcept;
+
+        uint8_t const* GetData() const noexcept { return mData; }
+        size_t GetSize() const noexcept { return mSize; }
+
+    private:
+    #ifdef _WIN32
+        struct view_unmapper { void operator()(void* p) noexcept { if (p) UnmapViewOfFile(p); } };
+
+        ScopedHandle                            mFile;
+        ScopedHandle                            mMapping;
+    #else
+        // munmap needs the length of the mapping; the descriptor is closed once mapped.
+        struct view_unmapper
+        {
+            size_t size;
+            void operator()(void* p) const noexcept;
+        };
+    #endif
+
+        std::unique_ptr<void, view_unmapper>    mView;
+        uint8_t const*                          mData;
+        size_t                                  mSize;
+    };
+}
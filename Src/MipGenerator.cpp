@@ -0,0 +1,156 @@
+//--------------------------------------------------------------------------------------
+// File: MipGenerator.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "MipGenerator.h"
+#include "LoaderHelpers.h"
+#include "PixelConvert.h"
+
+#include <new>
+
+using namespace DirectX;
+using namespace DirectX::LoaderHelpers;
+
+namespace
+{
+    PIXEL_LAYOUT GetPixelLayout(DXGI_FORMAT format) noexcept
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            return PIXEL_LAYOUT_RGBA8;
+
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            return PIXEL_LAYOUT_BGRA8;
+
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            return PIXEL_LAYOUT_BGRX8;
+
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            return PIXEL_LAYOUT_RGBA16F;
+
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            return PIXEL_LAYOUT_RGBA32F;
+
+        case DXGI_FORMAT_R32_FLOAT:
+            return PIXEL_LAYOUT_R32F;
+
+        default:
+            return PIXEL_LAYOUT_UNKNOWN;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+bool DirectX::IsCPUMipFormatSupported(DXGI_FORMAT format) noexcept
+{
+    return GetPixelLayout(format) != PIXEL_LAYOUT_UNKNOWN;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GenerateMipChain(
+    const uint8_t* pixels,
+    size_t rowPitch,
+    size_t width,
+    size_t height,
+    DXGI_FORMAT format,
+    size_t mipLevels,
+    MIP_FILTER filter,
+    bool straightAlpha,
+    std::unique_ptr<uint8_t[]>& mipData,
+    D3D11_SUBRESOURCE_DATA* initData) noexcept
+{
+    mipData.reset();
+
+    if (!pixels || !initData)
+        return E_POINTER;
+
+    if (!width || !height || width > UINT32_MAX || height > UINT32_MAX || !mipLevels)
+        return E_INVALIDARG;
+
+    if (mipLevels > CountMips(static_cast<uint32_t>(width), static_cast<uint32_t>(height)))
+        return E_INVALIDARG;
+
+    if (!IsCPUMipFormatSupported(format))
+        return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+    const size_t bytesPerPixel = BitsPerPixel(format) / 8;
+    if (rowPitch < width * bytesPerPixel)
+        return E_INVALIDARG;
+
+    const uint64_t imageBytes = uint64_t(rowPitch) * height;
+    if (rowPitch > UINT32_MAX || imageBytes > UINT32_MAX)
+        return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+
+    initData[0].pSysMem = pixels;
+    initData[0].SysMemPitch = static_cast<UINT>(rowPitch);
+    initData[0].SysMemSlicePitch = static_cast<UINT>(imageBytes);
+
+    if (mipLevels == 1)
+        return S_OK;
+
+    uint64_t totalBytes = 0;
+    for (size_t level = 1; level < mipLevels; ++level)
+    {
+        const size_t w = std::max<size_t>(1u, width >> level);
+        const size_t h = std::max<size_t>(1u, height >> level);
+        totalBytes += uint64_t(w) * h * bytesPerPixel;
+    }
+
+    if (totalBytes > SIZE_MAX)
+        return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+
+    mipData.reset(new (std::nothrow) uint8_t[static_cast<size_t>(totalBytes)]);
+    if (!mipData)
+        return E_OUTOFMEMORY;
+
+    // Without straightAlpha the data is filtered as it is, exactly as if it were premultiplied
+    uint32_t flags = straightAlpha ? PIXEL_DEFAULT : PIXEL_PREMULTIPLIED;
+    if (MakeLinear(format) != format)
+    {
+        flags |= PIXEL_SRGB;
+    }
+
+    PixelImage src = { pixels, rowPitch, width, height, GetPixelLayout(format), flags };
+    uint8_t* dest = mipData.get();
+
+    for (size_t level = 1; level < mipLevels; ++level)
+    {
+        const size_t w = std::max<size_t>(1u, src.width >> 1);
+        const size_t h = std::max<size_t>(1u, src.height >> 1);
+        const size_t pitch = w * bytesPerPixel;
+
+        // Each level comes from the one above it, which is cheaper than filtering from the top
+        HRESULT hr = ResizePixels(src, dest, pitch, w, h, src.layout, flags,
+            (filter == MIP_FILTER_KAISER) ? RESIZE_FILTER_KAISER : RESIZE_FILTER_BOX);
+        if (FAILED(hr))
+        {
+            mipData.reset();
+            return hr;
+        }
+
+        initData[level].pSysMem = dest;
+        initData[level].SysMemPitch = static_cast<UINT>(pitch);
+        initData[level].SysMemSlicePitch = static_cast<UINT>(pitch * h);
+
+        src.pixels = dest;
+        src.rowPitch = pitch;
+        src.width = w;
+        src.height = h;
+        dest += pitch * h;
+    }
+
+    return S_OK;
+}
@@ -0,0 +1,50 @@
+//--------------------------------------------------------------------------------------
+// File: MipGenerator.h
+//
+// Helper for building mipmap chains on the CPU, for loaders which can't use
+// GenerateMips (no immediate context, or no autogen support for the format)
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+namespace DirectX
+{
+    enum MIP_FILTER : uint32_t
+    {
+        MIP_FILTER_BOX = 0,         // Area average; fast, slightly soft
+        MIP_FILTER_KAISER = 1,      // Kaiser-windowed sinc; sharper, several times the work
+    };
+
+    // R8G8B8A8, B8G8R8A8, B8G8R8X8 (and their sRGB forms), R16G16B16A16_FLOAT,
+    // R32G32B32A32_FLOAT, and R32_FLOAT.
+    bool IsCPUMipFormatSupported(DXGI_FORMAT format) noexcept;
+
+    // Builds levels 1 to mipLevels - 1 of a 2D image from its level 0, each level filtered
+    // from the one above it. sRGB formats are filtered in linear space. With straightAlpha
+    // the color channels are weighted by alpha while filtering so fully transparent texels
+    // don't bleed into their neighbours; leave it off for premultiplied or non-color data.
+    //
+    // initData receives mipLevels entries: level 0 pointing at pixels, the rest into
+    // mipData, which must be kept alive until the texture has been created.
+    HRESULT GenerateMipChain(
+        _In_ const uint8_t* pixels,
+        size_t rowPitch,
+        size_t width,
+        size_t height,
+        DXGI_FORMAT format,
+        size_t mipLevels,
+        MIP_FILTER filter,
+        bool straightAlpha,
+        std::unique_ptr<uint8_t[]>& mipData,
+        _Out_writes_(mipLevels) D3D11_SUBRESOURCE_DATA* initData) noexcept;
+}
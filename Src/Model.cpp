@@ -13,8 +13,11 @@
 #include "DirectXHelpers.h"
 #include "Effects.h"
 #include "PlatformHelpers.h"
+#include "ModelBVH.h"
+#include "StateFilter.h"
 
 using namespace DirectX;
+using Microsoft::WRL::ComPtr;
 
 #if !defined(_CPPRTTI) && !defined(__GXX_RTTI)
 #error Model requires RTTI
@@ -49,15 +52,17 @@ void ModelMeshPart::Draw(
     ID3D11InputLayout* iinputLayout,
     std::function<void()> setCustomState) const
 {
-    deviceContext->IASetInputLayout(iinputLayout);
+    StateFilter filter(deviceContext);
+
+    filter.IASetInputLayout(iinputLayout);
 
     auto vb = vertexBuffer.Get();
     const UINT vbStride = vertexStride;
     constexpr UINT vbOffset = 0;
-    deviceContext->IASetVertexBuffers(0, 1, &vb, &vbStride, &vbOffset);
+    filter.IASetVertexBuffers(0, 1, &vb, &vbStride, &vbOffset);
 
     // Note that if indexFormat is DXGI_FORMAT_R32_UINT, this model mesh part requires a Feature Level 9.2 or greater device
-    deviceContext->IASetIndexBuffer(indexBuffer.Get(), indexFormat, 0);
+    filter.IASetIndexBuffer(indexBuffer.Get(), indexFormat, 0);
 
     assert(ieffect != nullptr);
     ieffect->Apply(deviceContext);
@@ -66,10 +71,11 @@ void ModelMeshPart::Draw(
     if (setCustomState)
     {
         setCustomState();
+        filter.Invalidate();
     }
 
     // Draw the primitive.
-    deviceContext->IASetPrimitiveTopology(primitiveType);
+    filter.IASetPrimitiveTopology(primitiveType);
 
     deviceContext->DrawIndexed(indexCount, startIndex, vertexOffset);
 }
@@ -84,15 +90,17 @@ void ModelMeshPart::DrawInstanced(
     uint32_t instanceCount, uint32_t startInstanceLocation,
     std::function<void()> setCustomState) const
 {
-    deviceContext->IASetInputLayout(iinputLayout);
+    StateFilter filter(deviceContext);
+
+    filter.IASetInputLayout(iinputLayout);
 
     auto vb = vertexBuffer.Get();
     const UINT vbStride = vertexStride;
     constexpr UINT vbOffset = 0;
-    deviceContext->IASetVertexBuffers(0, 1, &vb, &vbStride, &vbOffset);
+    filter.IASetVertexBuffers(0, 1, &vb, &vbStride, &vbOffset);
 
     // Note that if indexFormat is DXGI_FORMAT_R32_UINT, this model mesh part requires a Feature Level 9.2 or greater device
-    deviceContext->IASetIndexBuffer(indexBuffer.Get(), indexFormat, 0);
+    filter.IASetIndexBuffer(indexBuffer.Get(), indexFormat, 0);
 
     assert(ieffect != nullptr);
     ieffect->Apply(deviceContext);
@@ -101,10 +109,11 @@ void ModelMeshPart::DrawInstanced(
     if (setCustomState)
     {
         setCustomState();
+        filter.Invalidate();
     }
 
     // Draw the primitive.
-    deviceContext->IASetPrimitiveTopology(primitiveType);
+    filter.IASetPrimitiveTopology(primitiveType);
 
     deviceContext->DrawIndexedInstanced(
         indexCount, instanceCount, startIndex,
@@ -159,6 +168,36 @@ void ModelMeshPart::ModifyEffect(ID3D11Device* d3dDevice, const std::shared_ptr<
 }
 
 
+// Builds the ray picking hierarchy from CPU copies of the buffers.
+_Use_decl_annotations_
+void ModelMeshPart::CreatePickingBVH(
+    const XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+    const void* indices, size_t totalIndexCount)
+{
+    if (!positions || !indices)
+        throw std::invalid_argument("Positions and indices cannot be null");
+
+    if (primitiveType != D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+        throw std::runtime_error("Picking data requires a triangle list");
+
+    if (indexFormat != DXGI_FORMAT_R16_UINT && indexFormat != DXGI_FORMAT_R32_UINT)
+        throw std::runtime_error("Picking data requires 16-bit or 32-bit indices");
+
+    if (startIndex > totalIndexCount || indexCount > (totalIndexCount - startIndex))
+        throw std::out_of_range("Mesh part index range is outside the index data");
+
+    const bool indices32 = (indexFormat == DXGI_FORMAT_R32_UINT);
+
+    auto ib = static_cast<const uint8_t*>(indices) + size_t(startIndex) * (indices32 ? sizeof(uint32_t) : sizeof(uint16_t));
+
+    // Each vertexOffset + index is checked against vertexCount; a negative offset is legal.
+    auto bvh = std::make_shared<ModelBVH>();
+    bvh->Build(positions, positionStride, vertexCount, ib, indices32, indexCount, vertexOffset);
+
+    pickingBVH = std::move(bvh);
+}
+
+
 //--------------------------------------------------------------------------------------
 // ModelMesh
 //--------------------------------------------------------------------------------------
@@ -188,6 +227,8 @@ void ModelMesh::PrepareForRendering(
 {
     assert(deviceContext != nullptr);
 
+    StateFilter filter(deviceContext);
+
     // Set the blend and depth stencil state.
     ID3D11BlendState* blendState;
     ID3D11DepthStencilState* depthStencilState;
@@ -210,14 +251,14 @@ void ModelMesh::PrepareForRendering(
         depthStencilState = (s_reversez) ? states.DepthReverseZ() : states.DepthDefault();
     }
 
-    deviceContext->OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
-    deviceContext->OMSetDepthStencilState(depthStencilState, 0);
+    filter.OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
+    filter.OMSetDepthStencilState(depthStencilState, 0);
 
     // Set the rasterizer state.
     if (wireframe)
-        deviceContext->RSSetState(states.Wireframe());
+        filter.RSSetState(states.Wireframe());
     else
-        deviceContext->RSSetState(ccw ? states.CullCounterClockwise() : states.CullClockwise());
+        filter.RSSetState(ccw ? states.CullCounterClockwise() : states.CullClockwise());
 
     // Set sampler state.
     ID3D11SamplerState* samplers[] =
@@ -226,7 +267,7 @@ void ModelMesh::PrepareForRendering(
         states.LinearWrap(),
     };
 
-    deviceContext->PSSetSamplers(0, 2, samplers);
+    filter.PSSetSamplers(0, 2, samplers);
 }
 
 
@@ -408,6 +449,56 @@ void XM_CALLCONV ModelMesh::DrawSkinned(
 // Model
 //--------------------------------------------------------------------------------------
 
+// Draw lists along with the parts they were built from, in mesh order.
+struct Model::DrawLists
+{
+    struct Source
+    {
+        const ModelMesh*        mesh;
+        const ModelMeshPart*    part;
+        const IEffect*          effect;
+        bool                    isAlpha;
+    };
+
+    std::vector<DrawItem>   opaque;
+    std::vector<DrawItem>   alpha;
+    std::vector<Source>     sources;
+
+    // True if the model still has exactly the parts and effects the lists were built from. Only the
+    // live meshes are dereferenced, so stale items are detected without touching freed parts.
+    bool Matches(const ModelMesh::Collection& meshes) const noexcept
+    {
+        size_t k = 0;
+        for (const auto& mit : meshes)
+        {
+            const auto mesh = mit.get();
+            for (const auto& it : mesh->meshParts)
+            {
+                const auto part = it.get();
+                if (k >= sources.size())
+                    return false;
+
+                const auto& src = sources[k++];
+                if (src.mesh != mesh
+                    || src.part != part
+                    || src.effect != part->effect.get()
+                    || src.isAlpha != part->isAlpha)
+                    return false;
+            }
+        }
+
+        return k == sources.size();
+    }
+};
+
+
+namespace
+{
+    // Guards publishing the draw lists; they are built outside the lock and never modified once shared.
+    std::mutex s_drawListsMutex;
+}
+
+
 Model::~Model()
 {
 }
@@ -445,6 +536,7 @@ Model& Model::operator= (Model const& rhs)
         std::swap(invBindPoseMatrices, tmp.invBindPoseMatrices);
         std::swap(name, tmp.name);
         std::swap(mEffectCache, tmp.mEffectCache);
+        std::swap(mDrawLists, tmp.mDrawLists);
     }
     return *this;
 }
@@ -463,27 +555,75 @@ void XM_CALLCONV Model::Draw(
 {
     assert(deviceContext != nullptr);
 
-    // Draw opaque parts
-    for (const auto& it : meshes)
+    const auto lists = GetDrawLists();
+
+    auto setEffect = [&](const DrawItem& item)
     {
-        const auto *mesh = it.get();
-        assert(mesh != nullptr);
+        if (item.matrices)
+        {
+            item.matrices->SetMatrices(world, view, projection);
+        }
+    };
+
+    // Draw opaque parts
+    DrawParts(deviceContext, states, *lists, false, wireframe, nullptr, 0, setEffect, setCustomState);
+
+    // Draw alpha parts
+    DrawParts(deviceContext, states, *lists, true, wireframe, nullptr, 0, setEffect, setCustomState);
+}
+
+
+// Draw all meshes in model which pass a frustum test given worldViewProjection matrices.
+_Use_decl_annotations_
+void XM_CALLCONV Model::Draw(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    const BoundingFrustum& frustum,
+    bool wireframe,
+    std::function<void()> setCustomState) const
+{
+    assert(deviceContext != nullptr);
 
-        mesh->PrepareForRendering(deviceContext, states, false, wireframe);
+    const size_t nmeshes = meshes.size();
+    if (!nmeshes)
+        return;
 
-        mesh->Draw(deviceContext, world, view, projection, false, setCustomState);
+    uint8_t localVisible[64] = {};
+    std::unique_ptr<uint8_t[]> heapVisible;
+    uint8_t* visible = localVisible;
+    if (nmeshes > std::size(localVisible))
+    {
+        heapVisible = std::make_unique<uint8_t[]>(nmeshes);
+        visible = heapVisible.get();
     }
 
-    // Draw alpha parts
-    for (const auto& it : meshes)
+    const XMMATRIX instance = world;
+    const size_t drawn = CullMeshes(frustum, 1, &instance, visible);
+
+    mCullStats.meshesDrawn += drawn;
+    mCullStats.meshesCulled += nmeshes - drawn;
+
+    if (!drawn)
+        return;
+
+    const auto lists = GetDrawLists();
+
+    auto setEffect = [&](const DrawItem& item)
     {
-        const auto *mesh = it.get();
-        assert(mesh != nullptr);
+        if (item.matrices)
+        {
+            item.matrices->SetMatrices(world, view, projection);
+        }
+    };
 
-        mesh->PrepareForRendering(deviceContext, states, true, wireframe);
+    // Draw opaque parts
+    DrawParts(deviceContext, states, *lists, false, wireframe, visible, 0, setEffect, setCustomState);
 
-        mesh->Draw(deviceContext, world, view, projection, true, setCustomState);
-    }
+    // Draw alpha parts
+    DrawParts(deviceContext, states, *lists, true, wireframe, visible, 0, setEffect, setCustomState);
 }
 
 
@@ -502,27 +642,34 @@ void XM_CALLCONV Model::Draw(
 {
     assert(deviceContext != nullptr);
 
-    // Draw opaque parts
-    for (const auto& it : meshes)
+    if (!nbones || !boneTransforms)
     {
-        const auto *mesh = it.get();
-        assert(mesh != nullptr);
-
-        mesh->PrepareForRendering(deviceContext, states, false, wireframe);
-
-        mesh->Draw(deviceContext, nbones, boneTransforms, world, view, projection, false, setCustomState);
+        throw std::invalid_argument("Bone transforms array required");
     }
 
-    // Draw alpha parts
-    for (const auto& it : meshes)
+    const auto lists = GetDrawLists();
+
+    auto setEffect = [&](const DrawItem& item)
     {
-        const auto *mesh = it.get();
-        assert(mesh != nullptr);
+        if (item.matrices)
+        {
+            const uint32_t boneIndex = item.mesh->boneIndex;
+            if (boneIndex != ModelBone::c_Invalid && boneIndex < nbones)
+            {
+                item.matrices->SetMatrices(XMMatrixMultiply(boneTransforms[boneIndex], world), view, projection);
+            }
+            else
+            {
+                item.matrices->SetMatrices(world, view, projection);
+            }
+        }
+    };
 
-        mesh->PrepareForRendering(deviceContext, states, true, wireframe);
+    // Draw opaque parts
+    DrawParts(deviceContext, states, *lists, false, wireframe, nullptr, 0, setEffect, setCustomState);
 
-        mesh->Draw(deviceContext, nbones, boneTransforms, world, view, projection, true, setCustomState);
-    }
+    // Draw alpha parts
+    DrawParts(deviceContext, states, *lists, true, wireframe, nullptr, 0, setEffect, setCustomState);
 }
 
 
@@ -541,27 +688,606 @@ void XM_CALLCONV Model::DrawSkinned(
 {
     assert(deviceContext != nullptr);
 
+    if (!nbones || !boneTransforms)
+    {
+        throw std::invalid_argument("Bone transforms array required");
+    }
+
+    const auto lists = GetDrawLists();
+
+    ModelBone::TransformArray temp;
+    const ModelMesh* tempMesh = nullptr;
+
+    auto setEffect = [&](const DrawItem& item)
+    {
+        if (item.matrices)
+        {
+            item.matrices->SetMatrices(world, view, projection);
+        }
+
+        if (item.skinning)
+        {
+            const auto& boneInfluences = item.mesh->boneInfluences;
+            if (boneInfluences.empty())
+            {
+                // Direct-mapping of vertex bone indices to our master bone array
+                item.skinning->SetBoneTransforms(boneTransforms, nbones);
+            }
+            else
+            {
+                if (tempMesh != item.mesh)
+                {
+                    // Create the influence mapped bones on-demand.
+                    if (boneInfluences.size() > IEffectSkinning::MaxBones)
+                    {
+                        throw std::runtime_error("Too many bones for skinning");
+                    }
+
+                    if (!temp)
+                    {
+                        temp = ModelBone::MakeArray(IEffectSkinning::MaxBones);
+                    }
+
+                    size_t count = 0;
+                    for (auto it : boneInfluences)
+                    {
+                        if (it >= nbones)
+                        {
+                            throw std::runtime_error("Invalid bone influence index");
+                        }
+
+                        temp[count++] = boneTransforms[it];
+                    }
+
+                    tempMesh = item.mesh;
+                }
+
+                item.skinning->SetBoneTransforms(temp.get(), boneInfluences.size());
+            }
+        }
+        else if (item.matrices)
+        {
+            // Fallback for if we encounter a non-skinning effect in the model
+            const uint32_t boneIndex = item.mesh->boneIndex;
+            const XMMATRIX bm = (boneIndex != ModelBone::c_Invalid && boneIndex < nbones)
+                ? boneTransforms[boneIndex] : XMMatrixIdentity();
+
+            item.matrices->SetWorld(XMMatrixMultiply(bm, world));
+        }
+    };
+
     // Draw opaque parts
-    for (const auto& it : meshes)
+    DrawParts(deviceContext, states, *lists, false, wireframe, nullptr, 0, setEffect, setCustomState);
+
+    // Draw alpha parts
+    DrawParts(deviceContext, states, *lists, true, wireframe, nullptr, 0, setEffect, setCustomState);
+}
+
+
+// Private helper for getting draw lists that match the current parts.
+std::shared_ptr<const Model::DrawLists> Model::GetDrawLists() const
+{
+    std::shared_ptr<const DrawLists> lists;
+    {
+        std::lock_guard<std::mutex> lock(s_drawListsMutex);
+        lists = mDrawLists;
+    }
+
+    if (lists && lists->Matches(meshes))
+        return lists;
+
+    lists = BuildDrawLists();
+
     {
-        const auto *mesh = it.get();
+        std::lock_guard<std::mutex> lock(s_drawListsMutex);
+        mDrawLists = lists;
+    }
+
+    return lists;
+}
+
+
+// Private helper for building the flattened draw lists.
+std::shared_ptr<const Model::DrawLists> Model::BuildDrawLists() const
+{
+    auto lists = std::make_shared<DrawLists>();
+
+    for (size_t j = 0; j < meshes.size(); ++j)
+    {
+        const auto mesh = meshes[j].get();
         assert(mesh != nullptr);
 
-        mesh->PrepareForRendering(deviceContext, states, false, wireframe);
+        for (const auto& it : mesh->meshParts)
+        {
+            const auto part = it.get();
+            assert(part != nullptr);
+
+            DrawItem item = {};
+            item.mesh = mesh;
+            item.part = part;
+            item.matrices = dynamic_cast<IEffectMatrices*>(part->effect.get());
+            item.skinning = dynamic_cast<IEffectSkinning*>(part->effect.get());
+            item.meshIndex = j;
+
+            if (part->isAlpha)
+            {
+                lists->alpha.emplace_back(item);
+            }
+            else
+            {
+                lists->opaque.emplace_back(item);
+            }
 
-        mesh->DrawSkinned(deviceContext, nbones, boneTransforms, world, view, projection, false, setCustomState);
+            lists->sources.emplace_back(DrawLists::Source{ mesh, part, part->effect.get(), part->isAlpha });
+        }
     }
 
+    // Opaque parts are grouped by winding and then effect, input layout, and buffers to minimize state changes.
+    // Alpha parts are left in mesh order.
+    std::stable_sort(lists->opaque.begin(), lists->opaque.end(),
+        [](const DrawItem& a, const DrawItem& b) noexcept
+        {
+            if (a.mesh->ccw != b.mesh->ccw)
+                return a.mesh->ccw;
+
+            const void* akeys[] = { a.part->effect.get(), a.part->inputLayout.Get(), a.part->vertexBuffer.Get(), a.part->indexBuffer.Get() };
+            const void* bkeys[] = { b.part->effect.get(), b.part->inputLayout.Get(), b.part->vertexBuffer.Get(), b.part->indexBuffer.Get() };
+
+            for (size_t k = 0; k < std::size(akeys); ++k)
+            {
+                if (akeys[k] != bkeys[k])
+                    return std::less<const void*>()(akeys[k], bkeys[k]);
+            }
+
+            return false;
+        });
+
+    return lists;
+}
+
+
+// Private helper for drawing the opaque or alpha parts from the draw lists.
+template<typename TSetEffect>
+void Model::DrawParts(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    const DrawLists& lists,
+    bool alpha,
+    bool wireframe,
+    const uint8_t* visible,
+    uint32_t instanceCount,
+    TSetEffect& setEffect,
+    const std::function<void()>& setCustomState) const
+{
+    const ModelMesh* prepared = nullptr;
+
+    for (const auto& item : (alpha) ? lists.alpha : lists.opaque)
+    {
+        if (visible && !visible[item.meshIndex])
+            continue;
+
+        // Opaque state only depends on the winding, but alpha state also depends on the blend mode of the mesh.
+        // A custom state callback may have changed any of it for the previous part, so then it is always reapplied.
+        if (!prepared
+            || setCustomState
+            || (alpha && prepared != item.mesh)
+            || (prepared->ccw != item.mesh->ccw))
+        {
+            item.mesh->PrepareForRendering(deviceContext, states, alpha, wireframe);
+            prepared = item.mesh;
+        }
+
+        setEffect(item);
+
+        if (instanceCount > 0)
+        {
+            item.part->DrawInstanced(deviceContext, item.part->effect.get(), item.part->inputLayout.Get(), instanceCount, 0, setCustomState);
+        }
+        else
+        {
+            item.part->Draw(deviceContext, item.part->effect.get(), item.part->inputLayout.Get(), setCustomState);
+        }
+    }
+}
+
+
+// Draw all meshes in model using instancing given an array of 3x4 instance transforms.
+_Use_decl_annotations_
+void XM_CALLCONV Model::DrawInstanced(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    size_t ninstances,
+    const XMFLOAT3X4* instanceTransforms,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe,
+    std::function<void()> setCustomState) const
+{
+    assert(deviceContext != nullptr);
+
+    if (!ninstances)
+        return;
+
+    if (!instanceTransforms)
+    {
+        throw std::invalid_argument("Instance transforms array required");
+    }
+
+    CreateInstanceBuffer(deviceContext, ninstances);
+
+    {
+        MapGuard map(deviceContext, mInstanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0);
+
+        memcpy(map.pData, instanceTransforms, sizeof(XMFLOAT3X4) * ninstances);
+    }
+
+    DrawInstancedParts(deviceContext, states, ninstances, world, view, projection, wireframe, setCustomState);
+}
+
+
+// Draw all meshes in model using instancing given an array of instance transform matrices.
+_Use_decl_annotations_
+void XM_CALLCONV Model::DrawInstanced(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    size_t ninstances,
+    const XMMATRIX* instanceTransforms,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe,
+    std::function<void()> setCustomState) const
+{
+    assert(deviceContext != nullptr);
+
+    if (!ninstances)
+        return;
+
+    if (!instanceTransforms)
+    {
+        throw std::invalid_argument("Instance transforms array required");
+    }
+
+    CreateInstanceBuffer(deviceContext, ninstances);
+
+    {
+        MapGuard map(deviceContext, mInstanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0);
+
+        auto dest = static_cast<XMFLOAT3X4*>(map.pData);
+        for (size_t j = 0; j < ninstances; ++j)
+        {
+            XMStoreFloat3x4(&dest[j], instanceTransforms[j]);
+        }
+    }
+
+    DrawInstancedParts(deviceContext, states, ninstances, world, view, projection, wireframe, setCustomState);
+}
+
+
+// Private helper for ensuring the instance buffer is large enough.
+_Use_decl_annotations_
+void Model::CreateInstanceBuffer(ID3D11DeviceContext* deviceContext, size_t ninstances) const
+{
+    if (mInstanceBuffer && ninstances <= mInstanceCapacity)
+        return;
+
+    const uint64_t maxInstances = uint64_t(D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM) * 1024u * 1024u / sizeof(XMFLOAT3X4);
+    if (ninstances > maxInstances)
+    {
+        throw std::invalid_argument("Too many instances for DirectX 11");
+    }
+
+    // Grow by powers of two to avoid re-creating the buffer each time the instance count increases
+    size_t capacity = 256;
+    while (capacity < ninstances)
+    {
+        capacity <<= 1;
+    }
+    capacity = static_cast<size_t>(std::min<uint64_t>(capacity, maxInstances));
+
+    ComPtr<ID3D11Device> device;
+    deviceContext->GetDevice(device.GetAddressOf());
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.ByteWidth = static_cast<UINT>(capacity * sizeof(XMFLOAT3X4));
+    desc.Usage = D3D11_USAGE_DYNAMIC;
+    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    ThrowIfFailed(
+        device->CreateBuffer(&desc, nullptr, mInstanceBuffer.ReleaseAndGetAddressOf())
+    );
+
+    SetDebugObjectName(mInstanceBuffer.Get(), "ModelInstances");
+
+    mInstanceCapacity = capacity;
+}
+
+
+// Private helper for drawing all parts with the instance buffer bound to the second input slot.
+_Use_decl_annotations_
+void XM_CALLCONV Model::DrawInstancedParts(
+    ID3D11DeviceContext* deviceContext,
+    const CommonStates& states,
+    size_t ninstances,
+    FXMMATRIX world,
+    CXMMATRIX view,
+    CXMMATRIX projection,
+    bool wireframe,
+    const std::function<void()>& setCustomState) const
+{
+    StateFilter filter(deviceContext);
+
+    const auto lists = GetDrawLists();
+
+    auto ib = mInstanceBuffer.Get();
+    constexpr UINT ibStride = sizeof(XMFLOAT3X4);
+    constexpr UINT ibOffset = 0;
+    filter.IASetVertexBuffers(1, 1, &ib, &ibStride, &ibOffset);
+
+    auto setEffect = [&](const DrawItem& item)
+    {
+        if (item.matrices)
+        {
+            item.matrices->SetMatrices(world, view, projection);
+        }
+    };
+
+    const auto instanceCount = static_cast<uint32_t>(ninstances);
+
+    // Draw opaque parts
+    DrawParts(deviceContext, states, *lists, false, wireframe, nullptr, instanceCount, setEffect, setCustomState);
+
     // Draw alpha parts
-    for (const auto& it : meshes)
+    DrawParts(deviceContext, states, *lists, true, wireframe, nullptr, instanceCount, setEffect, setCustomState);
+}
+
+
+// Enable instancing on all effects and extend the vertex input layouts with per-instance transforms.
+_Use_decl_annotations_
+void Model::EnableInstancing(ID3D11Device* device)
+{
+    if (!device)
     {
-        const auto *mesh = it.get();
+        throw std::invalid_argument("Direct3D device is null");
+    }
+
+    static const D3D11_INPUT_ELEMENT_DESC s_instElements[] =
+    {
+        { "InstMatrix", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1,  0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "InstMatrix", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "InstMatrix", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    };
+
+    // Input element collections are often shared by parts, so the extended versions are shared as well
+    std::map<const ModelMeshPart::InputLayoutCollection*, std::shared_ptr<ModelMeshPart::InputLayoutCollection>> decls;
+
+    // Validate every part before touching any of them so an unsupported effect doesn't leave the model half converted
+    for (const auto& mit : meshes)
+    {
+        auto mesh = mit.get();
         assert(mesh != nullptr);
 
-        mesh->PrepareForRendering(deviceContext, states, true, wireframe);
+        for (const auto& it : mesh->meshParts)
+        {
+            auto part = it.get();
+            assert(part != nullptr);
+
+            auto effect = part->effect.get();
+            if (!dynamic_cast<NormalMapEffect*>(effect)
+                && !dynamic_cast<PBREffect*>(effect)
+                && !dynamic_cast<DebugEffect*>(effect))
+            {
+                throw std::runtime_error("Model mesh part effect does not support instancing");
+            }
 
-        mesh->DrawSkinned(deviceContext, nbones, boneTransforms, world, view, projection, true, setCustomState);
+            if (!part->vbDecl || part->vbDecl->empty())
+                throw std::runtime_error("Model mesh part missing vertex buffer input elements data");
+
+            auto& decl = decls[part->vbDecl.get()];
+            if (!decl)
+            {
+                const bool hasInstancing = std::any_of(part->vbDecl->cbegin(), part->vbDecl->cend(),
+                    [](const D3D11_INPUT_ELEMENT_DESC& desc) noexcept { return desc.InputSlot == 1; });
+
+                if (hasInstancing)
+                {
+                    decl = part->vbDecl;
+                }
+                else
+                {
+                    decl = std::make_shared<ModelMeshPart::InputLayoutCollection>(*part->vbDecl);
+                    decl->insert(decl->end(), std::cbegin(s_instElements), std::cend(s_instElements));
+                }
+
+                if (decl->size() > 32 /* D3D11_IA_VERTEX_INPUT_STRUCTURE_ELEMENT_COUNT */)
+                    throw std::runtime_error("Model mesh part input layout size is too large for DirectX 11");
+            }
+        }
     }
+
+    // The layouts are created against the instanced shaders, and are only assigned once all of them succeed
+    std::vector<ComPtr<ID3D11InputLayout>> layouts;
+
+    for (const auto& mit : meshes)
+    {
+        for (const auto& it : mit->meshParts)
+        {
+            auto effect = it->effect.get();
+            if (auto nmap = dynamic_cast<NormalMapEffect*>(effect))
+            {
+                nmap->SetInstancingEnabled(true);
+            }
+            else if (auto pbr = dynamic_cast<PBREffect*>(effect))
+            {
+                pbr->SetInstancingEnabled(true);
+            }
+            else if (auto debug = dynamic_cast<DebugEffect*>(effect))
+            {
+                debug->SetInstancingEnabled(true);
+            }
+
+            const auto& decl = decls[it->vbDecl.get()];
+
+            ComPtr<ID3D11InputLayout> layout;
+            ThrowIfFailed(
+                CreateInputLayoutFromEffect(device, effect, decl->data(), decl->size(), layout.GetAddressOf())
+            );
+
+            layouts.emplace_back(std::move(layout));
+        }
+    }
+
+    size_t index = 0;
+    for (const auto& mit : meshes)
+    {
+        for (const auto& it : mit->meshParts)
+        {
+            it->vbDecl = decls[it->vbDecl.get()];
+            it->inputLayout = std::move(layouts[index++]);
+        }
+    }
+
+    Modified();
+}
+
+
+// Test mesh bounding spheres for a set of model instances against a frustum.
+_Use_decl_annotations_
+size_t Model::CullMeshes(
+    const BoundingFrustum& frustum,
+    size_t ninstances,
+    const XMMATRIX* worlds,
+    uint8_t* visible) const
+{
+    if (!ninstances || !worlds || !visible)
+    {
+        throw std::invalid_argument("World transforms and visibility arrays required");
+    }
+
+    // Frustum planes face outward, so a sphere is culled if its center is further than its radius in front of any plane
+    XMVECTOR planes[6];
+    frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+
+    XMVECTOR planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (size_t p = 0; p < 6; ++p)
+    {
+        planeX[p] = XMVectorSplatX(planes[p]);
+        planeY[p] = XMVectorSplatY(planes[p]);
+        planeZ[p] = XMVectorSplatZ(planes[p]);
+        planeW[p] = XMVectorSplatW(planes[p]);
+    }
+
+    const size_t nmeshes = meshes.size();
+
+    size_t count = 0;
+    for (size_t i = 0; i < ninstances; ++i)
+    {
+        const XMMATRIX world = worlds[i];
+
+        // Radius is scaled by the largest axis scale of the world transform
+        XMVECTOR scale = XMVectorMax(XMVector3LengthSq(world.r[0]), XMVector3LengthSq(world.r[1]));
+        scale = XMVectorSqrt(XMVectorMax(scale, XMVector3LengthSq(world.r[2])));
+
+        uint8_t* result = visible + (i * nmeshes);
+
+        // Test four spheres at a time in structure-of-arrays form
+        for (size_t j = 0; j < nmeshes; j += 4)
+        {
+            const size_t n = std::min<size_t>(4, nmeshes - j);
+
+            XMVECTOR centers[4] = { g_XMZero, g_XMZero, g_XMZero, g_XMZero };
+            float radius[4] = {};
+            for (size_t k = 0; k < n; ++k)
+            {
+                auto mesh = meshes[j + k].get();
+                assert(mesh != nullptr);
+
+                centers[k] = XMVector3Transform(XMLoadFloat3(&mesh->boundingSphere.Center), world);
+                radius[k] = mesh->boundingSphere.Radius;
+            }
+
+            const XMMATRIX soa = XMMatrixTranspose(XMMATRIX(centers[0], centers[1], centers[2], centers[3]));
+            const XMVECTOR radii = XMVectorMultiply(XMVectorSet(radius[0], radius[1], radius[2], radius[3]), scale);
+
+            XMVECTOR outside = XMVectorFalseInt();
+            for (size_t p = 0; p < 6; ++p)
+            {
+                XMVECTOR dist = XMVectorMultiplyAdd(planeZ[p], soa.r[2], planeW[p]);
+                dist = XMVectorMultiplyAdd(planeY[p], soa.r[1], dist);
+                dist = XMVectorMultiplyAdd(planeX[p], soa.r[0], dist);
+                outside = XMVectorOrInt(outside, XMVectorGreater(dist, radii));
+            }
+
+            XMUINT4 mask;
+            XMStoreUInt4(&mask, outside);
+
+            const uint32_t lanes[4] = { mask.x, mask.y, mask.z, mask.w };
+            for (size_t k = 0; k < n; ++k)
+            {
+                const bool vis = (lanes[k] == 0);
+                result[j + k] = vis ? 1 : 0;
+                if (vis)
+                    ++count;
+            }
+        }
+    }
+
+    return count;
+}
+
+
+// Ray picking against the mesh part hierarchies.
+_Use_decl_annotations_
+bool XM_CALLCONV Model::Intersects(FXMVECTOR origin, FXMVECTOR direction, FXMMATRIX world, ModelIntersection& hit) const
+{
+    hit = {};
+
+    // Parts are tested in model space. The ray parameter is unchanged by an affine transform, so
+    // the distance found there is also the distance along the world space ray.
+    XMVECTOR det;
+    const XMMATRIX invWorld = XMMatrixInverse(&det, world);
+    if (XMVector3Equal(det, XMVectorZero()))
+        return false;
+
+    const XMVECTOR localOrigin = XMVector3TransformCoord(origin, invWorld);
+    const XMVECTOR localDirection = XMVector3TransformNormal(direction, invWorld);
+
+    bool result = false;
+    float best = FLT_MAX;
+
+    for (const auto& mit : meshes)
+    {
+        auto mesh = mit.get();
+        assert(mesh != nullptr);
+
+        for (const auto& pit : mesh->meshParts)
+        {
+            auto part = pit.get();
+            assert(part != nullptr);
+
+            if (!part->pickingBVH)
+                continue;
+
+            float distance;
+            uint32_t triangle;
+            float u, v;
+            if (part->pickingBVH->Intersects(localOrigin, localDirection, best, distance, triangle, u, v))
+            {
+                best = distance;
+                hit.distance = distance;
+                hit.mesh = mesh;
+                hit.part = part;
+                hit.triangle = triangle;
+                hit.u = u;
+                hit.v = v;
+                result = true;
+            }
+        }
+    }
+
+    return result;
 }
 
 
@@ -0,0 +1,591 @@
+//--------------------------------------------------------------------------------------
+// File: ModelBVH.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "ModelBVH.h"
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr uint32_t c_Bins = 16;
+
+    // SAH splits stop at c_MaxSAHDepth, after which median splits need at most 32 more levels.
+    // Each visited node leaves at most three siblings on the stack.
+    constexpr size_t c_StackSize = 3 * (ModelBVH::c_MaxSAHDepth + 32) + 1;
+
+    struct AABB
+    {
+        float mn[3];
+        float mx[3];
+
+        void Reset() noexcept
+        {
+            mn[0] = mn[1] = mn[2] = FLT_MAX;
+            mx[0] = mx[1] = mx[2] = -FLT_MAX;
+        }
+
+        void Grow(_In_reads_(3) const float* p) noexcept
+        {
+            for (size_t a = 0; a < 3; ++a)
+            {
+                mn[a] = std::min(mn[a], p[a]);
+                mx[a] = std::max(mx[a], p[a]);
+            }
+        }
+
+        void Grow(const AABB& b) noexcept
+        {
+            for (size_t a = 0; a < 3; ++a)
+            {
+                mn[a] = std::min(mn[a], b.mn[a]);
+                mx[a] = std::max(mx[a], b.mx[a]);
+            }
+        }
+
+        // Half the surface area, which is all the SAH needs to compare costs
+        float HalfArea() const noexcept
+        {
+            const float dx = mx[0] - mn[0];
+            const float dy = mx[1] - mn[1];
+            const float dz = mx[2] - mn[2];
+            if (dx < 0.f || dy < 0.f || dz < 0.f)
+                return 0.f;
+
+            return dx * dy + dy * dz + dz * dx;
+        }
+    };
+
+    struct BuildNode
+    {
+        AABB        bounds;
+        uint32_t    left;
+        uint32_t    right;
+        uint32_t    first;
+        uint32_t    count;      // Non-zero for a leaf
+    };
+
+    inline uint32_t BinIndex(float c, float cmin, float scale) noexcept
+    {
+        const auto b = static_cast<int>((c - cmin) * scale);
+        return static_cast<uint32_t>(std::min(std::max(b, 0), int(c_Bins - 1)));
+    }
+
+    // Returns the size of the left half after partitioning by the best binned SAH split, or 0 if
+    // the centroids can't be separated.
+    uint32_t SplitSAH(
+        _Inout_updates_(count) uint32_t* order, uint32_t count,
+        const AABB& cbounds,
+        const std::vector<AABB>& triBounds,
+        const std::vector<XMFLOAT3>& centroids)
+    {
+        float bestCost = FLT_MAX;
+        int bestAxis = -1;
+        uint32_t bestBin = 0;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float extent = cbounds.mx[axis] - cbounds.mn[axis];
+            if (!(extent > 0.f))
+                continue;
+
+            const float cmin = cbounds.mn[axis];
+            const float scale = float(c_Bins) / extent;
+
+            AABB bins[c_Bins];
+            uint32_t binCounts[c_Bins] = {};
+            for (auto& it : bins)
+            {
+                it.Reset();
+            }
+
+            for (uint32_t k = 0; k < count; ++k)
+            {
+                const uint32_t tri = order[k];
+                const uint32_t b = BinIndex((&centroids[tri].x)[axis], cmin, scale);
+                bins[b].Grow(triBounds[tri]);
+                ++binCounts[b];
+            }
+
+            float rightArea[c_Bins];
+            uint32_t rightCount[c_Bins];
+
+            AABB acc;
+            acc.Reset();
+            uint32_t n = 0;
+            for (uint32_t b = c_Bins - 1; b > 0; --b)
+            {
+                acc.Grow(bins[b]);
+                n += binCounts[b];
+                rightArea[b] = acc.HalfArea();
+                rightCount[b] = n;
+            }
+
+            acc.Reset();
+            n = 0;
+            for (uint32_t b = 0; b < c_Bins - 1; ++b)
+            {
+                acc.Grow(bins[b]);
+                n += binCounts[b];
+                if (!n || n == count)
+                    continue;
+
+                const float cost = acc.HalfArea() * float(n) + rightArea[b + 1] * float(rightCount[b + 1]);
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        if (bestAxis < 0)
+            return 0;
+
+        const float cmin = cbounds.mn[bestAxis];
+        const float scale = float(c_Bins) / (cbounds.mx[bestAxis] - cmin);
+
+        auto mid = std::partition(order, order + count,
+            [&](uint32_t tri) noexcept
+            {
+                return BinIndex((&centroids[tri].x)[bestAxis], cmin, scale) <= bestBin;
+            });
+
+        return static_cast<uint32_t>(mid - order);
+    }
+
+    // Splits at the median centroid along the longest axis
+    uint32_t SplitMedian(
+        _Inout_updates_(count) uint32_t* order, uint32_t count,
+        const AABB& cbounds,
+        const std::vector<XMFLOAT3>& centroids)
+    {
+        int axis = 0;
+        float extent = cbounds.mx[0] - cbounds.mn[0];
+        for (int a = 1; a < 3; ++a)
+        {
+            if (cbounds.mx[a] - cbounds.mn[a] > extent)
+            {
+                extent = cbounds.mx[a] - cbounds.mn[a];
+                axis = a;
+            }
+        }
+
+        const uint32_t mid = count / 2;
+        std::nth_element(order, order + mid, order + count,
+            [&](uint32_t a, uint32_t b) noexcept
+            {
+                return (&centroids[a].x)[axis] < (&centroids[b].x)[axis];
+            });
+
+        return mid;
+    }
+}
+
+
+_Use_decl_annotations_
+void ModelBVH::Build(
+    const XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+    const void* indices, bool indices32, size_t indexCount, int32_t baseVertex)
+{
+    if (!positions || !indices)
+        throw std::invalid_argument("Positions and indices cannot be null");
+
+    if (indexCount % 3)
+        throw std::invalid_argument("Index count must be a multiple of 3");
+
+    if (indexCount >= UINT32_MAX || vertexCount >= UINT32_MAX)
+        throw std::invalid_argument("Too many vertices or indices for BVH");
+
+    mNodes.clear();
+    mPositions.clear();
+    mIndices.clear();
+    mTriangleIds.clear();
+
+    const auto triCount = static_cast<uint32_t>(indexCount / 3);
+    if (!triCount)
+        return;
+
+    // Keep a compact copy of just the positions the triangles reference
+    std::vector<uint32_t> remap(vertexCount, c_Empty);
+    std::vector<uint32_t> sourceIndices(indexCount);
+
+    auto vptr = reinterpret_cast<const uint8_t*>(positions);
+    for (size_t j = 0; j < indexCount; ++j)
+    {
+        const int64_t vertex = int64_t(indices32
+            ? static_cast<const uint32_t*>(indices)[j]
+            : static_cast<const uint16_t*>(indices)[j]) + baseVertex;
+
+        if (vertex < 0 || uint64_t(vertex) >= vertexCount)
+            throw std::out_of_range("Invalid index found");
+
+        const auto index = static_cast<size_t>(vertex);
+
+        if (remap[index] == c_Empty)
+        {
+            remap[index] = static_cast<uint32_t>(mPositions.size());
+            mPositions.emplace_back(*reinterpret_cast<const XMFLOAT3*>(vptr + size_t(index) * positionStride));
+        }
+
+        sourceIndices[j] = remap[index];
+    }
+
+    remap = std::vector<uint32_t>();
+
+    std::vector<AABB> triBounds(triCount);
+    std::vector<XMFLOAT3> centroids(triCount);
+    for (uint32_t t = 0; t < triCount; ++t)
+    {
+        AABB& box = triBounds[t];
+        box.Reset();
+        box.Grow(&mPositions[sourceIndices[t * 3]].x);
+        box.Grow(&mPositions[sourceIndices[t * 3 + 1]].x);
+        box.Grow(&mPositions[sourceIndices[t * 3 + 2]].x);
+
+        centroids[t] = XMFLOAT3(
+            (box.mn[0] + box.mx[0]) * 0.5f,
+            (box.mn[1] + box.mx[1]) * 0.5f,
+            (box.mn[2] + box.mx[2]) * 0.5f);
+    }
+
+    // Build a binary tree top-down
+    std::vector<uint32_t> order(triCount);
+    for (uint32_t t = 0; t < triCount; ++t)
+    {
+        order[t] = t;
+    }
+
+    std::vector<BuildNode> nodes;
+    nodes.reserve(size_t(triCount) * 2 / c_LeafSize + 1);
+    nodes.emplace_back();
+
+    struct Task
+    {
+        uint32_t node;
+        uint32_t first;
+        uint32_t count;
+        uint32_t depth;
+    };
+
+    std::vector<Task> tasks;
+    tasks.push_back(Task{ 0, 0, triCount, 0 });
+
+    while (!tasks.empty())
+    {
+        const Task task = tasks.back();
+        tasks.pop_back();
+
+        uint32_t* range = order.data() + task.first;
+
+        AABB bounds;
+        AABB cbounds;
+        bounds.Reset();
+        cbounds.Reset();
+        for (uint32_t k = 0; k < task.count; ++k)
+        {
+            bounds.Grow(triBounds[range[k]]);
+            cbounds.Grow(&centroids[range[k]].x);
+        }
+
+        nodes[task.node].bounds = bounds;
+
+        if (task.count <= c_LeafSize)
+        {
+            nodes[task.node].first = task.first;
+            nodes[task.node].count = task.count;
+            continue;
+        }
+
+        uint32_t mid = 0;
+        if (task.depth < c_MaxSAHDepth)
+        {
+            mid = SplitSAH(range, task.count, cbounds, triBounds, centroids);
+        }
+
+        if (!mid)
+        {
+            mid = SplitMedian(range, task.count, cbounds, centroids);
+        }
+
+        const auto left = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        nodes.emplace_back();
+
+        nodes[task.node].left = left;
+        nodes[task.node].right = left + 1;
+        nodes[task.node].count = 0;
+
+        tasks.push_back(Task{ left, task.first, mid, task.depth + 1 });
+        tasks.push_back(Task{ left + 1, task.first + mid, task.count - mid, task.depth + 1 });
+    }
+
+    triBounds = std::vector<AABB>();
+    centroids = std::vector<XMFLOAT3>();
+
+    // Collapse into 4-wide nodes by repeatedly opening the largest child
+    mNodes.reserve(nodes.size() / 3 + 1);
+    mNodes.emplace_back();
+
+    struct Collapse
+    {
+        uint32_t binary;
+        uint32_t node;
+    };
+
+    std::vector<Collapse> collapse;
+    collapse.push_back(Collapse{ 0, 0 });
+
+    while (!collapse.empty())
+    {
+        const Collapse task = collapse.back();
+        collapse.pop_back();
+
+        uint32_t slots[4] = {};
+        uint32_t n = 0;
+
+        if (nodes[task.binary].count)
+        {
+            slots[n++] = task.binary;
+        }
+        else
+        {
+            slots[n++] = nodes[task.binary].left;
+            slots[n++] = nodes[task.binary].right;
+        }
+
+        while (n < 4)
+        {
+            int largest = -1;
+            float largestArea = -1.f;
+            for (uint32_t i = 0; i < n; ++i)
+            {
+                const BuildNode& c = nodes[slots[i]];
+                if (!c.count && c.bounds.HalfArea() > largestArea)
+                {
+                    largestArea = c.bounds.HalfArea();
+                    largest = static_cast<int>(i);
+                }
+            }
+
+            if (largest < 0)
+                break;
+
+            const BuildNode& c = nodes[slots[largest]];
+            slots[largest] = c.left;
+            slots[n++] = c.right;
+        }
+
+        Node node = {};
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            if (i >= n)
+            {
+                node.minX[i] = node.minY[i] = node.minZ[i] = FLT_MAX;
+                node.maxX[i] = node.maxY[i] = node.maxZ[i] = -FLT_MAX;
+                node.child[i] = c_Empty;
+                continue;
+            }
+
+            const BuildNode& c = nodes[slots[i]];
+            node.minX[i] = c.bounds.mn[0];
+            node.minY[i] = c.bounds.mn[1];
+            node.minZ[i] = c.bounds.mn[2];
+            node.maxX[i] = c.bounds.mx[0];
+            node.maxY[i] = c.bounds.mx[1];
+            node.maxZ[i] = c.bounds.mx[2];
+
+            if (c.count)
+            {
+                node.child[i] = c.first;
+                node.count[i] = c.count;
+            }
+            else
+            {
+                node.child[i] = static_cast<uint32_t>(mNodes.size());
+                mNodes.emplace_back();
+                collapse.push_back(Collapse{ slots[i], node.child[i] });
+            }
+        }
+
+        mNodes[task.node] = node;
+    }
+
+    // Store the triangles in leaf order
+    mIndices.resize(indexCount);
+    for (uint32_t k = 0; k < triCount; ++k)
+    {
+        const uint32_t* src = &sourceIndices[size_t(order[k]) * 3];
+        mIndices[size_t(k) * 3] = src[0];
+        mIndices[size_t(k) * 3 + 1] = src[1];
+        mIndices[size_t(k) * 3 + 2] = src[2];
+    }
+
+    mTriangleIds = std::move(order);
+}
+
+
+_Use_decl_annotations_
+bool XM_CALLCONV ModelBVH::Intersects(
+    FXMVECTOR origin, FXMVECTOR direction, float maxDistance,
+    float& distance, uint32_t& triangle, float& u, float& v) const noexcept
+{
+    distance = 0.f;
+    triangle = 0;
+    u = v = 0.f;
+
+    if (mNodes.empty())
+        return false;
+
+    // Keep the reciprocal finite for axis-aligned rays so the slab test never computes 0 * inf
+    static const XMVECTORF32 s_Epsilon = { { { 1e-20f, 1e-20f, 1e-20f, 1e-20f } } };
+    const XMVECTOR safeDir = XMVectorSelect(direction, s_Epsilon, XMVectorLess(XMVectorAbs(direction), s_Epsilon));
+    const XMVECTOR invDir = XMVectorReciprocal(safeDir);
+
+    const XMVECTOR ox = XMVectorSplatX(origin);
+    const XMVECTOR oy = XMVectorSplatY(origin);
+    const XMVECTOR oz = XMVectorSplatZ(origin);
+    const XMVECTOR ix = XMVectorSplatX(invDir);
+    const XMVECTOR iy = XMVectorSplatY(invDir);
+    const XMVECTOR iz = XMVectorSplatZ(invDir);
+
+    float best = maxDistance;
+    bool hit = false;
+
+    struct Entry
+    {
+        uint32_t    node;
+        float       t;
+    };
+
+    Entry stack[c_StackSize];
+    size_t sp = 0;
+    stack[sp++] = Entry{ 0, 0.f };
+
+    while (sp > 0)
+    {
+        const Entry entry = stack[--sp];
+        if (entry.t > best)
+            continue;
+
+        const Node& node = mNodes[entry.node];
+
+        // Slab test against all four children
+        XMVECTOR t1 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(node.minX)), ox), ix);
+        XMVECTOR t2 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(node.maxX)), ox), ix);
+        XMVECTOR tmin = XMVectorMin(t1, t2);
+        XMVECTOR tmax = XMVectorMax(t1, t2);
+
+        t1 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(node.minY)), oy), iy);
+        t2 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(node.maxY)), oy), iy);
+        tmin = XMVectorMax(tmin, XMVectorMin(t1, t2));
+        tmax = XMVectorMin(tmax, XMVectorMax(t1, t2));
+
+        t1 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(node.minZ)), oz), iz);
+        t2 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(node.maxZ)), oz), iz);
+        tmin = XMVectorMax(tmin, XMVectorMin(t1, t2));
+        tmax = XMVectorMin(tmax, XMVectorMax(t1, t2));
+
+        tmin = XMVectorMax(tmin, XMVectorZero());
+        tmax = XMVectorMin(tmax, XMVectorReplicate(best));
+
+        XMFLOAT4A nearT;
+        XMStoreFloat4A(&nearT, tmin);
+
+        XMUINT4 mask;
+        XMStoreUInt4(&mask, XMVectorLessOrEqual(tmin, tmax));
+
+        const float* nearPtr = &nearT.x;
+        const uint32_t* maskPtr = &mask.x;
+
+        // Sort the children that were hit front to back
+        uint32_t slots[4];
+        float dists[4];
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            if (!maskPtr[i] || node.child[i] == c_Empty)
+                continue;
+
+            uint32_t j = n++;
+            for (; j > 0 && dists[j - 1] > nearPtr[i]; --j)
+            {
+                slots[j] = slots[j - 1];
+                dists[j] = dists[j - 1];
+            }
+            slots[j] = i;
+            dists[j] = nearPtr[i];
+        }
+
+        // Leaves are tested right away, which shortens the ray for the child nodes
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            const uint32_t slot = slots[i];
+            if (!node.count[slot] || dists[i] > best)
+                continue;
+
+            const uint32_t last = node.child[slot] + node.count[slot];
+            for (uint32_t k = node.child[slot]; k < last; ++k)
+            {
+                const uint32_t* tri = &mIndices[size_t(k) * 3];
+
+                const XMVECTOR v0 = XMLoadFloat3(&mPositions[tri[0]]);
+                const XMVECTOR e1 = XMVectorSubtract(XMLoadFloat3(&mPositions[tri[1]]), v0);
+                const XMVECTOR e2 = XMVectorSubtract(XMLoadFloat3(&mPositions[tri[2]]), v0);
+
+                // Moller-Trumbore, accepting both windings
+                const XMVECTOR p = XMVector3Cross(direction, e2);
+                const float det = XMVectorGetX(XMVector3Dot(e1, p));
+                if (fabsf(det) < FLT_MIN)
+                    continue;
+
+                const float invDet = 1.f / det;
+
+                const XMVECTOR s = XMVectorSubtract(origin, v0);
+                const float tu = XMVectorGetX(XMVector3Dot(s, p)) * invDet;
+                if (tu < 0.f || tu > 1.f)
+                    continue;
+
+                const XMVECTOR q = XMVector3Cross(s, e1);
+                const float tv = XMVectorGetX(XMVector3Dot(direction, q)) * invDet;
+                if (tv < 0.f || (tu + tv) > 1.f)
+                    continue;
+
+                const float t = XMVectorGetX(XMVector3Dot(e2, q)) * invDet;
+                if (t < 0.f || t > best)
+                    continue;
+
+                best = t;
+                triangle = mTriangleIds[k];
+                u = tu;
+                v = tv;
+                hit = true;
+            }
+        }
+
+        // Push child nodes far to near so the nearest is visited next
+        for (uint32_t i = n; i > 0; --i)
+        {
+            const uint32_t slot = slots[i - 1];
+            if (node.count[slot])
+                continue;
+
+            assert(sp < c_StackSize);
+            stack[sp++] = Entry{ node.child[slot], dists[i - 1] };
+        }
+    }
+
+    if (hit)
+    {
+        distance = best;
+    }
+
+    return hit;
+}
@@ -0,0 +1,80 @@
+//--------------------------------------------------------------------------------------
+// File: ModelBVH.h
+//
+// CPU-side bounding volume hierarchy over the triangles of a mesh part, used for ray
+// picking. The tree is built top-down with a binned surface area heuristic, then
+// collapsed into 4-wide nodes whose child bounds are stored as structure-of-arrays so a
+// ray is tested against all four children at once.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+
+namespace DirectX
+{
+    class ModelBVH
+    {
+    public:
+        ModelBVH() = default;
+
+        ModelBVH(ModelBVH&&) = default;
+        ModelBVH& operator= (ModelBVH&&) = default;
+
+        ModelBVH(ModelBVH const&) = default;
+        ModelBVH& operator= (ModelBVH const&) = default;
+
+        // Builds the hierarchy for an indexed triangle list. Only the referenced positions are retained.
+        // baseVertex is added to each index as DrawIndexed does, and may be negative.
+        void Build(
+            _In_reads_bytes_(vertexCount * positionStride) const XMFLOAT3* positions, size_t positionStride, size_t vertexCount,
+            _In_ const void* indices, bool indices32, size_t indexCount, int32_t baseVertex = 0);
+
+        // Finds the closest triangle hit with a ray parameter in [0, maxDistance]. The direction does
+        // not need to be normalized; the reported distance is in units of its length.
+        bool XM_CALLCONV Intersects(
+            FXMVECTOR origin, FXMVECTOR direction, float maxDistance,
+            _Out_ float& distance, _Out_ uint32_t& triangle, _Out_ float& u, _Out_ float& v) const noexcept;
+
+        size_t GetTriangleCount() const noexcept { return mTriangleIds.size(); }
+        size_t GetNodeCount() const noexcept { return mNodes.size(); }
+        size_t GetVertexCount() const noexcept { return mPositions.size(); }
+
+        static constexpr uint32_t c_LeafSize = 4;
+
+        // Below this depth splits fall back to the median, which bounds the traversal stack.
+        static constexpr uint32_t c_MaxSAHDepth = 64;
+
+    private:
+        struct Node
+        {
+            float       minX[4];
+            float       minY[4];
+            float       minZ[4];
+            float       maxX[4];
+            float       maxY[4];
+            float       maxZ[4];
+            uint32_t    child[4];   // Child node index, or first triangle of a leaf
+            uint32_t    count[4];   // Triangle count of a leaf, or 0 for a child node
+        };
+
+        static_assert(sizeof(Node) == 128, "BVH node size mismatch");
+
+        static constexpr uint32_t c_Empty = uint32_t(-1);
+
+        std::vector<Node>       mNodes;         // mNodes[0] is the root
+        std::vector<XMFLOAT3>   mPositions;
+        std::vector<uint32_t>   mIndices;       // Three per triangle into mPositions, in leaf order
+        std::vector<uint32_t>   mTriangleIds;   // Source triangle for each triangle in leaf order
+    };
+}
@@ -0,0 +1,191 @@
+//--------------------------------------------------------------------------------------
+// File: ModelBaked.h
+//
+// The baked model format is a DirectX Tool Kit cache of a model after all loader-side
+// processing (validation, UV transform fixups, skinning stream interleaving, and
+// buffer consolidation) has been done. Vertex and index data is stored exactly as it
+// is uploaded, aligned so the file can be memory-mapped and handed to CreateBuffer.
+//
+// Layout:
+//      Header
+//      BufferRecord[NumBuffers]
+//      InputElement[NumInputElements]
+//      InputLayout[NumInputLayouts]
+//      Material[NumMaterials]
+//      Mesh[NumMeshes]
+//      MeshPart[NumMeshParts]
+//      uint32_t[NumBoneInfluences]
+//      Bone[NumBones]
+//      XMFLOAT4X4[NumBones] (bone matrices), XMFLOAT4X4[NumBones] (inverse bind pose, optional)
+//      wchar_t string table (StringTableSize bytes)
+//      buffer data (each buffer at a BufferAlignment-aligned offset)
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+
+namespace BakedModel
+{
+    constexpr uint32_t MAGIC = 0x4D425844; // "DXBM"
+    constexpr uint32_t VERSION = 1;
+
+    constexpr uint32_t BufferAlignment = 16;
+
+    // Offset into the string table for a missing string.
+    constexpr uint32_t NoString = uint32_t(-1);
+
+    enum HeaderFlags : uint32_t
+    {
+        HEADER_HAS_BONE_MATRICES = 0x1,
+        HEADER_HAS_BIND_POSE = 0x2,
+    };
+
+    enum BufferType : uint32_t
+    {
+        BUFFER_VERTEX = 0,
+        BUFFER_INDEX = 1,
+    };
+
+    enum MaterialFlags : uint32_t
+    {
+        MATERIAL_PER_VERTEX_COLOR = 0x1,
+        MATERIAL_SKINNING = 0x2,
+        MATERIAL_DUAL_TEXTURE = 0x4,
+        MATERIAL_NORMAL_MAPS = 0x8,
+        MATERIAL_BIASED_NORMALS = 0x10,
+    };
+
+    // Input element semantics are stored as an index into this table so the loaded
+    // layout descriptions can point to static strings.
+    constexpr const char* Semantics[] =
+    {
+        "SV_Position",
+        "NORMAL",
+        "TANGENT",
+        "BINORMAL",
+        "COLOR",
+        "TEXCOORD",
+        "BLENDINDICES",
+        "BLENDWEIGHT",
+        "InstMatrix",
+    };
+
+#pragma pack(push,4)
+
+    struct Header
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t Flags;
+        uint32_t NumBuffers;
+        uint32_t NumInputElements;
+        uint32_t NumInputLayouts;
+        uint32_t NumMaterials;
+        uint32_t NumMeshes;
+        uint32_t NumMeshParts;
+        uint32_t NumBoneInfluences;
+        uint32_t NumBones;
+        uint32_t ModelName;
+        uint32_t StringTableSize;
+        uint32_t Reserved;
+        uint64_t DataOffset;        // Start of the buffer data block
+        uint64_t DataSize;
+    };
+
+    struct BufferRecord
+    {
+        uint32_t Type;
+        uint32_t Reserved;
+        uint64_t Offset;            // Relative to Header::DataOffset
+        uint64_t SizeBytes;
+    };
+
+    struct InputElement
+    {
+        uint32_t Semantic;          // Index into Semantics
+        uint32_t SemanticIndex;
+        uint32_t Format;
+        uint32_t InputSlot;
+        uint32_t AlignedByteOffset;
+        uint32_t InputSlotClass;
+        uint32_t InstanceDataStepRate;
+    };
+
+    struct InputLayout
+    {
+        uint32_t FirstElement;
+        uint32_t NumElements;
+    };
+
+    struct Material
+    {
+        uint32_t Name;
+        uint32_t Flags;
+        float    SpecularPower;
+        float    Alpha;
+        float    AmbientColor[3];
+        float    DiffuseColor[3];
+        float    SpecularColor[3];
+        float    EmissiveColor[3];
+        uint32_t DiffuseTexture;
+        uint32_t SpecularTexture;
+        uint32_t NormalTexture;
+        uint32_t EmissiveTexture;
+    };
+
+    struct Mesh
+    {
+        uint32_t Name;
+        uint32_t FirstPart;
+        uint32_t NumParts;
+        uint32_t BoneIndex;
+        uint32_t FirstBoneInfluence;
+        uint32_t NumBoneInfluences;
+        uint32_t CCW;
+        uint32_t PMAlpha;
+        float    SphereCenter[3];
+        float    SphereRadius;
+        float    BoxCenter[3];
+        float    BoxExtents[3];
+    };
+
+    struct MeshPart
+    {
+        uint32_t IndexCount;
+        uint32_t StartIndex;
+        int32_t  VertexOffset;
+        uint32_t VertexStride;
+        uint32_t PrimitiveType;
+        uint32_t IndexFormat;
+        uint32_t VertexBuffer;
+        uint32_t IndexBuffer;
+        uint32_t Material;
+        uint32_t InputLayout;
+        uint32_t IsAlpha;
+    };
+
+    struct Bone
+    {
+        uint32_t Name;
+        uint32_t ParentIndex;
+        uint32_t ChildIndex;
+        uint32_t SiblingIndex;
+    };
+
+#pragma pack(pop)
+
+} // namespace
+
+static_assert(sizeof(BakedModel::Header) == 72, "Baked model header size mismatch");
+static_assert(sizeof(BakedModel::BufferRecord) == 24, "Baked model buffer record size mismatch");
+static_assert(sizeof(BakedModel::InputElement) == 28, "Baked model input element size mismatch");
+static_assert(sizeof(BakedModel::Material) == 80, "Baked model material size mismatch");
+static_assert(sizeof(BakedModel::Mesh) == 72, "Baked model mesh size mismatch");
+static_assert(sizeof(BakedModel::MeshPart) == 44, "Baked model mesh part size mismatch");
@@ -0,0 +1,590 @@
+//--------------------------------------------------------------------------------------
+// File: ModelLoadAsync.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Model.h"
+#include "BinaryReader.h"
+#include "ModelLoadCancel.h"
+#include "PlatformHelpers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+
+//--------------------------------------------------------------------------------------
+// Shared state between a ModelLoadHandle and the worker running its job
+//--------------------------------------------------------------------------------------
+
+class ModelLoadHandle::Impl
+{
+public:
+    Impl() noexcept :
+        mReady(false),
+        mCancelled(false),
+        mRetrieved(false)
+    {
+    }
+
+    bool IsReady() const noexcept { return mReady.load(std::memory_order_acquire); }
+
+    void Cancel() noexcept { mCancelled.store(true, std::memory_order_relaxed); }
+    bool IsCancelled() const noexcept { return mCancelled.load(std::memory_order_relaxed); }
+
+    // Throws an internal marker exception at a cancellation point.
+    void CheckCancelled() const
+    {
+        if (IsCancelled())
+            throw cancelled();
+    }
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this]() { return IsReady(); });
+    }
+
+    void Complete(std::unique_ptr<Model>&& model, std::exception_ptr error)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mModel = std::move(model);
+            mError = error;
+            mReady.store(true, std::memory_order_release);
+        }
+        mCondition.notify_all();
+    }
+
+    std::unique_ptr<Model> Get()
+    {
+        Wait();
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (mError)
+            std::rethrow_exception(mError);
+
+        if (mRetrieved)
+            throw std::logic_error("Model has already been retrieved from this handle");
+
+        mRetrieved = true;
+        return std::move(mModel);
+    }
+
+    struct cancelled {};
+
+private:
+    std::atomic<bool>           mReady;
+    std::atomic<bool>           mCancelled;
+    bool                        mRetrieved;
+    std::mutex                  mMutex;
+    std::condition_variable     mCondition;
+    std::unique_ptr<Model>      mModel;
+    std::exception_ptr          mError;
+};
+
+
+namespace
+{
+    // Load running on this thread, so the loaders' cancellation points can find it.
+    thread_local const ModelLoadHandle::Impl* t_currentLoad = nullptr;
+}
+
+void DirectX::Internal::CheckModelLoadCancelled()
+{
+    if (t_currentLoad)
+        t_currentLoad->CheckCancelled();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Priority job queue serviced by a small set of background threads
+//--------------------------------------------------------------------------------------
+
+class ModelLoadQueue::Impl
+{
+public:
+    using Job = std::function<std::unique_ptr<Model>()>;
+
+    explicit Impl(size_t threadCount) :
+        mSequence(0),
+        mShutdown(false)
+    {
+        if (!threadCount)
+        {
+            threadCount = std::max<size_t>(1u, std::min<size_t>(2u, std::thread::hardware_concurrency()));
+        }
+
+        try
+        {
+            for (size_t j = 0; j < threadCount; ++j)
+            {
+                mThreads.emplace_back(&Impl::Worker, this);
+            }
+        }
+        catch (...)
+        {
+            Shutdown();
+            throw;
+        }
+    }
+
+    Impl(Impl&&) = delete;
+    Impl& operator= (Impl&&) = delete;
+
+    Impl(Impl const&) = delete;
+    Impl& operator= (Impl const&) = delete;
+
+    ~Impl()
+    {
+        Shutdown();
+    }
+
+    void Submit(const std::shared_ptr<ModelLoadHandle::Impl>& state, ModelLoadPriority priority, Job&& job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mShutdown)
+                throw std::logic_error("ModelLoadQueue is shutting down");
+
+            mQueue.push(Entry{ priority, mSequence++, state, std::move(job) });
+        }
+        mCondition.notify_one();
+    }
+
+    size_t GetPendingCount() const noexcept
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mQueue.size() + mRunning.size();
+    }
+
+private:
+    struct Entry
+    {
+        ModelLoadPriority                           priority;
+        uint64_t                                    sequence;
+        std::shared_ptr<ModelLoadHandle::Impl>      state;
+        Job                                         job;
+
+        // Highest priority first, then submission order.
+        bool operator< (const Entry& rhs) const noexcept
+        {
+            if (priority != rhs.priority)
+                return priority < rhs.priority;
+            return sequence > rhs.sequence;
+        }
+    };
+
+    // Fails the loads that have not started rather than running them, and cancels the ones in
+    // flight, so the only wait is for those to reach their next cancellation point.
+    void Shutdown() noexcept
+    {
+        std::vector<std::shared_ptr<ModelLoadHandle::Impl>> dropped;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mShutdown = true;
+
+            while (!mQueue.empty())
+            {
+                dropped.emplace_back(mQueue.top().state);
+                mQueue.pop();
+            }
+
+            for (auto& it : mRunning)
+            {
+                it->Cancel();
+            }
+        }
+        mCondition.notify_all();
+
+        if (!dropped.empty())
+        {
+            auto error = std::make_exception_ptr(std::runtime_error("Model load cancelled by ModelLoadQueue shutdown"));
+            for (auto& it : dropped)
+            {
+                it->Cancel();
+                it->Complete(nullptr, error);
+            }
+        }
+
+        for (auto& it : mThreads)
+        {
+            if (it.joinable())
+                it.join();
+        }
+    }
+
+    void Worker()
+    {
+        for (;;)
+        {
+            Entry entry;
+
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this]() { return mShutdown || !mQueue.empty(); });
+
+                if (mShutdown)
+                    return;
+
+                entry = mQueue.top();
+                mQueue.pop();
+                mRunning.push_back(entry.state.get());
+            }
+
+            std::unique_ptr<Model> model;
+            std::exception_ptr error;
+
+            try
+            {
+                entry.state->CheckCancelled();
+
+                t_currentLoad = entry.state.get();
+                model = entry.job();
+
+                // Drop the result if cancelled while the load was in flight.
+                if (entry.state->IsCancelled())
+                {
+                    model.reset();
+                }
+            }
+            catch (const ModelLoadHandle::Impl::cancelled&)
+            {
+                model.reset();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            t_currentLoad = nullptr;
+            entry.job = nullptr;
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mRunning.erase(std::find(mRunning.begin(), mRunning.end(), entry.state.get()));
+            }
+
+            entry.state->Complete(std::move(model), error);
+        }
+    }
+
+    mutable std::mutex                      mMutex;
+    std::condition_variable                 mCondition;
+    std::priority_queue<Entry>              mQueue;
+    std::vector<ModelLoadHandle::Impl*>     mRunning;
+    std::vector<std::thread>                mThreads;
+    uint64_t                                mSequence;
+    bool                                    mShutdown;
+};
+
+
+namespace
+{
+    // Reads the file for a loader, matching the synchronous path's diagnostics.
+    void ReadModelFile(
+        _In_z_ const wchar_t* szFileName,
+        _In_z_ const char* loader,
+        std::unique_ptr<uint8_t[]>& data,
+        size_t& dataSize)
+    {
+        HRESULT hr = BinaryReader::ReadEntireFile(szFileName, data, &dataSize);
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: %s failed (%08X) loading '%ls'\n",
+                loader, static_cast<unsigned int>(hr), szFileName);
+            throw std::runtime_error(loader);
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// ModelLoadHandle
+//--------------------------------------------------------------------------------------
+
+bool ModelLoadHandle::IsReady() const noexcept
+{
+    return pImpl && pImpl->IsReady();
+}
+
+
+void ModelLoadHandle::Cancel() noexcept
+{
+    if (pImpl)
+    {
+        pImpl->Cancel();
+    }
+}
+
+
+bool ModelLoadHandle::IsCancelled() const noexcept
+{
+    return pImpl && pImpl->IsCancelled();
+}
+
+
+void ModelLoadHandle::Wait() const
+{
+    if (!pImpl)
+        throw std::logic_error("ModelLoadHandle is empty");
+
+    pImpl->Wait();
+}
+
+
+std::unique_ptr<Model> ModelLoadHandle::Get()
+{
+    if (!pImpl)
+        throw std::logic_error("ModelLoadHandle is empty");
+
+    return pImpl->Get();
+}
+
+
+//--------------------------------------------------------------------------------------
+// ModelLoadQueue
+//--------------------------------------------------------------------------------------
+
+ModelLoadQueue::ModelLoadQueue(size_t threadCount)
+    : pImpl(std::make_unique<Impl>(threadCount))
+{
+}
+
+
+ModelLoadQueue::ModelLoadQueue(ModelLoadQueue&&) noexcept = default;
+ModelLoadQueue& ModelLoadQueue::operator= (ModelLoadQueue&&) noexcept = default;
+ModelLoadQueue::~ModelLoadQueue() = default;
+
+
+size_t ModelLoadQueue::GetPendingCount() const noexcept
+{
+    return pImpl ? pImpl->GetPendingCount() : 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Model async loaders
+//--------------------------------------------------------------------------------------
+
+_Use_decl_annotations_
+ModelLoadHandle Model::CreateFromCMOAsync(
+    ModelLoadQueue& queue,
+    ID3D11Device* device,
+    const wchar_t* szFileName,
+    IEffectFactory& fxFactory,
+    ModelLoaderFlags flags,
+    ModelLoadPriority priority)
+{
+    if (!device || !szFileName)
+        throw std::invalid_argument("Device and file name cannot be null");
+
+    if (!queue.pImpl)
+        throw std::logic_error("ModelLoadQueue is empty");
+
+    ModelLoadHandle handle;
+    handle.pImpl = std::make_shared<ModelLoadHandle::Impl>();
+
+    ComPtr<ID3D11Device> d3dDevice(device);
+    std::wstring fileName(szFileName);
+    IEffectFactory* factory = &fxFactory;
+    ModelLoadHandle::Impl* state = handle.pImpl.get();
+
+    queue.pImpl->Submit(handle.pImpl, priority,
+        [d3dDevice, fileName, factory, flags, state]()
+        {
+            size_t dataSize = 0;
+            std::unique_ptr<uint8_t[]> data;
+            ReadModelFile(fileName.c_str(), "CreateFromCMO", data, dataSize);
+
+            state->CheckCancelled();
+
+            auto model = CreateFromCMO(d3dDevice.Get(), data.get(), dataSize, *factory, flags);
+            model->name = fileName;
+            return model;
+        });
+
+    return handle;
+}
+
+
+_Use_decl_annotations_
+ModelLoadHandle Model::CreateFromSDKMESHAsync(
+    ModelLoadQueue& queue,
+    ID3D11Device* device,
+    const wchar_t* szFileName,
+    IEffectFactory& fxFactory,
+    ModelLoaderFlags flags,
+    ModelLoadPriority priority)
+{
+    if (!device || !szFileName)
+        throw std::invalid_argument("Device and file name cannot be null");
+
+    if (!queue.pImpl)
+        throw std::logic_error("ModelLoadQueue is empty");
+
+    ModelLoadHandle handle;
+    handle.pImpl = std::make_shared<ModelLoadHandle::Impl>();
+
+    ComPtr<ID3D11Device> d3dDevice(device);
+    std::wstring fileName(szFileName);
+    IEffectFactory* factory = &fxFactory;
+    ModelLoadHandle::Impl* state = handle.pImpl.get();
+
+    queue.pImpl->Submit(handle.pImpl, priority,
+        [d3dDevice, fileName, factory, flags, state]()
+        {
+            size_t dataSize = 0;
+            std::unique_ptr<uint8_t[]> data;
+            ReadModelFile(fileName.c_str(), "CreateFromSDKMESH", data, dataSize);
+
+            state->CheckCancelled();
+
+            auto model = CreateFromSDKMESH(d3dDevice.Get(), data.get(), dataSize, *factory, flags);
+            model->name = fileName;
+            return model;
+        });
+
+    return handle;
+}
+
+
+_Use_decl_annotations_
+ModelLoadHandle Model::CreateFromVBOAsync(
+    ModelLoadQueue& queue,
+    ID3D11Device* device,
+    const wchar_t* szFileName,
+    std::shared_ptr<IEffect> ieffect,
+    ModelLoaderFlags flags,
+    ModelLoadPriority priority)
+{
+    if (!device || !szFileName)
+        throw std::invalid_argument("Device and file name cannot be null");
+
+    if (!queue.pImpl)
+        throw std::logic_error("ModelLoadQueue is empty");
+
+    ModelLoadHandle handle;
+    handle.pImpl = std::make_shared<ModelLoadHandle::Impl>();
+
+    ComPtr<ID3D11Device> d3dDevice(device);
+    std::wstring fileName(szFileName);
+    ModelLoadHandle::Impl* state = handle.pImpl.get();
+
+    queue.pImpl->Submit(handle.pImpl, priority,
+        [d3dDevice, fileName, ieffect, flags, state]()
+        {
+            size_t dataSize = 0;
+            std::unique_ptr<uint8_t[]> data;
+            ReadModelFile(fileName.c_str(), "CreateFromVBO", data, dataSize);
+
+            state->CheckCancelled();
+
+            auto model = CreateFromVBO(d3dDevice.Get(), data.get(), dataSize, ieffect, flags);
+            model->name = fileName;
+            return model;
+        });
+
+    return handle;
+}
+
+
+_Use_decl_annotations_
+ModelLoadHandle Model::CreateFromBakedAsync(
+    ModelLoadQueue& queue,
+    ID3D11Device* device,
+    const wchar_t* szFileName,
+    IEffectFactory& fxFactory,
+    ModelLoadPriority priority)
+{
+    if (!device || !szFileName)
+        throw std::invalid_argument("Device and file name cannot be null");
+
+    if (!queue.pImpl)
+        throw std::logic_error("ModelLoadQueue is empty");
+
+    ModelLoadHandle handle;
+    handle.pImpl = std::make_shared<ModelLoadHandle::Impl>();
+
+    ComPtr<ID3D11Device> d3dDevice(device);
+    std::wstring fileName(szFileName);
+    IEffectFactory* factory = &fxFactory;
+
+    // The baked loader maps the file rather than reading it, so there is no separate I/O stage;
+    // its cancellation point sits between validating the tables and creating the buffers.
+    queue.pImpl->Submit(handle.pImpl, priority,
+        [d3dDevice, fileName, factory]()
+        {
+            return CreateFromBaked(d3dDevice.Get(), fileName.c_str(), *factory);
+        });
+
+    return handle;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Adapters for /Zc:wchar_t- clients
+
+#if defined(_MSC_VER) && !defined(_NATIVE_WCHAR_T_DEFINED)
+
+_Use_decl_annotations_
+ModelLoadHandle Model::CreateFromCMOAsync(
+    ModelLoadQueue& queue,
+    ID3D11Device* device,
+    const __wchar_t* szFileName,
+    IEffectFactory& fxFactory,
+    ModelLoaderFlags flags,
+    ModelLoadPriority priority)
+{
+    return Model::CreateFromCMOAsync(queue, device, reinterpret_cast<const unsigned short*>(szFileName), fxFactory, flags, priority);
+}
+
+_Use_decl_annotations_
+ModelLoadHandle Model::CreateFromSDKMESHAsync(
+    ModelLoadQueue& queue,
+    ID3D11Device* device,
+    const __wchar_t* szFileName,
+    IEffectFactory& fxFactory,
+    ModelLoaderFlags flags,
+    ModelLoadPriority priority)
+{
+    return Model::CreateFromSDKMESHAsync(queue, device, reinterpret_cast<const unsigned short*>(szFileName), fxFactory, flags, priority);
+}
+
+_Use_decl_annotations_
+ModelLoadHandle Model::CreateFromVBOAsync(
+    ModelLoadQueue& queue,
+    ID3D11Device* device,
+    const __wchar_t* szFileName,
+    std::shared_ptr<IEffect> ieffect,
+    ModelLoaderFlags flags,
+    ModelLoadPriority priority)
+{
+    return Model::CreateFromVBOAsync(queue, device, reinterpret_cast<const unsigned short*>(szFileName), ieffect, flags, priority);
+}
+
+_Use_decl_annotations_
+ModelLoadHandle Model::CreateFromBakedAsync(
+    ModelLoadQueue& queue,
+    ID3D11Device* device,
+    const __wchar_t* szFileName,
+    IEffectFactory& fxFactory,
+    ModelLoadPriority priority)
+{
+    return Model::CreateFromBakedAsync(queue, device, reinterpret_cast<const unsigned short*>(szFileName), fxFactory, priority);
+}
+
+#endif // !_NATIVE_WCHAR_T_DEFINED
@@ -0,0 +1,945 @@
+//--------------------------------------------------------------------------------------
+// File: ModelLoadBaked.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "Model.h"
+#include "DirectXHelpers.h"
+#include "Effects.h"
+#include "LoaderHelpers.h"
+#include "MemoryMappedFile.h"
+#include "ModelBaked.h"
+#include "ModelLoadCancel.h"
+#include "PlatformHelpers.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    //----------------------------------------------------------------------------------
+    // Captures the material descriptions the loaders hand to the effect factory so they
+    // can be written to the baked file and replayed against the application's factory.
+    class RecordingEffectFactory : public IEffectFactory
+    {
+    public:
+        explicit RecordingEffectFactory(_In_ ID3D11Device* device) :
+            mFactory(device)
+        {
+            // Each material must map to a distinct effect instance.
+            mFactory.SetSharing(false);
+        }
+
+        struct Material
+        {
+            EffectInfo      info;
+            std::wstring    name;
+            std::wstring    textures[4];
+        };
+
+        std::shared_ptr<IEffect> __cdecl CreateEffect(_In_ const EffectInfo& info, _In_opt_ ID3D11DeviceContext* deviceContext) override
+        {
+            Material material;
+            material.info = info;
+            material.name = info.name ? info.name : L"";
+            material.textures[0] = info.diffuseTexture ? info.diffuseTexture : L"";
+            material.textures[1] = info.specularTexture ? info.specularTexture : L"";
+            material.textures[2] = info.normalTexture ? info.normalTexture : L"";
+            material.textures[3] = info.emissiveTexture ? info.emissiveTexture : L"";
+
+            // Textures are not needed to bake, only a shader signature for the input layouts.
+            EffectInfo stripped = info;
+            stripped.diffuseTexture = nullptr;
+            stripped.specularTexture = nullptr;
+            stripped.normalTexture = nullptr;
+            stripped.emissiveTexture = nullptr;
+
+            auto effect = mFactory.CreateEffect(stripped, deviceContext);
+
+            mIndices[effect.get()] = static_cast<uint32_t>(mMaterials.size());
+            mMaterials.emplace_back(std::move(material));
+
+            return effect;
+        }
+
+        void __cdecl CreateTexture(_In_z_ const wchar_t*, _In_opt_ ID3D11DeviceContext*, _Outptr_ ID3D11ShaderResourceView**) override
+        {
+            throw std::runtime_error("Textures are not loaded when baking models");
+        }
+
+        uint32_t GetMaterialIndex(_In_ IEffect* effect) const
+        {
+            auto it = mIndices.find(effect);
+            if (it == mIndices.cend())
+                throw std::runtime_error("Model effect was not created while baking");
+
+            return it->second;
+        }
+
+        const std::vector<Material>& GetMaterials() const noexcept { return mMaterials; }
+
+    private:
+        EffectFactory                   mFactory;
+        std::vector<Material>           mMaterials;
+        std::map<IEffect*, uint32_t>    mIndices;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    // Accumulates null-terminated strings and returns their byte offsets.
+    class StringTable
+    {
+    public:
+        uint32_t Add(_In_opt_z_ const wchar_t* str)
+        {
+            if (!str || !*str)
+                return BakedModel::NoString;
+
+            const size_t offset = mData.size() * sizeof(wchar_t);
+            if (offset > UINT32_MAX)
+                throw std::runtime_error("Baked model string table too large");
+
+            mData.insert(mData.end(), str, str + wcslen(str) + 1);
+            return static_cast<uint32_t>(offset);
+        }
+
+        uint32_t Add(const std::wstring& str) { return Add(str.c_str()); }
+
+        const std::vector<wchar_t>& GetData() const noexcept { return mData; }
+
+    private:
+        std::vector<wchar_t> mData;
+    };
+
+
+    inline size_t AlignUp(size_t value) noexcept
+    {
+        return (value + BakedModel::BufferAlignment - 1) & ~size_t(BakedModel::BufferAlignment - 1);
+    }
+
+
+    template<typename T>
+    void Append(std::vector<uint8_t>& blob, _In_reads_(count) const T* data, size_t count)
+    {
+        static_assert(std::is_standard_layout<T>::value, "Can only write plain-old-data types");
+
+        if (!count)
+            return;
+
+        auto ptr = reinterpret_cast<const uint8_t*>(data);
+        blob.insert(blob.end(), ptr, ptr + sizeof(T) * count);
+    }
+
+
+    uint32_t FindSemantic(_In_z_ const char* name)
+    {
+        for (size_t j = 0; j < std::size(BakedModel::Semantics); ++j)
+        {
+            if (_stricmp(name, BakedModel::Semantics[j]) == 0)
+                return static_cast<uint32_t>(j);
+        }
+
+        DebugTrace("ERROR: Semantic '%s' is not supported by the baked model format\n", name);
+        throw std::runtime_error("Unsupported input element semantic");
+    }
+
+
+    // Reads back the contents of a default usage buffer.
+    void ReadBuffer(
+        _In_ ID3D11Device* device,
+        _In_ ID3D11DeviceContext* context,
+        _In_ ID3D11Buffer* buffer,
+        std::vector<uint8_t>& data)
+    {
+        D3D11_BUFFER_DESC desc = {};
+        buffer->GetDesc(&desc);
+
+        desc.Usage = D3D11_USAGE_STAGING;
+        desc.BindFlags = 0;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        desc.MiscFlags = 0;
+        desc.StructureByteStride = 0;
+
+        ComPtr<ID3D11Buffer> staging;
+        ThrowIfFailed(
+            device->CreateBuffer(&desc, nullptr, staging.GetAddressOf())
+        );
+
+        context->CopyResource(staging.Get(), buffer);
+
+        MapGuard map(context, staging.Get(), 0, D3D11_MAP_READ, 0);
+
+        auto ptr = static_cast<const uint8_t*>(map.pData);
+        data.assign(ptr, ptr + desc.ByteWidth);
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Checks a mesh part read from a baked file against the buffers it draws from: the
+    // topology and index format must be known, the index range must lie inside the index
+    // buffer, and every index plus the vertex offset must land inside the vertex buffer.
+    void ValidateMeshPart(
+        const BakedModel::MeshPart& ph,
+        _In_reads_(numBuffers) const BakedModel::BufferRecord* bufferArray,
+        size_t numBuffers,
+        _In_ const uint8_t* bufferData)
+    {
+        if (ph.VertexBuffer >= numBuffers || ph.IndexBuffer >= numBuffers)
+            throw std::out_of_range("Invalid mesh part found");
+
+        switch (ph.PrimitiveType)
+        {
+        case D3D_PRIMITIVE_TOPOLOGY_POINTLIST:
+        case D3D_PRIMITIVE_TOPOLOGY_LINELIST:
+        case D3D_PRIMITIVE_TOPOLOGY_LINESTRIP:
+        case D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST:
+        case D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP:
+        case D3D_PRIMITIVE_TOPOLOGY_LINELIST_ADJ:
+        case D3D_PRIMITIVE_TOPOLOGY_LINESTRIP_ADJ:
+        case D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST_ADJ:
+        case D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP_ADJ:
+            break;
+
+        default:
+            if (ph.PrimitiveType < static_cast<uint32_t>(D3D_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST)
+                || ph.PrimitiveType > static_cast<uint32_t>(D3D_PRIMITIVE_TOPOLOGY_32_CONTROL_POINT_PATCHLIST))
+                throw std::runtime_error("Invalid mesh part primitive type found");
+            break;
+        }
+
+        size_t indexSize;
+        switch (ph.IndexFormat)
+        {
+        case DXGI_FORMAT_R16_UINT: indexSize = sizeof(uint16_t); break;
+        case DXGI_FORMAT_R32_UINT: indexSize = sizeof(uint32_t); break;
+        default:
+            throw std::runtime_error("Invalid mesh part index format found");
+        }
+
+        const auto& vbh = bufferArray[ph.VertexBuffer];
+        const auto& ibh = bufferArray[ph.IndexBuffer];
+
+        if (vbh.Type != BakedModel::BUFFER_VERTEX || ibh.Type != BakedModel::BUFFER_INDEX)
+            throw std::runtime_error("Invalid mesh part buffers found");
+
+        const uint64_t totalIndices = ibh.SizeBytes / indexSize;
+        if (ph.StartIndex > totalIndices
+            || ph.IndexCount > (totalIndices - ph.StartIndex))
+            throw std::out_of_range("Mesh part index range is outside the index buffer");
+
+        if (!ph.VertexStride)
+            throw std::runtime_error("Invalid mesh part vertex stride found");
+
+        if (!ph.IndexCount)
+            return;
+
+        const uint64_t totalVertices = vbh.SizeBytes / ph.VertexStride;
+
+        auto ib = bufferData + static_cast<size_t>(ibh.Offset) + size_t(ph.StartIndex) * indexSize;
+
+        uint32_t minIndex = UINT32_MAX;
+        uint32_t maxIndex = 0;
+        for (size_t j = 0; j < ph.IndexCount; ++j)
+        {
+            const uint32_t index = (indexSize == sizeof(uint32_t))
+                ? reinterpret_cast<const uint32_t*>(ib)[j]
+                : reinterpret_cast<const uint16_t*>(ib)[j];
+
+            minIndex = std::min(minIndex, index);
+            maxIndex = std::max(maxIndex, index);
+        }
+
+        if (int64_t(minIndex) + ph.VertexOffset < 0
+            || uint64_t(int64_t(maxIndex) + ph.VertexOffset) >= totalVertices)
+            throw std::out_of_range("Mesh part vertex range is outside the vertex buffer");
+    }
+
+
+    //----------------------------------------------------------------------------------
+    // Serializes a model loaded through a RecordingEffectFactory.
+    void WriteBakedModel(
+        _In_ ID3D11Device* device,
+        const Model& model,
+        const RecordingEffectFactory& fxFactory,
+        _In_z_ const wchar_t* szBakedFile)
+    {
+        ComPtr<ID3D11DeviceContext> context;
+        device->GetImmediateContext(context.GetAddressOf());
+
+        StringTable strings;
+
+        BakedModel::Header header = {};
+        header.Magic = BakedModel::MAGIC;
+        header.Version = BakedModel::VERSION;
+        header.ModelName = strings.Add(model.name);
+
+        // Buffers
+        std::vector<BakedModel::BufferRecord> buffers;
+        std::vector<uint8_t> bufferData;
+        std::map<ID3D11Buffer*, uint32_t> bufferIndices;
+
+        auto addBuffer = [&](ID3D11Buffer* buffer, uint32_t type) -> uint32_t
+        {
+            if (!buffer)
+                throw std::runtime_error("Model part is missing a buffer");
+
+            auto it = bufferIndices.find(buffer);
+            if (it != bufferIndices.end())
+                return it->second;
+
+            std::vector<uint8_t> contents;
+            ReadBuffer(device, context.Get(), buffer, contents);
+
+            BakedModel::BufferRecord record = {};
+            record.Type = type;
+            record.Offset = bufferData.size();
+            record.SizeBytes = contents.size();
+
+            bufferData.insert(bufferData.end(), contents.cbegin(), contents.cend());
+            bufferData.resize(AlignUp(bufferData.size()));
+
+            auto index = static_cast<uint32_t>(buffers.size());
+            buffers.emplace_back(record);
+            bufferIndices[buffer] = index;
+            return index;
+        };
+
+        // Input layouts
+        std::vector<BakedModel::InputElement> elements;
+        std::vector<BakedModel::InputLayout> layouts;
+        std::map<const ModelMeshPart::InputLayoutCollection*, uint32_t> layoutIndices;
+
+        auto addLayout = [&](const ModelMeshPart::InputLayoutCollection* decl) -> uint32_t
+        {
+            if (!decl)
+                throw std::runtime_error("Model part is missing a vertex declaration");
+
+            auto it = layoutIndices.find(decl);
+            if (it != layoutIndices.end())
+                return it->second;
+
+            BakedModel::InputLayout layout = {};
+            layout.FirstElement = static_cast<uint32_t>(elements.size());
+            layout.NumElements = static_cast<uint32_t>(decl->size());
+
+            for (auto& desc : *decl)
+            {
+                BakedModel::InputElement element = {};
+                element.Semantic = FindSemantic(desc.SemanticName);
+                element.SemanticIndex = desc.SemanticIndex;
+                element.Format = static_cast<uint32_t>(desc.Format);
+                element.InputSlot = desc.InputSlot;
+                element.AlignedByteOffset = desc.AlignedByteOffset;
+                element.InputSlotClass = static_cast<uint32_t>(desc.InputSlotClass);
+                element.InstanceDataStepRate = desc.InstanceDataStepRate;
+                elements.emplace_back(element);
+            }
+
+            auto index = static_cast<uint32_t>(layouts.size());
+            layouts.emplace_back(layout);
+            layoutIndices[decl] = index;
+            return index;
+        };
+
+        // Meshes and parts
+        std::vector<BakedModel::Mesh> meshes;
+        std::vector<BakedModel::MeshPart> parts;
+        std::vector<uint32_t> influences;
+
+        for (auto& mesh : model.meshes)
+        {
+            BakedModel::Mesh record = {};
+            record.Name = strings.Add(mesh->name);
+            record.FirstPart = static_cast<uint32_t>(parts.size());
+            record.NumParts = static_cast<uint32_t>(mesh->meshParts.size());
+            record.BoneIndex = mesh->boneIndex;
+            record.FirstBoneInfluence = static_cast<uint32_t>(influences.size());
+            record.NumBoneInfluences = static_cast<uint32_t>(mesh->boneInfluences.size());
+            record.CCW = mesh->ccw ? 1u : 0u;
+            record.PMAlpha = mesh->pmalpha ? 1u : 0u;
+            memcpy(record.SphereCenter, &mesh->boundingSphere.Center, sizeof(record.SphereCenter));
+            record.SphereRadius = mesh->boundingSphere.Radius;
+            memcpy(record.BoxCenter, &mesh->boundingBox.Center, sizeof(record.BoxCenter));
+            memcpy(record.BoxExtents, &mesh->boundingBox.Extents, sizeof(record.BoxExtents));
+            meshes.emplace_back(record);
+
+            influences.insert(influences.end(), mesh->boneInfluences.cbegin(), mesh->boneInfluences.cend());
+
+            for (auto& part : mesh->meshParts)
+            {
+                BakedModel::MeshPart precord = {};
+                precord.IndexCount = part->indexCount;
+                precord.StartIndex = part->startIndex;
+                precord.VertexOffset = part->vertexOffset;
+                precord.VertexStride = part->vertexStride;
+                precord.PrimitiveType = static_cast<uint32_t>(part->primitiveType);
+                precord.IndexFormat = static_cast<uint32_t>(part->indexFormat);
+                precord.VertexBuffer = addBuffer(part->vertexBuffer.Get(), BakedModel::BUFFER_VERTEX);
+                precord.IndexBuffer = addBuffer(part->indexBuffer.Get(), BakedModel::BUFFER_INDEX);
+                precord.Material = fxFactory.GetMaterialIndex(part->effect.get());
+                precord.InputLayout = addLayout(part->vbDecl.get());
+                precord.IsAlpha = part->isAlpha ? 1u : 0u;
+                parts.emplace_back(precord);
+            }
+        }
+
+        // Materials
+        std::vector<BakedModel::Material> materials;
+        for (auto& m : fxFactory.GetMaterials())
+        {
+            BakedModel::Material record = {};
+            record.Name = strings.Add(m.name);
+            record.Flags = (m.info.perVertexColor ? BakedModel::MATERIAL_PER_VERTEX_COLOR : 0u)
+                | (m.info.enableSkinning ? BakedModel::MATERIAL_SKINNING : 0u)
+                | (m.info.enableDualTexture ? BakedModel::MATERIAL_DUAL_TEXTURE : 0u)
+                | (m.info.enableNormalMaps ? BakedModel::MATERIAL_NORMAL_MAPS : 0u)
+                | (m.info.biasedVertexNormals ? BakedModel::MATERIAL_BIASED_NORMALS : 0u);
+            record.SpecularPower = m.info.specularPower;
+            record.Alpha = m.info.alpha;
+            memcpy(record.AmbientColor, &m.info.ambientColor, sizeof(record.AmbientColor));
+            memcpy(record.DiffuseColor, &m.info.diffuseColor, sizeof(record.DiffuseColor));
+            memcpy(record.SpecularColor, &m.info.specularColor, sizeof(record.SpecularColor));
+            memcpy(record.EmissiveColor, &m.info.emissiveColor, sizeof(record.EmissiveColor));
+            record.DiffuseTexture = strings.Add(m.textures[0]);
+            record.SpecularTexture = strings.Add(m.textures[1]);
+            record.NormalTexture = strings.Add(m.textures[2]);
+            record.EmissiveTexture = strings.Add(m.textures[3]);
+            materials.emplace_back(record);
+        }
+
+        // Bones
+        std::vector<BakedModel::Bone> bones;
+        for (auto& bone : model.bones)
+        {
+            BakedModel::Bone record = {};
+            record.Name = strings.Add(bone.name);
+            record.ParentIndex = bone.parentIndex;
+            record.ChildIndex = bone.childIndex;
+            record.SiblingIndex = bone.siblingIndex;
+            bones.emplace_back(record);
+        }
+
+        std::vector<XMFLOAT4X4> matrices;
+        if (!model.bones.empty() && model.boneMatrices)
+        {
+            header.Flags |= BakedModel::HEADER_HAS_BONE_MATRICES;
+            for (size_t j = 0; j < model.bones.size(); ++j)
+            {
+                XMFLOAT4X4 m;
+                XMStoreFloat4x4(&m, model.boneMatrices[j]);
+                matrices.emplace_back(m);
+            }
+
+            if (model.invBindPoseMatrices)
+            {
+                header.Flags |= BakedModel::HEADER_HAS_BIND_POSE;
+                for (size_t j = 0; j < model.bones.size(); ++j)
+                {
+                    XMFLOAT4X4 m;
+                    XMStoreFloat4x4(&m, model.invBindPoseMatrices[j]);
+                    matrices.emplace_back(m);
+                }
+            }
+        }
+
+        header.NumBuffers = static_cast<uint32_t>(buffers.size());
+        header.NumInputElements = static_cast<uint32_t>(elements.size());
+        header.NumInputLayouts = static_cast<uint32_t>(layouts.size());
+        header.NumMaterials = static_cast<uint32_t>(materials.size());
+        header.NumMeshes = static_cast<uint32_t>(meshes.size());
+        header.NumMeshParts = static_cast<uint32_t>(parts.size());
+        header.NumBoneInfluences = static_cast<uint32_t>(influences.size());
+        header.NumBones = static_cast<uint32_t>(bones.size());
+        header.StringTableSize = static_cast<uint32_t>(strings.GetData().size() * sizeof(wchar_t));
+
+        // Assemble the file image
+        std::vector<uint8_t> blob;
+        Append(blob, &header, 1);
+        Append(blob, buffers.data(), buffers.size());
+        Append(blob, elements.data(), elements.size());
+        Append(blob, layouts.data(), layouts.size());
+        Append(blob, materials.data(), materials.size());
+        Append(blob, meshes.data(), meshes.size());
+        Append(blob, parts.data(), parts.size());
+        Append(blob, influences.data(), influences.size());
+        Append(blob, bones.data(), bones.size());
+        Append(blob, matrices.data(), matrices.size());
+        Append(blob, strings.GetData().data(), strings.GetData().size());
+
+        blob.resize(AlignUp(blob.size()));
+
+        auto hdr = reinterpret_cast<BakedModel::Header*>(blob.data());
+        hdr->DataOffset = blob.size();
+        hdr->DataSize = bufferData.size();
+
+        // Write the file
+    #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+        ScopedHandle hFile(safe_handle(CreateFile2(
+            szBakedFile,
+            GENERIC_WRITE | DELETE, 0, CREATE_ALWAYS,
+            nullptr)));
+    #else
+        ScopedHandle hFile(safe_handle(CreateFileW(
+            szBakedFile,
+            GENERIC_WRITE | DELETE, 0,
+            nullptr,
+            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL,
+            nullptr)));
+    #endif
+        if (!hFile)
+        {
+            DebugTrace("ERROR: Failed (%08X) creating baked model '%ls'\n",
+                static_cast<unsigned int>(HRESULT_FROM_WIN32(GetLastError())), szBakedFile);
+            throw std::runtime_error("BakeModel");
+        }
+
+        LoaderHelpers::auto_delete_file delonfail(hFile.get());
+
+        auto writeBlock = [&](const std::vector<uint8_t>& block)
+        {
+            size_t offset = 0;
+            while (offset < block.size())
+            {
+                const auto bytes = static_cast<DWORD>(std::min<size_t>(block.size() - offset, 0x40000000));
+
+                DWORD bytesWritten;
+                if (!WriteFile(hFile.get(), block.data() + offset, bytes, &bytesWritten, nullptr)
+                    || bytesWritten != bytes)
+                {
+                    throw std::runtime_error("Failed writing baked model");
+                }
+
+                offset += bytes;
+            }
+        };
+
+        writeBlock(blob);
+        writeBlock(bufferData);
+
+        delonfail.clear();
+    }
+}
+
+
+//======================================================================================
+// Model Loader
+//======================================================================================
+
+_Use_decl_annotations_
+std::unique_ptr<Model> DirectX::Model::CreateFromBaked(
+    ID3D11Device* device,
+    const uint8_t* meshData,
+    size_t dataSize,
+    IEffectFactory& fxFactory)
+{
+    if (!device || !meshData)
+        throw std::invalid_argument("Device and meshData cannot be null");
+
+    if (dataSize < sizeof(BakedModel::Header))
+        throw std::runtime_error("End of file");
+
+    auto header = reinterpret_cast<const BakedModel::Header*>(meshData);
+
+    if (header->Magic != BakedModel::MAGIC)
+        throw std::runtime_error("Not a baked model");
+
+    if (header->Version != BakedModel::VERSION)
+        throw std::runtime_error("Baked model version not supported");
+
+    // Locate the tables
+    uint64_t usedSize = sizeof(BakedModel::Header);
+
+    auto table = [&](uint64_t count, size_t elementSize) -> const uint8_t*
+    {
+        const uint64_t offset = usedSize;
+        usedSize += count * elementSize;
+        if (dataSize < usedSize)
+            throw std::runtime_error("End of file");
+        return meshData + offset;
+    };
+
+    auto bufferArray = reinterpret_cast<const BakedModel::BufferRecord*>(table(header->NumBuffers, sizeof(BakedModel::BufferRecord)));
+    auto elementArray = reinterpret_cast<const BakedModel::InputElement*>(table(header->NumInputElements, sizeof(BakedModel::InputElement)));
+    auto layoutArray = reinterpret_cast<const BakedModel::InputLayout*>(table(header->NumInputLayouts, sizeof(BakedModel::InputLayout)));
+    auto materialArray = reinterpret_cast<const BakedModel::Material*>(table(header->NumMaterials, sizeof(BakedModel::Material)));
+    auto meshArray = reinterpret_cast<const BakedModel::Mesh*>(table(header->NumMeshes, sizeof(BakedModel::Mesh)));
+    auto partArray = reinterpret_cast<const BakedModel::MeshPart*>(table(header->NumMeshParts, sizeof(BakedModel::MeshPart)));
+    auto influenceArray = reinterpret_cast<const uint32_t*>(table(header->NumBoneInfluences, sizeof(uint32_t)));
+    auto boneArray = reinterpret_cast<const BakedModel::Bone*>(table(header->NumBones, sizeof(BakedModel::Bone)));
+
+    const bool hasBoneMatrices = (header->Flags & BakedModel::HEADER_HAS_BONE_MATRICES) != 0;
+    const bool hasBindPose = hasBoneMatrices && (header->Flags & BakedModel::HEADER_HAS_BIND_POSE) != 0;
+
+    auto matrixArray = reinterpret_cast<const XMFLOAT4X4*>(table(
+        (hasBoneMatrices ? header->NumBones : 0u) + (hasBindPose ? header->NumBones : 0u), sizeof(XMFLOAT4X4)));
+
+    auto stringTable = table(header->StringTableSize, 1);
+
+    if (header->DataOffset < usedSize
+        || (header->DataOffset % BakedModel::BufferAlignment) != 0
+        || dataSize < header->DataOffset
+        || (dataSize - header->DataOffset) < header->DataSize)
+        throw std::runtime_error("End of file");
+
+    auto bufferData = meshData + header->DataOffset;
+
+    if (!header->NumMeshes)
+        throw std::runtime_error("No meshes found");
+
+    auto getString = [&](uint32_t offset) -> const wchar_t*
+    {
+        if (offset == BakedModel::NoString)
+            return nullptr;
+
+        if ((offset % sizeof(wchar_t)) != 0 || offset >= header->StringTableSize)
+            throw std::runtime_error("Invalid string found");
+
+        auto str = reinterpret_cast<const wchar_t*>(stringTable + offset);
+        const size_t maxLength = (header->StringTableSize - offset) / sizeof(wchar_t);
+        if (wcsnlen(str, maxLength) >= maxLength)
+            throw std::runtime_error("Invalid string found");
+
+        return str;
+    };
+
+    Internal::CheckModelLoadCancelled();
+
+    // Create buffers directly from the file data
+    std::vector<ComPtr<ID3D11Buffer>> buffers;
+    buffers.resize(header->NumBuffers);
+
+    for (size_t j = 0; j < header->NumBuffers; ++j)
+    {
+        auto& bh = bufferArray[j];
+
+        if (!bh.SizeBytes || bh.SizeBytes > UINT32_MAX)
+            throw std::runtime_error("Invalid buffer found");
+
+        if (bh.Offset > header->DataSize || bh.SizeBytes > (header->DataSize - bh.Offset))
+            throw std::runtime_error("End of file");
+
+        if (bh.Type != BakedModel::BUFFER_VERTEX && bh.Type != BakedModel::BUFFER_INDEX)
+            throw std::runtime_error("Invalid buffer type found");
+
+        D3D11_BUFFER_DESC desc = {};
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.ByteWidth = static_cast<UINT>(bh.SizeBytes);
+        desc.BindFlags = (bh.Type == BakedModel::BUFFER_INDEX) ? D3D11_BIND_INDEX_BUFFER : D3D11_BIND_VERTEX_BUFFER;
+
+        D3D11_SUBRESOURCE_DATA initData = { bufferData + bh.Offset, 0, 0 };
+
+        ThrowIfFailed(
+            device->CreateBuffer(&desc, &initData, buffers[j].GetAddressOf())
+        );
+
+        SetDebugObjectName(buffers[j].Get(), "ModelBaked");
+    }
+
+    // Vertex declarations
+    std::vector<std::shared_ptr<ModelMeshPart::InputLayoutCollection>> vbDecls;
+    vbDecls.resize(header->NumInputLayouts);
+
+    for (size_t j = 0; j < header->NumInputLayouts; ++j)
+    {
+        auto& lh = layoutArray[j];
+
+        if (lh.FirstElement > header->NumInputElements
+            || lh.NumElements > (header->NumInputElements - lh.FirstElement))
+            throw std::runtime_error("Invalid input layout found");
+
+        auto decl = std::make_shared<ModelMeshPart::InputLayoutCollection>();
+        decl->reserve(lh.NumElements);
+
+        for (size_t k = 0; k < lh.NumElements; ++k)
+        {
+            auto& eh = elementArray[lh.FirstElement + k];
+
+            if (eh.Semantic >= std::size(BakedModel::Semantics))
+                throw std::runtime_error("Invalid input element semantic found");
+
+            D3D11_INPUT_ELEMENT_DESC desc = {};
+            desc.SemanticName = BakedModel::Semantics[eh.Semantic];
+            desc.SemanticIndex = eh.SemanticIndex;
+            desc.Format = static_cast<DXGI_FORMAT>(eh.Format);
+            desc.InputSlot = eh.InputSlot;
+            desc.AlignedByteOffset = eh.AlignedByteOffset;
+            desc.InputSlotClass = static_cast<D3D11_INPUT_CLASSIFICATION>(eh.InputSlotClass);
+            desc.InstanceDataStepRate = eh.InstanceDataStepRate;
+            decl->emplace_back(desc);
+        }
+
+        vbDecls[j] = std::move(decl);
+    }
+
+    // Effects
+    std::vector<std::shared_ptr<IEffect>> effects;
+    effects.resize(header->NumMaterials);
+
+    for (size_t j = 0; j < header->NumMaterials; ++j)
+    {
+        auto& mh = materialArray[j];
+
+        EffectFactory::EffectInfo info;
+        info.name = getString(mh.Name);
+        info.perVertexColor = (mh.Flags & BakedModel::MATERIAL_PER_VERTEX_COLOR) != 0;
+        info.enableSkinning = (mh.Flags & BakedModel::MATERIAL_SKINNING) != 0;
+        info.enableDualTexture = (mh.Flags & BakedModel::MATERIAL_DUAL_TEXTURE) != 0;
+        info.enableNormalMaps = (mh.Flags & BakedModel::MATERIAL_NORMAL_MAPS) != 0;
+        info.biasedVertexNormals = (mh.Flags & BakedModel::MATERIAL_BIASED_NORMALS) != 0;
+        info.specularPower = mh.SpecularPower;
+        info.alpha = mh.Alpha;
+        info.ambientColor = XMFLOAT3(mh.AmbientColor);
+        info.diffuseColor = XMFLOAT3(mh.DiffuseColor);
+        info.specularColor = XMFLOAT3(mh.SpecularColor);
+        info.emissiveColor = XMFLOAT3(mh.EmissiveColor);
+        info.diffuseTexture = getString(mh.DiffuseTexture);
+        info.specularTexture = getString(mh.SpecularTexture);
+        info.normalTexture = getString(mh.NormalTexture);
+        info.emissiveTexture = getString(mh.EmissiveTexture);
+
+        effects[j] = fxFactory.CreateEffect(info, nullptr);
+    }
+
+    // Meshes
+    std::map<std::pair<uint32_t, uint32_t>, ComPtr<ID3D11InputLayout>> inputLayouts;
+
+    auto model = std::make_unique<Model>();
+    model->meshes.reserve(header->NumMeshes);
+
+    for (size_t meshIndex = 0; meshIndex < header->NumMeshes; ++meshIndex)
+    {
+        auto& mh = meshArray[meshIndex];
+
+        if (mh.FirstPart > header->NumMeshParts
+            || mh.NumParts > (header->NumMeshParts - mh.FirstPart))
+            throw std::runtime_error("Invalid mesh found");
+
+        if (mh.FirstBoneInfluence > header->NumBoneInfluences
+            || mh.NumBoneInfluences > (header->NumBoneInfluences - mh.FirstBoneInfluence))
+            throw std::runtime_error("Invalid mesh found");
+
+        auto mesh = std::make_shared<ModelMesh>();
+
+        auto name = getString(mh.Name);
+        if (name)
+        {
+            mesh->name = name;
+        }
+
+        mesh->ccw = mh.CCW != 0;
+        mesh->pmalpha = mh.PMAlpha != 0;
+        mesh->boneIndex = mh.BoneIndex;
+        mesh->boundingSphere.Center = XMFLOAT3(mh.SphereCenter);
+        mesh->boundingSphere.Radius = mh.SphereRadius;
+        mesh->boundingBox.Center = XMFLOAT3(mh.BoxCenter);
+        mesh->boundingBox.Extents = XMFLOAT3(mh.BoxExtents);
+
+        if (mh.NumBoneInfluences > 0)
+        {
+            mesh->boneInfluences.assign(influenceArray + mh.FirstBoneInfluence,
+                influenceArray + mh.FirstBoneInfluence + mh.NumBoneInfluences);
+        }
+
+        mesh->meshParts.reserve(mh.NumParts);
+
+        for (size_t j = 0; j < mh.NumParts; ++j)
+        {
+            auto& ph = partArray[mh.FirstPart + j];
+
+            if (ph.Material >= header->NumMaterials
+                || ph.InputLayout >= header->NumInputLayouts)
+                throw std::out_of_range("Invalid mesh part found");
+
+            ValidateMeshPart(ph, bufferArray, header->NumBuffers, bufferData);
+
+            auto& il = inputLayouts[std::make_pair(ph.Material, ph.InputLayout)];
+            if (!il)
+            {
+                auto& decl = *vbDecls[ph.InputLayout];
+
+                ThrowIfFailed(
+                    CreateInputLayoutFromEffect(device, effects[ph.Material].get(),
+                        decl.data(), decl.size(), il.GetAddressOf())
+                );
+
+                SetDebugObjectName(il.Get(), "ModelBaked");
+            }
+
+            auto part = new ModelMeshPart();
+            part->isAlpha = ph.IsAlpha != 0;
+            part->indexCount = ph.IndexCount;
+            part->startIndex = ph.StartIndex;
+            part->vertexOffset = ph.VertexOffset;
+            part->vertexStride = ph.VertexStride;
+            part->primitiveType = static_cast<D3D_PRIMITIVE_TOPOLOGY>(ph.PrimitiveType);
+            part->indexFormat = static_cast<DXGI_FORMAT>(ph.IndexFormat);
+            part->inputLayout = il;
+            part->indexBuffer = buffers[ph.IndexBuffer];
+            part->vertexBuffer = buffers[ph.VertexBuffer];
+            part->effect = effects[ph.Material];
+            part->vbDecl = vbDecls[ph.InputLayout];
+
+            mesh->meshParts.emplace_back(part);
+        }
+
+        model->meshes.emplace_back(mesh);
+    }
+
+    // Bones
+    if (header->NumBones > 0)
+    {
+        model->bones.reserve(header->NumBones);
+
+        for (size_t j = 0; j < header->NumBones; ++j)
+        {
+            auto& bh = boneArray[j];
+
+            ModelBone bone(bh.ParentIndex, bh.ChildIndex, bh.SiblingIndex);
+
+            auto name = getString(bh.Name);
+            if (name)
+            {
+                bone.name = name;
+            }
+
+            model->bones.emplace_back(bone);
+        }
+
+        if (hasBoneMatrices)
+        {
+            auto transforms = ModelBone::MakeArray(header->NumBones);
+            for (size_t j = 0; j < header->NumBones; ++j)
+            {
+                transforms[j] = XMLoadFloat4x4(&matrixArray[j]);
+            }
+            std::swap(model->boneMatrices, transforms);
+
+            if (hasBindPose)
+            {
+                auto invBindPose = ModelBone::MakeArray(header->NumBones);
+                for (size_t j = 0; j < header->NumBones; ++j)
+                {
+                    invBindPose[j] = XMLoadFloat4x4(&matrixArray[header->NumBones + j]);
+                }
+                std::swap(model->invBindPoseMatrices, invBindPose);
+            }
+        }
+    }
+
+    auto name = getString(header->ModelName);
+    if (name)
+    {
+        model->name = name;
+    }
+
+    return model;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+std::unique_ptr<Model> DirectX::Model::CreateFromBaked(
+    ID3D11Device* device,
+    const wchar_t* szFileName,
+    IEffectFactory& fxFactory)
+{
+    MemoryMappedFile file;
+    HRESULT hr = file.Open(szFileName);
+    if (FAILED(hr))
+    {
+        DebugTrace("ERROR: CreateFromBaked failed (%08X) loading '%ls'\n",
+            static_cast<unsigned int>(hr), szFileName);
+        throw std::runtime_error("CreateFromBaked");
+    }
+
+    auto model = CreateFromBaked(device, file.GetData(), file.GetSize(), fxFactory);
+
+    if (model->name.empty())
+    {
+        model->name = szFileName;
+    }
+
+    return model;
+}
+
+
+//======================================================================================
+// Model Baking
+//======================================================================================
+
+_Use_decl_annotations_
+void DirectX::Model::BakeCMO(
+    ID3D11Device* device,
+    const uint8_t* meshData, size_t dataSize,
+    const wchar_t* szBakedFile,
+    ModelLoaderFlags flags)
+{
+    if (!szBakedFile)
+        throw std::invalid_argument("Baked file name cannot be null");
+
+    RecordingEffectFactory fxFactory(device);
+
+    auto model = CreateFromCMO(device, meshData, dataSize, fxFactory, flags | ModelLoader_ConsolidateBuffers);
+
+    WriteBakedModel(device, *model, fxFactory, szBakedFile);
+}
+
+
+_Use_decl_annotations_
+void DirectX::Model::BakeSDKMESH(
+    ID3D11Device* device,
+    const uint8_t* meshData, size_t dataSize,
+    const wchar_t* szBakedFile,
+    ModelLoaderFlags flags)
+{
+    if (!szBakedFile)
+        throw std::invalid_argument("Baked file name cannot be null");
+
+    RecordingEffectFactory fxFactory(device);
+
+    auto model = CreateFromSDKMESH(device, meshData, dataSize, fxFactory, flags | ModelLoader_ConsolidateBuffers);
+
+    WriteBakedModel(device, *model, fxFactory, szBakedFile);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Adapters for /Zc:wchar_t- clients
+
+#if defined(_MSC_VER) && !defined(_NATIVE_WCHAR_T_DEFINED)
+
+_Use_decl_annotations_
+std::unique_ptr<Model> Model::CreateFromBaked(
+    ID3D11Device* device,
+    const __wchar_t* szFileName,
+    IEffectFactory& fxFactory)
+{
+    return Model::CreateFromBaked(device, reinterpret_cast<const unsigned short*>(szFileName), fxFactory);
+}
+
+_Use_decl_annotations_
+void Model::BakeCMO(
+    ID3D11Device* device,
+    const uint8_t* meshData, size_t dataSize,
+    const __wchar_t* szBakedFile,
+    ModelLoaderFlags flags)
+{
+    Model::BakeCMO(device, meshData, dataSize, reinterpret_cast<const unsigned short*>(szBakedFile), flags);
+}
+
+_Use_decl_annotations_
+void Model::BakeSDKMESH(
+    ID3D11Device* device,
+    const uint8_t* meshData, size_t dataSize,
+    const __wchar_t* szBakedFile,
+    ModelLoaderFlags flags)
+{
+    Model::BakeSDKMESH(device, meshData, dataSize, reinterpret_cast<const unsigned short*>(szBakedFile), flags);
+}
+
+#endif // !_NATIVE_WCHAR_T_DEFINED
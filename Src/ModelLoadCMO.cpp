@@ -14,6 +14,10 @@
 #include "VertexTypes.h"
 #include "BinaryReader.h"
 #include "PlatformHelpers.h"
+#include "GeometryArena.h"
+#include "ModelLoadCancel.h"
+#include "ParallelFor.h"
+#include "VertexQuantization.h"
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -236,6 +240,41 @@ namespace
         return TRUE;
     }
 
+    // VertexQuantization::QuantizeVertex reads the source vertices by offset
+    static_assert(offsetof(VertexPositionNormalTangentColorTexture, normal) == VertexQuantization::c_SourceNormalOffset, "CMO vertex layout mismatch");
+    static_assert(offsetof(VertexPositionNormalTangentColorTexture, tangent) == VertexQuantization::c_SourceTangentOffset, "CMO vertex layout mismatch");
+    static_assert(offsetof(VertexPositionNormalTangentColorTexture, color) == VertexQuantization::c_SourceColorOffset, "CMO vertex layout mismatch");
+    static_assert(offsetof(VertexPositionNormalTangentColorTexture, textureCoordinate) == VertexQuantization::c_SourceTexCoordOffset, "CMO vertex layout mismatch");
+    static_assert(offsetof(VertexPositionNormalTangentColorTextureSkinning, indices) == VertexQuantization::c_SourceSkinningOffset, "CMO vertex layout mismatch");
+    static_assert(offsetof(VertexPositionNormalTangentColorTextureSkinning, weights) == VertexQuantization::c_SourceSkinningOffset + 4, "CMO vertex layout mismatch");
+
+    std::shared_ptr<ModelMeshPart::InputLayoutCollection> CreateQuantizedDecl(VertexQuantization::TexCoordEncoding encoding, bool skinning)
+    {
+        DXGI_FORMAT uvFormat = DXGI_FORMAT_R32G32_FLOAT;
+        switch (encoding)
+        {
+            case VertexQuantization::TexCoordEncoding::UNorm16: uvFormat = DXGI_FORMAT_R16G16_UNORM; break;
+            case VertexQuantization::TexCoordEncoding::Float16: uvFormat = DXGI_FORMAT_R16G16_FLOAT; break;
+            default: break;
+        }
+
+        auto decl = std::make_shared<ModelMeshPart::InputLayoutCollection>();
+        decl->push_back({ "SV_Position", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+        decl->push_back({ "NORMAL", 0, DXGI_FORMAT_R10G10B10A2_UNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+        decl->push_back({ "TANGENT", 0, DXGI_FORMAT_R10G10B10A2_UNORM, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+        decl->push_back({ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+        decl->push_back({ "TEXCOORD", 0, uvFormat, 0, static_cast<UINT>(VertexQuantization::c_TexCoordOffset), D3D11_INPUT_PER_VERTEX_DATA, 0 });
+
+        if (skinning)
+        {
+            const auto offset = static_cast<UINT>(VertexQuantization::c_TexCoordOffset + VertexQuantization::GetTexCoordSize(encoding));
+            decl->push_back({ "BLENDINDICES", 0, DXGI_FORMAT_R8G8B8A8_UINT, 0, offset, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+            decl->push_back({ "BLENDWEIGHT", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, offset + 4, D3D11_INPUT_PER_VERTEX_DATA, 0 });
+        }
+
+        return decl;
+    }
+
     inline XMFLOAT3 GetMaterialColor(float r, float g, float b, bool srgb)
     {
         if (srgb)
@@ -291,8 +330,28 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(
 
     auto model = std::make_unique<Model>();
 
+    // Optionally pack every mesh's VBs and IBs into a few shared buffers
+    const bool consolidate = (flags & ModelLoader_ConsolidateBuffers) != 0;
+
+    const size_t maxBufferSize = (flags & ModelLoader_AllowLargeModels)
+        ? UINT32_MAX : (D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM * 1024u * 1024u);
+
+    GeometryArena vbArena(maxBufferSize);
+    GeometryArena ibArena(maxBufferSize);
+
+    struct PartFixup
+    {
+        ModelMeshPart*              part;
+        GeometryArena::Allocation   vb;
+        GeometryArena::Allocation   ib;
+    };
+
+    std::vector<PartFixup> fixups;
+
     for (size_t meshIndex = 0; meshIndex < *nMesh; ++meshIndex)
     {
+        Internal::CheckModelLoadCancelled();
+
         // Mesh name
         auto nName = reinterpret_cast<const uint32_t*>(meshData + usedSize);
         usedSize += sizeof(uint32_t);
@@ -429,6 +488,9 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(
         std::vector<ComPtr<ID3D11Buffer>> ibs;
         ibs.resize(*nIBs);
 
+        std::vector<GeometryArena::Allocation> ibAllocs;
+        ibAllocs.resize(consolidate ? *nIBs : 0);
+
         for (size_t j = 0; j < *nIBs; ++j)
         {
             auto nIndexes = reinterpret_cast<const uint32_t*>(meshData + usedSize);
@@ -462,6 +524,12 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(
             ib.ptr = indexes;
             ibData.emplace_back(ib);
 
+            if (consolidate)
+            {
+                ibAllocs[j] = ibArena.Append(DXGI_FORMAT_R16_UINT, sizeof(uint16_t), indexes, ibBytes);
+                continue;
+            }
+
             D3D11_BUFFER_DESC desc = {};
             desc.Usage = D3D11_USAGE_DEFAULT;
             desc.ByteWidth = static_cast<UINT>(ibBytes);
@@ -708,18 +776,25 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(
 
         const bool enableSkinning = (*nSkinVBs) != 0 && !(flags & ModelLoader_DisableSkinning);
 
+        // DGSL shaders read full-precision tangent frames, so only the basic effects path is quantized
+        const bool quantize = (flags & ModelLoader_QuantizeVertices) && !fxFactoryDGSL;
+
         // Build vertex buffers
         std::vector<ComPtr<ID3D11Buffer>> vbs;
         vbs.resize(*nVBs);
 
+        std::vector<GeometryArena::Allocation> vbAllocs;
+        vbAllocs.resize(consolidate ? *nVBs : 0);
+
         const size_t stride = enableSkinning ? sizeof(VertexPositionNormalTangentColorTextureSkinning)
             : sizeof(VertexPositionNormalTangentColorTexture);
 
+        std::vector<size_t> vbBytes;
+        vbBytes.resize(*nVBs);
+
         for (size_t j = 0; j < *nVBs; ++j)
         {
-            const size_t nVerts = vbData[j].nVerts;
-
-            const uint64_t sizeInBytes = uint64_t(stride) * uint64_t(nVerts);
+            const uint64_t sizeInBytes = uint64_t(stride) * uint64_t(vbData[j].nVerts);
 
             if (sizeInBytes > UINT32_MAX)
                 throw std::runtime_error("VB too large");
@@ -730,24 +805,33 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(
                     throw std::runtime_error("VB too large for DirectX 11");
             }
 
-            const size_t bytes = static_cast<size_t>(sizeInBytes);
-
-            D3D11_BUFFER_DESC desc = {};
-            desc.Usage = D3D11_USAGE_DEFAULT;
-            desc.ByteWidth = static_cast<UINT>(bytes);
-            desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+            vbBytes[j] = static_cast<size_t>(sizeInBytes);
+        }
 
-            if (fxFactoryDGSL && !enableSkinning)
+        if (!fxFactoryDGSL)
+        {
+            for (size_t k = 0; k < *nSubmesh; ++k)
             {
-                // Can use CMO vertex data directly
-                D3D11_SUBRESOURCE_DATA initData = { vbData[j].ptr, 0, 0 };
+                auto& sm = subMesh[k];
 
-                ThrowIfFailed(
-                    device->CreateBuffer(&desc, &initData, &vbs[j])
-                );
+                if ((sm.IndexBufferIndex >= *nIBs)
+                    || (sm.MaterialIndex >= materials.size()))
+                    throw std::out_of_range("Invalid submesh found\n");
             }
-            else
+        }
+
+        // Each VB is converted independently, so the CPU work runs in parallel with
+        // buffer creation batched afterwards
+        std::vector<std::unique_ptr<uint8_t[]>> vbTemps;
+        vbTemps.resize(*nVBs);
+
+        if (!fxFactoryDGSL || enableSkinning)
+        {
+            ParallelFor(*nVBs, [&](size_t j)
             {
+                const size_t nVerts = vbData[j].nVerts;
+                const size_t bytes = vbBytes[j];
+
                 auto temp = std::make_unique<uint8_t[]>(bytes + (sizeof(uint32_t) * nVerts));
 
                 auto visited = reinterpret_cast<uint32_t*>(temp.get() + bytes);
@@ -791,10 +875,6 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(
                         if (sm.VertexBufferIndex != j)
                             continue;
 
-                        if ((sm.IndexBufferIndex >= *nIBs)
-                            || (sm.MaterialIndex >= materials.size()))
-                            throw std::out_of_range("Invalid submesh found\n");
-
                         const XMMATRIX uvTransform = XMLoadFloat4x4(&materials[sm.MaterialIndex].pMaterial->UVTransform);
 
                         auto ib = ibData[sm.IndexBufferIndex].ptr;
@@ -839,15 +919,86 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(
                     }
                 }
 
-                // Create vertex buffer from temporary buffer
-                D3D11_SUBRESOURCE_DATA initData = { temp.get(), 0, 0 };
+                vbTemps[j] = std::move(temp);
+            });
+        }
+
+        // Optionally re-encode the converted streams into compact vertex formats
+        size_t vbStride = stride;
+        std::shared_ptr<ModelMeshPart::InputLayoutCollection> vbDecl = enableSkinning ? g_vbdeclSkinning : g_vbdecl;
+
+        if (quantize)
+        {
+            // All VBs in a mesh share input layouts, so they must agree on the texcoord format
+            std::vector<VertexQuantization::TexCoordEncoding> encodings;
+            encodings.resize(*nVBs);
+
+            ParallelFor(*nVBs, [&](size_t j)
+            {
+                encodings[j] = VertexQuantization::ChooseTexCoordEncoding(
+                    vbTemps[j].get() + offsetof(VertexPositionNormalTangentColorTexture, textureCoordinate),
+                    stride, vbData[j].nVerts);
+            });
+
+            auto uvEncoding = VertexQuantization::TexCoordEncoding::UNorm16;
+            for (auto it : encodings)
+            {
+                uvEncoding = std::max(uvEncoding, it);
+            }
+
+            vbStride = VertexQuantization::GetVertexSize(uvEncoding, enableSkinning);
+            vbDecl = CreateQuantizedDecl(uvEncoding, enableSkinning);
+
+            ParallelFor(*nVBs, [&](size_t j)
+            {
+                const size_t nVerts = vbData[j].nVerts;
+
+                auto temp = std::make_unique<uint8_t[]>(vbStride * nVerts);
+
+                const uint8_t* sptr = vbTemps[j].get();
+                uint8_t* dptr = temp.get();
+
+                for (size_t v = 0; v < nVerts; ++v)
+                {
+                    VertexQuantization::QuantizeVertex(sptr, dptr, uvEncoding, enableSkinning);
+
+                    sptr += stride;
+                    dptr += vbStride;
+                }
+
+                vbTemps[j] = std::move(temp);
+                vbBytes[j] = vbStride * nVerts;
+            });
+        }
+
+        Internal::CheckModelLoadCancelled();
+
+        for (size_t j = 0; j < *nVBs; ++j)
+        {
+            // Can use CMO vertex data directly if it was not converted
+            const void* verts = vbTemps[j] ? static_cast<const void*>(vbTemps[j].get()) : vbData[j].ptr;
+
+            if (consolidate)
+            {
+                vbAllocs[j] = vbArena.Append(static_cast<uint32_t>(vbStride), vbStride, verts, vbBytes[j]);
+            }
+            else
+            {
+                D3D11_BUFFER_DESC desc = {};
+                desc.Usage = D3D11_USAGE_DEFAULT;
+                desc.ByteWidth = static_cast<UINT>(vbBytes[j]);
+                desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+                D3D11_SUBRESOURCE_DATA initData = { verts, 0, 0 };
 
                 ThrowIfFailed(
                     device->CreateBuffer(&desc, &initData, &vbs[j])
                 );
+
+                SetDebugObjectName(vbs[j].Get(), "ModelCMO");
             }
 
-            SetDebugObjectName(vbs[j].Get(), "ModelCMO");
+            vbTemps[j].reset();
         }
 
         assert(vbs.size() == *nVBs);
@@ -901,11 +1052,23 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(
                 info.specularColor = GetMaterialColor(m.pMaterial->Specular.x, m.pMaterial->Specular.y, m.pMaterial->Specular.z, srgb);
                 info.emissiveColor = GetMaterialColor(m.pMaterial->Emissive.x, m.pMaterial->Emissive.y, m.pMaterial->Emissive.z, srgb);
                 info.diffuseTexture = m.texture[0].c_str();
+                info.biasedVertexNormals = quantize;
 
                 m.effect = fxFactory.CreateEffect(info, nullptr);
             }
 
-            CreateCMOInputLayout(device, m.effect.get(), &m.il, enableSkinning);
+            if (quantize)
+            {
+                ThrowIfFailed(
+                    CreateInputLayoutFromEffect(device, m.effect.get(), vbDecl->data(), vbDecl->size(), m.il.ReleaseAndGetAddressOf())
+                );
+
+                SetDebugObjectName(m.il.Get(), "ModelCMO");
+            }
+            else
+            {
+                CreateCMOInputLayout(device, m.effect.get(), &m.il, enableSkinning);
+            }
         }
 
         // Build mesh parts
@@ -927,12 +1090,26 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(
 
             part->indexCount = sm.PrimCount * 3;
             part->startIndex = sm.StartIndex;
-            part->vertexStride = static_cast<UINT>(stride);
+            part->vertexStride = static_cast<UINT>(vbStride);
             part->inputLayout = mat.il;
             part->indexBuffer = ibs[sm.IndexBufferIndex];
             part->vertexBuffer = vbs[sm.VertexBufferIndex];
             part->effect = mat.effect;
-            part->vbDecl = enableSkinning ? g_vbdeclSkinning : g_vbdecl;
+            part->vbDecl = vbDecl;
+
+            if (flags & ModelLoader_BuildPickingBVH)
+            {
+                // Positions are read from the file's vertices, ahead of any skinning or quantization
+                auto& vb = vbData[sm.VertexBufferIndex];
+                auto& ib = ibData[sm.IndexBufferIndex];
+                part->CreatePickingBVH(&vb.ptr->position, sizeof(VertexPositionNormalTangentColorTexture), vb.nVerts,
+                    ib.ptr, ib.nIndices);
+            }
+
+            if (consolidate)
+            {
+                fixups.emplace_back(PartFixup{ part, vbAllocs[sm.VertexBufferIndex], ibAllocs[sm.IndexBufferIndex] });
+            }
 
             mesh->meshParts.emplace_back(part);
         }
@@ -940,6 +1117,33 @@ std::unique_ptr<Model> DirectX::Model::CreateFromCMO(
         model->meshes.emplace_back(mesh);
     }
 
+    if (consolidate)
+    {
+        Internal::CheckModelLoadCancelled();
+
+        std::vector<ComPtr<ID3D11Buffer>> vbs;
+        CreateGeometryArenaBuffers(device, vbArena, D3D11_BIND_VERTEX_BUFFER, "ModelCMO", vbs);
+        vbArena.Clear();
+
+        std::vector<ComPtr<ID3D11Buffer>> ibs;
+        CreateGeometryArenaBuffers(device, ibArena, D3D11_BIND_INDEX_BUFFER, "ModelCMO", ibs);
+        ibArena.Clear();
+
+        for (auto& it : fixups)
+        {
+            auto part = it.part;
+
+            const size_t baseVertex = it.vb.offset / part->vertexStride;
+            if (baseVertex > INT32_MAX)
+                throw std::runtime_error("Consolidated VB too large");
+
+            part->vertexBuffer = vbs[it.vb.buffer];
+            part->vertexOffset += static_cast<INT>(baseVertex);
+            part->indexBuffer = ibs[it.ib.buffer];
+            part->startIndex += static_cast<uint32_t>(it.ib.offset / sizeof(uint16_t));
+        }
+    }
+
     return model;
 }
 
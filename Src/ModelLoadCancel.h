@@ -0,0 +1,24 @@
+//--------------------------------------------------------------------------------------
+// File: ModelLoadCancel.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+
+namespace DirectX
+{
+    namespace Internal
+    {
+        // Cancellation point for the model loaders, called once a file has been parsed and
+        // validated and before its GPU buffers are created. When the calling thread is running
+        // a ModelLoadQueue job that has been cancelled this throws, and the worker completes the
+        // handle with no model; for synchronous loads it does nothing.
+        void CheckModelLoadCancelled();
+    }
+}
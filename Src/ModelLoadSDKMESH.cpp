@@ -15,6 +15,8 @@
 #include "BinaryReader.h"
 #include "PlatformHelpers.h"
 #include "SDKMesh.h"
+#include "GeometryArena.h"
+#include "ModelLoadCancel.h"
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -361,6 +363,22 @@ namespace
 
         return flags;
     }
+
+    //--------------------------------------------------------------------------------------
+    // Byte offset of the position within a vertex (GetInputLayoutDesc requires it be FLOAT3)
+    size_t GetPositionOffset(_In_reads_(32) const DXUT::D3DVERTEXELEMENT9 decl[])
+    {
+        for (uint32_t index = 0; index < DXUT::MAX_VERTEX_ELEMENTS; ++index)
+        {
+            if (decl[index].Usage == 0xFF || decl[index].Type == DXUT::D3DDECLTYPE_UNUSED)
+                break;
+
+            if (decl[index].Usage == DXUT::D3DDECLUSAGE_POSITION && decl[index].Type == DXUT::D3DDECLTYPE_FLOAT3)
+                return decl[index].Offset;
+        }
+
+        throw std::runtime_error("SV_Position is required");
+    }
 }
 
 
@@ -472,10 +490,23 @@ std::unique_ptr<Model> DirectX::Model::CreateFromSDKMESH(
         throw std::runtime_error("End of file");
     const uint8_t* bufferData = meshData + bufferDataOffset;
 
+    // Optionally pack the VBs and IBs into a few shared buffers
+    const bool consolidate = (flags & ModelLoader_ConsolidateBuffers) != 0;
+
+    const size_t maxBufferSize = (flags & ModelLoader_AllowLargeModels)
+        ? UINT32_MAX : (D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM * 1024u * 1024u);
+
+    GeometryArena arena(maxBufferSize);
+
+    Internal::CheckModelLoadCancelled();
+
     // Create vertex buffers
     std::vector<ComPtr<ID3D11Buffer>> vbs;
     vbs.resize(header->NumVertexBuffers);
 
+    std::vector<GeometryArena::Allocation> vbAllocs;
+    vbAllocs.resize(consolidate ? header->NumVertexBuffers : 0);
+
     std::vector<std::shared_ptr<ModelMeshPart::InputLayoutCollection>> vbDecls;
     vbDecls.resize(header->NumVertexBuffers);
 
@@ -521,6 +552,16 @@ std::unique_ptr<Model> DirectX::Model::CreateFromSDKMESH(
 
         auto verts = bufferData + (vh.DataOffset - bufferDataOffset);
 
+        if (consolidate)
+        {
+            if (!vh.StrideBytes || vh.StrideBytes > UINT32_MAX)
+                throw std::runtime_error("Invalid vertex buffer stride");
+
+            vbAllocs[j] = arena.Append(static_cast<uint32_t>(vh.StrideBytes), static_cast<size_t>(vh.StrideBytes),
+                verts, static_cast<size_t>(vh.SizeBytes));
+            continue;
+        }
+
         D3D11_BUFFER_DESC desc = {};
         desc.Usage = D3D11_USAGE_DEFAULT;
         desc.ByteWidth = static_cast<UINT>(vh.SizeBytes);
@@ -541,10 +582,25 @@ std::unique_ptr<Model> DirectX::Model::CreateFromSDKMESH(
             "         (treating as DXGI_FORMAT_R10G10B10A2_UNORM which is not a signed format)\n");
     }
 
+    if (consolidate)
+    {
+        std::vector<ComPtr<ID3D11Buffer>> buffers;
+        CreateGeometryArenaBuffers(d3dDevice, arena, D3D11_BIND_VERTEX_BUFFER, "ModelSDKMESH", buffers);
+        arena.Clear();
+
+        for (size_t j = 0; j < header->NumVertexBuffers; ++j)
+        {
+            vbs[j] = buffers[vbAllocs[j].buffer];
+        }
+    }
+
     // Create index buffers
     std::vector<ComPtr<ID3D11Buffer>> ibs;
     ibs.resize(header->NumIndexBuffers);
 
+    std::vector<GeometryArena::Allocation> ibAllocs;
+    ibAllocs.resize(consolidate ? header->NumIndexBuffers : 0);
+
     for (size_t j = 0; j < header->NumIndexBuffers; ++j)
     {
         auto& ih = ibArray[j];
@@ -567,6 +623,13 @@ std::unique_ptr<Model> DirectX::Model::CreateFromSDKMESH(
 
         auto indices = bufferData + (ih.DataOffset - bufferDataOffset);
 
+        if (consolidate)
+        {
+            const size_t indexSize = (ih.IndexType == DXUT::IT_32BIT) ? sizeof(uint32_t) : sizeof(uint16_t);
+            ibAllocs[j] = arena.Append(ih.IndexType, indexSize, indices, static_cast<size_t>(ih.SizeBytes));
+            continue;
+        }
+
         D3D11_BUFFER_DESC desc = {};
         desc.Usage = D3D11_USAGE_DEFAULT;
         desc.ByteWidth = static_cast<UINT>(ih.SizeBytes);
@@ -581,6 +644,18 @@ std::unique_ptr<Model> DirectX::Model::CreateFromSDKMESH(
         SetDebugObjectName(ibs[j].Get(), "ModelSDKMESH");
     }
 
+    if (consolidate)
+    {
+        std::vector<ComPtr<ID3D11Buffer>> buffers;
+        CreateGeometryArenaBuffers(d3dDevice, arena, D3D11_BIND_INDEX_BUFFER, "ModelSDKMESH", buffers);
+        arena.Clear();
+
+        for (size_t j = 0; j < header->NumIndexBuffers; ++j)
+        {
+            ibs[j] = buffers[ibAllocs[j].buffer];
+        }
+    }
+
     // Create meshes
     std::vector<MaterialRecordSDKMESH> materials;
     materials.resize(header->NumMaterials);
@@ -719,6 +794,36 @@ std::unique_ptr<Model> DirectX::Model::CreateFromSDKMESH(
             part->effect = mat.effect;
             part->vbDecl = vbDecls[mh.VertexBuffers[0]];
 
+            if ((flags & ModelLoader_BuildPickingBVH) && primType == D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+            {
+                auto& vh = vbArray[mh.VertexBuffers[0]];
+                auto& ih = ibArray[mh.IndexBuffer];
+
+                const size_t posOffset = GetPositionOffset(vh.Decl);
+                if (vh.StrideBytes < posOffset + sizeof(XMFLOAT3))
+                    throw std::runtime_error("Invalid vertex buffer stride");
+
+                auto verts = bufferData + (vh.DataOffset - bufferDataOffset) + posOffset;
+                auto indices = bufferData + (ih.DataOffset - bufferDataOffset);
+                const size_t indexSize = (ih.IndexType == DXUT::IT_32BIT) ? sizeof(uint32_t) : sizeof(uint16_t);
+
+                part->CreatePickingBVH(reinterpret_cast<const XMFLOAT3*>(verts), static_cast<size_t>(vh.StrideBytes),
+                    static_cast<size_t>(vh.SizeBytes / vh.StrideBytes),
+                    indices, static_cast<size_t>(ih.SizeBytes / indexSize));
+            }
+
+            if (consolidate)
+            {
+                const size_t baseVertex = vbAllocs[mh.VertexBuffers[0]].offset / part->vertexStride;
+                if (baseVertex + subset.VertexStart > INT32_MAX)
+                    throw std::runtime_error("Consolidated VB too large");
+
+                part->vertexOffset += static_cast<int32_t>(baseVertex);
+
+                const size_t indexSize = (part->indexFormat == DXGI_FORMAT_R32_UINT) ? sizeof(uint32_t) : sizeof(uint16_t);
+                part->startIndex += static_cast<uint32_t>(ibAllocs[mh.IndexBuffer].offset / indexSize);
+            }
+
             mesh->meshParts.emplace_back(part);
         }
 
@@ -13,6 +13,8 @@
 #include "Effects.h"
 #include "VertexTypes.h"
 #include "BinaryReader.h"
+#include "MemoryMappedFile.h"
+#include "ModelLoadCancel.h"
 #include "PlatformHelpers.h"
 
 #include "vbo.h"
@@ -41,6 +43,229 @@ namespace
 
         return TRUE;
     }
+
+    void CreateBuffer(
+        _In_ ID3D11Device* device,
+        _In_reads_bytes_(bytes) const void* data, size_t bytes,
+        UINT bindFlags,
+        _Outptr_ ID3D11Buffer** buffer)
+    {
+        D3D11_BUFFER_DESC desc = {};
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.ByteWidth = static_cast<UINT>(bytes);
+        desc.BindFlags = bindFlags;
+
+        D3D11_SUBRESOURCE_DATA initData = { data, 0, 0 };
+
+        ThrowIfFailed(
+            device->CreateBuffer(&desc, &initData, buffer)
+        );
+
+        SetDebugObjectName(*buffer, "ModelVBO");
+    }
+
+    size_t ValidateStreamSize(uint64_t sizeInBytes, ModelLoaderFlags flags, bool index)
+    {
+        if (sizeInBytes > UINT32_MAX)
+            throw std::runtime_error(index ? "IB too large" : "VB too large");
+
+        if (!(flags & ModelLoader_AllowLargeModels))
+        {
+            if (sizeInBytes > uint64_t(D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM * 1024u * 1024u))
+                throw std::runtime_error(index ? "IB too large for DirectX 11" : "VB too large for DirectX 11");
+        }
+
+        return static_cast<size_t>(sizeInBytes);
+    }
+
+    void CreateDefaultEffect(
+        _In_ ID3D11Device* device,
+        std::shared_ptr<IEffect>& ieffect,
+        ComPtr<ID3D11InputLayout>& il)
+    {
+        if (!ieffect)
+        {
+            auto effect = std::make_shared<BasicEffect>(device);
+            effect->EnableDefaultLighting();
+            effect->SetLightingEnabled(true);
+
+            ieffect = effect;
+        }
+
+        ThrowIfFailed(
+            CreateInputLayoutFromEffect<VertexPositionNormalTexture>(device, ieffect.get(), il.ReleaseAndGetAddressOf())
+        );
+
+        SetDebugObjectName(il.Get(), "ModelVBO");
+    }
+
+    // Stored bounds are only trusted when they are finite with non-negative extents.
+    bool BoundsAreValid(const float center[3], const float extents[3]) noexcept
+    {
+        for (size_t j = 0; j < 3; ++j)
+        {
+            if (!std::isfinite(center[j]) || !std::isfinite(extents[j]) || extents[j] < 0.f)
+                return false;
+        }
+
+        return true;
+    }
+
+    // Rebuilds a submesh box from the vertices its indices reference.
+    BoundingBox ComputeSubmeshBounds(
+        _In_reads_(numVertices) const VertexPositionNormalTexture* verts, uint32_t numVertices,
+        _In_ const uint8_t* indices, bool index32,
+        const VBO::submesh_t& sm)
+    {
+        XMVECTOR vMin = g_XMFltMax;
+        XMVECTOR vMax = XMVectorNegate(g_XMFltMax);
+
+        for (uint32_t j = 0; j < sm.indexCount; ++j)
+        {
+            const size_t i = size_t(sm.startIndex) + j;
+            const uint32_t index = index32
+                ? reinterpret_cast<const uint32_t*>(indices)[i]
+                : reinterpret_cast<const uint16_t*>(indices)[i];
+
+            const int64_t vertex = int64_t(index) + sm.baseVertex;
+            if (vertex < 0 || vertex >= int64_t(numVertices))
+                throw std::out_of_range("Invalid submesh index found");
+
+            const XMVECTOR pos = XMLoadFloat3(&verts[vertex].position);
+            vMin = XMVectorMin(vMin, pos);
+            vMax = XMVectorMax(vMax, pos);
+        }
+
+        if (XMVector3IsNaN(vMin) || XMVector3IsNaN(vMax) || XMVector3IsInfinite(vMin) || XMVector3IsInfinite(vMax))
+            throw std::runtime_error("Invalid vertex position found");
+
+        BoundingBox box;
+        BoundingBox::CreateFromPoints(box, vMin, vMax);
+        return box;
+    }
+
+    //----------------------------------------------------------------------------------
+    // Version 2: 16 or 32-bit indices, multiple submeshes, and precomputed bounds. Buffers are
+    // created directly from the file image; invalid bounds are recomputed from the vertices.
+    std::unique_ptr<Model> CreateFromVBOv2(
+        _In_ ID3D11Device* device,
+        _In_reads_bytes_(dataSize) const uint8_t* meshData, size_t dataSize,
+        std::shared_ptr<IEffect> ieffect,
+        ModelLoaderFlags flags)
+    {
+        if (dataSize < sizeof(VBO::header_v2_t))
+            throw std::runtime_error("End of file");
+        auto header = reinterpret_cast<const VBO::header_v2_t*>(meshData);
+
+        if (header->version != VBO::V2_VERSION)
+            throw std::runtime_error("VBO version not supported");
+
+        if (!header->numVertices || !header->numIndices)
+            throw std::runtime_error("No vertices or indices found");
+
+        if (header->indexFormat != VBO::INDEX_16BIT && header->indexFormat != VBO::INDEX_32BIT)
+            throw std::runtime_error("Invalid index format found");
+
+        const bool index32 = (header->indexFormat == VBO::INDEX_32BIT);
+
+        uint64_t usedSize = sizeof(VBO::header_v2_t);
+
+        auto submeshes = reinterpret_cast<const VBO::submesh_t*>(meshData + usedSize);
+        usedSize += uint64_t(header->numSubmeshes) * sizeof(VBO::submesh_t);
+        if (dataSize < usedSize)
+            throw std::runtime_error("End of file");
+
+        const size_t vertSize = ValidateStreamSize(uint64_t(header->numVertices) * sizeof(VertexPositionNormalTexture), flags, false);
+
+        auto verts = meshData + usedSize;
+        usedSize += vertSize;
+        if (dataSize < usedSize)
+            throw std::runtime_error("End of file");
+
+        const size_t indexSize = ValidateStreamSize(uint64_t(header->numIndices) * (index32 ? sizeof(uint32_t) : sizeof(uint16_t)), flags, true);
+
+        auto indices = meshData + usedSize;
+        usedSize += indexSize;
+        if (dataSize < usedSize)
+            throw std::runtime_error("End of file");
+
+        Internal::CheckModelLoadCancelled();
+
+        ComPtr<ID3D11Buffer> vb;
+        CreateBuffer(device, verts, vertSize, D3D11_BIND_VERTEX_BUFFER, vb.GetAddressOf());
+
+        ComPtr<ID3D11Buffer> ib;
+        CreateBuffer(device, indices, indexSize, D3D11_BIND_INDEX_BUFFER, ib.GetAddressOf());
+
+        ComPtr<ID3D11InputLayout> il;
+        CreateDefaultEffect(device, ieffect, il);
+
+        // A file without submesh records is drawn as a single mesh
+        VBO::submesh_t whole = {};
+        whole.indexCount = header->numIndices;
+        memcpy(whole.boundsCenter, header->boundsCenter, sizeof(whole.boundsCenter));
+        memcpy(whole.boundsExtents, header->boundsExtents, sizeof(whole.boundsExtents));
+
+        const size_t count = header->numSubmeshes ? header->numSubmeshes : 1u;
+        if (!header->numSubmeshes)
+        {
+            submeshes = &whole;
+        }
+
+        auto model = std::make_unique<Model>();
+        model->meshes.reserve(count);
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            auto& sm = submeshes[j];
+
+            if (!sm.indexCount
+                || sm.startIndex >= header->numIndices
+                || sm.indexCount > (header->numIndices - sm.startIndex))
+                throw std::out_of_range("Invalid submesh found");
+
+            auto part = new ModelMeshPart();
+            part->indexCount = sm.indexCount;
+            part->startIndex = sm.startIndex;
+            part->vertexOffset = sm.baseVertex;
+            part->vertexStride = static_cast<UINT>(sizeof(VertexPositionNormalTexture));
+            part->indexFormat = index32 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+            part->inputLayout = il;
+            part->indexBuffer = ib;
+            part->vertexBuffer = vb;
+            part->effect = ieffect;
+            part->vbDecl = g_vbdecl;
+
+            if (flags & ModelLoader_BuildPickingBVH)
+            {
+                part->CreatePickingBVH(
+                    &reinterpret_cast<const VertexPositionNormalTexture*>(verts)->position, sizeof(VertexPositionNormalTexture), header->numVertices,
+                    indices, header->numIndices);
+            }
+
+            auto mesh = std::make_shared<ModelMesh>();
+            mesh->ccw = (flags & ModelLoader_CounterClockwise) != 0;
+            mesh->pmalpha = (flags & ModelLoader_PremultipledAlpha) != 0;
+            if (BoundsAreValid(sm.boundsCenter, sm.boundsExtents))
+            {
+                mesh->boundingBox.Center = XMFLOAT3(sm.boundsCenter);
+                mesh->boundingBox.Extents = XMFLOAT3(sm.boundsExtents);
+            }
+            else
+            {
+                // NaN or negative bounds would break culling, so fall back to the vertex data
+                mesh->boundingBox = ComputeSubmeshBounds(
+                    reinterpret_cast<const VertexPositionNormalTexture*>(verts), header->numVertices,
+                    indices, index32, sm);
+            }
+            BoundingSphere::CreateFromBoundingBox(mesh->boundingSphere, mesh->boundingBox);
+            mesh->meshParts.emplace_back(part);
+
+            model->meshes.emplace_back(mesh);
+        }
+
+        return model;
+    }
 }
 
 
@@ -58,6 +283,11 @@ std::unique_ptr<Model> DirectX::Model::CreateFromVBO(
     if (!device || !meshData)
         throw std::invalid_argument("Device and meshData cannot be null");
 
+    if (dataSize >= sizeof(uint32_t) && *reinterpret_cast<const uint32_t*>(meshData) == VBO::V2_MAGIC)
+    {
+        return CreateFromVBOv2(device, meshData, dataSize, ieffect, flags);
+    }
+
     // File Header
     if (dataSize < sizeof(VBO::header_t))
         throw std::runtime_error("End of file");
@@ -66,91 +296,31 @@ std::unique_ptr<Model> DirectX::Model::CreateFromVBO(
     if (!header->numVertices || !header->numIndices)
         throw std::runtime_error("No vertices or indices found");
 
-    uint64_t sizeInBytes = uint64_t(header->numVertices) * sizeof(VertexPositionNormalTexture);
-
-    if (sizeInBytes > UINT32_MAX)
-        throw std::runtime_error("VB too large");
-
-    if (!(flags & ModelLoader_AllowLargeModels))
-    {
-        if (sizeInBytes > uint64_t(D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM * 1024u * 1024u))
-            throw std::runtime_error("VB too large for DirectX 11");
-    }
-
-    auto const vertSize = static_cast<size_t>(sizeInBytes);
+    auto const vertSize = ValidateStreamSize(uint64_t(header->numVertices) * sizeof(VertexPositionNormalTexture), flags, false);
 
     if (dataSize < (vertSize + sizeof(VBO::header_t)))
         throw std::runtime_error("End of file");
     auto verts = reinterpret_cast<const VertexPositionNormalTexture*>(meshData + sizeof(VBO::header_t));
 
-    sizeInBytes = uint64_t(header->numIndices) * sizeof(uint16_t);
-
-    if (sizeInBytes > UINT32_MAX)
-        throw std::runtime_error("IB too large");
-
-    if (!(flags & ModelLoader_AllowLargeModels))
-    {
-        if (sizeInBytes > uint64_t(D3D11_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_A_TERM * 1024u * 1024u))
-            throw std::runtime_error("IB too large for DirectX 11");
-    }
-
-    auto const indexSize = static_cast<size_t>(sizeInBytes);
+    auto const indexSize = ValidateStreamSize(uint64_t(header->numIndices) * sizeof(uint16_t), flags, true);
 
     if (dataSize < (sizeof(VBO::header_t) + vertSize + indexSize))
         throw std::runtime_error("End of file");
     auto indices = reinterpret_cast<const uint16_t*>(meshData + sizeof(VBO::header_t) + vertSize);
 
+    Internal::CheckModelLoadCancelled();
+
     // Create vertex buffer
     ComPtr<ID3D11Buffer> vb;
-    {
-        D3D11_BUFFER_DESC desc = {};
-        desc.Usage = D3D11_USAGE_DEFAULT;
-        desc.ByteWidth = static_cast<UINT>(vertSize);
-        desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-
-        D3D11_SUBRESOURCE_DATA initData = { verts, 0, 0 };
-
-        ThrowIfFailed(
-            device->CreateBuffer(&desc, &initData, vb.GetAddressOf())
-        );
-
-        SetDebugObjectName(vb.Get(), "ModelVBO");
-    }
+    CreateBuffer(device, verts, vertSize, D3D11_BIND_VERTEX_BUFFER, vb.GetAddressOf());
 
     // Create index buffer
     ComPtr<ID3D11Buffer> ib;
-    {
-        D3D11_BUFFER_DESC desc = {};
-        desc.Usage = D3D11_USAGE_DEFAULT;
-        desc.ByteWidth = static_cast<UINT>(indexSize);
-        desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-
-        D3D11_SUBRESOURCE_DATA initData = { indices, 0, 0 };
-
-        ThrowIfFailed(
-            device->CreateBuffer(&desc, &initData, ib.GetAddressOf())
-        );
-
-        SetDebugObjectName(ib.Get(), "ModelVBO");
-    }
+    CreateBuffer(device, indices, indexSize, D3D11_BIND_INDEX_BUFFER, ib.GetAddressOf());
 
     // Create input layout and effect
-    if (!ieffect)
-    {
-        auto effect = std::make_shared<BasicEffect>(device);
-        effect->EnableDefaultLighting();
-        effect->SetLightingEnabled(true);
-
-        ieffect = effect;
-    }
-
     ComPtr<ID3D11InputLayout> il;
-
-    ThrowIfFailed(
-        CreateInputLayoutFromEffect<VertexPositionNormalTexture>(device, ieffect.get(), il.GetAddressOf())
-    );
-
-    SetDebugObjectName(il.Get(), "ModelVBO");
+    CreateDefaultEffect(device, ieffect, il);
 
     auto part = new ModelMeshPart();
     part->indexCount = header->numIndices;
@@ -162,6 +332,11 @@ std::unique_ptr<Model> DirectX::Model::CreateFromVBO(
     part->effect = ieffect;
     part->vbDecl = g_vbdecl;
 
+    if (flags & ModelLoader_BuildPickingBVH)
+    {
+        part->CreatePickingBVH(&verts->position, sizeof(VertexPositionNormalTexture), header->numVertices, indices, header->numIndices);
+    }
+
     auto mesh = std::make_shared<ModelMesh>();
     mesh->ccw = (flags & ModelLoader_CounterClockwise) != 0;
     mesh->pmalpha = (flags & ModelLoader_PremultipledAlpha) != 0;
@@ -184,9 +359,9 @@ std::unique_ptr<Model> DirectX::Model::CreateFromVBO(
     std::shared_ptr<IEffect> ieffect,
     ModelLoaderFlags flags)
 {
-    size_t dataSize = 0;
-    std::unique_ptr<uint8_t[]> data;
-    HRESULT hr = BinaryReader::ReadEntireFile(szFileName, data, &dataSize);
+    // The file is mapped rather than read so buffers are created straight from the file data
+    MemoryMappedFile file;
+    HRESULT hr = file.Open(szFileName);
     if (FAILED(hr))
     {
         DebugTrace("ERROR: CreateFromVBO failed (%08X) loading '%ls'\n",
@@ -194,7 +369,7 @@ std::unique_ptr<Model> DirectX::Model::CreateFromVBO(
         throw std::runtime_error("CreateFromVBO");
     }
 
-    auto model = CreateFromVBO(device, data.get(), dataSize, ieffect, flags);
+    auto model = CreateFromVBO(device, file.GetData(), file.GetSize(), ieffect, flags);
 
     model->name = szFileName;
 
@@ -286,6 +286,26 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<NormalMapEffectTraits>::DeviceResources> EffectBase<NormalMapEffectTraits>::deviceResourcesPool = {};
 
 
+// Queues shader permutations for EffectShaderWarmUp.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::WarmUpNormalMapEffectShaders(ID3D11Device* device, const uint32_t* permutations, size_t count, std::vector<EffectWarmUpTask>& tasks)
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0)
+        return nullptr;
+
+    return EffectBase<NormalMapEffectTraits>::WarmUpShaders(device, permutations, count, tasks);
+}
+
+_Use_decl_annotations_
+void DirectX::GetNormalMapEffectUsedPermutations(ID3D11Device* device, std::vector<uint32_t>& permutations)
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0)
+        return;
+
+    EffectBase<NormalMapEffectTraits>::GetUsedPermutations(device, permutations);
+}
+
+
 // Constructor.
 NormalMapEffect::Impl::Impl(_In_ ID3D11Device* device)
     : EffectBase(device),
@@ -376,6 +396,8 @@ void NormalMapEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
     assert(deviceContext != nullptr);
 
+    StateFilter filter(deviceContext);
+
     // Compute derived parameter values.
     matrices.SetConstants(dirtyFlags, constants.worldViewProj);
 
@@ -401,7 +423,7 @@ void NormalMapEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
         }
 
         ID3D11Buffer* buffer = mBones.GetBuffer();
-        deviceContext->VSSetConstantBuffers(1, 1, &buffer);
+        filter.VSSetConstantBuffers(1, 1, &buffer);
     #endif
     }
 
@@ -412,7 +434,7 @@ void NormalMapEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
         (normalTexture) ? normalTexture.Get() : GetDefaultNormalTexture(),
         specularTexture.Get()
     };
-    deviceContext->PSSetShaderResources(0, 3, textures);
+    filter.PSSetShaderResources(0, 3, textures);
 
     // Set shaders and constant buffers.
     ApplyShaders(deviceContext, GetCurrentShaderPermutation());
@@ -450,7 +472,7 @@ void NormalMapEffect::GetVertexShaderBytecode(_Out_ void const** pShaderByteCode
 // Camera settings.
 void XM_CALLCONV NormalMapEffect::SetWorld(FXMMATRIX value)
 {
-    pImpl->matrices.world = value;
+    pImpl->matrices.SetWorld(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::FogVector;
 }
@@ -458,7 +480,7 @@ void XM_CALLCONV NormalMapEffect::SetWorld(FXMMATRIX value)
 
 void XM_CALLCONV NormalMapEffect::SetView(FXMMATRIX value)
 {
-    pImpl->matrices.view = value;
+    pImpl->matrices.SetView(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
 }
@@ -474,14 +496,30 @@ void XM_CALLCONV NormalMapEffect::SetProjection(FXMMATRIX value)
 
 void XM_CALLCONV NormalMapEffect::SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection)
 {
-    pImpl->matrices.world = world;
-    pImpl->matrices.view = view;
+    pImpl->matrices.SetWorld(world);
+    pImpl->matrices.SetView(view);
     pImpl->matrices.projection = projection;
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
 }
 
 
+void NormalMapEffect::SetCamera(const EffectCamera& camera)
+{
+    pImpl->matrices.SetCamera(camera);
+
+    pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
+}
+
+
+void NormalMapEffect::SetWorldTransform(const EffectWorldTransform& transform)
+{
+    pImpl->matrices.SetWorldTransform(transform);
+
+    pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::FogVector;
+}
+
+
 // Material settings.
 void XM_CALLCONV NormalMapEffect::SetDiffuseColor(FXMVECTOR value)
 {
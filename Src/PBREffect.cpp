@@ -246,6 +246,27 @@ const int EffectBase<PBREffectTraits>::PixelShaderIndices[] =
 template<>
 SharedResourcePool<ID3D11Device*, EffectBase<PBREffectTraits>::DeviceResources> EffectBase<PBREffectTraits>::deviceResourcesPool = {};
 
+
+// Queues shader permutations for EffectShaderWarmUp.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::WarmUpPBREffectShaders(ID3D11Device* device, const uint32_t* permutations, size_t count, std::vector<EffectWarmUpTask>& tasks)
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0)
+        return nullptr;
+
+    return EffectBase<PBREffectTraits>::WarmUpShaders(device, permutations, count, tasks);
+}
+
+_Use_decl_annotations_
+void DirectX::GetPBREffectUsedPermutations(ID3D11Device* device, std::vector<uint32_t>& permutations)
+{
+    if (device->GetFeatureLevel() < D3D_FEATURE_LEVEL_10_0)
+        return;
+
+    EffectBase<PBREffectTraits>::GetUsedPermutations(device, permutations);
+}
+
+
 // Constructor.
 PBREffect::Impl::Impl(_In_ ID3D11Device* device)
     : EffectBase(device),
@@ -346,6 +367,8 @@ void PBREffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
     assert(deviceContext != nullptr);
 
+    StateFilter filter(deviceContext);
+
     // Store old wvp for velocity calculation in shader
     constants.prevWorldViewProj = constants.worldViewProj;
 
@@ -357,11 +380,7 @@ void PBREffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
     {
         constants.world = XMMatrixTranspose(matrices.world);
 
-        const XMMATRIX worldInverse = XMMatrixInverse(nullptr, matrices.world);
-
-        constants.worldInverseTranspose[0] = worldInverse.r[0];
-        constants.worldInverseTranspose[1] = worldInverse.r[1];
-        constants.worldInverseTranspose[2] = worldInverse.r[2];
+        matrices.GetWorldInverseTranspose(constants.worldInverseTranspose);
 
         dirtyFlags &= ~EffectDirtyFlags::WorldInverseTranspose;
         dirtyFlags |= EffectDirtyFlags::ConstantBuffer;
@@ -370,9 +389,7 @@ void PBREffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
     // Eye position vector.
     if (dirtyFlags & EffectDirtyFlags::EyePosition)
     {
-        const XMMATRIX viewInverse = XMMatrixInverse(nullptr, matrices.view);
-
-        constants.eyePosition = viewInverse.r[3];
+        constants.eyePosition = matrices.GetEyePosition();
 
         dirtyFlags &= ~EffectDirtyFlags::EyePosition;
         dirtyFlags |= EffectDirtyFlags::ConstantBuffer;
@@ -396,7 +413,7 @@ void PBREffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
         }
 
         ID3D11Buffer* buffer = mBones.GetBuffer();
-        deviceContext->VSSetConstantBuffers(1, 1, &buffer);
+        filter.VSSetConstantBuffers(1, 1, &buffer);
     #endif
     }
 
@@ -409,7 +426,7 @@ void PBREffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
             emissiveTexture.Get(),
             radianceTexture.Get(), irradianceTexture.Get()
         };
-        deviceContext->PSSetShaderResources(0, 6, textures);
+        filter.PSSetShaderResources(0, 6, textures);
     }
     else
     {
@@ -419,7 +436,7 @@ void PBREffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
             nullptr,
             radianceTexture.Get(), irradianceTexture.Get()
         };
-        deviceContext->PSSetShaderResources(0, 6, textures);
+        filter.PSSetShaderResources(0, 6, textures);
     }
 
     // Set shaders and constant buffers.
@@ -458,7 +475,7 @@ void PBREffect::GetVertexShaderBytecode(_Out_ void const** pShaderByteCode, _Out
 // Camera settings.
 void XM_CALLCONV PBREffect::SetWorld(FXMMATRIX value)
 {
-    pImpl->matrices.world = value;
+    pImpl->matrices.SetWorld(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose;
 }
@@ -466,7 +483,7 @@ void XM_CALLCONV PBREffect::SetWorld(FXMMATRIX value)
 
 void XM_CALLCONV PBREffect::SetView(FXMMATRIX value)
 {
-    pImpl->matrices.view = value;
+    pImpl->matrices.SetView(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::EyePosition;
 }
@@ -482,14 +499,30 @@ void XM_CALLCONV PBREffect::SetProjection(FXMMATRIX value)
 
 void XM_CALLCONV PBREffect::SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection)
 {
-    pImpl->matrices.world = world;
-    pImpl->matrices.view = view;
+    pImpl->matrices.SetWorld(world);
+    pImpl->matrices.SetView(view);
     pImpl->matrices.projection = projection;
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::EyePosition;
 }
 
 
+void PBREffect::SetCamera(const EffectCamera& camera)
+{
+    pImpl->matrices.SetCamera(camera);
+
+    pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::EyePosition;
+}
+
+
+void PBREffect::SetWorldTransform(const EffectWorldTransform& transform)
+{
+    pImpl->matrices.SetWorldTransform(transform);
+
+    pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose;
+}
+
+
 // Light settings
 void PBREffect::SetLightingEnabled(bool value)
 {
@@ -11,9 +11,7 @@
 #include "Effects.h"
 #include "DemandCreate.h"
 #include "SharedResourcePool.h"
-
-#include "DDSTextureLoader.h"
-#include "WICTextureLoader.h"
+#include "EffectTextureCache.h"
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -93,10 +91,20 @@ public:
     explicit Impl(_In_ ID3D11Device* device)
         : mPath{},
         mDevice(device),
+        mTextureCache(EffectTextureCache::instancePool.DemandCreate(device)),
         mSharing(true),
         mForceSRGB(false)
     {}
 
+    Impl(Impl const&) = delete;
+    Impl& operator= (Impl const&) = delete;
+
+    // The texture cache outlives the factory when other factories share it.
+    ~Impl()
+    {
+        mTextureCache->Release(this);
+    }
+
     std::shared_ptr<IEffect> CreateEffect(
         _In_ IEffectFactory* factory,
         _In_ const IEffectFactory::EffectInfo& info,
@@ -115,14 +123,13 @@ public:
     wchar_t mPath[MAX_PATH];
 
     ComPtr<ID3D11Device> mDevice;
+    std::shared_ptr<EffectTextureCache> mTextureCache;
 
 private:
     using EffectCache = std::map< std::wstring, std::shared_ptr<IEffect> >;
-    using TextureCache = std::map< std::wstring, ComPtr<ID3D11ShaderResourceView> >;
 
     EffectCache  mEffectCache;
     EffectCache  mEffectCacheSkinning;
-    TextureCache mTextureCache;
 
     bool mSharing;
     bool mForceSRGB;
@@ -201,93 +208,7 @@ void PBREffectFactory::Impl::CreateTexture(
     ID3D11DeviceContext* deviceContext,
     ID3D11ShaderResourceView** textureView)
 {
-    if (!name || !textureView)
-        throw std::invalid_argument("name and textureView parameters can't be null");
-
-#if defined(_XBOX_ONE) && defined(_TITLE)
-    UNREFERENCED_PARAMETER(deviceContext);
-#endif
-
-    auto it = mTextureCache.find(name);
-
-    if (mSharing && it != mTextureCache.end())
-    {
-        ID3D11ShaderResourceView* srv = it->second.Get();
-        srv->AddRef();
-        *textureView = srv;
-    }
-    else
-    {
-        wchar_t fullName[MAX_PATH] = {};
-        wcscpy_s(fullName, mPath);
-        wcscat_s(fullName, name);
-
-        WIN32_FILE_ATTRIBUTE_DATA fileAttr = {};
-        if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
-        {
-            // Try Current Working Directory (CWD)
-            wcscpy_s(fullName, name);
-            if (!GetFileAttributesExW(fullName, GetFileExInfoStandard, &fileAttr))
-            {
-                DebugTrace("ERROR: PBREffectFactory could not find texture file '%ls'\n", name);
-                throw std::system_error(std::error_code(static_cast<int>(GetLastError()), std::system_category()), "PBREffectFactory::CreateTexture");
-            }
-        }
-
-        wchar_t ext[_MAX_EXT] = {};
-        _wsplitpath_s(name, nullptr, 0, nullptr, 0, nullptr, 0, ext, _MAX_EXT);
-        const bool isdds = _wcsicmp(ext, L".dds") == 0;
-
-        if (isdds)
-        {
-            HRESULT hr = CreateDDSTextureFromFileEx(
-                mDevice.Get(), fullName, 0,
-                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
-                mForceSRGB ? DDS_LOADER_FORCE_SRGB : DDS_LOADER_DEFAULT, nullptr, textureView);
-            if (FAILED(hr))
-            {
-                DebugTrace("ERROR: CreateDDSTextureFromFile failed (%08X) for '%ls'\n",
-                    static_cast<unsigned int>(hr), fullName);
-                throw std::runtime_error("PBREffectFactory::CreateDDSTextureFromFile");
-            }
-        }
-    #if !defined(_XBOX_ONE) || !defined(_TITLE)
-        else if (deviceContext)
-        {
-            std::lock_guard<std::mutex> lock(mutex);
-            HRESULT hr = CreateWICTextureFromFileEx(
-                mDevice.Get(), deviceContext, fullName, 0,
-                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
-                mForceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
-            if (FAILED(hr))
-            {
-                DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n",
-                    static_cast<unsigned int>(hr), fullName);
-                throw std::runtime_error("PBREffectFactory::CreateWICTextureFromFile");
-            }
-        }
-    #endif
-        else
-        {
-            HRESULT hr = CreateWICTextureFromFileEx(
-                mDevice.Get(), fullName, 0,
-                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
-                mForceSRGB ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_DEFAULT, nullptr, textureView);
-            if (FAILED(hr))
-            {
-                DebugTrace("ERROR: CreateWICTextureFromFile failed (%08X) for '%ls'\n",
-                    static_cast<unsigned int>(hr), fullName);
-                throw std::runtime_error("PBREffectFactory::CreateWICTextureFromFile");
-            }
-        }
-
-        if (mSharing && *name && it == mTextureCache.end())
-        {
-            std::lock_guard<std::mutex> lock(mutex);
-            TextureCache::value_type v(name, *textureView);
-            mTextureCache.insert(v);
-        }
-    }
+    mTextureCache->CreateTexture(mPath, name, mForceSRGB, mSharing, deviceContext, textureView, this, "PBREffectFactory");
 }
 
 void PBREffectFactory::Impl::ReleaseCache()
@@ -295,7 +216,7 @@ void PBREffectFactory::Impl::ReleaseCache()
     std::lock_guard<std::mutex> lock(mutex);
     mEffectCache.clear();
     mEffectCacheSkinning.clear();
-    mTextureCache.clear();
+    mTextureCache->Release(this);
 }
 
 
@@ -361,6 +282,16 @@ void PBREffectFactory::SetDirectory(_In_opt_z_ const wchar_t* path) noexcept
         *pImpl->mPath = 0;
 }
 
+void PBREffectFactory::SetTextureCacheBudget(size_t bytes) noexcept
+{
+    pImpl->mTextureCache->SetBudget(bytes);
+}
+
+TextureCacheStatistics PBREffectFactory::GetTextureCacheStatistics() const noexcept
+{
+    return pImpl->mTextureCache->GetStatistics();
+}
+
 ID3D11Device* PBREffectFactory::GetDevice() const noexcept
 {
     return pImpl->mDevice.Get();
@@ -0,0 +1,316 @@
+//--------------------------------------------------------------------------------------
+// File: ParallelFor.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace DirectX
+{
+    namespace Internal
+    {
+        // Shared state for one ParallelFor call. Indices are handed out dynamically so uneven
+        // work items balance. The first exception thrown by any item stops further items from
+        // starting and is kept to be rethrown on the calling thread.
+        class ParallelForJob
+        {
+        public:
+            ParallelForJob(size_t count, std::function<void(size_t)> body) :
+                mCount(count),
+                mBody(std::move(body)),
+                mNext(0),
+                mFailed(false),
+                mActive(0),
+                mClosed(false)
+            {
+            }
+
+            ParallelForJob(ParallelForJob&&) = delete;
+            ParallelForJob& operator= (ParallelForJob&&) = delete;
+
+            ParallelForJob(ParallelForJob const&) = delete;
+            ParallelForJob& operator= (ParallelForJob const&) = delete;
+
+            // Runs items until none are left.
+            void Run() noexcept
+            {
+                for (;;)
+                {
+                    const size_t j = mNext.fetch_add(1, std::memory_order_relaxed);
+                    if (j >= mCount || mFailed.load(std::memory_order_relaxed))
+                        break;
+
+                    try
+                    {
+                        mBody(j);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(mMutex);
+                        if (!mError)
+                            mError = std::current_exception();
+                        mFailed.store(true, std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            // Entry point for a helper thread. The body belongs to the caller's stack frame, so
+            // a helper that arrives after the caller has closed the job must not touch it.
+            void Help() noexcept
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    if (mClosed)
+                        return;
+                    ++mActive;
+                }
+
+                Run();
+
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    --mActive;
+                }
+                mDone.notify_all();
+            }
+
+            // Called by the owner once its own Run returns: turns away late helpers, waits for
+            // the ones still running, and rethrows the first error.
+            void Close()
+            {
+                std::exception_ptr error;
+
+                {
+                    std::unique_lock<std::mutex> lock(mMutex);
+                    mClosed = true;
+                    mDone.wait(lock, [this] { return mActive == 0; });
+                    error = mError;
+                }
+
+                if (error)
+                    std::rethrow_exception(error);
+            }
+
+        private:
+            const size_t                    mCount;
+            std::function<void(size_t)>     mBody;
+            std::atomic<size_t>             mNext;
+            std::atomic<bool>               mFailed;
+
+            std::mutex                      mMutex;
+            std::condition_variable         mDone;
+            size_t                          mActive;
+            bool                            mClosed;
+            std::exception_ptr              mError;
+        };
+
+
+        // Process-wide helper threads for ParallelFor, one fewer than the hardware threads
+        // since the caller always takes part. Started on first use and deliberately never
+        // destroyed: the threads only wait for work between calls, and leaving them to process
+        // exit means no thread is ever joined from a static destructor or under the loader lock.
+        //
+        // Since the threads outlive any static teardown, the module containing this code must
+        // stay loaded. On desktop the pool pins its module when it starts, so FreeLibrary on a
+        // DLL that links DirectXTK leaves it mapped; elsewhere such a DLL must not be unloaded
+        // once it has called into ParallelFor.
+        class ParallelForPool
+        {
+        public:
+            static ParallelForPool& Get()
+            {
+                static ParallelForPool* s_pool = new ParallelForPool();
+                return *s_pool;
+            }
+
+            size_t GetThreadCount() const noexcept { return mThreadCount; }
+
+            void Submit(const std::shared_ptr<ParallelForJob>& job, size_t helpers)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mQueue.insert(mQueue.end(), helpers, job);
+                }
+
+                if (helpers == 1)
+                {
+                    mCondition.notify_one();
+                }
+                else
+                {
+                    mCondition.notify_all();
+                }
+            }
+
+            ParallelForPool(ParallelForPool&&) = delete;
+            ParallelForPool& operator= (ParallelForPool&&) = delete;
+
+            ParallelForPool(ParallelForPool const&) = delete;
+            ParallelForPool& operator= (ParallelForPool const&) = delete;
+
+        private:
+            ParallelForPool() noexcept :
+                mThreadCount(0)
+            {
+            #if defined(_WIN32) && defined(WINAPI_FAMILY_PARTITION)
+            #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+                HMODULE module = nullptr;
+                if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_PIN,
+                    reinterpret_cast<LPCWSTR>(&ParallelForPool::Get), &module))
+                {
+                    // Without the pin, helper threads could outlive the code they run; use none.
+                    return;
+                }
+            #endif
+            #endif
+
+                const size_t threads = std::max<size_t>(1u, std::thread::hardware_concurrency()) - 1;
+
+                for (size_t j = 0; j < threads; ++j)
+                {
+                    try
+                    {
+                        std::thread(&ParallelForPool::Worker, this).detach();
+                        ++mThreadCount;
+                    }
+                    catch (...)
+                    {
+                        // Fewer helpers just means more of the work runs on the calling thread.
+                        break;
+                    }
+                }
+            }
+
+            void Worker() noexcept
+            {
+                for (;;)
+                {
+                    std::shared_ptr<ParallelForJob> job;
+
+                    {
+                        std::unique_lock<std::mutex> lock(mMutex);
+                        mCondition.wait(lock, [this] { return !mQueue.empty(); });
+                        job = std::move(mQueue.front());
+                        mQueue.pop_front();
+                    }
+
+                    job->Help();
+                }
+            }
+
+            size_t                                          mThreadCount;
+            std::mutex                                      mMutex;
+            std::condition_variable                         mCondition;
+            std::deque<std::shared_ptr<ParallelForJob>>     mQueue;
+        };
+    }
+
+
+    // Runs body(index) for every index in [0, count) on the calling thread plus up to
+    // maxWorkers - 1 threads from a shared pool. Indices are handed out dynamically so uneven
+    // work items balance. The first exception thrown by any item stops further items from
+    // starting and is rethrown on the calling thread once all workers have finished. Calls
+    // may nest. Pass maxWorkers = 1 for work too small to be worth waking other threads for;
+    // bodies that block waiting on other items or on I/O should use ParallelForOnThreads.
+    template<typename TBody>
+    void ParallelFor(size_t count, TBody&& body, size_t maxWorkers = 0)
+    {
+        if (!count)
+            return;
+
+        size_t workers = std::min(count, maxWorkers ? maxWorkers : size_t(SIZE_MAX));
+        if (workers > 1)
+        {
+            workers = std::min(workers, Internal::ParallelForPool::Get().GetThreadCount() + 1);
+        }
+
+        if (workers <= 1)
+        {
+            for (size_t j = 0; j < count; ++j)
+            {
+                body(j);
+            }
+            return;
+        }
+
+        auto job = std::make_shared<Internal::ParallelForJob>(count, std::ref(body));
+
+        try
+        {
+            Internal::ParallelForPool::Get().Submit(job, workers - 1);
+        }
+        catch (...)
+        {
+            // Could not queue the helpers; the work runs on this thread alone.
+        }
+
+        job->Run();
+        job->Close();
+    }
+
+
+    // As ParallelFor, but starts workers - 1 threads of its own for the duration of the call
+    // rather than borrowing the shared pool, for bodies that block (I/O, producer/consumer
+    // queues) and would otherwise hold pool threads that compute work is waiting for.
+    template<typename TBody>
+    void ParallelForOnThreads(size_t count, TBody&& body, size_t workers)
+    {
+        if (!count)
+            return;
+
+        workers = std::min(count, std::max<size_t>(workers, 1u));
+        if (workers <= 1)
+        {
+            for (size_t j = 0; j < count; ++j)
+            {
+                body(j);
+            }
+            return;
+        }
+
+        auto job = std::make_shared<Internal::ParallelForJob>(count, std::ref(body));
+
+        std::vector<std::future<void>> tasks;
+        tasks.reserve(workers - 1);
+
+        try
+        {
+            for (size_t j = 1; j < workers; ++j)
+            {
+                tasks.emplace_back(std::async(std::launch::async, [job]() { job->Help(); }));
+            }
+        }
+        catch (...)
+        {
+            // Could not start a thread; the remaining work runs on the threads we have.
+        }
+
+        job->Run();
+        job->Close();
+
+        for (auto& it : tasks)
+        {
+            it.wait();
+        }
+    }
+}
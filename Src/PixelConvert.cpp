@@ -0,0 +1,930 @@
+//--------------------------------------------------------------------------------------
+// File: PixelConvert.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "PixelConvert.h"
+#include "ParallelFor.h"
+
+#include <cmath>
+#include <limits>
+#include <new>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+    constexpr float c_lanczosRadius = 3.f;
+    constexpr float c_kaiserRadius = 3.f;
+    constexpr float c_kaiserAlpha = 4.f;
+
+    constexpr size_t c_bandRows = 16;
+    constexpr size_t c_minParallelPixels = 64 * 1024;
+
+    struct aligned_deleter { void operator()(void* p) noexcept { _aligned_free(p); } };
+
+    using ScanlineBuffer = std::unique_ptr<XMVECTOR[], aligned_deleter>;
+
+    ScanlineBuffer CreateScanlineBuffer(size_t count)
+    {
+        void* temp = _aligned_malloc(sizeof(XMVECTOR) * count, 16);
+        if (!temp)
+            throw std::bad_alloc();
+
+        return ScanlineBuffer(static_cast<XMVECTOR*>(temp));
+    }
+
+    // Splits rows into bands and runs them across threads once the image is big enough to
+    // be worth it.
+    template<typename TBody>
+    void ForEachBand(size_t width, size_t height, TBody&& body)
+    {
+        const size_t bands = (height + c_bandRows - 1) / c_bandRows;
+        const size_t workers = (width * height < c_minParallelPixels) ? 1u : 0u;
+
+        ParallelFor(bands, [&](size_t band)
+            {
+                const size_t firstRow = band * c_bandRows;
+                body(firstRow, std::min(firstRow + c_bandRows, height));
+            }, workers);
+    }
+
+    bool HasAlpha(PIXEL_LAYOUT layout) noexcept
+    {
+        switch (layout)
+        {
+        case PIXEL_LAYOUT_RGBA8:
+        case PIXEL_LAYOUT_BGRA8:
+        case PIXEL_LAYOUT_RGBA16:
+        case PIXEL_LAYOUT_BGRA16:
+        case PIXEL_LAYOUT_RGBA16F:
+        case PIXEL_LAYOUT_RGBA32F:
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Integer channel shuffles
+    //--------------------------------------------------------------------------------------
+    struct ChannelOrder
+    {
+        size_t  stride;     // Channels per pixel
+        size_t  r;
+        size_t  g;
+        size_t  b;
+        bool    alpha;      // Channel 3 holds alpha rather than X
+        bool    wide;       // 16 bits per channel
+    };
+
+    bool GetChannelOrder(PIXEL_LAYOUT layout, ChannelOrder& order) noexcept
+    {
+        switch (layout)
+        {
+        case PIXEL_LAYOUT_RGBA8:    order = { 4, 0, 1, 2, true, false }; return true;
+        case PIXEL_LAYOUT_BGRA8:    order = { 4, 2, 1, 0, true, false }; return true;
+        case PIXEL_LAYOUT_RGBX8:    order = { 4, 0, 1, 2, false, false }; return true;
+        case PIXEL_LAYOUT_BGRX8:    order = { 4, 2, 1, 0, false, false }; return true;
+        case PIXEL_LAYOUT_RGB8:     order = { 3, 0, 1, 2, false, false }; return true;
+        case PIXEL_LAYOUT_BGR8:     order = { 3, 2, 1, 0, false, false }; return true;
+        case PIXEL_LAYOUT_RGBA16:   order = { 4, 0, 1, 2, true, true }; return true;
+        case PIXEL_LAYOUT_BGRA16:   order = { 4, 2, 1, 0, true, true }; return true;
+        case PIXEL_LAYOUT_RGBX16:   order = { 4, 0, 1, 2, false, true }; return true;
+        case PIXEL_LAYOUT_RGB16:    order = { 3, 0, 1, 2, false, true }; return true;
+        case PIXEL_LAYOUT_BGR16:    order = { 3, 2, 1, 0, false, true }; return true;
+        default:                    return false;
+        }
+    }
+
+    // 4 byte to 4 byte, a pixel per word: the common BGRA <-> RGBA and X to opaque cases.
+    void SwizzleScanline32(
+        _Out_writes_bytes_(count * 4) uint8_t* pDest,
+        _In_reads_bytes_(count * 4) const uint8_t* pSrc,
+        size_t count,
+        bool swapRB,
+        bool setOpaque) noexcept
+    {
+        const uint32_t opaque = setOpaque ? 0xff000000 : 0u;
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            uint32_t t;
+            memcpy(&t, pSrc + j * 4, sizeof(t));
+
+            if (swapRB)
+            {
+                t = (t & 0xff00ff00) | ((t >> 16) & 0xff) | ((t & 0xff) << 16);
+            }
+
+            t |= opaque;
+            memcpy(pDest + j * 4, &t, sizeof(t));
+        }
+    }
+
+    template<typename T>
+    void ShuffleScanline(
+        _Out_ T* pDest,
+        const ChannelOrder& destOrder,
+        _In_ const T* pSrc,
+        const ChannelOrder& srcOrder,
+        size_t count) noexcept
+    {
+        constexpr T opaque = std::numeric_limits<T>::max();
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            const T* s = pSrc + j * srcOrder.stride;
+            T* d = pDest + j * destOrder.stride;
+
+            d[destOrder.r] = s[srcOrder.r];
+            d[destOrder.g] = s[srcOrder.g];
+            d[destOrder.b] = s[srcOrder.b];
+
+            if (destOrder.stride == 4)
+            {
+                d[3] = (srcOrder.alpha && destOrder.alpha) ? s[3] : opaque;
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Float scanlines
+    //--------------------------------------------------------------------------------------
+    enum ALPHA_OP
+    {
+        ALPHA_OP_NONE,
+        ALPHA_OP_PREMULTIPLY,
+        ALPHA_OP_UNPREMULTIPLY,
+    };
+
+    void LoadScanline(
+        _Out_writes_(count) XMVECTOR* pDest,
+        _In_ const uint8_t* pSrc,
+        size_t count,
+        PIXEL_LAYOUT layout,
+        bool srgb,
+        bool premultiply) noexcept
+    {
+        switch (layout)
+        {
+        case PIXEL_LAYOUT_RGBA8:
+        case PIXEL_LAYOUT_RGBX8:
+            {
+                auto sptr = reinterpret_cast<const XMUBYTEN4*>(pSrc);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    pDest[j] = XMLoadUByteN4(sptr++);
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_BGRA8:
+        case PIXEL_LAYOUT_BGRX8:
+            {
+                auto sptr = reinterpret_cast<const XMCOLOR*>(pSrc);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    pDest[j] = XMLoadColor(sptr++);
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_RGB8:
+        case PIXEL_LAYOUT_BGR8:
+            {
+                const bool bgr = (layout == PIXEL_LAYOUT_BGR8);
+                for (size_t j = 0; j < count; ++j, pSrc += 3)
+                {
+                    const XMUBYTEN4 p(pSrc[bgr ? 2 : 0], pSrc[1], pSrc[bgr ? 0 : 2], 0xff);
+                    pDest[j] = XMLoadUByteN4(&p);
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_RGBA16:
+        case PIXEL_LAYOUT_BGRA16:
+        case PIXEL_LAYOUT_RGBX16:
+            {
+                auto sptr = reinterpret_cast<const XMUSHORTN4*>(pSrc);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    pDest[j] = XMLoadUShortN4(sptr++);
+                }
+
+                if (layout == PIXEL_LAYOUT_BGRA16)
+                {
+                    for (size_t j = 0; j < count; ++j)
+                    {
+                        pDest[j] = XMVectorSwizzle<2, 1, 0, 3>(pDest[j]);
+                    }
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_RGB16:
+        case PIXEL_LAYOUT_BGR16:
+            {
+                const bool bgr = (layout == PIXEL_LAYOUT_BGR16);
+                auto sptr = reinterpret_cast<const uint16_t*>(pSrc);
+                for (size_t j = 0; j < count; ++j, sptr += 3)
+                {
+                    const XMUSHORTN4 p(sptr[bgr ? 2 : 0], sptr[1], sptr[bgr ? 0 : 2], 0xffff);
+                    pDest[j] = XMLoadUShortN4(&p);
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_RGBA16F:
+            {
+                auto sptr = reinterpret_cast<const XMHALF4*>(pSrc);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    pDest[j] = XMLoadHalf4(sptr++);
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_RGBA32F:
+            {
+                auto sptr = reinterpret_cast<const XMFLOAT4*>(pSrc);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    pDest[j] = XMLoadFloat4(sptr++);
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_R32F:
+            {
+                auto sptr = reinterpret_cast<const float*>(pSrc);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    pDest[j] = XMVectorSelect(g_XMIdentityR3, XMLoadFloat(sptr++), g_XMSelect1000);
+                }
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        switch (layout)
+        {
+        case PIXEL_LAYOUT_RGBX8:
+        case PIXEL_LAYOUT_BGRX8:
+        case PIXEL_LAYOUT_RGBX16:
+            for (size_t j = 0; j < count; ++j)
+            {
+                pDest[j] = XMVectorSelect(g_XMOne, pDest[j], g_XMSelect1110);
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        if (srgb)
+        {
+            for (size_t j = 0; j < count; ++j)
+            {
+                pDest[j] = XMColorSRGBToRGB(pDest[j]);
+            }
+        }
+
+        if (premultiply)
+        {
+            for (size_t j = 0; j < count; ++j)
+            {
+                const XMVECTOR v = pDest[j];
+                pDest[j] = XMVectorSelect(v, XMVectorMultiply(v, XMVectorSplatW(v)), g_XMSelect1110);
+            }
+        }
+    }
+
+    void StoreScanline(
+        _Out_ uint8_t* pDest,
+        _Inout_updates_(count) XMVECTOR* pSrc,
+        size_t count,
+        PIXEL_LAYOUT layout,
+        bool srgb,
+        ALPHA_OP alphaOp) noexcept
+    {
+        if (alphaOp == ALPHA_OP_UNPREMULTIPLY)
+        {
+            for (size_t j = 0; j < count; ++j)
+            {
+                const XMVECTOR v = pSrc[j];
+                const XMVECTOR alpha = XMVectorSplatW(v);
+                XMVECTOR rgb = XMVectorDivide(v, alpha);
+                rgb = XMVectorSelect(rgb, g_XMZero, XMVectorLessOrEqual(alpha, g_XMZero));
+                pSrc[j] = XMVectorSelect(v, rgb, g_XMSelect1110);
+            }
+        }
+        else if (alphaOp == ALPHA_OP_PREMULTIPLY)
+        {
+            for (size_t j = 0; j < count; ++j)
+            {
+                const XMVECTOR v = pSrc[j];
+                pSrc[j] = XMVectorSelect(v, XMVectorMultiply(v, XMVectorSplatW(v)), g_XMSelect1110);
+            }
+        }
+
+        if (srgb)
+        {
+            for (size_t j = 0; j < count; ++j)
+            {
+                pSrc[j] = XMColorRGBToSRGB(pSrc[j]);
+            }
+        }
+
+        switch (layout)
+        {
+        case PIXEL_LAYOUT_RGBX8:
+        case PIXEL_LAYOUT_BGRX8:
+        case PIXEL_LAYOUT_RGBX16:
+            for (size_t j = 0; j < count; ++j)
+            {
+                pSrc[j] = XMVectorSelect(g_XMOne, pSrc[j], g_XMSelect1110);
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        switch (layout)
+        {
+        case PIXEL_LAYOUT_RGBA8:
+        case PIXEL_LAYOUT_RGBX8:
+            {
+                auto dptr = reinterpret_cast<XMUBYTEN4*>(pDest);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    XMStoreUByteN4(dptr++, pSrc[j]);
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_BGRA8:
+        case PIXEL_LAYOUT_BGRX8:
+            {
+                auto dptr = reinterpret_cast<XMCOLOR*>(pDest);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    XMStoreColor(dptr++, pSrc[j]);
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_RGB8:
+        case PIXEL_LAYOUT_BGR8:
+            {
+                const bool bgr = (layout == PIXEL_LAYOUT_BGR8);
+                for (size_t j = 0; j < count; ++j, pDest += 3)
+                {
+                    XMUBYTEN4 p;
+                    XMStoreUByteN4(&p, pSrc[j]);
+                    pDest[0] = bgr ? p.z : p.x;
+                    pDest[1] = p.y;
+                    pDest[2] = bgr ? p.x : p.z;
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_RGBA16:
+        case PIXEL_LAYOUT_BGRA16:
+        case PIXEL_LAYOUT_RGBX16:
+            {
+                const bool bgr = (layout == PIXEL_LAYOUT_BGRA16);
+                auto dptr = reinterpret_cast<XMUSHORTN4*>(pDest);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    XMStoreUShortN4(dptr++, bgr ? XMVectorSwizzle<2, 1, 0, 3>(pSrc[j]) : pSrc[j]);
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_RGB16:
+        case PIXEL_LAYOUT_BGR16:
+            {
+                const bool bgr = (layout == PIXEL_LAYOUT_BGR16);
+                auto dptr = reinterpret_cast<uint16_t*>(pDest);
+                for (size_t j = 0; j < count; ++j, dptr += 3)
+                {
+                    XMUSHORTN4 p;
+                    XMStoreUShortN4(&p, pSrc[j]);
+                    dptr[0] = bgr ? p.z : p.x;
+                    dptr[1] = p.y;
+                    dptr[2] = bgr ? p.x : p.z;
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_RGBA16F:
+            {
+                auto dptr = reinterpret_cast<XMHALF4*>(pDest);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    XMStoreHalf4(dptr++, pSrc[j]);
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_RGBA32F:
+            {
+                auto dptr = reinterpret_cast<XMFLOAT4*>(pDest);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    XMStoreFloat4(dptr++, pSrc[j]);
+                }
+            }
+            break;
+
+        case PIXEL_LAYOUT_R32F:
+            {
+                auto dptr = reinterpret_cast<float*>(pDest);
+                for (size_t j = 0; j < count; ++j)
+                {
+                    XMStoreFloat(dptr++, pSrc[j]);
+                }
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Resampling weights for one axis, shared by every row (or column) of an image.
+    //--------------------------------------------------------------------------------------
+    struct FilterTap
+    {
+        size_t  index;
+        float   weight;
+    };
+
+    struct FilterSpan
+    {
+        size_t  first;
+        size_t  count;
+    };
+
+    struct FilterTable
+    {
+        std::vector<FilterSpan> spans;
+        std::vector<FilterTap>  taps;
+        size_t                  maxSpread;  // Widest range of source indices any span reads
+    };
+
+    float Sinc(float x) noexcept
+    {
+        if (x == 0.f)
+            return 1.f;
+
+        const float px = XM_PI * x;
+        return std::sin(px) / px;
+    }
+
+    float BesselI0(float x) noexcept
+    {
+        const float q = x * x * 0.25f;
+
+        float sum = 1.f;
+        float term = 1.f;
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= q / float(k * k);
+            sum += term;
+            if (term < sum * 1e-7f)
+                break;
+        }
+
+        return sum;
+    }
+
+    float GetFilterRadius(RESIZE_FILTER filter) noexcept
+    {
+        switch (filter)
+        {
+        case RESIZE_FILTER_LINEAR:  return 1.f;
+        case RESIZE_FILTER_LANCZOS: return c_lanczosRadius;
+        case RESIZE_FILTER_KAISER:  return c_kaiserRadius;
+        default:                    return 0.5f;
+        }
+    }
+
+    float EvaluateFilter(RESIZE_FILTER filter, float t) noexcept
+    {
+        const float a = std::fabs(t);
+
+        switch (filter)
+        {
+        case RESIZE_FILTER_LINEAR:
+            return std::max(0.f, 1.f - a);
+
+        case RESIZE_FILTER_LANCZOS:
+            return (a < c_lanczosRadius) ? Sinc(t) * Sinc(t / c_lanczosRadius) : 0.f;
+
+        case RESIZE_FILTER_KAISER:
+            if (a < c_kaiserRadius)
+            {
+                const float x = t / c_kaiserRadius;
+                return Sinc(t) * BesselI0(c_kaiserAlpha * std::sqrt(1.f - x * x)) / BesselI0(c_kaiserAlpha);
+            }
+            return 0.f;
+
+        default:
+            return 0.f;
+        }
+    }
+
+    void BuildFilter(size_t srcSize, size_t destSize, RESIZE_FILTER filter, FilterTable& table)
+    {
+        table.spans.resize(destSize);
+        table.taps.clear();
+        table.maxSpread = 1;
+
+        const float scale = float(srcSize) / float(destSize);
+
+        for (size_t j = 0; j < destSize; ++j)
+        {
+            auto& span = table.spans[j];
+            span.first = table.taps.size();
+
+            if (filter == RESIZE_FILTER_BOX)
+            {
+                // Each source pixel weighted by how much of it the destination pixel covers,
+                // so odd sizes don't drop their last row or column
+                const float lo = float(j) * scale;
+                const float hi = float(j + 1) * scale;
+
+                for (auto s = static_cast<size_t>(lo); s < srcSize && float(s) < hi; ++s)
+                {
+                    const float w = std::min(hi, float(s + 1)) - std::max(lo, float(s));
+                    if (w > 0.f)
+                    {
+                        table.taps.push_back({ s, w });
+                    }
+                }
+            }
+            else
+            {
+                // Pixel centers sit at +0.5; the kernel is widened by the scale when
+                // minifying, and samples past the edges clamp to the border
+                const float kscale = std::max(scale, 1.f);
+                const float center = (float(j) + 0.5f) * scale;
+                const float support = GetFilterRadius(filter) * kscale;
+                const auto lo = static_cast<ptrdiff_t>(std::floor(center - support));
+                const auto hi = static_cast<ptrdiff_t>(std::ceil(center + support));
+                const auto last = static_cast<ptrdiff_t>(srcSize) - 1;
+
+                for (ptrdiff_t s = lo; s <= hi; ++s)
+                {
+                    const float w = EvaluateFilter(filter, (float(s) + 0.5f - center) / kscale);
+                    if (w == 0.f)
+                        continue;
+
+                    table.taps.push_back({ static_cast<size_t>(std::min(std::max<ptrdiff_t>(s, 0), last)), w });
+                }
+            }
+
+            span.count = table.taps.size() - span.first;
+
+            if (span.count > 0)
+            {
+                float total = 0.f;
+                size_t minIndex = table.taps[span.first].index;
+                size_t maxIndex = minIndex;
+                for (size_t k = span.first; k < table.taps.size(); ++k)
+                {
+                    total += table.taps[k].weight;
+                    minIndex = std::min(minIndex, table.taps[k].index);
+                    maxIndex = std::max(maxIndex, table.taps[k].index);
+                }
+
+                if (total != 0.f)
+                {
+                    for (size_t k = span.first; k < table.taps.size(); ++k)
+                    {
+                        table.taps[k].weight /= total;
+                    }
+                }
+
+                table.maxSpread = std::max(table.maxSpread, maxIndex - minIndex + 1);
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Each band keeps a small ring of horizontally filtered source rows, so the separable
+    // passes never need a float copy of the whole image.
+    //--------------------------------------------------------------------------------------
+    struct ResizeTarget
+    {
+        uint8_t*        pixels;
+        size_t          rowPitch;
+        size_t          width;
+        PIXEL_LAYOUT    layout;
+        bool            srgb;
+        ALPHA_OP        alphaOp;
+    };
+
+    void ResizeBand(
+        const PixelImage& src,
+        bool premultiply,
+        const ResizeTarget& dest,
+        size_t firstRow,
+        size_t lastRow,
+        const FilterTable& horz,
+        const FilterTable& vert)
+    {
+        const size_t ringSize = vert.maxSpread;
+        const bool srcSRGB = (src.flags & PIXEL_SRGB) != 0;
+
+        auto buffer = CreateScanlineBuffer(src.width + (ringSize + 1) * dest.width);
+        XMVECTOR* scanline = buffer.get();
+        XMVECTOR* ring = scanline + src.width;
+        XMVECTOR* row = ring + ringSize * dest.width;
+
+        std::vector<size_t> tags(ringSize, size_t(-1));
+
+        for (size_t y = firstRow; y < lastRow; ++y)
+        {
+            const auto& vspan = vert.spans[y];
+
+            // A span reads at most ringSize consecutive rows, so its rows never share a slot
+            for (size_t k = 0; k < vspan.count; ++k)
+            {
+                const size_t sy = vert.taps[vspan.first + k].index;
+                const size_t slot = sy % ringSize;
+                if (tags[slot] == sy)
+                    continue;
+
+                LoadScanline(scanline, src.pixels + sy * src.rowPitch, src.width, src.layout, srcSRGB, premultiply);
+
+                XMVECTOR* hrow = ring + slot * dest.width;
+                for (size_t x = 0; x < dest.width; ++x)
+                {
+                    const auto& hspan = horz.spans[x];
+
+                    XMVECTOR acc = XMVectorZero();
+                    for (size_t t = 0; t < hspan.count; ++t)
+                    {
+                        const auto& tap = horz.taps[hspan.first + t];
+                        acc = XMVectorMultiplyAdd(scanline[tap.index], XMVectorReplicate(tap.weight), acc);
+                    }
+
+                    hrow[x] = acc;
+                }
+
+                tags[slot] = sy;
+            }
+
+            for (size_t x = 0; x < dest.width; ++x)
+            {
+                row[x] = XMVectorZero();
+            }
+
+            for (size_t k = 0; k < vspan.count; ++k)
+            {
+                const auto& tap = vert.taps[vspan.first + k];
+                const XMVECTOR w = XMVectorReplicate(tap.weight);
+                const XMVECTOR* hrow = ring + (tap.index % ringSize) * dest.width;
+
+                for (size_t x = 0; x < dest.width; ++x)
+                {
+                    row[x] = XMVectorMultiplyAdd(hrow[x], w, row[x]);
+                }
+            }
+
+            StoreScanline(dest.pixels + y * dest.rowPitch, row, dest.width, dest.layout, dest.srgb, dest.alphaOp);
+        }
+    }
+
+    bool IsValidImage(const PixelImage& src) noexcept
+    {
+        if (!src.pixels || !src.width || !src.height)
+            return false;
+
+        const size_t bpp = GetPixelLayoutSize(src.layout);
+        return bpp > 0 && src.rowPitch >= src.width * bpp;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+size_t DirectX::GetPixelLayoutSize(PIXEL_LAYOUT layout) noexcept
+{
+    switch (layout)
+    {
+    case PIXEL_LAYOUT_RGBA8:
+    case PIXEL_LAYOUT_BGRA8:
+    case PIXEL_LAYOUT_RGBX8:
+    case PIXEL_LAYOUT_BGRX8:
+    case PIXEL_LAYOUT_R32F:
+        return 4;
+
+    case PIXEL_LAYOUT_RGB8:
+    case PIXEL_LAYOUT_BGR8:
+        return 3;
+
+    case PIXEL_LAYOUT_RGBA16:
+    case PIXEL_LAYOUT_BGRA16:
+    case PIXEL_LAYOUT_RGBX16:
+    case PIXEL_LAYOUT_RGBA16F:
+        return 8;
+
+    case PIXEL_LAYOUT_RGB16:
+    case PIXEL_LAYOUT_BGR16:
+        return 6;
+
+    case PIXEL_LAYOUT_RGBA32F:
+        return 16;
+
+    default:
+        return 0;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+bool DirectX::IsPixelLayoutFloat(PIXEL_LAYOUT layout) noexcept
+{
+    switch (layout)
+    {
+    case PIXEL_LAYOUT_RGBA16F:
+    case PIXEL_LAYOUT_RGBA32F:
+    case PIXEL_LAYOUT_R32F:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::ConvertPixels(
+    const PixelImage& src,
+    uint8_t* dest,
+    size_t destPitch,
+    PIXEL_LAYOUT destLayout,
+    uint32_t destFlags) noexcept
+{
+    if (!dest)
+        return E_POINTER;
+
+    const size_t destBpp = GetPixelLayoutSize(destLayout);
+    if (!IsValidImage(src) || !destBpp || destPitch < src.width * destBpp)
+        return E_INVALIDARG;
+
+    const bool srcSRGB = (src.flags & PIXEL_SRGB) != 0;
+    const bool destSRGB = (destFlags & PIXEL_SRGB) != 0;
+
+    // Straight alpha is kept straight; alpha is only applied when the premultiplied state changes
+    // or premultiplied color has to lose its alpha.
+    ALPHA_OP alphaOp = ALPHA_OP_NONE;
+    if (HasAlpha(src.layout))
+    {
+        const bool srcPremultiplied = (src.flags & PIXEL_PREMULTIPLIED) != 0;
+        const bool destPremultiplied = HasAlpha(destLayout) && (destFlags & PIXEL_PREMULTIPLIED) != 0;
+
+        if (srcPremultiplied && !destPremultiplied)
+        {
+            alphaOp = ALPHA_OP_UNPREMULTIPLY;
+        }
+        else if (!srcPremultiplied && destPremultiplied)
+        {
+            alphaOp = ALPHA_OP_PREMULTIPLY;
+        }
+    }
+
+    ChannelOrder srcOrder = {};
+    ChannelOrder destOrder = {};
+    const bool shuffle = (alphaOp == ALPHA_OP_NONE)
+        && (srcSRGB == destSRGB)
+        && GetChannelOrder(src.layout, srcOrder)
+        && GetChannelOrder(destLayout, destOrder)
+        && (srcOrder.wide == destOrder.wide);
+
+    try
+    {
+        ForEachBand(src.width, src.height, [&](size_t firstRow, size_t lastRow)
+            {
+                if (shuffle)
+                {
+                    for (size_t y = firstRow; y < lastRow; ++y)
+                    {
+                        const uint8_t* sptr = src.pixels + y * src.rowPitch;
+                        uint8_t* dptr = dest + y * destPitch;
+
+                        if (src.layout == destLayout)
+                        {
+                            memcpy(dptr, sptr, src.width * destBpp);
+                        }
+                        else if (!srcOrder.wide && srcOrder.stride == 4 && destOrder.stride == 4)
+                        {
+                            SwizzleScanline32(dptr, sptr, src.width,
+                                srcOrder.r != destOrder.r,
+                                !srcOrder.alpha || !destOrder.alpha);
+                        }
+                        else if (srcOrder.wide)
+                        {
+                            ShuffleScanline(reinterpret_cast<uint16_t*>(dptr), destOrder,
+                                reinterpret_cast<const uint16_t*>(sptr), srcOrder, src.width);
+                        }
+                        else
+                        {
+                            ShuffleScanline(dptr, destOrder, sptr, srcOrder, src.width);
+                        }
+                    }
+                    return;
+                }
+
+                auto scanline = CreateScanlineBuffer(src.width);
+
+                for (size_t y = firstRow; y < lastRow; ++y)
+                {
+                    LoadScanline(scanline.get(), src.pixels + y * src.rowPitch, src.width, src.layout, srcSRGB, false);
+                    StoreScanline(dest + y * destPitch, scanline.get(), src.width, destLayout, destSRGB, alphaOp);
+                }
+            });
+    }
+    catch (const std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+    catch (...)
+    {
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::ResizePixels(
+    const PixelImage& src,
+    uint8_t* dest,
+    size_t destPitch,
+    size_t destWidth,
+    size_t destHeight,
+    PIXEL_LAYOUT destLayout,
+    uint32_t destFlags,
+    RESIZE_FILTER filter) noexcept
+{
+    if (!dest)
+        return E_POINTER;
+
+    const size_t destBpp = GetPixelLayoutSize(destLayout);
+    if (!IsValidImage(src) || !destBpp || !destWidth || !destHeight || destPitch < destWidth * destBpp)
+        return E_INVALIDARG;
+
+    // Filter with premultiplied color, then put alpha back to how the destination wants it
+    const bool srcAlpha = HasAlpha(src.layout);
+    const bool premultiply = srcAlpha && !(src.flags & PIXEL_PREMULTIPLIED);
+
+    ResizeTarget target = {};
+    target.pixels = dest;
+    target.rowPitch = destPitch;
+    target.width = destWidth;
+    target.layout = destLayout;
+    target.srgb = (destFlags & PIXEL_SRGB) != 0;
+    target.alphaOp = (srcAlpha && !(HasAlpha(destLayout) && (destFlags & PIXEL_PREMULTIPLIED)))
+        ? ALPHA_OP_UNPREMULTIPLY : ALPHA_OP_NONE;
+
+    try
+    {
+        FilterTable horz;
+        FilterTable vert;
+        BuildFilter(src.width, destWidth, filter, horz);
+        BuildFilter(src.height, destHeight, filter, vert);
+
+        ForEachBand(destWidth, destHeight, [&](size_t firstRow, size_t lastRow)
+            {
+                ResizeBand(src, premultiply, target, firstRow, lastRow, horz, vert);
+            });
+    }
+    catch (const std::bad_alloc&)
+    {
+        return E_OUTOFMEMORY;
+    }
+    catch (...)
+    {
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
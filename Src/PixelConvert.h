@@ -0,0 +1,90 @@
+//--------------------------------------------------------------------------------------
+// File: PixelConvert.h
+//
+// Helpers for converting and resampling images on the CPU, used by the loaders and
+// ScreenGrab in place of the WIC format converter and scaler for the common layouts
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace DirectX
+{
+    // Channel order in memory. X channels are ignored on read and written as opaque.
+    enum PIXEL_LAYOUT : uint32_t
+    {
+        PIXEL_LAYOUT_UNKNOWN = 0,
+        PIXEL_LAYOUT_RGBA8,
+        PIXEL_LAYOUT_BGRA8,
+        PIXEL_LAYOUT_RGBX8,
+        PIXEL_LAYOUT_BGRX8,
+        PIXEL_LAYOUT_RGB8,
+        PIXEL_LAYOUT_BGR8,
+        PIXEL_LAYOUT_RGBA16,
+        PIXEL_LAYOUT_BGRA16,
+        PIXEL_LAYOUT_RGBX16,
+        PIXEL_LAYOUT_RGB16,
+        PIXEL_LAYOUT_BGR16,
+        PIXEL_LAYOUT_RGBA16F,
+        PIXEL_LAYOUT_RGBA32F,
+        PIXEL_LAYOUT_R32F,
+    };
+
+    enum PIXEL_FLAGS : uint32_t
+    {
+        PIXEL_DEFAULT = 0,
+        PIXEL_PREMULTIPLIED = 0x1,  // Color already multiplied by alpha, or alpha unrelated to color
+        PIXEL_SRGB = 0x2,           // Color channels are sRGB encoded
+    };
+
+    enum RESIZE_FILTER : uint32_t
+    {
+        RESIZE_FILTER_BOX = 0,
+        RESIZE_FILTER_LINEAR,       // Tent, widened when minifying so it stays antialiased
+        RESIZE_FILTER_LANCZOS,      // Lanczos 3; sharpest, can ring on hard edges
+        RESIZE_FILTER_KAISER,
+    };
+
+    struct PixelImage
+    {
+        const uint8_t*  pixels;
+        size_t          rowPitch;
+        size_t          width;
+        size_t          height;
+        PIXEL_LAYOUT    layout;
+        uint32_t        flags;
+    };
+
+    size_t GetPixelLayoutSize(PIXEL_LAYOUT layout) noexcept;
+    bool IsPixelLayoutFloat(PIXEL_LAYOUT layout) noexcept;
+
+    // Converts between layouts, alpha modes, and encodings. Swizzles, channel expansion,
+    // and 24/48 bpp packing between integer layouts of the same depth stay in integer;
+    // everything else goes through a float scanline.
+    HRESULT ConvertPixels(
+        const PixelImage& src,
+        _Out_ uint8_t* dest,
+        size_t destPitch,
+        PIXEL_LAYOUT destLayout,
+        uint32_t destFlags) noexcept;
+
+    // Resamples to a new size, converting as above on the way. Filtering happens in linear
+    // space with color premultiplied by alpha, as a separable pass over bands of rows.
+    HRESULT ResizePixels(
+        const PixelImage& src,
+        _Out_ uint8_t* dest,
+        size_t destPitch,
+        size_t destWidth,
+        size_t destHeight,
+        PIXEL_LAYOUT destLayout,
+        uint32_t destFlags,
+        RESIZE_FILTER filter) noexcept;
+}
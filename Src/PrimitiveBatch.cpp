@@ -12,6 +12,7 @@
 #include "DirectXHelpers.h"
 #include "GraphicsMemory.h"
 #include "PlatformHelpers.h"
+#include "StateFilter.h"
 
 using namespace DirectX;
 using namespace DirectX::DX11::Private;
@@ -184,13 +185,15 @@ void PrimitiveBatchBase::Impl::Begin()
     if (mInBeginEndPair)
         throw std::logic_error("Cannot nest Begin calls");
 
+    StateFilter filter(mDeviceContext.Get());
+
 #if defined(_XBOX_ONE) && defined(_TITLE)
-    mDeviceContext->IASetIndexBuffer(nullptr, DXGI_FORMAT_UNKNOWN, 0);
+    filter.IASetIndexBuffer(nullptr, DXGI_FORMAT_UNKNOWN, 0);
 #else
     // Bind the index buffer.
     if (mMaxIndices > 0)
     {
-        mDeviceContext->IASetIndexBuffer(mIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+        filter.IASetIndexBuffer(mIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
     }
 
     // Bind the vertex buffer.
@@ -198,7 +201,7 @@ void PrimitiveBatchBase::Impl::Begin()
     const UINT vertexStride = static_cast<UINT>(mVertexSize);
     constexpr UINT vertexOffset = 0;
 
-    mDeviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
+    filter.IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
 #endif
 
     // If this is a deferred D3D context, reset position so the first Map calls will use D3D11_MAP_WRITE_DISCARD.
@@ -376,7 +379,9 @@ void PrimitiveBatchBase::Impl::FlushBatch()
     if (mCurrentTopology == D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED)
         return;
 
-    mDeviceContext->IASetPrimitiveTopology(mCurrentTopology);
+    StateFilter filter(mDeviceContext.Get());
+
+    filter.IASetPrimitiveTopology(mCurrentTopology);
 
 #if defined(_XBOX_ONE) && defined(_TITLE)
     if (mCurrentlyIndexed)
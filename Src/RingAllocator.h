@@ -0,0 +1,79 @@
+//--------------------------------------------------------------------------------------
+// File: RingAllocator.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace DirectX
+{
+    // CPU-side bookkeeping for the constant ring. Each frame's segment is opened with a
+    // WRITE_DISCARD map, so the driver renames the buffer and nothing the GPU may still be
+    // reading is ever overwritten; within a segment blocks are handed out in order until the
+    // buffer is full, and Reset starts the next segment from the beginning.
+    class RingAllocator
+    {
+    public:
+        static constexpr size_t InvalidOffset = size_t(-1);
+
+        explicit RingAllocator(size_t size = 0) noexcept :
+            mSize(size),
+            mHead(0)
+        {
+        }
+
+        RingAllocator(RingAllocator&&) = default;
+        RingAllocator& operator= (RingAllocator&&) = default;
+
+        RingAllocator(RingAllocator const&) = delete;
+        RingAllocator& operator= (RingAllocator const&) = delete;
+
+        // Returns the offset of the block, or InvalidOffset if the rest of the buffer can't hold it.
+        // Alignment must be a power of two.
+        size_t Allocate(size_t bytes, size_t alignment) noexcept
+        {
+            assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+            if (!bytes)
+                return InvalidOffset;
+
+            const size_t offset = AlignUp(mHead, alignment);
+            if (offset > mSize || bytes > (mSize - offset))
+                return InvalidOffset;
+
+            mHead = offset + bytes;
+
+            return offset;
+        }
+
+        // Releases everything, for when the whole buffer has been discarded or resized.
+        void Reset(size_t size) noexcept
+        {
+            mSize = size;
+            mHead = 0;
+        }
+
+        void Reset() noexcept { Reset(mSize); }
+
+        size_t GetSize() const noexcept { return mSize; }
+        size_t GetUsed() const noexcept { return mHead; }
+
+        static size_t AlignUp(size_t value, size_t alignment) noexcept
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+    private:
+        size_t      mSize;
+        size_t      mHead;      // Includes any alignment padding
+    };
+}
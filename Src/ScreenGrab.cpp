@@ -627,7 +627,47 @@ HRESULT DirectX::SaveWICTextureToFile(
         return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
     }
 
-    if (memcmp(&targetGuid, &pfGuid, sizeof(WICPixelFormatGUID)) != 0)
+    uint32_t srcFlags = 0;
+    uint32_t destFlags = 0;
+    const PIXEL_LAYOUT srcLayout = WICToPixelLayout(pfGuid, srcFlags);
+    const PIXEL_LAYOUT destLayout = WICToPixelLayout(targetGuid, destFlags);
+    ApplyWICGamma(srcLayout, srcFlags, destLayout, destFlags);
+
+    if (memcmp(&targetGuid, &pfGuid, sizeof(WICPixelFormatGUID)) == 0)
+    {
+        // No conversion required
+        hr = frame->WritePixels(desc.Height,
+            mapped.RowPitch, static_cast<UINT>(imageSize),
+            static_cast<BYTE*>(mapped.pData));
+    }
+    else if (srcLayout != PIXEL_LAYOUT_UNKNOWN && destLayout != PIXEL_LAYOUT_UNKNOWN)
+    {
+        // Conversion the CPU converters can do (such as dropping alpha for a 24bpp screenshot)
+        const uint64_t destRowPitch = uint64_t(desc.Width) * GetPixelLayoutSize(destLayout);
+        const uint64_t destImageSize = destRowPitch * uint64_t(desc.Height);
+        if (destImageSize > UINT32_MAX)
+        {
+            pContext->Unmap(pStaging.Get(), 0);
+            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+        }
+
+        std::unique_ptr<uint8_t[]> pixels(new (std::nothrow) uint8_t[static_cast<size_t>(destImageSize)]);
+        if (!pixels)
+        {
+            pContext->Unmap(pStaging.Get(), 0);
+            return E_OUTOFMEMORY;
+        }
+
+        const PixelImage src = { static_cast<const uint8_t*>(mapped.pData), mapped.RowPitch, desc.Width, desc.Height, srcLayout, srcFlags };
+        hr = ConvertPixels(src, pixels.get(), static_cast<size_t>(destRowPitch), destLayout, destFlags);
+        if (SUCCEEDED(hr))
+        {
+            hr = frame->WritePixels(desc.Height,
+                static_cast<UINT>(destRowPitch), static_cast<UINT>(destImageSize),
+                pixels.get());
+        }
+    }
+    else
     {
         // Conversion required to write
         ComPtr<IWICBitmap> source;
@@ -667,13 +707,6 @@ HRESULT DirectX::SaveWICTextureToFile(
         WICRect rect = { 0, 0, static_cast<INT>(desc.Width), static_cast<INT>(desc.Height) };
         hr = frame->WriteSource(FC.Get(), &rect);
     }
-    else
-    {
-        // No conversion required
-        hr = frame->WritePixels(desc.Height,
-            mapped.RowPitch, static_cast<UINT>(imageSize),
-            static_cast<BYTE*>(mapped.pData));
-    }
 
     pContext->Unmap(pStaging.Get(), 0);
 
@@ -171,6 +171,27 @@ call :CompileShader%1 SkinnedEffect ps PSSkinnedVertexLighting
 call :CompileShader%1 SkinnedEffect ps PSSkinnedVertexLightingNoFog
 call :CompileShader%1 SkinnedEffect ps PSSkinnedPixelLighting
 
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedVertexLightingOneBone
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedVertexLightingOneBoneBn
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedVertexLightingTwoBones
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedVertexLightingTwoBonesBn
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedVertexLightingFourBones
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedVertexLightingFourBonesBn
+
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedOneLightOneBone
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedOneLightOneBoneBn
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedOneLightTwoBones
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedOneLightTwoBonesBn
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedOneLightFourBones
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedOneLightFourBonesBn
+
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedPixelLightingOneBone
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedPixelLightingOneBoneBn
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedPixelLightingTwoBones
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedPixelLightingTwoBonesBn
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedPixelLightingFourBones
+call :CompileShader%1 SkinnedEffectDualQuaternion vs VSSkinnedPixelLightingFourBonesBn
+
 call :CompileShaderSM4%1 NormalMapEffect vs VSNormalPixelLightingTx
 call :CompileShaderSM4%1 NormalMapEffect vs VSNormalPixelLightingTxBn
 call :CompileShaderSM4%1 NormalMapEffect vs VSNormalPixelLightingTxVc
@@ -28,7 +28,11 @@ cbuffer Parameters : register(b0)
     float3x3 WorldInverseTranspose  : packoffset(c19);
     float4x4 WorldViewProj          : packoffset(c22);
 
+#ifdef SKINNED_DUAL_QUATERNION
+    float4 BoneQuaternions[216]     : packoffset(c26);
+#else
     float4x3 Bones[72]              : packoffset(c26);
+#endif
 };
 
 
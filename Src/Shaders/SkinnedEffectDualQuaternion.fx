@@ -0,0 +1,10 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+
+
+// SkinnedEffect vertex shaders reading the bone palette as quaternions rather than matrices.
+#define SKINNED_DUAL_QUATERNION
+
+#include "SkinnedEffect.fx"
@@ -10,8 +10,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <type_traits>
+#include <vector>
 
 #include "PlatformHelpers.h"
 
@@ -25,6 +29,8 @@ namespace DirectX
     template<typename TKey, typename TData, typename... TConstructorArgs>
     class SharedResourcePool
     {
+        static_assert(std::is_pointer<TKey>::value, "SharedResourcePool keys must be pointers");
+
     public:
         SharedResourcePool() noexcept(false)
             : mResourceMap(std::make_shared<ResourceMap>())
@@ -37,6 +43,11 @@ namespace DirectX
         // Allocates or looks up the shared TData instance for the specified key.
         std::shared_ptr<TData> DemandCreate(TKey key, TConstructorArgs... args)
         {
+            // Most calls find a live instance without taking the lock.
+            auto cachedValue = mResourceMap->Find(key);
+            if (cachedValue)
+                return cachedValue;
+
             std::lock_guard<std::mutex> lock(mResourceMap->mutex);
 
             // Return an existing instance?
@@ -47,7 +58,10 @@ namespace DirectX
                 auto existingValue = pos->second.lock();
 
                 if (existingValue)
+                {
+                    mResourceMap->Publish(key, existingValue);
                     return existingValue;
+                }
                 else
                     mResourceMap->erase(pos);
             }
@@ -58,15 +72,126 @@ namespace DirectX
             auto entry = std::make_pair(key, newValue);
             mResourceMap->insert(entry);
 
+            mResourceMap->Publish(key, newValue);
+
             return std::move(newValue);
         }
 
 
     private:
-        // Keep track of all allocated TData instances.
+        // Keep track of all allocated TData instances. The map is authoritative and guarded by the
+        // mutex; the small open-addressed table in front of it is read without locking.
         struct ResourceMap : public std::map<TKey, std::weak_ptr<TData>>
         {
+            static constexpr size_t TableSize = 16;
+
+            struct Slot
+            {
+                std::atomic<TKey>                       key;
+                std::atomic<std::weak_ptr<TData>*>      value;
+            };
+
             std::mutex mutex;
+
+            ResourceMap() noexcept : readers(0)
+            {
+                for (auto& it : table)
+                {
+                    it.key.store(nullptr, std::memory_order_relaxed);
+                    it.value.store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            ResourceMap(ResourceMap const&) = delete;
+            ResourceMap& operator= (ResourceMap const&) = delete;
+
+            ~ResourceMap()
+            {
+                for (auto& it : table)
+                {
+                    delete it.value.load(std::memory_order_relaxed);
+                }
+            }
+
+            // Looks up a live instance without locking. Slots are never reused for another key,
+            // and a published weak_ptr is never modified, only replaced; the one it replaces is
+            // freed once no lookup can still be reading it.
+            std::shared_ptr<TData> Find(TKey key) noexcept
+            {
+                readers.fetch_add(1);
+
+                std::shared_ptr<TData> result;
+
+                size_t index = Hash(key);
+                for (size_t j = 0; j < TableSize; ++j, ++index)
+                {
+                    auto& slot = table[index & (TableSize - 1)];
+
+                    const TKey slotKey = slot.key.load(std::memory_order_acquire);
+                    if (slotKey == key)
+                    {
+                        auto value = slot.value.load();
+                        if (value)
+                        {
+                            result = value->lock();
+                        }
+                        break;
+                    }
+
+                    if (!slotKey)
+                        break;
+                }
+
+                readers.fetch_sub(1);
+
+                return result;
+            }
+
+            // Makes an instance visible to Find. Must be called with the mutex held.
+            void Publish(TKey key, std::shared_ptr<TData> const& data)
+            {
+                size_t index = Hash(key);
+                for (size_t j = 0; j < TableSize; ++j, ++index)
+                {
+                    auto& slot = table[index & (TableSize - 1)];
+
+                    const TKey slotKey = slot.key.load(std::memory_order_relaxed);
+                    if (slotKey == key || !slotKey)
+                    {
+                        std::unique_ptr<std::weak_ptr<TData>> newValue(new std::weak_ptr<TData>(data));
+                        retired.reserve(retired.size() + 1);
+
+                        std::unique_ptr<std::weak_ptr<TData>> oldValue(slot.value.exchange(newValue.release()));
+
+                        if (!slotKey)
+                        {
+                            slot.key.store(key, std::memory_order_release);
+                        }
+
+                        if (oldValue)
+                        {
+                            retired.emplace_back(std::move(oldValue));
+                        }
+                        break;
+                    }
+                }
+
+                // A full table just means further keys always take the locked path.
+                if (!retired.empty() && !readers.load())
+                {
+                    retired.clear();
+                }
+            }
+
+            static size_t Hash(TKey key) noexcept
+            {
+                const auto value = reinterpret_cast<uintptr_t>(key);
+                return static_cast<size_t>((value >> 4) ^ (value >> 12));
+            }
+
+            Slot table[TableSize];
+            std::atomic<uint32_t> readers;
+            std::vector<std::unique_ptr<std::weak_ptr<TData>>> retired;
         };
 
         std::shared_ptr<ResourceMap> mResourceMap;
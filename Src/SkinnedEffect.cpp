@@ -39,14 +39,17 @@ namespace
 
     static_assert((sizeof(SkinnedEffectConstants) % 16) == 0, "CB size not padded correctly");
 
+    // Dual quaternion bones reuse the matrix palette storage, two vectors per bone.
+    static_assert(SkinnedEffect::MaxDualQuaternionBones * 2 <= SkinnedEffect::MaxBones * 3, "bone palette too small");
+
     // Traits type describes our characteristics to the EffectBase template.
     struct SkinnedEffectTraits
     {
         using ConstantBufferType = SkinnedEffectConstants;
 
-        static constexpr int VertexShaderCount = 18;
+        static constexpr int VertexShaderCount = 36;
         static constexpr int PixelShaderCount = 3;
-        static constexpr int ShaderPermutationCount = 36;
+        static constexpr int ShaderPermutationCount = 72;
     };
 }
 
@@ -59,12 +62,15 @@ public:
     bool preferPerPixelLighting;
     bool biasedVertexNormals;
     int weightsPerVertex;
+    BoneFormat boneFormat;
 
     EffectLights lights;
 
     int GetCurrentShaderPermutation() const noexcept;
 
     void Apply(_In_ ID3D11DeviceContext* deviceContext);
+
+    void SetBoneCount(size_t count) noexcept;
 };
 
 
@@ -100,6 +106,30 @@ namespace
 #include "XboxOneSkinnedEffect_PSSkinnedVertexLighting.inc"
 #include "XboxOneSkinnedEffect_PSSkinnedVertexLightingNoFog.inc"
 #include "XboxOneSkinnedEffect_PSSkinnedPixelLighting.inc"
+
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedVertexLightingOneBone.inc"
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedVertexLightingTwoBones.inc"
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedVertexLightingFourBones.inc"
+
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedOneLightOneBone.inc"
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedOneLightTwoBones.inc"
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedOneLightFourBones.inc"
+
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedPixelLightingOneBone.inc"
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedPixelLightingTwoBones.inc"
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedPixelLightingFourBones.inc"
+
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedVertexLightingOneBoneBn.inc"
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedVertexLightingTwoBonesBn.inc"
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedVertexLightingFourBonesBn.inc"
+
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedOneLightOneBoneBn.inc"
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedOneLightTwoBonesBn.inc"
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedOneLightFourBonesBn.inc"
+
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedPixelLightingOneBoneBn.inc"
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedPixelLightingTwoBonesBn.inc"
+#include "XboxOneSkinnedEffectDualQuaternion_VSSkinnedPixelLightingFourBonesBn.inc"
 #else
 #include "SkinnedEffect_VSSkinnedVertexLightingOneBone.inc"
 #include "SkinnedEffect_VSSkinnedVertexLightingTwoBones.inc"
@@ -128,6 +158,30 @@ namespace
 #include "SkinnedEffect_PSSkinnedVertexLighting.inc"
 #include "SkinnedEffect_PSSkinnedVertexLightingNoFog.inc"
 #include "SkinnedEffect_PSSkinnedPixelLighting.inc"
+
+#include "SkinnedEffectDualQuaternion_VSSkinnedVertexLightingOneBone.inc"
+#include "SkinnedEffectDualQuaternion_VSSkinnedVertexLightingTwoBones.inc"
+#include "SkinnedEffectDualQuaternion_VSSkinnedVertexLightingFourBones.inc"
+
+#include "SkinnedEffectDualQuaternion_VSSkinnedOneLightOneBone.inc"
+#include "SkinnedEffectDualQuaternion_VSSkinnedOneLightTwoBones.inc"
+#include "SkinnedEffectDualQuaternion_VSSkinnedOneLightFourBones.inc"
+
+#include "SkinnedEffectDualQuaternion_VSSkinnedPixelLightingOneBone.inc"
+#include "SkinnedEffectDualQuaternion_VSSkinnedPixelLightingTwoBones.inc"
+#include "SkinnedEffectDualQuaternion_VSSkinnedPixelLightingFourBones.inc"
+
+#include "SkinnedEffectDualQuaternion_VSSkinnedVertexLightingOneBoneBn.inc"
+#include "SkinnedEffectDualQuaternion_VSSkinnedVertexLightingTwoBonesBn.inc"
+#include "SkinnedEffectDualQuaternion_VSSkinnedVertexLightingFourBonesBn.inc"
+
+#include "SkinnedEffectDualQuaternion_VSSkinnedOneLightOneBoneBn.inc"
+#include "SkinnedEffectDualQuaternion_VSSkinnedOneLightTwoBonesBn.inc"
+#include "SkinnedEffectDualQuaternion_VSSkinnedOneLightFourBonesBn.inc"
+
+#include "SkinnedEffectDualQuaternion_VSSkinnedPixelLightingOneBoneBn.inc"
+#include "SkinnedEffectDualQuaternion_VSSkinnedPixelLightingTwoBonesBn.inc"
+#include "SkinnedEffectDualQuaternion_VSSkinnedPixelLightingFourBonesBn.inc"
 #endif
 }
 
@@ -159,6 +213,29 @@ const ShaderBytecode EffectBase<SkinnedEffectTraits>::VertexShaderBytecode[] =
     { SkinnedEffect_VSSkinnedPixelLightingTwoBonesBn,   sizeof(SkinnedEffect_VSSkinnedPixelLightingTwoBonesBn)   },
     { SkinnedEffect_VSSkinnedPixelLightingFourBonesBn,  sizeof(SkinnedEffect_VSSkinnedPixelLightingFourBonesBn)  },
 
+    { SkinnedEffectDualQuaternion_VSSkinnedVertexLightingOneBone,     sizeof(SkinnedEffectDualQuaternion_VSSkinnedVertexLightingOneBone)     },
+    { SkinnedEffectDualQuaternion_VSSkinnedVertexLightingTwoBones,    sizeof(SkinnedEffectDualQuaternion_VSSkinnedVertexLightingTwoBones)    },
+    { SkinnedEffectDualQuaternion_VSSkinnedVertexLightingFourBones,   sizeof(SkinnedEffectDualQuaternion_VSSkinnedVertexLightingFourBones)   },
+
+    { SkinnedEffectDualQuaternion_VSSkinnedOneLightOneBone,           sizeof(SkinnedEffectDualQuaternion_VSSkinnedOneLightOneBone)           },
+    { SkinnedEffectDualQuaternion_VSSkinnedOneLightTwoBones,          sizeof(SkinnedEffectDualQuaternion_VSSkinnedOneLightTwoBones)          },
+    { SkinnedEffectDualQuaternion_VSSkinnedOneLightFourBones,         sizeof(SkinnedEffectDualQuaternion_VSSkinnedOneLightFourBones)         },
+
+    { SkinnedEffectDualQuaternion_VSSkinnedPixelLightingOneBone,      sizeof(SkinnedEffectDualQuaternion_VSSkinnedPixelLightingOneBone)      },
+    { SkinnedEffectDualQuaternion_VSSkinnedPixelLightingTwoBones,     sizeof(SkinnedEffectDualQuaternion_VSSkinnedPixelLightingTwoBones)     },
+    { SkinnedEffectDualQuaternion_VSSkinnedPixelLightingFourBones,    sizeof(SkinnedEffectDualQuaternion_VSSkinnedPixelLightingFourBones)    },
+
+    { SkinnedEffectDualQuaternion_VSSkinnedVertexLightingOneBoneBn,   sizeof(SkinnedEffectDualQuaternion_VSSkinnedVertexLightingOneBoneBn)   },
+    { SkinnedEffectDualQuaternion_VSSkinnedVertexLightingTwoBonesBn,  sizeof(SkinnedEffectDualQuaternion_VSSkinnedVertexLightingTwoBonesBn)  },
+    { SkinnedEffectDualQuaternion_VSSkinnedVertexLightingFourBonesBn, sizeof(SkinnedEffectDualQuaternion_VSSkinnedVertexLightingFourBonesBn) },
+
+    { SkinnedEffectDualQuaternion_VSSkinnedOneLightOneBoneBn,         sizeof(SkinnedEffectDualQuaternion_VSSkinnedOneLightOneBoneBn)         },
+    { SkinnedEffectDualQuaternion_VSSkinnedOneLightTwoBonesBn,        sizeof(SkinnedEffectDualQuaternion_VSSkinnedOneLightTwoBonesBn)        },
+    { SkinnedEffectDualQuaternion_VSSkinnedOneLightFourBonesBn,       sizeof(SkinnedEffectDualQuaternion_VSSkinnedOneLightFourBonesBn)       },
+
+    { SkinnedEffectDualQuaternion_VSSkinnedPixelLightingOneBoneBn,    sizeof(SkinnedEffectDualQuaternion_VSSkinnedPixelLightingOneBoneBn)    },
+    { SkinnedEffectDualQuaternion_VSSkinnedPixelLightingTwoBonesBn,   sizeof(SkinnedEffectDualQuaternion_VSSkinnedPixelLightingTwoBonesBn)   },
+    { SkinnedEffectDualQuaternion_VSSkinnedPixelLightingFourBonesBn,  sizeof(SkinnedEffectDualQuaternion_VSSkinnedPixelLightingFourBonesBn)  },
 };
 
 
@@ -206,6 +283,48 @@ const int EffectBase<SkinnedEffectTraits>::VertexShaderIndices[] =
     16,     // pixel lighting (biased vertex normals), two bones, no fog
     17,     // pixel lighting (biased vertex normals), four bones
     17,     // pixel lighting (biased vertex normals), four bones, no fog
+
+    18,     // vertex lighting, one bone, dual quaternion
+    18,     // vertex lighting, one bone, no fog, dual quaternion
+    19,     // vertex lighting, two bones, dual quaternion
+    19,     // vertex lighting, two bones, no fog, dual quaternion
+    20,     // vertex lighting, four bones, dual quaternion
+    20,     // vertex lighting, four bones, no fog, dual quaternion
+
+    21,     // one light, one bone, dual quaternion
+    21,     // one light, one bone, no fog, dual quaternion
+    22,     // one light, two bones, dual quaternion
+    22,     // one light, two bones, no fog, dual quaternion
+    23,     // one light, four bones, dual quaternion
+    23,     // one light, four bones, no fog, dual quaternion
+
+    24,     // pixel lighting, one bone, dual quaternion
+    24,     // pixel lighting, one bone, no fog, dual quaternion
+    25,     // pixel lighting, two bones, dual quaternion
+    25,     // pixel lighting, two bones, no fog, dual quaternion
+    26,     // pixel lighting, four bones, dual quaternion
+    26,     // pixel lighting, four bones, no fog, dual quaternion
+
+    27,     // vertex lighting (biased vertex normals), one bone, dual quaternion
+    27,     // vertex lighting (biased vertex normals), one bone, no fog, dual quaternion
+    28,     // vertex lighting (biased vertex normals), two bones, dual quaternion
+    28,     // vertex lighting (biased vertex normals), two bones, no fog, dual quaternion
+    29,     // vertex lighting (biased vertex normals), four bones, dual quaternion
+    29,     // vertex lighting (biased vertex normals), four bones, no fog, dual quaternion
+
+    30,     // one light (biased vertex normals), one bone, dual quaternion
+    30,     // one light (biased vertex normals), one bone, no fog, dual quaternion
+    31,     // one light (biased vertex normals), two bones, dual quaternion
+    31,     // one light (biased vertex normals), two bones, no fog, dual quaternion
+    32,     // one light (biased vertex normals), four bones, dual quaternion
+    32,     // one light (biased vertex normals), four bones, no fog, dual quaternion
+
+    33,     // pixel lighting (biased vertex normals), one bone, dual quaternion
+    33,     // pixel lighting (biased vertex normals), one bone, no fog, dual quaternion
+    34,     // pixel lighting (biased vertex normals), two bones, dual quaternion
+    34,     // pixel lighting (biased vertex normals), two bones, no fog, dual quaternion
+    35,     // pixel lighting (biased vertex normals), four bones, dual quaternion
+    35,     // pixel lighting (biased vertex normals), four bones, no fog, dual quaternion
 };
 
 
@@ -262,6 +381,48 @@ const int EffectBase<SkinnedEffectTraits>::PixelShaderIndices[] =
     2,      // pixel lighting (biased vertex normals), two bones, no fog
     2,      // pixel lighting (biased vertex normals), four bones
     2,      // pixel lighting (biased vertex normals), four bones, no fog
+
+    0,      // vertex lighting, one bone, dual quaternion
+    1,      // vertex lighting, one bone, no fog, dual quaternion
+    0,      // vertex lighting, two bones, dual quaternion
+    1,      // vertex lighting, two bones, no fog, dual quaternion
+    0,      // vertex lighting, four bones, dual quaternion
+    1,      // vertex lighting, four bones, no fog, dual quaternion
+
+    0,      // one light, one bone, dual quaternion
+    1,      // one light, one bone, no fog, dual quaternion
+    0,      // one light, two bones, dual quaternion
+    1,      // one light, two bones, no fog, dual quaternion
+    0,      // one light, four bones, dual quaternion
+    1,      // one light, four bones, no fog, dual quaternion
+
+    2,      // pixel lighting, one bone, dual quaternion
+    2,      // pixel lighting, one bone, no fog, dual quaternion
+    2,      // pixel lighting, two bones, dual quaternion
+    2,      // pixel lighting, two bones, no fog, dual quaternion
+    2,      // pixel lighting, four bones, dual quaternion
+    2,      // pixel lighting, four bones, no fog, dual quaternion
+
+    0,      // vertex lighting (biased vertex normals), one bone, dual quaternion
+    1,      // vertex lighting (biased vertex normals), one bone, no fog, dual quaternion
+    0,      // vertex lighting (biased vertex normals), two bones, dual quaternion
+    1,      // vertex lighting (biased vertex normals), two bones, no fog, dual quaternion
+    0,      // vertex lighting (biased vertex normals), four bones, dual quaternion
+    1,      // vertex lighting (biased vertex normals), four bones, no fog, dual quaternion
+
+    0,      // one light (biased vertex normals), one bone, dual quaternion
+    1,      // one light (biased vertex normals), one bone, no fog, dual quaternion
+    0,      // one light (biased vertex normals), two bones, dual quaternion
+    1,      // one light (biased vertex normals), two bones, no fog, dual quaternion
+    0,      // one light (biased vertex normals), four bones, dual quaternion
+    1,      // one light (biased vertex normals), four bones, no fog, dual quaternion
+
+    2,      // pixel lighting (biased vertex normals), one bone, dual quaternion
+    2,      // pixel lighting (biased vertex normals), one bone, no fog, dual quaternion
+    2,      // pixel lighting (biased vertex normals), two bones, dual quaternion
+    2,      // pixel lighting (biased vertex normals), two bones, no fog, dual quaternion
+    2,      // pixel lighting (biased vertex normals), four bones, dual quaternion
+    2,      // pixel lighting (biased vertex normals), four bones, no fog, dual quaternion
 };
 #pragma endregion
 
@@ -270,12 +431,27 @@ template<>
 SharedResourcePool<ID3D11Device*, EffectBase<SkinnedEffectTraits>::DeviceResources> EffectBase<SkinnedEffectTraits>::deviceResourcesPool = {};
 
 
+// Queues shader permutations for EffectShaderWarmUp.
+_Use_decl_annotations_
+std::shared_ptr<void> DirectX::WarmUpSkinnedEffectShaders(ID3D11Device* device, const uint32_t* permutations, size_t count, std::vector<EffectWarmUpTask>& tasks)
+{
+    return EffectBase<SkinnedEffectTraits>::WarmUpShaders(device, permutations, count, tasks);
+}
+
+_Use_decl_annotations_
+void DirectX::GetSkinnedEffectUsedPermutations(ID3D11Device* device, std::vector<uint32_t>& permutations)
+{
+    EffectBase<SkinnedEffectTraits>::GetUsedPermutations(device, permutations);
+}
+
+
 // Constructor.
 SkinnedEffect::Impl::Impl(_In_ ID3D11Device* device)
     : EffectBase(device),
     preferPerPixelLighting(false),
     biasedVertexNormals(false),
-    weightsPerVertex(4)
+    weightsPerVertex(4),
+    boneFormat(BoneFormat_Matrix)
 {
     static_assert(static_cast<int>(std::size(EffectBase<SkinnedEffectTraits>::VertexShaderIndices)) == SkinnedEffectTraits::ShaderPermutationCount, "array/max mismatch");
     static_assert(static_cast<int>(std::size(EffectBase<SkinnedEffectTraits>::VertexShaderBytecode)) == SkinnedEffectTraits::VertexShaderCount, "array/max mismatch");
@@ -330,6 +506,12 @@ int SkinnedEffect::Impl::GetCurrentShaderPermutation() const noexcept
         permutation += 18;
     }
 
+    if (boneFormat == BoneFormat_DualQuaternion)
+    {
+        // Read the bone palette as quaternions.
+        permutation += 36;
+    }
+
     return permutation;
 }
 
@@ -339,6 +521,8 @@ void SkinnedEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
 {
     assert(deviceContext != nullptr);
 
+    StateFilter filter(deviceContext);
+
     // Compute derived parameter values.
     matrices.SetConstants(dirtyFlags, constants.worldViewProj);
 
@@ -352,13 +536,29 @@ void SkinnedEffect::Impl::Apply(_In_ ID3D11DeviceContext* deviceContext)
         (texture) ? texture.Get() : GetDefaultTexture()
     };
 
-    deviceContext->PSSetShaderResources(0, 1, textures);
+    filter.PSSetShaderResources(0, 1, textures);
 
     // Set shaders and constant buffers.
     ApplyShaders(deviceContext, GetCurrentShaderPermutation());
 }
 
 
+// Trims the constant buffer upload to the bones in use. Matrix bones are always uploaded in full.
+void SkinnedEffect::Impl::SetBoneCount(size_t count) noexcept
+{
+    if (boneFormat == BoneFormat_DualQuaternion)
+    {
+        constantsSize = offsetof(SkinnedEffectConstants, bones) + count * 2 * sizeof(XMVECTOR);
+    }
+    else
+    {
+        constantsSize = sizeof(SkinnedEffectConstants);
+    }
+
+    dirtyFlags |= EffectDirtyFlags::ConstantBuffer;
+}
+
+
 // Public constructor.
 SkinnedEffect::SkinnedEffect(_In_ ID3D11Device* device)
     : pImpl(std::make_unique<Impl>(device))
@@ -387,7 +587,7 @@ void SkinnedEffect::GetVertexShaderBytecode(_Out_ void const** pShaderByteCode,
 // Camera settings.
 void XM_CALLCONV SkinnedEffect::SetWorld(FXMMATRIX value)
 {
-    pImpl->matrices.world = value;
+    pImpl->matrices.SetWorld(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::FogVector;
 }
@@ -395,7 +595,7 @@ void XM_CALLCONV SkinnedEffect::SetWorld(FXMMATRIX value)
 
 void XM_CALLCONV SkinnedEffect::SetView(FXMMATRIX value)
 {
-    pImpl->matrices.view = value;
+    pImpl->matrices.SetView(value);
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
 }
@@ -411,14 +611,30 @@ void XM_CALLCONV SkinnedEffect::SetProjection(FXMMATRIX value)
 
 void XM_CALLCONV SkinnedEffect::SetMatrices(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection)
 {
-    pImpl->matrices.world = world;
-    pImpl->matrices.view = view;
+    pImpl->matrices.SetWorld(world);
+    pImpl->matrices.SetView(view);
     pImpl->matrices.projection = projection;
 
     pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
 }
 
 
+void SkinnedEffect::SetCamera(const EffectCamera& camera)
+{
+    pImpl->matrices.SetCamera(camera);
+
+    pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::EyePosition | EffectDirtyFlags::FogVector;
+}
+
+
+void SkinnedEffect::SetWorldTransform(const EffectWorldTransform& transform)
+{
+    pImpl->matrices.SetWorldTransform(transform);
+
+    pImpl->dirtyFlags |= EffectDirtyFlags::WorldViewProj | EffectDirtyFlags::WorldInverseTranspose | EffectDirtyFlags::FogVector;
+}
+
+
 // Material settings.
 void XM_CALLCONV SkinnedEffect::SetDiffuseColor(FXMVECTOR value)
 {
@@ -596,6 +812,17 @@ void SkinnedEffect::SetWeightsPerVertex(int value)
 
 void SkinnedEffect::SetBoneTransforms(_In_reads_(count) XMMATRIX const* value, size_t count)
 {
+    if (pImpl->boneFormat == BoneFormat_DualQuaternion)
+    {
+        if (count > MaxDualQuaternionBones)
+            throw std::invalid_argument("count parameter exceeds MaxDualQuaternionBones");
+
+        ConvertBoneTransforms(value, count, &pImpl->constants.bones[0][0]);
+
+        pImpl->SetBoneCount(count);
+        return;
+    }
+
     if (count > MaxBones)
         throw std::invalid_argument("count parameter exceeds MaxBones");
 
@@ -621,6 +848,20 @@ void SkinnedEffect::SetBoneTransforms(_In_reads_(count) XMMATRIX const* value, s
 
 void SkinnedEffect::ResetBoneTransforms()
 {
+    if (pImpl->boneFormat == BoneFormat_DualQuaternion)
+    {
+        auto boneConstant = &pImpl->constants.bones[0][0];
+
+        for (size_t i = 0; i < MaxDualQuaternionBones; ++i)
+        {
+            boneConstant[i * 2] = g_XMIdentityR3;
+            boneConstant[i * 2 + 1] = g_XMIdentityR3;
+        }
+
+        pImpl->SetBoneCount(MaxDualQuaternionBones);
+        return;
+    }
+
     auto boneConstant = pImpl->constants.bones;
 
     for (size_t i = 0; i < MaxBones; ++i)
@@ -630,7 +871,54 @@ void SkinnedEffect::ResetBoneTransforms()
         boneConstant[i][2] = g_XMIdentityR2;
     }
 
-    pImpl->dirtyFlags |= EffectDirtyFlags::ConstantBuffer;
+    pImpl->SetBoneCount(MaxBones);
+}
+
+
+void SkinnedEffect::SetBoneFormat(BoneFormat value)
+{
+    if (value != BoneFormat_Matrix && value != BoneFormat_DualQuaternion)
+        throw std::invalid_argument("Unknown bone format");
+
+    if (value != pImpl->boneFormat)
+    {
+        pImpl->boneFormat = value;
+
+        ResetBoneTransforms();
+    }
+}
+
+
+// Uniform scale is taken from the length of the first row, and the remaining rotation
+// converted to a quaternion.
+_Use_decl_annotations_
+void SkinnedEffect::ConvertBoneTransforms(XMMATRIX const* value, size_t count, XMVECTOR* result) noexcept
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const XMMATRIX& bone = value[i];
+
+        const XMVECTOR scale = XMVector3Length(bone.r[0]);
+
+        XMVECTOR rotation = g_XMIdentityR3;
+        if (XMVectorGetX(scale) > 0.f)
+        {
+            const XMVECTOR invScale = XMVectorReciprocal(scale);
+
+            const XMMATRIX m(
+                XMVectorMultiply(bone.r[0], invScale),
+                XMVectorMultiply(bone.r[1], invScale),
+                XMVectorMultiply(bone.r[2], invScale),
+                g_XMIdentityR3);
+
+            rotation = XMQuaternionNormalize(XMQuaternionRotationMatrix(m));
+        }
+
+        result[i * 2] = rotation;
+
+        // x, y, z = translation, w = scale
+        result[i * 2 + 1] = XMVectorSelect(scale, bone.r[3], g_XMSelect1110);
+    }
 }
 
 
@@ -16,6 +16,7 @@
 #include "VertexTypes.h"
 #include "AlignedNew.h"
 #include "SharedResourcePool.h"
+#include "StateFilter.h"
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -553,22 +554,24 @@ void SpriteBatch::Impl::PrepareForRendering()
 {
     auto deviceContext = mContextResources->deviceContext.Get();
 
+    StateFilter filter(deviceContext);
+
     // Set state objects.
     auto blendState = mBlendState ? mBlendState.Get() : mDeviceResources->stateObjects.AlphaBlend();
     auto depthStencilState = mDepthStencilState ? mDepthStencilState.Get() : mDeviceResources->stateObjects.DepthNone();
     auto rasterizerState = mRasterizerState ? mRasterizerState.Get() : mDeviceResources->stateObjects.CullCounterClockwise();
     auto samplerState = mSamplerState ? mSamplerState.Get() : mDeviceResources->stateObjects.LinearClamp();
 
-    deviceContext->OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
-    deviceContext->OMSetDepthStencilState(depthStencilState, 0);
-    deviceContext->RSSetState(rasterizerState);
-    deviceContext->PSSetSamplers(0, 1, &samplerState);
+    filter.OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
+    filter.OMSetDepthStencilState(depthStencilState, 0);
+    filter.RSSetState(rasterizerState);
+    filter.PSSetSamplers(0, 1, &samplerState);
 
     // Set shaders.
-    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    deviceContext->IASetInputLayout(mDeviceResources->inputLayout.Get());
-    deviceContext->VSSetShader(mDeviceResources->vertexShader.Get(), nullptr, 0);
-    deviceContext->PSSetShader(mDeviceResources->pixelShader.Get(), nullptr, 0);
+    filter.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    filter.IASetInputLayout(mDeviceResources->inputLayout.Get());
+    filter.VSSetShader(mDeviceResources->vertexShader.Get(), nullptr, 0);
+    filter.PSSetShader(mDeviceResources->pixelShader.Get(), nullptr, 0);
 
     // Set the vertex and index buffer.
 #if !defined(_XBOX_ONE) || !defined(_TITLE)
@@ -576,10 +579,10 @@ void SpriteBatch::Impl::PrepareForRendering()
     constexpr UINT vertexStride = sizeof(VertexPositionColorTexture);
     constexpr UINT vertexOffset = 0;
 
-    deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
+    filter.IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
 #endif
 
-    deviceContext->IASetIndexBuffer(mDeviceResources->indexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+    filter.IASetIndexBuffer(mDeviceResources->indexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
 
     // Set the transform matrix.
     const XMMATRIX transformMatrix = (mRotation == DXGI_MODE_ROTATION_UNSPECIFIED)
@@ -596,7 +599,7 @@ void SpriteBatch::Impl::PrepareForRendering()
 
     ID3D11Buffer* constantBuffer = mContextResources->constantBuffer.GetBuffer();
 
-    deviceContext->VSSetConstantBuffers(0, 1, &constantBuffer);
+    filter.VSSetConstantBuffers(0, 1, &constantBuffer);
 #endif
 
     // If this is a deferred D3D context, reset position so the first Map call will use D3D11_MAP_WRITE_DISCARD.
@@ -609,6 +612,7 @@ void SpriteBatch::Impl::PrepareForRendering()
     if (mSetCustomShaders)
     {
         mSetCustomShaders();
+        filter.Invalidate();
     }
 }
 
@@ -725,8 +729,10 @@ void SpriteBatch::Impl::RenderBatch(ID3D11ShaderResourceView* texture, SpriteInf
 {
     auto deviceContext = mContextResources->deviceContext.Get();
 
+    StateFilter filter(deviceContext);
+
     // Draw using the specified texture.
-    deviceContext->PSSetShaderResources(0, 1, &texture);
+    filter.PSSetShaderResources(0, 1, &texture);
 
     const XMVECTOR textureSize = GetTextureSize(texture);
     const XMVECTOR inverseTextureSize = XMVectorReciprocal(textureSize);
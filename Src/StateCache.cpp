@@ -0,0 +1,599 @@
+//--------------------------------------------------------------------------------------
+// File: StateCache.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "StateCache.h"
+#include "PlatformHelpers.h"
+
+#include <atomic>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+
+namespace
+{
+    // Only the low slots the toolkit uses are shadowed; binds outside them are passed through.
+    constexpr UINT c_MaxConstantBuffers = 4;
+    constexpr UINT c_MaxResources = 8;
+    constexpr UINT c_MaxSamplers = 4;
+    constexpr UINT c_MaxVertexBuffers = 2;
+
+    // numConstants value recorded for a whole-buffer constant buffer bind
+    constexpr UINT c_WholeBuffer = 0;
+
+    template<typename T>
+    struct Shadow
+    {
+        ComPtr<T>   value;
+        bool        known = false;
+
+        bool Matches(const T* v) const noexcept { return known && value.Get() == v; }
+        void Set(T* v) noexcept { value = v; known = true; }
+        void Reset() noexcept { value.Reset(); known = false; }
+    };
+
+    struct ConstantBufferShadow : Shadow<ID3D11Buffer>
+    {
+        UINT first = 0;
+        UINT num = c_WholeBuffer;
+
+        bool Matches(const ID3D11Buffer* v, UINT f, UINT n) const noexcept
+        {
+            return Shadow<ID3D11Buffer>::Matches(v) && first == f && num == n;
+        }
+
+        void Set(ID3D11Buffer* v, UINT f, UINT n) noexcept
+        {
+            Shadow<ID3D11Buffer>::Set(v);
+            first = f;
+            num = n;
+        }
+    };
+
+    struct VertexBufferShadow : Shadow<ID3D11Buffer>
+    {
+        UINT stride = 0;
+        UINT offset = 0;
+    };
+
+    struct IndexBufferShadow : Shadow<ID3D11Buffer>
+    {
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        UINT offset = 0;
+    };
+
+    struct BlendShadow : Shadow<ID3D11BlendState>
+    {
+        float factor[4] = {};
+        UINT mask = 0;
+    };
+
+    struct DepthStencilShadow : Shadow<ID3D11DepthStencilState>
+    {
+        UINT stencilRef = 0;
+    };
+
+    // Caches registered by device context. The generation changes whenever a cache is added or
+    // removed, so each thread can keep its last lookup until then without taking the lock.
+    std::mutex s_registryMutex;
+    std::vector<std::pair<ID3D11DeviceContext*, StateCache*>> s_registry;
+    std::atomic<size_t> s_registryCount(0);
+    std::atomic<uint64_t> s_registryGeneration(1);
+
+    struct RegistryLookup
+    {
+        uint64_t                generation;
+        ID3D11DeviceContext*    context;
+        StateCache*             cache;
+    };
+
+    thread_local RegistryLookup s_lastLookup = {};
+}
+
+
+//--------------------------------------------------------------------------------------
+class StateCache::Impl
+{
+public:
+    explicit Impl(_In_ ID3D11DeviceContext* deviceContext) noexcept :
+        mContext(deviceContext),
+        mStats{},
+        mTopologyKnown(false),
+        mTopology(D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED)
+    {
+        // Offset constant buffer binds need Direct3D 11.1
+        (void)deviceContext->QueryInterface(IID_GRAPHICS_PPV_ARGS(mContext1.GetAddressOf()));
+    }
+
+    void Invalidate() noexcept
+    {
+        mVS.Reset();
+        mPS.Reset();
+
+        for (UINT j = 0; j < c_MaxConstantBuffers; ++j)
+        {
+            mVSConstants[j].Reset();
+            mPSConstants[j].Reset();
+        }
+
+        for (auto& it : mResources)
+            it.Reset();
+
+        for (auto& it : mSamplers)
+            it.Reset();
+
+        mInputLayout.Reset();
+
+        for (auto& it : mVertexBuffers)
+            it.Reset();
+
+        mIndexBuffer.Reset();
+        mTopologyKnown = false;
+
+        mBlend.Reset();
+        mDepthStencil.Reset();
+        mRasterizer.Reset();
+    }
+
+    // Counts a call and reports whether it can be dropped
+    bool Elide(bool redundant) noexcept
+    {
+        ++mStats.calls;
+        if (redundant)
+        {
+            ++mStats.elided;
+        }
+        return redundant;
+    }
+
+    void SetConstantBuffer(bool vs, UINT slot, ID3D11Buffer* buffer, UINT first, UINT num)
+    {
+        ConstantBufferShadow* shadow = nullptr;
+        if (slot < c_MaxConstantBuffers)
+        {
+            shadow = vs ? &mVSConstants[slot] : &mPSConstants[slot];
+            if (Elide(shadow->Matches(buffer, first, num)))
+                return;
+        }
+        else
+        {
+            Elide(false);
+        }
+
+        if (num == c_WholeBuffer)
+        {
+            if (vs)
+                mContext->VSSetConstantBuffers(slot, 1, &buffer);
+            else
+                mContext->PSSetConstantBuffers(slot, 1, &buffer);
+        }
+        else
+        {
+            if (!mContext1)
+                throw std::runtime_error("Constant buffer offsets require Direct3D 11.1");
+
+            if (vs)
+                mContext1->VSSetConstantBuffers1(slot, 1, &buffer, &first, &num);
+            else
+                mContext1->PSSetConstantBuffers1(slot, 1, &buffer, &first, &num);
+        }
+
+        // Only record the bind once it has reached the context
+        if (shadow)
+            shadow->Set(buffer, first, num);
+    }
+
+    ID3D11DeviceContext*            mContext;
+    ComPtr<ID3D11DeviceContext1>    mContext1;
+
+    Statistics                      mStats;
+
+    Shadow<ID3D11VertexShader>      mVS;
+    Shadow<ID3D11PixelShader>       mPS;
+    ConstantBufferShadow            mVSConstants[c_MaxConstantBuffers];
+    ConstantBufferShadow            mPSConstants[c_MaxConstantBuffers];
+    Shadow<ID3D11ShaderResourceView> mResources[c_MaxResources];
+    Shadow<ID3D11SamplerState>      mSamplers[c_MaxSamplers];
+    Shadow<ID3D11InputLayout>       mInputLayout;
+    VertexBufferShadow              mVertexBuffers[c_MaxVertexBuffers];
+    IndexBufferShadow               mIndexBuffer;
+    bool                            mTopologyKnown;
+    D3D11_PRIMITIVE_TOPOLOGY        mTopology;
+    BlendShadow                     mBlend;
+    DepthStencilShadow              mDepthStencil;
+    Shadow<ID3D11RasterizerState>   mRasterizer;
+};
+
+
+//--------------------------------------------------------------------------------------
+StateCache::StateCache(_In_ ID3D11DeviceContext* deviceContext)
+{
+    if (!deviceContext)
+        throw std::invalid_argument("Device context cannot be null");
+
+    pImpl = std::make_unique<Impl>(deviceContext);
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+
+    for (const auto& it : s_registry)
+    {
+        if (it.first == deviceContext)
+            throw std::logic_error("StateCache already exists for this device context");
+    }
+
+    s_registry.emplace_back(deviceContext, this);
+    s_registryCount.store(s_registry.size(), std::memory_order_release);
+    s_registryGeneration.fetch_add(1, std::memory_order_release);
+}
+
+
+StateCache::~StateCache()
+{
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+
+    s_registry.erase(
+        std::remove_if(s_registry.begin(), s_registry.end(),
+            [this](const std::pair<ID3D11DeviceContext*, StateCache*>& it) noexcept { return it.second == this; }),
+        s_registry.end());
+
+    s_registryCount.store(s_registry.size(), std::memory_order_release);
+    s_registryGeneration.fetch_add(1, std::memory_order_release);
+}
+
+
+void StateCache::Invalidate() noexcept
+{
+    pImpl->Invalidate();
+}
+
+
+StateCache::Statistics StateCache::GetStatistics() const noexcept
+{
+    return pImpl->mStats;
+}
+
+
+void StateCache::ResetStatistics() noexcept
+{
+    pImpl->mStats = {};
+}
+
+
+ID3D11DeviceContext* StateCache::GetDeviceContext() const noexcept
+{
+    return pImpl->mContext;
+}
+
+
+_Use_decl_annotations_
+StateCache* StateCache::Get(ID3D11DeviceContext* deviceContext) noexcept
+{
+    // Skip the lock entirely in the common case of no caches
+    if (!s_registryCount.load(std::memory_order_acquire))
+        return nullptr;
+
+    // Most lookups repeat the calling thread's previous one
+    auto& last = s_lastLookup;
+    if (last.context == deviceContext
+        && last.generation == s_registryGeneration.load(std::memory_order_acquire))
+        return last.cache;
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+
+    StateCache* cache = nullptr;
+    for (const auto& it : s_registry)
+    {
+        if (it.first == deviceContext)
+        {
+            cache = it.second;
+            break;
+        }
+    }
+
+    last.generation = s_registryGeneration.load(std::memory_order_relaxed);
+    last.context = deviceContext;
+    last.cache = cache;
+
+    return cache;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Shaders
+
+_Use_decl_annotations_
+void StateCache::VSSetShader(ID3D11VertexShader* shader, ID3D11ClassInstance* const* classInstances, UINT numClassInstances)
+{
+    if (numClassInstances)
+    {
+        // Class instances aren't shadowed, so forget the stage's shader
+        pImpl->Elide(false);
+        pImpl->mVS.Reset();
+        pImpl->mContext->VSSetShader(shader, classInstances, numClassInstances);
+        return;
+    }
+
+    if (pImpl->Elide(pImpl->mVS.Matches(shader)))
+        return;
+
+    pImpl->mVS.Set(shader);
+    pImpl->mContext->VSSetShader(shader, nullptr, 0);
+}
+
+
+_Use_decl_annotations_
+void StateCache::PSSetShader(ID3D11PixelShader* shader, ID3D11ClassInstance* const* classInstances, UINT numClassInstances)
+{
+    if (numClassInstances)
+    {
+        pImpl->Elide(false);
+        pImpl->mPS.Reset();
+        pImpl->mContext->PSSetShader(shader, classInstances, numClassInstances);
+        return;
+    }
+
+    if (pImpl->Elide(pImpl->mPS.Matches(shader)))
+        return;
+
+    pImpl->mPS.Set(shader);
+    pImpl->mContext->PSSetShader(shader, nullptr, 0);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constant buffers
+
+_Use_decl_annotations_
+void StateCache::VSSetConstantBuffer(UINT slot, ID3D11Buffer* buffer)
+{
+    pImpl->SetConstantBuffer(true, slot, buffer, 0, c_WholeBuffer);
+}
+
+
+_Use_decl_annotations_
+void StateCache::PSSetConstantBuffer(UINT slot, ID3D11Buffer* buffer)
+{
+    pImpl->SetConstantBuffer(false, slot, buffer, 0, c_WholeBuffer);
+}
+
+
+_Use_decl_annotations_
+void StateCache::VSSetConstantBuffer1(UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants)
+{
+    if (numConstants == c_WholeBuffer)
+        throw std::invalid_argument("numConstants cannot be zero");
+
+    pImpl->SetConstantBuffer(true, slot, buffer, firstConstant, numConstants);
+}
+
+
+_Use_decl_annotations_
+void StateCache::PSSetConstantBuffer1(UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants)
+{
+    if (numConstants == c_WholeBuffer)
+        throw std::invalid_argument("numConstants cannot be zero");
+
+    pImpl->SetConstantBuffer(false, slot, buffer, firstConstant, numConstants);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Shader resources and samplers
+
+_Use_decl_annotations_
+void StateCache::PSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+    if (!count)
+        return;
+
+    auto& resources = pImpl->mResources;
+
+    if (startSlot < c_MaxResources && count <= (c_MaxResources - startSlot))
+    {
+        bool redundant = true;
+        for (UINT j = 0; j < count; ++j)
+        {
+            if (!resources[startSlot + j].Matches(views ? views[j] : nullptr))
+            {
+                redundant = false;
+                break;
+            }
+        }
+
+        if (pImpl->Elide(redundant))
+            return;
+
+        for (UINT j = 0; j < count; ++j)
+        {
+            resources[startSlot + j].Set(views ? views[j] : nullptr);
+        }
+    }
+    else
+    {
+        pImpl->Elide(false);
+
+        for (UINT j = startSlot; j < c_MaxResources; ++j)
+        {
+            resources[j].Reset();
+        }
+    }
+
+    if (views)
+    {
+        pImpl->mContext->PSSetShaderResources(startSlot, count, views);
+    }
+    else
+    {
+        ID3D11ShaderResourceView* nullViews[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {};
+        pImpl->mContext->PSSetShaderResources(startSlot, std::min<UINT>(count, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT), nullViews);
+    }
+}
+
+
+_Use_decl_annotations_
+void StateCache::PSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers)
+{
+    if (!count)
+        return;
+
+    auto& shadows = pImpl->mSamplers;
+
+    if (startSlot < c_MaxSamplers && count <= (c_MaxSamplers - startSlot))
+    {
+        bool redundant = true;
+        for (UINT j = 0; j < count; ++j)
+        {
+            if (!shadows[startSlot + j].Matches(samplers ? samplers[j] : nullptr))
+            {
+                redundant = false;
+                break;
+            }
+        }
+
+        if (pImpl->Elide(redundant))
+            return;
+
+        for (UINT j = 0; j < count; ++j)
+        {
+            shadows[startSlot + j].Set(samplers ? samplers[j] : nullptr);
+        }
+    }
+    else
+    {
+        pImpl->Elide(false);
+
+        for (UINT j = startSlot; j < c_MaxSamplers; ++j)
+        {
+            shadows[j].Reset();
+        }
+    }
+
+    if (samplers)
+    {
+        pImpl->mContext->PSSetSamplers(startSlot, count, samplers);
+    }
+    else
+    {
+        ID3D11SamplerState* nullSamplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT] = {};
+        pImpl->mContext->PSSetSamplers(startSlot, std::min<UINT>(count, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT), nullSamplers);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Input assembler
+
+_Use_decl_annotations_
+void StateCache::IASetInputLayout(ID3D11InputLayout* inputLayout)
+{
+    if (pImpl->Elide(pImpl->mInputLayout.Matches(inputLayout)))
+        return;
+
+    pImpl->mInputLayout.Set(inputLayout);
+    pImpl->mContext->IASetInputLayout(inputLayout);
+}
+
+
+_Use_decl_annotations_
+void StateCache::IASetVertexBuffer(UINT slot, ID3D11Buffer* buffer, UINT stride, UINT offset)
+{
+    if (slot < c_MaxVertexBuffers)
+    {
+        auto& shadow = pImpl->mVertexBuffers[slot];
+        if (pImpl->Elide(shadow.Matches(buffer) && shadow.stride == stride && shadow.offset == offset))
+            return;
+
+        shadow.Set(buffer);
+        shadow.stride = stride;
+        shadow.offset = offset;
+    }
+    else
+    {
+        pImpl->Elide(false);
+    }
+
+    pImpl->mContext->IASetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+}
+
+
+_Use_decl_annotations_
+void StateCache::IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset)
+{
+    auto& shadow = pImpl->mIndexBuffer;
+    if (pImpl->Elide(shadow.Matches(buffer) && shadow.format == format && shadow.offset == offset))
+        return;
+
+    shadow.Set(buffer);
+    shadow.format = format;
+    shadow.offset = offset;
+
+    pImpl->mContext->IASetIndexBuffer(buffer, format, offset);
+}
+
+
+void StateCache::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    if (pImpl->Elide(pImpl->mTopologyKnown && pImpl->mTopology == topology))
+        return;
+
+    pImpl->mTopologyKnown = true;
+    pImpl->mTopology = topology;
+
+    pImpl->mContext->IASetPrimitiveTopology(topology);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Fixed-function state objects
+
+_Use_decl_annotations_
+void StateCache::OMSetBlendState(ID3D11BlendState* state, const float blendFactor[4], UINT sampleMask)
+{
+    // A null blend factor means { 1, 1, 1, 1 }
+    static const float s_defaultFactor[4] = { 1.f, 1.f, 1.f, 1.f };
+    const float* factor = blendFactor ? blendFactor : s_defaultFactor;
+
+    auto& shadow = pImpl->mBlend;
+    if (pImpl->Elide(shadow.Matches(state)
+        && shadow.mask == sampleMask
+        && memcmp(shadow.factor, factor, sizeof(shadow.factor)) == 0))
+        return;
+
+    shadow.Set(state);
+    shadow.mask = sampleMask;
+    memcpy(shadow.factor, factor, sizeof(shadow.factor));
+
+    pImpl->mContext->OMSetBlendState(state, blendFactor, sampleMask);
+}
+
+
+_Use_decl_annotations_
+void StateCache::OMSetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef)
+{
+    auto& shadow = pImpl->mDepthStencil;
+    if (pImpl->Elide(shadow.Matches(state) && shadow.stencilRef == stencilRef))
+        return;
+
+    shadow.Set(state);
+    shadow.stencilRef = stencilRef;
+
+    pImpl->mContext->OMSetDepthStencilState(state, stencilRef);
+}
+
+
+_Use_decl_annotations_
+void StateCache::RSSetState(ID3D11RasterizerState* state)
+{
+    if (pImpl->Elide(pImpl->mRasterizer.Matches(state)))
+        return;
+
+    pImpl->mRasterizer.Set(state);
+    pImpl->mContext->RSSetState(state);
+}
@@ -0,0 +1,179 @@
+//--------------------------------------------------------------------------------------
+// File: StateFilter.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "StateCache.h"
+
+#include <cassert>
+
+
+namespace DirectX
+{
+    // Mirrors the device context binding methods the toolkit uses, forwarding them to the
+    // StateCache for the context if the application created one, or straight to the
+    // context otherwise. Every toolkit bind of a shadowed kind goes through this so the
+    // cache never records a value that was since replaced behind its back.
+    class StateFilter
+    {
+    public:
+        explicit StateFilter(_In_ ID3D11DeviceContext* deviceContext) noexcept :
+            mContext(deviceContext),
+            mCache(StateCache::Get(deviceContext))
+        {
+            assert(deviceContext != nullptr);
+        }
+
+        StateFilter(StateFilter const&) = delete;
+        StateFilter& operator= (StateFilter const&) = delete;
+
+        // Call after user callbacks, which may bind anything directly.
+        void Invalidate() noexcept
+        {
+            if (mCache)
+                mCache->Invalidate();
+        }
+
+        void VSSetShader(_In_opt_ ID3D11VertexShader* shader, _In_opt_ ID3D11ClassInstance* const* classInstances, UINT numClassInstances)
+        {
+            if (mCache)
+                mCache->VSSetShader(shader, classInstances, numClassInstances);
+            else
+                mContext->VSSetShader(shader, classInstances, numClassInstances);
+        }
+
+        void PSSetShader(_In_opt_ ID3D11PixelShader* shader, _In_opt_ ID3D11ClassInstance* const* classInstances, UINT numClassInstances)
+        {
+            if (mCache)
+                mCache->PSSetShader(shader, classInstances, numClassInstances);
+            else
+                mContext->PSSetShader(shader, classInstances, numClassInstances);
+        }
+
+        void VSSetConstantBuffers(UINT startSlot, UINT numBuffers, _In_reads_(numBuffers) ID3D11Buffer* const* buffers)
+        {
+            if (auto cache = BufferCache())
+            {
+                for (UINT j = 0; j < numBuffers; ++j)
+                    cache->VSSetConstantBuffer(startSlot + j, buffers[j]);
+            }
+            else
+            {
+                mContext->VSSetConstantBuffers(startSlot, numBuffers, buffers);
+            }
+        }
+
+        void PSSetConstantBuffers(UINT startSlot, UINT numBuffers, _In_reads_(numBuffers) ID3D11Buffer* const* buffers)
+        {
+            if (auto cache = BufferCache())
+            {
+                for (UINT j = 0; j < numBuffers; ++j)
+                    cache->PSSetConstantBuffer(startSlot + j, buffers[j]);
+            }
+            else
+            {
+                mContext->PSSetConstantBuffers(startSlot, numBuffers, buffers);
+            }
+        }
+
+        void PSSetShaderResources(UINT startSlot, UINT numViews, _In_reads_(numViews) ID3D11ShaderResourceView* const* views)
+        {
+            if (mCache)
+                mCache->PSSetShaderResources(startSlot, numViews, views);
+            else
+                mContext->PSSetShaderResources(startSlot, numViews, views);
+        }
+
+        void PSSetSamplers(UINT startSlot, UINT numSamplers, _In_reads_(numSamplers) ID3D11SamplerState* const* samplers)
+        {
+            if (mCache)
+                mCache->PSSetSamplers(startSlot, numSamplers, samplers);
+            else
+                mContext->PSSetSamplers(startSlot, numSamplers, samplers);
+        }
+
+        void IASetInputLayout(_In_opt_ ID3D11InputLayout* inputLayout)
+        {
+            if (mCache)
+                mCache->IASetInputLayout(inputLayout);
+            else
+                mContext->IASetInputLayout(inputLayout);
+        }
+
+        void IASetVertexBuffers(UINT startSlot, UINT numBuffers,
+            _In_reads_(numBuffers) ID3D11Buffer* const* buffers,
+            _In_reads_(numBuffers) const UINT* strides,
+            _In_reads_(numBuffers) const UINT* offsets)
+        {
+            if (auto cache = BufferCache())
+            {
+                for (UINT j = 0; j < numBuffers; ++j)
+                    cache->IASetVertexBuffer(startSlot + j, buffers[j], strides[j], offsets[j]);
+            }
+            else
+            {
+                mContext->IASetVertexBuffers(startSlot, numBuffers, buffers, strides, offsets);
+            }
+        }
+
+        void IASetIndexBuffer(_In_opt_ ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset)
+        {
+            if (auto cache = BufferCache())
+                cache->IASetIndexBuffer(buffer, format, offset);
+            else
+                mContext->IASetIndexBuffer(buffer, format, offset);
+        }
+
+        void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+        {
+            if (mCache)
+                mCache->IASetPrimitiveTopology(topology);
+            else
+                mContext->IASetPrimitiveTopology(topology);
+        }
+
+        void OMSetBlendState(_In_opt_ ID3D11BlendState* state, _In_opt_ const float blendFactor[4], UINT sampleMask)
+        {
+            if (mCache)
+                mCache->OMSetBlendState(state, blendFactor, sampleMask);
+            else
+                mContext->OMSetBlendState(state, blendFactor, sampleMask);
+        }
+
+        void OMSetDepthStencilState(_In_opt_ ID3D11DepthStencilState* state, UINT stencilRef)
+        {
+            if (mCache)
+                mCache->OMSetDepthStencilState(state, stencilRef);
+            else
+                mContext->OMSetDepthStencilState(state, stencilRef);
+        }
+
+        void RSSetState(_In_opt_ ID3D11RasterizerState* state)
+        {
+            if (mCache)
+                mCache->RSSetState(state);
+            else
+                mContext->RSSetState(state);
+        }
+
+    private:
+        // Xbox placement buffers are bound outside the cache, so buffer binds are not filtered there.
+        StateCache* BufferCache() const noexcept
+        {
+        #if defined(_XBOX_ONE) && defined(_TITLE)
+            return nullptr;
+        #else
+            return mCache;
+        #endif
+        }
+
+        ID3D11DeviceContext*    mContext;
+        StateCache*             mCache;
+    };
+}
@@ -0,0 +1,273 @@
+//--------------------------------------------------------------------------------------
+// File: TextureBatchLoader.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TextureBatchLoader.h"
+#include "BinaryReader.h"
+#include "DDSCompression.h"
+#include "DirectXHelpers.h"
+#include "ParallelFor.h"
+#include "PlatformHelpers.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <thread>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double Seconds(Clock::time_point start) noexcept
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Reads waiting for a CPU thread. I/O threads block once it holds enough files, so a batch
+    // larger than memory never has to be read in full before it is parsed.
+    class ReadQueue
+    {
+    public:
+        explicit ReadQueue(size_t capacity) noexcept :
+            mCapacity(capacity),
+            mClosed(false)
+        {
+        }
+
+        void Push(size_t index)
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mSpace.wait(lock, [this]() { return mItems.size() < mCapacity; });
+            mItems.push_back(index);
+            lock.unlock();
+            mReady.notify_one();
+        }
+
+        // Returns false once the queue is closed and drained.
+        bool Pop(size_t& index)
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mReady.wait(lock, [this]() { return mClosed || !mItems.empty(); });
+
+            if (mItems.empty())
+                return false;
+
+            index = mItems.front();
+            mItems.pop_front();
+            lock.unlock();
+            mSpace.notify_one();
+            return true;
+        }
+
+        void Close() noexcept
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mClosed = true;
+            }
+            mReady.notify_all();
+        }
+
+    private:
+        std::mutex                  mMutex;
+        std::condition_variable     mReady;
+        std::condition_variable     mSpace;
+        std::deque<size_t>          mItems;
+        size_t                      mCapacity;
+        bool                        mClosed;
+    };
+}
+
+
+//======================================================================================
+// TextureBatchLoader
+//======================================================================================
+
+class TextureBatchLoader::Impl
+{
+public:
+    Impl(_In_opt_ ID3D11Device* device, size_t ioThreads, size_t cpuThreads) noexcept :
+        mDevice(device),
+        mIOThreads(ioThreads ? ioThreads : 8u),
+        mCPUThreads(cpuThreads ? cpuThreads : std::max<size_t>(1u, std::thread::hardware_concurrency()))
+    {
+    }
+
+    std::vector<Result> Load(_In_reads_(count) const wchar_t* const* fileNames, size_t count, DDS_LOADER_FLAGS loadFlags)
+    {
+        if (!fileNames && count > 0)
+            throw std::invalid_argument("File names are null");
+
+        std::vector<Result> results(count);
+        std::vector<std::unique_ptr<uint8_t[]>> data(count);
+
+        if (!count)
+            return results;
+
+        const size_t cpuThreads = std::min(count, mCPUThreads);
+
+        ReadQueue queue(cpuThreads * 4);
+
+        // The I/O stage runs on its own threads so parsing starts with the first file read.
+        auto reader = std::async(std::launch::async, [&]()
+            {
+                try
+                {
+                    ParallelForOnThreads(count, [&](size_t index)
+                        {
+                            auto& result = results[index];
+                            const auto start = Clock::now();
+
+                            if (!fileNames[index])
+                            {
+                                result.hr = E_INVALIDARG;
+                            }
+                            else
+                            {
+                                result.hr = BinaryReader::ReadEntireFile(fileNames[index], data[index], &result.fileSize);
+                                if (FAILED(result.hr))
+                                {
+                                    DebugTrace("ERROR: TextureBatchLoader failed (%08X) to read '%ls'\n",
+                                        static_cast<unsigned int>(result.hr), fileNames[index]);
+                                }
+                            }
+
+                            result.readTime = Seconds(start);
+
+                            queue.Push(index);
+                        }, mIOThreads);
+                }
+                catch (...)
+                {
+                    queue.Close();
+                    throw;
+                }
+
+                queue.Close();
+            });
+
+        std::exception_ptr error;
+
+        try
+        {
+            ParallelForOnThreads(cpuThreads, [&](size_t)
+                {
+                    size_t index = 0;
+                    while (queue.Pop(index))
+                    {
+                        Process(results[index], data[index], loadFlags, fileNames[index]);
+                    }
+                }, cpuThreads);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+
+            // Keep draining so the readers are not left blocked on a full queue.
+            size_t index = 0;
+            while (queue.Pop(index))
+            {
+                data[index].reset();
+            }
+        }
+
+        reader.get();
+
+        if (error)
+            std::rethrow_exception(error);
+
+        return results;
+    }
+
+private:
+    void Process(Result& result, std::unique_ptr<uint8_t[]>& data, DDS_LOADER_FLAGS loadFlags, _In_opt_z_ const wchar_t* fileName)
+    {
+        if (FAILED(result.hr))
+            return;
+
+        size_t ddsDataSize = result.fileSize;
+
+        auto start = Clock::now();
+
+        if (IsCompressedDDS(data.get(), ddsDataSize))
+        {
+            std::unique_ptr<uint8_t[]> unpacked;
+            result.hr = DecompressDDS(data.get(), result.fileSize, unpacked, ddsDataSize);
+            result.decompressTime = Seconds(start);
+            if (FAILED(result.hr))
+            {
+                DebugTrace("ERROR: TextureBatchLoader failed (%08X) to decompress '%ls'\n",
+                    static_cast<unsigned int>(result.hr), fileName);
+                data.reset();
+                return;
+            }
+
+            data = std::move(unpacked);
+            start = Clock::now();
+        }
+
+        result.hr = ParseDDS(data.get(), ddsDataSize, &result.desc);
+
+        result.parseTime = Seconds(start);
+
+        if (SUCCEEDED(result.hr) && mDevice)
+        {
+            start = Clock::now();
+
+            result.hr = CreateDDSTextureFromMemoryEx(mDevice.Get(), data.get(), ddsDataSize, 0,
+                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+                static_cast<DDS_LOADER_FLAGS>(loadFlags & ~DDS_LOADER_MEMORY_MAPPED),
+                result.texture.GetAddressOf(), result.textureView.GetAddressOf());
+
+            result.createTime = Seconds(start);
+        }
+
+        if (FAILED(result.hr))
+        {
+            DebugTrace("ERROR: TextureBatchLoader failed (%08X) to load '%ls'\n",
+                static_cast<unsigned int>(result.hr), fileName);
+        }
+
+        data.reset();
+    }
+
+    ComPtr<ID3D11Device>    mDevice;
+    size_t                  mIOThreads;
+    size_t                  mCPUThreads;
+};
+
+
+// Public constructor.
+_Use_decl_annotations_
+TextureBatchLoader::TextureBatchLoader(ID3D11Device* device, size_t ioThreads, size_t cpuThreads)
+    : pImpl(std::make_unique<Impl>(device, ioThreads, cpuThreads))
+{
+}
+
+
+// Move constructor.
+TextureBatchLoader::TextureBatchLoader(TextureBatchLoader&&) noexcept = default;
+TextureBatchLoader& TextureBatchLoader::operator= (TextureBatchLoader&&) noexcept = default;
+TextureBatchLoader::~TextureBatchLoader() = default;
+
+
+_Use_decl_annotations_
+std::vector<TextureBatchLoader::Result> TextureBatchLoader::Load(
+    const wchar_t* const* fileNames,
+    size_t count,
+    DDS_LOADER_FLAGS loadFlags)
+{
+    return pImpl->Load(fileNames, count, loadFlags);
+}
@@ -0,0 +1,770 @@
+//--------------------------------------------------------------------------------------
+// File: TextureStreamer.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "TextureStreamer.h"
+#include "DDSParser.h"
+#include "DirectXHelpers.h"
+#include "LoaderHelpers.h"
+#include "MemoryMappedFile.h"
+#include "PlatformHelpers.h"
+#include "TextureStreamingScheduler.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+
+using namespace DirectX;
+using namespace DirectX::LoaderHelpers;
+using Microsoft::WRL::ComPtr;
+
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // A failed read is retried after this long, doubling with each failure in a row.
+    constexpr std::chrono::milliseconds c_retryDelay(100);
+    constexpr uint32_t c_maxRetryShift = 6;
+
+    // One texture and the layout of its file.
+    struct StreamedTexture
+    {
+        MemoryMappedFile                    file;
+        DDSTextureDesc                      desc;
+        std::vector<DDSSubresource>         subresources;
+        std::vector<size_t>                 levelBytes;     // Summed over the array slices
+        DXGI_FORMAT                         format;         // With the sRGB load flags applied
+        uint32_t                            tailMip;
+        uint32_t                            residentMip;
+        uint32_t                            requestedMip;   // Differs from residentMip while a read is in flight
+        float                               priority;
+        uint32_t                            failures;       // Consecutive failed reads
+        Clock::time_point                   retryTime;      // No new reads before this after a failure
+        ComPtr<ID3D11Resource>              texture;
+        ComPtr<ID3D11ShaderResourceView>    view;
+
+        const DDSSubresource& GetSubresource(size_t item, uint32_t level) const noexcept
+        {
+            return subresources[item * desc.mipLevels + level];
+        }
+
+        size_t GetResidentBytes() const noexcept
+        {
+            size_t bytes = 0;
+            for (uint32_t level = residentMip; level < desc.mipLevels; ++level)
+            {
+                bytes += levelBytes[level];
+            }
+            return bytes;
+        }
+
+        // Block compressed textures need a top level that is a whole number of blocks.
+        bool IsValidTopMip(uint32_t level) const noexcept
+        {
+            if (!IsCompressed(format))
+                return true;
+
+            return ((std::max(desc.width >> level, 1u) % 4) == 0)
+                && ((std::max(desc.height >> level, 1u) % 4) == 0);
+        }
+    };
+
+
+    // Levels [firstMip, lastMip) of every array slice, copied out of the mapped file.
+    struct StreamRequest
+    {
+        std::shared_ptr<StreamedTexture>    texture;
+        TextureStreamer::Handle             handle;
+        uint32_t                            firstMip;
+        uint32_t                            lastMip;
+        float                               priority;
+        Clock::time_point                   issued;
+        std::vector<uint8_t>                data;
+        std::vector<size_t>                 itemOffsets;    // Start of each slice's levels in data
+        bool                                failed;
+    };
+
+
+    //----------------------------------------------------------------------------------
+    void CreateShaderResourceView(
+        _In_ ID3D11Device* device,
+        const StreamedTexture& entry,
+        _In_ ID3D11Texture2D* texture,
+        _Outptr_ ID3D11ShaderResourceView** view)
+    {
+        const UINT arraySize = entry.desc.arraySize;
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC desc = {};
+        desc.Format = entry.format;
+
+        if (entry.desc.isCubeMap)
+        {
+            if (arraySize > 6)
+            {
+                desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBEARRAY;
+                desc.TextureCubeArray.MipLevels = UINT(-1);
+                desc.TextureCubeArray.NumCubes = arraySize / 6;
+            }
+            else
+            {
+                desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+                desc.TextureCube.MipLevels = UINT(-1);
+            }
+        }
+        else if (arraySize > 1)
+        {
+            desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+            desc.Texture2DArray.MipLevels = UINT(-1);
+            desc.Texture2DArray.ArraySize = arraySize;
+        }
+        else
+        {
+            desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+            desc.Texture2D.MipLevels = UINT(-1);
+        }
+
+        ThrowIfFailed(device->CreateShaderResourceView(texture, &desc, view));
+    }
+
+
+    // Creates the texture holding levels [topMip, mipLevels) of a streamed texture.
+    ComPtr<ID3D11Texture2D> CreateStreamedTexture(
+        _In_ ID3D11Device* device,
+        const StreamedTexture& entry,
+        uint32_t topMip,
+        _In_opt_ const D3D11_SUBRESOURCE_DATA* initData)
+    {
+        D3D11_TEXTURE2D_DESC desc = {};
+        desc.Width = std::max(entry.desc.width >> topMip, 1u);
+        desc.Height = std::max(entry.desc.height >> topMip, 1u);
+        desc.MipLevels = entry.desc.mipLevels - topMip;
+        desc.ArraySize = entry.desc.arraySize;
+        desc.Format = entry.format;
+        desc.SampleDesc.Count = 1;
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        desc.MiscFlags = entry.desc.isCubeMap ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0u;
+
+        ComPtr<ID3D11Texture2D> texture;
+        ThrowIfFailed(device->CreateTexture2D(&desc, initData, texture.GetAddressOf()));
+
+        SetDebugObjectName(texture.Get(), "TextureStreamer");
+
+        return texture;
+    }
+
+
+    // Copies the levels of the current texture that the new one also holds.
+    void CopyResidentLevels(
+        _In_ ID3D11DeviceContext* deviceContext,
+        const StreamedTexture& entry,
+        _In_ ID3D11Resource* dest,
+        uint32_t destMip)
+    {
+        const uint32_t mipLevels = entry.desc.mipLevels;
+        const uint32_t firstLevel = std::max(destMip, entry.residentMip);
+
+        for (UINT item = 0; item < entry.desc.arraySize; ++item)
+        {
+            for (uint32_t level = firstLevel; level < mipLevels; ++level)
+            {
+                deviceContext->CopySubresourceRegion(
+                    dest, D3D11CalcSubresource(level - destMip, item, mipLevels - destMip),
+                    0, 0, 0,
+                    entry.texture.Get(), D3D11CalcSubresource(level - entry.residentMip, item, mipLevels - entry.residentMip),
+                    nullptr);
+            }
+        }
+    }
+}
+
+
+//======================================================================================
+// TextureStreamer
+//======================================================================================
+
+class TextureStreamer::Impl
+{
+public:
+    Impl(_In_ ID3D11Device* device, size_t budget, uint32_t mipTailSize) :
+        mDevice(device),
+        mBudget(budget),
+        mMipTailSize(std::max(mipTailSize, 1u)),
+        mNextHandle(1),
+        mEvictions(0),
+        mCompletedCount(0),
+        mFailedCount(0),
+        mTotalLatency(0),
+        mMaxLatency(0),
+        mShutdown(false)
+    {
+        if (!device)
+            throw std::invalid_argument("Direct3D device is null");
+
+        mThread = std::thread(&Impl::Worker, this);
+    }
+
+    Impl(Impl&&) = delete;
+    Impl& operator= (Impl&&) = delete;
+
+    Impl(Impl const&) = delete;
+    Impl& operator= (Impl const&) = delete;
+
+    ~Impl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mShutdown = true;
+        }
+        mCondition.notify_all();
+
+        mThread.join();
+    }
+
+    Handle Load(_In_z_ const wchar_t* fileName, DDS_LOADER_FLAGS loadFlags)
+    {
+        if (!fileName)
+            throw std::invalid_argument("File name is null");
+
+        auto entry = std::make_shared<StreamedTexture>();
+
+        HRESULT hr = entry->file.Open(fileName);
+        if (FAILED(hr))
+        {
+            DebugTrace("ERROR: TextureStreamer failed (%08X) to open '%ls'\n",
+                static_cast<unsigned int>(hr), fileName);
+            throw std::runtime_error("TextureStreamer::Load");
+        }
+
+        const uint8_t* ddsData = entry->file.GetData();
+        const size_t ddsDataSize = entry->file.GetSize();
+
+        ThrowIfFailed(ParseDDS(ddsData, ddsDataSize, &entry->desc));
+
+        const auto& desc = entry->desc;
+
+        entry->format = desc.format;
+        if (loadFlags & DDS_LOADER_FORCE_SRGB)
+        {
+            entry->format = MakeSRGB(entry->format);
+        }
+        else if (loadFlags & DDS_LOADER_IGNORE_SRGB)
+        {
+            entry->format = MakeLinear(entry->format);
+        }
+
+        entry->priority = 0.f;
+        entry->tailMip = GetTailMip(*entry);
+
+        if (!entry->tailMip)
+        {
+            // Nothing to stream, so load it whole and let go of the file.
+            hr = CreateDDSTextureFromMemoryEx(mDevice.Get(), ddsData, ddsDataSize, 0,
+                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+                static_cast<DDS_LOADER_FLAGS>(loadFlags & ~DDS_LOADER_MEMORY_MAPPED),
+                entry->texture.GetAddressOf(), entry->view.GetAddressOf());
+            if (FAILED(hr))
+            {
+                DebugTrace("ERROR: TextureStreamer failed (%08X) to create '%ls'\n",
+                    static_cast<unsigned int>(hr), fileName);
+                throw std::runtime_error("TextureStreamer::Load");
+            }
+
+            entry->levelBytes.assign(desc.mipLevels, 0);
+            entry->levelBytes[0] = ddsDataSize - desc.dataOffset;
+            entry->residentMip = entry->requestedMip = 0;
+            entry->file.Close();
+        }
+        else
+        {
+            if (desc.mipLevels > D3D11_REQ_MIP_LEVELS
+                || desc.arraySize > D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION
+                || desc.width > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION
+                || desc.height > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+            {
+                DebugTrace("ERROR: Resource dimensions too large for DirectX 11 (2D: array %u, size %u by %u)\n", desc.arraySize, desc.width, desc.height);
+                throw std::runtime_error("TextureStreamer::Load");
+            }
+
+            entry->subresources.resize(desc.subresourceCount);
+            ThrowIfFailed(ParseDDS(ddsData, ddsDataSize, &entry->desc, entry->subresources.data(), entry->subresources.size()));
+
+            entry->levelBytes.assign(desc.mipLevels, 0);
+            for (size_t item = 0; item < desc.arraySize; ++item)
+            {
+                for (uint32_t level = 0; level < desc.mipLevels; ++level)
+                {
+                    entry->levelBytes[level] += entry->GetSubresource(item, level).size;
+                }
+            }
+
+            // The tail is small, so it comes straight from the mapping.
+            const uint32_t levels = desc.mipLevels - entry->tailMip;
+            std::vector<D3D11_SUBRESOURCE_DATA> initData(size_t(levels) * desc.arraySize);
+
+            for (size_t item = 0; item < desc.arraySize; ++item)
+            {
+                for (uint32_t level = 0; level < levels; ++level)
+                {
+                    const auto& sub = entry->GetSubresource(item, entry->tailMip + level);
+
+                    auto& init = initData[item * levels + level];
+                    init.pSysMem = ddsData + sub.offset;
+                    init.SysMemPitch = static_cast<UINT>(sub.rowPitch);
+                    init.SysMemSlicePitch = static_cast<UINT>(sub.slicePitch);
+                }
+            }
+
+            auto texture = CreateStreamedTexture(mDevice.Get(), *entry, entry->tailMip, initData.data());
+            CreateShaderResourceView(mDevice.Get(), *entry, texture.Get(), entry->view.ReleaseAndGetAddressOf());
+
+            entry->texture = texture;
+            entry->residentMip = entry->requestedMip = entry->tailMip;
+        }
+
+        const Handle handle = mNextHandle++;
+        mTextures[handle] = std::move(entry);
+        return handle;
+    }
+
+    void Unload(Handle handle) noexcept
+    {
+        // A read in flight keeps its texture alive and is dropped when it completes.
+        mTextures.erase(handle);
+    }
+
+    void SetPriority(Handle handle, float priority) noexcept
+    {
+        auto it = mTextures.find(handle);
+        if (it != mTextures.end())
+        {
+            it->second->priority = priority;
+        }
+    }
+
+    void Update(_In_ ID3D11DeviceContext* deviceContext)
+    {
+        if (!deviceContext)
+            throw std::invalid_argument("Direct3D device context is null");
+
+        std::vector<std::unique_ptr<StreamRequest>> completed;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            completed.swap(mCompleted);
+
+            // Re-rank reads that have not started yet.
+            for (auto& it : mPending)
+            {
+                auto entry = mTextures.find(it->handle);
+                if (entry != mTextures.end())
+                {
+                    it->priority = entry->second->priority;
+                }
+            }
+        }
+
+        for (auto& it : completed)
+        {
+            Upload(deviceContext, *it);
+        }
+
+        Schedule(deviceContext);
+    }
+
+    ID3D11ShaderResourceView* GetView(Handle handle) const noexcept
+    {
+        auto it = mTextures.find(handle);
+        return (it != mTextures.end()) ? it->second->view.Get() : nullptr;
+    }
+
+    uint32_t GetResidentMip(Handle handle) const noexcept
+    {
+        auto it = mTextures.find(handle);
+        return (it != mTextures.end()) ? it->second->residentMip : 0;
+    }
+
+    void SetBudget(size_t bytes) noexcept
+    {
+        mBudget = bytes;
+    }
+
+    Statistics GetStatistics() const noexcept
+    {
+        Statistics stats = {};
+        stats.textures = mTextures.size();
+        stats.budget = mBudget;
+        stats.completedRequests = mCompletedCount;
+        stats.failedRequests = mFailedCount;
+        stats.evictions = mEvictions;
+        stats.averageLatency = mCompletedCount ? (mTotalLatency / double(mCompletedCount)) : 0.0;
+        stats.maxLatency = mMaxLatency;
+
+        for (const auto& it : mTextures)
+        {
+            stats.residentBytes += it.second->GetResidentBytes();
+
+            if (it.second->requestedMip != it.second->residentMip)
+                ++stats.pendingRequests;
+        }
+
+        return stats;
+    }
+
+private:
+    // Most detailed level that still fits within the tail size, or 0 if the texture is not streamed.
+    uint32_t GetTailMip(const StreamedTexture& entry) const noexcept
+    {
+        const auto& desc = entry.desc;
+
+        if (desc.dimension != DDS_TEXTURE_DIMENSION_2D || desc.mipLevels <= 1)
+            return 0;
+
+        uint32_t tailMip = 0;
+        while (tailMip + 1 < desc.mipLevels
+            && std::max(desc.width >> tailMip, desc.height >> tailMip) > mMipTailSize)
+        {
+            ++tailMip;
+        }
+
+        while (tailMip > 0 && !entry.IsValidTopMip(tailMip))
+        {
+            --tailMip;
+        }
+
+        return tailMip;
+    }
+
+    void Upload(_In_ ID3D11DeviceContext* deviceContext, StreamRequest& request)
+    {
+        auto it = mTextures.find(request.handle);
+        if (it == mTextures.end() || it->second != request.texture)
+            return;
+
+        auto& entry = *it->second;
+        entry.requestedMip = entry.residentMip;
+
+        if (request.failed)
+        {
+            // Keep what is resident and hold off asking again, rather than re-reading every Update.
+            ++mFailedCount;
+            entry.retryTime = Clock::now() + c_retryDelay * (1u << std::min(entry.failures, c_maxRetryShift));
+            ++entry.failures;
+            return;
+        }
+
+        assert(entry.residentMip == request.lastMip);
+
+        auto texture = CreateStreamedTexture(mDevice.Get(), entry, request.firstMip, nullptr);
+
+        CopyResidentLevels(deviceContext, entry, texture.Get(), request.firstMip);
+
+        const uint32_t levels = entry.desc.mipLevels - request.firstMip;
+
+        for (UINT item = 0; item < entry.desc.arraySize; ++item)
+        {
+            const size_t base = entry.GetSubresource(item, request.firstMip).offset;
+
+            for (uint32_t level = request.firstMip; level < request.lastMip; ++level)
+            {
+                const auto& sub = entry.GetSubresource(item, level);
+
+                deviceContext->UpdateSubresource(texture.Get(),
+                    D3D11CalcSubresource(level - request.firstMip, item, levels),
+                    nullptr,
+                    request.data.data() + request.itemOffsets[item] + (sub.offset - base),
+                    static_cast<UINT>(sub.rowPitch), static_cast<UINT>(sub.slicePitch));
+            }
+        }
+
+        ComPtr<ID3D11ShaderResourceView> view;
+        CreateShaderResourceView(mDevice.Get(), entry, texture.Get(), view.GetAddressOf());
+
+        entry.texture = texture;
+        entry.view = view;
+        entry.residentMip = entry.requestedMip = request.firstMip;
+        entry.failures = 0;
+
+        const double latency = std::chrono::duration<double>(Clock::now() - request.issued).count();
+        ++mCompletedCount;
+        mTotalLatency += latency;
+        mMaxLatency = std::max(mMaxLatency, latency);
+    }
+
+    void Shrink(_In_ ID3D11DeviceContext* deviceContext, StreamedTexture& entry, uint32_t topMip)
+    {
+        auto texture = CreateStreamedTexture(mDevice.Get(), entry, topMip, nullptr);
+
+        CopyResidentLevels(deviceContext, entry, texture.Get(), topMip);
+
+        ComPtr<ID3D11ShaderResourceView> view;
+        CreateShaderResourceView(mDevice.Get(), entry, texture.Get(), view.GetAddressOf());
+
+        entry.texture = texture;
+        entry.view = view;
+        entry.residentMip = entry.requestedMip = topMip;
+
+        ++mEvictions;
+    }
+
+    void Schedule(_In_ ID3D11DeviceContext* deviceContext)
+    {
+        std::vector<StreamedTexture*> entries;
+        std::vector<TextureStreamingState> states;
+        std::vector<Handle> handles;
+
+        entries.reserve(mTextures.size());
+        states.reserve(mTextures.size());
+        handles.reserve(mTextures.size());
+
+        for (auto& it : mTextures)
+        {
+            auto& entry = *it.second;
+
+            TextureStreamingState state = {};
+            state.levelBytes = entry.levelBytes.data();
+            state.mipLevels = entry.desc.mipLevels;
+            state.tailMip = entry.tailMip;
+            state.maxDimension = std::max(entry.desc.width, entry.desc.height);
+            state.priority = entry.priority;
+
+            entries.push_back(&entry);
+            states.push_back(state);
+            handles.push_back(it.first);
+        }
+
+        ScheduleTextureStreaming(states.data(), states.size(), mBudget);
+
+        bool queued = false;
+        const auto now = Clock::now();
+
+        for (size_t j = 0; j < entries.size(); ++j)
+        {
+            auto& entry = *entries[j];
+
+            // One read or resize at a time per texture.
+            if (entry.requestedMip != entry.residentMip)
+                continue;
+
+            uint32_t target = states[j].targetMip;
+
+            if (target > entry.residentMip)
+            {
+                // Keep more rather than less if the level asked for can't be the top one.
+                while (target > entry.residentMip && !entry.IsValidTopMip(target))
+                    --target;
+
+                if (target > entry.residentMip)
+                {
+                    Shrink(deviceContext, entry, target);
+                }
+            }
+            else if (target < entry.residentMip && now >= entry.retryTime)
+            {
+                while (target > 0 && !entry.IsValidTopMip(target))
+                    --target;
+
+                auto request = std::make_unique<StreamRequest>();
+                request->texture = mTextures[handles[j]];
+                request->handle = handles[j];
+                request->firstMip = target;
+                request->lastMip = entry.residentMip;
+                request->priority = entry.priority;
+                request->issued = Clock::now();
+                request->failed = false;
+
+                entry.requestedMip = target;
+
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mPending.emplace_back(std::move(request));
+                }
+                queued = true;
+            }
+        }
+
+        if (queued)
+        {
+            mCondition.notify_one();
+        }
+    }
+
+    // Copies the requested levels out of the mapping, so the page faults land on this
+    // thread rather than on the one calling Update.
+    static void Read(StreamRequest& request)
+    {
+        const auto& entry = *request.texture;
+        const uint8_t* ddsData = entry.file.GetData();
+
+        try
+        {
+            size_t total = 0;
+            request.itemOffsets.resize(entry.desc.arraySize);
+
+            for (size_t item = 0; item < entry.desc.arraySize; ++item)
+            {
+                const auto& first = entry.GetSubresource(item, request.firstMip);
+                const auto& last = entry.GetSubresource(item, request.lastMip - 1);
+
+                request.itemOffsets[item] = total;
+                total += last.offset + last.size - first.offset;
+            }
+
+            request.data.resize(total);
+
+            for (size_t item = 0; item < entry.desc.arraySize; ++item)
+            {
+                const auto& first = entry.GetSubresource(item, request.firstMip);
+                const auto& last = entry.GetSubresource(item, request.lastMip - 1);
+
+                memcpy(request.data.data() + request.itemOffsets[item],
+                    ddsData + first.offset,
+                    last.offset + last.size - first.offset);
+            }
+        }
+        catch (...)
+        {
+            request.failed = true;
+            request.data.clear();
+        }
+    }
+
+    void Worker()
+    {
+        for (;;)
+        {
+            std::unique_ptr<StreamRequest> request;
+
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this]() { return mShutdown || !mPending.empty(); });
+
+                if (mShutdown)
+                    return;
+
+                // Highest priority first, then the order they were queued.
+                auto it = std::max_element(mPending.begin(), mPending.end(),
+                    [](const std::unique_ptr<StreamRequest>& a, const std::unique_ptr<StreamRequest>& b)
+                    {
+                        return a->priority < b->priority;
+                    });
+
+                request = std::move(*it);
+                mPending.erase(it);
+            }
+
+            Read(*request);
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mCompleted.emplace_back(std::move(request));
+            }
+        }
+    }
+
+    ComPtr<ID3D11Device>                                    mDevice;
+    size_t                                                  mBudget;
+    uint32_t                                                mMipTailSize;
+    Handle                                                  mNextHandle;
+    std::unordered_map<Handle, std::shared_ptr<StreamedTexture>> mTextures;
+
+    size_t                                                  mEvictions;
+    size_t                                                  mCompletedCount;
+    size_t                                                  mFailedCount;
+    double                                                  mTotalLatency;
+    double                                                  mMaxLatency;
+
+    // Shared with the worker thread.
+    std::mutex                                              mMutex;
+    std::condition_variable                                 mCondition;
+    std::vector<std::unique_ptr<StreamRequest>>             mPending;
+    std::vector<std::unique_ptr<StreamRequest>>             mCompleted;
+    bool                                                    mShutdown;
+    std::thread                                             mThread;
+};
+
+
+// Public constructor.
+_Use_decl_annotations_
+TextureStreamer::TextureStreamer(ID3D11Device* device, size_t budget, uint32_t mipTailSize)
+    : pImpl(std::make_unique<Impl>(device, budget, mipTailSize))
+{
+}
+
+
+// Move constructor.
+TextureStreamer::TextureStreamer(TextureStreamer&&) noexcept = default;
+TextureStreamer& TextureStreamer::operator= (TextureStreamer&&) noexcept = default;
+TextureStreamer::~TextureStreamer() = default;
+
+
+_Use_decl_annotations_
+TextureStreamer::Handle TextureStreamer::Load(const wchar_t* fileName, DDS_LOADER_FLAGS loadFlags)
+{
+    return pImpl->Load(fileName, loadFlags);
+}
+
+
+void TextureStreamer::Unload(Handle texture) noexcept
+{
+    pImpl->Unload(texture);
+}
+
+
+void TextureStreamer::SetPriority(Handle texture, float priority) noexcept
+{
+    pImpl->SetPriority(texture, priority);
+}
+
+
+_Use_decl_annotations_
+void TextureStreamer::Update(ID3D11DeviceContext* deviceContext)
+{
+    pImpl->Update(deviceContext);
+}
+
+
+ID3D11ShaderResourceView* TextureStreamer::GetView(Handle texture) const noexcept
+{
+    return pImpl->GetView(texture);
+}
+
+
+uint32_t TextureStreamer::GetResidentMip(Handle texture) const noexcept
+{
+    return pImpl->GetResidentMip(texture);
+}
+
+
+void TextureStreamer::SetBudget(size_t bytes) noexcept
+{
+    pImpl->SetBudget(bytes);
+}
+
+
+TextureStreamer::Statistics TextureStreamer::GetStatistics() const noexcept
+{
+    return pImpl->GetStatistics();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Adapters for /Zc:wchar_t- clients
+
+#if defined(_MSC_VER) && !defined(_NATIVE_WCHAR_T_DEFINED)
+
+_Use_decl_annotations_
+TextureStreamer::Handle TextureStreamer::Load(const __wchar_t* fileName, DDS_LOADER_FLAGS loadFlags)
+{
+    return Load(reinterpret_cast<const unsigned short*>(fileName), loadFlags);
+}
+
+#endif // !_NATIVE_WCHAR_T_DEFINED
@@ -0,0 +1,93 @@
+//--------------------------------------------------------------------------------------
+// File: TextureStreamingScheduler.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <sal.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+
+namespace DirectX
+{
+    // What the scheduler needs to know about one streamed texture. Kept free of any
+    // Direct3D types so the residency decisions can be exercised without a device.
+    struct TextureStreamingState
+    {
+        const size_t*   levelBytes;     // Size of each mip level, summed over all array slices
+        uint32_t        mipLevels;
+        uint32_t        tailMip;        // Most detailed level of the always-resident mip tail
+        uint32_t        maxDimension;   // Largest of the level 0 width and height
+        float           priority;       // Caller supplied on-screen size in pixels, 0 if unseen
+        uint32_t        targetMip;      // Output: most detailed level that should be resident
+    };
+
+    // Returns the most detailed level worth having for a texture drawn 'priority' pixels
+    // across; finer levels would only be minified away.
+    inline uint32_t GetStreamingDesiredMip(const TextureStreamingState& state) noexcept
+    {
+        if (!(state.priority > 0.f))
+            return state.tailMip;
+
+        if (state.priority >= float(state.maxDimension))
+            return 0;
+
+        const auto mip = static_cast<uint32_t>(std::floor(std::log2(float(state.maxDimension) / state.priority)));
+        return std::min(mip, state.tailMip);
+    }
+
+    // Sets targetMip for every texture: the level each one's priority asks for, then with
+    // a non-zero budget, top levels dropped from the lowest priority textures first until
+    // the total fits. The mip tails are never dropped, so they can exceed the budget alone.
+    inline void ScheduleTextureStreaming(
+        _Inout_updates_(count) TextureStreamingState* states,
+        size_t count,
+        size_t budget)
+    {
+        uint64_t total = 0;
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            auto& state = states[j];
+            state.targetMip = GetStreamingDesiredMip(state);
+
+            for (uint32_t level = state.targetMip; level < state.mipLevels; ++level)
+            {
+                total += state.levelBytes[level];
+            }
+        }
+
+        if (!budget || total <= budget)
+            return;
+
+        std::vector<size_t> order(count);
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(order.begin(), order.end(),
+            [states](size_t a, size_t b) { return states[a].priority < states[b].priority; });
+
+        for (auto index : order)
+        {
+            auto& state = states[index];
+
+            while (state.targetMip < state.tailMip && total > budget)
+            {
+                total -= state.levelBytes[state.targetMip];
+                ++state.targetMip;
+            }
+
+            if (total <= budget)
+                break;
+        }
+    }
+}
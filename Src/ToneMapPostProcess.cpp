@@ -15,6 +15,7 @@
 #include "AlignedNew.h"
 #include "DemandCreate.h"
 #include "SharedResourcePool.h"
+#include "StateFilter.h"
 
 using namespace DirectX;
 
@@ -233,8 +234,8 @@ namespace
 
     protected:
         ComPtr<ID3D11Device>        mDevice;
-        ComPtr<ID3D11VertexShader>  mVertexShader;
-        ComPtr<ID3D11PixelShader>   mPixelShaders[PixelShaderCount];
+        AtomicComPtr<ID3D11VertexShader>  mVertexShader;
+        AtomicComPtr<ID3D11PixelShader>   mPixelShaders[PixelShaderCount];
         std::mutex                  mMutex;
     };
 }
@@ -306,24 +307,26 @@ void ToneMapPostProcess::Impl::Process(
     _In_ ID3D11DeviceContext* deviceContext,
     const std::function<void __cdecl()>& setCustomState)
 {
+    StateFilter filter(deviceContext);
+
     // Set the texture.
     ID3D11ShaderResourceView* textures[1] = { hdrTexture.Get() };
-    deviceContext->PSSetShaderResources(0, 1, textures);
+    filter.PSSetShaderResources(0, 1, textures);
 
     auto sampler = mDeviceResources->stateObjects.PointClamp();
-    deviceContext->PSSetSamplers(0, 1, &sampler);
+    filter.PSSetSamplers(0, 1, &sampler);
 
     // Set state objects.
-    deviceContext->OMSetBlendState(mDeviceResources->stateObjects.Opaque(), nullptr, 0xffffffff);
-    deviceContext->OMSetDepthStencilState(mDeviceResources->stateObjects.DepthNone(), 0);
-    deviceContext->RSSetState(mDeviceResources->stateObjects.CullNone());
+    filter.OMSetBlendState(mDeviceResources->stateObjects.Opaque(), nullptr, 0xffffffff);
+    filter.OMSetDepthStencilState(mDeviceResources->stateObjects.DepthNone(), 0);
+    filter.RSSetState(mDeviceResources->stateObjects.CullNone());
 
     // Set shaders.
     auto vertexShader = mDeviceResources->GetVertexShader();
     auto pixelShader = mDeviceResources->GetPixelShader(GetCurrentShaderPermutation());
 
-    deviceContext->VSSetShader(vertexShader, nullptr, 0);
-    deviceContext->PSSetShader(pixelShader, nullptr, 0);
+    filter.VSSetShader(vertexShader, nullptr, 0);
+    filter.PSSetShader(pixelShader, nullptr, 0);
 
     // Set constants.
     if (mDirtyFlags & Dirty_Parameters)
@@ -354,17 +357,18 @@ void ToneMapPostProcess::Impl::Process(
     // Set the constant buffer.
     auto buffer = mConstantBuffer.GetBuffer();
 
-    deviceContext->PSSetConstantBuffers(0, 1, &buffer);
+    filter.PSSetConstantBuffers(0, 1, &buffer);
 #endif
 
     if (setCustomState)
     {
         setCustomState();
+        filter.Invalidate();
     }
 
     // Draw quad.
-    deviceContext->IASetInputLayout(nullptr);
-    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    filter.IASetInputLayout(nullptr);
+    filter.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
     deviceContext->Draw(3, 0);
 }
@@ -0,0 +1,219 @@
+//--------------------------------------------------------------------------------------
+// File: VertexQuantization.h
+//
+// Encoders used by ModelLoader_QuantizeVertices to re-encode loaded vertex streams into
+// compact formats the input assembler expands in hardware:
+//
+//      normals and tangents    R10G10B10A2_UNORM, biased (x * 0.5 + 0.5)
+//      texture coordinates     R16G16_UNORM or R16G16_FLOAT when within the error bound
+//
+// The decoders mirror the input assembler's expansion, so the error bounds can be checked
+// on the CPU.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+
+namespace DirectX
+{
+    namespace VertexQuantization
+    {
+        // Largest texture coordinate error accepted for a 16-bit encoding (a quarter texel at 1024).
+        constexpr float c_MaxTexCoordError = 1.f / 4096.f;
+
+        // Largest angle in radians between a unit vector and its decoded 10:10:10 encoding. Each
+        // component is rounded to the nearest of 1023 steps over [-1,1], so the error vector is at
+        // most sqrt(3) / 1023 long, about 0.097 degrees.
+        constexpr float c_MaxUnitVectorError = 0.0017f;
+
+        enum class TexCoordEncoding : uint32_t
+        {
+            UNorm16 = 0,    // R16G16_UNORM
+            Float16,        // R16G16_FLOAT
+            Float32,        // R32G32_FLOAT (left as-is)
+        };
+
+        inline size_t GetTexCoordSize(TexCoordEncoding encoding) noexcept
+        {
+            return (encoding == TexCoordEncoding::Float32) ? sizeof(XMFLOAT2) : sizeof(uint32_t);
+        }
+
+        // Packs a direction as biased 10:10:10 with the sign of w in the 2-bit alpha channel.
+        // Components are rounded to nearest, which is what c_MaxUnitVectorError assumes.
+        inline uint32_t XM_CALLCONV EncodeUnitVector(FXMVECTOR v, float w = 1.f) noexcept
+        {
+            static const XMVECTORF32 s_scale = { { { 1023.f, 1023.f, 1023.f, 3.f } } };
+
+            XMVECTOR n = XMVector3Normalize(v);
+
+            // Degenerate input normalizes to NaN; encode as zero length in biased space.
+            n = XMVectorSelect(n, g_XMZero, XMVectorIsNaN(n));
+
+            n = XMVectorMultiplyAdd(n, g_XMOneHalf, g_XMOneHalf);
+            n = XMVectorSetW(n, (w < 0.f) ? 0.f : 1.f);
+            n = XMVectorRound(XMVectorMultiply(XMVectorSaturate(n), s_scale));
+
+            XMUINT4 packed;
+            XMStoreUInt4(&packed, n);
+            return packed.x | (packed.y << 10) | (packed.z << 20) | (packed.w << 30);
+        }
+
+        // Expands EncodeUnitVector's output as the input assembler does, with w of +1 or -1.
+        inline XMVECTOR XM_CALLCONV DecodeUnitVector(uint32_t packed) noexcept
+        {
+            const XMVECTOR n = XMVectorSet(
+                float(packed & 0x3FF) / 1023.f,
+                float((packed >> 10) & 0x3FF) / 1023.f,
+                float((packed >> 20) & 0x3FF) / 1023.f,
+                0.f);
+
+            return XMVectorSetW(XMVectorMultiplyAdd(n, g_XMTwo, g_XMNegativeOne), (packed >> 30) ? 1.f : -1.f);
+        }
+
+        // Reports the most compact encoding whose round-trip error stays within maxError
+        // for every texture coordinate of the stream.
+        inline TexCoordEncoding ChooseTexCoordEncoding(
+            _In_reads_bytes_(stride * count) const uint8_t* texcoords, size_t stride, size_t count,
+            float maxError = c_MaxTexCoordError) noexcept
+        {
+            bool unorm = true;
+            bool half = true;
+
+            const XMVECTOR tolerance = XMVectorReplicate(maxError);
+
+            for (size_t j = 0; j < count && (unorm || half); ++j)
+            {
+                const XMVECTOR t = XMLoadFloat2(reinterpret_cast<const XMFLOAT2*>(texcoords + j * stride));
+
+                if (unorm)
+                {
+                    PackedVector::XMUSHORTN2 u;
+                    PackedVector::XMStoreUShortN2(&u, t);
+
+                    if (!XMVector2InBounds(XMVectorSubtract(t, g_XMOneHalf), g_XMOneHalf)
+                        || !XMVector2NearEqual(PackedVector::XMLoadUShortN2(&u), t, tolerance))
+                    {
+                        unorm = false;
+                    }
+                }
+
+                if (half)
+                {
+                    PackedVector::XMHALF2 h;
+                    PackedVector::XMStoreHalf2(&h, t);
+
+                    if (!XMVector2NearEqual(PackedVector::XMLoadHalf2(&h), t, tolerance))
+                    {
+                        half = false;
+                    }
+                }
+            }
+
+            // R16G16_UNORM is more accurate than half in [0,1], so it wins whenever it fits.
+            if (unorm)
+                return TexCoordEncoding::UNorm16;
+
+            return half ? TexCoordEncoding::Float16 : TexCoordEncoding::Float32;
+        }
+
+        // Writes one texture coordinate in the given encoding (GetTexCoordSize bytes).
+        inline void XM_CALLCONV EncodeTexCoord(FXMVECTOR t, TexCoordEncoding encoding, _Out_writes_bytes_(8) uint8_t* dest) noexcept
+        {
+            switch (encoding)
+            {
+                case TexCoordEncoding::UNorm16:
+                    PackedVector::XMStoreUShortN2(reinterpret_cast<PackedVector::XMUSHORTN2*>(dest), t);
+                    break;
+
+                case TexCoordEncoding::Float16:
+                    PackedVector::XMStoreHalf2(reinterpret_cast<PackedVector::XMHALF2*>(dest), t);
+                    break;
+
+                default:
+                    XMStoreFloat2(reinterpret_cast<XMFLOAT2*>(dest), t);
+                    break;
+            }
+        }
+
+        // Reads back one texture coordinate written by EncodeTexCoord.
+        inline XMVECTOR XM_CALLCONV DecodeTexCoord(_In_reads_bytes_(8) const uint8_t* src, TexCoordEncoding encoding) noexcept
+        {
+            switch (encoding)
+            {
+                case TexCoordEncoding::UNorm16:
+                    return PackedVector::XMLoadUShortN2(reinterpret_cast<const PackedVector::XMUSHORTN2*>(src));
+
+                case TexCoordEncoding::Float16:
+                    return PackedVector::XMLoadHalf2(reinterpret_cast<const PackedVector::XMHALF2*>(src));
+
+                default:
+                    return XMLoadFloat2(reinterpret_cast<const XMFLOAT2*>(src));
+            }
+        }
+
+        //------------------------------------------------------------------------------
+        // Whole vertices, as re-encoded by the .CMO loader. The source is the layout of
+        // VertexPositionNormalTangentColorTexture, optionally followed by the RGBA8 blend
+        // indices and weights of the Skinning variant:
+        //
+        //      float3 position, float3 normal, float4 tangent, RGBA8 color, float2 texcoord
+        //
+        // The compact layout keeps the position, packs the normal and tangent, and copies the
+        // color and skinning data:
+        //
+        //      float3 position, biased 10:10:10:2 normal and tangent, RGBA8 color,
+        //      16-bit or 32-bit texcoord, then the RGBA8 skinning indices and weights
+        constexpr size_t c_SourceNormalOffset = 12;
+        constexpr size_t c_SourceTangentOffset = 24;
+        constexpr size_t c_SourceColorOffset = 40;
+        constexpr size_t c_SourceTexCoordOffset = 44;
+        constexpr size_t c_SourceSkinningOffset = 52;
+
+        constexpr size_t c_TexCoordOffset = sizeof(XMFLOAT3) + 3 * sizeof(uint32_t);
+
+        inline size_t GetVertexSize(TexCoordEncoding encoding, bool skinning) noexcept
+        {
+            return c_TexCoordOffset + GetTexCoordSize(encoding) + (skinning ? 2 * sizeof(uint32_t) : 0);
+        }
+
+        // Re-encodes one source vertex into GetVertexSize bytes.
+        inline void QuantizeVertex(
+            _In_reads_bytes_(c_SourceSkinningOffset + 8) const uint8_t* src,
+            _Out_writes_bytes_(GetVertexSize(encoding, skinning)) uint8_t* dest,
+            TexCoordEncoding encoding, bool skinning) noexcept
+        {
+            memcpy(dest, src, sizeof(XMFLOAT3));
+
+            XMFLOAT4 tangent;
+            memcpy(&tangent, src + c_SourceTangentOffset, sizeof(XMFLOAT4));
+
+            const uint32_t packed[3] =
+            {
+                EncodeUnitVector(XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(src + c_SourceNormalOffset))),
+                EncodeUnitVector(XMLoadFloat4(&tangent), tangent.w),
+                *reinterpret_cast<const uint32_t*>(src + c_SourceColorOffset),
+            };
+            memcpy(dest + sizeof(XMFLOAT3), packed, sizeof(packed));
+
+            EncodeTexCoord(XMLoadFloat2(reinterpret_cast<const XMFLOAT2*>(src + c_SourceTexCoordOffset)), encoding, dest + c_TexCoordOffset);
+
+            if (skinning)
+            {
+                memcpy(dest + c_TexCoordOffset + GetTexCoordSize(encoding), src + c_SourceSkinningOffset, 2 * sizeof(uint32_t));
+            }
+        }
+    }
+}
@@ -31,6 +31,8 @@
 #include "DirectXHelpers.h"
 #include "PlatformHelpers.h"
 #include "LoaderHelpers.h"
+#include "MipGenerator.h"
+#include "BCEncoder.h"
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -278,6 +280,56 @@ namespace
         return bpp;
     }
 
+    //---------------------------------------------------------------------------------
+    // Decodes the frame in its own layout, then converts and resizes it on the CPU
+    HRESULT CopyConvertedPixels(
+        _In_ IWICBitmapFrameDecode* frame,
+        UINT width,
+        UINT height,
+        PIXEL_LAYOUT srcLayout,
+        uint32_t srcFlags,
+        UINT twidth,
+        UINT theight,
+        PIXEL_LAYOUT destLayout,
+        uint32_t destFlags,
+        bool sRGB,
+        _Out_ uint8_t* dest,
+        size_t rowPitch) noexcept
+    {
+        const uint64_t srcRowBytes = uint64_t(width) * GetPixelLayoutSize(srcLayout);
+        const uint64_t srcBytes = srcRowBytes * uint64_t(height);
+
+        if (srcRowBytes > UINT32_MAX || srcBytes > UINT32_MAX)
+            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+
+        std::unique_ptr<uint8_t[]> pixels(new (std::nothrow) uint8_t[static_cast<size_t>(srcBytes)]);
+        if (!pixels)
+            return E_OUTOFMEMORY;
+
+        HRESULT hr = frame->CopyPixels(nullptr, static_cast<UINT>(srcRowBytes), static_cast<UINT>(srcBytes), pixels.get());
+        if (FAILED(hr))
+            return hr;
+
+        PixelImage src = { pixels.get(), static_cast<size_t>(srcRowBytes), width, height, srcLayout, srcFlags };
+
+        if (twidth == width && theight == height)
+        {
+            return ConvertPixels(src, dest, rowPitch, destLayout, destFlags);
+        }
+
+        // Only filtering cares about the encoding; a float side is linear already
+        if (sRGB && !IsPixelLayoutFloat(srcLayout) && !IsPixelLayoutFloat(destLayout))
+        {
+            src.flags |= PIXEL_SRGB;
+            destFlags |= PIXEL_SRGB;
+        }
+
+        // Lanczos to shrink; MAKE_SQUARE can stretch an axis, where a tent doesn't ring
+        const RESIZE_FILTER filter = (twidth <= width && theight <= height) ? RESIZE_FILTER_LANCZOS : RESIZE_FILTER_LINEAR;
+
+        return ResizePixels(src, dest, rowPitch, twidth, theight, destLayout, destFlags, filter);
+    }
+
     //---------------------------------------------------------------------------------
     HRESULT CreateTextureFromWIC(
         _In_ ID3D11Device* d3dDevice,
@@ -554,6 +606,13 @@ namespace
         if (!temp)
             return E_OUTOFMEMORY;
 
+        // Layouts the CPU converters know skip the WIC format converter and scaler
+        uint32_t srcFlags = 0;
+        uint32_t destFlags = 0;
+        const PIXEL_LAYOUT srcLayout = LoaderHelpers::WICToPixelLayout(pixelFormat, srcFlags);
+        const PIXEL_LAYOUT destLayout = LoaderHelpers::WICToPixelLayout(convertGUID, destFlags);
+        LoaderHelpers::ApplyWICGamma(srcLayout, srcFlags, destLayout, destFlags);
+
         // Load image data
         if (memcmp(&convertGUID, &pixelFormat, sizeof(GUID)) == 0
             && twidth == width
@@ -564,6 +623,15 @@ namespace
             if (FAILED(hr))
                 return hr;
         }
+        else if (srcLayout != PIXEL_LAYOUT_UNKNOWN && destLayout != PIXEL_LAYOUT_UNKNOWN)
+        {
+            hr = CopyConvertedPixels(frame, width, height, srcLayout, srcFlags,
+                twidth, theight, destLayout, destFlags,
+                LoaderHelpers::MakeLinear(format) != format,
+                temp.get(), rowPitch);
+            if (FAILED(hr))
+                return hr;
+        }
         else if (twidth != width || theight != height)
         {
             // Resize
@@ -643,9 +711,32 @@ namespace
                 return hr;
         }
 
+        // Block compression has to be decided first since BC formats can't auto-gen mipmaps
+        DXGI_FORMAT bcFormat = DXGI_FORMAT_UNKNOWN;
+        if (loadFlags & WIC_LOADER_BC_COMPRESS)
+        {
+            if ((twidth % 4) != 0 || (theight % 4) != 0)
+            {
+                DebugTrace("WARNING: WICTextureLoader can't block compress a %u x %u image (must be a multiple of 4)\n", twidth, theight);
+            }
+            else if ((bindFlags & ~static_cast<unsigned int>(D3D11_BIND_SHADER_RESOURCE)) == 0)
+            {
+                bcFormat = GetBCFormat(temp.get(), rowPitch, twidth, theight, format, (loadFlags & WIC_LOADER_BC_RG) != 0);
+                if (bcFormat != DXGI_FORMAT_UNKNOWN)
+                {
+                    UINT bcSupport = 0;
+                    hr = d3dDevice->CheckFormatSupport(bcFormat, &bcSupport);
+                    if (FAILED(hr) || !(bcSupport & D3D11_FORMAT_SUPPORT_TEXTURE2D))
+                    {
+                        bcFormat = DXGI_FORMAT_UNKNOWN;
+                    }
+                }
+            }
+        }
+
         // See if format is supported for auto-gen mipmaps (varies by feature level)
         bool autogen = false;
-        if (d3dContext && textureView) // Must have context and shader-view to auto generate mipmaps
+        if (d3dContext && textureView && bcFormat == DXGI_FORMAT_UNKNOWN) // Must have context and shader-view to auto generate mipmaps
         {
             UINT fmtSupport = 0;
             hr = d3dDevice->CheckFormatSupport(format, &fmtSupport);
@@ -659,11 +750,55 @@ namespace
             }
         }
 
+        // Without autogen, the chain can still be built on the CPU
+        UINT mipLevels = 1;
+        std::unique_ptr<uint8_t[]> mipData;
+        std::unique_ptr<D3D11_SUBRESOURCE_DATA[]> mipInitData;
+        // A compressed texture gets the full chain whenever the caller could have had autogen
+        const bool cpumips = (loadFlags & WIC_LOADER_MIP_CPU)
+            || (bcFormat != DXGI_FORMAT_UNKNOWN && d3dContext && textureView);
+        if (!autogen && cpumips && IsCPUMipFormatSupported(format))
+        {
+            mipLevels = LoaderHelpers::CountMips(twidth, theight);
+
+            mipInitData.reset(new (std::nothrow) D3D11_SUBRESOURCE_DATA[mipLevels]);
+            if (!mipInitData)
+                return E_OUTOFMEMORY;
+
+            // WIC decodes to straight alpha
+            hr = GenerateMipChain(temp.get(), rowPitch, twidth, theight, format, mipLevels,
+                (loadFlags & WIC_LOADER_MIP_KAISER) ? MIP_FILTER_KAISER : MIP_FILTER_BOX,
+                true, mipData, mipInitData.get());
+            if (FAILED(hr))
+                return hr;
+        }
+
+        std::unique_ptr<uint8_t[]> bcData;
+        std::unique_ptr<D3D11_SUBRESOURCE_DATA[]> bcInitData;
+        if (bcFormat != DXGI_FORMAT_UNKNOWN)
+        {
+            bcInitData.reset(new (std::nothrow) D3D11_SUBRESOURCE_DATA[mipLevels]);
+            if (!bcInitData)
+                return E_OUTOFMEMORY;
+
+            const D3D11_SUBRESOURCE_DATA topLevel = { temp.get(), static_cast<UINT>(rowPitch), static_cast<UINT>(imageSize) };
+
+            hr = CompressMipChain((mipInitData) ? mipInitData.get() : &topLevel, mipLevels, twidth, theight,
+                format, bcFormat, (loadFlags & WIC_LOADER_BC_QUALITY) != 0, bcData, bcInitData.get());
+            if (FAILED(hr))
+                return hr;
+
+            // The uncompressed chain isn't needed past this point
+            mipData.reset();
+            mipInitData.reset();
+            format = bcFormat;
+        }
+
         // Create texture
         D3D11_TEXTURE2D_DESC desc = {};
         desc.Width = twidth;
         desc.Height = theight;
-        desc.MipLevels = (autogen) ? 0u : 1u;
+        desc.MipLevels = (autogen) ? 0u : mipLevels;
         desc.ArraySize = 1;
         desc.Format = format;
         desc.SampleDesc.Count = 1;
@@ -684,8 +819,11 @@ namespace
 
         D3D11_SUBRESOURCE_DATA initData = { temp.get(), static_cast<UINT>(rowPitch), static_cast<UINT>(imageSize) };
 
+        const D3D11_SUBRESOURCE_DATA* pInitData = (bcInitData) ? bcInitData.get()
+            : (mipInitData) ? mipInitData.get() : &initData;
+
         ID3D11Texture2D* tex = nullptr;
-        hr = d3dDevice->CreateTexture2D(&desc, (autogen) ? nullptr : &initData, &tex);
+        hr = d3dDevice->CreateTexture2D(&desc, (autogen) ? nullptr : pInitData, &tex);
         if (SUCCEEDED(hr) && tex)
         {
             if (textureView)
@@ -694,7 +832,7 @@ namespace
                 SRVDesc.Format = desc.Format;
 
                 SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-                SRVDesc.Texture2D.MipLevels = (autogen) ? unsigned(-1) : 1u;
+                SRVDesc.Texture2D.MipLevels = (autogen) ? unsigned(-1) : mipLevels;
 
                 hr = d3dDevice->CreateShaderResourceView(tex, &SRVDesc, textureView);
                 if (FAILED(hr))
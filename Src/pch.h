@@ -166,6 +166,8 @@
 #define XM_ALIGNED_STRUCT(x) __declspec(align(x)) struct
 #endif
 
+// Other platforms only build the CPU-only code used by the unit tests
+#ifdef _WIN32
 #pragma warning(push)
 #pragma warning(disable : 4467 4986 5038 5204 5220 6101)
 #ifdef __MINGW32__
@@ -182,6 +184,7 @@
 #else
 #include <OCIdl.h>
 #endif
+#endif // _WIN32
 
 #if (defined(WINAPI_FAMILY) && (WINAPI_FAMILY == WINAPI_FAMILY_APP)) || (defined(_XBOX_ONE) && defined(_TITLE))
 #pragma warning(push)
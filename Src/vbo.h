@@ -28,8 +28,49 @@ namespace VBO
         uint32_t numIndices;
     };
 
+    // Version 2 keeps the same vertex format but adds 32-bit indices, submeshes, and
+    // precomputed bounds. The magic value can't be mistaken for a legacy header since
+    // that many vertices would exceed any legacy file.
+    //
+    //      header_v2_t
+    //      submesh_t[numSubmeshes]
+    //      VertexPositionNormalTexture[numVertices]
+    //      uint16_t or uint32_t[numIndices]
+    constexpr uint32_t V2_MAGIC = 0x324F4256; // "VBO2"
+    constexpr uint32_t V2_VERSION = 2;
+
+    enum INDEX_FORMAT : uint32_t
+    {
+        INDEX_16BIT = 0,
+        INDEX_32BIT = 1,
+    };
+
+    struct header_v2_t
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t numVertices;
+        uint32_t numIndices;
+        uint32_t indexFormat;
+        uint32_t numSubmeshes;
+        float    boundsCenter[3];
+        float    boundsExtents[3];
+    };
+
+    struct submesh_t
+    {
+        uint32_t startIndex;
+        uint32_t indexCount;
+        int32_t  baseVertex;
+        uint32_t reserved;
+        float    boundsCenter[3];
+        float    boundsExtents[3];
+    };
+
 #pragma pack(pop)
 
 } // namespace
 
 static_assert(sizeof(VBO::header_t) == 8, "VBO header size mismatch");
+static_assert(sizeof(VBO::header_v2_t) == 48, "VBO v2 header size mismatch");
+static_assert(sizeof(VBO::submesh_t) == 40, "VBO v2 submesh size mismatch");
@@ -0,0 +1,181 @@
+//--------------------------------------------------------------------------------------
+// File: BCHelpers.h
+//
+// Reference BC1, BC3, BC4, and BC5 decoding, written from the Direct3D block format
+// rules, for the block compression tests and benchmark
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <d3d11_1.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+namespace TestHelpers
+{
+    // Decodes one BC1 color block into 16 RGBA texels, in both the 4 and 3 color modes.
+    inline void DecodeColorBlock(const uint8_t* block, bool forceFourColor, uint8_t texels[16][4])
+    {
+        const uint32_t c0 = uint32_t(block[0]) | (uint32_t(block[1]) << 8);
+        const uint32_t c1 = uint32_t(block[2]) | (uint32_t(block[3]) << 8);
+
+        float palette[4][4] = {};
+        for (int e = 0; e < 2; ++e)
+        {
+            const uint32_t c = e ? c1 : c0;
+            const uint32_t r = (c >> 11) & 0x1f;
+            const uint32_t g = (c >> 5) & 0x3f;
+            const uint32_t b = c & 0x1f;
+            palette[e][0] = float((r << 3) | (r >> 2));
+            palette[e][1] = float((g << 2) | (g >> 4));
+            palette[e][2] = float((b << 3) | (b >> 2));
+            palette[e][3] = 255.f;
+        }
+
+        for (int k = 0; k < 4; ++k)
+        {
+            if (forceFourColor || c0 > c1)
+            {
+                palette[2][k] = (2.f * palette[0][k] + palette[1][k]) / 3.f;
+                palette[3][k] = (palette[0][k] + 2.f * palette[1][k]) / 3.f;
+            }
+            else
+            {
+                palette[2][k] = (palette[0][k] + palette[1][k]) / 2.f;
+                palette[3][k] = 0.f;
+            }
+        }
+
+        uint32_t bits;
+        memcpy(&bits, block + 4, sizeof(bits));
+        for (size_t i = 0; i < 16; ++i)
+        {
+            const float* p = palette[(bits >> (i * 2)) & 3];
+            for (size_t k = 0; k < 4; ++k)
+                texels[i][k] = static_cast<uint8_t>(std::lround(p[k]));
+        }
+    }
+
+    // Decodes one BC4 style block into channel c of 16 RGBA texels.
+    inline void DecodeChannelBlock(const uint8_t* block, size_t c, uint8_t texels[16][4])
+    {
+        const float a0 = block[0];
+        const float a1 = block[1];
+
+        float palette[8] = { a0, a1 };
+        if (block[0] > block[1])
+        {
+            for (int k = 1; k < 7; ++k)
+                palette[k + 1] = ((7 - k) * a0 + k * a1) / 7.f;
+        }
+        else
+        {
+            for (int k = 1; k < 5; ++k)
+                palette[k + 1] = ((5 - k) * a0 + k * a1) / 5.f;
+            palette[6] = 0.f;
+            palette[7] = 255.f;
+        }
+
+        uint64_t bits = 0;
+        for (size_t i = 0; i < 6; ++i)
+            bits |= uint64_t(block[2 + i]) << (i * 8);
+
+        for (size_t i = 0; i < 16; ++i)
+            texels[i][c] = static_cast<uint8_t>(std::lround(palette[(bits >> (i * 3)) & 7]));
+    }
+
+    inline size_t GetBCBlockSize(DXGI_FORMAT bcFormat) noexcept
+    {
+        return (bcFormat == DXGI_FORMAT_BC3_UNORM || bcFormat == DXGI_FORMAT_BC3_UNORM_SRGB || bcFormat == DXGI_FORMAT_BC5_UNORM) ? 16 : 8;
+    }
+
+    // Decodes a level to RGBA; channels a format doesn't store read as 0, alpha as 255.
+    inline std::vector<uint8_t> DecodeBC(const D3D11_SUBRESOURCE_DATA& level, size_t width, size_t height, DXGI_FORMAT bcFormat)
+    {
+        std::vector<uint8_t> image(width * height * 4);
+        const size_t blockSize = GetBCBlockSize(bcFormat);
+
+        for (size_t by = 0; by < (height + 3) / 4; ++by)
+        {
+            for (size_t bx = 0; bx < (width + 3) / 4; ++bx)
+            {
+                const uint8_t* block = static_cast<const uint8_t*>(level.pSysMem) + by * level.SysMemPitch + bx * blockSize;
+
+                uint8_t texels[16][4] = {};
+                for (auto& t : texels)
+                    t[3] = 255;
+
+                switch (bcFormat)
+                {
+                case DXGI_FORMAT_BC1_UNORM:
+                case DXGI_FORMAT_BC1_UNORM_SRGB:
+                    DecodeColorBlock(block, false, texels);
+                    break;
+
+                case DXGI_FORMAT_BC3_UNORM:
+                case DXGI_FORMAT_BC3_UNORM_SRGB:
+                    DecodeColorBlock(block + 8, true, texels);
+                    DecodeChannelBlock(block, 3, texels);
+                    break;
+
+                case DXGI_FORMAT_BC4_UNORM:
+                    DecodeChannelBlock(block, 0, texels);
+                    break;
+
+                case DXGI_FORMAT_BC5_UNORM:
+                    DecodeChannelBlock(block, 0, texels);
+                    DecodeChannelBlock(block + 8, 1, texels);
+                    break;
+
+                default:
+                    break;
+                }
+
+                for (size_t i = 0; i < 16; ++i)
+                {
+                    const size_t x = bx * 4 + (i & 3);
+                    const size_t y = by * 4 + (i >> 2);
+                    if (x < width && y < height)
+                        memcpy(&image[(y * width + x) * 4], texels[i], 4);
+                }
+            }
+        }
+
+        return image;
+    }
+
+    // Sum of squared error over the channels in the mask (bit 0 red ... bit 3 alpha).
+    inline double SquaredError(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, uint32_t mask)
+    {
+        double sum = 0;
+        for (size_t j = 0; j < a.size(); ++j)
+        {
+            if (mask & (1u << (j & 3)))
+            {
+                const double d = double(a[j]) - double(b[j]);
+                sum += d * d;
+            }
+        }
+        return sum;
+    }
+
+    inline double PSNR(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, uint32_t mask)
+    {
+        size_t channels = 0;
+        for (uint32_t c = 0; c < 4; ++c)
+            channels += (mask >> c) & 1;
+
+        const double mse = SquaredError(a, b, mask) / double(a.size() / 4 * channels);
+        return (mse > 0) ? 10.0 * std::log10(255.0 * 255.0 / mse) : 100.0;
+    }
+}
@@ -0,0 +1,245 @@
+//--------------------------------------------------------------------------------------
+// File: DDSHelpers.h
+//
+// Builds DDS files in memory for the texture loading tests and benchmarks
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <dxgiformat.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "PlatformHelpers.h"
+#include "DDS.h"
+#include "TestHelpers.h"
+
+
+namespace TestHelpers
+{
+    struct DDSDesc
+    {
+        DXGI_FORMAT                     format;
+        DirectX::DDS_RESOURCE_DIMENSION dimension;
+        uint32_t                        width;
+        uint32_t                        height;
+        uint32_t                        depth;
+        uint32_t                        arraySize;      // Cubemaps count each set of six faces once
+        uint32_t                        mipLevels;
+        bool                            isCubeMap;
+        bool                            legacyHeader;   // Write a DDS_PIXELFORMAT instead of the DX10 header
+    };
+
+    // Row pitch and row count of one slice, for the formats the tests use.
+    inline void GetSurfaceSize(DXGI_FORMAT format, size_t width, size_t height, size_t& rowPitch, size_t& rowCount)
+    {
+        size_t blockBytes = 0;
+        size_t pixelBytes = 0;
+
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_UNORM:
+        case DXGI_FORMAT_BC4_SNORM:
+            blockBytes = 8;
+            break;
+
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC5_SNORM:
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            blockBytes = 16;
+            break;
+
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            pixelBytes = 16;
+            break;
+
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        case DXGI_FORMAT_R16G16B16A16_UNORM:
+            pixelBytes = 8;
+            break;
+
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_R10G10B10A2_UNORM:
+        case DXGI_FORMAT_R32_FLOAT:
+        case DXGI_FORMAT_R16G16_UNORM:
+            pixelBytes = 4;
+            break;
+
+        case DXGI_FORMAT_B5G6R5_UNORM:
+        case DXGI_FORMAT_R16_UNORM:
+        case DXGI_FORMAT_R8G8_UNORM:
+            pixelBytes = 2;
+            break;
+
+        case DXGI_FORMAT_R8_UNORM:
+        case DXGI_FORMAT_A8_UNORM:
+            pixelBytes = 1;
+            break;
+
+        default:
+            throw std::invalid_argument("Format not supported by the test helpers");
+        }
+
+        if (blockBytes)
+        {
+            rowPitch = std::max<size_t>(1, (width + 3) / 4) * blockBytes;
+            rowCount = std::max<size_t>(1, (height + 3) / 4);
+        }
+        else
+        {
+            rowPitch = width * pixelBytes;
+            rowCount = height;
+        }
+    }
+
+    // Every subresource in file order: by array item (and face), then by mip level.
+    struct DDSSurface
+    {
+        size_t      offset;
+        size_t      rowPitch;
+        size_t      rowCount;
+        size_t      slicePitch;
+        uint32_t    width;
+        uint32_t    height;
+        uint32_t    depth;
+    };
+
+    inline std::vector<DDSSurface> GetSurfaces(const DDSDesc& desc, size_t dataOffset)
+    {
+        std::vector<DDSSurface> surfaces;
+
+        const uint32_t items = desc.arraySize * (desc.isCubeMap ? 6u : 1u);
+        size_t offset = dataOffset;
+        for (uint32_t item = 0; item < items; ++item)
+        {
+            uint32_t w = desc.width;
+            uint32_t h = desc.height;
+            uint32_t d = desc.depth;
+            for (uint32_t level = 0; level < desc.mipLevels; ++level)
+            {
+                DDSSurface s = {};
+                GetSurfaceSize(desc.format, w, h, s.rowPitch, s.rowCount);
+                s.slicePitch = s.rowPitch * s.rowCount;
+                s.offset = offset;
+                s.width = w;
+                s.height = h;
+                s.depth = d;
+                surfaces.push_back(s);
+
+                offset += s.slicePitch * d;
+
+                w = std::max(1u, w / 2);
+                h = std::max(1u, h / 2);
+                d = std::max(1u, d / 2);
+            }
+        }
+
+        return surfaces;
+    }
+
+    inline size_t GetDataOffset(const DDSDesc& desc) noexcept
+    {
+        return sizeof(uint32_t) + sizeof(DirectX::DDS_HEADER) + (desc.legacyHeader ? 0 : sizeof(DirectX::DDS_HEADER_DXT10));
+    }
+
+    // A complete DDS file whose pixel data is noise from the given seed.
+    inline std::vector<uint8_t> MakeDDS(const DDSDesc& desc, uint32_t seed)
+    {
+        using namespace DirectX;
+
+        DDS_HEADER header = {};
+        header.size = sizeof(DDS_HEADER);
+        header.flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_MIPMAP;
+        header.width = desc.width;
+        header.height = desc.height;
+        header.mipMapCount = desc.mipLevels;
+        header.caps = DDS_SURFACE_FLAGS_TEXTURE | ((desc.mipLevels > 1) ? DDS_SURFACE_FLAGS_MIPMAP : 0u);
+
+        if (desc.dimension == DDS_DIMENSION_TEXTURE3D)
+        {
+            header.flags |= DDS_HEADER_FLAGS_VOLUME;
+            header.depth = desc.depth;
+            header.caps2 = DDS_FLAGS_VOLUME;
+        }
+
+        if (desc.isCubeMap)
+        {
+            header.caps |= DDS_SURFACE_FLAGS_CUBEMAP;
+            header.caps2 = DDS_CUBEMAP_ALLFACES;
+        }
+
+        DDS_HEADER_DXT10 ext = {};
+        if (desc.legacyHeader)
+        {
+            if (desc.arraySize != 1 || desc.dimension == DDS_DIMENSION_TEXTURE1D)
+                throw std::invalid_argument("Legacy DDS headers can't describe arrays or 1D textures");
+
+            switch (desc.format)
+            {
+            case DXGI_FORMAT_R8G8B8A8_UNORM: header.ddspf = DDSPF_A8B8G8R8; break;
+            case DXGI_FORMAT_B8G8R8A8_UNORM: header.ddspf = DDSPF_A8R8G8B8; break;
+            case DXGI_FORMAT_B5G6R5_UNORM: header.ddspf = DDSPF_R5G6B5; break;
+            case DXGI_FORMAT_R8_UNORM: header.ddspf = DDSPF_L8; break;
+            case DXGI_FORMAT_BC1_UNORM: header.ddspf = DDSPF_DXT1; break;
+            case DXGI_FORMAT_BC3_UNORM: header.ddspf = DDSPF_DXT5; break;
+            case DXGI_FORMAT_BC4_UNORM: header.ddspf = DDSPF_BC4_UNORM; break;
+            case DXGI_FORMAT_BC5_UNORM: header.ddspf = DDSPF_BC5_UNORM; break;
+            default:
+                throw std::invalid_argument("Format needs the DX10 header");
+            }
+        }
+        else
+        {
+            header.ddspf = DDSPF_DX10;
+            ext.dxgiFormat = desc.format;
+            ext.resourceDimension = desc.dimension;
+            ext.miscFlag = desc.isCubeMap ? DDS_RESOURCE_MISC_TEXTURECUBE : 0u;
+            ext.arraySize = desc.arraySize;
+        }
+
+        const size_t dataOffset = GetDataOffset(desc);
+        const auto surfaces = GetSurfaces(desc, dataOffset);
+        const size_t size = surfaces.back().offset + surfaces.back().slicePitch * surfaces.back().depth;
+
+        std::vector<uint8_t> dds(size);
+        memcpy(dds.data(), &DDS_MAGIC, sizeof(uint32_t));
+        memcpy(dds.data() + sizeof(uint32_t), &header, sizeof(header));
+        if (!desc.legacyHeader)
+        {
+            memcpy(dds.data() + sizeof(uint32_t) + sizeof(header), &ext, sizeof(ext));
+        }
+
+        // Noise with runs of repeated bytes, so compressors have something to find
+        Random rng(seed);
+        for (size_t j = dataOffset; j < size; )
+        {
+            const auto value = static_cast<uint8_t>(rng.Next());
+            const size_t run = (rng.Next(4) == 0) ? 1 + rng.Next(64) : 1;
+            for (size_t k = 0; k < run && j < size; ++k, ++j)
+            {
+                dds[j] = value;
+            }
+        }
+
+        return dds;
+    }
+}
@@ -0,0 +1,254 @@
+//--------------------------------------------------------------------------------------
+// File: DeviceHelpers.h
+//
+// WARP device, texture readback, and temporary file helpers for the tests and
+// benchmarks that load textures
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <d3d11_1.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <wrl/client.h>
+
+#include "DDSHelpers.h"
+
+
+namespace TestHelpers
+{
+    // The tests run on WARP, so they need no GPU and see the same results on every machine.
+    inline HRESULT CreateWarpDevice(_Outptr_ ID3D11Device** device, _Outptr_opt_ ID3D11DeviceContext** context) noexcept
+    {
+        static const D3D_FEATURE_LEVEL s_featureLevels[] =
+        {
+            D3D_FEATURE_LEVEL_11_1,
+            D3D_FEATURE_LEVEL_11_0,
+            D3D_FEATURE_LEVEL_10_1,
+            D3D_FEATURE_LEVEL_10_0,
+        };
+
+        HRESULT hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, 0,
+            s_featureLevels, static_cast<UINT>(std::size(s_featureLevels)),
+            D3D11_SDK_VERSION, device, nullptr, context);
+
+        if (hr == E_INVALIDARG)
+        {
+            // Runtimes without Direct3D 11.1 reject the first level
+            hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, 0,
+                &s_featureLevels[1], static_cast<UINT>(std::size(s_featureLevels) - 1),
+                D3D11_SDK_VERSION, device, nullptr, context);
+        }
+
+        return hr;
+    }
+
+    // Copies every subresource of a texture back to the CPU, in Direct3D subresource order,
+    // with the rows of each packed at their natural pitch as they are in a DDS file.
+    inline HRESULT ReadTexture(
+        _In_ ID3D11Device* device,
+        _In_ ID3D11DeviceContext* context,
+        _In_ ID3D11Resource* resource,
+        std::vector<std::vector<uint8_t>>& subresources)
+    {
+        using Microsoft::WRL::ComPtr;
+
+        subresources.clear();
+
+        D3D11_RESOURCE_DIMENSION dimension = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+        resource->GetType(&dimension);
+
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        UINT width = 0;
+        UINT height = 1;
+        UINT depth = 1;
+        UINT mipLevels = 0;
+        UINT arraySize = 1;
+
+        ComPtr<ID3D11Resource> staging;
+        HRESULT hr = E_UNEXPECTED;
+
+        switch (dimension)
+        {
+        case D3D11_RESOURCE_DIMENSION_TEXTURE1D:
+            {
+                ComPtr<ID3D11Texture1D> texture;
+                hr = resource->QueryInterface(IID_PPV_ARGS(texture.GetAddressOf()));
+                if (FAILED(hr))
+                    return hr;
+
+                D3D11_TEXTURE1D_DESC desc = {};
+                texture->GetDesc(&desc);
+                format = desc.Format;
+                width = desc.Width;
+                mipLevels = desc.MipLevels;
+                arraySize = desc.ArraySize;
+
+                desc.Usage = D3D11_USAGE_STAGING;
+                desc.BindFlags = 0;
+                desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+                desc.MiscFlags = 0;
+
+                ComPtr<ID3D11Texture1D> copy;
+                hr = device->CreateTexture1D(&desc, nullptr, copy.GetAddressOf());
+                staging = copy;
+            }
+            break;
+
+        case D3D11_RESOURCE_DIMENSION_TEXTURE2D:
+            {
+                ComPtr<ID3D11Texture2D> texture;
+                hr = resource->QueryInterface(IID_PPV_ARGS(texture.GetAddressOf()));
+                if (FAILED(hr))
+                    return hr;
+
+                D3D11_TEXTURE2D_DESC desc = {};
+                texture->GetDesc(&desc);
+                format = desc.Format;
+                width = desc.Width;
+                height = desc.Height;
+                mipLevels = desc.MipLevels;
+                arraySize = desc.ArraySize;
+
+                desc.Usage = D3D11_USAGE_STAGING;
+                desc.BindFlags = 0;
+                desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+                desc.MiscFlags &= D3D11_RESOURCE_MISC_TEXTURECUBE;
+
+                ComPtr<ID3D11Texture2D> copy;
+                hr = device->CreateTexture2D(&desc, nullptr, copy.GetAddressOf());
+                staging = copy;
+            }
+            break;
+
+        case D3D11_RESOURCE_DIMENSION_TEXTURE3D:
+            {
+                ComPtr<ID3D11Texture3D> texture;
+                hr = resource->QueryInterface(IID_PPV_ARGS(texture.GetAddressOf()));
+                if (FAILED(hr))
+                    return hr;
+
+                D3D11_TEXTURE3D_DESC desc = {};
+                texture->GetDesc(&desc);
+                format = desc.Format;
+                width = desc.Width;
+                height = desc.Height;
+                depth = desc.Depth;
+                mipLevels = desc.MipLevels;
+
+                desc.Usage = D3D11_USAGE_STAGING;
+                desc.BindFlags = 0;
+                desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+                desc.MiscFlags = 0;
+
+                ComPtr<ID3D11Texture3D> copy;
+                hr = device->CreateTexture3D(&desc, nullptr, copy.GetAddressOf());
+                staging = copy;
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        if (FAILED(hr))
+            return hr;
+
+        context->CopyResource(staging.Get(), resource);
+
+        for (UINT item = 0; item < arraySize; ++item)
+        {
+            UINT w = width;
+            UINT h = height;
+            UINT d = depth;
+            for (UINT level = 0; level < mipLevels; ++level)
+            {
+                size_t rowPitch = 0;
+                size_t rowCount = 0;
+                GetSurfaceSize(format, w, h, rowPitch, rowCount);
+
+                D3D11_MAPPED_SUBRESOURCE mapped = {};
+                hr = context->Map(staging.Get(), D3D11CalcSubresource(level, item, mipLevels), D3D11_MAP_READ, 0, &mapped);
+                if (FAILED(hr))
+                    return hr;
+
+                std::vector<uint8_t> data(rowPitch * rowCount * d);
+                for (UINT z = 0; z < d; ++z)
+                {
+                    for (size_t y = 0; y < rowCount; ++y)
+                    {
+                        memcpy(&data[(z * rowCount + y) * rowPitch],
+                            static_cast<const uint8_t*>(mapped.pData) + z * mapped.DepthPitch + y * mapped.RowPitch,
+                            rowPitch);
+                    }
+                }
+
+                context->Unmap(staging.Get(), D3D11CalcSubresource(level, item, mipLevels));
+
+                subresources.emplace_back(std::move(data));
+
+                w = std::max(1u, w / 2);
+                h = std::max(1u, h / 2);
+                d = std::max(1u, d / 2);
+            }
+        }
+
+        return S_OK;
+    }
+
+    // A file in the temporary directory, deleted when this goes out of scope.
+    class TempFile
+    {
+    public:
+        TempFile(const wchar_t* name, const std::vector<uint8_t>& contents) : TempFile(name, contents.data(), contents.size()) {}
+
+        TempFile(const wchar_t* name, const uint8_t* data, size_t size)
+        {
+            wchar_t path[MAX_PATH] = {};
+            if (!GetTempPathW(MAX_PATH, path))
+                throw std::runtime_error("GetTempPath");
+
+            mPath = path;
+            mPath += L"DirectXTKTest_";
+            mPath += std::to_wstring(GetCurrentProcessId());
+            mPath += L"_";
+            mPath += name;
+
+            FILE* file = nullptr;
+            if (_wfopen_s(&file, mPath.c_str(), L"wb") != 0 || !file)
+                throw std::runtime_error("Can't create temporary file");
+
+            const size_t written = size ? fwrite(data, 1, size, file) : 0;
+            fclose(file);
+
+            if (written != size)
+                throw std::runtime_error("Can't write temporary file");
+        }
+
+        TempFile(TempFile const&) = delete;
+        TempFile& operator= (TempFile const&) = delete;
+
+        ~TempFile()
+        {
+            DeleteFileW(mPath.c_str());
+        }
+
+        const wchar_t* GetPath() const noexcept { return mPath.c_str(); }
+
+    private:
+        std::wstring mPath;
+    };
+}
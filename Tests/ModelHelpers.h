@@ -0,0 +1,183 @@
+//--------------------------------------------------------------------------------------
+// File: ModelHelpers.h
+//
+// Synthetic .CMO files for the model loader tests and benchmarks
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <DirectXMath.h>
+
+
+namespace TestHelpers
+{
+    struct CMOVertex
+    {
+        DirectX::XMFLOAT3 position;
+        DirectX::XMFLOAT3 normal;
+        DirectX::XMFLOAT4 tangent;
+        uint32_t          color;
+        DirectX::XMFLOAT2 textureCoordinate;
+    };
+
+    static_assert(sizeof(CMOVertex) == 52, "mismatch with CMO vertex type");
+
+    // Builds a .CMO image of meshCount meshes. Each mesh has vbCount vertex buffers holding a
+    // gridSize x gridSize grid of vertices, each drawn by its own index buffer and submesh.
+    // Alternate submeshes use a material with a non-identity UV transform, so the loader's
+    // texture coordinate fixup has work to do, and skinning adds the second vertex stream.
+    inline std::vector<uint8_t> CreateTestCMO(size_t meshCount, size_t vbCount, size_t gridSize, bool skinning)
+    {
+        if (!meshCount || !vbCount || gridSize < 2 || gridSize > 256)
+            throw std::invalid_argument("CreateTestCMO");
+
+        std::vector<uint8_t> data;
+
+        auto append = [&](const void* src, size_t size)
+        {
+            auto ptr = static_cast<const uint8_t*>(src);
+            data.insert(data.end(), ptr, ptr + size);
+        };
+
+        auto appendUInt = [&](size_t value)
+        {
+            const auto v = static_cast<uint32_t>(value);
+            append(&v, sizeof(v));
+        };
+
+        const size_t nVerts = gridSize * gridSize;
+        const size_t nIndices = (gridSize - 1) * (gridSize - 1) * 6;
+
+        std::vector<uint16_t> indices;
+        indices.reserve(nIndices);
+        for (size_t y = 0; y + 1 < gridSize; ++y)
+        {
+            for (size_t x = 0; x + 1 < gridSize; ++x)
+            {
+                const auto v = static_cast<uint16_t>(y * gridSize + x);
+                const auto below = static_cast<uint16_t>(v + gridSize);
+                const uint16_t quad[6] = { v, below, uint16_t(v + 1), uint16_t(v + 1), below, uint16_t(below + 1) };
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+
+        appendUInt(meshCount);
+
+        for (size_t mesh = 0; mesh < meshCount; ++mesh)
+        {
+            // Unnamed mesh
+            appendUInt(0);
+
+            // Two materials: Ambient, Diffuse, Specular, SpecularPower, Emissive, UVTransform
+            appendUInt(2);
+            for (size_t m = 0; m < 2; ++m)
+            {
+                const float uvScale = m ? 0.5f : 1.f;
+                const float material[33] =
+                {
+                    0.2f, 0.2f, 0.2f, 1.f,
+                    0.8f, 0.8f, 0.8f, 1.f,
+                    0.f, 0.f, 0.f, 1.f,
+                    1.f,
+                    0.f, 0.f, 0.f, 1.f,
+                    uvScale, 0.f, 0.f, 0.f,
+                    0.f, uvScale, 0.f, 0.f,
+                    0.f, 0.f, 1.f, 0.f,
+                    0.f, 0.f, 0.f, 1.f,
+                };
+
+                appendUInt(0);
+                append(material, sizeof(material));
+
+                // No pixel shader or textures
+                for (size_t j = 0; j < 9; ++j)
+                {
+                    appendUInt(0);
+                }
+            }
+
+            // No skeleton
+            const uint8_t skeleton = 0;
+            append(&skeleton, sizeof(skeleton));
+
+            // Submeshes: MaterialIndex, IndexBufferIndex, VertexBufferIndex, StartIndex, PrimCount
+            appendUInt(vbCount);
+            for (size_t j = 0; j < vbCount; ++j)
+            {
+                const uint32_t submesh[5] = { uint32_t(j & 1), uint32_t(j), uint32_t(j), 0, uint32_t(nIndices / 3) };
+                append(submesh, sizeof(submesh));
+            }
+
+            appendUInt(vbCount);
+            for (size_t j = 0; j < vbCount; ++j)
+            {
+                appendUInt(nIndices);
+                append(indices.data(), indices.size() * sizeof(uint16_t));
+            }
+
+            // The VBs of a mesh sit side by side along x
+            appendUInt(vbCount);
+            for (size_t j = 0; j < vbCount; ++j)
+            {
+                appendUInt(nVerts);
+                for (size_t v = 0; v < nVerts; ++v)
+                {
+                    const float u = float(v % gridSize) / float(gridSize - 1);
+                    const float t = float(v / gridSize) / float(gridSize - 1);
+
+                    const CMOVertex vert =
+                    {
+                        DirectX::XMFLOAT3(float(j) + u, t, float(mesh)),
+                        DirectX::XMFLOAT3(0.f, 0.f, 1.f),
+                        DirectX::XMFLOAT4(1.f, 0.f, 0.f, 1.f),
+                        0xFFFFFFFF,
+                        DirectX::XMFLOAT2(u, t),
+                    };
+                    append(&vert, sizeof(vert));
+                }
+            }
+
+            // Skinning VBs: four bone indices, then four weights
+            appendUInt(skinning ? vbCount : 0);
+            if (skinning)
+            {
+                const uint32_t indices4[4] = {};
+                const float weights[4] = { 1.f, 0.f, 0.f, 0.f };
+
+                for (size_t j = 0; j < vbCount; ++j)
+                {
+                    appendUInt(nVerts);
+                    for (size_t v = 0; v < nVerts; ++v)
+                    {
+                        append(indices4, sizeof(indices4));
+                        append(weights, sizeof(weights));
+                    }
+                }
+            }
+
+            // MeshExtents: sphere center and radius, then box min and max
+            const float width = float(vbCount);
+            const float extents[10] =
+            {
+                width * 0.5f, 0.5f, float(mesh),
+                std::max(width, 1.f),
+                0.f, 0.f, float(mesh),
+                width, 1.f, float(mesh),
+            };
+            append(extents, sizeof(extents));
+        }
+
+        return data;
+    }
+}
@@ -0,0 +1,118 @@
+//--------------------------------------------------------------------------------------
+// File: TestHelpers.h
+//
+// Minimal harness shared by the DirectX Tool Kit unit tests and benchmarks
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+
+
+// Fails the current test, reporting the expression and where it is.
+#define TEST_VERIFY(expr) \
+    do { if (!(expr)) { printf("\n    %s(%d): %s", __FILE__, __LINE__, #expr); return false; } } while(0)
+
+
+namespace TestHelpers
+{
+    using TestFN = bool(*)();
+
+    struct TestInfo
+    {
+        const char* name;
+        TestFN      func;
+    };
+
+    // Runs every test in order and returns the process exit code CTest expects.
+    template<size_t N>
+    int RunTests(const TestInfo(&tests)[N])
+    {
+        size_t failed = 0;
+
+        for (const auto& it : tests)
+        {
+            printf("%s: ", it.name);
+
+            bool passed = false;
+            try
+            {
+                passed = it.func();
+            }
+            catch (const std::exception& e)
+            {
+                printf("\n    exception: %s", e.what());
+            }
+
+            if (passed)
+            {
+                printf("passed\n");
+            }
+            else
+            {
+                printf("\n*** FAILED ***\n");
+                ++failed;
+            }
+        }
+
+        printf("Ran %zu tests, %zu passed, %zu failed\n", N, N - failed, failed);
+
+        return failed ? 1 : 0;
+    }
+
+    // Deterministic generator, so failures reproduce on every platform.
+    class Random
+    {
+    public:
+        explicit Random(uint32_t seed = 1) noexcept : mState(seed ? seed : 1) {}
+
+        uint32_t Next() noexcept
+        {
+            mState ^= mState << 13;
+            mState ^= mState >> 17;
+            mState ^= mState << 5;
+            return mState;
+        }
+
+        // In [0, range)
+        uint32_t Next(uint32_t range) noexcept { return range ? Next() % range : 0; }
+
+        // In [0, 1)
+        float NextFloat() noexcept { return float(Next() >> 8) * (1.f / 16777216.f); }
+
+    private:
+        uint32_t mState;
+    };
+
+    // Best time in seconds of at least minRuns calls, repeated until minSeconds has passed.
+    template<typename Fn>
+    double Measure(Fn&& fn, size_t minRuns = 5, double minSeconds = 0.5)
+    {
+        using clock = std::chrono::steady_clock;
+
+        double best = 0;
+        double total = 0;
+        for (size_t run = 0; run < minRuns || total < minSeconds; ++run)
+        {
+            const auto start = clock::now();
+            fn();
+            const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+            if (!run || seconds < best)
+                best = seconds;
+
+            total += seconds;
+        }
+
+        return best;
+    }
+}
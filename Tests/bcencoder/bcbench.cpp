@@ -0,0 +1,123 @@
+//--------------------------------------------------------------------------------------
+// File: bcbench.cpp
+//
+// Measures CompressMipChain throughput and quality on a 2048x2048 image, per block
+// format, with and without the quality flag
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <d3d11_1.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "BCEncoder.h"
+#include "BCHelpers.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    struct Case
+    {
+        const char*     name;
+        DXGI_FORMAT     bcFormat;
+        uint32_t        mask;
+    };
+
+    const Case g_Cases[] =
+    {
+        { "BC1", DXGI_FORMAT_BC1_UNORM, 0x7 },
+        { "BC3", DXGI_FORMAT_BC3_UNORM, 0xF },
+        { "BC4", DXGI_FORMAT_BC4_UNORM, 0x1 },
+        { "BC5", DXGI_FORMAT_BC5_UNORM, 0x3 },
+    };
+
+    constexpr size_t c_size = 2048;
+
+    // Smooth color with some grain, something like a photograph.
+    std::vector<uint8_t> MakeImage()
+    {
+        Random rng(49);
+        std::vector<uint8_t> image(c_size * c_size * 4);
+        for (size_t y = 0; y < c_size; ++y)
+        {
+            for (size_t x = 0; x < c_size; ++x)
+            {
+                const double u = double(x) / c_size;
+                const double v = double(y) / c_size;
+                const double base[4] =
+                {
+                    0.5 + 0.4 * std::sin(u * 9.0 + v * 3.0),
+                    0.5 + 0.4 * std::cos(v * 7.0 - u * 2.0),
+                    0.5 + 0.4 * std::sin((u + v) * 13.0),
+                    0.5 + 0.5 * std::cos(u * 5.0),
+                };
+
+                uint8_t* t = &image[(y * c_size + x) * 4];
+                for (size_t c = 0; c < 4; ++c)
+                {
+                    const double grain = (rng.NextFloat() - 0.5) * 0.06;
+                    t[c] = static_cast<uint8_t>(std::min(std::max((base[c] + grain) * 255.0 + 0.5, 0.0), 255.0));
+                }
+            }
+        }
+        return image;
+    }
+}
+
+int __cdecl main()
+{
+    const auto image = MakeImage();
+    const D3D11_SUBRESOURCE_DATA level = { image.data(), UINT(c_size * 4), UINT(c_size * c_size * 4) };
+    const double megapixels = double(c_size * c_size) / 1e6;
+
+    printf("%zux%zu, one level\n", c_size, c_size);
+    printf("%-8s %12s %12s %12s %12s %12s %12s\n", "Format", "fast (ms)", "MPix/s", "PSNR (dB)", "quality (ms)", "MPix/s", "PSNR (dB)");
+
+    for (const auto& it : g_Cases)
+    {
+        double seconds[2] = {};
+        double psnr[2] = {};
+
+        for (int quality = 0; quality < 2; ++quality)
+        {
+            std::unique_ptr<uint8_t[]> bcData;
+            D3D11_SUBRESOURCE_DATA initData = {};
+
+            bool failed = false;
+            seconds[quality] = Measure([&]()
+                {
+                    if (FAILED(CompressMipChain(&level, 1, c_size, c_size, DXGI_FORMAT_R8G8B8A8_UNORM, it.bcFormat, quality != 0, bcData, &initData)))
+                        failed = true;
+                });
+
+            if (failed)
+            {
+                printf("ERROR: %s failed\n", it.name);
+                return 1;
+            }
+
+            psnr[quality] = PSNR(DecodeBC(initData, c_size, c_size, it.bcFormat), image, it.mask);
+        }
+
+        printf("%-8s %12.1f %12.1f %12.2f %12.1f %12.1f %12.2f\n", it.name,
+            seconds[0] * 1000.0, megapixels / seconds[0], psnr[0],
+            seconds[1] * 1000.0, megapixels / seconds[1], psnr[1]);
+    }
+
+    return 0;
+}
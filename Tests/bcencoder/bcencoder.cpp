@@ -0,0 +1,503 @@
+//--------------------------------------------------------------------------------------
+// File: bcencoder.cpp
+//
+// Tests for the load time BC1, BC3, BC4, and BC5 encoder, checked against the reference
+// decoder in BCHelpers.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <d3d11_1.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "BCEncoder.h"
+#include "BCHelpers.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    //--------------------------------------------------------------------------------------
+    // Helpers
+    //--------------------------------------------------------------------------------------
+
+    struct Encoded
+    {
+        HRESULT                                 hr;
+        std::unique_ptr<uint8_t[]>              bcData;
+        std::vector<D3D11_SUBRESOURCE_DATA>     initData;
+    };
+
+    Encoded Encode(const std::vector<uint8_t>& pixels, size_t width, size_t height, DXGI_FORMAT format, DXGI_FORMAT bcFormat, bool quality)
+    {
+        const size_t bpp = (format == DXGI_FORMAT_R8_UNORM) ? 1 : 4;
+        const D3D11_SUBRESOURCE_DATA level = { pixels.data(), UINT(width * bpp), UINT(width * height * bpp) };
+
+        Encoded result;
+        result.initData.resize(1);
+        result.hr = CompressMipChain(&level, 1, width, height, format, bcFormat, quality, result.bcData, result.initData.data());
+        return result;
+    }
+
+    uint8_t Expand5(size_t v) { return static_cast<uint8_t>((v << 3) | (v >> 2)); }
+    uint8_t Expand6(size_t v) { return static_cast<uint8_t>((v << 2) | (v >> 4)); }
+
+    // RGBA images: smooth gradients and uniform noise, with alpha following the pattern.
+    std::vector<uint8_t> MakeGradient(size_t width, size_t height)
+    {
+        std::vector<uint8_t> image(width * height * 4);
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                uint8_t* t = &image[(y * width + x) * 4];
+                t[0] = static_cast<uint8_t>(x * 255 / (width - 1));
+                t[1] = static_cast<uint8_t>(y * 255 / (height - 1));
+                t[2] = static_cast<uint8_t>(127.5 + 127.5 * std::sin(double(x + y) * 0.05));
+                t[3] = static_cast<uint8_t>((x + y) * 255 / (width + height - 2));
+            }
+        }
+        return image;
+    }
+
+    std::vector<uint8_t> MakeNoise(size_t width, size_t height, uint32_t seed)
+    {
+        Random rng(seed);
+        std::vector<uint8_t> image(width * height * 4);
+        for (auto& it : image)
+            it = static_cast<uint8_t>(rng.Next());
+        return image;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Tests
+    //--------------------------------------------------------------------------------------
+
+    bool TestFormatSelection()
+    {
+        std::vector<uint8_t> pixels(16 * 16 * 4, 0xFF);
+
+        TEST_VERIFY(GetBCFormat(pixels.data(), 64, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, false) == DXGI_FORMAT_BC1_UNORM);
+        TEST_VERIFY(GetBCFormat(pixels.data(), 64, 16, 16, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, false) == DXGI_FORMAT_BC1_UNORM_SRGB);
+
+        // One translucent texel, in the last row, is enough for BC3
+        pixels[15 * 64 + 63] = 0xFE;
+        TEST_VERIFY(GetBCFormat(pixels.data(), 64, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, false) == DXGI_FORMAT_BC3_UNORM);
+        TEST_VERIFY(GetBCFormat(pixels.data(), 64, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, false) == DXGI_FORMAT_BC3_UNORM_SRGB);
+        TEST_VERIFY(GetBCFormat(pixels.data(), 64, 16, 16, DXGI_FORMAT_B8G8R8A8_UNORM, false) == DXGI_FORMAT_BC3_UNORM);
+
+        // Only texels inside the image count, not the padding of a wider pitch
+        TEST_VERIFY(GetBCFormat(pixels.data(), 64, 15, 16, DXGI_FORMAT_R8G8B8A8_UNORM, false) == DXGI_FORMAT_BC1_UNORM);
+        TEST_VERIFY(GetBCFormat(pixels.data(), 64, 16, 15, DXGI_FORMAT_R8G8B8A8_UNORM, false) == DXGI_FORMAT_BC1_UNORM);
+
+        // The X channel is never alpha
+        TEST_VERIFY(GetBCFormat(pixels.data(), 64, 16, 16, DXGI_FORMAT_B8G8R8X8_UNORM, false) == DXGI_FORMAT_BC1_UNORM);
+        TEST_VERIFY(GetBCFormat(pixels.data(), 64, 16, 16, DXGI_FORMAT_B8G8R8X8_UNORM_SRGB, false) == DXGI_FORMAT_BC1_UNORM_SRGB);
+
+        TEST_VERIFY(GetBCFormat(pixels.data(), 16, 16, 16, DXGI_FORMAT_R8_UNORM, false) == DXGI_FORMAT_BC4_UNORM);
+        TEST_VERIFY(GetBCFormat(pixels.data(), 64, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, true) == DXGI_FORMAT_BC5_UNORM);
+
+        TEST_VERIFY(GetBCFormat(pixels.data(), 64, 16, 16, DXGI_FORMAT_R16G16B16A16_UNORM, false) == DXGI_FORMAT_UNKNOWN);
+        TEST_VERIFY(GetBCFormat(pixels.data(), 64, 16, 16, DXGI_FORMAT_BC1_UNORM, false) == DXGI_FORMAT_UNKNOWN);
+        TEST_VERIFY(GetBCFormat(nullptr, 64, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, false) == DXGI_FORMAT_UNKNOWN);
+
+        return true;
+    }
+
+    // A flat block decodes to the nearest 5:6:5 color, and flat channels are exact.
+    bool TestSolidBlocks()
+    {
+        Random rng(49);
+
+        for (size_t j = 0; j < 500; ++j)
+        {
+            const uint8_t color[4] =
+            {
+                static_cast<uint8_t>(rng.Next()), static_cast<uint8_t>(rng.Next()),
+                static_cast<uint8_t>(rng.Next()), static_cast<uint8_t>(rng.Next()),
+            };
+
+            std::vector<uint8_t> pixels(16 * 4);
+            for (size_t i = 0; i < 16; ++i)
+                memcpy(&pixels[i * 4], color, 4);
+
+            for (const auto bcFormat : { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC5_UNORM })
+            {
+                const bool quality = (j & 1) != 0;
+                const auto encoded = Encode(pixels, 4, 4, DXGI_FORMAT_R8G8B8A8_UNORM, bcFormat, quality);
+                TEST_VERIFY(SUCCEEDED(encoded.hr));
+
+                const auto decoded = DecodeBC(encoded.initData[0], 4, 4, bcFormat);
+                for (size_t i = 0; i < 16; ++i)
+                {
+                    const uint8_t* t = &decoded[i * 4];
+                    switch (bcFormat)
+                    {
+                    case DXGI_FORMAT_BC3_UNORM:
+                        TEST_VERIFY(t[3] == color[3]);
+                        // fall through
+
+                    case DXGI_FORMAT_BC1_UNORM:
+                        TEST_VERIFY(std::abs(int(t[0]) - int(color[0])) <= 4);
+                        TEST_VERIFY(std::abs(int(t[1]) - int(color[1])) <= 2);
+                        TEST_VERIFY(std::abs(int(t[2]) - int(color[2])) <= 4);
+                        break;
+
+                    case DXGI_FORMAT_BC5_UNORM:
+                        TEST_VERIFY(t[1] == color[1]);
+                        // fall through
+
+                    default:
+                        TEST_VERIFY(t[0] == color[0]);
+                        break;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Blocks made of two colors that 5:6:5 holds exactly, or of two channel values, are lossless.
+    bool TestTwoColorBlocks()
+    {
+        Random rng(4949);
+
+        auto expand565 = [](uint32_t c, uint8_t* t)
+            {
+                t[0] = Expand5((c >> 11) & 0x1f);
+                t[1] = Expand6((c >> 5) & 0x3f);
+                t[2] = Expand5(c & 0x1f);
+                t[3] = 255;
+            };
+
+        for (size_t j = 0; j < 500; ++j)
+        {
+            uint8_t colors[2][4];
+            expand565(rng.Next(0x10000), colors[0]);
+            expand565(rng.Next(0x10000), colors[1]);
+
+            std::vector<uint8_t> pixels(16 * 4);
+            for (size_t i = 0; i < 16; ++i)
+            {
+                const size_t pick = (i == 0) ? 0 : (i == 1) ? 1 : rng.Next(2);
+                memcpy(&pixels[i * 4], colors[pick], 4);
+                pixels[i * 4 + 3] = pick ? 40 : 210;
+            }
+
+            const bool quality = (j & 1) != 0;
+            for (const auto bcFormat : { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC5_UNORM })
+            {
+                const auto encoded = Encode(pixels, 4, 4, DXGI_FORMAT_R8G8B8A8_UNORM, bcFormat, quality);
+                TEST_VERIFY(SUCCEEDED(encoded.hr));
+
+                const auto decoded = DecodeBC(encoded.initData[0], 4, 4, bcFormat);
+                const uint32_t mask = (bcFormat == DXGI_FORMAT_BC1_UNORM) ? 0x7
+                    : (bcFormat == DXGI_FORMAT_BC3_UNORM) ? 0xF
+                    : (bcFormat == DXGI_FORMAT_BC4_UNORM) ? 0x1 : 0x3;
+
+                if (SquaredError(decoded, pixels, mask) != 0)
+                {
+                    printf("\n    block %zu, format %u is not exact", j, unsigned(bcFormat));
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // With the endpoints at the block's extremes, every value is within half a palette step.
+    bool TestChannelBound()
+    {
+        Random rng(494949);
+
+        for (size_t j = 0; j < 2000; ++j)
+        {
+            const uint32_t lo = rng.Next(256);
+            const uint32_t range = rng.Next(256 - lo);
+
+            std::vector<uint8_t> pixels(16);
+            for (auto& it : pixels)
+                it = static_cast<uint8_t>(lo + rng.Next(range + 1));
+
+            const auto encoded = Encode(pixels, 4, 4, DXGI_FORMAT_R8_UNORM, DXGI_FORMAT_BC4_UNORM, false);
+            TEST_VERIFY(SUCCEEDED(encoded.hr));
+
+            const auto decoded = DecodeBC(encoded.initData[0], 4, 4, DXGI_FORMAT_BC4_UNORM);
+
+            const uint8_t minValue = *std::min_element(pixels.begin(), pixels.end());
+            const uint8_t maxValue = *std::max_element(pixels.begin(), pixels.end());
+            const double bound = double(maxValue - minValue) / 14.0 + 1.0;
+
+            for (size_t i = 0; i < 16; ++i)
+            {
+                if (std::fabs(double(decoded[i * 4]) - double(pixels[i])) > bound)
+                {
+                    printf("\n    block %zu, texel %zu: %u, expected %u within %f", j, i, decoded[i * 4], pixels[i], bound);
+                    return false;
+                }
+            }
+
+            // The quality path only ever takes a closer fit
+            const auto refined = Encode(pixels, 4, 4, DXGI_FORMAT_R8_UNORM, DXGI_FORMAT_BC4_UNORM, true);
+            TEST_VERIFY(SUCCEEDED(refined.hr));
+
+            std::vector<uint8_t> source(16 * 4);
+            for (size_t i = 0; i < 16; ++i)
+                source[i * 4] = pixels[i];
+
+            const auto decodedRefined = DecodeBC(refined.initData[0], 4, 4, DXGI_FORMAT_BC4_UNORM);
+            TEST_VERIFY(SquaredError(decodedRefined, source, 0x1) <= SquaredError(decoded, source, 0x1));
+        }
+
+        return true;
+    }
+
+    // Whole images: the decoded result stays above a PSNR floor for each format, and the
+    // quality path is never worse than the fast one.
+    bool TestImageQuality()
+    {
+        struct Case
+        {
+            const char*     name;
+            DXGI_FORMAT     bcFormat;
+            uint32_t        mask;
+            bool            noise;
+            double          minPSNR;
+        };
+
+        const Case cases[] =
+        {
+            { "BC1 gradient",   DXGI_FORMAT_BC1_UNORM,  0x7, false, 38.0 },
+            { "BC3 gradient",   DXGI_FORMAT_BC3_UNORM,  0xF, false, 39.0 },
+            { "BC4 gradient",   DXGI_FORMAT_BC4_UNORM,  0x1, false, 45.0 },
+            { "BC5 gradient",   DXGI_FORMAT_BC5_UNORM,  0x3, false, 45.0 },
+            { "BC1 noise",      DXGI_FORMAT_BC1_UNORM,  0x7, true,  11.0 },
+            { "BC3 noise",      DXGI_FORMAT_BC3_UNORM,  0xF, true,  12.0 },
+            { "BC4 noise",      DXGI_FORMAT_BC4_UNORM,  0x1, true,  27.0 },
+            { "BC5 noise",      DXGI_FORMAT_BC5_UNORM,  0x3, true,  27.0 },
+        };
+
+        const size_t width = 128;
+        const size_t height = 96;
+        const auto gradient = MakeGradient(width, height);
+        const auto noise = MakeNoise(width, height, 49494949);
+
+        for (const auto& it : cases)
+        {
+            const auto& pixels = it.noise ? noise : gradient;
+
+            const auto fast = Encode(pixels, width, height, DXGI_FORMAT_R8G8B8A8_UNORM, it.bcFormat, false);
+            const auto quality = Encode(pixels, width, height, DXGI_FORMAT_R8G8B8A8_UNORM, it.bcFormat, true);
+            TEST_VERIFY(SUCCEEDED(fast.hr) && SUCCEEDED(quality.hr));
+
+            const double fastPSNR = PSNR(DecodeBC(fast.initData[0], width, height, it.bcFormat), pixels, it.mask);
+            const double qualityPSNR = PSNR(DecodeBC(quality.initData[0], width, height, it.bcFormat), pixels, it.mask);
+
+            if (fastPSNR < it.minPSNR || qualityPSNR < fastPSNR - 0.01)
+            {
+                printf("\n    %s: %.2f dB fast, %.2f dB quality, expected at least %.2f dB", it.name, fastPSNR, qualityPSNR, it.minPSNR);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Every mip level gets its own entry, including the ones smaller than a block, and the
+    // texels past a level's edge don't leak into the covered ones.
+    bool TestMipLayout()
+    {
+        const size_t width = 37;
+        const size_t height = 13;
+        const size_t mipLevels = 6;
+        const size_t padding = 12;
+
+        std::vector<std::vector<uint8_t>> sources;
+        std::vector<D3D11_SUBRESOURCE_DATA> levels(mipLevels);
+        for (size_t level = 0; level < mipLevels; ++level)
+        {
+            const size_t w = std::max<size_t>(1, width >> level);
+            const size_t h = std::max<size_t>(1, height >> level);
+
+            // A flat 5:6:5 color per level, different from the padding, so the decode must be exact
+            std::vector<uint8_t> pixels((w * 4 + padding) * h, 0);
+            for (size_t y = 0; y < h; ++y)
+            {
+                for (size_t x = 0; x < w; ++x)
+                {
+                    uint8_t* t = &pixels[y * (w * 4 + padding) + x * 4];
+                    t[0] = Expand5(level * 5);
+                    t[1] = Expand6(level * 10);
+                    t[2] = 0xFF;
+                    t[3] = static_cast<uint8_t>(255 - level);
+                }
+            }
+
+            sources.emplace_back(std::move(pixels));
+            levels[level] = { sources.back().data(), UINT(w * 4 + padding), 0 };
+        }
+
+        for (const auto bcFormat : { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM })
+        {
+            std::unique_ptr<uint8_t[]> bcData;
+            D3D11_SUBRESOURCE_DATA initData[mipLevels] = {};
+            TEST_VERIFY(SUCCEEDED(CompressMipChain(levels.data(), mipLevels, width, height, DXGI_FORMAT_R8G8B8A8_UNORM, bcFormat, false, bcData, initData)));
+            TEST_VERIFY(bcData);
+
+            const size_t blockSize = GetBCBlockSize(bcFormat);
+            const uint8_t* next = bcData.get();
+
+            for (size_t level = 0; level < mipLevels; ++level)
+            {
+                const size_t w = std::max<size_t>(1, width >> level);
+                const size_t h = std::max<size_t>(1, height >> level);
+                const size_t blocksWide = (w + 3) / 4;
+                const size_t blocksHigh = (h + 3) / 4;
+
+                TEST_VERIFY(initData[level].pSysMem == next);
+                TEST_VERIFY(initData[level].SysMemPitch == blocksWide * blockSize);
+                TEST_VERIFY(initData[level].SysMemSlicePitch == blocksWide * blocksHigh * blockSize);
+                next += initData[level].SysMemSlicePitch;
+
+                const auto decoded = DecodeBC(initData[level], w, h, bcFormat);
+                for (size_t j = 0; j < w * h; ++j)
+                {
+                    const uint8_t* t = &decoded[j * 4];
+                    TEST_VERIFY(t[0] == Expand5(level * 5) && t[1] == Expand6(level * 10) && t[2] == 0xFF);
+                    TEST_VERIFY(bcFormat == DXGI_FORMAT_BC1_UNORM || t[3] == 255 - level);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // RGBA, BGRA, and BGRX sources of the same image encode the same blocks, with X opaque.
+    bool TestSourceOrder()
+    {
+        const size_t width = 64;
+        const size_t height = 32;
+        const auto rgba = MakeNoise(width, height, 4949494);
+
+        std::vector<uint8_t> bgra(rgba.size());
+        std::vector<uint8_t> bgrx(rgba.size());
+        std::vector<uint8_t> opaque(rgba);
+        for (size_t j = 0; j < width * height; ++j)
+        {
+            bgra[j * 4] = bgrx[j * 4] = rgba[j * 4 + 2];
+            bgra[j * 4 + 1] = bgrx[j * 4 + 1] = rgba[j * 4 + 1];
+            bgra[j * 4 + 2] = bgrx[j * 4 + 2] = rgba[j * 4];
+            bgra[j * 4 + 3] = rgba[j * 4 + 3];
+            bgrx[j * 4 + 3] = static_cast<uint8_t>(j);
+            opaque[j * 4 + 3] = 0xFF;
+        }
+
+        for (const auto bcFormat : { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC5_UNORM })
+        {
+            const size_t size = (width / 4) * (height / 4) * GetBCBlockSize(bcFormat);
+
+            const auto a = Encode(rgba, width, height, DXGI_FORMAT_R8G8B8A8_UNORM, bcFormat, true);
+            const auto b = Encode(bgra, width, height, DXGI_FORMAT_B8G8R8A8_UNORM, bcFormat, true);
+            TEST_VERIFY(SUCCEEDED(a.hr) && SUCCEEDED(b.hr));
+            TEST_VERIFY(memcmp(a.bcData.get(), b.bcData.get(), size) == 0);
+
+            const auto c = Encode(opaque, width, height, DXGI_FORMAT_R8G8B8A8_UNORM, bcFormat, true);
+            const auto d = Encode(bgrx, width, height, DXGI_FORMAT_B8G8R8X8_UNORM, bcFormat, true);
+            TEST_VERIFY(SUCCEEDED(c.hr) && SUCCEEDED(d.hr));
+            TEST_VERIFY(memcmp(c.bcData.get(), d.bcData.get(), size) == 0);
+        }
+
+        return true;
+    }
+
+    // Levels big enough to be split across threads encode each block as it would be alone.
+    bool TestParallel()
+    {
+        const size_t width = 256;
+        const size_t height = 128;
+        const auto pixels = MakeNoise(width, height, 494949494);
+
+        for (const auto bcFormat : { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM })
+        {
+            const auto whole = Encode(pixels, width, height, DXGI_FORMAT_R8G8B8A8_UNORM, bcFormat, true);
+            TEST_VERIFY(SUCCEEDED(whole.hr));
+
+            const size_t blockSize = GetBCBlockSize(bcFormat);
+            for (size_t by = 0; by < height / 4; by += 5)
+            {
+                for (size_t bx = 0; bx < width / 4; bx += 3)
+                {
+                    std::vector<uint8_t> block(16 * 4);
+                    for (size_t y = 0; y < 4; ++y)
+                        memcpy(&block[y * 16], &pixels[((by * 4 + y) * width + bx * 4) * 4], 16);
+
+                    const auto alone = Encode(block, 4, 4, DXGI_FORMAT_R8G8B8A8_UNORM, bcFormat, true);
+                    TEST_VERIFY(SUCCEEDED(alone.hr));
+                    TEST_VERIFY(memcmp(alone.bcData.get(), whole.bcData.get() + (by * (width / 4) + bx) * blockSize, blockSize) == 0);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool TestInvalid()
+    {
+        const std::vector<uint8_t> pixels(16 * 16 * 4);
+        const D3D11_SUBRESOURCE_DATA level = { pixels.data(), 64, 0 };
+        D3D11_SUBRESOURCE_DATA initData = {};
+
+        std::unique_ptr<uint8_t[]> bcData(new uint8_t[16]);
+        TEST_VERIFY(CompressMipChain(nullptr, 1, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC1_UNORM, false, bcData, &initData) == E_POINTER);
+        TEST_VERIFY(!bcData);
+
+        TEST_VERIFY(CompressMipChain(&level, 1, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC1_UNORM, false, bcData, nullptr) == E_POINTER);
+        TEST_VERIFY(CompressMipChain(&level, 0, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC1_UNORM, false, bcData, &initData) == E_INVALIDARG);
+        TEST_VERIFY(CompressMipChain(&level, 1, 0, 16, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC1_UNORM, false, bcData, &initData) == E_INVALIDARG);
+        TEST_VERIFY(CompressMipChain(&level, 1, 16, 0, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC1_UNORM, false, bcData, &initData) == E_INVALIDARG);
+
+        const HRESULT notSupported = HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+        TEST_VERIFY(CompressMipChain(&level, 1, 16, 16, DXGI_FORMAT_R16G16B16A16_UNORM, DXGI_FORMAT_BC1_UNORM, false, bcData, &initData) == notSupported);
+        TEST_VERIFY(CompressMipChain(&level, 1, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC7_UNORM, false, bcData, &initData) == notSupported);
+        TEST_VERIFY(CompressMipChain(&level, 1, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM, false, bcData, &initData) == notSupported);
+        TEST_VERIFY(!bcData);
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "FormatSelection", TestFormatSelection },
+        { "SolidBlocks", TestSolidBlocks },
+        { "TwoColorBlocks", TestTwoColorBlocks },
+        { "ChannelBound", TestChannelBound },
+        { "ImageQuality", TestImageQuality },
+        { "MipLayout", TestMipLayout },
+        { "SourceOrder", TestSourceOrder },
+        { "Parallel", TestParallel },
+        { "Invalid", TestInvalid },
+    };
+}
+
+int __cdecl main()
+{
+    return RunTests(g_Tests);
+}
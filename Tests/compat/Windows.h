@@ -0,0 +1,99 @@
+//--------------------------------------------------------------------------------------
+// File: Windows.h
+//
+// The few Windows SDK and CRT definitions the CPU-only library code relies on, so its
+// unit tests build on platforms without the Windows SDK. Only on the include path of
+// non-Windows builds of the tests.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#error Use the Windows SDK headers when building for Windows
+#endif
+
+#include <sal.h>
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0A00
+#endif
+
+#define _WIN32_WINNT_WIN8 0x0602
+#define _WIN32_WINNT_WIN10 0x0A00
+
+using HRESULT = int32_t;
+using UINT = uint32_t;
+using ULONG = uint32_t;
+using DWORD = uint32_t;
+using HANDLE = void*;
+
+#define SUCCEEDED(hr) (static_cast<HRESULT>(hr) >= 0)
+#define FAILED(hr) (static_cast<HRESULT>(hr) < 0)
+
+#define S_OK static_cast<HRESULT>(0)
+#define S_FALSE static_cast<HRESULT>(1)
+#define E_NOTIMPL static_cast<HRESULT>(0x80004001)
+#define E_POINTER static_cast<HRESULT>(0x80004003)
+#define E_FAIL static_cast<HRESULT>(0x80004005)
+#define E_UNEXPECTED static_cast<HRESULT>(0x8000FFFF)
+#define E_OUTOFMEMORY static_cast<HRESULT>(0x8007000E)
+#define E_INVALIDARG static_cast<HRESULT>(0x80070057)
+
+#define ERROR_FILE_NOT_FOUND 2L
+#define ERROR_ACCESS_DENIED 5L
+#define ERROR_INVALID_DATA 13L
+#define ERROR_HANDLE_EOF 38L
+#define ERROR_NOT_SUPPORTED 50L
+#define ERROR_INSUFFICIENT_BUFFER 122L
+#define ERROR_FILE_TOO_LARGE 223L
+#define ERROR_ARITHMETIC_OVERFLOW 534L
+
+#define HRESULT_FROM_WIN32(x) static_cast<HRESULT>((static_cast<uint32_t>(x) & 0x0000FFFF) | (7u << 16) | 0x80000000u)
+
+#define INVALID_HANDLE_VALUE reinterpret_cast<HANDLE>(static_cast<intptr_t>(-1))
+#define MEM_RELEASE 0x00008000
+
+#define UNREFERENCED_PARAMETER(p) (void)(p)
+
+// PlatformHelpers.h wraps these for handles and virtual allocations, which the CPU-only
+// code never creates.
+inline int CloseHandle(HANDLE) noexcept { return 1; }
+inline int VirtualFree(void*, size_t, DWORD) noexcept { return 1; }
+
+inline void OutputDebugStringA(const char* str) noexcept { fputs(str, stderr); }
+
+// CRT extensions
+template<size_t N>
+inline int vsprintf_s(char (&buffer)[N], const char* format, va_list args) noexcept
+{
+    return vsnprintf(buffer, N, format, args);
+}
+
+template<size_t N>
+inline int sprintf_s(char (&buffer)[N], const char* format, ...) noexcept
+{
+    va_list args;
+    va_start(args, format);
+    const int result = vsnprintf(buffer, N, format, args);
+    va_end(args);
+    return result;
+}
+
+inline void* _aligned_malloc(size_t size, size_t alignment) noexcept
+{
+    void* ptr = nullptr;
+    return posix_memalign(&ptr, alignment, size) ? nullptr : ptr;
+}
+
+inline void _aligned_free(void* ptr) noexcept { free(ptr); }
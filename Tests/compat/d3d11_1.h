@@ -0,0 +1,23 @@
+//--------------------------------------------------------------------------------------
+// File: d3d11_1.h
+//
+// The Direct3D 11 types the CPU-only texture code passes around, for its unit tests on
+// platforms without the Windows SDK. Nothing here talks to a device.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <Windows.h>
+#include <dxgiformat.h>
+
+struct D3D11_SUBRESOURCE_DATA
+{
+    const void* pSysMem;
+    UINT SysMemPitch;
+    UINT SysMemSlicePitch;
+};
@@ -0,0 +1,15 @@
+//--------------------------------------------------------------------------------------
+// File: dxgiformat.h
+//
+// DXGI_FORMAT from the DirectX-Headers package, for the CPU-only unit tests on platforms
+// without the Windows SDK.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <directx/dxgiformat.h>
@@ -0,0 +1,15 @@
+//--------------------------------------------------------------------------------------
+// File: objbase.h
+//
+// Forwards to the Windows.h subset for the CPU-only unit tests on platforms without the
+// Windows SDK.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <Windows.h>
@@ -0,0 +1,47 @@
+//--------------------------------------------------------------------------------------
+// File: sal.h
+//
+// Empty source annotations and calling conventions for the CPU-only unit tests on
+// platforms without the Windows SDK. Only on the include path of non-Windows builds of
+// the tests.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef __cdecl
+#define __cdecl
+#endif
+
+#define _In_
+#define _In_opt_
+#define _In_z_
+#define _In_opt_z_
+#define _In_reads_(size)
+#define _In_reads_opt_(size)
+#define _In_reads_bytes_(size)
+#define _In_reads_bytes_opt_(size)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(size)
+#define _Out_writes_opt_(size)
+#define _Out_writes_bytes_(size)
+#define _Out_writes_bytes_opt_(size)
+#define _Out_writes_bytes_to_(size, count)
+#define _Out_writes_bytes_all_(size)
+#define _Out_writes_all_(size)
+#define _Outptr_
+#define _Outptr_opt_
+#define _Inout_
+#define _Inout_opt_
+#define _Inout_updates_(size)
+#define _Inout_updates_bytes_(size)
+#define _Use_decl_annotations_
+#define _Printf_format_string_
+#define _Success_(expr)
+#define _When_(expr, annotations)
+#define _Analysis_assume_(expr)
@@ -0,0 +1,510 @@
+//--------------------------------------------------------------------------------------
+// File: ddscompression.cpp
+//
+// Tests for the LZ4 block codec and the supercompressed DDS (DDSZ) container
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "DDSCompression.h"
+#include "DDSParser.h"
+#include "DDSHelpers.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    enum PATTERN
+    {
+        PATTERN_NOISE,
+        PATTERN_RUNS,
+        PATTERN_PERIODIC,
+        PATTERN_FEW_VALUES,
+        PATTERN_FAR_REPEAT,
+        PATTERN_COUNT,
+    };
+
+    std::vector<uint8_t> MakeData(size_t size, PATTERN pattern, uint32_t seed)
+    {
+        Random rng(seed);
+        std::vector<uint8_t> data(size);
+
+        switch (pattern)
+        {
+        case PATTERN_NOISE:
+            for (auto& it : data)
+                it = static_cast<uint8_t>(rng.Next());
+            break;
+
+        case PATTERN_RUNS:
+            for (size_t j = 0; j < size; ++j)
+                data[j] = static_cast<uint8_t>(j / 1000);
+            break;
+
+        case PATTERN_PERIODIC:
+            for (size_t j = 0; j < size; ++j)
+                data[j] = static_cast<uint8_t>(j % 7);
+            break;
+
+        case PATTERN_FEW_VALUES:
+            for (auto& it : data)
+                it = static_cast<uint8_t>(rng.Next(4));
+            break;
+
+        case PATTERN_FAR_REPEAT:
+            // Noise that repeats only past the largest offset the format can encode
+            for (size_t j = 0; j < size; ++j)
+                data[j] = (j < 70000) ? static_cast<uint8_t>(rng.Next()) : data[j - 70000];
+            break;
+
+        default:
+            break;
+        }
+
+        return data;
+    }
+
+    // Compresses into a buffer of exactly LZCompressBound bytes. Returns an empty vector if
+    // the compressor failed.
+    std::vector<uint8_t> Compress(const std::vector<uint8_t>& data)
+    {
+        std::vector<uint8_t> packed(LZCompressBound(data.size()));
+        const size_t size = LZCompress(data.data(), data.size(), packed.data(), packed.size());
+        packed.resize(size);
+        return packed;
+    }
+
+    // Decompresses into a buffer of exactly destSize bytes, so any overrun is caught by
+    // the debug heap or sanitizers.
+    bool Decompress(const std::vector<uint8_t>& packed, size_t destSize, std::vector<uint8_t>& data)
+    {
+        data.assign(destSize, 0);
+        std::unique_ptr<uint8_t[]> src(new uint8_t[std::max<size_t>(packed.size(), 1)]);
+        if (!packed.empty())
+            memcpy(src.get(), packed.data(), packed.size());
+
+        std::unique_ptr<uint8_t[]> dest(new uint8_t[std::max<size_t>(destSize, 1)]);
+        if (!LZDecompress(src.get(), packed.size(), dest.get(), destSize))
+            return false;
+
+        if (destSize)
+            memcpy(data.data(), dest.get(), destSize);
+        return true;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // LZ codec
+    //--------------------------------------------------------------------------------------
+
+    bool TestLZRoundTrip()
+    {
+        const size_t sizes[] = { 1, 4, 5, 12, 13, 16, 17, 100, 255, 4096, 65535, 65536, 65537, 200000, 1000000 };
+
+        for (const size_t size : sizes)
+        {
+            for (int pattern = 0; pattern < PATTERN_COUNT; ++pattern)
+            {
+                const auto data = MakeData(size, PATTERN(pattern), uint32_t(size + 50));
+                const auto packed = Compress(data);
+                TEST_VERIFY(!packed.empty());
+                TEST_VERIFY(packed.size() <= LZCompressBound(size));
+
+                std::vector<uint8_t> result;
+                if (!Decompress(packed, size, result) || result != data)
+                {
+                    printf("\n    %zu bytes of pattern %d don't round trip", size, pattern);
+                    return false;
+                }
+
+                // Repetitive data has to actually shrink
+                if (size >= 4096 && (pattern == PATTERN_RUNS || pattern == PATTERN_PERIODIC))
+                {
+                    TEST_VERIFY(packed.size() < size / 50);
+                }
+
+                if (size >= 200000 && pattern == PATTERN_FAR_REPEAT)
+                {
+                    TEST_VERIFY(packed.size() > 70000);
+                }
+            }
+        }
+
+        // An empty input is a single token with no literals
+        const uint8_t none = 0;
+        uint8_t token[16] = {};
+        TEST_VERIFY(LZCompress(&none, 0, token, sizeof(token)) == 1);
+        TEST_VERIFY(token[0] == 0);
+
+        uint8_t out = 0xCD;
+        TEST_VERIFY(LZDecompress(token, 1, &out, 0));
+        TEST_VERIFY(out == 0xCD);
+
+        // Random lengths and mixes of the patterns
+        Random rng(5050);
+        for (size_t j = 0; j < 300; ++j)
+        {
+            const size_t size = 1 + rng.Next((j < 150) ? 64u : 100000u);
+            auto data = MakeData(size, PATTERN(j % PATTERN_COUNT), uint32_t(j));
+            for (size_t k = 0; k + 32 < size; k += 1 + rng.Next(200))
+                data[k] = static_cast<uint8_t>(rng.Next());
+
+            std::vector<uint8_t> result;
+            TEST_VERIFY(Decompress(Compress(data), size, result));
+            TEST_VERIFY(result == data);
+        }
+
+        return true;
+    }
+
+    // The compressor returns 0 rather than write past the end of a small buffer.
+    bool TestLZDestTooSmall()
+    {
+        for (int pattern = 0; pattern < PATTERN_COUNT; ++pattern)
+        {
+            const auto data = MakeData(50000, PATTERN(pattern), 505);
+            const auto packed = Compress(data);
+            TEST_VERIFY(!packed.empty());
+
+            for (const size_t destSize : { packed.size(), packed.size() - 1, packed.size() / 2, size_t(1), size_t(0) })
+            {
+                std::unique_ptr<uint8_t[]> dest(new uint8_t[std::max<size_t>(destSize, 1)]);
+                const size_t size = LZCompress(data.data(), data.size(), dest.get(), destSize);
+                if (destSize == packed.size())
+                {
+                    TEST_VERIFY(size == packed.size());
+                    TEST_VERIFY(memcmp(dest.get(), packed.data(), size) == 0);
+                }
+                else
+                {
+                    TEST_VERIFY(size == 0);
+                }
+            }
+        }
+
+        // Noise never fits in its own size
+        const auto noise = MakeData(10000, PATTERN_NOISE, 50505);
+        std::vector<uint8_t> dest(noise.size());
+        TEST_VERIFY(LZCompress(noise.data(), noise.size(), dest.data(), dest.size()) == 0);
+
+        TEST_VERIFY(LZCompress(nullptr, 16, dest.data(), dest.size()) == 0);
+        TEST_VERIFY(LZCompress(noise.data(), 16, nullptr, 64) == 0);
+
+        return true;
+    }
+
+    // Damaged streams fail, or at worst decode to the right length, without touching memory
+    // outside the buffers.
+    bool TestLZCorrupt()
+    {
+        Random rng(50505);
+
+        for (size_t j = 0; j < 200; ++j)
+        {
+            const size_t size = 1 + rng.Next(20000);
+            const auto data = MakeData(size, PATTERN(j % PATTERN_COUNT), uint32_t(j * 3));
+            const auto packed = Compress(data);
+
+            std::vector<uint8_t> result;
+
+            // Every cut short stream is missing output
+            for (size_t k = 0; k < 8; ++k)
+            {
+                const std::vector<uint8_t> truncated(packed.begin(), packed.begin() + rng.Next(uint32_t(packed.size())));
+                TEST_VERIFY(!Decompress(truncated, size, result));
+            }
+
+            // The output size is part of the contract
+            TEST_VERIFY(!Decompress(packed, size + 1, result));
+            TEST_VERIFY(!Decompress(packed, size - 1, result));
+
+            // Trailing bytes are an error
+            auto longer = packed;
+            longer.push_back(0);
+            TEST_VERIFY(!Decompress(longer, size, result));
+
+            for (size_t k = 0; k < 20; ++k)
+            {
+                auto damaged = packed;
+                damaged[rng.Next(uint32_t(damaged.size()))] ^= static_cast<uint8_t>(1 + rng.Next(255));
+                if (Decompress(damaged, size, result))
+                {
+                    TEST_VERIFY(result.size() == size);
+                }
+            }
+        }
+
+        // Hand built sequences: a literal then a match with a bad offset
+        const uint8_t zeroOffset[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+        const uint8_t farOffset[] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+        const uint8_t longLiteral[] = { 0xF0, 0xFF, 0xFF, 0xFF };
+        const uint8_t valid[] = { 0x10, 'a', 0x01, 0x00, 0x10, 'b' };
+
+        std::vector<uint8_t> result;
+        TEST_VERIFY(!Decompress(std::vector<uint8_t>(std::begin(zeroOffset), std::end(zeroOffset)), 6, result));
+        TEST_VERIFY(!Decompress(std::vector<uint8_t>(std::begin(farOffset), std::end(farOffset)), 6, result));
+        TEST_VERIFY(!Decompress(std::vector<uint8_t>(std::begin(longLiteral), std::end(longLiteral)), 1000, result));
+
+        // 'a', then a match of four at offset 1 repeating it, then 'b'
+        TEST_VERIFY(Decompress(std::vector<uint8_t>(std::begin(valid), std::end(valid)), 6, result));
+        TEST_VERIFY(memcmp(result.data(), "aaaaab", 6) == 0);
+
+        TEST_VERIFY(!Decompress(std::vector<uint8_t>(), 0, result));
+
+        uint8_t dest[4];
+        TEST_VERIFY(!LZDecompress(nullptr, 4, dest, sizeof(dest)));
+        TEST_VERIFY(!LZDecompress(valid, sizeof(valid), nullptr, 6));
+
+        return true;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // DDSZ container
+    //--------------------------------------------------------------------------------------
+
+    const DDSDesc g_Textures[] =
+    {
+        // format                           dimension                   w      h     d  array mips  cube   legacy
+        { DXGI_FORMAT_R8G8B8A8_UNORM,       DDS_DIMENSION_TEXTURE2D,    256,   256,  1, 1,    9,    false, false },
+        { DXGI_FORMAT_R8G8B8A8_UNORM,       DDS_DIMENSION_TEXTURE2D,    300,   200,  1, 1,    1,    false, true },
+        { DXGI_FORMAT_B5G6R5_UNORM,         DDS_DIMENSION_TEXTURE2D,    64,    32,   1, 1,    7,    false, true },
+        { DXGI_FORMAT_BC1_UNORM,            DDS_DIMENSION_TEXTURE2D,    256,   128,  1, 1,    9,    false, true },
+        { DXGI_FORMAT_BC3_UNORM,            DDS_DIMENSION_TEXTURE2D,    128,   128,  1, 4,    8,    false, false },
+        { DXGI_FORMAT_BC7_UNORM,            DDS_DIMENSION_TEXTURE2D,    1024,  1024, 1, 1,    11,   false, false },
+        { DXGI_FORMAT_R8G8B8A8_UNORM,       DDS_DIMENSION_TEXTURE2D,    64,    64,   1, 1,    7,    true,  true },
+        { DXGI_FORMAT_BC1_UNORM,            DDS_DIMENSION_TEXTURE2D,    32,    32,   1, 2,    6,    true,  false },
+        { DXGI_FORMAT_R16G16B16A16_FLOAT,   DDS_DIMENSION_TEXTURE3D,    32,    16,   8, 1,    6,    false, false },
+        { DXGI_FORMAT_R32_FLOAT,            DDS_DIMENSION_TEXTURE1D,    1024,  1,    1, 3,    11,   false, false },
+        { DXGI_FORMAT_R8_UNORM,             DDS_DIMENSION_TEXTURE2D,    2048,  1024, 1, 1,    1,    false, true },
+        { DXGI_FORMAT_BC4_UNORM,            DDS_DIMENSION_TEXTURE2D,    4,     4,    1, 1,    1,    false, false },
+    };
+
+    bool RoundTrip(const std::vector<uint8_t>& dds, std::vector<uint8_t>& blob)
+    {
+        TEST_VERIFY(SUCCEEDED(CompressDDS(dds.data(), dds.size(), blob)));
+        TEST_VERIFY(IsCompressedDDS(blob.data(), blob.size()));
+        TEST_VERIFY(!IsCompressedDDS(dds.data(), dds.size()));
+
+        std::unique_ptr<uint8_t[]> ddsData;
+        size_t ddsDataSize = 0;
+        TEST_VERIFY(SUCCEEDED(DecompressDDS(blob.data(), blob.size(), ddsData, ddsDataSize)));
+        TEST_VERIFY(ddsDataSize == dds.size());
+        TEST_VERIFY(memcmp(ddsData.get(), dds.data(), dds.size()) == 0);
+
+        return true;
+    }
+
+    // The expanded file is the original, byte for byte, for every kind of texture.
+    bool TestDDSZRoundTrip()
+    {
+        for (size_t j = 0; j < std::size(g_Textures); ++j)
+        {
+            auto dds = MakeDDS(g_Textures[j], uint32_t(50 + j));
+
+            std::vector<uint8_t> blob;
+            if (!RoundTrip(dds, blob))
+            {
+                printf("\n    texture %zu", j);
+                return false;
+            }
+
+            // The DDS headers are kept as they are after the magic
+            const size_t dataOffset = GetDataOffset(g_Textures[j]);
+            TEST_VERIFY(memcmp(blob.data() + 4, dds.data() + 4, dataOffset - 4) == 0);
+
+            DDSZ_HEADER zhdr;
+            memcpy(&zhdr, blob.data() + dataOffset, sizeof(zhdr));
+            TEST_VERIFY(zhdr.version == DDSZ_VERSION);
+            TEST_VERIFY(zhdr.bitSize == dds.size() - dataOffset);
+
+            // Chunks never straddle a subresource
+            DDSTextureDesc desc = {};
+            TEST_VERIFY(SUCCEEDED(ParseDDS(dds.data(), dds.size(), &desc)));
+            std::vector<DDSSubresource> subresources(desc.subresourceCount);
+            TEST_VERIFY(SUCCEEDED(ParseDDS(dds.data(), dds.size(), &desc, subresources.data(), subresources.size())));
+
+            std::vector<DDSZ_CHUNK> chunks(zhdr.chunkCount);
+            memcpy(chunks.data(), blob.data() + dataOffset + sizeof(zhdr), chunks.size() * sizeof(DDSZ_CHUNK));
+
+            size_t offset = dataOffset;
+            for (const auto& chunk : chunks)
+            {
+                TEST_VERIFY(chunk.packedSize <= chunk.size);
+                for (const auto& it : subresources)
+                {
+                    TEST_VERIFY(it.offset <= offset || it.offset >= offset + chunk.size);
+                }
+                offset += chunk.size;
+            }
+            TEST_VERIFY(offset == dds.size());
+
+            // Bytes past the last subresource survive too
+            dds.insert(dds.end(), { 1, 2, 3, 4, 5 });
+            TEST_VERIFY(RoundTrip(dds, blob));
+        }
+
+        // Smooth data packs well below the original size; noise is stored, not expanded
+        const DDSDesc desc = { DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 1024, 1024, 1, 1, 11, false, false };
+        auto smooth = MakeDDS(desc, 5050);
+        for (size_t j = GetDataOffset(desc); j < smooth.size(); ++j)
+            smooth[j] = static_cast<uint8_t>((j / 4096) & 0xff);
+
+        std::vector<uint8_t> blob;
+        TEST_VERIFY(RoundTrip(smooth, blob));
+        TEST_VERIFY(blob.size() < smooth.size() / 20);
+
+        auto noise = MakeDDS(desc, 505050);
+        const auto bits = MakeData(noise.size() - GetDataOffset(desc), PATTERN_NOISE, 50);
+        memcpy(noise.data() + GetDataOffset(desc), bits.data(), bits.size());
+        TEST_VERIFY(RoundTrip(noise, blob));
+        TEST_VERIFY(blob.size() < noise.size() + 1024);
+
+        return true;
+    }
+
+    // Damaged containers fail cleanly and hand back nothing.
+    bool TestDDSZCorrupt()
+    {
+        const DDSDesc desc = { DXGI_FORMAT_BC3_UNORM, DDS_DIMENSION_TEXTURE2D, 512, 512, 1, 2, 10, false, false };
+        const auto dds = MakeDDS(desc, 50505050);
+
+        std::vector<uint8_t> blob;
+        TEST_VERIFY(SUCCEEDED(CompressDDS(dds.data(), dds.size(), blob)));
+
+        auto expand = [](const std::vector<uint8_t>& data, HRESULT& hr)
+            {
+                std::unique_ptr<uint8_t[]> copy(new uint8_t[std::max<size_t>(data.size(), 1)]);
+                if (!data.empty())
+                    memcpy(copy.get(), data.data(), data.size());
+
+                std::unique_ptr<uint8_t[]> ddsData(new uint8_t[1]);
+                size_t ddsDataSize = 1;
+                hr = DecompressDDS(copy.get(), data.size(), ddsData, ddsDataSize);
+                return FAILED(hr) ? (!ddsData && !ddsDataSize) : (ddsData && ddsDataSize);
+            };
+
+        HRESULT hr;
+
+        // Cut anywhere
+        Random rng(5);
+        for (size_t j = 0; j < 200; ++j)
+        {
+            const size_t size = (j < 100) ? j : rng.Next(uint32_t(blob.size()));
+            TEST_VERIFY(expand(std::vector<uint8_t>(blob.begin(), blob.begin() + size), hr));
+            TEST_VERIFY(FAILED(hr));
+        }
+
+        const size_t zhdrOffset = GetDataOffset(desc);
+        const size_t tableOffset = zhdrOffset + sizeof(DDSZ_HEADER);
+
+        DDSZ_HEADER zhdr;
+        memcpy(&zhdr, blob.data() + zhdrOffset, sizeof(zhdr));
+
+        auto damaged = blob;
+        damaged[zhdrOffset] = DDSZ_VERSION + 1;
+        TEST_VERIFY(expand(damaged, hr) && hr == HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED));
+
+        damaged = blob;
+        const uint32_t moreChunks = zhdr.chunkCount + 1;
+        memcpy(&damaged[zhdrOffset + 4], &moreChunks, sizeof(moreChunks));
+        TEST_VERIFY(expand(damaged, hr) && FAILED(hr));
+
+        damaged = blob;
+        const uint32_t hugeCount = 0x10000000;
+        memcpy(&damaged[zhdrOffset + 4], &hugeCount, sizeof(hugeCount));
+        TEST_VERIFY(expand(damaged, hr) && hr == HRESULT_FROM_WIN32(ERROR_HANDLE_EOF));
+
+        damaged = blob;
+        const uint32_t smallerBits = zhdr.bitSize - 1;
+        memcpy(&damaged[zhdrOffset + 8], &smallerBits, sizeof(smallerBits));
+        TEST_VERIFY(expand(damaged, hr) && hr == HRESULT_FROM_WIN32(ERROR_INVALID_DATA));
+
+        // A chunk claiming to be larger packed than raw, or empty
+        DDSZ_CHUNK chunk;
+        memcpy(&chunk, &blob[tableOffset], sizeof(chunk));
+
+        damaged = blob;
+        const DDSZ_CHUNK inverted = { chunk.size, chunk.size + 1 };
+        memcpy(&damaged[tableOffset], &inverted, sizeof(inverted));
+        TEST_VERIFY(expand(damaged, hr) && hr == HRESULT_FROM_WIN32(ERROR_INVALID_DATA));
+
+        damaged = blob;
+        const DDSZ_CHUNK empty = { 0, 0 };
+        memcpy(&damaged[tableOffset], &empty, sizeof(empty));
+        TEST_VERIFY(expand(damaged, hr) && hr == HRESULT_FROM_WIN32(ERROR_INVALID_DATA));
+
+        // Damage in the payload can only be caught by the codec, and must never overrun
+        const size_t payloadOffset = tableOffset + zhdr.chunkCount * sizeof(DDSZ_CHUNK);
+        for (size_t j = 0; j < 200; ++j)
+        {
+            damaged = blob;
+            damaged[payloadOffset + rng.Next(uint32_t(blob.size() - payloadOffset))] ^= static_cast<uint8_t>(1 + rng.Next(255));
+            TEST_VERIFY(expand(damaged, hr));
+            TEST_VERIFY(SUCCEEDED(hr) || hr == HRESULT_FROM_WIN32(ERROR_INVALID_DATA));
+        }
+
+        // Plain DDS files are not containers, and containers are not plain DDS files
+        TEST_VERIFY(expand(dds, hr) && hr == E_FAIL);
+
+        std::vector<uint8_t> nested = { 1 };
+        TEST_VERIFY(FAILED(CompressDDS(blob.data(), blob.size(), nested)));
+        TEST_VERIFY(nested.empty());
+
+        auto bad = dds;
+        bad.resize(bad.size() - 1);
+        nested = { 1 };
+        TEST_VERIFY(FAILED(CompressDDS(bad.data(), bad.size(), nested)));
+        TEST_VERIFY(nested.empty());
+
+        std::unique_ptr<uint8_t[]> ddsData;
+        size_t ddsDataSize = 0;
+        TEST_VERIFY(DecompressDDS(nullptr, 100, ddsData, ddsDataSize) == E_POINTER);
+
+        return true;
+    }
+
+    bool TestIsCompressedDDS()
+    {
+        const uint32_t magic = DDSZ_MAGIC;
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&magic);
+
+        TEST_VERIFY(IsCompressedDDS(bytes, sizeof(magic)));
+        TEST_VERIFY(!IsCompressedDDS(bytes, sizeof(magic) - 1));
+        TEST_VERIFY(!IsCompressedDDS(nullptr, sizeof(magic)));
+
+        const uint32_t plain = DDS_MAGIC;
+        TEST_VERIFY(!IsCompressedDDS(reinterpret_cast<const uint8_t*>(&plain), sizeof(plain)));
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "LZRoundTrip", TestLZRoundTrip },
+        { "LZDestTooSmall", TestLZDestTooSmall },
+        { "LZCorrupt", TestLZCorrupt },
+        { "DDSZRoundTrip", TestDDSZRoundTrip },
+        { "DDSZCorrupt", TestDDSZCorrupt },
+        { "IsCompressedDDS", TestIsCompressedDDS },
+    };
+}
+
+int __cdecl main()
+{
+    return RunTests(g_Tests);
+}
@@ -0,0 +1,150 @@
+//--------------------------------------------------------------------------------------
+// File: ddszbench.cpp
+//
+// Compares DDSZ container sizes with the plain DDS files, and measures CompressDDS,
+// DecompressDDS, and single chunk LZDecompress throughput
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "DDSCompression.h"
+#include "DDSHelpers.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    enum CONTENT
+    {
+        CONTENT_NOISE,      // MakeDDS noise with short runs
+        CONTENT_SMOOTH,     // Slow ramps, like flat colored or masked textures
+        CONTENT_BLOCKS,     // Repeated BC blocks, as from solid areas
+    };
+
+    struct Case
+    {
+        const char*     name;
+        DDSDesc         desc;
+        CONTENT         content;
+    };
+
+    const Case g_Cases[] =
+    {
+        { "RGBA8 2048 noise",   { DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 2048, 2048, 1, 1, 12, false, false }, CONTENT_NOISE },
+        { "RGBA8 2048 smooth",  { DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 2048, 2048, 1, 1, 12, false, false }, CONTENT_SMOOTH },
+        { "BC1 4096 blocks",    { DXGI_FORMAT_BC1_UNORM, DDS_DIMENSION_TEXTURE2D, 4096, 4096, 1, 1, 13, false, true }, CONTENT_BLOCKS },
+        { "BC7 2048 noise",     { DXGI_FORMAT_BC7_UNORM, DDS_DIMENSION_TEXTURE2D, 2048, 2048, 1, 1, 12, false, false }, CONTENT_NOISE },
+        { "RGBA16F cube smooth", { DXGI_FORMAT_R16G16B16A16_FLOAT, DDS_DIMENSION_TEXTURE2D, 512, 512, 1, 1, 10, true, false }, CONTENT_SMOOTH },
+    };
+
+    std::vector<uint8_t> MakeFile(const Case& test)
+    {
+        auto dds = MakeDDS(test.desc, 50);
+        const size_t dataOffset = GetDataOffset(test.desc);
+
+        switch (test.content)
+        {
+        case CONTENT_SMOOTH:
+            for (size_t j = dataOffset; j < dds.size(); ++j)
+                dds[j] = static_cast<uint8_t>(((j - dataOffset) / 8192) + ((j & 3) << 6));
+            break;
+
+        case CONTENT_BLOCKS:
+            {
+                // A few distinct 8 byte blocks, each repeated for a stretch
+                Random rng(5050);
+                for (size_t j = dataOffset; j + 8 <= dds.size(); j += 8)
+                {
+                    if (((j - dataOffset) % 512) == 0 && rng.Next(4) == 0)
+                    {
+                        for (size_t k = 0; k < 8; ++k)
+                            dds[j + k] = static_cast<uint8_t>(rng.Next());
+                    }
+                    else if (j >= dataOffset + 8)
+                    {
+                        memcpy(&dds[j], &dds[j - 8], 8);
+                    }
+                }
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        return dds;
+    }
+}
+
+int __cdecl main()
+{
+    printf("%-20s %10s %10s %7s %12s %12s %12s\n", "File", "DDS (KB)", "DDSZ (KB)", "ratio", "pack MB/s", "unpack MB/s", "LZ MB/s");
+
+    for (const auto& it : g_Cases)
+    {
+        const auto dds = MakeFile(it);
+        const double megabytes = double(dds.size()) / (1024.0 * 1024.0);
+
+        std::vector<uint8_t> blob;
+        bool failed = false;
+
+        const double packSeconds = Measure([&]()
+            {
+                if (FAILED(CompressDDS(dds.data(), dds.size(), blob)))
+                    failed = true;
+            }, 3, 0.5);
+
+        std::unique_ptr<uint8_t[]> ddsData;
+        size_t ddsDataSize = 0;
+        const double unpackSeconds = Measure([&]()
+            {
+                if (FAILED(DecompressDDS(blob.data(), blob.size(), ddsData, ddsDataSize)))
+                    failed = true;
+            });
+
+        if (failed || ddsDataSize != dds.size() || memcmp(ddsData.get(), dds.data(), dds.size()) != 0)
+        {
+            printf("ERROR: %s doesn't round trip\n", it.name);
+            return 1;
+        }
+
+        // The codec alone, on the whole image data as one block, on one thread
+        const size_t dataOffset = GetDataOffset(it.desc);
+        const size_t bitSize = dds.size() - dataOffset;
+        std::vector<uint8_t> packed(LZCompressBound(bitSize));
+        packed.resize(LZCompress(dds.data() + dataOffset, bitSize, packed.data(), packed.size()));
+
+        std::unique_ptr<uint8_t[]> bits(new uint8_t[bitSize]);
+        const double lzSeconds = Measure([&]()
+            {
+                if (!LZDecompress(packed.data(), packed.size(), bits.get(), bitSize))
+                    failed = true;
+            });
+
+        if (failed)
+        {
+            printf("ERROR: %s failed to decompress\n", it.name);
+            return 1;
+        }
+
+        printf("%-20s %10.0f %10.0f %6.1f%% %12.1f %12.1f %12.1f\n", it.name,
+            double(dds.size()) / 1024.0, double(blob.size()) / 1024.0, 100.0 * double(blob.size()) / double(dds.size()),
+            megabytes / packSeconds, megabytes / unpackSeconds, double(bitSize) / (1024.0 * 1024.0) / lzSeconds);
+    }
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+//--------------------------------------------------------------------------------------
+// File: ddsparsebench.cpp
+//
+// Measures ParseDDS on headers alone and with the full subresource layout
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "DDSParser.h"
+#include "DDSHelpers.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    struct Case
+    {
+        const char* name;
+        DDSDesc     desc;
+    };
+
+    const Case g_Cases[] =
+    {
+        { "2D 1024x1024 BC1, 11 mips (legacy)",  { DXGI_FORMAT_BC1_UNORM,          DDS_DIMENSION_TEXTURE2D, 1024, 1024, 1, 1,  11, false, true } },
+        { "2D 2048x2048 BC7, 12 mips",           { DXGI_FORMAT_BC7_UNORM,          DDS_DIMENSION_TEXTURE2D, 2048, 2048, 1, 1,  12, false, false } },
+        { "Cube 256 RGBA8, 9 mips",              { DXGI_FORMAT_R8G8B8A8_UNORM,     DDS_DIMENSION_TEXTURE2D, 256,  256,  1, 1,  9,  true,  false } },
+        { "2D array 64 x 128x128 BC3, 8 mips",   { DXGI_FORMAT_BC3_UNORM,          DDS_DIMENSION_TEXTURE2D, 128,  128,  1, 64, 8,  false, false } },
+        { "3D 64x64x64 RGBA16F, 7 mips",         { DXGI_FORMAT_R16G16B16A16_FLOAT, DDS_DIMENSION_TEXTURE3D, 64,   64,   64, 1, 7,  false, false } },
+    };
+
+    constexpr size_t c_parses = 10000;
+}
+
+int __cdecl main()
+{
+    printf("%-38s %14s %14s %12s\n", "Texture", "desc (ns)", "layout (ns)", "subresources");
+
+    for (const auto& it : g_Cases)
+    {
+        const auto dds = MakeDDS(it.desc, 1);
+
+        DDSTextureDesc desc;
+        if (FAILED(ParseDDS(dds.data(), dds.size(), &desc)))
+        {
+            printf("ERROR: %s failed to parse\n", it.name);
+            return 1;
+        }
+
+        std::vector<DDSSubresource> subresources(desc.subresourceCount);
+
+        volatile size_t sink = 0;
+
+        const double descOnly = Measure([&]()
+            {
+                for (size_t j = 0; j < c_parses; ++j)
+                {
+                    (void)ParseDDS(dds.data(), dds.size(), &desc);
+                    sink = sink + desc.subresourceCount;
+                }
+            });
+
+        const double layout = Measure([&]()
+            {
+                for (size_t j = 0; j < c_parses; ++j)
+                {
+                    (void)ParseDDS(dds.data(), dds.size(), &desc, subresources.data(), subresources.size());
+                    sink = sink + subresources.back().offset;
+                }
+            });
+
+        printf("%-38s %14.1f %14.1f %12zu\n", it.name,
+            descOnly * 1e9 / c_parses, layout * 1e9 / c_parses, subresources.size());
+    }
+
+    return 0;
+}
@@ -0,0 +1,433 @@
+//--------------------------------------------------------------------------------------
+// File: ddsparser.cpp
+//
+// Tests for ParseDDS, the device-independent DDS validation shared by the loaders
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include "DDSParser.h"
+#include "DDSHelpers.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    constexpr size_t c_HeaderOffset = sizeof(uint32_t);
+    constexpr size_t c_ExtOffset = sizeof(uint32_t) + sizeof(DDS_HEADER);
+
+    DDS_HEADER GetHeader(const std::vector<uint8_t>& dds)
+    {
+        DDS_HEADER header;
+        memcpy(&header, dds.data() + c_HeaderOffset, sizeof(header));
+        return header;
+    }
+
+    void SetHeader(std::vector<uint8_t>& dds, const DDS_HEADER& header)
+    {
+        memcpy(dds.data() + c_HeaderOffset, &header, sizeof(header));
+    }
+
+    DDS_HEADER_DXT10 GetExt(const std::vector<uint8_t>& dds)
+    {
+        DDS_HEADER_DXT10 ext;
+        memcpy(&ext, dds.data() + c_ExtOffset, sizeof(ext));
+        return ext;
+    }
+
+    void SetExt(std::vector<uint8_t>& dds, const DDS_HEADER_DXT10& ext)
+    {
+        memcpy(dds.data() + c_ExtOffset, &ext, sizeof(ext));
+    }
+
+    HRESULT Parse(const std::vector<uint8_t>& dds, DDSTextureDesc& desc)
+    {
+        return ParseDDS(dds.data(), dds.size(), &desc);
+    }
+
+    // Every subresource must lie inside the data, after the headers, without overlapping.
+    bool InBounds(const std::vector<uint8_t>& dds, DDSTextureDesc& desc)
+    {
+        std::vector<DDSSubresource> subresources(desc.subresourceCount);
+        TEST_VERIFY(SUCCEEDED(ParseDDS(dds.data(), dds.size(), &desc, subresources.data(), subresources.size())));
+
+        size_t end = desc.dataOffset;
+        for (const auto& it : subresources)
+        {
+            TEST_VERIFY(it.offset >= end);
+            TEST_VERIFY(it.size <= dds.size() - it.offset);
+            TEST_VERIFY(it.size == it.slicePitch * it.depth);
+            end = it.offset + it.size;
+        }
+
+        return true;
+    }
+
+    const DDSDesc g_Textures[] =
+    {
+        // format                           dimension                   w      h     d  array mips  cube   legacy
+        { DXGI_FORMAT_R8G8B8A8_UNORM,       DDS_DIMENSION_TEXTURE2D,    256,   256,  1, 1,    9,    false, false },
+        { DXGI_FORMAT_R8G8B8A8_UNORM,       DDS_DIMENSION_TEXTURE2D,    300,   200,  1, 1,    1,    false, true },
+        { DXGI_FORMAT_B8G8R8A8_UNORM,       DDS_DIMENSION_TEXTURE2D,    17,    33,   1, 1,    6,    false, true },
+        { DXGI_FORMAT_B5G6R5_UNORM,         DDS_DIMENSION_TEXTURE2D,    64,    32,   1, 1,    7,    false, true },
+        { DXGI_FORMAT_R8_UNORM,             DDS_DIMENSION_TEXTURE2D,    5,     3,    1, 1,    3,    false, true },
+        { DXGI_FORMAT_BC1_UNORM,            DDS_DIMENSION_TEXTURE2D,    252,   124,  1, 1,    8,    false, true },
+        { DXGI_FORMAT_BC3_UNORM,            DDS_DIMENSION_TEXTURE2D,    128,   128,  1, 4,    8,    false, false },
+        { DXGI_FORMAT_BC4_UNORM,            DDS_DIMENSION_TEXTURE2D,    64,    64,   1, 1,    7,    false, true },
+        { DXGI_FORMAT_BC5_UNORM,            DDS_DIMENSION_TEXTURE2D,    64,    16,   1, 1,    7,    false, true },
+        { DXGI_FORMAT_BC7_UNORM,            DDS_DIMENSION_TEXTURE2D,    6,     10,   1, 1,    4,    false, false },
+        { DXGI_FORMAT_R8G8B8A8_UNORM,       DDS_DIMENSION_TEXTURE2D,    64,    64,   1, 1,    7,    true,  true },
+        { DXGI_FORMAT_BC1_UNORM,            DDS_DIMENSION_TEXTURE2D,    32,    32,   1, 2,    6,    true,  false },
+        { DXGI_FORMAT_R16G16B16A16_FLOAT,   DDS_DIMENSION_TEXTURE3D,    32,    16,   8, 1,    6,    false, false },
+        { DXGI_FORMAT_R32_FLOAT,            DDS_DIMENSION_TEXTURE1D,    1024,  1,    1, 3,    11,   false, false },
+        { DXGI_FORMAT_R10G10B10A2_UNORM,    DDS_DIMENSION_TEXTURE2D,    1,     1,    1, 1,    1,    false, false },
+    };
+
+    bool TestValid()
+    {
+        for (size_t j = 0; j < std::size(g_Textures); ++j)
+        {
+            const DDSDesc& expected = g_Textures[j];
+            const auto dds = MakeDDS(expected, uint32_t(44 + j));
+
+            DDSTextureDesc desc;
+            if (FAILED(Parse(dds, desc)))
+            {
+                printf("\n    texture %zu failed to parse", j);
+                return false;
+            }
+
+            const uint32_t items = expected.arraySize * (expected.isCubeMap ? 6u : 1u);
+
+            TEST_VERIFY(uint32_t(desc.dimension) == uint32_t(expected.dimension));
+            TEST_VERIFY(desc.format == expected.format);
+            TEST_VERIFY(desc.width == expected.width);
+            TEST_VERIFY(desc.height == expected.height);
+            TEST_VERIFY(desc.depth == expected.depth);
+            TEST_VERIFY(desc.arraySize == items);
+            TEST_VERIFY(desc.mipLevels == expected.mipLevels);
+            TEST_VERIFY(desc.isCubeMap == expected.isCubeMap);
+            TEST_VERIFY(desc.alphaMode == DDS_ALPHA_MODE_UNKNOWN);
+            TEST_VERIFY(desc.dataOffset == GetDataOffset(expected));
+            TEST_VERIFY(desc.subresourceCount == size_t(items) * expected.mipLevels);
+
+            std::vector<DDSSubresource> subresources(desc.subresourceCount);
+            TEST_VERIFY(SUCCEEDED(ParseDDS(dds.data(), dds.size(), &desc, subresources.data(), subresources.size())));
+
+            const auto surfaces = GetSurfaces(expected, desc.dataOffset);
+            TEST_VERIFY(surfaces.size() == subresources.size());
+
+            for (size_t k = 0; k < surfaces.size(); ++k)
+            {
+                TEST_VERIFY(subresources[k].offset == surfaces[k].offset);
+                TEST_VERIFY(subresources[k].rowPitch == surfaces[k].rowPitch);
+                TEST_VERIFY(subresources[k].slicePitch == surfaces[k].slicePitch);
+                TEST_VERIFY(subresources[k].size == surfaces[k].slicePitch * surfaces[k].depth);
+                TEST_VERIFY(subresources[k].width == surfaces[k].width);
+                TEST_VERIFY(subresources[k].height == surfaces[k].height);
+                TEST_VERIFY(subresources[k].depth == surfaces[k].depth);
+            }
+
+            // The last subresource ends the file
+            TEST_VERIFY(subresources.back().offset + subresources.back().size == dds.size());
+        }
+
+        return true;
+    }
+
+    bool TestArguments()
+    {
+        const DDSDesc texture = { DXGI_FORMAT_BC1_UNORM, DDS_DIMENSION_TEXTURE2D, 64, 64, 1, 2, 7, false, false };
+        const auto dds = MakeDDS(texture, 4);
+
+        DDSTextureDesc desc;
+        TEST_VERIFY(ParseDDS(nullptr, dds.size(), &desc) == E_INVALIDARG);
+        TEST_VERIFY(ParseDDS(dds.data(), dds.size(), nullptr) == E_INVALIDARG);
+
+        DDSSubresource subresources[14] = {};
+        TEST_VERIFY(ParseDDS(dds.data(), dds.size(), &desc, subresources, 13) == HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER));
+        TEST_VERIFY(ParseDDS(dds.data(), dds.size(), &desc, subresources, 14) == S_OK);
+
+        // Trailing data is allowed
+        auto padded = dds;
+        padded.resize(padded.size() + 100);
+        TEST_VERIFY(SUCCEEDED(Parse(padded, desc)));
+
+        return true;
+    }
+
+    bool TestAlphaMode()
+    {
+        const DDSDesc texture = { DXGI_FORMAT_BC3_UNORM, DDS_DIMENSION_TEXTURE2D, 16, 16, 1, 1, 1, false, false };
+        auto dds = MakeDDS(texture, 44);
+
+        DDSTextureDesc desc;
+        for (uint32_t mode = 0; mode < 8; ++mode)
+        {
+            auto ext = GetExt(dds);
+            ext.miscFlags2 = mode | 0x100;
+            SetExt(dds, ext);
+
+            TEST_VERIFY(SUCCEEDED(Parse(dds, desc)));
+            TEST_VERIFY(uint32_t(desc.alphaMode) == ((mode <= DDS_ALPHA_MODE_CUSTOM) ? mode : 0u));
+        }
+
+        // DXT2 and DXT4 are premultiplied forms of BC2 and BC3
+        const DDSDesc legacy = { DXGI_FORMAT_BC3_UNORM, DDS_DIMENSION_TEXTURE2D, 16, 16, 1, 1, 1, false, true };
+        dds = MakeDDS(legacy, 44);
+
+        auto header = GetHeader(dds);
+        header.ddspf = DDSPF_DXT4;
+        SetHeader(dds, header);
+
+        TEST_VERIFY(SUCCEEDED(Parse(dds, desc)));
+        TEST_VERIFY(desc.format == DXGI_FORMAT_BC3_UNORM);
+        TEST_VERIFY(desc.alphaMode == DDS_ALPHA_MODE_PREMULTIPLIED);
+
+        return true;
+    }
+
+    // Every prefix of a valid file is rejected.
+    bool TestTruncated()
+    {
+        const DDSDesc textures[] =
+        {
+            { DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 16, 8, 1, 1, 5, false, true },
+            { DXGI_FORMAT_BC1_UNORM, DDS_DIMENSION_TEXTURE2D, 16, 16, 1, 1, 1, true, false },
+            { DXGI_FORMAT_R8_UNORM, DDS_DIMENSION_TEXTURE3D, 8, 8, 8, 1, 4, false, false },
+        };
+
+        for (const auto& texture : textures)
+        {
+            const auto dds = MakeDDS(texture, 444);
+
+            DDSTextureDesc desc;
+            for (size_t size = 0; size < dds.size(); ++size)
+            {
+                std::vector<uint8_t> data(dds.begin(), dds.begin() + size);
+                data.shrink_to_fit();
+                if (SUCCEEDED(ParseDDS(size ? data.data() : dds.data(), size, &desc)))
+                {
+                    printf("\n    accepted %zu of %zu bytes", size, dds.size());
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Headers that contradict themselves are rejected with the same errors as the loaders give.
+    bool TestBadHeaders()
+    {
+        const DDSDesc texture = { DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 64, 64, 1, 1, 7, false, false };
+        const auto dds = MakeDDS(texture, 4444);
+
+        const HRESULT invalidData = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        const HRESULT notSupported = HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+        const HRESULT endOfFile = HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+
+        DDSTextureDesc desc;
+
+        {
+            auto data = dds;
+            data[0] = 'X';
+            TEST_VERIFY(Parse(data, desc) == E_FAIL);
+        }
+        {
+            auto data = dds;
+            auto header = GetHeader(data);
+            header.size = 0;
+            SetHeader(data, header);
+            TEST_VERIFY(Parse(data, desc) == E_FAIL);
+        }
+        {
+            auto data = dds;
+            auto ext = GetExt(data);
+            ext.arraySize = 0;
+            SetExt(data, ext);
+            TEST_VERIFY(Parse(data, desc) == invalidData);
+        }
+        {
+            auto data = dds;
+            auto ext = GetExt(data);
+            ext.dxgiFormat = DXGI_FORMAT_UNKNOWN;
+            SetExt(data, ext);
+            TEST_VERIFY(Parse(data, desc) == notSupported);
+        }
+        {
+            auto data = dds;
+            auto ext = GetExt(data);
+            ext.resourceDimension = 5;
+            SetExt(data, ext);
+            TEST_VERIFY(Parse(data, desc) == notSupported);
+        }
+        {
+            // A 1D texture with a height
+            auto data = dds;
+            auto ext = GetExt(data);
+            ext.resourceDimension = DDS_DIMENSION_TEXTURE1D;
+            SetExt(data, ext);
+            TEST_VERIFY(Parse(data, desc) == invalidData);
+        }
+        {
+            // A volume without the volume flag, then a volume array
+            auto data = dds;
+            auto ext = GetExt(data);
+            ext.resourceDimension = DDS_DIMENSION_TEXTURE3D;
+            SetExt(data, ext);
+            TEST_VERIFY(Parse(data, desc) == invalidData);
+
+            auto header = GetHeader(data);
+            header.flags |= DDS_HEADER_FLAGS_VOLUME;
+            header.depth = 1;
+            SetHeader(data, header);
+            TEST_VERIFY(SUCCEEDED(Parse(data, desc)));
+
+            ext.arraySize = 2;
+            SetExt(data, ext);
+            TEST_VERIFY(Parse(data, desc) == notSupported);
+        }
+        {
+            auto data = dds;
+            auto header = GetHeader(data);
+            header.width = 0;
+            SetHeader(data, header);
+            TEST_VERIFY(Parse(data, desc) == invalidData);
+        }
+        {
+            // Dimensions whose size can't be represented must not wrap around
+            auto data = dds;
+            auto header = GetHeader(data);
+            header.width = header.height = UINT32_MAX;
+            SetHeader(data, header);
+            TEST_VERIFY(Parse(data, desc) == endOfFile);
+
+            header.width = 65536;
+            header.height = 65536;
+            header.mipMapCount = 1;
+            SetHeader(data, header);
+            TEST_VERIFY(Parse(data, desc) == endOfFile);
+        }
+        {
+            // More array items or mips than there are bytes
+            auto data = dds;
+            auto ext = GetExt(data);
+            ext.arraySize = UINT32_MAX;
+            SetExt(data, ext);
+            TEST_VERIFY(Parse(data, desc) == endOfFile);
+
+            // Six faces of that many cubes don't fit the array size at all
+            ext.miscFlag = DDS_RESOURCE_MISC_TEXTURECUBE;
+            SetExt(data, ext);
+            TEST_VERIFY(Parse(data, desc) == invalidData);
+
+            data = dds;
+            auto header = GetHeader(data);
+            header.mipMapCount = UINT32_MAX;
+            SetHeader(data, header);
+            TEST_VERIFY(Parse(data, desc) == endOfFile);
+        }
+        {
+            // Legacy cubemaps need all six faces
+            const DDSDesc cube = { DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 8, 8, 1, 1, 1, true, true };
+            auto data = MakeDDS(cube, 44444);
+            TEST_VERIFY(SUCCEEDED(Parse(data, desc)));
+
+            auto header = GetHeader(data);
+            header.caps2 &= ~uint32_t(DDS_CUBEMAP_NEGATIVEZ & ~DDS_CUBEMAP);
+            SetHeader(data, header);
+            TEST_VERIFY(Parse(data, desc) == notSupported);
+        }
+        {
+            // Unknown legacy pixel format
+            const DDSDesc legacy = { DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 8, 8, 1, 1, 1, false, true };
+            auto data = MakeDDS(legacy, 444444);
+            auto header = GetHeader(data);
+            header.ddspf.RBitMask = 0x1234;
+            SetHeader(data, header);
+            TEST_VERIFY(Parse(data, desc) == notSupported);
+        }
+
+        return true;
+    }
+
+    // Random corruption anywhere in the headers either fails or describes data inside the file.
+    bool TestMutations()
+    {
+        Random rng(44);
+
+        for (size_t j = 0; j < std::size(g_Textures); ++j)
+        {
+            const auto dds = MakeDDS(g_Textures[j], uint32_t(j));
+            const size_t headerSize = GetDataOffset(g_Textures[j]);
+
+            size_t accepted = 0;
+            for (size_t k = 0; k < 5000; ++k)
+            {
+                auto data = dds;
+
+                const uint32_t edits = 1 + rng.Next(4);
+                for (uint32_t e = 0; e < edits; ++e)
+                {
+                    const size_t offset = rng.Next(uint32_t(headerSize));
+                    switch (rng.Next(3))
+                    {
+                    case 0: data[offset] ^= static_cast<uint8_t>(1u << rng.Next(8)); break;
+                    case 1: data[offset] = static_cast<uint8_t>(rng.Next()); break;
+                    default: data[offset] = (rng.Next(2)) ? 0xFF : 0; break;
+                    }
+                }
+
+                if (rng.Next(4) == 0)
+                {
+                    data.resize(rng.Next(uint32_t(data.size())));
+                    data.shrink_to_fit();
+                }
+
+                DDSTextureDesc desc;
+                if (data.empty() || FAILED(Parse(data, desc)))
+                    continue;
+
+                ++accepted;
+                TEST_VERIFY(desc.subresourceCount == size_t(desc.mipLevels) * desc.arraySize);
+                TEST_VERIFY(desc.dataOffset <= data.size());
+                if (!InBounds(data, desc))
+                    return false;
+            }
+
+            TEST_VERIFY(accepted > 0);
+        }
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "Valid", TestValid },
+        { "Arguments", TestArguments },
+        { "AlphaMode", TestAlphaMode },
+        { "Truncated", TestTruncated },
+        { "BadHeaders", TestBadHeaders },
+        { "Mutations", TestMutations },
+    };
+}
+
+int __cdecl main()
+{
+    return RunTests(g_Tests);
+}
@@ -0,0 +1,139 @@
+//--------------------------------------------------------------------------------------
+// File: ddsloadbench.cpp
+//
+// Compares DDS file load times with and without DDS_LOADER_MEMORY_MAPPED on WARP
+//
+// Usage: ddsloadbench [directory]
+//
+// With a directory, every .dds file in it is loaded; otherwise a generated set is used.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DDSTextureLoader.h"
+#include "DeviceHelpers.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    uint64_t GetFileSize(const wchar_t* fileName)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data = {};
+        if (!GetFileAttributesExW(fileName, GetFileExInfoStandard, &data))
+            return 0;
+
+        return (uint64_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    }
+
+    // Returns the best time to load every file, or a negative value if any load failed.
+    double LoadAll(ID3D11Device* device, const std::vector<std::wstring>& files, DDS_LOADER_FLAGS loadFlags)
+    {
+        bool failed = false;
+
+        const double seconds = Measure([&]()
+            {
+                for (const auto& it : files)
+                {
+                    ComPtr<ID3D11Resource> texture;
+                    if (FAILED(CreateDDSTextureFromFileEx(device, it.c_str(), 0,
+                        D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, loadFlags,
+                        texture.GetAddressOf(), nullptr)))
+                    {
+                        failed = true;
+                    }
+                }
+            }, 3, 1.0);
+
+        return failed ? -1.0 : seconds;
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+{
+    ComPtr<ID3D11Device> device;
+    if (FAILED(CreateWarpDevice(device.GetAddressOf(), nullptr)))
+    {
+        printf("ERROR: Can't create a WARP device\n");
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<TempFile>> generated;
+    std::vector<std::wstring> files;
+
+    if (argc > 1)
+    {
+        std::wstring pattern = argv[1];
+        pattern += L"\\*.dds";
+
+        WIN32_FIND_DATAW findData = {};
+        HANDLE hFind = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, 0);
+        if (hFind == INVALID_HANDLE_VALUE)
+        {
+            wprintf(L"ERROR: No DDS files in %ls\n", argv[1]);
+            return 1;
+        }
+
+        do
+        {
+            if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+            {
+                files.emplace_back(std::wstring(argv[1]) + L"\\" + findData.cFileName);
+            }
+        }
+        while (FindNextFileW(hFind, &findData));
+
+        FindClose(hFind);
+    }
+    else
+    {
+        // A level's worth of block compressed textures and a few uncompressed ones
+        for (uint32_t j = 0; j < 40; ++j)
+        {
+            const DDSDesc desc = (j % 5)
+                ? DDSDesc{ DXGI_FORMAT_BC1_UNORM, DDS_DIMENSION_TEXTURE2D, 2048, 2048, 1, 1, 12, false, false }
+                : DDSDesc{ DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 1024, 1024, 1, 1, 11, false, false };
+
+            generated.emplace_back(new TempFile((L"bench" + std::to_wstring(j) + L".dds").c_str(), MakeDDS(desc, j)));
+            files.emplace_back(generated.back()->GetPath());
+        }
+    }
+
+    uint64_t totalBytes = 0;
+    for (const auto& it : files)
+    {
+        totalBytes += GetFileSize(it.c_str());
+    }
+
+    const double megabytes = double(totalBytes) / (1024.0 * 1024.0);
+    printf("%zu files, %.1f MB\n", files.size(), megabytes);
+
+    const double heapTime = LoadAll(device.Get(), files, DDS_LOADER_DEFAULT);
+    const double mappedTime = LoadAll(device.Get(), files, DDS_LOADER_MEMORY_MAPPED);
+
+    if (heapTime < 0 || mappedTime < 0)
+    {
+        printf("ERROR: Failed to load the files\n");
+        return 1;
+    }
+
+    printf("read:   %8.1f ms  %8.1f MB/s\n", heapTime * 1000.0, megabytes / heapTime);
+    printf("mapped: %8.1f ms  %8.1f MB/s\n", mappedTime * 1000.0, megabytes / mappedTime);
+
+    return 0;
+}
@@ -0,0 +1,262 @@
+//--------------------------------------------------------------------------------------
+// File: ddstextureloader.cpp
+//
+// Tests that DDS_LOADER_MEMORY_MAPPED loads create the same textures as regular file
+// loads, and fail the same way on bad files. Runs on a WARP device.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "DDSTextureLoader.h"
+#include "DeviceHelpers.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    ComPtr<ID3D11Device> g_device;
+    ComPtr<ID3D11DeviceContext> g_context;
+
+    struct LoadResult
+    {
+        HRESULT                             hr;
+        ComPtr<ID3D11Resource>              texture;
+        ComPtr<ID3D11ShaderResourceView>    textureView;
+        DDS_ALPHA_MODE                      alphaMode;
+    };
+
+    LoadResult Load(const wchar_t* fileName, DDS_LOADER_FLAGS loadFlags)
+    {
+        LoadResult result = {};
+        result.hr = CreateDDSTextureFromFileEx(g_device.Get(), fileName, 0,
+            D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, loadFlags,
+            result.texture.GetAddressOf(), result.textureView.GetAddressOf(), &result.alphaMode);
+        return result;
+    }
+
+    // The texture must hold exactly the subresources of the file it was loaded from.
+    bool MatchesFile(ID3D11Resource* texture, const DDSDesc& desc, const std::vector<uint8_t>& dds)
+    {
+        std::vector<std::vector<uint8_t>> subresources;
+        TEST_VERIFY(SUCCEEDED(ReadTexture(g_device.Get(), g_context.Get(), texture, subresources)));
+
+        const auto surfaces = GetSurfaces(desc, GetDataOffset(desc));
+        TEST_VERIFY(subresources.size() == surfaces.size());
+
+        for (size_t j = 0; j < surfaces.size(); ++j)
+        {
+            const size_t size = surfaces[j].slicePitch * surfaces[j].depth;
+            TEST_VERIFY(subresources[j].size() == size);
+            TEST_VERIFY(memcmp(subresources[j].data(), dds.data() + surfaces[j].offset, size) == 0);
+        }
+
+        return true;
+    }
+
+    bool SameDesc(ID3D11Resource* a, ID3D11Resource* b)
+    {
+        D3D11_RESOURCE_DIMENSION typeA, typeB;
+        a->GetType(&typeA);
+        b->GetType(&typeB);
+        TEST_VERIFY(typeA == typeB);
+
+        switch (typeA)
+        {
+        case D3D11_RESOURCE_DIMENSION_TEXTURE1D:
+            {
+                D3D11_TEXTURE1D_DESC descA, descB;
+                static_cast<ID3D11Texture1D*>(a)->GetDesc(&descA);
+                static_cast<ID3D11Texture1D*>(b)->GetDesc(&descB);
+                TEST_VERIFY(memcmp(&descA, &descB, sizeof(descA)) == 0);
+            }
+            break;
+
+        case D3D11_RESOURCE_DIMENSION_TEXTURE2D:
+            {
+                D3D11_TEXTURE2D_DESC descA, descB;
+                static_cast<ID3D11Texture2D*>(a)->GetDesc(&descA);
+                static_cast<ID3D11Texture2D*>(b)->GetDesc(&descB);
+                TEST_VERIFY(memcmp(&descA, &descB, sizeof(descA)) == 0);
+            }
+            break;
+
+        case D3D11_RESOURCE_DIMENSION_TEXTURE3D:
+            {
+                D3D11_TEXTURE3D_DESC descA, descB;
+                static_cast<ID3D11Texture3D*>(a)->GetDesc(&descA);
+                static_cast<ID3D11Texture3D*>(b)->GetDesc(&descB);
+                TEST_VERIFY(memcmp(&descA, &descB, sizeof(descA)) == 0);
+            }
+            break;
+
+        default:
+            return false;
+        }
+
+        return true;
+    }
+
+    const DDSDesc g_Textures[] =
+    {
+        // format                           dimension                   w      h     d  array mips  cube   legacy
+        { DXGI_FORMAT_R8G8B8A8_UNORM,       DDS_DIMENSION_TEXTURE2D,    256,   256,  1, 1,    9,    false, false },
+        { DXGI_FORMAT_R8G8B8A8_UNORM,       DDS_DIMENSION_TEXTURE2D,    300,   200,  1, 1,    1,    false, true },
+        { DXGI_FORMAT_B5G6R5_UNORM,         DDS_DIMENSION_TEXTURE2D,    64,    32,   1, 1,    7,    false, true },
+        { DXGI_FORMAT_BC1_UNORM,            DDS_DIMENSION_TEXTURE2D,    256,   128,  1, 1,    9,    false, true },
+        { DXGI_FORMAT_BC3_UNORM,            DDS_DIMENSION_TEXTURE2D,    128,   128,  1, 4,    8,    false, false },
+        { DXGI_FORMAT_BC7_UNORM,            DDS_DIMENSION_TEXTURE2D,    512,   256,  1, 1,    10,   false, false },
+        { DXGI_FORMAT_R8G8B8A8_UNORM,       DDS_DIMENSION_TEXTURE2D,    64,    64,   1, 1,    7,    true,  true },
+        { DXGI_FORMAT_BC1_UNORM,            DDS_DIMENSION_TEXTURE2D,    32,    32,   1, 2,    6,    true,  false },
+        { DXGI_FORMAT_R16G16B16A16_FLOAT,   DDS_DIMENSION_TEXTURE3D,    32,    16,   8, 1,    6,    false, false },
+        { DXGI_FORMAT_R32_FLOAT,            DDS_DIMENSION_TEXTURE1D,    1024,  1,    1, 3,    11,   false, false },
+        { DXGI_FORMAT_R8_UNORM,             DDS_DIMENSION_TEXTURE2D,    4096,  2048, 1, 1,    1,    false, true },
+    };
+
+    bool TestMatchesFileLoad()
+    {
+        for (size_t j = 0; j < std::size(g_Textures); ++j)
+        {
+            const DDSDesc& desc = g_Textures[j];
+            const auto dds = MakeDDS(desc, uint32_t(43 + j));
+            const TempFile file((L"mapped" + std::to_wstring(j) + L".dds").c_str(), dds);
+
+            const auto heap = Load(file.GetPath(), DDS_LOADER_DEFAULT);
+            const auto mapped = Load(file.GetPath(), DDS_LOADER_MEMORY_MAPPED);
+
+            if (FAILED(heap.hr) || FAILED(mapped.hr))
+            {
+                printf("\n    texture %zu: %08X %08X", j, static_cast<unsigned int>(heap.hr), static_cast<unsigned int>(mapped.hr));
+                return false;
+            }
+
+            TEST_VERIFY(mapped.textureView);
+            TEST_VERIFY(heap.alphaMode == mapped.alphaMode);
+            TEST_VERIFY(SameDesc(heap.texture.Get(), mapped.texture.Get()));
+            TEST_VERIFY(MatchesFile(heap.texture.Get(), desc, dds));
+            TEST_VERIFY(MatchesFile(mapped.texture.Get(), desc, dds));
+        }
+
+        return true;
+    }
+
+    // Mapping is only for file loads; the flag changes nothing else about the texture.
+    bool TestFlagsCombine()
+    {
+        const DDSDesc desc = { DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 64, 64, 1, 1, 7, false, false };
+        const auto dds = MakeDDS(desc, 4343);
+        const TempFile file(L"srgb.dds", dds);
+
+        const auto mapped = Load(file.GetPath(), DDS_LOADER_MEMORY_MAPPED | DDS_LOADER_FORCE_SRGB);
+        TEST_VERIFY(SUCCEEDED(mapped.hr));
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+        mapped.textureView->GetDesc(&viewDesc);
+        TEST_VERIFY(viewDesc.Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB);
+
+        // From memory the flag is ignored
+        ComPtr<ID3D11Resource> texture;
+        TEST_VERIFY(SUCCEEDED(CreateDDSTextureFromMemoryEx(g_device.Get(), dds.data(), dds.size(), 0,
+            D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, DDS_LOADER_MEMORY_MAPPED,
+            texture.GetAddressOf(), nullptr)));
+        TEST_VERIFY(MatchesFile(texture.Get(), desc, dds));
+
+        return true;
+    }
+
+    // Bad files fail with the same error either way, and leave nothing behind.
+    bool TestErrors()
+    {
+        const DDSDesc desc = { DXGI_FORMAT_BC1_UNORM, DDS_DIMENSION_TEXTURE2D, 256, 256, 1, 1, 9, false, false };
+        const auto dds = MakeDDS(desc, 434343);
+
+        std::vector<std::vector<uint8_t>> files;
+        files.emplace_back();                                           // Empty
+        files.emplace_back(dds.begin(), dds.begin() + 64);              // Part of the header
+        files.emplace_back(dds.begin(), dds.begin() + GetDataOffset(desc));
+        files.emplace_back(dds.begin(), dds.end() - 1);                 // One byte short
+        files.push_back(dds);
+        files.back()[0] = 'X';                                          // Bad magic
+        files.push_back(dds);
+        files.back()[4] = 0;                                            // Bad header size
+
+        for (size_t j = 0; j < files.size(); ++j)
+        {
+            const TempFile file((L"bad" + std::to_wstring(j) + L".dds").c_str(), files[j]);
+
+            const auto heap = Load(file.GetPath(), DDS_LOADER_DEFAULT);
+            const auto mapped = Load(file.GetPath(), DDS_LOADER_MEMORY_MAPPED);
+
+            if (SUCCEEDED(heap.hr) || heap.hr != mapped.hr)
+            {
+                printf("\n    file %zu: %08X %08X", j, static_cast<unsigned int>(heap.hr), static_cast<unsigned int>(mapped.hr));
+                return false;
+            }
+
+            TEST_VERIFY(!mapped.texture);
+            TEST_VERIFY(!mapped.textureView);
+        }
+
+        const auto missing = Load(L"DirectXTKTest_missing.dds", DDS_LOADER_MEMORY_MAPPED);
+        TEST_VERIFY(FAILED(missing.hr));
+        TEST_VERIFY(missing.hr == Load(L"DirectXTKTest_missing.dds", DDS_LOADER_DEFAULT).hr);
+
+        return true;
+    }
+
+    // The mapping is closed once the texture exists, so the file can be replaced right away.
+    bool TestFileReleased()
+    {
+        const DDSDesc desc = { DXGI_FORMAT_R8G8B8A8_UNORM, DDS_DIMENSION_TEXTURE2D, 128, 128, 1, 1, 1, false, false };
+        const auto dds = MakeDDS(desc, 43434343);
+
+        std::wstring path;
+        ComPtr<ID3D11Resource> texture;
+        {
+            const TempFile file(L"released.dds", dds);
+            path = file.GetPath();
+
+            auto mapped = Load(file.GetPath(), DDS_LOADER_MEMORY_MAPPED);
+            TEST_VERIFY(SUCCEEDED(mapped.hr));
+            texture = mapped.texture;
+        }
+
+        TEST_VERIFY(GetFileAttributesW(path.c_str()) == INVALID_FILE_ATTRIBUTES);
+        TEST_VERIFY(MatchesFile(texture.Get(), desc, dds));
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "MatchesFileLoad", TestMatchesFileLoad },
+        { "FlagsCombine", TestFlagsCombine },
+        { "Errors", TestErrors },
+        { "FileReleased", TestFileReleased },
+    };
+}
+
+int __cdecl main()
+{
+    if (FAILED(CreateWarpDevice(g_device.GetAddressOf(), g_context.GetAddressOf())))
+    {
+        printf("ERROR: Can't create a WARP device\n");
+        return 1;
+    }
+
+    return RunTests(g_Tests);
+}
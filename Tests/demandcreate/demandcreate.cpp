@@ -0,0 +1,392 @@
+//--------------------------------------------------------------------------------------
+// File: demandcreate.cpp
+//
+// Tests for the lazily created resources in DemandCreate.h and the per-device
+// instance lookups in SharedResourcePool.h, including under thread contention
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "DemandCreate.h"
+#include "SharedResourcePool.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    std::atomic<int> g_liveObjects(0);
+
+    // Stands in for a D3D object: AtomicComPtr only needs Release.
+    class TestObject
+    {
+    public:
+        explicit TestObject(uint32_t value) noexcept : mValue(value) { ++g_liveObjects; }
+
+        TestObject(TestObject const&) = delete;
+        TestObject& operator= (TestObject const&) = delete;
+
+        ULONG Release() noexcept
+        {
+            delete this;
+            return 0;
+        }
+
+        uint32_t GetValue() const noexcept { return mValue; }
+
+    private:
+        ~TestObject() { --g_liveObjects; }
+
+        uint32_t mValue;
+    };
+
+    // Keyed by a fake device pointer, as the effect and factory pools are.
+    class PoolData
+    {
+    public:
+        PoolData(int* device, uint32_t tag) : mDevice(device), mTag(tag)
+        {
+            ++g_liveObjects;
+        }
+
+        PoolData(PoolData const&) = delete;
+        PoolData& operator= (PoolData const&) = delete;
+
+        ~PoolData() { --g_liveObjects; }
+
+        int* mDevice;
+        uint32_t mTag;
+    };
+
+    using Pool = SharedResourcePool<int*, PoolData, uint32_t>;
+
+    template<typename Fn>
+    void RunThreads(size_t count, Fn&& fn)
+    {
+        std::vector<std::thread> threads;
+        for (size_t j = 0; j < count; ++j)
+        {
+            threads.emplace_back(fn, j);
+        }
+
+        for (auto& it : threads)
+        {
+            it.join();
+        }
+    }
+
+    constexpr size_t c_ThreadCount = 8;
+
+    // Holds each thread until all of them are running, so they reach the code under test together.
+    void Rendezvous(std::atomic<size_t>& ready)
+    {
+        ++ready;
+        while (ready.load() < c_ThreadCount)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    bool TestDemandCreate()
+    {
+        {
+            AtomicComPtr<TestObject> ptr;
+            std::mutex mutex;
+
+            TEST_VERIFY(ptr.Get() == nullptr);
+
+            // A failed creation throws and leaves nothing published
+            bool threw = false;
+            try
+            {
+                DemandCreate(ptr, mutex, [](TestObject**) noexcept { return E_OUTOFMEMORY; });
+            }
+            catch (const com_exception& e)
+            {
+                threw = (e.get_result() == E_OUTOFMEMORY);
+            }
+            TEST_VERIFY(threw);
+            TEST_VERIFY(ptr.Get() == nullptr);
+
+            int calls = 0;
+            auto create = [&](TestObject** result)
+            {
+                ++calls;
+                *result = new TestObject(42);
+                return S_OK;
+            };
+
+            TestObject* first = DemandCreate(ptr, mutex, create);
+            TestObject* second = DemandCreate(ptr, mutex, create);
+
+            TEST_VERIFY(first != nullptr);
+            TEST_VERIFY(first == second);
+            TEST_VERIFY(first->GetValue() == 42);
+            TEST_VERIFY(calls == 1);
+            TEST_VERIFY(g_liveObjects == 1);
+        }
+
+        // The owner released it
+        TEST_VERIFY(g_liveObjects == 0);
+
+        return true;
+    }
+
+    // Many threads racing on first use must create the object exactly once.
+    bool TestDemandCreateThreads()
+    {
+        for (size_t round = 0; round < 200; ++round)
+        {
+            AtomicComPtr<TestObject> ptr;
+            std::mutex mutex;
+            std::atomic<int> calls(0);
+            std::atomic<size_t> ready(0);
+            TestObject* seen[c_ThreadCount] = {};
+
+            RunThreads(c_ThreadCount, [&](size_t index)
+                {
+                    Rendezvous(ready);
+
+                    seen[index] = DemandCreate(ptr, mutex, [&](TestObject** result)
+                        {
+                            ++calls;
+                            *result = new TestObject(uint32_t(round));
+                            return S_OK;
+                        });
+                });
+
+            TEST_VERIFY(calls == 1);
+            for (const auto it : seen)
+            {
+                TEST_VERIFY(it == ptr.Get());
+                TEST_VERIFY(it->GetValue() == round);
+            }
+        }
+
+        TEST_VERIFY(g_liveObjects == 0);
+
+        return true;
+    }
+
+    // The unlocked variant may create more than once, but publishes one object and releases the rest.
+    bool TestDemandCreateUnlocked()
+    {
+        {
+            AtomicComPtr<TestObject> ptr;
+            std::mutex mutex;
+
+            TEST_VERIFY(DemandCreateUnlocked(ptr, mutex, [](TestObject**) noexcept { return E_FAIL; }) == E_FAIL);
+            TEST_VERIFY(ptr.Get() == nullptr);
+
+            auto create = [](TestObject** result)
+            {
+                *result = new TestObject(7);
+                return S_OK;
+            };
+
+            TEST_VERIFY(DemandCreateUnlocked(ptr, mutex, create) == S_OK);
+            TEST_VERIFY(DemandCreateUnlocked(ptr, mutex, create) == S_FALSE);
+            TEST_VERIFY(ptr.Get()->GetValue() == 7);
+            TEST_VERIFY(g_liveObjects == 1);
+        }
+
+        TEST_VERIFY(g_liveObjects == 0);
+
+        for (size_t round = 0; round < 200; ++round)
+        {
+            AtomicComPtr<TestObject> ptr;
+            std::mutex mutex;
+            std::atomic<size_t> ready(0);
+            std::atomic<int> published(0);
+            std::atomic<int> existed(0);
+
+            RunThreads(c_ThreadCount, [&](size_t index)
+                {
+                    Rendezvous(ready);
+
+                    const HRESULT hr = DemandCreateUnlocked(ptr, mutex, [&](TestObject** result)
+                        {
+                            *result = new TestObject(uint32_t(index));
+                            return S_OK;
+                        });
+
+                    if (hr == S_OK)
+                        ++published;
+                    else if (hr == S_FALSE)
+                        ++existed;
+                });
+
+            TEST_VERIFY(published == 1);
+            TEST_VERIFY(existed == int(c_ThreadCount) - 1);
+            TEST_VERIFY(ptr.Get() != nullptr);
+            TEST_VERIFY(g_liveObjects == 1);
+        }
+
+        TEST_VERIFY(g_liveObjects == 0);
+
+        return true;
+    }
+
+    bool TestPool()
+    {
+        int devices[3] = {};
+
+        {
+            Pool pool;
+
+            auto a = pool.DemandCreate(&devices[0], 1);
+            auto b = pool.DemandCreate(&devices[0], 2);
+            auto c = pool.DemandCreate(&devices[1], 3);
+
+            // One instance per key; later constructor arguments are ignored
+            TEST_VERIFY(a == b);
+            TEST_VERIFY(a != c);
+            TEST_VERIFY(a->mDevice == &devices[0]);
+            TEST_VERIFY(a->mTag == 1);
+            TEST_VERIFY(c->mDevice == &devices[1]);
+            TEST_VERIFY(g_liveObjects == 2);
+
+            // Once every reference is gone the next lookup creates a new instance
+            a.reset();
+            b.reset();
+            TEST_VERIFY(g_liveObjects == 1);
+
+            auto d = pool.DemandCreate(&devices[0], 4);
+            TEST_VERIFY(d->mTag == 4);
+            TEST_VERIFY(pool.DemandCreate(&devices[0], 5) == d);
+            TEST_VERIFY(pool.DemandCreate(&devices[1], 6) == c);
+        }
+
+        // Instances can outlive the pool that made them
+        std::shared_ptr<PoolData> survivor;
+        {
+            Pool pool;
+            survivor = pool.DemandCreate(&devices[2], 9);
+        }
+        TEST_VERIFY(survivor->mTag == 9);
+        survivor.reset();
+
+        TEST_VERIFY(g_liveObjects == 0);
+
+        return true;
+    }
+
+    // More keys than the lock-free table holds still resolve through the map.
+    bool TestPoolManyKeys()
+    {
+        int devices[100] = {};
+
+        {
+            Pool pool;
+            std::vector<std::shared_ptr<PoolData>> held;
+
+            for (uint32_t j = 0; j < 100; ++j)
+            {
+                held.emplace_back(pool.DemandCreate(&devices[j], j));
+            }
+
+            for (uint32_t pass = 0; pass < 3; ++pass)
+            {
+                for (uint32_t j = 0; j < 100; ++j)
+                {
+                    auto it = pool.DemandCreate(&devices[j], 1000 + j);
+                    TEST_VERIFY(it == held[j]);
+                    TEST_VERIFY(it->mTag == j);
+                }
+            }
+
+            TEST_VERIFY(g_liveObjects == 100);
+
+            // Recreate every other key
+            for (uint32_t j = 0; j < 100; j += 2)
+            {
+                held[j].reset();
+            }
+            for (uint32_t j = 0; j < 100; ++j)
+            {
+                auto it = pool.DemandCreate(&devices[j], 1000 + j);
+                TEST_VERIFY(it->mTag == ((j & 1) ? j : 1000 + j));
+                held[j] = it;
+            }
+
+            TEST_VERIFY(g_liveObjects == 100);
+        }
+
+        TEST_VERIFY(g_liveObjects == 0);
+
+        return true;
+    }
+
+    // Threads look up, drop, and recreate instances for a few devices at once. Every lookup must
+    // get an instance for its own key, and while one is held every lookup must return that one.
+    bool TestPoolThreads()
+    {
+        constexpr size_t deviceCount = 24;
+        int devices[deviceCount] = {};
+
+        std::atomic<bool> failed(false);
+        std::atomic<size_t> ready(0);
+
+        {
+            Pool pool;
+
+            RunThreads(c_ThreadCount, [&](size_t index)
+                {
+                    Random rng(uint32_t(39 + index));
+                    std::shared_ptr<PoolData> held[4];
+
+                    Rendezvous(ready);
+
+                    for (size_t j = 0; j < 20000; ++j)
+                    {
+                        const size_t device = rng.Next(uint32_t(deviceCount));
+
+                        auto it = pool.DemandCreate(&devices[device], uint32_t(index));
+                        if (!it || it->mDevice != &devices[device])
+                            failed = true;
+
+                        if (pool.DemandCreate(&devices[device], uint32_t(index)) != it)
+                            failed = true;
+
+                        // Hold a few at random so instances keep dying and coming back
+                        held[rng.Next(4)] = std::move(it);
+                    }
+                });
+        }
+
+        TEST_VERIFY(!failed);
+        TEST_VERIFY(g_liveObjects == 0);
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "DemandCreate", TestDemandCreate },
+        { "DemandCreateThreads", TestDemandCreateThreads },
+        { "DemandCreateUnlocked", TestDemandCreateUnlocked },
+        { "Pool", TestPool },
+        { "PoolManyKeys", TestPoolManyKeys },
+        { "PoolThreads", TestPoolThreads },
+    };
+}
+
+int __cdecl main()
+{
+    return RunTests(g_Tests);
+}
@@ -0,0 +1,189 @@
+//--------------------------------------------------------------------------------------
+// File: poolbench.cpp
+//
+// Measures the cost of looking up existing shared resources as threads are added, for
+// SharedResourcePool and DemandCreate against the always-locked lookups they replaced
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "DemandCreate.h"
+#include "SharedResourcePool.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    class TestObject
+    {
+    public:
+        ULONG Release() noexcept
+        {
+            delete this;
+            return 0;
+        }
+    };
+
+    class PoolData
+    {
+    public:
+        explicit PoolData(int* device) noexcept : mDevice(device) {}
+
+        int* mDevice;
+    };
+
+    // The lookup every SharedResourcePool::DemandCreate call used to make.
+    class LockedPool
+    {
+    public:
+        std::shared_ptr<PoolData> DemandCreate(int* key)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            auto pos = mMap.find(key);
+            if (pos != mMap.end())
+            {
+                auto existing = pos->second.lock();
+                if (existing)
+                    return existing;
+            }
+
+            auto value = std::make_shared<PoolData>(key);
+            mMap[key] = value;
+            return value;
+        }
+
+    private:
+        std::mutex mMutex;
+        std::map<int*, std::weak_ptr<PoolData>> mMap;
+    };
+
+    constexpr size_t c_Iterations = 1000000;
+
+    // Nanoseconds per call, with every thread making c_Iterations calls at once.
+    template<typename Fn>
+    double Contend(size_t threadCount, Fn&& fn)
+    {
+        std::atomic<size_t> ready(0);
+        std::atomic<bool> go(false);
+        std::vector<std::thread> threads;
+
+        for (size_t t = 0; t < threadCount; ++t)
+        {
+            threads.emplace_back([&, t]()
+                {
+                    ++ready;
+                    while (!go.load())
+                    {
+                        std::this_thread::yield();
+                    }
+
+                    for (size_t j = 0; j < c_Iterations; ++j)
+                    {
+                        fn(t, j);
+                    }
+                });
+        }
+
+        while (ready.load() < threadCount)
+        {
+            std::this_thread::yield();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        go = true;
+
+        for (auto& it : threads)
+        {
+            it.join();
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return seconds * 1e9 / double(c_Iterations);
+    }
+}
+
+int __cdecl main()
+{
+    int devices[4] = {};
+
+    SharedResourcePool<int*, PoolData> pool;
+    LockedPool lockedPool;
+
+    // Keep one live instance per device, as a running game would
+    std::shared_ptr<PoolData> held[4];
+    std::shared_ptr<PoolData> lockedHeld[4];
+    for (size_t j = 0; j < 4; ++j)
+    {
+        held[j] = pool.DemandCreate(&devices[j]);
+        lockedHeld[j] = lockedPool.DemandCreate(&devices[j]);
+    }
+
+    AtomicComPtr<TestObject> resource;
+    std::mutex resourceMutex;
+    DemandCreate(resource, resourceMutex, [](TestObject** result) { *result = new TestObject; return S_OK; });
+
+    TestObject* lockedResource = resource.Get();
+
+    const size_t maxThreads = std::max<size_t>(4, std::thread::hardware_concurrency());
+
+    printf("threads   pool ns/call   locked pool ns/call   DemandCreate ns/call   locked ns/call\n");
+
+    for (size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+        std::atomic<size_t> sink(0);
+
+        const double poolTime = Contend(threadCount, [&](size_t t, size_t j)
+            {
+                auto it = pool.DemandCreate(&devices[(t + j) & 3]);
+                sink.fetch_add(size_t(it->mDevice != nullptr), std::memory_order_relaxed);
+            });
+
+        const double lockedPoolTime = Contend(threadCount, [&](size_t t, size_t j)
+            {
+                auto it = lockedPool.DemandCreate(&devices[(t + j) & 3]);
+                sink.fetch_add(size_t(it->mDevice != nullptr), std::memory_order_relaxed);
+            });
+
+        const double createTime = Contend(threadCount, [&](size_t, size_t)
+            {
+                auto it = DemandCreate(resource, resourceMutex, [](TestObject** result) { *result = new TestObject; return S_OK; });
+                sink.fetch_add(size_t(it != nullptr), std::memory_order_relaxed);
+            });
+
+        const double lockedTime = Contend(threadCount, [&](size_t, size_t)
+            {
+                std::lock_guard<std::mutex> lock(resourceMutex);
+                sink.fetch_add(size_t(lockedResource != nullptr), std::memory_order_relaxed);
+            });
+
+        printf("%7zu   %12.1f   %19.1f   %20.1f   %14.1f\n", threadCount, poolTime, lockedPoolTime, createTime, lockedTime);
+
+        if (sink.load() != 4 * threadCount * c_Iterations)
+        {
+            printf("Lookup failed\n");
+            return 1;
+        }
+    }
+
+    return 0;
+}
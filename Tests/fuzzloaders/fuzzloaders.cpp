@@ -0,0 +1,99 @@
+//--------------------------------------------------------------------------------------
+// File: fuzzloaders.cpp
+//
+// libFuzzer harness for the device-independent DDS parsing and DDSZ decompression.
+// Without FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION it runs each file named on the
+// command line through the same code, so crashes found by the fuzzer can be replayed.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "DDSParser.h"
+#include "DDSCompression.h"
+
+using namespace DirectX;
+
+namespace
+{
+    void ParseSubresources(const uint8_t* data, size_t size)
+    {
+        DDSTextureDesc desc;
+        if (FAILED(ParseDDS(data, size, &desc)))
+            return;
+
+        std::vector<DDSSubresource> subresources(desc.subresourceCount);
+        if (FAILED(ParseDDS(data, size, &desc, subresources.data(), subresources.size())))
+            return;
+
+        // Touch the first and last byte of every subresource so ASan sees any overrun.
+        volatile uint8_t sink = 0;
+        for (const auto& it : subresources)
+        {
+            if (it.size)
+            {
+                sink ^= data[it.offset];
+                sink ^= data[it.offset + it.size - 1];
+            }
+        }
+    }
+}
+
+extern "C" int __cdecl LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    ParseSubresources(data, size);
+
+    if (IsCompressedDDS(data, size))
+    {
+        std::unique_ptr<uint8_t[]> dds;
+        size_t ddsSize = 0;
+        if (SUCCEEDED(DecompressDDS(data, size, dds, ddsSize)))
+        {
+            ParseSubresources(dds.get(), ddsSize);
+        }
+    }
+
+    return 0;
+}
+
+#ifndef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
+int __cdecl main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: fuzzloaders <file> [<file>...]\n");
+        return 0;
+    }
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file)
+        {
+            printf("ERROR: can't open %s\n", argv[i]);
+            return 1;
+        }
+
+        const std::vector<uint8_t> data{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+        printf("%s\n", argv[i]);
+        LLVMFuzzerTestOneInput(data.empty() ? nullptr : data.data(), data.size());
+    }
+
+    return 0;
+}
+#endif
@@ -0,0 +1,248 @@
+//--------------------------------------------------------------------------------------
+// File: geometryarena.cpp
+//
+// Tests for GeometryArena, which packs model vertex and index streams into shared buffers
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include <sal.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include "GeometryArena.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    std::vector<uint8_t> MakeStream(size_t bytes, uint8_t seed)
+    {
+        std::vector<uint8_t> data(bytes);
+        for (size_t j = 0; j < bytes; ++j)
+        {
+            data[j] = static_cast<uint8_t>(seed + j * 7);
+        }
+        return data;
+    }
+
+    bool Contains(const GeometryArena& arena, const GeometryArena::Allocation& alloc, const std::vector<uint8_t>& data)
+    {
+        return alloc.buffer < arena.GetBufferCount()
+            && alloc.offset + data.size() <= arena.GetBufferSize(alloc.buffer)
+            && memcmp(arena.GetBufferData(alloc.buffer) + alloc.offset, data.data(), data.size()) == 0;
+    }
+
+    // Streams sharing a key are placed back to back, each at a multiple of its stride.
+    bool TestPacking()
+    {
+        GeometryArena arena(1024 * 1024);
+
+        const auto a = MakeStream(36 * 5, 1);
+        const auto b = MakeStream(36 * 3, 2);
+        const auto c = MakeStream(36 * 7, 3);
+
+        const auto allocA = arena.Append(36, 36, a.data(), a.size());
+        const auto allocB = arena.Append(36, 36, b.data(), b.size());
+        const auto allocC = arena.Append(36, 36, c.data(), c.size());
+
+        TEST_VERIFY(arena.GetBufferCount() == 1);
+        TEST_VERIFY(arena.GetBufferKey(0) == 36);
+        TEST_VERIFY(allocA.offset == 0);
+        TEST_VERIFY(allocB.offset == a.size());
+        TEST_VERIFY(allocC.offset == a.size() + b.size());
+        TEST_VERIFY(arena.GetBufferSize(0) == a.size() + b.size() + c.size());
+
+        TEST_VERIFY(Contains(arena, allocA, a));
+        TEST_VERIFY(Contains(arena, allocB, b));
+        TEST_VERIFY(Contains(arena, allocC, c));
+
+        return true;
+    }
+
+    // A stream whose size isn't a multiple of the alignment pushes the next one up.
+    bool TestAlignment()
+    {
+        GeometryArena arena(1024);
+
+        const auto a = MakeStream(6, 1);        // Three 16-bit indices
+        const auto b = MakeStream(10, 2);
+
+        arena.Append(0, 4, a.data(), a.size());
+        const auto allocB = arena.Append(0, 4, b.data(), b.size());
+
+        TEST_VERIFY(allocB.buffer == 0);
+        TEST_VERIFY(allocB.offset == 8);
+        TEST_VERIFY(Contains(arena, allocB, b));
+
+        // Same key but a different stride can't share a buffer, since base vertices are in strides.
+        const auto c = MakeStream(24, 3);
+        const auto allocC = arena.Append(0, 12, c.data(), c.size());
+        TEST_VERIFY(allocC.buffer == 1);
+        TEST_VERIFY(allocC.offset == 0);
+
+        return true;
+    }
+
+    bool TestKeys()
+    {
+        GeometryArena arena(1024 * 1024);
+
+        const auto a = MakeStream(32 * 4, 1);
+        const auto b = MakeStream(24 * 4, 2);
+
+        const auto allocA = arena.Append(32, 32, a.data(), a.size());
+        const auto allocB = arena.Append(24, 24, b.data(), b.size());
+        const auto allocA2 = arena.Append(32, 32, a.data(), a.size());
+
+        TEST_VERIFY(arena.GetBufferCount() == 2);
+        TEST_VERIFY(allocA.buffer == allocA2.buffer);
+        TEST_VERIFY(allocA.buffer != allocB.buffer);
+        TEST_VERIFY(arena.GetBufferKey(allocA.buffer) == 32);
+        TEST_VERIFY(arena.GetBufferKey(allocB.buffer) == 24);
+        TEST_VERIFY(allocA2.offset == a.size());
+
+        return true;
+    }
+
+    // A full buffer starts another, and a stream over the cap gets a buffer of its own.
+    bool TestMaxBufferSize()
+    {
+        GeometryArena arena(100);
+
+        const auto a = MakeStream(60, 1);
+        const auto b = MakeStream(60, 2);
+        const auto c = MakeStream(40, 3);
+        const auto big = MakeStream(250, 4);
+
+        const auto allocA = arena.Append(1, 4, a.data(), a.size());
+        const auto allocB = arena.Append(1, 4, b.data(), b.size());
+        const auto allocC = arena.Append(1, 4, c.data(), c.size());
+        const auto allocBig = arena.Append(1, 4, big.data(), big.size());
+
+        TEST_VERIFY(allocA.buffer == 0);
+        TEST_VERIFY(allocB.buffer == 1);
+
+        // The first buffer still has room for c
+        TEST_VERIFY(allocC.buffer == 0);
+        TEST_VERIFY(allocC.offset == 60);
+
+        TEST_VERIFY(allocBig.offset == 0);
+        TEST_VERIFY(arena.GetBufferSize(allocBig.buffer) == big.size());
+        TEST_VERIFY(arena.GetBufferCount() == 3);
+
+        TEST_VERIFY(Contains(arena, allocA, a));
+        TEST_VERIFY(Contains(arena, allocB, b));
+        TEST_VERIFY(Contains(arena, allocC, c));
+        TEST_VERIFY(Contains(arena, allocBig, big));
+
+        return true;
+    }
+
+    bool TestInvalid()
+    {
+        GeometryArena arena(1024);
+
+        const uint8_t data[16] = {};
+
+        bool threw = false;
+        try { arena.Append(0, 0, data, sizeof(data)); } catch (const std::invalid_argument&) { threw = true; }
+        TEST_VERIFY(threw);
+
+        threw = false;
+        try { arena.Append(0, 4, data, 0); } catch (const std::invalid_argument&) { threw = true; }
+        TEST_VERIFY(threw);
+
+        threw = false;
+        try { arena.Append(0, 4, nullptr, 16); } catch (const std::invalid_argument&) { threw = true; }
+        TEST_VERIFY(threw);
+
+        TEST_VERIFY(arena.GetBufferCount() == 0);
+
+        threw = false;
+        try { (void)arena.GetBufferSize(0); } catch (const std::out_of_range&) { threw = true; }
+        TEST_VERIFY(threw);
+
+        return true;
+    }
+
+    // Many streams of mixed keys: every one must read back intact, aligned, and without overlap.
+    bool TestRandom()
+    {
+        static const size_t strides[] = { 2, 4, 12, 24, 32, 36, 52 };
+
+        constexpr size_t maxBufferSize = 64 * 1024;
+
+        GeometryArena arena(maxBufferSize);
+        Random rng(29);
+
+        struct Stream
+        {
+            size_t                      stride;
+            std::vector<uint8_t>        data;
+            GeometryArena::Allocation   alloc;
+        };
+
+        std::vector<Stream> streams;
+        for (size_t j = 0; j < 2000; ++j)
+        {
+            Stream s;
+            s.stride = strides[rng.Next(uint32_t(std::size(strides)))];
+            s.data = MakeStream(s.stride * (1 + rng.Next(j % 100 ? 200u : 4000u)), static_cast<uint8_t>(j));
+            s.alloc = arena.Append(static_cast<uint32_t>(s.stride), s.stride, s.data.data(), s.data.size());
+            streams.emplace_back(std::move(s));
+        }
+
+        std::vector<std::vector<std::pair<size_t, size_t>>> ranges(arena.GetBufferCount());
+
+        for (const auto& s : streams)
+        {
+            TEST_VERIFY(Contains(arena, s.alloc, s.data));
+            TEST_VERIFY((s.alloc.offset % s.stride) == 0);
+            TEST_VERIFY(arena.GetBufferKey(s.alloc.buffer) == s.stride);
+
+            const size_t size = arena.GetBufferSize(s.alloc.buffer);
+            TEST_VERIFY(size <= maxBufferSize || s.alloc.offset == 0);
+
+            ranges[s.alloc.buffer].emplace_back(s.alloc.offset, s.alloc.offset + s.data.size());
+        }
+
+        for (auto& it : ranges)
+        {
+            std::sort(it.begin(), it.end());
+            for (size_t j = 1; j < it.size(); ++j)
+            {
+                TEST_VERIFY(it[j - 1].second <= it[j].first);
+            }
+        }
+
+        arena.Clear();
+        TEST_VERIFY(arena.GetBufferCount() == 0);
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "Packing", TestPacking },
+        { "Alignment", TestAlignment },
+        { "Keys", TestKeys },
+        { "MaxBufferSize", TestMaxBufferSize },
+        { "Invalid", TestInvalid },
+        { "Random", TestRandom },
+    };
+}
+
+int __cdecl main()
+{
+    return RunTests(g_Tests);
+}
@@ -0,0 +1,147 @@
+//--------------------------------------------------------------------------------------
+// File: memorymappedfile.cpp
+//
+// Tests for MemoryMappedFile, the read-only file view used by the DDS, VBO and baked
+// model loaders
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "MemoryMappedFile.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    // A file in the temporary directory, deleted when this goes out of scope.
+    class ScratchFile
+    {
+    public:
+        ScratchFile(const char* name, const std::vector<uint8_t>& contents)
+        {
+            mPath = std::filesystem::temp_directory_path() / (std::string("DirectXTKTest_mmf_") + name);
+
+            std::ofstream file(mPath, std::ios::out | std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+            if (!file)
+                throw std::runtime_error("Can't write temporary file");
+        }
+
+        ScratchFile(ScratchFile const&) = delete;
+        ScratchFile& operator= (ScratchFile const&) = delete;
+
+        ~ScratchFile()
+        {
+            std::error_code ec;
+            std::filesystem::remove(mPath, ec);
+        }
+
+        std::wstring GetPath() const { return mPath.wstring(); }
+
+    private:
+        std::filesystem::path mPath;
+    };
+
+    std::vector<uint8_t> CreatePattern(size_t size)
+    {
+        std::vector<uint8_t> data(size);
+        for (size_t j = 0; j < size; ++j)
+        {
+            data[j] = static_cast<uint8_t>((j * 31) ^ (j >> 8));
+        }
+        return data;
+    }
+
+    bool TestMap()
+    {
+        // Sizes around the page size, plus one spanning many pages
+        for (const size_t size : { size_t(1), size_t(4095), size_t(4096), size_t(4097), size_t(1u << 20) })
+        {
+            const auto contents = CreatePattern(size);
+            ScratchFile scratch("map.bin", contents);
+
+            MemoryMappedFile file;
+            TEST_VERIFY(file.Open(scratch.GetPath().c_str()) == S_OK);
+            TEST_VERIFY(file.GetSize() == size);
+            TEST_VERIFY(file.GetData() != nullptr);
+            TEST_VERIFY(memcmp(file.GetData(), contents.data(), size) == 0);
+
+            file.Close();
+            TEST_VERIFY(file.GetData() == nullptr);
+            TEST_VERIFY(file.GetSize() == 0);
+        }
+
+        return true;
+    }
+
+    bool TestReopen()
+    {
+        const auto first = CreatePattern(100);
+        const auto second = CreatePattern(5000);
+        ScratchFile a("a.bin", first);
+        ScratchFile b("b.bin", second);
+
+        // Opening again replaces the previous view
+        MemoryMappedFile file;
+        TEST_VERIFY(file.Open(a.GetPath().c_str()) == S_OK);
+        TEST_VERIFY(file.Open(b.GetPath().c_str()) == S_OK);
+        TEST_VERIFY(file.GetSize() == second.size());
+        TEST_VERIFY(memcmp(file.GetData(), second.data(), second.size()) == 0);
+
+        // The view moves with the object
+        MemoryMappedFile moved(std::move(file));
+        TEST_VERIFY(moved.GetSize() == second.size());
+        TEST_VERIFY(memcmp(moved.GetData(), second.data(), second.size()) == 0);
+
+        return true;
+    }
+
+    bool TestErrors()
+    {
+        MemoryMappedFile file;
+        TEST_VERIFY(file.Open(nullptr) == E_INVALIDARG);
+
+        const std::wstring missing = (std::filesystem::temp_directory_path() / "DirectXTKTest_mmf_missing.bin").wstring();
+        TEST_VERIFY(file.Open(missing.c_str()) == HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND));
+        TEST_VERIFY(file.GetData() == nullptr);
+
+        // Empty files can't be mapped
+        ScratchFile empty("empty.bin", {});
+        TEST_VERIFY(FAILED(file.Open(empty.GetPath().c_str())));
+        TEST_VERIFY(file.GetData() == nullptr);
+        TEST_VERIFY(file.GetSize() == 0);
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "Map", TestMap },
+        { "Reopen", TestReopen },
+        { "Errors", TestErrors },
+    };
+}
+
+int __cdecl main()
+{
+    return RunTests(g_Tests);
+}
@@ -0,0 +1,111 @@
+//--------------------------------------------------------------------------------------
+// File: mipbench.cpp
+//
+// Measures GenerateMipChain for full chains of a 2048x2048 image, per format and filter
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <d3d11_1.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "MipGenerator.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    struct Case
+    {
+        const char*     name;
+        DXGI_FORMAT     format;
+        size_t          bytesPerPixel;
+        bool            straightAlpha;
+    };
+
+    const Case g_Cases[] =
+    {
+        { "R8G8B8A8_UNORM",             DXGI_FORMAT_R8G8B8A8_UNORM,         4,  false },
+        { "R8G8B8A8_UNORM_SRGB",        DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,    4,  true },
+        { "B8G8R8A8_UNORM",             DXGI_FORMAT_B8G8R8A8_UNORM,         4,  true },
+        { "R16G16B16A16_FLOAT",         DXGI_FORMAT_R16G16B16A16_FLOAT,     8,  false },
+        { "R32_FLOAT",                  DXGI_FORMAT_R32_FLOAT,              4,  false },
+    };
+
+    constexpr size_t c_size = 2048;
+    constexpr size_t c_mipLevels = 12;
+}
+
+int __cdecl main()
+{
+    printf("%zux%zu, %zu levels\n", c_size, c_size, c_mipLevels);
+    printf("%-24s %12s %12s %12s %12s\n", "Format", "box (ms)", "MPix/s", "kaiser (ms)", "MPix/s");
+
+    for (const auto& it : g_Cases)
+    {
+        // Noise with the float formats kept in a sane range
+        Random rng(47);
+        std::vector<uint8_t> pixels(c_size * c_size * it.bytesPerPixel);
+        if (it.format == DXGI_FORMAT_R32_FLOAT)
+        {
+            for (size_t j = 0; j < c_size * c_size; ++j)
+            {
+                const float value = rng.NextFloat();
+                memcpy(&pixels[j * 4], &value, sizeof(value));
+            }
+        }
+        else if (it.format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+        {
+            for (size_t j = 0; j < c_size * c_size * 4; ++j)
+            {
+                const uint16_t half = static_cast<uint16_t>(0x3000 + rng.Next(0x0C00));     // [0.125, 1)
+                memcpy(&pixels[j * 2], &half, sizeof(half));
+            }
+        }
+        else
+        {
+            for (auto& p : pixels)
+                p = static_cast<uint8_t>(rng.Next());
+        }
+
+        std::unique_ptr<uint8_t[]> mipData;
+        D3D11_SUBRESOURCE_DATA initData[c_mipLevels] = {};
+
+        double seconds[2] = {};
+        for (const auto filter : { MIP_FILTER_BOX, MIP_FILTER_KAISER })
+        {
+            HRESULT hr = S_OK;
+            seconds[filter] = Measure([&]()
+                {
+                    hr = GenerateMipChain(pixels.data(), c_size * it.bytesPerPixel, c_size, c_size, it.format,
+                        c_mipLevels, filter, it.straightAlpha, mipData, initData);
+                });
+
+            if (FAILED(hr))
+            {
+                printf("ERROR: %s failed (%08X)\n", it.name, static_cast<unsigned int>(hr));
+                return 1;
+            }
+        }
+
+        const double megapixels = double(c_size * c_size) / 1e6;
+        printf("%-24s %12.1f %12.1f %12.1f %12.1f\n", it.name,
+            seconds[0] * 1000.0, megapixels / seconds[0],
+            seconds[1] * 1000.0, megapixels / seconds[1]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,495 @@
+//--------------------------------------------------------------------------------------
+// File: mipgenerator.cpp
+//
+// Tests for GenerateMipChain, the CPU mipmap builder used by the loaders
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <d3d11_1.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "MipGenerator.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    struct Chain
+    {
+        std::unique_ptr<uint8_t[]>          mipData;
+        std::vector<D3D11_SUBRESOURCE_DATA> levels;
+    };
+
+    HRESULT Generate(const void* pixels, size_t rowPitch, size_t width, size_t height, DXGI_FORMAT format,
+        size_t mipLevels, MIP_FILTER filter, bool straightAlpha, Chain& chain)
+    {
+        chain.levels.assign(mipLevels, D3D11_SUBRESOURCE_DATA{});
+        return GenerateMipChain(static_cast<const uint8_t*>(pixels), rowPitch, width, height, format, mipLevels,
+            filter, straightAlpha, chain.mipData, chain.levels.data());
+    }
+
+    const float* GetTexel(const D3D11_SUBRESOURCE_DATA& level, size_t x, size_t y)
+    {
+        return reinterpret_cast<const float*>(static_cast<const uint8_t*>(level.pSysMem) + y * level.SysMemPitch) + x * 4;
+    }
+
+    // Reference box filter with fractional coverage at odd sizes, as a 2D area average.
+    std::vector<float> BoxDownsample(const float* src, size_t width, size_t height, size_t destWidth, size_t destHeight)
+    {
+        std::vector<float> dest(destWidth * destHeight * 4);
+
+        const double sx = double(width) / double(destWidth);
+        const double sy = double(height) / double(destHeight);
+
+        for (size_t y = 0; y < destHeight; ++y)
+        {
+            for (size_t x = 0; x < destWidth; ++x)
+            {
+                double acc[4] = {};
+                for (size_t v = 0; v < height; ++v)
+                {
+                    const double wy = std::min(double(v + 1), (y + 1) * sy) - std::max(double(v), y * sy);
+                    if (wy <= 0)
+                        continue;
+
+                    for (size_t u = 0; u < width; ++u)
+                    {
+                        const double wx = std::min(double(u + 1), (x + 1) * sx) - std::max(double(u), x * sx);
+                        if (wx <= 0)
+                            continue;
+
+                        for (size_t c = 0; c < 4; ++c)
+                            acc[c] += wx * wy * src[(v * width + u) * 4 + c];
+                    }
+                }
+
+                for (size_t c = 0; c < 4; ++c)
+                    dest[(y * destWidth + x) * 4 + c] = float(acc[c] / (sx * sy));
+            }
+        }
+
+        return dest;
+    }
+
+    std::vector<float> MakeNoise(size_t width, size_t height, uint32_t seed)
+    {
+        Random rng(seed);
+        std::vector<float> pixels(width * height * 4);
+        for (auto& it : pixels)
+            it = rng.NextFloat();
+        return pixels;
+    }
+
+    // Level sizes halve and round down, the top level is the source, and the rest are packed.
+    bool TestLayout()
+    {
+        const size_t width = 200;
+        const size_t height = 48;
+        const auto pixels = MakeNoise(width, height, 47);
+
+        Chain chain;
+        TEST_VERIFY(SUCCEEDED(Generate(pixels.data(), width * 16, width, height, DXGI_FORMAT_R32G32B32A32_FLOAT, 8, MIP_FILTER_BOX, false, chain)));
+
+        TEST_VERIFY(chain.levels[0].pSysMem == pixels.data());
+        TEST_VERIFY(chain.levels[0].SysMemPitch == width * 16);
+        TEST_VERIFY(chain.levels[0].SysMemSlicePitch == width * height * 16);
+
+        const uint8_t* next = chain.mipData.get();
+        size_t w = width;
+        size_t h = height;
+        for (size_t level = 1; level < chain.levels.size(); ++level)
+        {
+            w = std::max<size_t>(1, w / 2);
+            h = std::max<size_t>(1, h / 2);
+
+            TEST_VERIFY(chain.levels[level].pSysMem == next);
+            TEST_VERIFY(chain.levels[level].SysMemPitch == w * 16);
+            TEST_VERIFY(chain.levels[level].SysMemSlicePitch == w * h * 16);
+            next += w * h * 16;
+        }
+
+        // A single level needs no storage
+        TEST_VERIFY(SUCCEEDED(Generate(pixels.data(), width * 16, width, height, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, MIP_FILTER_BOX, false, chain)));
+        TEST_VERIFY(!chain.mipData);
+        TEST_VERIFY(chain.levels[0].pSysMem == pixels.data());
+
+        return true;
+    }
+
+    // Each box level is the area average of the one above it, including odd sizes where a
+    // destination texel covers part of a source row or column.
+    bool TestBox()
+    {
+        const struct { size_t w; size_t h; } sizes[] = { { 64, 64 }, { 37, 21 }, { 5, 3 }, { 1, 33 }, { 128, 1 } };
+
+        for (const auto& size : sizes)
+        {
+            const auto pixels = MakeNoise(size.w, size.h, uint32_t(size.w * 100 + size.h));
+
+            uint32_t mips = 1;
+            for (size_t m = std::max(size.w, size.h); m > 1; m >>= 1)
+                ++mips;
+
+            Chain chain;
+            TEST_VERIFY(SUCCEEDED(Generate(pixels.data(), size.w * 16, size.w, size.h, DXGI_FORMAT_R32G32B32A32_FLOAT, mips, MIP_FILTER_BOX, false, chain)));
+
+            std::vector<float> above = pixels;
+            size_t w = size.w;
+            size_t h = size.h;
+            for (size_t level = 1; level < mips; ++level)
+            {
+                const size_t dw = std::max<size_t>(1, w / 2);
+                const size_t dh = std::max<size_t>(1, h / 2);
+                const auto expected = BoxDownsample(above.data(), w, h, dw, dh);
+
+                for (size_t y = 0; y < dh; ++y)
+                {
+                    for (size_t x = 0; x < dw; ++x)
+                    {
+                        const float* texel = GetTexel(chain.levels[level], x, y);
+                        for (size_t c = 0; c < 4; ++c)
+                        {
+                            if (std::fabs(texel[c] - expected[(y * dw + x) * 4 + c]) > 1e-5f)
+                            {
+                                printf("\n    %zux%zu level %zu (%zu, %zu): %f, expected %f", size.w, size.h, level, x, y,
+                                    double(texel[c]), double(expected[(y * dw + x) * 4 + c]));
+                                return false;
+                            }
+                        }
+                    }
+                }
+
+                above.assign(GetTexel(chain.levels[level], 0, 0), GetTexel(chain.levels[level], 0, 0) + dw * dh * 4);
+                w = dw;
+                h = dh;
+            }
+        }
+
+        return true;
+    }
+
+    // Every texel of a level equals the given one: 8-bit channels may round by one through
+    // sRGB and back, and float channels by the rounding of the filter weights.
+    bool MatchesTexel(const D3D11_SUBRESOURCE_DATA& level, DXGI_FORMAT format, const uint8_t* texel, size_t bpp)
+    {
+        const auto data = static_cast<const uint8_t*>(level.pSysMem);
+
+        for (size_t j = 0; j < level.SysMemSlicePitch; j += bpp)
+        {
+            switch (format)
+            {
+            case DXGI_FORMAT_R16G16B16A16_FLOAT:
+                for (size_t c = 0; c < 4; ++c)
+                {
+                    uint16_t a, b;
+                    memcpy(&a, data + j + c * 2, sizeof(a));
+                    memcpy(&b, texel + c * 2, sizeof(b));
+                    if (std::abs(int(a) - int(b)) > 1)
+                        return false;
+                }
+                break;
+
+            case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            case DXGI_FORMAT_R32_FLOAT:
+                for (size_t c = 0; c < bpp / 4; ++c)
+                {
+                    float a, b;
+                    memcpy(&a, data + j + c * 4, sizeof(a));
+                    memcpy(&b, texel + c * 4, sizeof(b));
+                    if (std::fabs(a - b) > 1e-6f * std::fabs(b))
+                        return false;
+                }
+                break;
+
+            default:
+                for (size_t c = 0; c < 4; ++c)
+                {
+                    if (std::abs(int(data[j + c]) - int(texel[c])) > 1)
+                        return false;
+                }
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    // A flat image stays flat at every level and with both filters, in every format.
+    bool TestConstant()
+    {
+        const DXGI_FORMAT formats[] =
+        {
+            DXGI_FORMAT_R8G8B8A8_UNORM,
+            DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+            DXGI_FORMAT_B8G8R8A8_UNORM,
+            DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,
+            DXGI_FORMAT_B8G8R8X8_UNORM,
+            DXGI_FORMAT_R16G16B16A16_FLOAT,
+            DXGI_FORMAT_R32G32B32A32_FLOAT,
+            DXGI_FORMAT_R32_FLOAT,
+        };
+
+        for (const auto format : formats)
+        {
+            TEST_VERIFY(IsCPUMipFormatSupported(format));
+
+            size_t bpp = 4;
+            uint8_t texel[16] = { 0x40, 0x90, 0xC8, 0xFF };
+            if (format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+            {
+                const uint16_t half[4] = { 0x3800, 0x3400, 0x3C00, 0x3A00 };    // 0.5, 0.25, 1, 0.75
+                memcpy(texel, half, sizeof(half));
+                bpp = 8;
+            }
+            else if (format == DXGI_FORMAT_R32G32B32A32_FLOAT)
+            {
+                const float value[4] = { 0.125f, 0.5f, 2.f, 0.75f };
+                memcpy(texel, value, sizeof(value));
+                bpp = 16;
+            }
+            else if (format == DXGI_FORMAT_R32_FLOAT)
+            {
+                const float value = 0.3f;
+                memcpy(texel, &value, sizeof(value));
+            }
+
+            const size_t width = 50;
+            const size_t height = 30;
+            std::vector<uint8_t> pixels(width * height * bpp);
+            for (size_t j = 0; j < width * height; ++j)
+                memcpy(&pixels[j * bpp], texel, bpp);
+
+            for (const auto filter : { MIP_FILTER_BOX, MIP_FILTER_KAISER })
+            {
+                Chain chain;
+                TEST_VERIFY(SUCCEEDED(Generate(pixels.data(), width * bpp, width, height, format, 6, filter, true, chain)));
+
+                for (size_t level = 1; level < chain.levels.size(); ++level)
+                {
+                    if (!MatchesTexel(chain.levels[level], format, texel, bpp))
+                    {
+                        printf("\n    format %u filter %u level %zu", unsigned(format), unsigned(filter), level);
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // sRGB levels average light, not encoded values: black and white make a 50% grey in linear.
+    bool TestSRGB()
+    {
+        const uint8_t pixels[2 * 2 * 4] =
+        {
+            0, 0, 0, 255,           255, 255, 255, 255,
+            255, 255, 255, 255,     0, 0, 0, 255,
+        };
+
+        Chain chain;
+        TEST_VERIFY(SUCCEEDED(Generate(pixels, 8, 2, 2, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 2, MIP_FILTER_BOX, false, chain)));
+        auto texel = static_cast<const uint8_t*>(chain.levels[1].pSysMem);
+        TEST_VERIFY(texel[0] == 188 && texel[1] == 188 && texel[2] == 188 && texel[3] == 255);
+
+        TEST_VERIFY(SUCCEEDED(Generate(pixels, 8, 2, 2, DXGI_FORMAT_R8G8B8A8_UNORM, 2, MIP_FILTER_BOX, false, chain)));
+        texel = static_cast<const uint8_t*>(chain.levels[1].pSysMem);
+        TEST_VERIFY(texel[0] == 128 && texel[3] == 255);
+
+        return true;
+    }
+
+    // With straight alpha, transparent texels don't tint their neighbours.
+    bool TestStraightAlpha()
+    {
+        const uint8_t pixels[2 * 2 * 4] =
+        {
+            255, 0, 0, 255,         0, 255, 0, 0,
+            0, 255, 0, 0,           0, 255, 0, 0,
+        };
+
+        Chain chain;
+        TEST_VERIFY(SUCCEEDED(Generate(pixels, 8, 2, 2, DXGI_FORMAT_R8G8B8A8_UNORM, 2, MIP_FILTER_BOX, true, chain)));
+        auto texel = static_cast<const uint8_t*>(chain.levels[1].pSysMem);
+        TEST_VERIFY(texel[0] == 255 && texel[1] == 0 && texel[2] == 0 && texel[3] == 64);
+
+        // Otherwise the data is averaged as it is
+        TEST_VERIFY(SUCCEEDED(Generate(pixels, 8, 2, 2, DXGI_FORMAT_R8G8B8A8_UNORM, 2, MIP_FILTER_BOX, false, chain)));
+        texel = static_cast<const uint8_t*>(chain.levels[1].pSysMem);
+        TEST_VERIFY(texel[0] == 64 && texel[1] == 191 && texel[2] == 0 && texel[3] == 64);
+
+        // A fully transparent area stays black rather than producing NaNs
+        const uint8_t clear[2 * 2 * 4] = {};
+        TEST_VERIFY(SUCCEEDED(Generate(clear, 8, 2, 2, DXGI_FORMAT_B8G8R8A8_UNORM, 2, MIP_FILTER_KAISER, true, chain)));
+        texel = static_cast<const uint8_t*>(chain.levels[1].pSysMem);
+        TEST_VERIFY(texel[0] == 0 && texel[1] == 0 && texel[2] == 0 && texel[3] == 0);
+
+        return true;
+    }
+
+    // Power of a horizontal cosine with the given period after one level.
+    float Response(MIP_FILTER filter, float period)
+    {
+        const size_t width = 256;
+        const size_t height = 4;
+
+        std::vector<float> pixels(width * height * 4);
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                const float v = 0.5f + 0.5f * std::cos(2.f * 3.14159265f * (float(x) + 0.5f) / period);
+                float* p = &pixels[(y * width + x) * 4];
+                p[0] = p[1] = p[2] = v;
+                p[3] = 1.f;
+            }
+        }
+
+        Chain chain;
+        if (FAILED(Generate(pixels.data(), width * 16, width, height, DXGI_FORMAT_R32G32B32A32_FLOAT, 2, filter, false, chain)))
+            return -1.f;
+
+        // Away from the clamped edges
+        float lo = 1.f;
+        float hi = 0.f;
+        for (size_t x = 16; x < width / 2 - 16; ++x)
+        {
+            const float v = GetTexel(chain.levels[1], x, 1)[0];
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+
+        return hi - lo;
+    }
+
+    // Kaiser keeps detail the smaller level can hold, and removes what would alias.
+    bool TestKaiser()
+    {
+        const float boxPass = Response(MIP_FILTER_BOX, 16.f);
+        const float kaiserPass = Response(MIP_FILTER_KAISER, 16.f);
+        const float boxStop = Response(MIP_FILTER_BOX, 2.5f);
+        const float kaiserStop = Response(MIP_FILTER_KAISER, 2.5f);
+
+        TEST_VERIFY(kaiserPass > 0.9f && kaiserPass >= boxPass);
+        TEST_VERIFY(boxStop > 0.2f);
+        TEST_VERIFY(kaiserStop < 0.05f);
+
+        // An impulse keeps its energy and stays symmetric
+        const size_t size = 32;
+        std::vector<float> pixels(size * size * 4, 0.f);
+        for (size_t j = 0; j < size * size; ++j)
+            pixels[j * 4 + 3] = 1.f;
+
+        for (const size_t x : { size / 2 - 1, size / 2 })
+            for (const size_t y : { size / 2 - 1, size / 2 })
+                pixels[(y * size + x) * 4] = 1.f;
+
+        Chain chain;
+        TEST_VERIFY(SUCCEEDED(Generate(pixels.data(), size * 16, size, size, DXGI_FORMAT_R32G32B32A32_FLOAT, 2, MIP_FILTER_KAISER, false, chain)));
+
+        const size_t half = size / 2;
+        float sum = 0.f;
+        for (size_t y = 0; y < half; ++y)
+        {
+            for (size_t x = 0; x < half; ++x)
+            {
+                const float v = GetTexel(chain.levels[1], x, y)[0];
+                sum += v;
+                TEST_VERIFY(std::fabs(v - GetTexel(chain.levels[1], half - 1 - x, y)[0]) < 1e-6f);
+                TEST_VERIFY(std::fabs(v - GetTexel(chain.levels[1], x, half - 1 - y)[0]) < 1e-6f);
+            }
+        }
+
+        TEST_VERIFY(std::fabs(sum - 1.f) < 1e-4f);
+        TEST_VERIFY(GetTexel(chain.levels[1], half / 2 - 1, half / 2 - 1)[0] > 0.2f);
+
+        return true;
+    }
+
+    // Padding at the end of source rows is skipped.
+    bool TestRowPitch()
+    {
+        const size_t width = 31;
+        const size_t height = 17;
+        const size_t pitch = width * 4 + 20;
+
+        Random rng(4747);
+        std::vector<uint8_t> packed(width * height * 4);
+        std::vector<uint8_t> padded(pitch * height, 0xCD);
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width * 4; ++x)
+            {
+                packed[y * width * 4 + x] = padded[y * pitch + x] = static_cast<uint8_t>(rng.Next());
+            }
+        }
+
+        Chain a;
+        Chain b;
+        TEST_VERIFY(SUCCEEDED(Generate(packed.data(), width * 4, width, height, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, 5, MIP_FILTER_KAISER, true, a)));
+        TEST_VERIFY(SUCCEEDED(Generate(padded.data(), pitch, width, height, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, 5, MIP_FILTER_KAISER, true, b)));
+
+        for (size_t level = 1; level < 5; ++level)
+        {
+            TEST_VERIFY(a.levels[level].SysMemSlicePitch == b.levels[level].SysMemSlicePitch);
+            TEST_VERIFY(memcmp(a.levels[level].pSysMem, b.levels[level].pSysMem, a.levels[level].SysMemSlicePitch) == 0);
+        }
+
+        return true;
+    }
+
+    bool TestInvalid()
+    {
+        const uint8_t pixels[16 * 16 * 4] = {};
+        Chain chain;
+
+        TEST_VERIFY(Generate(nullptr, 64, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, 5, MIP_FILTER_BOX, false, chain) == E_POINTER);
+        TEST_VERIFY(GenerateMipChain(pixels, 64, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, 5, MIP_FILTER_BOX, false, chain.mipData, nullptr) == E_POINTER);
+        TEST_VERIFY(Generate(pixels, 64, 0, 16, DXGI_FORMAT_R8G8B8A8_UNORM, 1, MIP_FILTER_BOX, false, chain) == E_INVALIDARG);
+        TEST_VERIFY(Generate(pixels, 64, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, 0, MIP_FILTER_BOX, false, chain) == E_INVALIDARG);
+        TEST_VERIFY(Generate(pixels, 64, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, 6, MIP_FILTER_BOX, false, chain) == E_INVALIDARG);
+        TEST_VERIFY(Generate(pixels, 63, 16, 16, DXGI_FORMAT_R8G8B8A8_UNORM, 5, MIP_FILTER_BOX, false, chain) == E_INVALIDARG);
+        TEST_VERIFY(Generate(pixels, 64, 16, 16, DXGI_FORMAT_BC1_UNORM, 5, MIP_FILTER_BOX, false, chain) == HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED));
+        TEST_VERIFY(Generate(pixels, 64, 32, 16, DXGI_FORMAT_R8_UNORM, 5, MIP_FILTER_BOX, false, chain) == HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED));
+        TEST_VERIFY(!chain.mipData);
+
+        TEST_VERIFY(!IsCPUMipFormatSupported(DXGI_FORMAT_R10G10B10A2_UNORM));
+        TEST_VERIFY(!IsCPUMipFormatSupported(DXGI_FORMAT_UNKNOWN));
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "Layout", TestLayout },
+        { "Box", TestBox },
+        { "Constant", TestConstant },
+        { "SRGB", TestSRGB },
+        { "StraightAlpha", TestStraightAlpha },
+        { "Kaiser", TestKaiser },
+        { "RowPitch", TestRowPitch },
+        { "Invalid", TestInvalid },
+    };
+}
+
+int __cdecl main()
+{
+    return RunTests(g_Tests);
+}
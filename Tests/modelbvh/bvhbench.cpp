@@ -0,0 +1,138 @@
+//--------------------------------------------------------------------------------------
+// File: bvhbench.cpp
+//
+// Measures ModelBVH build time and ray throughput on meshes of millions of triangles
+//
+// Usage: bvhbench [millions of triangles]
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include <sal.h>
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "ModelBVH.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    // A displaced grid, so the rays see a surface rather than a uniform soup.
+    void MakeTerrain(size_t triCount, std::vector<XMFLOAT3>& positions, std::vector<uint32_t>& indices)
+    {
+        const auto gridSize = static_cast<uint32_t>(sqrt(double(triCount) / 2.0)) + 1;
+
+        positions.clear();
+        positions.reserve(size_t(gridSize + 1) * (gridSize + 1));
+        for (uint32_t y = 0; y <= gridSize; ++y)
+        {
+            for (uint32_t x = 0; x <= gridSize; ++x)
+            {
+                const float fx = float(x) / float(gridSize);
+                const float fy = float(y) / float(gridSize);
+                positions.emplace_back(
+                    fx * 100.f - 50.f,
+                    sinf(fx * 40.f) * cosf(fy * 30.f) * 2.f + sinf(fx * 7.f + fy * 5.f) * 6.f,
+                    fy * 100.f - 50.f);
+            }
+        }
+
+        indices.clear();
+        indices.reserve(size_t(gridSize) * gridSize * 6);
+        for (uint32_t y = 0; y < gridSize; ++y)
+        {
+            for (uint32_t x = 0; x < gridSize; ++x)
+            {
+                const uint32_t i0 = y * (gridSize + 1) + x;
+                const uint32_t i1 = i0 + 1;
+                const uint32_t i2 = i0 + gridSize + 1;
+                const uint32_t i3 = i2 + 1;
+                indices.insert(indices.end(), { i0, i2, i1, i1, i2, i3 });
+            }
+        }
+    }
+
+    void Run(size_t triCount)
+    {
+        std::vector<XMFLOAT3> positions;
+        std::vector<uint32_t> indices;
+        MakeTerrain(triCount, positions, indices);
+
+        triCount = indices.size() / 3;
+
+        ModelBVH bvh;
+        const double buildTime = Measure([&]()
+            {
+                bvh.Build(positions.data(), sizeof(XMFLOAT3), positions.size(), indices.data(), true, indices.size());
+            }, 3, 0.);
+
+        printf("%zu triangles: build %.1f ms, %zu nodes\n", triCount, buildTime * 1000.0, bvh.GetNodeCount());
+
+        // Picking rays from a camera above the terrain, and grazing rays along it
+        constexpr size_t rayCount = 1000000;
+
+        Random rng(35);
+        std::vector<XMFLOAT3> origins(rayCount);
+        std::vector<XMFLOAT3> directions(rayCount);
+        for (size_t j = 0; j < rayCount; ++j)
+        {
+            const float tx = rng.NextFloat() * 100.f - 50.f;
+            const float tz = rng.NextFloat() * 100.f - 50.f;
+            if (j % 4)
+            {
+                origins[j] = XMFLOAT3(0.f, 80.f, -120.f);
+                directions[j] = XMFLOAT3(tx, -80.f, tz + 120.f);
+            }
+            else
+            {
+                origins[j] = XMFLOAT3(-60.f, 4.f, tz);
+                directions[j] = XMFLOAT3(1.f, (rng.NextFloat() - 0.5f) * 0.1f, tx * 0.01f);
+            }
+        }
+
+        size_t hits = 0;
+        const double rayTime = Measure([&]()
+            {
+                hits = 0;
+                for (size_t j = 0; j < rayCount; ++j)
+                {
+                    float distance;
+                    uint32_t triangle;
+                    float u, v;
+                    if (bvh.Intersects(XMLoadFloat3(&origins[j]), XMLoadFloat3(&directions[j]), FLT_MAX, distance, triangle, u, v))
+                        ++hits;
+                }
+            }, 3, 0.);
+
+        printf("    %zu rays: %.1f ms, %.2f Mrays/s, %zu hits\n",
+            rayCount, rayTime * 1000.0, double(rayCount) / rayTime / 1e6, hits);
+    }
+}
+
+int __cdecl main(int argc, char* argv[])
+{
+    const double millions = (argc > 1) ? atof(argv[1]) : 0.;
+
+    if (millions > 0.)
+    {
+        Run(static_cast<size_t>(millions * 1000000.0));
+    }
+    else
+    {
+        Run(100000);
+        Run(1000000);
+        Run(4000000);
+    }
+
+    return 0;
+}
@@ -0,0 +1,471 @@
+//--------------------------------------------------------------------------------------
+// File: modelbvh.cpp
+//
+// Tests for ModelBVH, the ray picking hierarchy, against a brute force search
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include <sal.h>
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include "ModelBVH.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    struct Hit
+    {
+        bool        hit;
+        float       distance;
+        uint32_t    triangle;
+        float       u;
+        float       v;
+    };
+
+    // Same Moller-Trumbore test as the BVH, applied to every triangle in turn.
+    Hit BruteForce(
+        const std::vector<XMFLOAT3>& positions, const std::vector<uint32_t>& indices, int32_t baseVertex,
+        const XMFLOAT3& origin, const XMFLOAT3& dir, float maxDistance)
+    {
+        Hit result = { false, maxDistance, 0, 0.f, 0.f };
+
+        for (size_t k = 0; k < indices.size() / 3; ++k)
+        {
+            const XMFLOAT3& p0 = positions[size_t(int64_t(indices[k * 3]) + baseVertex)];
+            const XMFLOAT3& p1 = positions[size_t(int64_t(indices[k * 3 + 1]) + baseVertex)];
+            const XMFLOAT3& p2 = positions[size_t(int64_t(indices[k * 3 + 2]) + baseVertex)];
+
+            const float e1[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+            const float e2[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+
+            const float p[3] = { dir.y * e2[2] - dir.z * e2[1], dir.z * e2[0] - dir.x * e2[2], dir.x * e2[1] - dir.y * e2[0] };
+            const float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+            if (fabsf(det) < FLT_MIN)
+                continue;
+
+            const float invDet = 1.f / det;
+
+            const float s[3] = { origin.x - p0.x, origin.y - p0.y, origin.z - p0.z };
+            const float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invDet;
+            if (u < 0.f || u > 1.f)
+                continue;
+
+            const float q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+            const float v = (dir.x * q[0] + dir.y * q[1] + dir.z * q[2]) * invDet;
+            if (v < 0.f || (u + v) > 1.f)
+                continue;
+
+            const float t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * invDet;
+            if (t < 0.f || t > result.distance)
+                continue;
+
+            result = { true, t, uint32_t(k), u, v };
+        }
+
+        if (!result.hit)
+            result.distance = 0.f;
+
+        return result;
+    }
+
+    Hit Pick(const ModelBVH& bvh, const XMFLOAT3& origin, const XMFLOAT3& dir, float maxDistance)
+    {
+        Hit result;
+        result.hit = bvh.Intersects(XMLoadFloat3(&origin), XMLoadFloat3(&dir), maxDistance,
+            result.distance, result.triangle, result.u, result.v);
+        return result;
+    }
+
+    // Ties between triangles at the same distance may resolve either way.
+    bool Matches(const Hit& a, const Hit& b)
+    {
+        if (a.hit != b.hit)
+            return false;
+
+        if (!a.hit)
+            return true;
+
+        if (fabsf(a.distance - b.distance) > 1e-5f * (1.f + fabsf(b.distance)))
+            return false;
+
+        return a.triangle == b.triangle
+            || a.distance == b.distance;
+    }
+
+    XMFLOAT3 RandomPoint(Random& rng, float scale)
+    {
+        return XMFLOAT3(
+            (rng.NextFloat() * 2.f - 1.f) * scale,
+            (rng.NextFloat() * 2.f - 1.f) * scale,
+            (rng.NextFloat() * 2.f - 1.f) * scale);
+    }
+
+    // Small triangles scattered through a cube, plus a few long slivers crossing it.
+    void MakeSoup(Random& rng, size_t triCount, std::vector<XMFLOAT3>& positions, std::vector<uint32_t>& indices)
+    {
+        positions.clear();
+        indices.clear();
+
+        for (size_t k = 0; k < triCount; ++k)
+        {
+            const XMFLOAT3 c = RandomPoint(rng, 10.f);
+            const float size = (k % 50) ? 0.5f : 8.f;
+
+            for (size_t j = 0; j < 3; ++j)
+            {
+                const XMFLOAT3 d = RandomPoint(rng, size);
+                indices.push_back(uint32_t(positions.size()));
+                positions.emplace_back(c.x + d.x, c.y + d.y, c.z + d.z);
+            }
+        }
+    }
+
+    bool CompareRays(
+        const ModelBVH& bvh, const std::vector<XMFLOAT3>& positions, const std::vector<uint32_t>& indices, int32_t baseVertex,
+        Random& rng, size_t rayCount, size_t& hits)
+    {
+        static const XMFLOAT3 s_axes[] =
+        {
+            XMFLOAT3(1.f, 0.f, 0.f), XMFLOAT3(-1.f, 0.f, 0.f),
+            XMFLOAT3(0.f, 1.f, 0.f), XMFLOAT3(0.f, -1.f, 0.f),
+            XMFLOAT3(0.f, 0.f, 1.f), XMFLOAT3(0.f, 0.f, -1.f),
+        };
+
+        for (size_t j = 0; j < rayCount; ++j)
+        {
+            const XMFLOAT3 origin = RandomPoint(rng, 15.f);
+
+            // Aim most rays through the soup, with some axis-aligned and unnormalized
+            XMFLOAT3 dir;
+            if (j % 8 == 0)
+            {
+                dir = s_axes[rng.Next(uint32_t(std::size(s_axes)))];
+            }
+            else
+            {
+                const XMFLOAT3 target = RandomPoint(rng, 8.f);
+                const float scale = (j % 3) ? 1.f : 0.01f;
+                dir = XMFLOAT3((target.x - origin.x) * scale, (target.y - origin.y) * scale, (target.z - origin.z) * scale);
+            }
+
+            const float maxDistance = (j % 5) ? FLT_MAX : rng.NextFloat() * 20.f / ((j % 3) ? 1.f : 0.01f);
+
+            const Hit expected = BruteForce(positions, indices, baseVertex, origin, dir, maxDistance);
+            const Hit actual = Pick(bvh, origin, dir, maxDistance);
+
+            if (!Matches(actual, expected))
+            {
+                printf("\n    ray %zu: expected %d %f %u, got %d %f %u", j,
+                    expected.hit, double(expected.distance), expected.triangle,
+                    actual.hit, double(actual.distance), actual.triangle);
+                return false;
+            }
+
+            if (actual.hit && actual.triangle == expected.triangle)
+            {
+                TEST_VERIFY(fabsf(actual.u - expected.u) < 1e-4f);
+                TEST_VERIFY(fabsf(actual.v - expected.v) < 1e-4f);
+            }
+
+            if (actual.hit)
+                ++hits;
+        }
+
+        return true;
+    }
+
+    bool TestEmpty()
+    {
+        ModelBVH bvh;
+
+        float distance;
+        uint32_t triangle;
+        float u, v;
+        TEST_VERIFY(!bvh.Intersects(XMVectorZero(), XMVectorSet(0.f, 0.f, 1.f, 0.f), FLT_MAX, distance, triangle, u, v));
+
+        const XMFLOAT3 positions[1] = {};
+        const uint16_t indices[1] = {};
+        bvh.Build(positions, sizeof(XMFLOAT3), 1, indices, false, 0);
+
+        TEST_VERIFY(bvh.GetTriangleCount() == 0);
+        TEST_VERIFY(bvh.GetNodeCount() == 0);
+        TEST_VERIFY(!bvh.Intersects(XMVectorZero(), XMVectorSet(0.f, 0.f, 1.f, 0.f), FLT_MAX, distance, triangle, u, v));
+
+        return true;
+    }
+
+    // One triangle in the z = 5 plane, with hits checked against known barycentrics.
+    bool TestSingle()
+    {
+        const XMFLOAT3 positions[] =
+        {
+            XMFLOAT3(0.f, 0.f, 5.f),
+            XMFLOAT3(4.f, 0.f, 5.f),
+            XMFLOAT3(0.f, 4.f, 5.f),
+        };
+        const uint16_t indices[] = { 0, 1, 2 };
+
+        ModelBVH bvh;
+        bvh.Build(positions, sizeof(XMFLOAT3), std::size(positions), indices, false, std::size(indices));
+
+        TEST_VERIFY(bvh.GetTriangleCount() == 1);
+        TEST_VERIFY(bvh.GetVertexCount() == 3);
+
+        float distance;
+        uint32_t triangle;
+        float u, v;
+        TEST_VERIFY(bvh.Intersects(XMVectorSet(1.f, 2.f, 0.f, 0.f), XMVectorSet(0.f, 0.f, 1.f, 0.f), FLT_MAX, distance, triangle, u, v));
+        TEST_VERIFY(fabsf(distance - 5.f) < 1e-5f);
+        TEST_VERIFY(triangle == 0);
+        TEST_VERIFY(fabsf(u - 0.25f) < 1e-5f);
+        TEST_VERIFY(fabsf(v - 0.5f) < 1e-5f);
+
+        // Back faces hit too, and the distance is in units of the direction's length
+        TEST_VERIFY(bvh.Intersects(XMVectorSet(1.f, 1.f, 10.f, 0.f), XMVectorSet(0.f, 0.f, -2.f, 0.f), FLT_MAX, distance, triangle, u, v));
+        TEST_VERIFY(fabsf(distance - 2.5f) < 1e-5f);
+
+        // Out of reach, pointing away, and outside the triangle
+        TEST_VERIFY(!bvh.Intersects(XMVectorSet(1.f, 1.f, 0.f, 0.f), XMVectorSet(0.f, 0.f, 1.f, 0.f), 4.9f, distance, triangle, u, v));
+        TEST_VERIFY(!bvh.Intersects(XMVectorSet(1.f, 1.f, 0.f, 0.f), XMVectorSet(0.f, 0.f, -1.f, 0.f), FLT_MAX, distance, triangle, u, v));
+        TEST_VERIFY(!bvh.Intersects(XMVectorSet(3.f, 3.f, 0.f, 0.f), XMVectorSet(0.f, 0.f, 1.f, 0.f), FLT_MAX, distance, triangle, u, v));
+
+        // A ray in the plane of the triangle never hits
+        TEST_VERIFY(!bvh.Intersects(XMVectorSet(-1.f, 1.f, 5.f, 0.f), XMVectorSet(1.f, 0.f, 0.f, 0.f), FLT_MAX, distance, triangle, u, v));
+
+        return true;
+    }
+
+    bool TestRandom16()
+    {
+        Random rng(35);
+
+        std::vector<XMFLOAT3> positions;
+        std::vector<uint32_t> indices;
+        MakeSoup(rng, 5000, positions, indices);
+
+        const std::vector<uint16_t> indices16(indices.begin(), indices.end());
+
+        ModelBVH bvh;
+        bvh.Build(positions.data(), sizeof(XMFLOAT3), positions.size(), indices16.data(), false, indices16.size());
+
+        TEST_VERIFY(bvh.GetTriangleCount() == 5000);
+        TEST_VERIFY(bvh.GetVertexCount() == positions.size());
+        TEST_VERIFY(bvh.GetNodeCount() > 1);
+
+        size_t hits = 0;
+        if (!CompareRays(bvh, positions, indices, 0, rng, 20000, hits))
+            return false;
+
+        // Make sure the rays actually exercised both outcomes
+        TEST_VERIFY(hits > 1000 && hits < 19000);
+
+        return true;
+    }
+
+    // A larger mesh with 32-bit indices, shared vertices, and a position stride wider than XMFLOAT3.
+    bool TestRandom32()
+    {
+        struct Vertex
+        {
+            XMFLOAT3    position;
+            float       normal[3];
+            float       uv[2];
+        };
+
+        Random rng(3532);
+
+        constexpr size_t gridSize = 200;
+
+        std::vector<XMFLOAT3> positions;
+        std::vector<Vertex> vertices;
+        for (size_t y = 0; y <= gridSize; ++y)
+        {
+            for (size_t x = 0; x <= gridSize; ++x)
+            {
+                const XMFLOAT3 p(
+                    float(x) * 0.1f - 10.f,
+                    float(y) * 0.1f - 10.f,
+                    sinf(float(x) * 0.3f) * cosf(float(y) * 0.2f) * 3.f);
+                positions.push_back(p);
+                vertices.push_back(Vertex{ p, { 0.f, 0.f, 1.f }, { 0.f, 0.f } });
+            }
+        }
+
+        std::vector<uint32_t> indices;
+        for (uint32_t y = 0; y < gridSize; ++y)
+        {
+            for (uint32_t x = 0; x < gridSize; ++x)
+            {
+                const uint32_t i0 = y * (gridSize + 1) + x;
+                const uint32_t i1 = i0 + 1;
+                const uint32_t i2 = i0 + gridSize + 1;
+                const uint32_t i3 = i2 + 1;
+                indices.insert(indices.end(), { i0, i1, i2, i2, i1, i3 });
+            }
+        }
+
+        TEST_VERIFY(positions.size() > 65536 / 2);
+
+        ModelBVH bvh;
+        bvh.Build(&vertices[0].position, sizeof(Vertex), vertices.size(), indices.data(), true, indices.size());
+
+        TEST_VERIFY(bvh.GetTriangleCount() == indices.size() / 3);
+        TEST_VERIFY(bvh.GetVertexCount() == positions.size());
+
+        size_t hits = 0;
+        return CompareRays(bvh, positions, indices, 0, rng, 4000, hits);
+    }
+
+    // Only referenced vertices are kept, and baseVertex offsets each index either way.
+    bool TestBaseVertex()
+    {
+        Random rng(350);
+
+        std::vector<XMFLOAT3> soup;
+        std::vector<uint32_t> indices;
+        MakeSoup(rng, 500, soup, indices);
+
+        // Pad unreferenced vertices on both sides of the soup
+        std::vector<XMFLOAT3> positions(100, XMFLOAT3(1e6f, 1e6f, 1e6f));
+        positions.insert(positions.end(), soup.begin(), soup.end());
+        positions.resize(positions.size() + 100, XMFLOAT3(-1e6f, -1e6f, -1e6f));
+
+        ModelBVH bvh;
+        bvh.Build(positions.data(), sizeof(XMFLOAT3), positions.size(), indices.data(), true, indices.size(), 100);
+
+        TEST_VERIFY(bvh.GetVertexCount() == soup.size());
+
+        size_t hits = 0;
+        if (!CompareRays(bvh, positions, indices, 100, rng, 5000, hits))
+            return false;
+
+        // The same soup again, now with indices past the end pulled back by a negative base vertex
+        std::vector<uint16_t> shifted(indices.size());
+        for (size_t j = 0; j < indices.size(); ++j)
+        {
+            shifted[j] = static_cast<uint16_t>(indices[j] + 300);
+        }
+
+        std::vector<uint32_t> shifted32(shifted.begin(), shifted.end());
+
+        bvh.Build(positions.data(), sizeof(XMFLOAT3), positions.size(), shifted.data(), false, shifted.size(), -200);
+
+        TEST_VERIFY(bvh.GetVertexCount() == soup.size());
+
+        hits = 0;
+        return CompareRays(bvh, positions, shifted32, -200, rng, 5000, hits);
+    }
+
+    bool TestInvalid()
+    {
+        const XMFLOAT3 positions[4] = {};
+        const uint16_t indices[] = { 0, 1, 2, 1, 2, 3 };
+
+        ModelBVH bvh;
+
+        bool threw = false;
+        try { bvh.Build(positions, sizeof(XMFLOAT3), std::size(positions), indices, false, 5); } catch (const std::invalid_argument&) { threw = true; }
+        TEST_VERIFY(threw);
+
+        threw = false;
+        try { bvh.Build(nullptr, sizeof(XMFLOAT3), std::size(positions), indices, false, 6); } catch (const std::invalid_argument&) { threw = true; }
+        TEST_VERIFY(threw);
+
+        // Index 3 is past the end of three vertices
+        threw = false;
+        try { bvh.Build(positions, sizeof(XMFLOAT3), 3, indices, false, 6); } catch (const std::out_of_range&) { threw = true; }
+        TEST_VERIFY(threw);
+
+        // And index 0 is before the start once baseVertex is applied
+        threw = false;
+        try { bvh.Build(positions, sizeof(XMFLOAT3), std::size(positions), indices, false, 6, -1); } catch (const std::out_of_range&) { threw = true; }
+        TEST_VERIFY(threw);
+
+        threw = false;
+        try { bvh.Build(positions, sizeof(XMFLOAT3), std::size(positions), indices, false, 6, 1); } catch (const std::out_of_range&) { threw = true; }
+        TEST_VERIFY(threw);
+
+        return true;
+    }
+
+    // Zero-area triangles and coincident centroids must neither hit nor break the build.
+    bool TestDegenerate()
+    {
+        std::vector<XMFLOAT3> positions;
+        std::vector<uint32_t> indices;
+
+        for (uint32_t k = 0; k < 1000; ++k)
+        {
+            const uint32_t base = uint32_t(positions.size());
+
+            if (k % 2)
+            {
+                // Collinear
+                positions.emplace_back(0.f, 0.f, 1.f);
+                positions.emplace_back(1.f, 1.f, 1.f);
+                positions.emplace_back(2.f, 2.f, 1.f);
+            }
+            else
+            {
+                // All at one point
+                positions.emplace_back(0.5f, 0.5f, 2.f);
+                positions.emplace_back(0.5f, 0.5f, 2.f);
+                positions.emplace_back(0.5f, 0.5f, 2.f);
+            }
+
+            indices.insert(indices.end(), { base, base + 1, base + 2 });
+        }
+
+        // One real triangle behind all of them
+        const uint32_t base = uint32_t(positions.size());
+        positions.emplace_back(-10.f, -10.f, 3.f);
+        positions.emplace_back(10.f, -10.f, 3.f);
+        positions.emplace_back(0.f, 10.f, 3.f);
+        indices.insert(indices.end(), { base, base + 1, base + 2 });
+
+        ModelBVH bvh;
+        bvh.Build(positions.data(), sizeof(XMFLOAT3), positions.size(), indices.data(), true, indices.size());
+
+        TEST_VERIFY(bvh.GetTriangleCount() == 1001);
+
+        float distance;
+        uint32_t triangle;
+        float u, v;
+        TEST_VERIFY(bvh.Intersects(XMVectorSet(0.5f, 0.5f, 0.f, 0.f), XMVectorSet(0.f, 0.f, 1.f, 0.f), FLT_MAX, distance, triangle, u, v));
+        TEST_VERIFY(triangle == 1000);
+        TEST_VERIFY(fabsf(distance - 3.f) < 1e-5f);
+
+        Random rng(3535);
+        size_t hits = 0;
+        return CompareRays(bvh, positions, indices, 0, rng, 2000, hits);
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "Empty", TestEmpty },
+        { "Single", TestSingle },
+        { "Random16", TestRandom16 },
+        { "Random32", TestRandom32 },
+        { "BaseVertex", TestBaseVertex },
+        { "Invalid", TestInvalid },
+        { "Degenerate", TestDegenerate },
+    };
+}
+
+int __cdecl main()
+{
+    return RunTests(g_Tests);
+}
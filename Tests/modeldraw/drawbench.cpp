@@ -0,0 +1,222 @@
+//--------------------------------------------------------------------------------------
+// File: drawbench.cpp
+//
+// Measures the CPU cost of Model::Draw on models of thousands of parts, against the
+// mesh by mesh loop it replaced, along with draw list rebuilds and custom state callbacks
+//
+// Usage: drawbench [part count]
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "BufferHelpers.h"
+#include "CommonStates.h"
+#include "DirectXHelpers.h"
+#include "Effects.h"
+#include "GeometricPrimitive.h"
+#include "Model.h"
+#include "PlatformHelpers.h"
+#include "DeviceHelpers.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    constexpr size_t c_EffectCount = 8;
+    constexpr size_t c_PartsPerMesh = 4;
+
+    struct Scene
+    {
+        std::shared_ptr<IEffect>    effects[c_EffectCount];
+        ComPtr<ID3D11InputLayout>   layouts[c_EffectCount];
+        ComPtr<ID3D11Buffer>        vbs[2];
+        ComPtr<ID3D11Buffer>        ibs[2];
+        uint32_t                    indexCounts[2];
+    };
+
+    void CreateScene(ID3D11Device* device, Scene& scene)
+    {
+        for (size_t j = 0; j < c_EffectCount; ++j)
+        {
+            auto effect = std::make_shared<BasicEffect>(device);
+            effect->EnableDefaultLighting();
+            effect->SetTextureEnabled(false);
+            effect->SetDiffuseColor(XMVectorSet(float(j) / float(c_EffectCount), 0.5f, 0.5f, 1.f));
+
+            ThrowIfFailed(CreateInputLayoutFromEffect<VertexPositionNormalTexture>(device, effect.get(), scene.layouts[j].GetAddressOf()));
+            scene.effects[j] = effect;
+        }
+
+        for (size_t j = 0; j < std::size(scene.vbs); ++j)
+        {
+            GeometricPrimitive::VertexCollection vertices;
+            GeometricPrimitive::IndexCollection indices;
+            GeometricPrimitive::CreateBox(vertices, indices, XMFLOAT3(1.f + float(j), 1.f, 1.f));
+
+            ThrowIfFailed(CreateStaticBuffer(device, vertices, D3D11_BIND_VERTEX_BUFFER, scene.vbs[j].GetAddressOf()));
+            ThrowIfFailed(CreateStaticBuffer(device, indices, D3D11_BIND_INDEX_BUFFER, scene.ibs[j].GetAddressOf()));
+            scene.indexCounts[j] = static_cast<uint32_t>(indices.size());
+        }
+    }
+
+    // Parts are spread over the effects, buffers, and windings in a shuffled order, so grouping has work to do.
+    std::unique_ptr<Model> CreateModel(const Scene& scene, size_t partCount)
+    {
+        auto model = std::make_unique<Model>();
+
+        Random rng(27);
+        for (size_t j = 0; j < partCount; j += c_PartsPerMesh)
+        {
+            auto mesh = std::make_shared<ModelMesh>();
+            mesh->ccw = (rng.Next(2) != 0);
+            mesh->boundingSphere.Radius = 1.f;
+
+            for (size_t k = 0; k < c_PartsPerMesh && (j + k) < partCount; ++k)
+            {
+                const size_t effect = rng.Next(static_cast<uint32_t>(c_EffectCount));
+                const size_t buffer = rng.Next(static_cast<uint32_t>(std::size(scene.vbs)));
+
+                auto part = new ModelMeshPart();
+                part->indexCount = scene.indexCounts[buffer];
+                part->vertexStride = sizeof(VertexPositionNormalTexture);
+                part->indexFormat = DXGI_FORMAT_R16_UINT;
+                part->vertexBuffer = scene.vbs[buffer];
+                part->indexBuffer = scene.ibs[buffer];
+                part->inputLayout = scene.layouts[effect];
+                part->effect = scene.effects[effect];
+                part->isAlpha = (rng.Next(8) == 0);
+                mesh->meshParts.emplace_back(part);
+            }
+
+            model->meshes.emplace_back(mesh);
+        }
+
+        return model;
+    }
+
+    void Run(ID3D11DeviceContext* context, const CommonStates& states, const Scene& scene, size_t partCount)
+    {
+        auto model = CreateModel(scene, partCount);
+
+        const XMMATRIX world = XMMatrixIdentity();
+        const XMMATRIX view = XMMatrixLookAtRH(XMVectorSet(0.f, 2.f, -10.f, 0.f), g_XMZero, g_XMIdentityR1);
+        const XMMATRIX proj = XMMatrixPerspectiveFovRH(XM_PIDIV4, 1.f, 0.1f, 100.f);
+
+        // Work is submitted to WARP with no render target bound, so only the submission cost is left
+        auto frame = [&](auto&& draw)
+        {
+            return Measure([&]()
+                {
+                    draw();
+                    context->Flush();
+                }, 10, 0.5);
+        };
+
+        const double listTime = frame([&]() { model->Draw(context, states, world, view, proj); });
+
+        // The loop Model::Draw used before the draw lists: every mesh sets its own state and effects
+        const double meshTime = frame([&]()
+            {
+                for (const auto& mesh : model->meshes)
+                {
+                    mesh->PrepareForRendering(context, states, false);
+                    mesh->Draw(context, world, view, proj, false);
+                }
+
+                for (const auto& mesh : model->meshes)
+                {
+                    mesh->PrepareForRendering(context, states, true);
+                    mesh->Draw(context, world, view, proj, true);
+                }
+            });
+
+        const double customTime = frame([&]()
+            {
+                model->Draw(context, states, world, view, proj, false, [&]()
+                    {
+                        context->OMSetDepthStencilState(states.DepthRead(), 0);
+                    });
+            });
+
+        // Modified drops the lists, so the next draw rebuilds them
+        const double rebuildTime = frame([&]()
+            {
+                model->Modified();
+                model->Draw(context, states, world, view, proj);
+            });
+
+        // Swapping one effect without Modified is caught by the per-draw validation
+        size_t swap = 0;
+        const double swapTime = frame([&]()
+            {
+                auto part = model->meshes[0]->meshParts[0].get();
+                ++swap;
+                part->effect = scene.effects[swap % c_EffectCount];
+                part->inputLayout = scene.layouts[swap % c_EffectCount];
+                model->Draw(context, states, world, view, proj);
+            });
+
+        const double perPart = 1e9 / double(partCount);
+        printf("%6zu parts: draw lists %7.2f ms (%5.0f ns/part), per mesh %7.2f ms (%5.0f ns/part), %.2fx\n",
+            partCount, listTime * 1000.0, listTime * perPart, meshTime * 1000.0, meshTime * perPart, meshTime / listTime);
+        printf("              custom state %7.2f ms, rebuild after Modified %7.2f ms, rebuild after effect swap %7.2f ms\n",
+            customTime * 1000.0, rebuildTime * 1000.0, swapTime * 1000.0);
+    }
+}
+
+int __cdecl main(int argc, char* argv[])
+{
+    ComPtr<ID3D11Device> device;
+    ComPtr<ID3D11DeviceContext> context;
+    if (FAILED(CreateWarpDevice(device.GetAddressOf(), context.GetAddressOf())))
+    {
+        printf("ERROR: Failed to create WARP device\n");
+        return 1;
+    }
+
+    try
+    {
+        CommonStates states(device.Get());
+
+        Scene scene = {};
+        CreateScene(device.Get(), scene);
+
+        const size_t parts = (argc > 1) ? static_cast<size_t>(atoi(argv[1])) : 0;
+        if (parts > 0)
+        {
+            Run(context.Get(), states, scene, parts);
+        }
+        else
+        {
+            Run(context.Get(), states, scene, 1000);
+            Run(context.Get(), states, scene, 4000);
+            Run(context.Get(), states, scene, 16000);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        printf("ERROR: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
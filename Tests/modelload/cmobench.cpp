@@ -0,0 +1,158 @@
+//--------------------------------------------------------------------------------------
+// File: cmobench.cpp
+//
+// Times the CPU stage of Model::CreateFromCMO (parsing, skinning stream interleave, UV
+// transform fixup, and optional quantization) headless on WARP. Each load is timed from
+// memory, then the cost of creating the same buffers is timed on its own and subtracted.
+//
+// Usage: cmobench [file.cmo]
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "BinaryReader.h"
+#include "Effects.h"
+#include "Model.h"
+#include "PlatformHelpers.h"
+#include "DeviceHelpers.h"
+#include "ModelHelpers.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // Descriptions of the distinct vertex and index buffers a model was loaded into.
+    std::vector<D3D11_BUFFER_DESC> GetBufferDescs(const Model& model)
+    {
+        std::set<ID3D11Buffer*> seen;
+        std::vector<D3D11_BUFFER_DESC> descs;
+
+        for (const auto& mesh : model.meshes)
+        {
+            for (const auto& part : mesh->meshParts)
+            {
+                for (ID3D11Buffer* buffer : { part->vertexBuffer.Get(), part->indexBuffer.Get() })
+                {
+                    if (buffer && seen.insert(buffer).second)
+                    {
+                        D3D11_BUFFER_DESC desc = {};
+                        buffer->GetDesc(&desc);
+                        descs.push_back(desc);
+                    }
+                }
+            }
+        }
+
+        return descs;
+    }
+
+    void Run(ID3D11Device* device, const char* name, const uint8_t* data, size_t dataSize, ModelLoaderFlags flags)
+    {
+        EffectFactory fxFactory(device);
+
+        const double loadTime = Measure([&]()
+            {
+                auto model = Model::CreateFromCMO(device, data, dataSize, fxFactory, flags);
+            });
+
+        // The buffers the loader creates, filled from a scratch block of the largest size
+        const auto descs = GetBufferDescs(*Model::CreateFromCMO(device, data, dataSize, fxFactory, flags));
+
+        size_t maxBytes = 0;
+        for (const auto& it : descs)
+        {
+            maxBytes = std::max<size_t>(maxBytes, it.ByteWidth);
+        }
+
+        const std::vector<uint8_t> scratch(maxBytes);
+        const D3D11_SUBRESOURCE_DATA initData = { scratch.data(), 0, 0 };
+
+        const double uploadTime = Measure([&]()
+            {
+                for (const auto& it : descs)
+                {
+                    ComPtr<ID3D11Buffer> buffer;
+                    ThrowIfFailed(device->CreateBuffer(&it, &initData, buffer.GetAddressOf()));
+                }
+            });
+
+        printf("%-32s %10.2f %10.2f %10.2f\n", name, loadTime * 1000.0, uploadTime * 1000.0,
+            std::max(loadTime - uploadTime, 0.0) * 1000.0);
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+{
+    ComPtr<ID3D11Device> device;
+    if (FAILED(CreateWarpDevice(device.GetAddressOf(), nullptr)))
+    {
+        printf("ERROR: Can't create a WARP device\n");
+        return 1;
+    }
+
+    try
+    {
+        printf("%-32s %10s %10s %10s\n", "", "load ms", "buffers ms", "CPU ms");
+
+        if (argc > 1)
+        {
+            std::unique_ptr<uint8_t[]> data;
+            size_t dataSize = 0;
+            ThrowIfFailed(BinaryReader::ReadEntireFile(argv[1], data, &dataSize));
+
+            Run(device.Get(), "default", data.get(), dataSize, ModelLoader_CounterClockwise);
+            Run(device.Get(), "quantized", data.get(), dataSize, ModelLoader_CounterClockwise | ModelLoader_QuantizeVertices);
+            Run(device.Get(), "consolidated", data.get(), dataSize, ModelLoader_CounterClockwise | ModelLoader_ConsolidateBuffers);
+        }
+        else
+        {
+            // The same vertex count split across more and more vertex buffers
+            static const struct
+            {
+                size_t vbs;
+                size_t gridSize;
+            } s_splits[] = { { 3, 256 }, { 12, 128 }, { 48, 64 } };
+
+            for (const bool skinning : { false, true })
+            {
+                for (const auto& it : s_splits)
+                {
+                    const auto cmo = CreateTestCMO(4, it.vbs, it.gridSize, skinning);
+
+                    char name[64] = {};
+                    sprintf_s(name, "%zu VBs%s", 4 * it.vbs, skinning ? ", skinned" : "");
+                    Run(device.Get(), name, cmo.data(), cmo.size(), ModelLoader_CounterClockwise);
+
+                    sprintf_s(name, "%zu VBs%s, quantized", 4 * it.vbs, skinning ? ", skinned" : "");
+                    Run(device.Get(), name, cmo.data(), cmo.size(), ModelLoader_CounterClockwise | ModelLoader_QuantizeVertices);
+                }
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        printf("ERROR: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+//--------------------------------------------------------------------------------------
+// File: loadbench.cpp
+//
+// Compares model load times from .CMO or .SDKMESH files against the baked model cache
+// written from them by Model::BakeCMO / Model::BakeSDKMESH, on WARP
+//
+// Usage: loadbench [file.cmo | file.sdkmesh]
+//
+// With a file, it is loaded with textures found next to it; otherwise a set of generated
+// .CMO models is used.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cwchar>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BinaryReader.h"
+#include "Effects.h"
+#include "Model.h"
+#include "PlatformHelpers.h"
+#include "DeviceHelpers.h"
+#include "ModelHelpers.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    uint64_t GetFileSize(const wchar_t* fileName)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data = {};
+        if (!GetFileAttributesExW(fileName, GetFileExInfoStandard, &data))
+            return 0;
+
+        return (uint64_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    }
+
+    // Times the source loader, the source loader with the consolidated buffers a bake
+    // uses, and the baked file. All loads go through the file overloads.
+    void Run(ID3D11Device* device, const wchar_t* sourceFile, const uint8_t* data, size_t dataSize, bool sdkmesh, const wchar_t* textureDirectory)
+    {
+        const ModelLoaderFlags flags = sdkmesh ? ModelLoader_Clockwise : ModelLoader_CounterClockwise;
+
+        EffectFactory fxFactory(device);
+        fxFactory.SetDirectory(textureDirectory);
+
+        TempFile baked(L"loadbench.baked", nullptr, 0);
+        if (sdkmesh)
+        {
+            Model::BakeSDKMESH(device, data, dataSize, baked.GetPath(), flags);
+        }
+        else
+        {
+            Model::BakeCMO(device, data, dataSize, baked.GetPath(), flags);
+        }
+
+        auto loadSource = [&](ModelLoaderFlags loadFlags)
+        {
+            return Measure([&]()
+                {
+                    auto model = sdkmesh
+                        ? Model::CreateFromSDKMESH(device, sourceFile, fxFactory, loadFlags)
+                        : Model::CreateFromCMO(device, sourceFile, fxFactory, loadFlags);
+                }, 3, 1.0);
+        };
+
+        const double sourceTime = loadSource(flags);
+        const double consolidatedTime = loadSource(flags | ModelLoader_ConsolidateBuffers);
+        const double bakedTime = Measure([&]()
+            {
+                auto model = Model::CreateFromBaked(device, baked.GetPath(), fxFactory);
+            }, 3, 1.0);
+
+        const double sourceMB = double(GetFileSize(sourceFile)) / (1024.0 * 1024.0);
+        const double bakedMB = double(GetFileSize(baked.GetPath())) / (1024.0 * 1024.0);
+
+        const char* format = sdkmesh ? "sdkmesh" : "cmo";
+        printf("  %-20s %8.1f MB  %8.1f ms\n", format, sourceMB, sourceTime * 1000.0);
+        printf("  %-20s %8.1f MB  %8.1f ms\n", "  consolidated", sourceMB, consolidatedTime * 1000.0);
+        printf("  %-20s %8.1f MB  %8.1f ms  (%.1fx)\n", "baked", bakedMB, bakedTime * 1000.0, sourceTime / bakedTime);
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+{
+    ComPtr<ID3D11Device> device;
+    if (FAILED(CreateWarpDevice(device.GetAddressOf(), nullptr)))
+    {
+        printf("ERROR: Can't create a WARP device\n");
+        return 1;
+    }
+
+    try
+    {
+        if (argc > 1)
+        {
+            const wchar_t* ext = wcsrchr(argv[1], L'.');
+            const bool sdkmesh = ext && !_wcsicmp(ext, L".sdkmesh");
+
+            std::unique_ptr<uint8_t[]> data;
+            size_t dataSize = 0;
+            ThrowIfFailed(BinaryReader::ReadEntireFile(argv[1], data, &dataSize));
+
+            std::wstring directory = argv[1];
+            const size_t slash = directory.find_last_of(L"\\/");
+            directory.resize((slash == std::wstring::npos) ? 0 : slash + 1);
+
+            wprintf(L"%ls\n", argv[1]);
+            Run(device.Get(), argv[1], data.get(), dataSize, sdkmesh, directory.c_str());
+        }
+        else
+        {
+            struct Config
+            {
+                const char* name;
+                size_t      meshes;
+                size_t      vbs;
+                size_t      gridSize;
+                bool        skinning;
+            };
+
+            static const Config s_configs[] =
+            {
+                { "1 mesh, 40 VBs", 1, 40, 128, false },
+                { "1 mesh, 40 skinned VBs", 1, 40, 128, true },
+                { "4 meshes, 48 VBs each", 4, 48, 96, false },
+            };
+
+            for (const auto& it : s_configs)
+            {
+                const auto cmo = CreateTestCMO(it.meshes, it.vbs, it.gridSize, it.skinning);
+                TempFile source(L"loadbench.cmo", cmo);
+
+                printf("%s, %zu vertices\n", it.name, it.meshes * it.vbs * it.gridSize * it.gridSize);
+                Run(device.Get(), source.GetPath(), cmo.data(), cmo.size(), false, nullptr);
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        printf("ERROR: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+//--------------------------------------------------------------------------------------
+// File: pixelbench.cpp
+//
+// Measures ConvertPixels and ResizePixels throughput on a 2048x2048 image
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "PixelConvert.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    struct Conversion
+    {
+        const char*     name;
+        PIXEL_LAYOUT    srcLayout;
+        uint32_t        srcFlags;
+        PIXEL_LAYOUT    destLayout;
+        uint32_t        destFlags;
+    };
+
+    const Conversion g_Conversions[] =
+    {
+        { "BGRA8 -> RGBA8",             PIXEL_LAYOUT_BGRA8,     PIXEL_DEFAULT,  PIXEL_LAYOUT_RGBA8,     PIXEL_DEFAULT },
+        { "BGR8 -> RGBA8",              PIXEL_LAYOUT_BGR8,      PIXEL_DEFAULT,  PIXEL_LAYOUT_RGBA8,     PIXEL_DEFAULT },
+        { "RGBA16 -> RGBA8",            PIXEL_LAYOUT_RGBA16,    PIXEL_DEFAULT,  PIXEL_LAYOUT_RGBA8,     PIXEL_DEFAULT },
+        { "RGBA8 premultiply",          PIXEL_LAYOUT_RGBA8,     PIXEL_DEFAULT,  PIXEL_LAYOUT_RGBA8,     PIXEL_PREMULTIPLIED },
+        { "RGBA8 sRGB -> RGBA16F",      PIXEL_LAYOUT_RGBA8,     PIXEL_SRGB,     PIXEL_LAYOUT_RGBA16F,   PIXEL_DEFAULT },
+        { "RGBA32F -> BGRA8 sRGB",      PIXEL_LAYOUT_RGBA32F,   PIXEL_DEFAULT,  PIXEL_LAYOUT_BGRA8,     PIXEL_SRGB },
+    };
+
+    struct Resize
+    {
+        const char*     name;
+        RESIZE_FILTER   filter;
+        size_t          width;
+        size_t          height;
+    };
+
+    const Resize g_Resizes[] =
+    {
+        { "box 1/2",                    RESIZE_FILTER_BOX,      1024,   1024 },
+        { "linear 1/2",                 RESIZE_FILTER_LINEAR,   1024,   1024 },
+        { "lanczos 1/2",                RESIZE_FILTER_LANCZOS,  1024,   1024 },
+        { "kaiser 1/2",                 RESIZE_FILTER_KAISER,   1024,   1024 },
+        { "linear 0.7",                 RESIZE_FILTER_LINEAR,   1434,   1434 },
+        { "lanczos 1/8",                RESIZE_FILTER_LANCZOS,  256,    256 },
+        { "linear 2x",                  RESIZE_FILTER_LINEAR,   4096,   4096 },
+    };
+
+    constexpr size_t c_size = 2048;
+
+    // Noise in any integer layout; float layouts get values in [0, 1).
+    std::vector<uint8_t> MakePixels(PIXEL_LAYOUT layout)
+    {
+        Random rng(48);
+        std::vector<uint8_t> pixels(c_size * c_size * GetPixelLayoutSize(layout));
+
+        if (layout == PIXEL_LAYOUT_RGBA32F)
+        {
+            auto values = reinterpret_cast<float*>(pixels.data());
+            for (size_t j = 0; j < c_size * c_size * 4; ++j)
+                values[j] = rng.NextFloat();
+        }
+        else if (layout == PIXEL_LAYOUT_RGBA16F)
+        {
+            auto values = reinterpret_cast<uint16_t*>(pixels.data());
+            for (size_t j = 0; j < c_size * c_size * 4; ++j)
+                values[j] = static_cast<uint16_t>(0x3000 + rng.Next(0x0C00));     // [0.125, 1)
+        }
+        else
+        {
+            for (auto& p : pixels)
+                p = static_cast<uint8_t>(rng.Next());
+        }
+
+        return pixels;
+    }
+}
+
+int __cdecl main()
+{
+    const double megapixels = double(c_size * c_size) / 1e6;
+
+    printf("%zux%zu source\n", c_size, c_size);
+    printf("%-28s %10s %10s %10s\n", "Conversion", "ms", "MPix/s", "MB/s");
+
+    for (const auto& it : g_Conversions)
+    {
+        const auto pixels = MakePixels(it.srcLayout);
+        const PixelImage image = { pixels.data(), c_size * GetPixelLayoutSize(it.srcLayout), c_size, c_size, it.srcLayout, it.srcFlags };
+
+        const size_t destPitch = c_size * GetPixelLayoutSize(it.destLayout);
+        std::vector<uint8_t> dest(destPitch * c_size);
+
+        bool failed = false;
+        const double seconds = Measure([&]()
+            {
+                if (FAILED(ConvertPixels(image, dest.data(), destPitch, it.destLayout, it.destFlags)))
+                    failed = true;
+            });
+
+        if (failed)
+        {
+            printf("ERROR: %s failed\n", it.name);
+            return 1;
+        }
+
+        const double megabytes = double(pixels.size() + dest.size()) / (1024.0 * 1024.0);
+        printf("%-28s %10.2f %10.1f %10.1f\n", it.name, seconds * 1000.0, megapixels / seconds, megabytes / seconds);
+    }
+
+    // Resizes are reported per source pixel, so the rates compare across scales
+    const auto pixels = MakePixels(PIXEL_LAYOUT_RGBA8);
+    const PixelImage image = { pixels.data(), c_size * 4, c_size, c_size, PIXEL_LAYOUT_RGBA8, PIXEL_SRGB };
+
+    printf("\n%-28s %10s %10s\n", "Resize (RGBA8 sRGB)", "ms", "MPix/s");
+
+    for (const auto& it : g_Resizes)
+    {
+        std::vector<uint8_t> dest(it.width * it.height * 4);
+
+        bool failed = false;
+        const double seconds = Measure([&]()
+            {
+                if (FAILED(ResizePixels(image, dest.data(), it.width * 4, it.width, it.height, PIXEL_LAYOUT_RGBA8, PIXEL_SRGB, it.filter)))
+                    failed = true;
+            });
+
+        if (failed)
+        {
+            printf("ERROR: %s failed\n", it.name);
+            return 1;
+        }
+
+        printf("%-28s %10.2f %10.1f\n", it.name, seconds * 1000.0, megapixels / seconds);
+    }
+
+    return 0;
+}
@@ -0,0 +1,626 @@
+//--------------------------------------------------------------------------------------
+// File: pixelconvert.cpp
+//
+// Tests for the CPU pixel conversion and resize kernels shared by the loaders and ScreenGrab
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include "PixelConvert.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    // Where each channel lives for the integer layouts; alpha is -1 when there is none.
+    struct Layout
+    {
+        PIXEL_LAYOUT    layout;
+        size_t          channels;
+        int             r;
+        int             g;
+        int             b;
+        int             a;
+        bool            wide;
+    };
+
+    const Layout g_Layouts8[] =
+    {
+        { PIXEL_LAYOUT_RGBA8, 4, 0, 1, 2, 3, false },
+        { PIXEL_LAYOUT_BGRA8, 4, 2, 1, 0, 3, false },
+        { PIXEL_LAYOUT_RGBX8, 4, 0, 1, 2, -1, false },
+        { PIXEL_LAYOUT_BGRX8, 4, 2, 1, 0, -1, false },
+        { PIXEL_LAYOUT_RGB8,  3, 0, 1, 2, -1, false },
+        { PIXEL_LAYOUT_BGR8,  3, 2, 1, 0, -1, false },
+    };
+
+    const Layout g_Layouts16[] =
+    {
+        { PIXEL_LAYOUT_RGBA16, 4, 0, 1, 2, 3, true },
+        { PIXEL_LAYOUT_BGRA16, 4, 2, 1, 0, 3, true },
+        { PIXEL_LAYOUT_RGBX16, 4, 0, 1, 2, -1, true },
+        { PIXEL_LAYOUT_RGB16,  3, 0, 1, 2, -1, true },
+        { PIXEL_LAYOUT_BGR16,  3, 2, 1, 0, -1, true },
+    };
+
+    // Channel c (0-3 for RGBA) of pixel j as a 16-bit value; missing alpha reads as opaque.
+    uint32_t GetChannel(const Layout& layout, const uint8_t* pixels, size_t j, int c)
+    {
+        const int index = (c == 0) ? layout.r : (c == 1) ? layout.g : (c == 2) ? layout.b : layout.a;
+        if (index < 0)
+            return 65535;
+
+        if (layout.wide)
+        {
+            uint16_t v;
+            memcpy(&v, pixels + (j * layout.channels + size_t(index)) * 2, sizeof(v));
+            return v;
+        }
+
+        return pixels[j * layout.channels + size_t(index)] * 257u;
+    }
+
+    std::vector<uint8_t> MakeNoise(size_t bytes, uint32_t seed)
+    {
+        Random rng(seed);
+        std::vector<uint8_t> data(bytes);
+        for (auto& it : data)
+            it = static_cast<uint8_t>(rng.Next());
+        return data;
+    }
+
+    PixelImage MakeImage(const std::vector<uint8_t>& data, size_t width, size_t height, PIXEL_LAYOUT layout, uint32_t flags = PIXEL_DEFAULT)
+    {
+        return PixelImage{ data.data(), width * GetPixelLayoutSize(layout), width, height, layout, flags };
+    }
+
+    bool TestLayoutSizes()
+    {
+        for (const auto& it : g_Layouts8)
+            TEST_VERIFY(GetPixelLayoutSize(it.layout) == it.channels);
+
+        for (const auto& it : g_Layouts16)
+            TEST_VERIFY(GetPixelLayoutSize(it.layout) == it.channels * 2);
+
+        TEST_VERIFY(GetPixelLayoutSize(PIXEL_LAYOUT_RGBA16F) == 8);
+        TEST_VERIFY(GetPixelLayoutSize(PIXEL_LAYOUT_RGBA32F) == 16);
+        TEST_VERIFY(GetPixelLayoutSize(PIXEL_LAYOUT_R32F) == 4);
+        TEST_VERIFY(GetPixelLayoutSize(PIXEL_LAYOUT_UNKNOWN) == 0);
+
+        TEST_VERIFY(IsPixelLayoutFloat(PIXEL_LAYOUT_RGBA16F));
+        TEST_VERIFY(IsPixelLayoutFloat(PIXEL_LAYOUT_RGBA32F));
+        TEST_VERIFY(IsPixelLayoutFloat(PIXEL_LAYOUT_R32F));
+        TEST_VERIFY(!IsPixelLayoutFloat(PIXEL_LAYOUT_RGBA16));
+        TEST_VERIFY(!IsPixelLayoutFloat(PIXEL_LAYOUT_BGRA8));
+
+        return true;
+    }
+
+    // Every pair of integer layouts, at the same and at different depths: channels move,
+    // missing alpha becomes opaque, and depth changes round to nearest.
+    bool TestSwizzles()
+    {
+        const size_t width = 67;
+        const size_t height = 5;
+
+        std::vector<const Layout*> layouts;
+        for (const auto& it : g_Layouts8)
+            layouts.push_back(&it);
+        for (const auto& it : g_Layouts16)
+            layouts.push_back(&it);
+
+        for (const auto src : layouts)
+        {
+            // Opaque sources, since an alpha source converted to no alpha is unpremultiplied
+            auto data = MakeNoise(width * height * GetPixelLayoutSize(src->layout), uint32_t(src->layout));
+            if (src->a >= 0)
+            {
+                for (size_t j = 0; j < width * height; ++j)
+                {
+                    if (src->wide)
+                        memset(&data[(j * 4 + size_t(src->a)) * 2], 0xFF, 2);
+                    else
+                        data[j * 4 + size_t(src->a)] = 0xFF;
+                }
+            }
+
+            const PixelImage image = MakeImage(data, width, height, src->layout);
+
+            for (const auto dest : layouts)
+            {
+                const size_t pitch = width * GetPixelLayoutSize(dest->layout) + 4;
+                std::vector<uint8_t> out(pitch * height, 0xCD);
+                TEST_VERIFY(SUCCEEDED(ConvertPixels(image, out.data(), pitch, dest->layout, PIXEL_DEFAULT)));
+
+                for (size_t y = 0; y < height; ++y)
+                {
+                    for (size_t x = 0; x < width; ++x)
+                    {
+                        for (int c = 0; c < 4; ++c)
+                        {
+                            if (c == 3 && dest->a < 0)
+                                continue;
+
+                            uint32_t expected = GetChannel(*src, data.data(), y * width + x, c);
+                            uint32_t actual = GetChannel(*dest, out.data() + y * pitch, x, c);
+                            if (!dest->wide)
+                            {
+                                expected = (expected * 255 + 32767) / 65535;
+                                actual /= 257;
+                            }
+
+                            if (actual != expected)
+                            {
+                                printf("\n    layout %u to %u, pixel %zu channel %d: %u, expected %u",
+                                    unsigned(src->layout), unsigned(dest->layout), x, c, actual, expected);
+                                return false;
+                            }
+                        }
+                    }
+
+                    // The padding is left alone
+                    TEST_VERIFY(out[y * pitch + pitch - 1] == 0xCD);
+                }
+            }
+        }
+
+        // X channels on 4 byte destinations are written opaque, whatever the source holds
+        const auto noise = MakeNoise(width * 4, 48);
+        std::vector<uint8_t> out(width * 4);
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(MakeImage(noise, width, 1, PIXEL_LAYOUT_RGBA8, PIXEL_PREMULTIPLIED), out.data(), width * 4, PIXEL_LAYOUT_BGRX8, PIXEL_DEFAULT)));
+        for (size_t x = 0; x < width; ++x)
+            TEST_VERIFY(out[x * 4 + 3] == 0xFF);
+
+        return true;
+    }
+
+    // To and from float keep values to within the rounding of the integer format.
+    bool TestFloat()
+    {
+        const size_t width = 256;
+        std::vector<uint8_t> data(width * 4);
+        for (size_t j = 0; j < width; ++j)
+        {
+            data[j * 4] = static_cast<uint8_t>(j);
+            data[j * 4 + 1] = static_cast<uint8_t>(255 - j);
+            data[j * 4 + 2] = static_cast<uint8_t>(j * 7);
+            data[j * 4 + 3] = 0xFF;
+        }
+
+        std::vector<float> linear(width * 4);
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(MakeImage(data, width, 1, PIXEL_LAYOUT_BGRA8), reinterpret_cast<uint8_t*>(linear.data()), width * 16, PIXEL_LAYOUT_RGBA32F, PIXEL_DEFAULT)));
+
+        for (size_t j = 0; j < width; ++j)
+        {
+            TEST_VERIFY(std::fabs(linear[j * 4] - float(data[j * 4 + 2]) / 255.f) < 1e-6f);
+            TEST_VERIFY(std::fabs(linear[j * 4 + 2] - float(data[j * 4]) / 255.f) < 1e-6f);
+            TEST_VERIFY(linear[j * 4 + 3] == 1.f);
+        }
+
+        std::vector<uint8_t> half(width * 8);
+        std::vector<uint8_t> back(width * 4);
+        const PixelImage floatImage = { reinterpret_cast<const uint8_t*>(linear.data()), width * 16, width, 1, PIXEL_LAYOUT_RGBA32F, PIXEL_DEFAULT };
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(floatImage, half.data(), width * 8, PIXEL_LAYOUT_RGBA16F, PIXEL_DEFAULT)));
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(MakeImage(half, width, 1, PIXEL_LAYOUT_RGBA16F), back.data(), width * 4, PIXEL_LAYOUT_BGRA8, PIXEL_DEFAULT)));
+        TEST_VERIFY(back == data);
+
+        // R32F keeps red only, and reads back as opaque
+        std::vector<float> red(width);
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(floatImage, reinterpret_cast<uint8_t*>(red.data()), width * 4, PIXEL_LAYOUT_R32F, PIXEL_DEFAULT)));
+        for (size_t j = 0; j < width; ++j)
+            TEST_VERIFY(red[j] == linear[j * 4]);
+
+        const PixelImage redImage = { reinterpret_cast<const uint8_t*>(red.data()), width * 4, width, 1, PIXEL_LAYOUT_R32F, PIXEL_DEFAULT };
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(redImage, back.data(), width * 4, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT)));
+        for (size_t j = 0; j < width; ++j)
+        {
+            TEST_VERIFY(back[j * 4] == data[j * 4 + 2]);
+            TEST_VERIFY(back[j * 4 + 1] == 0 && back[j * 4 + 2] == 0 && back[j * 4 + 3] == 0xFF);
+        }
+
+        return true;
+    }
+
+    // sRGB decode matches the transfer function, and every 8-bit value survives a trip
+    // through 16-bit linear.
+    bool TestSRGB()
+    {
+        const size_t width = 256;
+        std::vector<uint8_t> data(width * 4);
+        for (size_t j = 0; j < width; ++j)
+        {
+            data[j * 4] = data[j * 4 + 1] = data[j * 4 + 2] = static_cast<uint8_t>(j);
+            data[j * 4 + 3] = static_cast<uint8_t>(j);
+        }
+
+        std::vector<float> linear(width * 4);
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(MakeImage(data, width, 1, PIXEL_LAYOUT_RGBA8, PIXEL_SRGB | PIXEL_PREMULTIPLIED), reinterpret_cast<uint8_t*>(linear.data()), width * 16, PIXEL_LAYOUT_RGBA32F, PIXEL_PREMULTIPLIED)));
+
+        for (size_t j = 0; j < width; ++j)
+        {
+            const double s = double(j) / 255.0;
+            const double expected = (s <= 0.04045) ? s / 12.92 : std::pow((s + 0.055) / 1.055, 2.4);
+            TEST_VERIFY(std::fabs(linear[j * 4] - expected) < 1e-4);
+
+            // Alpha is never encoded
+            TEST_VERIFY(std::fabs(linear[j * 4 + 3] - s) < 1e-6);
+        }
+
+        std::vector<uint8_t> wide(width * 8);
+        std::vector<uint8_t> back(width * 4);
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(MakeImage(data, width, 1, PIXEL_LAYOUT_RGBA8, PIXEL_SRGB | PIXEL_PREMULTIPLIED), wide.data(), width * 8, PIXEL_LAYOUT_RGBA16, PIXEL_PREMULTIPLIED)));
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(MakeImage(wide, width, 1, PIXEL_LAYOUT_RGBA16, PIXEL_PREMULTIPLIED), back.data(), width * 4, PIXEL_LAYOUT_RGBA8, PIXEL_SRGB | PIXEL_PREMULTIPLIED)));
+        TEST_VERIFY(back == data);
+
+        return true;
+    }
+
+    // Premultiplying scales color by alpha; unpremultiplying undoes it as far as 8 bits allow,
+    // and fully transparent texels become black.
+    bool TestAlpha()
+    {
+        const size_t width = 256;
+        auto data = MakeNoise(width * 4, 4848);
+        for (size_t j = 0; j < width; ++j)
+            data[j * 4 + 3] = static_cast<uint8_t>(j);
+
+        std::vector<uint8_t> premultiplied(width * 4);
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(MakeImage(data, width, 1, PIXEL_LAYOUT_RGBA8), premultiplied.data(), width * 4, PIXEL_LAYOUT_BGRA8, PIXEL_PREMULTIPLIED)));
+
+        for (size_t j = 0; j < width; ++j)
+        {
+            const uint8_t* s = &data[j * 4];
+            const uint8_t* d = &premultiplied[j * 4];
+            TEST_VERIFY(d[3] == s[3]);
+
+            for (size_t c = 0; c < 3; ++c)
+            {
+                const int expected = int(std::lround(s[c] * s[3] / 255.0));
+                TEST_VERIFY(std::abs(int(d[2 - c]) - expected) <= 1);
+            }
+        }
+
+        std::vector<uint8_t> straight(width * 4);
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(MakeImage(premultiplied, width, 1, PIXEL_LAYOUT_BGRA8, PIXEL_PREMULTIPLIED), straight.data(), width * 4, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT)));
+
+        for (size_t j = 0; j < width; ++j)
+        {
+            const uint8_t* s = &data[j * 4];
+            const uint8_t* d = &straight[j * 4];
+            TEST_VERIFY(d[3] == s[3]);
+
+            for (size_t c = 0; c < 3; ++c)
+            {
+                if (!s[3])
+                {
+                    TEST_VERIFY(d[c] == 0);
+                }
+                else
+                {
+                    // Each 8-bit step of premultiplied color spans 255 / alpha steps of straight color
+                    TEST_VERIFY(std::abs(int(d[c]) - int(s[c])) <= int(std::ceil(255.0 / s[3])));
+                }
+            }
+        }
+
+        // Straight to straight and premultiplied to premultiplied leave color alone
+        std::vector<uint8_t> same(width * 4);
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(MakeImage(data, width, 1, PIXEL_LAYOUT_RGBA8, PIXEL_PREMULTIPLIED), same.data(), width * 4, PIXEL_LAYOUT_RGBA8, PIXEL_PREMULTIPLIED)));
+        TEST_VERIFY(same == data);
+
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(MakeImage(data, width, 1, PIXEL_LAYOUT_RGBA8), same.data(), width * 4, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT)));
+        TEST_VERIFY(same == data);
+
+        return true;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Resize
+    //--------------------------------------------------------------------------------------
+
+    // The filter kernels, written out independently of the library's tables.
+    double Kernel(RESIZE_FILTER filter, double t)
+    {
+        const double pi = 3.14159265358979323846;
+        auto sinc = [pi](double x) { return (x == 0) ? 1.0 : std::sin(pi * x) / (pi * x); };
+        auto besselI0 = [](double x)
+            {
+                double sum = 1.0;
+                double term = 1.0;
+                for (int k = 1; k < 50; ++k)
+                {
+                    term *= (x * x / 4.0) / (double(k) * double(k));
+                    sum += term;
+                }
+                return sum;
+            };
+
+        const double a = std::fabs(t);
+        switch (filter)
+        {
+        case RESIZE_FILTER_LINEAR:  return std::max(0.0, 1.0 - a);
+        case RESIZE_FILTER_LANCZOS: return (a < 3.0) ? sinc(t) * sinc(t / 3.0) : 0.0;
+        case RESIZE_FILTER_KAISER:  return (a < 3.0) ? sinc(t) * besselI0(4.0 * std::sqrt(1.0 - (t / 3.0) * (t / 3.0))) / besselI0(4.0) : 0.0;
+        default:                    return 0.0;
+        }
+    }
+
+    // Weight of source texel s in destination texel j along one axis.
+    std::vector<double> ReferenceWeights(RESIZE_FILTER filter, size_t srcSize, size_t destSize, size_t j)
+    {
+        std::vector<double> weights(srcSize, 0.0);
+        const double scale = double(srcSize) / double(destSize);
+
+        if (filter == RESIZE_FILTER_BOX)
+        {
+            for (size_t s = 0; s < srcSize; ++s)
+            {
+                weights[s] = std::max(0.0, std::min(double(s + 1), (j + 1) * scale) - std::max(double(s), j * scale));
+            }
+        }
+        else
+        {
+            const double kscale = std::max(scale, 1.0);
+            const double center = (j + 0.5) * scale;
+
+            for (long long s = -20; s < (long long)srcSize + 20; ++s)
+            {
+                const double w = Kernel(filter, (double(s) + 0.5 - center) / kscale);
+                weights[size_t(std::min(std::max(s, 0LL), (long long)srcSize - 1))] += w;
+            }
+        }
+
+        double total = 0;
+        for (const double w : weights)
+            total += w;
+        for (auto& w : weights)
+            w /= total;
+
+        return weights;
+    }
+
+    // An impulse at every position in turn, resized along one axis: each output texel must
+    // equal the reference weight of that source texel.
+    bool TestImpulses()
+    {
+        const RESIZE_FILTER filters[] = { RESIZE_FILTER_BOX, RESIZE_FILTER_LINEAR, RESIZE_FILTER_LANCZOS, RESIZE_FILTER_KAISER };
+        const struct { size_t src; size_t dest; } sizes[] = { { 16, 8 }, { 15, 4 }, { 12, 12 }, { 7, 16 }, { 9, 2 }, { 3, 1 } };
+
+        for (const auto filter : filters)
+        {
+            for (const auto& size : sizes)
+            {
+                for (size_t impulse = 0; impulse < size.src; ++impulse)
+                {
+                    // Horizontal and vertical passes are the same code with different tables
+                    for (const bool vertical : { false, true })
+                    {
+                        const size_t srcWidth = vertical ? 1 : size.src;
+                        const size_t srcHeight = vertical ? size.src : 1;
+                        const size_t destWidth = vertical ? 1 : size.dest;
+                        const size_t destHeight = vertical ? size.dest : 1;
+
+                        std::vector<float> pixels(size.src * 4, 0.f);
+                        for (size_t j = 0; j < size.src; ++j)
+                            pixels[j * 4 + 3] = 1.f;
+                        pixels[impulse * 4] = 1.f;
+
+                        const PixelImage image = { reinterpret_cast<const uint8_t*>(pixels.data()), srcWidth * 16, srcWidth, srcHeight, PIXEL_LAYOUT_RGBA32F, PIXEL_DEFAULT };
+
+                        std::vector<float> out(size.dest * 4);
+                        TEST_VERIFY(SUCCEEDED(ResizePixels(image, reinterpret_cast<uint8_t*>(out.data()), destWidth * 16, destWidth, destHeight, PIXEL_LAYOUT_RGBA32F, PIXEL_DEFAULT, filter)));
+
+                        for (size_t j = 0; j < size.dest; ++j)
+                        {
+                            const double expected = ReferenceWeights(filter, size.src, size.dest, j)[impulse];
+                            if (std::fabs(out[j * 4] - expected) > 1e-5 || std::fabs(out[j * 4 + 3] - 1.f) > 1e-5f)
+                            {
+                                printf("\n    filter %u, %zu to %zu, impulse at %zu, texel %zu: %f, expected %f", unsigned(filter),
+                                    size.src, size.dest, impulse, j, double(out[j * 4]), expected);
+                                return false;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // At the same size every filter is the identity, and a flat image stays flat at any size.
+    bool TestIdentity()
+    {
+        const size_t width = 33;
+        const size_t height = 19;
+        const auto data = MakeNoise(width * height * 4, 484848);
+
+        for (const auto filter : { RESIZE_FILTER_BOX, RESIZE_FILTER_LINEAR, RESIZE_FILTER_LANCZOS, RESIZE_FILTER_KAISER })
+        {
+            std::vector<uint8_t> out(width * height * 4);
+            TEST_VERIFY(SUCCEEDED(ResizePixels(MakeImage(data, width, height, PIXEL_LAYOUT_RGBA8, PIXEL_PREMULTIPLIED), out.data(), width * 4, width, height, PIXEL_LAYOUT_RGBA8, PIXEL_PREMULTIPLIED, filter)));
+            TEST_VERIFY(out == data);
+
+            std::vector<uint8_t> flat(width * height * 4);
+            for (size_t j = 0; j < width * height; ++j)
+            {
+                flat[j * 4] = 10;
+                flat[j * 4 + 1] = 128;
+                flat[j * 4 + 2] = 250;
+                flat[j * 4 + 3] = 200;
+            }
+
+            for (const auto& size : { std::make_pair(size_t(7), size_t(3)), std::make_pair(size_t(100), size_t(50)), std::make_pair(size_t(1), size_t(1)) })
+            {
+                std::vector<uint8_t> resized(size.first * size.second * 4);
+                TEST_VERIFY(SUCCEEDED(ResizePixels(MakeImage(flat, width, height, PIXEL_LAYOUT_RGBA8), resized.data(), size.first * 4, size.first, size.second, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT, filter)));
+
+                for (size_t j = 0; j < resized.size(); ++j)
+                    TEST_VERIFY(std::abs(int(resized[j]) - int(flat[j % 4])) <= 1);
+            }
+        }
+
+        return true;
+    }
+
+    // Lanczos has negative lobes, so it rings on a hard edge where the others stay in range.
+    bool TestRinging()
+    {
+        const size_t width = 32;
+        std::vector<float> pixels(width * 4, 1.f);
+        for (size_t j = 0; j < width / 2; ++j)
+            pixels[j * 4] = 0.f;
+
+        const PixelImage image = { reinterpret_cast<const uint8_t*>(pixels.data()), width * 16, width, 1, PIXEL_LAYOUT_RGBA32F, PIXEL_DEFAULT };
+
+        for (const auto filter : { RESIZE_FILTER_BOX, RESIZE_FILTER_LINEAR, RESIZE_FILTER_LANCZOS })
+        {
+            std::vector<float> out(12 * 4);
+            TEST_VERIFY(SUCCEEDED(ResizePixels(image, reinterpret_cast<uint8_t*>(out.data()), 12 * 16, 12, 1, PIXEL_LAYOUT_RGBA32F, PIXEL_DEFAULT, filter)));
+
+            float lo = 1.f;
+            float hi = 0.f;
+            for (size_t j = 0; j < 12; ++j)
+            {
+                lo = std::min(lo, out[j * 4]);
+                hi = std::max(hi, out[j * 4]);
+            }
+
+            if (filter == RESIZE_FILTER_LANCZOS)
+            {
+                TEST_VERIFY(lo < -0.01f || hi > 1.01f);
+            }
+            else
+            {
+                TEST_VERIFY(lo >= -1e-6f && hi <= 1.f + 1e-6f);
+            }
+        }
+
+        return true;
+    }
+
+    // Color is filtered premultiplied, so transparent texels don't bleed into the result.
+    bool TestResizeAlpha()
+    {
+        const uint8_t pixels[4 * 4] =
+        {
+            255, 0, 0, 255,     0, 255, 0, 0,
+            0, 255, 0, 0,       0, 255, 0, 0,
+        };
+
+        const PixelImage image = { pixels, 8, 2, 2, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT };
+
+        uint8_t out[4] = {};
+        TEST_VERIFY(SUCCEEDED(ResizePixels(image, out, 4, 1, 1, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT, RESIZE_FILTER_BOX)));
+        TEST_VERIFY(out[0] == 255 && out[1] == 0 && out[2] == 0 && out[3] == 64);
+
+        TEST_VERIFY(SUCCEEDED(ResizePixels(image, out, 4, 1, 1, PIXEL_LAYOUT_RGBA8, PIXEL_PREMULTIPLIED, RESIZE_FILTER_BOX)));
+        TEST_VERIFY(out[0] == 64 && out[1] == 0 && out[3] == 64);
+
+        // Without alpha in the destination the color is unpremultiplied
+        uint8_t rgb[3] = {};
+        TEST_VERIFY(SUCCEEDED(ResizePixels(image, rgb, 3, 1, 1, PIXEL_LAYOUT_RGB8, PIXEL_DEFAULT, RESIZE_FILTER_BOX)));
+        TEST_VERIFY(rgb[0] == 255 && rgb[1] == 0 && rgb[2] == 0);
+
+        return true;
+    }
+
+    // Images big enough to be split across threads give the same result as their rows alone.
+    bool TestBands()
+    {
+        const size_t width = 512;
+        const size_t height = 300;
+        const auto data = MakeNoise(width * height * 4, 48484848);
+
+        std::vector<uint8_t> whole(width / 2 * (height / 2) * 4);
+        TEST_VERIFY(SUCCEEDED(ResizePixels(MakeImage(data, width, height, PIXEL_LAYOUT_BGRA8, PIXEL_SRGB), whole.data(), width / 2 * 4, width / 2, height / 2, PIXEL_LAYOUT_RGBA8, PIXEL_SRGB, RESIZE_FILTER_LANCZOS)));
+
+        // The same filter run on a horizontal strip matches away from the strip's edges
+        const size_t top = 100;
+        const size_t rows = 60;
+        std::vector<uint8_t> strip(data.begin() + top * width * 4, data.begin() + (top + rows) * width * 4);
+        std::vector<uint8_t> part(width / 2 * (rows / 2) * 4);
+        TEST_VERIFY(SUCCEEDED(ResizePixels(MakeImage(strip, width, rows, PIXEL_LAYOUT_BGRA8, PIXEL_SRGB), part.data(), width / 2 * 4, width / 2, rows / 2, PIXEL_LAYOUT_RGBA8, PIXEL_SRGB, RESIZE_FILTER_LANCZOS)));
+
+        for (size_t y = 5; y < rows / 2 - 5; ++y)
+        {
+            TEST_VERIFY(memcmp(&part[y * width / 2 * 4], &whole[(top / 2 + y) * width / 2 * 4], width / 2 * 4) == 0);
+        }
+
+        std::vector<uint8_t> converted(width * height * 4);
+        std::vector<uint8_t> reference(width * 4);
+        TEST_VERIFY(SUCCEEDED(ConvertPixels(MakeImage(data, width, height, PIXEL_LAYOUT_BGRA8), converted.data(), width * 4, PIXEL_LAYOUT_RGBA8, PIXEL_PREMULTIPLIED)));
+        for (size_t y = 0; y < height; y += 37)
+        {
+            std::vector<uint8_t> row(data.begin() + y * width * 4, data.begin() + (y + 1) * width * 4);
+            TEST_VERIFY(SUCCEEDED(ConvertPixels(MakeImage(row, width, 1, PIXEL_LAYOUT_BGRA8), reference.data(), width * 4, PIXEL_LAYOUT_RGBA8, PIXEL_PREMULTIPLIED)));
+            TEST_VERIFY(memcmp(reference.data(), &converted[y * width * 4], width * 4) == 0);
+        }
+
+        return true;
+    }
+
+    bool TestInvalid()
+    {
+        const std::vector<uint8_t> data(16 * 16 * 4);
+        std::vector<uint8_t> out(16 * 16 * 16);
+        const PixelImage image = MakeImage(data, 16, 16, PIXEL_LAYOUT_RGBA8);
+
+        TEST_VERIFY(ConvertPixels(image, nullptr, 64, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT) == E_POINTER);
+        TEST_VERIFY(ConvertPixels(image, out.data(), 63, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT) == E_INVALIDARG);
+        TEST_VERIFY(ConvertPixels(image, out.data(), 64, PIXEL_LAYOUT_UNKNOWN, PIXEL_DEFAULT) == E_INVALIDARG);
+
+        PixelImage bad = image;
+        bad.rowPitch = 63;
+        TEST_VERIFY(ConvertPixels(bad, out.data(), 64, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT) == E_INVALIDARG);
+        bad = image;
+        bad.pixels = nullptr;
+        TEST_VERIFY(ConvertPixels(bad, out.data(), 64, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT) == E_INVALIDARG);
+        bad = image;
+        bad.layout = PIXEL_LAYOUT_UNKNOWN;
+        TEST_VERIFY(ResizePixels(bad, out.data(), 64, 16, 16, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT, RESIZE_FILTER_BOX) == E_INVALIDARG);
+
+        TEST_VERIFY(ResizePixels(image, nullptr, 64, 16, 16, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT, RESIZE_FILTER_BOX) == E_POINTER);
+        TEST_VERIFY(ResizePixels(image, out.data(), 64, 0, 16, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT, RESIZE_FILTER_BOX) == E_INVALIDARG);
+        TEST_VERIFY(ResizePixels(image, out.data(), 64, 16, 0, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT, RESIZE_FILTER_BOX) == E_INVALIDARG);
+        TEST_VERIFY(ResizePixels(image, out.data(), 63, 16, 16, PIXEL_LAYOUT_RGBA8, PIXEL_DEFAULT, RESIZE_FILTER_BOX) == E_INVALIDARG);
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "LayoutSizes", TestLayoutSizes },
+        { "Swizzles", TestSwizzles },
+        { "Float", TestFloat },
+        { "SRGB", TestSRGB },
+        { "Alpha", TestAlpha },
+        { "Impulses", TestImpulses },
+        { "Identity", TestIdentity },
+        { "Ringing", TestRinging },
+        { "ResizeAlpha", TestResizeAlpha },
+        { "Bands", TestBands },
+        { "Invalid", TestInvalid },
+    };
+}
+
+int __cdecl main()
+{
+    return RunTests(g_Tests);
+}
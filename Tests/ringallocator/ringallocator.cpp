@@ -0,0 +1,150 @@
+//--------------------------------------------------------------------------------------
+// File: ringallocator.cpp
+//
+// Tests for RingAllocator, the segment bookkeeping behind the constant ring
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include <sal.h>
+
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "RingAllocator.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    bool TestBasic()
+    {
+        RingAllocator ring(1024);
+
+        TEST_VERIFY(ring.GetSize() == 1024);
+        TEST_VERIFY(ring.Allocate(100, 1) == 0);
+        TEST_VERIFY(ring.Allocate(100, 256) == 256);
+        TEST_VERIFY(ring.GetUsed() == 356);
+
+        // Zero bytes and blocks bigger than the ring always fail, and change nothing
+        TEST_VERIFY(ring.Allocate(0, 16) == RingAllocator::InvalidOffset);
+        TEST_VERIFY(ring.Allocate(1025, 16) == RingAllocator::InvalidOffset);
+        TEST_VERIFY(ring.GetUsed() == 356);
+
+        // Blocks never wrap; a full segment fails until it is reset
+        TEST_VERIFY(ring.Allocate(600, 16) == 368);
+        TEST_VERIFY(ring.Allocate(100, 1) == RingAllocator::InvalidOffset);
+        TEST_VERIFY(ring.Allocate(56, 1) == 968);
+        TEST_VERIFY(ring.GetUsed() == 1024);
+        TEST_VERIFY(ring.Allocate(1, 1) == RingAllocator::InvalidOffset);
+
+        ring.Reset();
+        TEST_VERIFY(ring.GetUsed() == 0);
+        TEST_VERIFY(ring.Allocate(1024, 256) == 0);
+        TEST_VERIFY(ring.Allocate(1, 1) == RingAllocator::InvalidOffset);
+
+        ring.Reset(512);
+        TEST_VERIFY(ring.GetSize() == 512);
+        TEST_VERIFY(ring.GetUsed() == 0);
+        TEST_VERIFY(ring.Allocate(512, 16) == 0);
+
+        RingAllocator empty;
+        TEST_VERIFY(empty.Allocate(1, 1) == RingAllocator::InvalidOffset);
+
+        return true;
+    }
+
+    // The aligned head can fall past the end of a ring that isn't a multiple of the alignment.
+    bool TestEnd()
+    {
+        RingAllocator ring(1000);
+
+        TEST_VERIFY(ring.Allocate(990, 1) == 0);
+        TEST_VERIFY(ring.Allocate(1, 1024) == RingAllocator::InvalidOffset);
+        TEST_VERIFY(ring.Allocate(16, 16) == RingAllocator::InvalidOffset);
+        TEST_VERIFY(ring.Allocate(8, 8) == 992);
+        TEST_VERIFY(ring.Allocate(1, 8) == RingAllocator::InvalidOffset);
+        TEST_VERIFY(ring.GetUsed() == 1000);
+
+        return true;
+    }
+
+    // Blocks handed out within a segment are aligned, in bounds, and never overlap, and a
+    // failure only happens when the rest of the segment really can't hold the block.
+    bool TestRandom()
+    {
+        static const size_t alignments[] = { 1, 4, 16, 64, 256 };
+
+        for (const size_t size : { size_t(4096), size_t(4000), size_t(777) })
+        {
+            RingAllocator ring(size);
+            Random rng(static_cast<uint32_t>(size));
+
+            std::vector<bool> used(size, false);
+            size_t end = 0;
+            size_t allocated = 0;
+            size_t failed = 0;
+
+            for (size_t step = 0; step < 20000; ++step)
+            {
+                if (rng.Next(50) == 0)
+                {
+                    ring.Reset();
+                    used.assign(size, false);
+                    end = 0;
+                    continue;
+                }
+
+                const size_t bytes = 1 + rng.Next(uint32_t(size / 8));
+                const size_t alignment = alignments[rng.Next(uint32_t(std::size(alignments)))];
+
+                const size_t start = RingAllocator::AlignUp(end, alignment);
+                const bool fits = start <= size && bytes <= size - start;
+
+                const size_t offset = ring.Allocate(bytes, alignment);
+                if (!fits)
+                {
+                    TEST_VERIFY(offset == RingAllocator::InvalidOffset);
+                    ++failed;
+                    continue;
+                }
+
+                TEST_VERIFY(offset == start);
+                TEST_VERIFY((offset % alignment) == 0);
+                for (size_t j = offset; j < offset + bytes; ++j)
+                {
+                    TEST_VERIFY(!used[j]);
+                    used[j] = true;
+                }
+
+                end = offset + bytes;
+                TEST_VERIFY(ring.GetUsed() == end);
+                ++allocated;
+            }
+
+            // Both outcomes should have been exercised
+            TEST_VERIFY(allocated > 1000);
+            TEST_VERIFY(failed > 100);
+        }
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "Basic", TestBasic },
+        { "End", TestEnd },
+        { "Random", TestRandom },
+    };
+}
+
+int __cdecl main()
+{
+    return RunTests(g_Tests);
+}
@@ -0,0 +1,406 @@
+//--------------------------------------------------------------------------------------
+// File: skinning.cpp
+//
+// Tests for the dual quaternion bone format: SkinnedEffect::ConvertBoneTransforms, and
+// a CPU port of the shader's blend checked against matrix skinning
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Effects.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    XMFLOAT3 Add(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.x + b.x, a.y + b.y, a.z + b.z); }
+    XMFLOAT3 Scale(const XMFLOAT3& a, float s) { return XMFLOAT3(a.x * s, a.y * s, a.z * s); }
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    float Length(const XMFLOAT3& a) { return sqrtf(Dot(a, a)); }
+
+    XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+
+    float Distance(const XMFLOAT3& a, const XMFLOAT3& b) { return Length(Add(a, Scale(b, -1.f))); }
+
+    // Line for line port of Skin from Shaders/Skinning.fxh with SKINNED_DUAL_QUATERNION defined.
+    // bones holds two constants per bone, as written by ConvertBoneTransforms.
+    void SkinDualQuaternion(
+        const XMFLOAT4* bones, const uint32_t* indices, const float* weights, size_t boneCount,
+        const XMFLOAT3& inPosition, const XMFLOAT3& inNormal, XMFLOAT3& outPosition, XMFLOAT3& outNormal)
+    {
+        const XMFLOAT4& pivot = bones[indices[0] * 2];
+
+        XMFLOAT4 real(0.f, 0.f, 0.f, 0.f);
+        XMFLOAT4 dual(0.f, 0.f, 0.f, 0.f);
+        float scale = 0.f;
+
+        for (size_t i = 0; i < boneCount; ++i)
+        {
+            const XMFLOAT4& q = bones[indices[i] * 2];
+            const XMFLOAT4& ts = bones[indices[i] * 2 + 1];
+
+            const float qdot = q.x * pivot.x + q.y * pivot.y + q.z * pivot.z + q.w * pivot.w;
+            const float weight = (qdot < 0) ? -weights[i] : weights[i];
+
+            const XMFLOAT3 qv(q.x, q.y, q.z);
+            const XMFLOAT3 t(ts.x, ts.y, ts.z);
+            const XMFLOAT3 dv = Scale(Add(Scale(t, q.w), Cross(t, qv)), 0.5f);
+            const float dw = -0.5f * Dot(t, qv);
+
+            real.x += q.x * weight;
+            real.y += q.y * weight;
+            real.z += q.z * weight;
+            real.w += q.w * weight;
+            dual.x += dv.x * weight;
+            dual.y += dv.y * weight;
+            dual.z += dv.z * weight;
+            dual.w += dw * weight;
+            scale += ts.w * weights[i];
+        }
+
+        const float invLength = 1.f / sqrtf(real.x * real.x + real.y * real.y + real.z * real.z + real.w * real.w);
+
+        const XMFLOAT3 rv(real.x * invLength, real.y * invLength, real.z * invLength);
+        const float rw = real.w * invLength;
+        const XMFLOAT3 dualv(dual.x * invLength, dual.y * invLength, dual.z * invLength);
+        const float dualw = dual.w * invLength;
+
+        const XMFLOAT3 translation = Scale(Add(Add(Scale(dualv, rw), Scale(rv, -dualw)), Cross(rv, dualv)), 2.f);
+
+        XMFLOAT3 position = Scale(inPosition, scale);
+        position = Add(position, Scale(Cross(rv, Add(Cross(rv, position), Scale(position, rw))), 2.f));
+
+        outPosition = Add(position, translation);
+        outNormal = Add(inNormal, Scale(Cross(rv, Add(Cross(rv, inNormal), Scale(inNormal, rw))), 2.f));
+    }
+
+    // The path the matrix bone format takes: blend the matrices, then transform.
+    void SkinMatrix(
+        const XMMATRIX* bones, const uint32_t* indices, const float* weights, size_t boneCount,
+        const XMFLOAT3& inPosition, const XMFLOAT3& inNormal, XMFLOAT3& outPosition, XMFLOAT3& outNormal)
+    {
+        XMMATRIX skinning(XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero());
+
+        for (size_t i = 0; i < boneCount; ++i)
+        {
+            for (size_t r = 0; r < 4; ++r)
+            {
+                skinning.r[r] = XMVectorAdd(skinning.r[r], XMVectorScale(bones[indices[i]].r[r], weights[i]));
+            }
+        }
+
+        XMStoreFloat3(&outPosition, XMVector3Transform(XMLoadFloat3(&inPosition), skinning));
+        XMStoreFloat3(&outNormal, XMVector3TransformNormal(XMLoadFloat3(&inNormal), skinning));
+    }
+
+    std::vector<XMFLOAT4> Convert(const std::vector<XMMATRIX>& bones)
+    {
+        std::vector<XMVECTOR> converted(bones.size() * 2);
+        SkinnedEffect::ConvertBoneTransforms(bones.data(), bones.size(), converted.data());
+
+        std::vector<XMFLOAT4> result(converted.size());
+        for (size_t j = 0; j < converted.size(); ++j)
+        {
+            XMStoreFloat4(&result[j], converted[j]);
+        }
+        return result;
+    }
+
+    XMFLOAT3 RandomVector(Random& rng, float scale)
+    {
+        return XMFLOAT3(
+            (rng.NextFloat() * 2.f - 1.f) * scale,
+            (rng.NextFloat() * 2.f - 1.f) * scale,
+            (rng.NextFloat() * 2.f - 1.f) * scale);
+    }
+
+    XMMATRIX RandomRotation(Random& rng, float maxAngle)
+    {
+        XMFLOAT3 axis = RandomVector(rng, 1.f);
+        if (Length(axis) < 0.01f)
+            axis = XMFLOAT3(0.f, 1.f, 0.f);
+
+        return XMMatrixRotationAxis(XMLoadFloat3(&axis), (rng.NextFloat() * 2.f - 1.f) * maxAngle);
+    }
+
+    // Uniform scale, rotation, then translation: the transforms the format supports.
+    XMMATRIX RandomBone(Random& rng, float& scale)
+    {
+        scale = 0.5f + rng.NextFloat() * 1.5f;
+        const XMFLOAT3 t = RandomVector(rng, 10.f);
+
+        return XMMatrixMultiply(
+            XMMatrixMultiply(XMMatrixScaling(scale, scale, scale), RandomRotation(rng, XM_PI)),
+            XMMatrixTranslation(t.x, t.y, t.z));
+    }
+
+    bool TestConvert()
+    {
+        Random rng(41);
+
+        std::vector<XMMATRIX> bones;
+        std::vector<float> scales;
+        for (size_t j = 0; j < 1000; ++j)
+        {
+            float scale;
+            bones.push_back(RandomBone(rng, scale));
+            scales.push_back(scale);
+        }
+
+        const auto converted = Convert(bones);
+
+        for (size_t j = 0; j < bones.size(); ++j)
+        {
+            const XMFLOAT4& q = converted[j * 2];
+            const XMFLOAT4& ts = converted[j * 2 + 1];
+
+            TEST_VERIFY(fabsf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w - 1.f) < 1e-5f);
+            TEST_VERIFY(fabsf(ts.w - scales[j]) < 1e-5f * scales[j]);
+            TEST_VERIFY(ts.x == XMVectorGetX(bones[j].r[3]));
+            TEST_VERIFY(ts.y == XMVectorGetY(bones[j].r[3]));
+            TEST_VERIFY(ts.z == XMVectorGetZ(bones[j].r[3]));
+
+            // Rebuilding the matrix from the quaternion and scale gives back the original
+            const XMMATRIX rotation = XMMatrixRotationQuaternion(XMVectorSet(q.x, q.y, q.z, q.w));
+            for (size_t r = 0; r < 3; ++r)
+            {
+                const XMVECTOR diff = XMVectorSubtract(XMVectorScale(rotation.r[r], ts.w), bones[j].r[r]);
+                TEST_VERIFY(XMVectorGetX(XMVector3Length(diff)) < 1e-5f * scales[j]);
+            }
+        }
+
+        // A collapsed bone keeps an identity rotation rather than dividing by zero
+        const XMMATRIX collapsed = XMMatrixMultiply(XMMatrixScaling(0.f, 0.f, 0.f), XMMatrixTranslation(1.f, 2.f, 3.f));
+        const auto zero = Convert(std::vector<XMMATRIX>(1, collapsed));
+        TEST_VERIFY(zero[0].x == 0.f && zero[0].y == 0.f && zero[0].z == 0.f && zero[0].w == 1.f);
+        TEST_VERIFY(zero[1].x == 1.f && zero[1].y == 2.f && zero[1].z == 3.f && zero[1].w == 0.f);
+
+        return true;
+    }
+
+    // With a single bone the two formats must agree. Matrix normals carry the bone's scale.
+    bool TestSingleBone()
+    {
+        Random rng(4141);
+
+        std::vector<XMMATRIX> bones;
+        std::vector<float> scales;
+        for (size_t j = 0; j < 200; ++j)
+        {
+            float scale;
+            bones.push_back(RandomBone(rng, scale));
+            scales.push_back(scale);
+        }
+        bones.push_back(XMMatrixIdentity());
+        scales.push_back(1.f);
+
+        const auto converted = Convert(bones);
+
+        for (uint32_t j = 0; j < bones.size(); ++j)
+        {
+            for (size_t k = 0; k < 20; ++k)
+            {
+                const XMFLOAT3 position = RandomVector(rng, 5.f);
+                const XMFLOAT3 normal = RandomVector(rng, 1.f);
+                const float weight = 1.f;
+
+                XMFLOAT3 dqPosition, dqNormal, mPosition, mNormal;
+                SkinDualQuaternion(converted.data(), &j, &weight, 1, position, normal, dqPosition, dqNormal);
+                SkinMatrix(bones.data(), &j, &weight, 1, position, normal, mPosition, mNormal);
+
+                TEST_VERIFY(Distance(dqPosition, mPosition) < 1e-4f * (1.f + Length(mPosition)));
+                TEST_VERIFY(Distance(dqNormal, Scale(mNormal, 1.f / scales[j])) < 1e-5f);
+            }
+        }
+
+        return true;
+    }
+
+    // q and -q are the same rotation; blending them must not cancel out.
+    bool TestHemisphere()
+    {
+        Random rng(414);
+
+        for (size_t j = 0; j < 100; ++j)
+        {
+            float scale;
+            const std::vector<XMMATRIX> bone(1, RandomBone(rng, scale));
+            auto converted = Convert(bone);
+
+            converted.push_back(XMFLOAT4(-converted[0].x, -converted[0].y, -converted[0].z, -converted[0].w));
+            converted.push_back(converted[1]);
+
+            const uint32_t indices[] = { 0, 1 };
+            const float weights[] = { 0.3f, 0.7f };
+
+            const XMFLOAT3 position = RandomVector(rng, 5.f);
+            const XMFLOAT3 normal = RandomVector(rng, 1.f);
+
+            XMFLOAT3 single, singleNormal, blended, blendedNormal;
+            const float one = 1.f;
+            SkinDualQuaternion(converted.data(), indices, &one, 1, position, normal, single, singleNormal);
+            SkinDualQuaternion(converted.data(), indices, weights, 2, position, normal, blended, blendedNormal);
+
+            TEST_VERIFY(Distance(single, blended) < 1e-4f * (1.f + Length(single)));
+            TEST_VERIFY(Distance(singleNormal, blendedNormal) < 1e-5f);
+        }
+
+        return true;
+    }
+
+    // Bones a few degrees apart, as along a smooth limb, skin close to the matrix blend.
+    bool TestSimilarBones()
+    {
+        Random rng(41414);
+
+        for (size_t j = 0; j < 500; ++j)
+        {
+            float scale;
+            const XMMATRIX base = RandomBone(rng, scale);
+
+            std::vector<XMMATRIX> bones;
+            bones.push_back(base);
+            for (size_t k = 1; k < 4; ++k)
+            {
+                const XMFLOAT3 offset = RandomVector(rng, 0.05f);
+                bones.push_back(XMMatrixMultiply(
+                    XMMatrixMultiply(RandomRotation(rng, XMConvertToRadians(10.f)), base),
+                    XMMatrixTranslation(offset.x, offset.y, offset.z)));
+            }
+
+            const auto converted = Convert(bones);
+
+            float weights[4];
+            float total = 0.f;
+            for (auto& it : weights)
+            {
+                it = 0.1f + rng.NextFloat();
+                total += it;
+            }
+            for (auto& it : weights)
+            {
+                it /= total;
+            }
+
+            const uint32_t indices[] = { 0, 1, 2, 3 };
+            const XMFLOAT3 position = RandomVector(rng, 1.f);
+            const XMFLOAT3 normal = RandomVector(rng, 1.f);
+
+            XMFLOAT3 dqPosition, dqNormal, mPosition, mNormal;
+            SkinDualQuaternion(converted.data(), indices, weights, 4, position, normal, dqPosition, dqNormal);
+            SkinMatrix(bones.data(), indices, weights, 4, position, normal, mPosition, mNormal);
+
+            // Blended matrices shrink by about 1 - cos(angle / 2), under 1% at 10 degrees
+            TEST_VERIFY(Distance(dqPosition, mPosition) < 0.01f * scale * (1.f + Length(position)));
+            TEST_VERIFY(Distance(dqNormal, Scale(mNormal, 1.f / scale)) < 0.02f * Length(normal));
+        }
+
+        return true;
+    }
+
+    // Half way between a bone and one twisted almost half a turn about the limb, matrix
+    // blending collapses the limb towards its axis. Dual quaternions keep its radius.
+    bool TestTwist()
+    {
+        const std::vector<XMMATRIX> bones =
+        {
+            XMMatrixIdentity(),
+            XMMatrixRotationX(XMConvertToRadians(170.f)),
+        };
+
+        const auto converted = Convert(bones);
+
+        const uint32_t indices[] = { 0, 1 };
+        const float weights[] = { 0.5f, 0.5f };
+
+        for (size_t j = 0; j < 36; ++j)
+        {
+            const float angle = XMConvertToRadians(float(j * 10));
+            const XMFLOAT3 position(float(j) * 0.1f, cosf(angle), sinf(angle));
+            const XMFLOAT3 normal(0.f, cosf(angle), sinf(angle));
+
+            XMFLOAT3 dqPosition, dqNormal, mPosition, mNormal;
+            SkinDualQuaternion(converted.data(), indices, weights, 2, position, normal, dqPosition, dqNormal);
+            SkinMatrix(bones.data(), indices, weights, 2, position, normal, mPosition, mNormal);
+
+            const float dqRadius = sqrtf(dqPosition.y * dqPosition.y + dqPosition.z * dqPosition.z);
+            const float mRadius = sqrtf(mPosition.y * mPosition.y + mPosition.z * mPosition.z);
+
+            TEST_VERIFY(fabsf(dqRadius - 1.f) < 1e-4f);
+            TEST_VERIFY(fabsf(dqPosition.x - position.x) < 1e-4f);
+            TEST_VERIFY(fabsf(Length(dqNormal) - 1.f) < 1e-4f);
+
+            // cos(85 degrees)
+            TEST_VERIFY(fabsf(mRadius - 0.0872f) < 1e-3f);
+        }
+
+        return true;
+    }
+
+    // Scale is blended linearly, which matches the matrix blend when the rotations agree.
+    bool TestScale()
+    {
+        Random rng(4);
+
+        for (size_t j = 0; j < 100; ++j)
+        {
+            const XMMATRIX rotation = RandomRotation(rng, XM_PI);
+            const XMFLOAT3 t = RandomVector(rng, 10.f);
+            const XMMATRIX translation = XMMatrixTranslation(t.x, t.y, t.z);
+
+            const std::vector<XMMATRIX> bones =
+            {
+                XMMatrixMultiply(XMMatrixMultiply(XMMatrixScaling(1.f, 1.f, 1.f), rotation), translation),
+                XMMatrixMultiply(XMMatrixMultiply(XMMatrixScaling(3.f, 3.f, 3.f), rotation), translation),
+            };
+
+            const auto converted = Convert(bones);
+
+            const uint32_t indices[] = { 0, 1 };
+            const float w = rng.NextFloat();
+            const float weights[] = { w, 1.f - w };
+
+            const XMFLOAT3 position = RandomVector(rng, 5.f);
+            const XMFLOAT3 normal = RandomVector(rng, 1.f);
+
+            XMFLOAT3 dqPosition, dqNormal, mPosition, mNormal;
+            SkinDualQuaternion(converted.data(), indices, weights, 2, position, normal, dqPosition, dqNormal);
+            SkinMatrix(bones.data(), indices, weights, 2, position, normal, mPosition, mNormal);
+
+            TEST_VERIFY(Distance(dqPosition, mPosition) < 1e-4f * (1.f + Length(mPosition)));
+        }
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "Convert", TestConvert },
+        { "SingleBone", TestSingleBone },
+        { "Hemisphere", TestHemisphere },
+        { "SimilarBones", TestSimilarBones },
+        { "Twist", TestTwist },
+        { "Scale", TestScale },
+    };
+}
+
+int __cdecl main()
+{
+    return RunTests(g_Tests);
+}
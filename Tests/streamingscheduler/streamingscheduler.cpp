@@ -0,0 +1,304 @@
+//--------------------------------------------------------------------------------------
+// File: streamingscheduler.cpp
+//
+// Tests for the mip selection behind the texture streaming residency budget
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include <sal.h>
+
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "TextureStreamingScheduler.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+
+namespace
+{
+    // A square texture with a full mip chain; levels below 'tail' are the mip tail.
+    struct Texture
+    {
+        std::vector<size_t>     levelBytes;
+        TextureStreamingState   state;
+
+        Texture(uint32_t size, size_t bytesPerPixel, uint32_t tail, float priority) :
+            state{}
+        {
+            for (uint32_t w = size; ; w >>= 1)
+            {
+                levelBytes.push_back(size_t(w) * w * bytesPerPixel);
+                if (w == 1)
+                    break;
+            }
+
+            state.levelBytes = levelBytes.data();
+            state.mipLevels = static_cast<uint32_t>(levelBytes.size());
+            state.tailMip = std::min(tail, state.mipLevels - 1);
+            state.maxDimension = size;
+            state.priority = priority;
+            state.targetMip = UINT32_MAX;
+        }
+
+        Texture(Texture const&) = delete;
+        Texture& operator=(Texture const&) = delete;
+
+        size_t Resident(uint32_t mip) const
+        {
+            size_t total = 0;
+            for (uint32_t level = mip; level < state.mipLevels; ++level)
+                total += levelBytes[level];
+            return total;
+        }
+    };
+
+    std::vector<TextureStreamingState> GetStates(const std::vector<std::unique_ptr<Texture>>& textures)
+    {
+        std::vector<TextureStreamingState> states;
+        for (const auto& it : textures)
+            states.push_back(it->state);
+        return states;
+    }
+
+    size_t TotalResident(const std::vector<std::unique_ptr<Texture>>& textures, const std::vector<TextureStreamingState>& states)
+    {
+        size_t total = 0;
+        for (size_t j = 0; j < textures.size(); ++j)
+            total += textures[j]->Resident(states[j].targetMip);
+        return total;
+    }
+
+    bool TestDesiredMip()
+    {
+        const Texture texture(1024, 4, 7, 0.f);
+        auto state = texture.state;
+
+        struct { float priority; uint32_t mip; } const cases[] =
+        {
+            { 4096.f, 0 },
+            { 1024.f, 0 },
+            { 1023.f, 0 },
+            { 512.f, 1 },
+            { 511.f, 1 },
+            { 300.f, 1 },
+            { 256.f, 2 },
+            { 64.f, 4 },
+            { 9.f, 6 },
+            { 8.f, 7 },
+            { 1.f, 7 },         // Finer than the tail is all there is
+            { 0.001f, 7 },
+            { 0.f, 7 },
+            { -5.f, 7 },
+            { std::numeric_limits<float>::quiet_NaN(), 7 },
+        };
+
+        for (const auto& it : cases)
+        {
+            state.priority = it.priority;
+            const uint32_t mip = GetStreamingDesiredMip(state);
+            if (mip != it.mip)
+            {
+                printf("\n    priority %f gave mip %u, expected %u", double(it.priority), mip, it.mip);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Without a budget, or under one, every texture gets the level its priority asks for.
+    bool TestWithinBudget()
+    {
+        std::vector<std::unique_ptr<Texture>> textures;
+        textures.emplace_back(new Texture(1024, 4, 7, 1024.f));
+        textures.emplace_back(new Texture(512, 1, 5, 100.f));
+        textures.emplace_back(new Texture(256, 4, 5, 0.f));
+
+        for (const size_t budget : { size_t(0), size_t(64) * 1024 * 1024 })
+        {
+            auto states = GetStates(textures);
+            ScheduleTextureStreaming(states.data(), states.size(), budget);
+
+            TEST_VERIFY(states[0].targetMip == 0);
+            TEST_VERIFY(states[1].targetMip == 2);
+            TEST_VERIFY(states[2].targetMip == 5);
+        }
+
+        // Exactly at the budget is still within it
+        auto states = GetStates(textures);
+        const size_t exact = textures[0]->Resident(0) + textures[1]->Resident(2) + textures[2]->Resident(5);
+        ScheduleTextureStreaming(states.data(), states.size(), exact);
+        TEST_VERIFY(states[0].targetMip == 0);
+        TEST_VERIFY(states[1].targetMip == 2);
+
+        ScheduleTextureStreaming(nullptr, 0, 1);
+
+        return true;
+    }
+
+    // Over budget, the least visible texture gives up levels first, and only as many as needed.
+    bool TestOverBudget()
+    {
+        std::vector<std::unique_ptr<Texture>> textures;
+        textures.emplace_back(new Texture(1024, 4, 7, 2048.f));    // Wants level 0
+        textures.emplace_back(new Texture(1024, 4, 7, 600.f));     // Wants level 0
+        textures.emplace_back(new Texture(1024, 4, 7, 200.f));     // Wants level 2
+
+        auto states = GetStates(textures);
+
+        // Dropping the lowest priority to its tail isn't enough; the middle one loses two levels.
+        const size_t budget = textures[0]->Resident(0) + textures[1]->Resident(2) + textures[2]->Resident(7);
+        ScheduleTextureStreaming(states.data(), states.size(), budget);
+
+        TEST_VERIFY(states[0].targetMip == 0);
+        TEST_VERIFY(states[1].targetMip == 2);
+        TEST_VERIFY(states[2].targetMip == 7);
+        TEST_VERIFY(TotalResident(textures, states) <= budget);
+
+        // One byte less and the middle one drops a further level
+        states = GetStates(textures);
+        ScheduleTextureStreaming(states.data(), states.size(), budget - 1);
+        TEST_VERIFY(states[0].targetMip == 0);
+        TEST_VERIFY(states[1].targetMip == 3);
+        TEST_VERIFY(states[2].targetMip == 7);
+
+        // The most visible texture only drops once everything else is at its tail
+        states = GetStates(textures);
+        ScheduleTextureStreaming(states.data(), states.size(), textures[0]->Resident(1) + 2 * textures[0]->Resident(7));
+        TEST_VERIFY(states[0].targetMip == 1);
+        TEST_VERIFY(states[1].targetMip == 7);
+        TEST_VERIFY(states[2].targetMip == 7);
+
+        return true;
+    }
+
+    // Ties are broken by order, and the mip tails stay resident even over the budget.
+    bool TestTails()
+    {
+        std::vector<std::unique_ptr<Texture>> textures;
+        textures.emplace_back(new Texture(256, 4, 4, 256.f));
+        textures.emplace_back(new Texture(256, 4, 4, 256.f));
+
+        auto states = GetStates(textures);
+        ScheduleTextureStreaming(states.data(), states.size(), textures[0]->Resident(0) + textures[1]->Resident(1));
+        TEST_VERIFY(states[0].targetMip == 1);
+        TEST_VERIFY(states[1].targetMip == 0);
+
+        states = GetStates(textures);
+        ScheduleTextureStreaming(states.data(), states.size(), 1);
+        TEST_VERIFY(states[0].targetMip == 4);
+        TEST_VERIFY(states[1].targetMip == 4);
+        TEST_VERIFY(TotalResident(textures, states) > 1);
+
+        // A texture that is all tail is left alone
+        std::vector<std::unique_ptr<Texture>> small;
+        small.emplace_back(new Texture(4, 4, 0, 0.f));
+        states = GetStates(small);
+        ScheduleTextureStreaming(states.data(), states.size(), 1);
+        TEST_VERIFY(states[0].targetMip == 0);
+
+        return true;
+    }
+
+    // Random scenes: checks the properties the renderer relies on rather than exact levels.
+    bool TestRandom()
+    {
+        Random rng(45);
+
+        for (size_t scene = 0; scene < 500; ++scene)
+        {
+            std::vector<std::unique_ptr<Texture>> textures;
+
+            const size_t count = 1 + rng.Next(40);
+            for (size_t j = 0; j < count; ++j)
+            {
+                const uint32_t size = 1u << (2 + rng.Next(10));
+                const float priority = rng.Next(5) ? float(rng.Next(2 * size)) : 0.f;
+                textures.emplace_back(new Texture(size, 1 + rng.Next(8), 2 + rng.Next(8), priority));
+            }
+
+            std::vector<uint32_t> desired;
+            size_t wanted = 0;
+            size_t tails = 0;
+            for (const auto& it : textures)
+            {
+                desired.push_back(GetStreamingDesiredMip(it->state));
+                wanted += it->Resident(desired.back());
+                tails += it->Resident(it->state.tailMip);
+            }
+
+            const size_t budget = rng.Next(4) ? rng.Next(uint32_t(wanted + 1)) : 0;
+
+            auto states = GetStates(textures);
+            ScheduleTextureStreaming(states.data(), states.size(), budget);
+
+            const size_t total = TotalResident(textures, states);
+
+            if (!budget || wanted <= budget)
+            {
+                for (size_t j = 0; j < count; ++j)
+                    TEST_VERIFY(states[j].targetMip == desired[j]);
+                continue;
+            }
+
+            TEST_VERIFY(total <= budget || total == tails);
+
+            float lowestKept = std::numeric_limits<float>::max();
+            size_t lastDropped = SIZE_MAX;
+            for (size_t j = 0; j < count; ++j)
+            {
+                TEST_VERIFY(states[j].targetMip >= desired[j]);
+                TEST_VERIFY(states[j].targetMip <= states[j].tailMip);
+
+                if (states[j].targetMip > desired[j] && states[j].targetMip < states[j].tailMip)
+                {
+                    // At most one texture is partly dropped: the last one the scheduler visited
+                    TEST_VERIFY(lastDropped == SIZE_MAX);
+                    lastDropped = j;
+                }
+
+                if (states[j].targetMip == desired[j] && desired[j] < states[j].tailMip)
+                    lowestKept = std::min(lowestKept, states[j].priority);
+            }
+
+            // Nothing more visible than a texture that kept all its levels lost any
+            for (size_t j = 0; j < count; ++j)
+            {
+                if (states[j].targetMip > desired[j])
+                    TEST_VERIFY(states[j].priority <= lowestKept);
+            }
+
+            // No level was dropped that the budget didn't need
+            if (lastDropped != SIZE_MAX)
+            {
+                const auto& levels = textures[lastDropped]->levelBytes;
+                TEST_VERIFY(total + levels[states[lastDropped].targetMip - 1] > budget);
+            }
+        }
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "DesiredMip", TestDesiredMip },
+        { "WithinBudget", TestWithinBudget },
+        { "OverBudget", TestOverBudget },
+        { "Tails", TestTails },
+        { "Random", TestRandom },
+    };
+}
+
+int __cdecl main()
+{
+    return RunTests(g_Tests);
+}
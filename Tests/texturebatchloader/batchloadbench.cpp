@@ -0,0 +1,182 @@
+//--------------------------------------------------------------------------------------
+// File: batchloadbench.cpp
+//
+// Compares loading a set of DDS files one at a time with TextureBatchLoader on WARP,
+// and reports the batch loader's throughput without a device
+//
+// Usage: batchloadbench [directory]
+//
+// With a directory, every .dds file in it is loaded; otherwise a generated set is used.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "TextureBatchLoader.h"
+#include "DeviceHelpers.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    struct Stages
+    {
+        double read;
+        double decompress;
+        double parse;
+        double create;
+    };
+
+    // Returns the best time to load every file, or a negative value if any load failed.
+    double LoadSequential(ID3D11Device* device, const std::vector<const wchar_t*>& files)
+    {
+        bool failed = false;
+
+        const double seconds = Measure([&]()
+            {
+                for (const auto it : files)
+                {
+                    ComPtr<ID3D11Resource> texture;
+                    if (FAILED(CreateDDSTextureFromFile(device, it, texture.GetAddressOf(), nullptr)))
+                    {
+                        failed = true;
+                    }
+                }
+            }, 3, 1.0);
+
+        return failed ? -1.0 : seconds;
+    }
+
+    double LoadBatch(ID3D11Device* device, const std::vector<const wchar_t*>& files, Stages& stages)
+    {
+        TextureBatchLoader loader(device);
+
+        bool failed = false;
+        stages = {};
+
+        const double seconds = Measure([&]()
+            {
+                const auto results = loader.Load(files.data(), files.size());
+
+                stages = {};
+                for (const auto& it : results)
+                {
+                    failed |= FAILED(it.hr);
+                    stages.read += it.readTime;
+                    stages.decompress += it.decompressTime;
+                    stages.parse += it.parseTime;
+                    stages.create += it.createTime;
+                }
+            }, 3, 1.0);
+
+        return failed ? -1.0 : seconds;
+    }
+
+    void PrintStages(const Stages& stages)
+    {
+        printf("        summed over files: read %.1f ms, decompress %.1f ms, parse %.1f ms, create %.1f ms\n",
+            stages.read * 1000.0, stages.decompress * 1000.0, stages.parse * 1000.0, stages.create * 1000.0);
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+{
+    ComPtr<ID3D11Device> device;
+    if (FAILED(CreateWarpDevice(device.GetAddressOf(), nullptr)))
+    {
+        printf("ERROR: Can't create a WARP device\n");
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<TempFile>> generated;
+    std::vector<std::wstring> paths;
+
+    if (argc > 1)
+    {
+        std::wstring pattern = argv[1];
+        pattern += L"\\*.dds";
+
+        WIN32_FIND_DATAW findData = {};
+        HANDLE hFind = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, 0);
+        if (hFind == INVALID_HANDLE_VALUE)
+        {
+            wprintf(L"ERROR: No DDS files in %ls\n", argv[1]);
+            return 1;
+        }
+
+        do
+        {
+            if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+            {
+                paths.emplace_back(std::wstring(argv[1]) + L"\\" + findData.cFileName);
+            }
+        }
+        while (FindNextFileW(hFind, &findData));
+
+        FindClose(hFind);
+    }
+    else
+    {
+        // A level's worth of textures, mostly small: per-file overhead is what batching hides
+        for (uint32_t j = 0; j < 200; ++j)
+        {
+            const DDSDesc desc = (j % 10)
+                ? DDSDesc{ DXGI_FORMAT_BC1_UNORM, DDS_DIMENSION_TEXTURE2D, 256, 256, 1, 1, 9, false, false }
+                : DDSDesc{ DXGI_FORMAT_BC7_UNORM, DDS_DIMENSION_TEXTURE2D, 2048, 2048, 1, 1, 12, false, false };
+
+            generated.emplace_back(new TempFile((L"batch" + std::to_wstring(j) + L".dds").c_str(), MakeDDS(desc, j)));
+            paths.emplace_back(generated.back()->GetPath());
+        }
+    }
+
+    std::vector<const wchar_t*> files;
+    uint64_t totalBytes = 0;
+    for (const auto& it : paths)
+    {
+        files.push_back(it.c_str());
+
+        WIN32_FILE_ATTRIBUTE_DATA data = {};
+        if (GetFileAttributesExW(it.c_str(), GetFileExInfoStandard, &data))
+        {
+            totalBytes += (uint64_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        }
+    }
+
+    const double megabytes = double(totalBytes) / (1024.0 * 1024.0);
+    printf("%zu files, %.1f MB\n", files.size(), megabytes);
+
+    Stages batchStages = {};
+    Stages headlessStages = {};
+
+    const double sequentialTime = LoadSequential(device.Get(), files);
+    const double batchTime = LoadBatch(device.Get(), files, batchStages);
+    const double headlessTime = LoadBatch(nullptr, files, headlessStages);
+
+    if (sequentialTime < 0 || batchTime < 0 || headlessTime < 0)
+    {
+        printf("ERROR: Failed to load the files\n");
+        return 1;
+    }
+
+    printf("sequential: %8.1f ms  %8.1f MB/s\n", sequentialTime * 1000.0, megabytes / sequentialTime);
+    printf("batch:      %8.1f ms  %8.1f MB/s\n", batchTime * 1000.0, megabytes / batchTime);
+    PrintStages(batchStages);
+    printf("headless:   %8.1f ms  %8.1f MB/s\n", headlessTime * 1000.0, megabytes / headlessTime);
+    PrintStages(headlessStages);
+
+    return 0;
+}
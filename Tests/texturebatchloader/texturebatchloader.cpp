@@ -0,0 +1,343 @@
+//--------------------------------------------------------------------------------------
+// File: texturebatchloader.cpp
+//
+// Tests for TextureBatchLoader: results in file order, textures identical to single file
+// loads, per-file failures, and the device-less mode. Runs on a WARP device.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "TextureBatchLoader.h"
+#include "DDSCompression.h"
+#include "DeviceHelpers.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace TestHelpers;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    ComPtr<ID3D11Device> g_device;
+    ComPtr<ID3D11DeviceContext> g_context;
+
+    const DDSDesc g_Textures[] =
+    {
+        // format                           dimension                   w      h     d  array mips  cube   legacy
+        { DXGI_FORMAT_R8G8B8A8_UNORM,       DDS_DIMENSION_TEXTURE2D,    256,   256,  1, 1,    9,    false, false },
+        { DXGI_FORMAT_B5G6R5_UNORM,         DDS_DIMENSION_TEXTURE2D,    64,    32,   1, 1,    7,    false, true },
+        { DXGI_FORMAT_BC1_UNORM,            DDS_DIMENSION_TEXTURE2D,    256,   128,  1, 1,    9,    false, true },
+        { DXGI_FORMAT_BC3_UNORM,            DDS_DIMENSION_TEXTURE2D,    128,   128,  1, 4,    8,    false, false },
+        { DXGI_FORMAT_BC7_UNORM,            DDS_DIMENSION_TEXTURE2D,    512,   256,  1, 1,    10,   false, false },
+        { DXGI_FORMAT_R8G8B8A8_UNORM,       DDS_DIMENSION_TEXTURE2D,    64,    64,   1, 1,    7,    true,  true },
+        { DXGI_FORMAT_R16G16B16A16_FLOAT,   DDS_DIMENSION_TEXTURE3D,    32,    16,   8, 1,    6,    false, false },
+        { DXGI_FORMAT_R32_FLOAT,            DDS_DIMENSION_TEXTURE1D,    1024,  1,    1, 3,    11,   false, false },
+    };
+
+    // A batch of generated files on disk; every third one is supercompressed.
+    struct Batch
+    {
+        std::vector<std::vector<uint8_t>>       contents;   // As DDS, before any compression
+        std::vector<std::unique_ptr<TempFile>>  files;
+        std::vector<const wchar_t*>             names;
+
+        Batch(const wchar_t* prefix, size_t count)
+        {
+            for (size_t j = 0; j < count; ++j)
+            {
+                contents.emplace_back(MakeDDS(g_Textures[j % std::size(g_Textures)], uint32_t(46 + j)));
+
+                const std::wstring name = prefix + std::to_wstring(j) + L".dds";
+                if (j % 3 == 2)
+                {
+                    std::vector<uint8_t> packed;
+                    if (FAILED(CompressDDS(contents.back().data(), contents.back().size(), packed)))
+                        throw std::runtime_error("CompressDDS");
+
+                    files.emplace_back(new TempFile(name.c_str(), packed));
+                }
+                else
+                {
+                    files.emplace_back(new TempFile(name.c_str(), contents.back()));
+                }
+
+                names.push_back(files.back()->GetPath());
+            }
+        }
+    };
+
+    uint64_t GetFileSize(const wchar_t* fileName)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data = {};
+        if (!GetFileAttributesExW(fileName, GetFileExInfoStandard, &data))
+            return 0;
+
+        return (uint64_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    }
+
+    // The texture must hold exactly the subresources ParseDDS finds in the file.
+    bool MatchesFile(ID3D11Resource* texture, const std::vector<uint8_t>& dds)
+    {
+        DDSTextureDesc desc;
+        TEST_VERIFY(SUCCEEDED(ParseDDS(dds.data(), dds.size(), &desc)));
+
+        std::vector<DDSSubresource> expected(desc.subresourceCount);
+        TEST_VERIFY(SUCCEEDED(ParseDDS(dds.data(), dds.size(), &desc, expected.data(), expected.size())));
+
+        std::vector<std::vector<uint8_t>> subresources;
+        TEST_VERIFY(SUCCEEDED(ReadTexture(g_device.Get(), g_context.Get(), texture, subresources)));
+        TEST_VERIFY(subresources.size() == expected.size());
+
+        for (size_t j = 0; j < expected.size(); ++j)
+        {
+            TEST_VERIFY(subresources[j].size() == expected[j].size);
+            TEST_VERIFY(memcmp(subresources[j].data(), dds.data() + expected[j].offset, expected[j].size) == 0);
+        }
+
+        return true;
+    }
+
+    bool CheckBatch(const Batch& batch, const std::vector<TextureBatchLoader::Result>& results, bool withDevice)
+    {
+        TEST_VERIFY(results.size() == batch.names.size());
+
+        for (size_t j = 0; j < results.size(); ++j)
+        {
+            const auto& result = results[j];
+            if (FAILED(result.hr))
+            {
+                printf("\n    file %zu failed (%08X)", j, static_cast<unsigned int>(result.hr));
+                return false;
+            }
+
+            DDSTextureDesc expected;
+            TEST_VERIFY(SUCCEEDED(ParseDDS(batch.contents[j].data(), batch.contents[j].size(), &expected)));
+            TEST_VERIFY(result.desc.format == expected.format);
+            TEST_VERIFY(result.desc.width == expected.width);
+            TEST_VERIFY(result.desc.height == expected.height);
+            TEST_VERIFY(result.desc.depth == expected.depth);
+            TEST_VERIFY(result.desc.arraySize == expected.arraySize);
+            TEST_VERIFY(result.desc.mipLevels == expected.mipLevels);
+            TEST_VERIFY(result.desc.dataOffset == expected.dataOffset);
+
+            TEST_VERIFY(result.fileSize == GetFileSize(batch.names[j]));
+            TEST_VERIFY(result.readTime >= 0 && result.parseTime >= 0);
+            if (j % 3 != 2)
+                TEST_VERIFY(result.decompressTime == 0);
+
+            if (withDevice)
+            {
+                TEST_VERIFY(result.texture && result.textureView);
+                TEST_VERIFY(MatchesFile(result.texture.Get(), batch.contents[j]));
+            }
+            else
+            {
+                TEST_VERIFY(!result.texture && !result.textureView);
+                TEST_VERIFY(result.createTime == 0);
+            }
+        }
+
+        return true;
+    }
+
+    // Results line up with the file names whatever the thread counts, including more files
+    // than the queue between the I/O and CPU threads holds.
+    bool TestOrdered()
+    {
+        const Batch batch(L"batch", 64);
+
+        const struct { size_t io; size_t cpu; } threads[] = { { 0, 0 }, { 1, 1 }, { 8, 1 }, { 1, 8 }, { 3, 5 } };
+
+        for (const auto& it : threads)
+        {
+            TextureBatchLoader loader(g_device.Get(), it.io, it.cpu);
+
+            const auto results = loader.Load(batch.names.data(), batch.names.size());
+            if (!CheckBatch(batch, results, true))
+            {
+                printf("\n    with %zu I/O and %zu CPU threads", it.io, it.cpu);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Without a device the files are still read, decompressed, and parsed.
+    bool TestHeadless()
+    {
+        const Batch batch(L"headless", 24);
+
+        TextureBatchLoader loader(nullptr, 4, 4);
+        TEST_VERIFY(CheckBatch(batch, loader.Load(batch.names.data(), batch.names.size()), false));
+
+        return true;
+    }
+
+    // Flags reach every texture, and a mapped load is done from the buffer already read.
+    bool TestFlags()
+    {
+        const Batch batch(L"flags", 6);
+
+        TextureBatchLoader loader(g_device.Get());
+        const auto results = loader.Load(batch.names.data(), batch.names.size(), DDS_LOADER_FORCE_SRGB | DDS_LOADER_MEMORY_MAPPED);
+
+        for (size_t j = 0; j < results.size(); ++j)
+        {
+            TEST_VERIFY(SUCCEEDED(results[j].hr));
+
+            ComPtr<ID3D11ShaderResourceView> single;
+            TEST_VERIFY(SUCCEEDED(CreateDDSTextureFromMemoryEx(g_device.Get(), batch.contents[j].data(), batch.contents[j].size(), 0,
+                D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, DDS_LOADER_FORCE_SRGB,
+                nullptr, single.GetAddressOf())));
+
+            D3D11_SHADER_RESOURCE_VIEW_DESC batchDesc = {};
+            D3D11_SHADER_RESOURCE_VIEW_DESC singleDesc = {};
+            results[j].textureView->GetDesc(&batchDesc);
+            single->GetDesc(&singleDesc);
+            TEST_VERIFY(memcmp(&batchDesc, &singleDesc, sizeof(batchDesc)) == 0);
+        }
+
+        return true;
+    }
+
+    // Each bad file fails on its own, with the error a single load gives, and the rest load.
+    bool TestErrors()
+    {
+        const Batch batch(L"errors", 8);
+
+        const DDSDesc desc = { DXGI_FORMAT_BC1_UNORM, DDS_DIMENSION_TEXTURE2D, 256, 256, 1, 1, 9, false, false };
+        const auto dds = MakeDDS(desc, 464646);
+
+        std::vector<uint8_t> packed;
+        TEST_VERIFY(SUCCEEDED(CompressDDS(dds.data(), dds.size(), packed)));
+
+        std::vector<std::vector<uint8_t>> bad;
+        bad.emplace_back();                                             // Empty
+        bad.emplace_back(dds.begin(), dds.begin() + 64);                // Part of the header
+        bad.emplace_back(dds.begin(), dds.end() - 1);                   // One byte short
+        bad.push_back(dds);
+        bad.back()[0] = 'X';                                            // Bad magic
+        bad.emplace_back(packed.begin(), packed.end() - 1);             // Truncated supercompressed
+
+        std::vector<std::unique_ptr<TempFile>> files;
+        for (size_t j = 0; j < bad.size(); ++j)
+        {
+            files.emplace_back(new TempFile((L"bad" + std::to_wstring(j) + L".dds").c_str(), bad[j]));
+        }
+
+        // Good and bad files interleaved; good files record their index in the batch
+        struct Entry
+        {
+            const wchar_t*  name;
+            size_t          good;
+        };
+
+        std::vector<Entry> entries;
+        for (size_t j = 0; j < batch.names.size(); ++j)
+        {
+            entries.push_back({ batch.names[j], j });
+
+            if (j < files.size())
+                entries.push_back({ files[j]->GetPath(), SIZE_MAX });
+        }
+
+        entries.push_back({ L"DirectXTKTest_missing.dds", SIZE_MAX });
+        entries.push_back({ nullptr, SIZE_MAX });
+
+        std::vector<const wchar_t*> names;
+        for (const auto& it : entries)
+            names.push_back(it.name);
+
+        TextureBatchLoader loader(g_device.Get(), 2, 2);
+        const auto results = loader.Load(names.data(), names.size());
+        TEST_VERIFY(results.size() == names.size());
+
+        for (size_t j = 0; j < entries.size(); ++j)
+        {
+            const auto& result = results[j];
+
+            if (entries[j].good != SIZE_MAX)
+            {
+                TEST_VERIFY(SUCCEEDED(result.hr));
+                TEST_VERIFY(MatchesFile(result.texture.Get(), batch.contents[entries[j].good]));
+                continue;
+            }
+
+            TEST_VERIFY(FAILED(result.hr));
+            TEST_VERIFY(!result.texture && !result.textureView);
+
+            if (!entries[j].name)
+            {
+                TEST_VERIFY(result.hr == E_INVALIDARG);
+            }
+            else if (entries[j].name != files.back()->GetPath())
+            {
+                // Supercompressed files have no single file load to compare with
+                ComPtr<ID3D11Resource> texture;
+                const HRESULT hr = CreateDDSTextureFromFile(g_device.Get(), entries[j].name, texture.GetAddressOf(), nullptr);
+                if (hr != result.hr)
+                {
+                    printf("\n    file %zu: %08X, single load %08X", j, static_cast<unsigned int>(result.hr), static_cast<unsigned int>(hr));
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool TestEmpty()
+    {
+        TextureBatchLoader loader(g_device.Get());
+
+        TEST_VERIFY(loader.Load(nullptr, 0).empty());
+
+        bool threw = false;
+        try { (void)loader.Load(nullptr, 3); } catch (const std::invalid_argument&) { threw = true; }
+        TEST_VERIFY(threw);
+
+        // The loader is reusable, and movable between batches
+        const Batch batch(L"reuse", 3);
+        TEST_VERIFY(CheckBatch(batch, loader.Load(batch.names.data(), batch.names.size()), true));
+
+        TextureBatchLoader moved(std::move(loader));
+        TEST_VERIFY(CheckBatch(batch, moved.Load(batch.names.data(), batch.names.size()), true));
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "Ordered", TestOrdered },
+        { "Headless", TestHeadless },
+        { "Flags", TestFlags },
+        { "Errors", TestErrors },
+        { "Empty", TestEmpty },
+    };
+}
+
+int __cdecl main()
+{
+    if (FAILED(CreateWarpDevice(g_device.GetAddressOf(), g_context.GetAddressOf())))
+    {
+        printf("ERROR: Can't create a WARP device\n");
+        return 1;
+    }
+
+    return RunTests(g_Tests);
+}
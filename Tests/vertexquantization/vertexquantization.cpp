@@ -0,0 +1,327 @@
+//--------------------------------------------------------------------------------------
+// File: vertexquantization.cpp
+//
+// Tests for the vertex encoders behind ModelLoader_QuantizeVertices
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include <sal.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "VertexQuantization.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace DirectX::VertexQuantization;
+using namespace TestHelpers;
+
+namespace
+{
+    // VertexPositionNormalTangentColorTextureSkinning, as read from a .CMO file
+    struct SourceVertex
+    {
+        XMFLOAT3 position;
+        XMFLOAT3 normal;
+        XMFLOAT4 tangent;
+        uint32_t color;
+        XMFLOAT2 textureCoordinate;
+        uint32_t indices;
+        uint32_t weights;
+    };
+
+    static_assert(offsetof(SourceVertex, normal) == c_SourceNormalOffset, "layout mismatch");
+    static_assert(offsetof(SourceVertex, tangent) == c_SourceTangentOffset, "layout mismatch");
+    static_assert(offsetof(SourceVertex, color) == c_SourceColorOffset, "layout mismatch");
+    static_assert(offsetof(SourceVertex, textureCoordinate) == c_SourceTexCoordOffset, "layout mismatch");
+    static_assert(offsetof(SourceVertex, indices) == c_SourceSkinningOffset, "layout mismatch");
+
+    XMVECTOR RandomDirection(Random& rng)
+    {
+        for (;;)
+        {
+            const XMVECTOR v = XMVectorSet(rng.NextFloat() * 2.f - 1.f, rng.NextFloat() * 2.f - 1.f, rng.NextFloat() * 2.f - 1.f, 0.f);
+            const float lengthSq = XMVectorGetX(XMVector3LengthSq(v));
+            if (lengthSq > 1e-4f && lengthSq <= 1.f)
+                return XMVector3Normalize(v);
+        }
+    }
+
+    // Angle in radians between two directions, accurate for tiny angles where acos is not.
+    float AngleBetween(FXMVECTOR a, FXMVECTOR b)
+    {
+        const float sine = XMVectorGetX(XMVector3Length(XMVector3Cross(a, b)));
+        const float cosine = XMVectorGetX(XMVector3Dot(a, b));
+        return std::atan2(sine, cosine);
+    }
+
+    bool TestUnitVector()
+    {
+        std::vector<XMVECTOR> dirs;
+
+        // The axes and the diagonals land on or between the grid points in every component
+        for (int x = -1; x <= 1; ++x)
+        {
+            for (int y = -1; y <= 1; ++y)
+            {
+                for (int z = -1; z <= 1; ++z)
+                {
+                    if (x || y || z)
+                        dirs.push_back(XMVector3Normalize(XMVectorSet(float(x), float(y), float(z), 0.f)));
+                }
+            }
+        }
+
+        // A dense sweep of the sphere, then random directions
+        constexpr int c_Steps = 256;
+        for (int j = 0; j <= c_Steps; ++j)
+        {
+            const float theta = XM_PI * float(j) / float(c_Steps);
+            for (int k = 0; k < 2 * c_Steps; ++k)
+            {
+                const float phi = XM_PI * float(k) / float(c_Steps);
+                dirs.push_back(XMVectorSet(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta), 0.f));
+            }
+        }
+
+        Random rng(32);
+        for (size_t j = 0; j < 200000; ++j)
+        {
+            dirs.push_back(RandomDirection(rng));
+        }
+
+        float worst = 0.f;
+        for (const XMVECTOR v : dirs)
+        {
+            const XMVECTOR decoded = DecodeUnitVector(EncodeUnitVector(v));
+            const float angle = AngleBetween(v, decoded);
+            if (angle > worst)
+                worst = angle;
+        }
+
+        TEST_VERIFY(worst <= c_MaxUnitVectorError);
+
+        // The stated bound is close to the real worst case, not just a safe overestimate
+        TEST_VERIFY(worst > 0.9f * c_MaxUnitVectorError);
+
+        // Only the direction is kept; the length of the input doesn't matter
+        const XMVECTOR v = XMVectorSet(0.3f, -0.4f, 0.5f, 0.f);
+        TEST_VERIFY(EncodeUnitVector(v) == EncodeUnitVector(XMVectorScale(v, 40.f)));
+
+        // The sign of w survives in the alpha bits
+        TEST_VERIFY(XMVectorGetW(DecodeUnitVector(EncodeUnitVector(v, 1.f))) == 1.f);
+        TEST_VERIFY(XMVectorGetW(DecodeUnitVector(EncodeUnitVector(v, -1.f))) == -1.f);
+        TEST_VERIFY(EncodeUnitVector(v, 1.f) != EncodeUnitVector(v, -1.f));
+
+        // Degenerate input encodes as zero length rather than NaN
+        const XMVECTOR zero = DecodeUnitVector(EncodeUnitVector(g_XMZero));
+        TEST_VERIFY(XMVectorGetX(XMVector3Length(zero)) < 0.01f);
+
+        return true;
+    }
+
+    TexCoordEncoding Choose(const std::vector<XMFLOAT2>& uvs, float maxError = c_MaxTexCoordError)
+    {
+        return ChooseTexCoordEncoding(reinterpret_cast<const uint8_t*>(uvs.data()), sizeof(XMFLOAT2), uvs.size(), maxError);
+    }
+
+    // Every coordinate of the stream survives the chosen encoding within maxError.
+    bool RoundTrips(const std::vector<XMFLOAT2>& uvs, TexCoordEncoding encoding, float maxError)
+    {
+        for (const auto& it : uvs)
+        {
+            uint8_t packed[8] = {};
+            EncodeTexCoord(XMLoadFloat2(&it), encoding, packed);
+
+            XMFLOAT2 decoded;
+            XMStoreFloat2(&decoded, DecodeTexCoord(packed, encoding));
+
+            if (std::fabs(decoded.x - it.x) > maxError || std::fabs(decoded.y - it.y) > maxError)
+                return false;
+        }
+
+        return true;
+    }
+
+    bool TestTexCoordEncoding()
+    {
+        TEST_VERIFY(GetTexCoordSize(TexCoordEncoding::UNorm16) == 4);
+        TEST_VERIFY(GetTexCoordSize(TexCoordEncoding::Float16) == 4);
+        TEST_VERIFY(GetTexCoordSize(TexCoordEncoding::Float32) == 8);
+
+        // An empty stream takes the smallest encoding
+        TEST_VERIFY(Choose({}) == TexCoordEncoding::UNorm16);
+
+        // Anything in [0,1] fits R16G16_UNORM at the default bound
+        Random rng(7);
+        std::vector<XMFLOAT2> uvs;
+        for (size_t j = 0; j < 10000; ++j)
+        {
+            uvs.emplace_back(rng.NextFloat(), rng.NextFloat());
+        }
+        uvs.emplace_back(0.f, 1.f);
+        uvs.emplace_back(1.f, 0.f);
+        TEST_VERIFY(Choose(uvs) == TexCoordEncoding::UNorm16);
+        TEST_VERIFY(RoundTrips(uvs, TexCoordEncoding::UNorm16, c_MaxTexCoordError));
+
+        // One coordinate outside [0,1] moves the whole stream to half, or to float when half
+        // can't hold it either
+        for (const float outside : { -0.25f, 1.5f, 3.75f })
+        {
+            auto wrapped = uvs;
+            wrapped[wrapped.size() / 2].y = outside;
+            TEST_VERIFY(Choose(wrapped) == TexCoordEncoding::Float16);
+            TEST_VERIFY(RoundTrips(wrapped, TexCoordEncoding::Float16, c_MaxTexCoordError));
+        }
+
+        {
+            auto tiled = uvs;
+            tiled.back().x = 300.3f;
+            TEST_VERIFY(Choose(tiled) == TexCoordEncoding::Float32);
+            TEST_VERIFY(RoundTrips(tiled, TexCoordEncoding::Float32, 0.f));
+        }
+
+        // Non-finite input never picks a 16-bit encoding
+        {
+            auto broken = uvs;
+            broken.front().x = NAN;
+            TEST_VERIFY(Choose(broken) == TexCoordEncoding::Float32);
+        }
+
+        // A bound tighter than R16G16_UNORM's step rejects it even inside [0,1]. Coordinates on
+        // the half grid then fall back to half; the random ones need float.
+        const float tight = 1e-6f;
+        TEST_VERIFY(Choose(uvs, tight) == TexCoordEncoding::Float32);
+
+        std::vector<XMFLOAT2> halfGrid;
+        for (uint32_t j = 0; j < 1024; ++j)
+        {
+            const float u = 0.5f + float(j) / 2048.f;
+            halfGrid.emplace_back(u, float(j) / 1024.f);
+        }
+        TEST_VERIFY(Choose(halfGrid, tight) == TexCoordEncoding::Float16);
+        TEST_VERIFY(RoundTrips(halfGrid, TexCoordEncoding::Float16, 0.f));
+        TEST_VERIFY(Choose(halfGrid) == TexCoordEncoding::UNorm16);
+
+        // Coordinates on the R16G16_UNORM grid are exact under any bound
+        std::vector<XMFLOAT2> unormGrid;
+        for (uint32_t j = 0; j <= 65535; j += 97)
+        {
+            unormGrid.emplace_back(float(j) / 65535.f, float(65535 - j) / 65535.f);
+        }
+        TEST_VERIFY(Choose(unormGrid, tight) == TexCoordEncoding::UNorm16);
+
+        return true;
+    }
+
+    // The .CMO loader's path: pick the encoding for the stream, then re-encode every vertex.
+    bool TestQuantizeVertex()
+    {
+        Random rng(52);
+
+        for (const bool skinning : { false, true })
+        {
+            // Coordinates in [0,1], in [-1,1] where half is within the bound, and tiled far past it
+            for (const XMFLOAT2 uvRange : { XMFLOAT2(0.f, 1.f), XMFLOAT2(-1.f, 1.f), XMFLOAT2(0.f, 5000.f) })
+            {
+                std::vector<SourceVertex> verts(1000);
+                for (auto& it : verts)
+                {
+                    it.position = XMFLOAT3(rng.NextFloat() * 200.f - 100.f, rng.NextFloat() * 200.f - 100.f, rng.NextFloat() * 200.f - 100.f);
+
+                    // Normals from files aren't always unit length
+                    XMStoreFloat3(&it.normal, XMVectorScale(RandomDirection(rng), 0.5f + rng.NextFloat()));
+
+                    XMStoreFloat4(&it.tangent, RandomDirection(rng));
+                    it.tangent.w = rng.Next(2) ? 1.f : -1.f;
+
+                    it.color = rng.Next();
+                    const float width = uvRange.y - uvRange.x;
+                    it.textureCoordinate = XMFLOAT2(uvRange.x + rng.NextFloat() * width, uvRange.x + rng.NextFloat() * width);
+                    it.indices = rng.Next();
+                    it.weights = rng.Next();
+                }
+
+                const TexCoordEncoding encoding = ChooseTexCoordEncoding(
+                    reinterpret_cast<const uint8_t*>(verts.data()) + c_SourceTexCoordOffset,
+                    sizeof(SourceVertex), verts.size());
+
+                TEST_VERIFY(encoding == ((uvRange.y > 1.f) ? TexCoordEncoding::Float32
+                    : (uvRange.x < 0.f) ? TexCoordEncoding::Float16 : TexCoordEncoding::UNorm16));
+
+                const size_t stride = GetVertexSize(encoding, skinning);
+                TEST_VERIFY(stride == c_TexCoordOffset + GetTexCoordSize(encoding) + (skinning ? 8 : 0));
+
+                // One spare vertex at the end catches writes past the stride
+                std::vector<uint8_t> dest(stride * (verts.size() + 1), 0xCD);
+                for (size_t j = 0; j < verts.size(); ++j)
+                {
+                    QuantizeVertex(reinterpret_cast<const uint8_t*>(&verts[j]), dest.data() + j * stride, encoding, skinning);
+                }
+
+                for (size_t j = stride * verts.size(); j < dest.size(); ++j)
+                {
+                    TEST_VERIFY(dest[j] == 0xCD);
+                }
+
+                for (size_t j = 0; j < verts.size(); ++j)
+                {
+                    const SourceVertex& src = verts[j];
+                    const uint8_t* ptr = dest.data() + j * stride;
+
+                    XMFLOAT3 position;
+                    uint32_t packed[3];
+                    memcpy(&position, ptr, sizeof(position));
+                    memcpy(packed, ptr + sizeof(XMFLOAT3), sizeof(packed));
+
+                    TEST_VERIFY(memcmp(&position, &src.position, sizeof(position)) == 0);
+
+                    const XMVECTOR normal = DecodeUnitVector(packed[0]);
+                    TEST_VERIFY(AngleBetween(XMVector3Normalize(XMLoadFloat3(&src.normal)), normal) <= c_MaxUnitVectorError);
+
+                    const XMVECTOR tangent = DecodeUnitVector(packed[1]);
+                    TEST_VERIFY(AngleBetween(XMLoadFloat4(&src.tangent), tangent) <= c_MaxUnitVectorError);
+                    TEST_VERIFY(XMVectorGetW(tangent) == src.tangent.w);
+
+                    TEST_VERIFY(packed[2] == src.color);
+
+                    XMFLOAT2 uv;
+                    XMStoreFloat2(&uv, DecodeTexCoord(ptr + c_TexCoordOffset, encoding));
+                    const float uvError = (encoding == TexCoordEncoding::Float32) ? 0.f : c_MaxTexCoordError;
+                    TEST_VERIFY(std::fabs(uv.x - src.textureCoordinate.x) <= uvError);
+                    TEST_VERIFY(std::fabs(uv.y - src.textureCoordinate.y) <= uvError);
+
+                    if (skinning)
+                    {
+                        uint32_t skin[2];
+                        memcpy(skin, ptr + c_TexCoordOffset + GetTexCoordSize(encoding), sizeof(skin));
+                        TEST_VERIFY(skin[0] == src.indices);
+                        TEST_VERIFY(skin[1] == src.weights);
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    const TestInfo g_Tests[] =
+    {
+        { "UnitVector", TestUnitVector },
+        { "TexCoordEncoding", TestTexCoordEncoding },
+        { "QuantizeVertex", TestQuantizeVertex },
+    };
+}
+
+int __cdecl main()
+{
+    return RunTests(g_Tests);
+}